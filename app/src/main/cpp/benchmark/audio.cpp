@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <audio/resampler.h>
+#include <audio/adpcm_decoder.h>
+#include "benchmark.h"
+
+namespace skyline::benchmark {
+    constexpr size_t AudioFrameCount{0x1E0}; //!< The amount of frames in a buffer, this is a 10ms buffer at 48KHz which is typical of games
+
+    /**
+     * @brief Benchmarks resampling a buffer of random PCM data by the supplied ratio, the resampler state is carried over between iterations as it would be for a stream
+     */
+    static Factory Resample(double ratio, u8 channelCount) {
+        return [=] {
+            auto input{std::make_shared<std::vector<i16>>(AudioFrameCount * channelCount)};
+            FillRandom(span<i16>(*input).cast<u8>());
+            auto output{std::make_shared<std::vector<i16>>(audio::Resampler::GetMaxOutputSize(input->size(), ratio, channelCount))};
+            auto resampler{std::make_shared<audio::Resampler>()};
+            return Case{
+                .iteration = [=] {
+                    DoNotOptimize(resampler->Resample(*input, *output, ratio, channelCount));
+                },
+                .bytesPerIteration = input->size() * sizeof(i16),
+            };
+        };
+    }
+
+    static Registration ResampleStereo{"Audio/Resampler/32KHzTo48KHz/Stereo", Resample(48000.0 / 32000.0, 2)};
+    static Registration ResampleSurround{"Audio/Resampler/32KHzTo48KHz/Surround", Resample(48000.0 / 32000.0, 6)};
+    static Registration ResampleDown{"Audio/Resampler/48KHzTo44.1KHz/Stereo", Resample(44100.0 / 48000.0, 2)};
+
+    static Registration AdpcmDecode{"Audio/AdpcmDecoder/Decode", [] {
+        constexpr size_t AdpcmSize{0x1000};
+        auto input{std::make_shared<std::vector<u8>>(AdpcmSize)};
+        FillRandom(*input);
+        auto output{std::make_shared<std::vector<i16>>(audio::AdpcmDecoder::GetDecodedSize(AdpcmSize))};
+
+        // Arbitrary coefficients that are within the range used by real streams, the output only has to be plausible rather than meaningful
+        std::array<std::array<i16, 2>, 8> coefficients{{{0x04AB, -0x01E2}, {0x0789, -0x0318}, {0x02F1, 0x0112}, {0x0C3A, -0x0555}, {0x0100, 0x0000}, {0x0A22, -0x0481}, {0x0612, -0x0070}, {0x0E01, -0x0700}}};
+        auto decoder{std::make_shared<audio::AdpcmDecoder>(coefficients)};
+        return Case{
+            .iteration = [=] {
+                DoNotOptimize(decoder->Decode(*input, *output));
+            },
+            .bytesPerIteration = AdpcmSize,
+        };
+    }};
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <functional>
+#include <random>
+#include <common.h>
+
+namespace skyline::benchmark {
+    /**
+     * @brief A single benchmark which has been set up and is ready to be run
+     */
+    struct Case {
+        std::function<void()> iteration; //!< A function which runs a single iteration of the benchmark, any state it requires must be captured by it
+        size_t bytesPerIteration{}; //!< The amount of bytes that are processed by a single iteration, this is used to report the throughput and is omitted if it's 0
+    };
+
+    using Factory = std::function<Case()>; //!< A function which allocates and initializes the state for a benchmark, this is only called if the benchmark is selected
+
+    /**
+     * @brief Registers a benchmark with the global registry on construction, this is intended to be used as a static object in the file defining the benchmark
+     */
+    struct Registration {
+        Registration(std::string_view name, Factory factory);
+    };
+
+    /**
+     * @brief Fills the supplied buffer with pseudorandom data, this is deterministic across runs so results are comparable
+     */
+    inline void FillRandom(span<u8> buffer, u32 seed = 0) {
+        std::mt19937 generator{seed};
+        for (auto &byte : buffer)
+            byte = static_cast<u8>(generator());
+    }
+
+    /**
+     * @brief Prevents the compiler from optimizing out the computation of a value that isn't used otherwise
+     */
+    template<typename Type>
+    inline void DoNotOptimize(const Type &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cstdio>
+#include <map>
+#include "benchmark.h"
+
+namespace skyline::benchmark {
+    constexpr i64 WarmupTime{100 * constant::NsInMillisecond}; //!< The time that every benchmark is run for prior to being measured, this faults in memory and lets the CPU governor ramp up clocks
+    constexpr i64 MeasureTime{constant::NsInSecond}; //!< The minimum time that every benchmark is measured for
+
+    /**
+     * @return All registered benchmarks sorted by their name, this is a function-local static as registration happens during static initialization
+     */
+    static std::map<std::string, Factory, std::less<>> &GetRegistry() {
+        static std::map<std::string, Factory, std::less<>> registry;
+        return registry;
+    }
+
+    Registration::Registration(std::string_view name, Factory factory) {
+        GetRegistry().emplace(name, std::move(factory));
+    }
+
+    /**
+     * @brief Runs the iteration of a case repeatedly till the supplied duration has elapsed
+     * @return The amount of iterations and the time they took in nanoseconds
+     */
+    static std::pair<u64, i64> RunFor(Case &benchmarkCase, i64 duration) {
+        u64 iterations{}, batch{1};
+        i64 start{util::GetTimeNs()}, elapsed{};
+        while (elapsed < duration) {
+            // The clock is only read after a batch of iterations as reading it can be more expensive than an iteration, the batch grows till it takes at least a millisecond
+            for (u64 index{}; index < batch; index++)
+                benchmarkCase.iteration();
+            iterations += batch;
+
+            auto batchElapsed{util::GetTimeNs() - start - elapsed};
+            elapsed += batchElapsed;
+            if (batchElapsed < constant::NsInMillisecond)
+                batch *= 2;
+        }
+        return {iterations, elapsed};
+    }
+
+    static void Run(const std::string &name, const Factory &factory) {
+        auto benchmarkCase{factory()};
+        RunFor(benchmarkCase, WarmupTime);
+        auto [iterations, elapsed]{RunFor(benchmarkCase, MeasureTime)};
+
+        auto nsPerIteration{static_cast<double>(elapsed) / static_cast<double>(iterations)};
+        if (benchmarkCase.bytesPerIteration) {
+            auto mibPerSecond{(static_cast<double>(benchmarkCase.bytesPerIteration) * static_cast<double>(iterations) / (1024.0 * 1024.0)) / (static_cast<double>(elapsed) / constant::NsInSecond)};
+            std::printf("%-48s %14.1f ns %12lu iterations %10.1f MiB/s\n", name.c_str(), nsPerIteration, iterations, mibPerSecond);
+        } else {
+            std::printf("%-48s %14.1f ns %12lu iterations\n", name.c_str(), nsPerIteration, iterations);
+        }
+        std::fflush(stdout);
+    }
+}
+
+/**
+ * @brief Runs all benchmarks or the ones which contain any of the supplied arguments in their name
+ * @note This is intended to be pushed to a device alongside libskyline.so and run through adb, see the benchmark target in CMakeLists.txt
+ */
+int main(int argc, char **argv) {
+    using namespace skyline::benchmark;
+
+    if (argc > 1 && (std::string_view{argv[1]} == "--list")) {
+        for (const auto &[name, factory] : GetRegistry())
+            std::printf("%s\n", name.c_str());
+        return 0;
+    }
+
+    for (const auto &[name, factory] : GetRegistry()) {
+        bool selected{argc <= 1};
+        for (int index{1}; index < argc && !selected; index++)
+            selected = name.find(argv[index]) != std::string::npos;
+
+        if (selected) {
+            try {
+                Run(name, factory);
+            } catch (const std::exception &e) {
+                std::printf("%-48s failed: %s\n", name.c_str(), e.what());
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <thread>
+#include <common/circular_queue.h>
+#include <soc/gm20b/gmmu.h>
+#include "benchmark.h"
+
+namespace skyline::benchmark {
+    constexpr u64 GmmuBase{0x100000000}; //!< The GPU VA that all GMMU benchmarks map their memory at
+    constexpr size_t GmmuMappingSize{0x10000}; //!< The size of every mapping, physically contiguous mappings would be merged so every other one is offset in host memory
+    constexpr size_t GmmuMappingCount{0x100};
+
+    /**
+     * @brief A GMMU with a large region mapped as many small mappings, this is representative of the fragmentation caused by games mapping individual nvmap handles
+     */
+    struct GmmuFixture {
+        soc::gm20b::GMMU gmmu;
+        std::vector<u8> backing;
+
+        GmmuFixture() : backing(GmmuMappingSize * GmmuMappingCount * 2) {
+            FillRandom(backing);
+            for (size_t index{}; index < GmmuMappingCount; index++)
+                gmmu.Map(GmmuBase + index * GmmuMappingSize, backing.data() + index * GmmuMappingSize * 2, GmmuMappingSize);
+        }
+    };
+
+    /**
+     * @brief Benchmarks reading a range of the supplied size from the GMMU, the offset of the read is advanced every iteration to cover different mappings
+     */
+    static Factory GmmuRead(size_t readSize) {
+        return [=] {
+            auto fixture{std::make_shared<GmmuFixture>()};
+            auto output{std::make_shared<std::vector<u8>>(readSize)};
+            auto offset{std::make_shared<u64>()};
+            return Case{
+                .iteration = [=] {
+                    fixture->gmmu.Read(output->data(), GmmuBase + *offset, readSize);
+                    *offset = (*offset + 0x1040) % (GmmuMappingSize * GmmuMappingCount - readSize);
+                },
+                .bytesPerIteration = readSize,
+            };
+        };
+    }
+
+    static Registration GmmuRead16{"Memory/FlatMemoryManager/Read/16B", GmmuRead(0x10)};
+    static Registration GmmuRead4K{"Memory/FlatMemoryManager/Read/4KiB", GmmuRead(0x1000)};
+    static Registration GmmuRead1M{"Memory/FlatMemoryManager/Read/1MiB", GmmuRead(0x100000)};
+
+    /**
+     * @brief Benchmarks translating a range of the supplied size in the GMMU into host ranges
+     */
+    static Factory GmmuTranslateRange(size_t rangeSize) {
+        return [=] {
+            auto fixture{std::make_shared<GmmuFixture>()};
+            auto offset{std::make_shared<u64>()};
+            return Case{
+                .iteration = [=] {
+                    DoNotOptimize(fixture->gmmu.TranslateRange(GmmuBase + *offset, rangeSize));
+                    *offset = (*offset + 0x1040) % (GmmuMappingSize * GmmuMappingCount - rangeSize);
+                },
+            };
+        };
+    }
+
+    static Registration GmmuTranslateRange4K{"Memory/FlatMemoryManager/TranslateRange/4KiB", GmmuTranslateRange(0x1000)};
+    static Registration GmmuTranslateRange1M{"Memory/FlatMemoryManager/TranslateRange/1MiB", GmmuTranslateRange(0x100000)};
+
+    /**
+     * @brief Benchmarks pushing items into a CircularQueue and popping them on a consumer thread, an iteration is a batch of items being pushed and consumed
+     * @param batchSize The amount of items pushed per iteration, the producer waits for all of them to be consumed at the end of an iteration
+     */
+    static Factory CircularQueuePushPop(size_t queueSize, size_t batchSize) {
+        return [=] {
+            struct Fixture {
+                CircularQueue<u64> queue;
+                std::atomic<u64> consumed{};
+
+                Fixture(size_t queueSize) : queue(queueSize) {}
+            };
+
+            // The fixture is intentionally leaked as CircularQueue::Process never returns, the consumer thread is detached and blocks on the queue for the rest of the process
+            auto fixture{new Fixture(queueSize)};
+            std::thread([fixture] {
+                fixture->queue.Process([fixture](u64 &) {
+                    fixture->consumed.fetch_add(1, std::memory_order_release);
+                });
+            }).detach();
+
+            auto produced{std::make_shared<u64>()};
+            return Case{
+                .iteration = [=] {
+                    for (size_t index{}; index < batchSize; index++)
+                        fixture->queue.Push(index);
+                    *produced += batchSize;
+                    while (fixture->consumed.load(std::memory_order_acquire) != *produced)
+                        std::this_thread::yield();
+                },
+                .bytesPerIteration = batchSize * sizeof(u64),
+            };
+        };
+    }
+
+    static Registration CircularQueuePushPopSmall{"Containers/CircularQueue/PushPop/16", CircularQueuePushPop(0x200, 0x10)};
+    static Registration CircularQueuePushPopLarge{"Containers/CircularQueue/PushPop/1024", CircularQueuePushPop(0x200, 0x400)};
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu/texture/format.h>
+#include <gpu/texture/copy.h>
+#include "benchmark.h"
+
+namespace skyline::benchmark {
+    /**
+     * @return A 2D blocklinear RGBA8 texture with the supplied dimensions and block height, it isn't backed by any mappings
+     */
+    static std::shared_ptr<gpu::GuestTexture> MakeBlockLinearTexture(u32 width, u32 height, u8 blockHeight) {
+        return std::make_shared<gpu::GuestTexture>(gpu::GuestTexture::Mappings{}, gpu::texture::Dimensions(width, height, 1), gpu::format::R8G8B8A8Unorm, gpu::texture::TileConfig{
+            .mode = gpu::texture::TileMode::Block,
+            .blockHeight = blockHeight,
+            .blockDepth = 1,
+        }, gpu::texture::TextureType::e2D);
+    }
+
+    /**
+     * @brief Benchmarks deswizzling a 2D blocklinear texture with the supplied dimensions and block height
+     * @param threadCount The amount of workers in the thread pool that the copy is split across, 0 copies on the calling thread
+     */
+    static Factory CopyBlockLinearToLinear(u32 width, u32 height, u8 blockHeight, size_t threadCount) {
+        return [=] {
+            auto guest{MakeBlockLinearTexture(width, height, blockHeight)};
+
+            gpu::detail::BlockLinearLayout layout{*guest};
+            auto guestBuffer{std::make_shared<std::vector<u8>>(static_cast<size_t>(layout.robBytes) * layout.surfaceHeightRobs)};
+            auto linearBuffer{std::make_shared<std::vector<u8>>(guest->format->GetSize(width, height))};
+            FillRandom(*guestBuffer);
+            guest->mappings.emplace_back(*guestBuffer);
+
+            std::shared_ptr<ThreadPool> threadPool{threadCount ? std::make_shared<ThreadPool>(threadCount) : nullptr};
+
+            // The optimized copy is checked against the reference implementation prior to being benchmarked as its results would be meaningless otherwise
+            std::vector<u8> referenceBuffer(linearBuffer->size());
+            gpu::CopyBlockLinearToLinearReference(*guest, guestBuffer->data(), referenceBuffer.data());
+            gpu::CopyBlockLinearToLinear(*guest, guestBuffer->data(), linearBuffer->data(), threadPool.get());
+            if (*linearBuffer != referenceBuffer)
+                throw exception("CopyBlockLinearToLinear doesn't match the reference implementation for {}x{} (Block Height: {})", width, height, blockHeight);
+
+            return Case{
+                .iteration = [=] {
+                    gpu::CopyBlockLinearToLinear(*guest, guestBuffer->data(), linearBuffer->data(), threadPool.get());
+                },
+                .bytesPerIteration = linearBuffer->size(),
+            };
+        };
+    }
+
+    static Registration CopyBlockLinearToLinear720p{"Texture/CopyBlockLinearToLinear/1280x720", CopyBlockLinearToLinear(1280, 720, 16, 0)};
+    static Registration CopyBlockLinearToLinear1080p{"Texture/CopyBlockLinearToLinear/1920x1080", CopyBlockLinearToLinear(1920, 1080, 16, 0)};
+    static Registration CopyBlockLinearToLinear1080pParallel{"Texture/CopyBlockLinearToLinear/1920x1080/Parallel", CopyBlockLinearToLinear(1920, 1080, 16, 3)};
+    static Registration CopyBlockLinearToLinearSmall{"Texture/CopyBlockLinearToLinear/64x64", CopyBlockLinearToLinear(64, 64, 2, 0)};
+
+    /**
+     * @brief Benchmarks swizzling a linear texture into a 2D blocklinear texture with the supplied dimensions and block height
+     * @param threadCount The amount of workers in the thread pool that the copy is split across, 0 copies on the calling thread
+     */
+    static Factory CopyLinearToBlockLinear(u32 width, u32 height, u8 blockHeight, size_t threadCount) {
+        return [=] {
+            auto guest{MakeBlockLinearTexture(width, height, blockHeight)};
+
+            gpu::detail::BlockLinearLayout layout{*guest};
+            auto guestBuffer{std::make_shared<std::vector<u8>>(static_cast<size_t>(layout.robBytes) * layout.surfaceHeightRobs)};
+            auto linearBuffer{std::make_shared<std::vector<u8>>(guest->format->GetSize(width, height))};
+            FillRandom(*linearBuffer);
+            guest->mappings.emplace_back(*guestBuffer);
+
+            std::shared_ptr<ThreadPool> threadPool{threadCount ? std::make_shared<ThreadPool>(threadCount) : nullptr};
+
+            // Padding in the blocklinear surface isn't written by either copy, both outputs start zeroed so it compares equal
+            std::vector<u8> referenceBuffer(guestBuffer->size());
+            gpu::CopyLinearToBlockLinearReference(*guest, linearBuffer->data(), referenceBuffer.data());
+            gpu::CopyLinearToBlockLinear(*guest, linearBuffer->data(), guestBuffer->data(), threadPool.get());
+            if (*guestBuffer != referenceBuffer)
+                throw exception("CopyLinearToBlockLinear doesn't match the reference implementation for {}x{} (Block Height: {})", width, height, blockHeight);
+
+            return Case{
+                .iteration = [=] {
+                    gpu::CopyLinearToBlockLinear(*guest, linearBuffer->data(), guestBuffer->data(), threadPool.get());
+                },
+                .bytesPerIteration = linearBuffer->size(),
+            };
+        };
+    }
+
+    static Registration CopyLinearToBlockLinear1080p{"Texture/CopyLinearToBlockLinear/1920x1080", CopyLinearToBlockLinear(1920, 1080, 16, 0)};
+    static Registration CopyLinearToBlockLinearSmall{"Texture/CopyLinearToBlockLinear/64x64", CopyLinearToBlockLinear(64, 64, 2, 0)};
+}
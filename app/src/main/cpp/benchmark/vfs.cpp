@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <vfs/ctr_encrypted_backing.h>
+#include "benchmark.h"
+
+namespace skyline::benchmark {
+    /**
+     * @brief A read-only backing over a buffer in memory, this isolates the cost of decryption from that of I/O
+     */
+    class MemoryBacking : public vfs::Backing {
+      private:
+        std::vector<u8> buffer;
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override {
+            size_t size{std::min(output.size(), buffer.size() - offset)};
+            std::memcpy(output.data(), buffer.data() + offset, size);
+            return size;
+        }
+
+      public:
+        MemoryBacking(size_t size) : Backing({true, false, false}, size), buffer(size) {
+            FillRandom(buffer);
+        }
+    };
+
+    /**
+     * @brief Benchmarks reading from a CtrEncryptedBacking in chunks of the supplied size, the offset is advanced every iteration as it would be for sequential reads
+     * @param misalignment The offset of every read from the AES block size, misaligned reads require an additional block to be decrypted separately
+     */
+    static Factory CtrEncryptedRead(size_t readSize, size_t misalignment) {
+        return [=] {
+            constexpr size_t BackingSize{0x800000};
+            crypto::KeyStore::Key128 ctr{}, key{};
+            FillRandom(key);
+            auto backing{std::make_shared<vfs::CtrEncryptedBacking>(ctr, key, std::make_shared<MemoryBacking>(BackingSize), 0)};
+
+            auto output{std::make_shared<std::vector<u8>>(readSize)};
+            auto offset{std::make_shared<size_t>()};
+            return Case{
+                .iteration = [=] {
+                    backing->Read(*output, *offset + misalignment);
+                    *offset = (*offset + readSize) % (BackingSize - readSize);
+                },
+                .bytesPerIteration = readSize,
+            };
+        };
+    }
+
+    static Registration CtrEncryptedRead4K{"Vfs/CtrEncryptedBacking/Read/4KiB", CtrEncryptedRead(0x1000, 0)};
+    static Registration CtrEncryptedRead4KMisaligned{"Vfs/CtrEncryptedBacking/Read/4KiB/Misaligned", CtrEncryptedRead(0x1000, 0x5)};
+    static Registration CtrEncryptedRead1M{"Vfs/CtrEncryptedBacking/Read/1MiB", CtrEncryptedRead(0x100000, 0)};
+}
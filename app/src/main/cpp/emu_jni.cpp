@@ -11,6 +11,8 @@
 #include "skyline/common/signal.h"
 #include "skyline/common/settings.h"
 #include "skyline/common/trace.h"
+#include "skyline/common/performance_counters.h"
+#include "skyline/common/memory_accounting.h"
 #include "skyline/loader/loader.h"
 #include "skyline/vfs/android_asset_filesystem.h"
 #include "skyline/os.h"
@@ -20,10 +22,6 @@
 #include "skyline/input.h"
 #include "skyline/kernel/types/KProcess.h"
 
-jint Fps; //!< An approximation of the amount of frames being submitted every second
-jfloat AverageFrametimeMs; //!< The average time it takes for a frame to be rendered and presented in milliseconds
-jfloat AverageFrametimeDeviationMs; //!< The average deviation of the average frametimes in milliseconds
-
 std::weak_ptr<skyline::kernel::OS> OsWeak;
 std::weak_ptr<skyline::gpu::GPU> GpuWeak;
 std::weak_ptr<skyline::audio::Audio> AudioWeak;
@@ -74,20 +72,27 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
     jint preferenceFd,
     jint systemLanguage,
     jstring appFilesPathJstring,
-    jobject assetManager
+    jobject assetManager,
+    jint automationFrames,
+    jstring automationInputJstring
 ) {
     skyline::signal::ScopedStackBlocker stackBlocker; // We do not want anything to unwind past JNI code as there are invalid stack frames which can lead to a segmentation fault
-    Fps = 0;
-    AverageFrametimeMs = AverageFrametimeDeviationMs = 0.0f;
+    skyline::perf::SharedCounters.Reset();
 
     pthread_setname_np(pthread_self(), "EmuMain");
 
     auto jvmManager{std::make_shared<skyline::JvmManager>(env, instance)};
     auto settings{std::make_shared<skyline::Settings>(preferenceFd)};
     close(preferenceFd);
+    settings->automationFrames = static_cast<skyline::u32>(std::max(automationFrames, 0));
+    settings->automationInput = skyline::JniString(env, automationInputJstring);
+    skyline::Logger::SetCategoryFilter(settings->logFilter);
 
     skyline::JniString appFilesPath(env, appFilesPathJstring);
-    skyline::Logger::EmulationContext.Initialize(appFilesPath + "emulation.sklog");
+    if (settings->logBinary)
+        skyline::Logger::EmulationContext.InitializeBinary(appFilesPath + "emulation.skblog", 64 * 1024 * 1024);
+    else
+        skyline::Logger::EmulationContext.Initialize(appFilesPath + "emulation.sklog");
 
     auto start{std::chrono::steady_clock::now()};
 
@@ -162,25 +167,40 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_changeAudioStatus(J
             audio->Pause();
 }
 
-extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_updatePerformanceStatistics(JNIEnv *env, jobject thiz) {
-    static jclass clazz{};
-    if (!clazz)
-        clazz = env->GetObjectClass(thiz);
-
-    static jfieldID fpsField{};
-    if (!fpsField)
-        fpsField = env->GetFieldID(clazz, "fps", "I");
-    env->SetIntField(thiz, fpsField, Fps);
-
-    static jfieldID averageFrametimeField{};
-    if (!averageFrametimeField)
-        averageFrametimeField = env->GetFieldID(clazz, "averageFrametime", "F");
-    env->SetFloatField(thiz, averageFrametimeField, AverageFrametimeMs);
-
-    static jfieldID averageFrametimeDeviationField{};
-    if (!averageFrametimeDeviationField)
-        averageFrametimeDeviationField = env->GetFieldID(clazz, "averageFrametimeDeviation", "F");
-    env->SetFloatField(thiz, averageFrametimeDeviationField, AverageFrametimeDeviationMs);
+extern "C" JNIEXPORT jobject Java_emu_skyline_EmulationActivity_getPerformanceCounters(JNIEnv *env, jobject) {
+    return env->NewDirectByteBuffer(&skyline::perf::SharedCounters, sizeof(skyline::perf::Counters));
+}
+
+extern "C" JNIEXPORT jstring JNICALL Java_emu_skyline_EmulationActivity_getHleLatencies(JNIEnv *env, jobject, jint count) {
+    auto summaries{skyline::trace::LatencyHistograms::Snapshot()};
+
+    // The slowest calls are determined by their tail latency as that's what causes stutters, percentiles are computed once rather than in the comparator
+    std::vector<std::pair<skyline::i64, const skyline::trace::LatencyHistograms::Summary *>> ranked;
+    ranked.reserve(summaries.size());
+    for (const auto &summary : summaries)
+        ranked.emplace_back(summary.Percentile(0.99), &summary);
+    auto rankedCount{std::min(ranked.size(), static_cast<size_t>(std::max(count, 0)))};
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<ssize_t>(rankedCount), ranked.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+    std::string text;
+    for (size_t index{}; index < rankedCount; index++) {
+        auto [p99, summary]{ranked[index]};
+        constexpr auto NsInUs{skyline::constant::NsInMicrosecond};
+        text += fmt::format("{}: {} calls, avg {}us, p99 <{}us, max {}us\n", summary->name, summary->count, summary->totalNs / static_cast<skyline::i64>(summary->count) / NsInUs, p99 / NsInUs, summary->maxNs / NsInUs);
+    }
+    if (!text.empty())
+        text.pop_back();
+    return env->NewStringUTF(text.c_str());
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL Java_emu_skyline_EmulationActivity_getMemoryUsage(JNIEnv *env, jobject) {
+    auto snapshot{skyline::perf::SharedMemoryAccounting.GetSnapshot()};
+    std::array<jlong, static_cast<size_t>(skyline::perf::MemoryCategory::Count)> usage{};
+    std::copy(snapshot.begin(), snapshot.end(), usage.begin());
+
+    auto array{env->NewLongArray(static_cast<jsize>(usage.size()))};
+    env->SetLongArrayRegion(array, 0, static_cast<jsize>(usage.size()), usage.data());
+    return array;
 }
 
 extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setController(JNIEnv *, jobject, jint index, jint type, jint partnerIndex) {
@@ -193,22 +213,21 @@ extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_updateContr
     InputWeak.lock()->npad.Update();
 }
 
-extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setButtonState(JNIEnv *, jobject, jint index, jlong mask, jboolean pressed) {
-    auto input{InputWeak.lock()};
-    if (!input)
-        return; // We don't mind if we miss button updates while input hasn't been initialized
-    auto device{input->npad.controllers[static_cast<size_t>(index)].device};
-    if (device)
-        device->SetButtonState(skyline::input::NpadButton{.raw = static_cast<skyline::u64>(mask)}, pressed);
-}
+extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_submitInputEvents(JNIEnv *env, jobject, jobject eventsJni, jint count) {
+    using Event = skyline::input::HostInputEvent;
 
-extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setAxisValue(JNIEnv *, jobject, jint index, jint axis, jint value) {
     auto input{InputWeak.lock()};
     if (!input)
-        return; // We don't mind if we miss axis updates while input hasn't been initialized
-    auto device{input->npad.controllers[static_cast<size_t>(index)].device};
-    if (device)
-        device->SetAxisValue(static_cast<skyline::input::NpadAxisId>(axis), value);
+        return; // We don't mind if we miss input updates while input hasn't been initialized
+
+    auto events{reinterpret_cast<Event *>(env->GetDirectBufferAddress(eventsJni))};
+    auto capacity{static_cast<size_t>(env->GetDirectBufferCapacity(eventsJni)) / sizeof(Event)};
+    if (!events || static_cast<size_t>(count) > capacity) [[unlikely]] {
+        skyline::Logger::Warn("Invalid input event buffer: {} events", count);
+        return;
+    }
+
+    input->npad.SubmitHostEvents(skyline::span<const Event>(events, static_cast<size_t>(count)));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setTouchState(JNIEnv *env, jobject, jintArray pointsJni) {
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/performance_counters.h>
 #include "audio.h"
 
 namespace skyline::audio {
@@ -22,11 +23,25 @@ namespace skyline::audio {
         outputStream->requestStop();
     }
 
+    void Audio::PublishTracks(std::unique_ptr<TrackList> tracks) {
+        activeTracks.store(tracks.get());
+
+        // A callback that started after the store is guaranteed to observe the new snapshot, only one that's still in progress may be using the previous snapshot
+        auto sequence{callbackSequence.load()};
+        if (sequence & 1)
+            while (callbackSequence.load() == sequence)
+                std::this_thread::yield();
+
+        audioTracks = std::move(tracks);
+    }
+
     std::shared_ptr<AudioTrack> Audio::OpenTrack(u8 channelCount, u32 sampleRate, const std::function<void()> &releaseCallback) {
         std::lock_guard trackGuard(trackLock);
 
         auto track{std::make_shared<AudioTrack>(channelCount, sampleRate, releaseCallback)};
-        audioTracks.push_back(track);
+        auto tracks{std::make_unique<TrackList>(*audioTracks)};
+        tracks->push_back(track);
+        PublishTracks(std::move(tracks));
 
         return track;
     }
@@ -34,35 +49,68 @@ namespace skyline::audio {
     void Audio::CloseTrack(std::shared_ptr<AudioTrack> &track) {
         std::lock_guard trackGuard(trackLock);
 
-        audioTracks.erase(std::remove(audioTracks.begin(), audioTracks.end(), track), audioTracks.end());
+        auto tracks{std::make_unique<TrackList>(*audioTracks)};
+        tracks->erase(std::remove(tracks->begin(), tracks->end(), track), tracks->end());
+        PublishTracks(std::move(tracks));
         track.reset();
     }
 
+    void Audio::TuneLatency(oboe::AudioStream *audioStream, i32 numFrames) {
+        auto now{std::chrono::steady_clock::now()};
+        if (lastCallbackTime != std::chrono::steady_clock::time_point{}) {
+            auto expectedInterval{std::chrono::nanoseconds(constant::NsInSecond * numFrames / audioStream->getSampleRate())};
+            auto interval{now - lastCallbackTime};
+            peakJitter = std::max(peakJitter, std::chrono::duration_cast<std::chrono::nanoseconds>(interval > expectedInterval ? interval - expectedInterval : expectedInterval - interval));
+        } else {
+            stableSince = now;
+        }
+        lastCallbackTime = now;
+
+        auto xRunCount{audioStream->getXRunCount()};
+        if (!xRunCount)
+            return; // Streams which don't report underruns can't be tuned
+        perf::SharedCounters.audioUnderruns.store(static_cast<u32>(xRunCount.value()), std::memory_order_relaxed);
+
+        auto burstSize{audioStream->getFramesPerBurst()};
+        auto bufferSize{audioStream->getBufferSizeInFrames()};
+        if (xRunCount.value() != lastXRunCount) {
+            lastXRunCount = xRunCount.value();
+            if (bufferSize + burstSize <= audioStream->getBufferCapacityInFrames())
+                audioStream->setBufferSizeInFrames(bufferSize + burstSize);
+            stableSince = now;
+            peakJitter = {};
+        } else if (now - stableSince > LatencyStablePeriod) {
+            // The buffer is only shrunk if the smaller buffer still covers the worst callback jitter seen, this avoids repeatedly causing an underrun by shrinking it
+            auto jitterFrames{static_cast<i32>(peakJitter.count() * audioStream->getSampleRate() / constant::NsInSecond)};
+            if (bufferSize - burstSize >= std::max(burstSize, jitterFrames + burstSize))
+                audioStream->setBufferSizeInFrames(bufferSize - burstSize);
+            stableSince = now;
+            peakJitter = {};
+        }
+    }
+
     oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *audioStream, void *audioData, int32_t numFrames) {
         auto destBuffer{static_cast<i16 *>(audioData)};
         auto streamSamples{static_cast<size_t>(numFrames) * static_cast<size_t>(audioStream->getChannelCount())};
         size_t writtenSamples{};
 
-        {
-            std::lock_guard trackGuard(trackLock);
+        TuneLatency(audioStream, numFrames);
 
-            for (auto &track : audioTracks) {
-                if (track->playbackState == AudioOutState::Stopped)
-                    continue;
+        callbackSequence.fetch_add(1);
 
-                std::lock_guard bufferGuard(track->bufferLock);
+        for (auto &track : *activeTracks.load()) {
+            if (track->playbackState.load(std::memory_order_relaxed) == AudioOutState::Stopped)
+                continue;
 
-                auto trackSamples{track->samples.Read(span(destBuffer, streamSamples), [](i16 *source, i16 *destination) {
-                    *destination = Saturate<i16, i32>(static_cast<u32>(*destination) + static_cast<u32>(*source));
-                }, static_cast<ssize_t>(writtenSamples))};
+            // Samples which overlap with those of a previous track are mixed into them, the rest are copied directly
+            auto trackSamples{track->Read(span(destBuffer, streamSamples), writtenSamples)};
+            writtenSamples = std::max(trackSamples, writtenSamples);
 
-                writtenSamples = std::max(trackSamples, writtenSamples);
-
-                track->sampleCounter += trackSamples;
-                track->CheckReleasedBuffers();
-            }
+            track->CheckReleasedBuffers();
         }
 
+        callbackSequence.fetch_add(1);
+
         if (streamSamples > writtenSamples)
             memset(destBuffer + writtenSamples, 0, (streamSamples - writtenSamples) * sizeof(i16));
 
@@ -71,6 +119,9 @@ namespace skyline::audio {
 
     void Audio::onErrorAfterClose(oboe::AudioStream *audioStream, oboe::Result error) {
         if (error == oboe::Result::ErrorDisconnected) {
+            // The new stream may be on a different device, so tuning starts from scratch
+            lastXRunCount = 0;
+            lastCallbackTime = {};
             builder.openManagedStream(outputStream);
             outputStream->requestStart();
         }
@@ -8,14 +8,37 @@
 namespace skyline::audio {
     /**
      * @brief The Audio class is used to mix audio from all tracks
+     * @note The audio callback runs on a real-time thread and never locks a mutex, tracks are accessed through an immutable snapshot of the track list which is replaced on modification
      */
     class Audio : public oboe::AudioStreamCallback {
       private:
+        using TrackList = std::vector<std::shared_ptr<AudioTrack>>;
+
         oboe::AudioStreamBuilder builder;
         oboe::ManagedStream outputStream;
-        std::vector<std::shared_ptr<AudioTrack>> audioTracks;
+        std::unique_ptr<TrackList> audioTracks{std::make_unique<TrackList>()}; //!< The current track list, this is only accessed by the audio callback through activeTracks
+        std::atomic<TrackList *> activeTracks{audioTracks.get()}; //!< The snapshot of the track list that the audio callback mixes
+        std::atomic<u32> callbackSequence{}; //!< Incremented at the start and end of every audio callback, an odd value means a callback may be accessing a previous snapshot
         std::mutex trackLock; //!< Synchronizes modifications to the audio tracks
 
+        static constexpr std::chrono::seconds LatencyStablePeriod{10}; //!< The duration without any underruns after which the stream's buffer is shrunk to reduce latency
+        i32 lastXRunCount{}; //!< The amount of underruns reported by the stream when it was last tuned
+        std::chrono::steady_clock::time_point lastCallbackTime{}; //!< The time at which the previous audio callback started
+        std::chrono::steady_clock::time_point stableSince{}; //!< The time of the last change to the buffer size or underrun
+        std::chrono::nanoseconds peakJitter{}; //!< The largest deviation of the interval between callbacks from the duration of a callback since stableSince
+
+        /**
+         * @brief Adapts the size of the stream's buffer to the device, it's grown by a burst whenever an underrun occurs and shrunk by a burst after a stable period where the jitter of callbacks allows it
+         * @note This must only be called from the audio callback
+         */
+        void TuneLatency(oboe::AudioStream *audioStream, i32 numFrames);
+
+        /**
+         * @brief Publishes a new snapshot of the track list and waits for the audio callback to stop using the previous one before destroying it
+         * @note trackLock MUST be locked when calling this
+         */
+        void PublishTracks(std::unique_ptr<TrackList> tracks);
+
       public:
         Audio(const DeviceState &state);
 
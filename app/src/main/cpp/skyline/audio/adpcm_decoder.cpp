@@ -5,48 +5,62 @@
 #include "adpcm_decoder.h"
 
 namespace skyline::audio {
-    AdpcmDecoder::AdpcmDecoder(std::vector<std::array<i16, 2>> coefficients) : coefficients(std::move(coefficients)) {}
+    /**
+     * @brief A lookup table of the sign-extended high and low nibbles of every byte, in the order they're decoded
+     */
+    constexpr std::array<std::array<i8, 2>, 0x100> NibbleLut{[] {
+        std::array<std::array<i8, 2>, 0x100> lut{};
+        for (size_t byte{}; byte < lut.size(); byte++)
+            lut[byte] = {static_cast<i8>(static_cast<i8>(byte) >> 4), static_cast<i8>(static_cast<i8>(byte << 4) >> 4)};
+        return lut;
+    }()};
 
-    std::vector<i16> AdpcmDecoder::Decode(span<u8> adpcmData) {
-        constexpr size_t BytesPerFrame{0x8};
-        constexpr size_t SamplesPerFrame{0xE};
+    /**
+     * @brief A lookup table of the multiplier for the nibbles of a frame for every scale in its header
+     */
+    constexpr std::array<i32, 0x10> ScaleLut{[] {
+        std::array<i32, 0x10> lut{};
+        for (size_t scale{}; scale < lut.size(); scale++)
+            lut[scale] = 0x800 << scale;
+        return lut;
+    }()};
 
-        size_t remainingSamples{(adpcmData.size() / BytesPerFrame) * SamplesPerFrame};
-
-        std::vector<i16> output;
-        output.reserve(remainingSamples);
-
-        size_t inputOffset{};
-
-        while (inputOffset < adpcmData.size()) {
-            FrameHeader header{adpcmData[inputOffset++]};
-
-            size_t frameSamples{std::min(SamplesPerFrame, remainingSamples)};
+    AdpcmDecoder::AdpcmDecoder(span<const std::array<i16, 2>> pCoefficients) {
+        SetCoefficients(pCoefficients);
+    }
 
-            i32 ctx{};
+    void AdpcmDecoder::SetCoefficients(span<const std::array<i16, 2>> pCoefficients) {
+        coefficients = {};
+        std::copy_n(pCoefficients.begin(), std::min(pCoefficients.size(), MaxCoefficientCount), coefficients.begin());
+        history = {};
+    }
 
-            for (size_t index{}; index < frameSamples; index++) {
-                i32 sample{};
+    void AdpcmDecoder::DecodeFrame(const u8 *frame, i16 *output, size_t sampleCount) {
+        FrameHeader header{*frame++};
+        auto scale{ScaleLut[header.scale]};
+        auto [coefficient0, coefficient1]{coefficients[header.coefficientIndex]};
+        auto [history0, history1]{history};
 
-                if (index & 1) {
-                    sample = (ctx << 28) >> 28;
-                } else {
-                    ctx = adpcmData[inputOffset++];
-                    sample = (ctx << 24) >> 28;
-                }
+        for (size_t index{}; index < sampleCount; index++) {
+            i32 prediction{history0 * coefficient0 + history1 * coefficient1};
+            auto saturated{audio::Saturate<i16, i32>((NibbleLut[frame[index >> 1]][index & 1] * scale + prediction + 0x400) >> 11)};
 
-                i32 prediction{history[0] * coefficients[header.coefficientIndex][0] + history[1] * coefficients[header.coefficientIndex][1]};
-                sample = (sample * (0x800 << header.scale) + prediction + 0x400) >> 11;
+            output[index] = saturated;
+            history1 = history0;
+            history0 = saturated;
+        }
 
-                auto saturated{audio::Saturate<i16, i32>(sample)};
-                output.push_back(saturated);
-                history[1] = history[0];
-                history[0] = saturated;
-            }
+        history = {history0, history1};
+    }
 
-            remainingSamples -= frameSamples;
+    size_t AdpcmDecoder::Decode(span<const u8> adpcmData, span<i16> output) {
+        size_t outputOffset{};
+        for (size_t inputOffset{}; inputOffset + BytesPerFrame <= adpcmData.size() && outputOffset < output.size(); inputOffset += BytesPerFrame) {
+            size_t frameSamples{std::min(SamplesPerFrame, output.size() - outputOffset)};
+            DecodeFrame(adpcmData.data() + inputOffset, output.data() + outputOffset, frameSamples);
+            outputOffset += frameSamples;
         }
 
-        return output;
+        return outputOffset;
     }
 }
@@ -22,15 +22,42 @@ namespace skyline::audio {
         };
         static_assert(sizeof(FrameHeader) == 0x1);
 
+        static constexpr size_t BytesPerFrame{0x8};
+        static constexpr size_t SamplesPerFrame{0xE};
+        static constexpr size_t MaxCoefficientCount{8}; //!< The amount of coefficient pairs that can be indexed by a frame header
+
         std::array<i32, 2> history{}; //!< The previous samples for decoding the ADPCM stream
-        std::vector<std::array<i16, 2>> coefficients; //!< The coefficients for decoding the ADPCM stream
+        std::array<std::array<i16, 2>, MaxCoefficientCount> coefficients{}; //!< The coefficients for decoding the ADPCM stream, any that weren't supplied are zero
+
+        /**
+         * @brief Decodes the samples of a single frame
+         * @param frame The ADPCM data of the frame including its header, this must contain enough bytes for the supplied amount of samples
+         */
+        void DecodeFrame(const u8 *frame, i16 *output, size_t sampleCount);
 
       public:
-        AdpcmDecoder(std::vector<std::array<i16, 2>> coefficients);
+        AdpcmDecoder() = default;
+
+        AdpcmDecoder(span<const std::array<i16, 2>> coefficients);
+
+        /**
+         * @brief Replaces the coefficients and resets the state of the decoder for a new stream
+         * @note Any coefficients past the maximum amount of coefficients are ignored
+         */
+        void SetCoefficients(span<const std::array<i16, 2>> coefficients);
+
+        /**
+         * @return The amount of samples that decoding a buffer of ADPCM data of the supplied size produces
+         */
+        static constexpr size_t GetDecodedSize(size_t adpcmSize) {
+            return (adpcmSize / BytesPerFrame) * SamplesPerFrame;
+        }
 
         /**
          * @brief Decodes a buffer of ADPCM data into I16 PCM
+         * @param output The buffer to write the PCM data into, this should be at least GetDecodedSize samples large otherwise the remaining frames are skipped
+         * @return The amount of samples that were written into the output buffer
          */
-        std::vector<i16> Decode(span <u8> adpcmData);
+        size_t Decode(span<const u8> adpcmData, span<i16> output);
     };
 }
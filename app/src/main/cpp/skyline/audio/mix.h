@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+#include "common.h"
+
+namespace skyline::audio {
+    /**
+     * @brief Mixes the source samples into the destination samples with saturation
+     * @note Both spans must be the same size
+     */
+    inline void MixSamples(span<i16> destination, span<const i16> source) {
+        size_t index{};
+        #ifdef __ARM_NEON
+        for (; index + 8 <= destination.size(); index += 8)
+            vst1q_s16(destination.data() + index, vqaddq_s16(vld1q_s16(destination.data() + index), vld1q_s16(source.data() + index)));
+        #endif
+        for (; index < destination.size(); index++)
+            destination[index] = Saturate<i16, i32>(static_cast<i32>(destination[index]) + static_cast<i32>(source[index]));
+    }
+
+    /**
+     * @brief Scales interleaved frames of source samples by a volume which changes linearly from frame to frame, the result is either written or mixed into the destination with saturation
+     * @tparam Accumulate If the scaled samples are mixed into the destination rather than overwriting it
+     * @param startVolume The volume of the first frame
+     * @param volumeStep The difference in volume between consecutive frames, this is 0 for a constant volume
+     * @note Both spans must be the same size and consist of whole frames with constant::ChannelCount channels
+     */
+    template<bool Accumulate>
+    inline void ApplyVolumeRamp(span<i16> destination, span<const i16> source, float startVolume, float volumeStep) {
+        static_assert(constant::ChannelCount == 2, "The volume kernels assume interleaved stereo frames");
+
+        size_t index{};
+        #ifdef __ARM_NEON
+        // Each iteration handles 4 stereo frames, every pair of lanes shares the volume of its frame
+        const float32x4_t LowFrameOffsets{0.0f, 0.0f, 1.0f, 1.0f}, HighFrameOffsets{2.0f, 2.0f, 3.0f, 3.0f};
+        for (; index + 8 <= destination.size(); index += 8) {
+            auto volume{vdupq_n_f32(startVolume + (volumeStep * static_cast<float>(index / constant::ChannelCount)))};
+            auto samples{vld1q_s16(source.data() + index)};
+
+            auto low{vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), vmlaq_n_f32(volume, LowFrameOffsets, volumeStep)))};
+            auto high{vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(samples)), vmlaq_n_f32(volume, HighFrameOffsets, volumeStep)))};
+            auto scaled{vcombine_s16(vqmovn_s32(low), vqmovn_s32(high))};
+
+            if constexpr (Accumulate)
+                scaled = vqaddq_s16(vld1q_s16(destination.data() + index), scaled);
+            vst1q_s16(destination.data() + index, scaled);
+        }
+        #endif
+        for (; index < destination.size(); index++) {
+            auto volume{startVolume + (volumeStep * static_cast<float>(index / constant::ChannelCount))};
+            auto scaled{Saturate<i16, i32>(static_cast<float>(source[index]) * volume)};
+            if constexpr (Accumulate)
+                destination[index] = Saturate<i16, i32>(static_cast<i32>(destination[index]) + static_cast<i32>(scaled));
+            else
+                destination[index] = scaled;
+        }
+    }
+
+    /**
+     * @brief Converts mono samples into stereo frames by duplicating every sample into both channels
+     * @note The destination must be twice the size of the source and they must not overlap
+     */
+    inline void UpmixMonoToStereo(span<i16> destination, span<const i16> source) {
+        size_t index{};
+        #ifdef __ARM_NEON
+        for (; index + 8 <= source.size(); index += 8) {
+            auto samples{vld1q_s16(source.data() + index)};
+            vst2q_s16(destination.data() + (index * 2), (int16x8x2_t{{samples, samples}}));
+        }
+        #endif
+        for (; index < source.size(); index++)
+            destination[index * 2] = destination[(index * 2) + 1] = source[index];
+    }
+}
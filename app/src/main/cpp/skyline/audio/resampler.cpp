@@ -1,18 +1,22 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
 #include "common.h"
 #include "resampler.h"
 
 namespace skyline::audio {
     /**
      * @brief The coefficients for each index of a single output frame
+     * @note These are contiguous so they can be loaded into a single vector
      */
     struct LutEntry {
-        i32 a;
-        i32 b;
-        i32 c;
-        i32 d;
+        i16 a;
+        i16 b;
+        i16 c;
+        i16 d;
     };
 
     // @fmt:off
@@ -119,40 +123,90 @@ namespace skyline::audio {
         {-42, 3751, 26253, 2811},   {-38, 3608, 26270, 2936},   {-34, 3467, 26281, 3064},   {-32, 3329, 26287, 3195}}};
     // @fmt:on
 
-    std::vector<i16> Resampler::ResampleBuffer(span<i16> inputBuffer, double ratio, u8 channelCount) {
-        auto step{static_cast<u32>(ratio * 0x8000)};
-        auto outputSize{static_cast<size_t>(inputBuffer.size() / ratio)};
-        std::vector<i16> outputBuffer(outputSize);
+    static const std::array<LutEntry, 128> &GetLut(u32 step) {
+        if (step > 0xAAAA)
+            return CurveLut0;
+        else if (step <= 0x8000)
+            return CurveLut1;
+        else
+            return CurveLut2;
+    }
+
+    /**
+     * @brief Filters the 4 consecutive input frames starting at the supplied pointer into a single output frame
+     */
+    static void FilterFrame(const i16 *frames, i16 *output, const LutEntry &coefficients, u8 channelCount) {
+        #ifdef __ARM_NEON
+        auto taps{vld1_s16(&coefficients.a)};
+        if (channelCount == 2) {
+            // The interleaved frames are multiplied by the taps duplicated for both channels, the products of both halves are then summed per-channel
+            auto samples{vld1q_s16(frames)};
+            auto products{vaddq_s32(vmull_s16(vget_low_s16(samples), vzip1_s16(taps, taps)), vmull_s16(vget_high_s16(samples), vzip2_s16(taps, taps)))};
+            auto sum{vadd_s32(vget_low_s32(products), vget_high_s32(products))};
+            auto result{vqmovn_s32(vcombine_s32(vshr_n_s32(sum, 15), vdup_n_s32(0)))};
+            vst1_lane_s16(output, result, 0);
+            vst1_lane_s16(output + 1, result, 1);
+            return;
+        } else if (channelCount == 1) {
+            *output = Saturate<i16, i32>(vaddvq_s32(vmull_s16(vld1_s16(frames), taps)) >> 15);
+            return;
+        }
+        #endif
+
+        for (u8 channel{}; channel < channelCount; channel++) {
+            i32 data{frames[channel] * coefficients.a +
+                     frames[channelCount + channel] * coefficients.b +
+                     frames[(channelCount * 2) + channel] * coefficients.c +
+                     frames[(channelCount * 3) + channel] * coefficients.d};
+
+            output[channel] = Saturate<i16, i32>(data >> 15);
+        }
+    }
+
+    u32 Resampler::GetStep(double ratio) {
+        return std::max(static_cast<u32>(ratio * 0x8000), 1U);
+    }
+
+    size_t Resampler::GetMaxOutputSize(size_t inputSize, double ratio, u8 channelCount) {
+        return ((((inputSize / channelCount) << 15) / GetStep(ratio)) + 1) * channelCount;
+    }
 
-        const std::array<LutEntry, 128> &lut = [step] {
-            if (step > 0xAAAA)
-                return CurveLut0;
-            else if (step <= 0x8000)
-                return CurveLut1;
-            else
-                return CurveLut2;
-        }();
+    void Resampler::Reset() {
+        fraction = 0;
+        skipFrames = 0;
+        history = {};
+    }
 
-        for (size_t outIndex{}, inIndex{}; outIndex < outputSize; outIndex += channelCount) {
-            u32 lutIndex{fraction >> 8};
+    size_t Resampler::Resample(span<const i16> input, span<i16> output, double ratio, u8 channelCount) {
+        if (!channelCount || channelCount > MaxChannelCount)
+            throw exception("Unsupported resampler channel count: {}", channelCount);
 
-            for (u8 channel{}; channel < channelCount; channel++) {
-                if (((inIndex + 3) * channelCount + channel) >= inputBuffer.size())
-                    continue;
+        auto step{GetStep(ratio)};
+        const auto &lut{GetLut(step)};
+        size_t inputFrames{input.size() / channelCount}, outputFrames{output.size() / channelCount};
 
-                i32 data{inputBuffer[(inIndex + 0) * channelCount + channel] * lut[lutIndex].a +
-                         inputBuffer[(inIndex + 1) * channelCount + channel] * lut[lutIndex].b +
-                         inputBuffer[(inIndex + 2) * channelCount + channel] * lut[lutIndex].c +
-                         inputBuffer[(inIndex + 3) * channelCount + channel] * lut[lutIndex].d};
+        // The input is treated as following the history frames, filters which straddle both are read from a contiguous copy of the history and the start of the input
+        std::array<i16, HistoryFrames * 2 * MaxChannelCount> edge{};
+        std::copy_n(history.begin(), HistoryFrames * channelCount, edge.begin());
+        std::copy_n(input.begin(), std::min(inputFrames, HistoryFrames) * channelCount, edge.begin() + (HistoryFrames * channelCount));
 
-                outputBuffer[outIndex + channel] = Saturate<i16, i32>(data >> 15);
-            }
+        // The position is the index of the first frame of the filter with the history frames at the start, the filter is in bounds while it's lower than the amount of input frames
+        size_t position{skipFrames}, outputFrame{};
+        for (; position < inputFrames && outputFrame < outputFrames; outputFrame++) {
+            auto frames{position < HistoryFrames ? edge.data() + (position * channelCount) : input.data() + ((position - HistoryFrames) * channelCount)};
+            FilterFrame(frames, output.data() + (outputFrame * channelCount), lut[fraction >> 8], channelCount);
 
             u32 newOffset{fraction + step};
-            inIndex += newOffset >> 15;
+            position += newOffset >> 15;
             fraction = newOffset & 0x7FFF;
         }
 
-        return outputBuffer;
+        // If the output ran out the rest of the input is dropped and the stream continues from its end
+        skipFrames = std::max(position, inputFrames) - inputFrames;
+
+        auto lastFrames{inputFrames >= HistoryFrames ? input.data() + ((inputFrames - HistoryFrames) * channelCount) : edge.data() + (inputFrames * channelCount)};
+        std::copy_n(lastFrames, HistoryFrames * channelCount, history.begin());
+
+        return outputFrame * channelCount;
     }
 }
@@ -7,19 +7,39 @@
 
 namespace skyline::audio {
     /**
-     * @brief The Resampler class handles resampling audio PCM data
+     * @brief The Resampler class handles resampling a stream of audio PCM data with a 4-tap filter
+     * @note The state is carried over between buffers so consecutive buffers of a stream are resampled without discontinuities, Reset must be called when starting a new stream
      */
     class Resampler {
       private:
-        u32 fraction{}; //!< The fractional value used for storing the resamplers last frame
+        static constexpr size_t HistoryFrames{3}; //!< The amount of input frames that the filter reads past the current frame
+        static constexpr u8 MaxChannelCount{6};
+
+        u32 fraction{}; //!< The fractional position between the current input frames in 1.15 fixed point
+        size_t skipFrames{}; //!< The amount of frames that the position has advanced past the end of the previous buffer
+        std::array<i16, HistoryFrames * MaxChannelCount> history{}; //!< The last frames of the previous buffer, these are the first taps of the filter at the start of the next buffer
+
+        static u32 GetStep(double ratio);
 
       public:
         /**
-         * @brief Resamples the given sample buffer by the given ratio
-         * @param inputBuffer A buffer containing PCM sample data
+         * @return The maximum amount of samples that resampling a buffer of the supplied size can produce
+         */
+        static size_t GetMaxOutputSize(size_t inputSize, double ratio, u8 channelCount);
+
+        /**
+         * @brief Resets the state of the resampler for a new stream
+         */
+        void Reset();
+
+        /**
+         * @brief Resamples the given sample buffer by the given ratio and writes the result into the output buffer
+         * @param input A buffer containing PCM sample data
+         * @param output The buffer to write resampled PCM sample data into, it should be at least GetMaxOutputSize samples large otherwise the remaining input is dropped
          * @param ratio The conversion ratio needed
-         * @param channelCount The amount of channels the buffer contains
+         * @param channelCount The amount of channels the buffers contain, this must stay the same throughout a stream
+         * @return The amount of samples that were written into the output buffer
          */
-        std::vector<i16> ResampleBuffer(span <i16> inputBuffer, double ratio, u8 channelCount);
+        size_t Resample(span<const i16> input, span<i16> output, double ratio, u8 channelCount);
     };
 }
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/memory_accounting.h>
+#include "mix.h"
 #include "track.h"
 
 namespace skyline::audio {
@@ -13,32 +15,42 @@ namespace skyline::audio {
 
         if (channelCount != constant::ChannelCount)
             throw exception("Unsupported quantity of audio channels: {}", channelCount);
+
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::AudioBuffers, sizeof(samples));
+    }
+
+    AudioTrack::~AudioTrack() {
+        perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::AudioBuffers, sizeof(samples));
     }
 
     void AudioTrack::Stop() {
-        while (!identifiers.end()->released);
+        u64 finalSample;
+        {
+            std::lock_guard guard(bufferLock);
+            finalSample = appendedSamples;
+        }
+
+        while (sampleCounter.load(std::memory_order_acquire) < finalSample)
+            std::this_thread::yield();
         playbackState = AudioOutState::Stopped;
     }
 
     bool AudioTrack::ContainsBuffer(u64 tag) {
-        // Iterate from front of queue as we don't want released samples
-        for (auto identifier{identifiers.crbegin()}; identifier != identifiers.crend(); identifier++) {
-            if (identifier->released)
-                return false;
-
-            if (identifier->tag == tag)
-                return true;
-        }
+        std::lock_guard guard(bufferLock);
+        auto playedSamples{sampleCounter.load(std::memory_order_acquire)};
 
-        return false;
+        return std::any_of(identifiers.begin(), identifiers.end(), [&](const BufferIdentifier &identifier) {
+            return identifier.tag == tag && identifier.finalSample > playedSamples;
+        });
     }
 
     std::vector<u64> AudioTrack::GetReleasedBuffers(u32 max) {
         std::vector<u64> bufferIds;
-        std::lock_guard trackGuard(bufferLock);
+        std::lock_guard guard(bufferLock);
+        auto playedSamples{sampleCounter.load(std::memory_order_acquire)};
 
         for (u32 index{}; index < max; index++) {
-            if (identifiers.empty() || !identifiers.back().released)
+            if (identifiers.empty() || identifiers.back().finalSample > playedSamples)
                 break;
             bufferIds.push_back(identifiers.back().tag);
             identifiers.pop_back();
@@ -48,29 +60,104 @@ namespace skyline::audio {
     }
 
     void AudioTrack::AppendBuffer(u64 tag, span<i16> buffer) {
-        BufferIdentifier identifier{
-            .released = false,
+        std::lock_guard guard(bufferLock);
+
+        // Samples that don't fit into the ring buffer are dropped, the final sample is based on the written samples so the buffer is still released after being played
+        appendedSamples += samples.Write(buffer);
+        identifiers.push_front(BufferIdentifier{
             .tag = tag,
-            .finalSample = identifiers.empty() ? (buffer.size()) : (buffer.size() + identifiers.front().finalSample)
-        };
+            .finalSample = appendedSamples,
+        });
+        releaseSamples.Write(span<const u64>(&appendedSamples, 1)); // If this is full, the release is signalled alongside a later buffer's
+    }
 
-        std::lock_guard guard(bufferLock);
+    size_t AudioTrack::Read(span<i16> destination, size_t mixSamples) {
+        queueSize += (static_cast<float>(samples.Size()) - queueSize) * QueueSmoothing;
+
+        // The guest only appending less than a callback's worth of samples on average means emulation is running slow, stretching them out fills in some of the gaps
+        float playbackRate{1.0f};
+        if (queueSize < static_cast<float>(destination.size()))
+            playbackRate -= StretchRate;
+        else if (queueSize > static_cast<float>(StretchHighWatermark))
+            playbackRate += StretchRate;
+
+        size_t writtenSamples{}, consumedSamples{};
+        if (playbackRate == 1.0f) {
+            while (writtenSamples < destination.size()) {
+                auto source{samples.Peek()};
+                if (source.empty())
+                    break;
+                source = source.first(std::min(source.size(), destination.size() - writtenSamples));
+
+                auto target{destination.subspan(writtenSamples, source.size())};
+                auto overlapSamples{std::min(source.size(), mixSamples > writtenSamples ? mixSamples - writtenSamples : 0)};
+                MixSamples(target.first(overlapSamples), source.first(overlapSamples));
+                std::memcpy(target.data() + overlapSamples, source.data() + overlapSamples, (source.size() - overlapSamples) * sizeof(i16));
+
+                samples.Consume(source.size());
+                writtenSamples += source.size();
+            }
+            consumedSamples = writtenSamples;
+
+            // The last played frame is retained so time-stretching can seamlessly continue from it
+            if (writtenSamples >= constant::ChannelCount) {
+                std::copy_n(destination.data() + writtenSamples - constant::ChannelCount, constant::ChannelCount, stretchFrames[1].begin());
+                stretchPosition = 1.0f;
+            }
+        } else {
+            auto source{samples.Peek()};
+            size_t sourceOffset{};
+            while (writtenSamples + constant::ChannelCount <= destination.size()) {
+                stretchPosition += playbackRate;
+                while (stretchPosition > 1.0f) {
+                    if (sourceOffset + constant::ChannelCount > source.size()) {
+                        samples.Consume(sourceOffset);
+                        source = samples.Peek();
+                        sourceOffset = 0;
+                        if (source.size() < constant::ChannelCount)
+                            break;
+                    }
+
+                    stretchFrames[0] = stretchFrames[1];
+                    std::copy_n(source.data() + sourceOffset, constant::ChannelCount, stretchFrames[1].begin());
+                    sourceOffset += constant::ChannelCount;
+                    consumedSamples += constant::ChannelCount;
+                    stretchPosition -= 1.0f;
+                }
+
+                if (stretchPosition > 1.0f) {
+                    stretchPosition -= playbackRate; // The sample buffer ran dry, the frame is output by a later callback instead
+                    break;
+                }
+
+                for (size_t channel{}; channel < constant::ChannelCount; channel++) {
+                    auto previous{static_cast<float>(stretchFrames[0][channel])};
+                    auto sample{static_cast<i16>(previous + ((static_cast<float>(stretchFrames[1][channel]) - previous) * stretchPosition))};
+                    auto &output{destination[writtenSamples + channel]};
+                    output = (writtenSamples + channel < mixSamples) ? Saturate<i16, i32>(static_cast<i32>(output) + static_cast<i32>(sample)) : sample;
+                }
+                writtenSamples += constant::ChannelCount;
+            }
+            samples.Consume(sourceOffset);
+        }
 
-        identifiers.push_front(identifier);
-        samples.Append(buffer);
+        sampleCounter.fetch_add(consumedSamples, std::memory_order_release);
+        return writtenSamples;
     }
 
     void AudioTrack::CheckReleasedBuffers() {
-        bool anyReleased{};
+        auto playedSamples{sampleCounter.load(std::memory_order_relaxed)};
 
-        for (auto &identifier : identifiers) {
-            if (identifier.finalSample <= sampleCounter && !identifier.released) {
-                anyReleased = true;
-                identifier.released = true;
-            }
+        size_t released{};
+        for (auto finalSample : releaseSamples.Peek()) {
+            if (finalSample > playedSamples)
+                break;
+            released++;
         }
 
-        if (anyReleased)
+        if (released) {
+            releaseSamples.Consume(released);
             releaseCallback();
+        }
     }
 }
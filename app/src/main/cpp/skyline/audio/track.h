@@ -4,27 +4,39 @@
 #pragma once
 
 #include <kernel/types/KEvent.h>
-#include <common/circular_buffer.h>
+#include <common/spsc_ring_buffer.h>
 #include "common.h"
 
 namespace skyline::audio {
     /**
      * @brief The AudioTrack class manages the buffers for an audio stream
+     * @note The audio callback only interacts with the track through lock-free SPSC ring buffers and atomics, the guest-facing functions are synchronized amongst themselves with bufferLock
      */
     class AudioTrack {
       private:
         std::function<void()> releaseCallback; //!< Callback called when a buffer has been played
         std::deque<BufferIdentifier> identifiers; //!< Queue of all appended buffer identifiers
+        std::mutex bufferLock; //!< Synchronizes appending buffers and accessing their identifiers, this is never locked by the audio callback
+        u64 appendedSamples{}; //!< The total amount of samples that were written into the sample buffer
+
+        SpscRingBuffer<u64, 256> releaseSamples; //!< The final samples of all appended buffers which the audio callback hasn't seen being released yet
 
         u8 channelCount;
         u32 sampleRate;
 
+        static constexpr float StretchRate{0.03f}; //!< The maximum deviation of the playback rate from 1 while time-stretching, this is small enough to not be noticeable as a change in pitch
+        static constexpr float QueueSmoothing{0.1f}; //!< The weight of the latest measurement in the smoothed queue size
+        static constexpr size_t StretchHighWatermark{constant::MixBufferSize * constant::ChannelCount * 8}; //!< The smoothed queue size above which playback is sped up to reduce latency, this is 8 callbacks worth of samples
+
+        float queueSize{}; //!< An exponential moving average of the amount of queued samples at the start of every callback
+        float stretchPosition{1.0f}; //!< The position of the next output frame between the two stretch frames
+        std::array<std::array<i16, constant::ChannelCount>, 2> stretchFrames{}; //!< The last two frames consumed from the sample buffer, output frames are interpolated between these while time-stretching
+
       public:
-        CircularBuffer<i16, constant::SampleRate * constant::ChannelCount * 10> samples; //!< A circular buffer with all appended audio samples
-        std::mutex bufferLock; //!< Synchronizes appending to audio buffers
+        SpscRingBuffer<i16, std::bit_ceil(static_cast<size_t>(constant::SampleRate) * constant::ChannelCount * 10)> samples; //!< A ring buffer with all appended audio samples, this is consumed by the audio callback
 
-        AudioOutState playbackState{AudioOutState::Stopped}; //!< The current state of playback
-        u64 sampleCounter{}; //!< A counter used for tracking when buffers have been played and can be released
+        std::atomic<AudioOutState> playbackState{AudioOutState::Stopped}; //!< The current state of playback
+        std::atomic<u64> sampleCounter{}; //!< The amount of samples played by the audio callback, this is used for tracking when buffers have been played and can be released
 
         /**
          * @param channelCount The amount channels that will be present in the track
@@ -33,6 +45,8 @@ namespace skyline::audio {
          */
         AudioTrack(u8 channelCount, u32 sampleRate, std::function<void()> releaseCallback);
 
+        ~AudioTrack();
+
         /**
          * @brief Starts audio playback using data from appended buffers
          */
@@ -66,9 +80,17 @@ namespace skyline::audio {
          */
         void AppendBuffer(u64 tag, span<i16> buffer = {});
 
+        /**
+         * @brief Writes the samples for a single audio callback into the destination, if the guest is persistently too slow or too fast at appending samples they're time-stretched to avoid starving or accumulating latency
+         * @param mixSamples The amount of samples at the start of the destination which were already written by another track, the track's samples are mixed into these rather than overwriting them
+         * @return The amount of samples that were written into the destination
+         * @note This must only be called from the audio callback, sampleCounter is updated with the amount of samples that were consumed
+         */
+        size_t Read(span<i16> destination, size_t mixSamples);
+
         /**
          * @brief Checks if any buffers have been released and calls the appropriate callback for them
-         * @note bufferLock MUST be locked when calling this
+         * @note This must only be called from the audio callback after updating sampleCounter
          */
         void CheckReleasedBuffers();
     };
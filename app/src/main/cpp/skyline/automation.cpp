@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fstream>
+#include <numeric>
+#include <sys/resource.h>
+#include <common/settings.h>
+#include <common/trace.h>
+#include <common/performance_counters.h>
+#include <kernel/types/KProcess.h>
+#include <input.h>
+#include <os.h>
+#include "automation.h"
+
+namespace skyline {
+    Automation::Automation(const DeviceState &state) : state(state), frameCount(state.settings->automationFrames) {
+        frametimes.reserve(frameCount);
+
+        const auto &inputPath{state.settings->automationInput};
+        if (!inputPath.empty()) {
+            std::ifstream file(inputPath, std::ios::binary | std::ios::ate);
+            if (!file)
+                throw exception("Failed to open automation input file: {}", inputPath);
+
+            auto size{static_cast<size_t>(file.tellg())};
+            if (size % sizeof(InputRecord))
+                throw exception("Automation input file isn't a whole amount of records: 0x{:X} bytes", size);
+
+            inputs.resize(size / sizeof(InputRecord));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(inputs.data()), static_cast<std::streamsize>(size));
+            if (!std::is_sorted(inputs.begin(), inputs.end(), [](const InputRecord &a, const InputRecord &b) { return a.frame < b.frame; }))
+                throw exception("Automation input records aren't sorted by frame");
+        }
+
+        Logger::Info("Automated run: {} frames with {} input events", frameCount, inputs.size());
+    }
+
+    void Automation::OnFramePresented(i64 timestamp) {
+        if (finished)
+            return;
+
+        if (firstFrameTime)
+            frametimes.push_back(timestamp - lastFrameTime);
+        else
+            firstFrameTime = timestamp;
+        lastFrameTime = timestamp;
+        presentedFrames++;
+        peakTextureMemory = std::max(peakTextureMemory, perf::SharedCounters.textureMemory.load(std::memory_order_relaxed));
+
+        for (; nextInput < inputs.size() && inputs[nextInput].frame <= presentedFrames; nextInput++)
+            state.input->npad.SubmitHostEvents(span<const input::HostInputEvent>{&inputs[nextInput].event, 1});
+
+        if (presentedFrames >= frameCount) {
+            finished = true;
+            WriteReport();
+            state.process->Kill(false, false, true);
+        }
+    }
+
+    void Automation::WriteReport() {
+        auto sorted{frametimes};
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile{[&](double fraction) -> i64 {
+            if (sorted.empty())
+                return 0;
+            return sorted[std::min(static_cast<size_t>(fraction * static_cast<double>(sorted.size())), sorted.size() - 1)];
+        }};
+        i64 totalFrametime{std::accumulate(sorted.begin(), sorted.end(), i64{})};
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+
+        auto bootStart{trace::BootProfile::GetStart()};
+        auto reportPath{state.os->appFilesPath + "automation_report.json"};
+        std::ofstream file(reportPath, std::ios::trunc);
+        file << util::Format(R"({{"frames":{},"boot_time_ns":{},"frametime_average_ns":{},"frametime_p50_ns":{},"frametime_p90_ns":{},"frametime_p99_ns":{},"frametime_p999_ns":{},"frametime_max_ns":{},"peak_rss_bytes":{},"texture_memory_bytes":{},"peak_texture_memory_bytes":{}}})",
+                             presentedFrames, bootStart ? firstFrameTime - bootStart : 0, sorted.empty() ? 0 : totalFrametime / static_cast<i64>(sorted.size()),
+                             percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), sorted.empty() ? 0 : sorted.back(),
+                             static_cast<u64>(usage.ru_maxrss) * 1024, perf::SharedCounters.textureMemory.load(std::memory_order_relaxed), peakTextureMemory) << std::endl;
+
+        Logger::Info("Automated run finished after {} frames, the report has been written to {}", presentedFrames, reportPath);
+    }
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <input/npad.h>
+
+namespace skyline {
+    /**
+     * @brief Drives an automated benchmark run, this replays input from a file, stops emulation after a fixed amount of frames and writes a JSON report of the run
+     * @note The report contains the boot time, frametime percentiles, peak RSS and GPU memory usage, it's written to automation_report.json in the app's files directory
+     */
+    class Automation {
+      public:
+        /**
+         * @brief A host input event which is submitted once the supplied amount of frames has been presented, input replay files are a sequence of these sorted by frame
+         * @note This is the same HostInputEvent layout that the Kotlin side submits, recordings of those can be replayed directly
+         */
+        struct InputRecord {
+            u32 frame;
+            u32 _pad_;
+            input::HostInputEvent event;
+        };
+        static_assert(sizeof(InputRecord) == 0x18);
+
+      private:
+        const DeviceState &state;
+        u32 frameCount; //!< The amount of frames after which the run is finished
+
+        std::vector<InputRecord> inputs;
+        size_t nextInput{}; //!< The index of the next input record to submit
+
+        u32 presentedFrames{};
+        i64 firstFrameTime{}; //!< The timestamp at which the first frame was presented, this is 0 prior to it
+        i64 lastFrameTime{};
+        std::vector<i64> frametimes; //!< The time between every presented frame and the one prior to it in nanoseconds
+        u64 peakTextureMemory{};
+        bool finished{};
+
+        void WriteReport();
+
+      public:
+        /**
+         * @note This must only be constructed when Settings::automationFrames is non-zero
+         */
+        Automation(const DeviceState &state);
+
+        /**
+         * @brief Accounts for a frame being presented, this submits any input scheduled up to it and stops emulation once the run is finished
+         * @note This must only be called from the presentation thread
+         */
+        void OnFramePresented(i64 timestamp);
+    };
+}
@@ -4,6 +4,9 @@
 #pragma once
 
 #include <concepts>
+#include <atomic>
+#include <map>
+#include <set>
 #include <common.h>
 
 namespace skyline {
@@ -53,6 +56,24 @@ namespace skyline {
         std::mutex blockMutex;
         std::vector<Block> blocks{Block{}};
 
+        using VaRange = std::pair<VaType, VaType>; //!< The start and end of a range in the AS
+
+        bool deferUnmapCallbacks{}; //!< If calls to the unmap callback are deferred till EndDeferredUnmapsLocked, this is used to coalesce the callbacks of batched operations
+        std::vector<VaRange> deferredUnmaps; //!< Every range which the unmap callback was deferred for
+
+        /**
+         * @brief Calls the unmap callback for the supplied range or defers it if deferUnmapCallbacks is set
+         * @note blockMutex MUST be locked when calling this
+         */
+        void UnmapCallbackLocked(VaType virt, VaType size);
+
+        /**
+         * @brief Stops deferring unmap callbacks and calls the callback once for every merged range that was deferred
+         * @return Every merged range in ascending order
+         * @note blockMutex MUST be locked when calling this
+         */
+        std::vector<VaRange> EndDeferredUnmapsLocked();
+
         /**
          * @brief Maps a PA range into the given AS region
          * @note blockMutex MUST be locked when calling this
@@ -94,18 +115,82 @@ namespace skyline {
 
     /**
      * @brief FlatMemoryManager specialises FlatAddressSpaceMap to focus on pointers as PAs, adding read/write functions and sparse mapping support
+     * @tparam PageTableBits The log2 of the page size of an optional two-level page table which mirrors the blocks, this allows accesses contained within a single page to be translated in constant time rather than by searching the blocks, a value of 0 disables the page table
      */
-    template<typename VaType, VaType UnmappedVa, size_t AddressSpaceBits> requires AddressSpaceValid<VaType, AddressSpaceBits>
+    template<typename VaType, VaType UnmappedVa, size_t AddressSpaceBits, size_t PageTableBits = 0> requires AddressSpaceValid<VaType, AddressSpaceBits>
     class FlatMemoryManager : public FlatAddressSpaceMap<VaType, UnmappedVa, u8 *, nullptr, true, AddressSpaceBits, MemoryManagerBlockInfo> {
       private:
+        using Base = FlatAddressSpaceMap<VaType, UnmappedVa, u8 *, nullptr, true, AddressSpaceBits, MemoryManagerBlockInfo>;
+
         static constexpr u64 SparseMapSize{0x400000000}; //!< 16GiB pool size for sparse mappings returned by TranslateRange, this number is arbritary and should be large enough to fit the largest sparse mapping in the AS
         u8 *sparseMap; //!< Pointer to a zero filled memory region that is returned by TranslateRange for sparse mappings
 
+        static constexpr size_t PageTableLeafBits{(AddressSpaceBits - PageTableBits) / 2}; //!< The amount of page index bits that are resolved by a leaf table
+        static constexpr size_t PageTableRootBits{AddressSpaceBits - PageTableBits - PageTableLeafBits}; //!< The amount of page index bits that are resolved by the root table
+        using PageTableLeaf = std::array<u8 *, 1ULL << PageTableLeafBits>; //!< A table of host pointers for every page it covers, pages which aren't entirely covered by a regular mapping are null
+
+        static inline const PageTableLeaf EmptyPageTableLeaf{}; //!< A leaf which all root entries without an allocated leaf point to, this avoids checking for missing leaves during lookups
+        std::vector<const PageTableLeaf *> pageTable; //!< The root table of the page table, this is empty when the page table is disabled
+        std::vector<std::unique_ptr<PageTableLeaf>> pageTableLeaves; //!< The leaves which were allocated for each root entry, leaves are only allocated once a page in them is mapped and are retained till destruction
+
+        /**
+         * @brief Updates the page table entries of all pages overlapping the supplied region to reflect the current state of the blocks
+         * @note blockMutex MUST be locked when calling this
+         */
+        void UpdatePageTableLocked(VaType virt, VaType size);
+
+        /**
+         * @return A host pointer to the supplied address if it's within a page which is entirely covered by a regular mapping, otherwise nullptr
+         * @note blockMutex MUST be locked when calling this and the page table must be enabled
+         */
+        u8 *LookupPageTableLocked(VaType virt) {
+            VaType page{virt >> PageTableBits};
+            u8 *pagePhys{(*pageTable[page >> PageTableLeafBits])[page & ((1ULL << PageTableLeafBits) - 1)]};
+            return pagePhys ? pagePhys + (virt & (PageSize - 1)) : nullptr;
+        }
+
       public:
+        static constexpr VaType PageSize{PageTableBits ? (1ULL << PageTableBits) : 0}; //!< The size of a page in the page table, this is 0 when the page table is disabled
+
+        std::atomic<u32> generation{}; //!< A counter which is incremented whenever any mapping in the AS changes, translation caches compare against this to determine if their contents are stale
+
         FlatMemoryManager();
 
         ~FlatMemoryManager();
 
+        /**
+         * @note This shadows FlatAddressSpaceMap::Map to keep the page table in sync with the blocks
+         */
+        void Map(VaType virt, u8 *phys, VaType size, MemoryManagerBlockInfo extraInfo = {}) {
+            std::scoped_lock lock(this->blockMutex);
+            this->MapLocked(virt, phys, size, extraInfo);
+            UpdatePageTableLocked(virt, size);
+        }
+
+        /**
+         * @note This shadows FlatAddressSpaceMap::Unmap to keep the page table in sync with the blocks
+         */
+        void Unmap(VaType virt, VaType size) {
+            std::scoped_lock lock(this->blockMutex);
+            this->UnmapLocked(virt, size);
+            UpdatePageTableLocked(virt, size);
+        }
+
+        /**
+         * @brief A single operation in a batch, regions with a null PA are unmapped
+         */
+        struct MapOperation {
+            VaType virt;
+            u8 *phys;
+            VaType size;
+            MemoryManagerBlockInfo extraInfo{};
+        };
+
+        /**
+         * @brief Applies a batch of map and unmap operations in order under a single lock, the page table and the unmap callback are updated once for every merged range rather than once for every operation
+         */
+        void MapBatch(span<const MapOperation> operations);
+
         /**
          * @return A placeholder address for sparse mapped regions, this means nothing
          */
@@ -113,8 +198,18 @@ namespace skyline {
             return reinterpret_cast<u8 *>(0xCAFEBABE);
         }
 
+        /**
+         * @return A host pointer to the start of the page containing the supplied address if the page is entirely covered by a regular mapping, otherwise nullptr
+         * @note This requires the page table to be enabled
+         */
+        u8 *TranslatePage(VaType virt) requires (PageTableBits != 0) {
+            std::scoped_lock lock(this->blockMutex);
+            return LookupPageTableLocked(util::AlignDown(virt, PageSize));
+        }
+
         /**
          * @brief Returns a vector of all physical ranges inside of the given virtual range
+         * @note Any unmapped regions inside the range will be returned as spans with a null pointer
          */
         std::vector<span<u8>> TranslateRange(VaType virt, VaType size);
 
@@ -147,14 +242,23 @@ namespace skyline {
 
 
     /**
-     * @brief FlatMemoryManager specialises FlatAddressSpaceMap to work as an allocator, with an initial, fast linear pass and a subsequent slower pass that iterates until it finds a free block
+     * @brief FlatMemoryManager specialises FlatAddressSpaceMap to work as an allocator, allocations continue linearly from the end of the previous one while possible and otherwise use the smallest free region that fits
+     * @note All free regions are indexed by their start and by their size alongside the blocks, this keeps allocation logarithmic in the amount of blocks regardless of how fragmented the AS is
      */
     template<typename VaType, VaType UnmappedVa, size_t AddressSpaceBits> requires AddressSpaceValid<VaType, AddressSpaceBits>
     class FlatAllocator : public FlatAddressSpaceMap<VaType, UnmappedVa, bool, false, false, AddressSpaceBits> {
       private:
         using Base = FlatAddressSpaceMap<VaType, UnmappedVa, bool, false, false, AddressSpaceBits>;
 
-        VaType currentLinearAllocEnd; //!< The end address for the initial linear allocation pass, once this reaches the AS limit the slower allocation path will be used
+        VaType currentLinearAllocEnd; //!< The end address of the previous allocation, the next allocation is placed here if the free region it's in is large enough
+        std::map<VaType, VaType> freeRegions; //!< A map from the start of every free region within [vaStart, vaLimit) to its end
+        std::set<std::pair<VaType, VaType>> freeRegionSizes; //!< The size and start of every free region, this is ordered to find the smallest region which fits an allocation
+
+        /**
+         * @brief Recomputes the free regions overlapping or adjacent to the supplied range from the blocks, this must be called after any change to the blocks in the range
+         * @note blockMutex MUST be locked when calling this
+         */
+        void UpdateFreeRegionsLocked(VaType virt, VaType virtEnd);
 
       public:
         VaType vaStart; //!< The base VA of the allocator, no allocations will be below this
@@ -163,6 +267,7 @@ namespace skyline {
 
         /**
          * @brief Allocates a region in the AS of the given size and returns its address
+         * @return The address of the region or 0 if there's no free region large enough
          */
         VaType Allocate(VaType size);
 
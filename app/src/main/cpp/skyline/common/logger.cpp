@@ -1,26 +1,440 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <condition_variable>
+#include <shared_mutex>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <android/log.h>
 #include "utils.h"
+#include "spsc_ring_buffer.h"
 #include "logger.h"
 
 namespace skyline {
+    /**
+     * @brief The header of a log record in a thread's log ring, it's immediately followed by the message
+     */
+    struct LogRecordHeader {
+        Logger::LoggerContext *context; //!< The context the log was written in, logs without one are only written to logcat
+        i64 timestamp; //!< The time at which the log was written in milliseconds relative to the start of the context
+        u32 length; //!< The length of the message in bytes
+        u32 formatId; //!< The ID of the format string for binary records, the message is the serialized arguments in that case
+        u32 threadId; //!< The kernel TID of the thread that wrote the log
+        Logger::LogLevel level;
+        std::array<char, 16> threadName; //!< The name of the thread that wrote the log, this is copied as the writing thread may be renamed or exit before the log is written out
+    };
+
+    constexpr size_t LogRingSize{0x10000}; //!< The size of the log ring of every thread in bytes
+    using LogRing = SpscRingBuffer<u8, LogRingSize>;
+
+    /**
+     * @brief The header of a binary log file, this is followed by a ring of BinaryRecordHeader prefixed records
+     * @note This must be kept in sync with the decoder in tools/decode_binary_log.py
+     */
+    struct BinaryLogHeader {
+        std::array<char, 8> magic{'S', 'K', 'Y', 'B', 'L', 'O', 'G', '\0'};
+        u32 version{1};
+        u32 headerSize{sizeof(BinaryLogHeader)};
+        u64 ringSize; //!< The size of the ring of records in bytes
+        u64 writeOffset; //!< The free-running offset into the ring after the last record, records prior to writeOffset - ringSize have been overwritten
+        i64 startTime; //!< The UNIX time in milliseconds at which the context was started, all record timestamps are relative to this
+    };
+    static_assert(sizeof(BinaryLogHeader) == 0x28);
+
+    /**
+     * @brief The header of a single record in the binary log ring, this is followed by the serialized arguments or the formatted message for records without a format string
+     */
+    struct __attribute__((packed)) BinaryRecordHeader {
+        static constexpr u32 Magic{0x52594B53}; //!< "SKYR" to allow finding the first complete record in a ring that has wrapped around
+        u32 magic{Magic};
+        u32 size; //!< The size of the record including this header
+        i64 timestamp; //!< The time at which the log was written in milliseconds relative to the start time
+        u32 threadId;
+        u32 formatId; //!< The ID of the format string in the string table, 0 for records with a formatted message
+        u8 level;
+    };
+
+    /**
+     * @brief The type of an entry in the string table of a binary log, entries are a type, a 32-bit ID and a 32-bit length followed by the string
+     */
+    enum class BinaryStringType : u8 {
+        Format, //!< A format string ID, the string is the name of the calling function and the format string separated by a null terminator
+        Thread, //!< A thread ID, the string is the name of the thread
+    };
+
+    static std::mutex formatMutex; //!< Synchronizes access to formatStrings and formatIds
+    static std::vector<std::pair<const char *, const char *>> formatStrings; //!< The function and format string of every format ID, the ID of an entry is its index plus one
+    static std::map<std::pair<const char *, const char *>, u32> formatIds; //!< A mapping from the function and format string to their ID
+
+    /**
+     * @return The function and format string with the supplied ID
+     */
+    static std::pair<const char *, const char *> GetFormat(u32 id) {
+        std::scoped_lock lock(formatMutex);
+        return formatStrings.at(id - 1);
+    }
+
+    /**
+     * @brief The background thread which drains the log rings of all threads and writes them out to logcat and the log file of their context
+     */
+    class LogBackend {
+      private:
+        static constexpr std::chrono::milliseconds DrainPeriod{10}; //!< The period at which the rings are drained when they aren't filling up
+
+        std::mutex mutex; //!< Synchronizes all members aside from the rings themselves
+        std::condition_variable wakeCondition; //!< Signalled to drain the rings prior to the end of the period
+        std::condition_variable flushCondition; //!< Signalled after every drain so Flush can return
+        std::vector<std::shared_ptr<LogRing>> rings; //!< The rings of all threads which have written logs, rings are dropped once they're empty and their thread has exited
+        u64 flushRequest{}; //!< The amount of times a drain was explicitly requested
+        u64 flushComplete{}; //!< The value of flushRequest at the start of the last completed drain
+        bool wake{};
+        bool exit{};
+
+        struct Record {
+            LogRecordHeader header;
+            std::string message;
+        };
+        std::vector<Record> records; //!< A buffer for the records of a single drain, this is only accessed by the background thread
+        std::vector<u8> binaryRecord; //!< A buffer for a single binary record, this is only accessed by the background thread
+        std::thread thread; //!< The background thread, this must be declared last as it's started on construction
+
+        /**
+         * @brief Copies the supplied amount of bytes out of a ring and consumes them
+         * @note The bytes must all be present in the ring already
+         */
+        static void Read(LogRing &ring, u8 *data, size_t size) {
+            while (size) {
+                auto peeked{ring.Peek()};
+                auto count{std::min(peeked.size(), size)};
+                std::memcpy(data, peeked.data(), count);
+                ring.Consume(count);
+                data += count;
+                size -= count;
+            }
+        }
+
+        /**
+         * @brief Writes a string table entry for a binary context
+         */
+        static void WriteString(Logger::LoggerContext &context, BinaryStringType type, u32 id, std::string_view string) {
+            struct __attribute__((packed)) {
+                BinaryStringType type;
+                u32 id;
+                u32 length;
+            } entry{type, id, static_cast<u32>(string.size())};
+
+            std::lock_guard guard(context.mutex);
+            context.logFile.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+            context.logFile.write(string.data(), static_cast<std::streamsize>(string.size()));
+            context.logFile.flush(); // Entries are rare and the ring is written out by the kernel on a crash, the table must be written out eagerly to be able to decode it in that case
+        }
+
+        void WriteBinary(Logger::LoggerContext &context, const Record &record) {
+            const auto &header{record.header};
+            if (header.formatId) {
+                if (context.writtenFormats.size() <= header.formatId)
+                    context.writtenFormats.resize(header.formatId + 1);
+                if (!context.writtenFormats[header.formatId]) {
+                    auto [function, format]{GetFormat(header.formatId)};
+                    std::string string{function};
+                    string.push_back('\0');
+                    string += format;
+                    WriteString(context, BinaryStringType::Format, header.formatId, string);
+                    context.writtenFormats[header.formatId] = true;
+                }
+            }
+
+            std::string_view threadName{header.threadName.data()};
+            auto &writtenName{context.writtenThreads[header.threadId]};
+            if (writtenName != threadName) {
+                WriteString(context, BinaryStringType::Thread, header.threadId, threadName);
+                writtenName = threadName;
+            }
+
+            BinaryRecordHeader binaryHeader{
+                .size = static_cast<u32>(sizeof(BinaryRecordHeader) + record.message.size()),
+                .timestamp = header.timestamp,
+                .threadId = header.threadId,
+                .formatId = header.formatId,
+                .level = static_cast<u8>(header.level),
+            };
+            binaryRecord.resize(binaryHeader.size);
+            std::memcpy(binaryRecord.data(), &binaryHeader, sizeof(BinaryRecordHeader));
+            std::memcpy(binaryRecord.data() + sizeof(BinaryRecordHeader), record.message.data(), record.message.size());
+            context.WriteBinary(binaryRecord);
+        }
+
+        void Drain(const std::vector<std::shared_ptr<LogRing>> &drainRings) {
+            // Records are only ever written as a whole, when the header is visible so is the message
+            for (const auto &ring : drainRings) {
+                while (ring->Size() >= sizeof(LogRecordHeader)) {
+                    auto &record{records.emplace_back()};
+                    Read(*ring, reinterpret_cast<u8 *>(&record.header), sizeof(LogRecordHeader));
+                    record.message.resize(record.header.length);
+                    Read(*ring, reinterpret_cast<u8 *>(record.message.data()), record.header.length);
+                }
+            }
+
+            if (records.empty())
+                return;
+
+            // Logs from all threads are interleaved by their timestamp as they would've been when written synchronously
+            std::stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+                return a.header.timestamp < b.header.timestamp;
+            });
+
+            constexpr std::array<int, 5> levelAlog{ANDROID_LOG_ERROR, ANDROID_LOG_WARN, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE}; // This corresponds to LogLevel and provides its equivalent for NDK Logging
+            constexpr std::array<char, 5> levelCharacter{'E', 'W', 'I', 'D', 'V'}; // The LogLevel as written out to a file
+
+            std::string tag;
+            Logger::LoggerContext *batchContext{};
+            std::string batch;
+            auto flushBatch{[&]() {
+                if (batchContext && !batch.empty())
+                    batchContext->Write(batch);
+                batch.clear();
+            }};
+
+            for (const auto &record : records) {
+                const auto &header{record.header};
+                std::string_view threadName{header.threadName.data()};
+
+                if (header.context && header.context->binary) {
+                    // Binary logs are only written to the log file, formatting them for logcat would defeat the purpose of them
+                    WriteBinary(*header.context, record);
+                    continue;
+                }
+
+                tag = "emu-cpp-";
+                tag += threadName;
+                __android_log_write(levelAlog[static_cast<u8>(header.level)], tag.c_str(), record.message.c_str());
+
+                if (!header.context)
+                    continue;
+
+                if (header.context != batchContext) {
+                    flushBatch();
+                    batchContext = header.context;
+                }
+
+                // We use RS (\036) and GS (\035) as our delimiters
+                fmt::format_to(std::back_inserter(batch), "\036{}\035{}\035{}\035{}\n", levelCharacter[static_cast<u8>(header.level)], header.timestamp, threadName, record.message);
+            }
+            flushBatch();
+
+            records.clear();
+        }
+
+        void Run() {
+            pthread_setname_np(pthread_self(), "Sky-Logger");
+
+            std::unique_lock lock(mutex);
+            while (true) {
+                wakeCondition.wait_for(lock, DrainPeriod, [this]() { return wake || exit || flushRequest != flushComplete; });
+                wake = false;
+                bool exiting{exit};
+                auto request{flushRequest};
+                auto drainRings{rings};
+                lock.unlock();
+
+                Drain(drainRings);
+                drainRings.clear();
+
+                lock.lock();
+                // A ring that's only referenced by us belongs to a thread which has exited, it can be dropped once it's empty
+                std::erase_if(rings, [](const std::shared_ptr<LogRing> &ring) {
+                    return ring.use_count() == 1 && !ring->Size();
+                });
+                flushComplete = request;
+                flushCondition.notify_all();
+
+                if (exiting)
+                    return;
+            }
+        }
+
+      public:
+        LogBackend() : thread(&LogBackend::Run, this) {}
+
+        ~LogBackend() {
+            {
+                std::scoped_lock lock(mutex);
+                exit = true;
+            }
+            wakeCondition.notify_all();
+            thread.join();
+        }
+
+        std::shared_ptr<LogRing> CreateRing() {
+            auto ring{std::make_shared<LogRing>()};
+            std::scoped_lock lock(mutex);
+            rings.push_back(ring);
+            return ring;
+        }
+
+        /**
+         * @brief Wakes up the background thread to drain the rings prior to the end of the period
+         */
+        void Wake() {
+            {
+                std::scoped_lock lock(mutex);
+                wake = true;
+            }
+            wakeCondition.notify_all();
+        }
+
+        /**
+         * @brief Blocks till all records submitted prior to this call have been written out
+         */
+        void Flush() {
+            std::unique_lock lock(mutex);
+            auto request{++flushRequest};
+            wakeCondition.notify_all();
+            flushCondition.wait(lock, [&]() { return flushComplete >= request; });
+        }
+    };
+
+    /**
+     * @return The log backend, this is constructed on first use so static initialization of it can't race with any logs
+     */
+    static LogBackend &GetBackend() {
+        static LogBackend backend;
+        return backend;
+    }
+
     void Logger::LoggerContext::Initialize(const std::string &path) {
+        std::lock_guard guard(mutex);
         start = util::GetTimeNs() / constant::NsInMillisecond;
         logFile.open(path, std::ios::trunc);
     }
 
+    void Logger::LoggerContext::InitializeBinary(const std::string &path, size_t ringSize) {
+        std::lock_guard guard(mutex);
+        start = util::GetTimeNs() / constant::NsInMillisecond;
+
+        // The log is a shared file mapping so the kernel writes it out even if the process is killed or crashes
+        int fd{open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)};
+        if (fd < 0)
+            throw exception("Failed to open binary log '{}': {}", path, strerror(errno));
+        binaryLogSize = sizeof(BinaryLogHeader) + ringSize;
+        if (ftruncate(fd, static_cast<off_t>(binaryLogSize)) < 0) {
+            close(fd);
+            throw exception("Failed to resize binary log to 0x{:X} bytes: {}", binaryLogSize, strerror(errno));
+        }
+        auto mapping{mmap(nullptr, binaryLogSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+        close(fd);
+        if (mapping == MAP_FAILED)
+            throw exception("Failed to map binary log: {}", strerror(errno));
+
+        binaryLog = static_cast<u8 *>(mapping);
+        new (binaryLog) BinaryLogHeader{
+            .ringSize = ringSize,
+            .writeOffset = 0,
+            .startTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
+        };
+
+        logFile.open(path + ".strings", std::ios::trunc | std::ios::binary);
+        writtenFormats.clear();
+        writtenThreads.clear();
+        binary = true;
+    }
+
     void Logger::LoggerContext::Finalize() {
+        GetBackend().Flush();
+        std::lock_guard guard(mutex);
         logFile.close();
+        if (binaryLog) {
+            munmap(binaryLog, binaryLogSize);
+            binaryLog = nullptr;
+            binary = false;
+        }
     }
 
     void Logger::LoggerContext::Flush() {
+        GetBackend().Flush();
+        std::lock_guard guard(mutex);
         logFile.flush();
     }
 
-    thread_local static std::string logTag, threadName;
+    void Logger::LoggerContext::Write(const std::string &str) {
+        std::lock_guard guard(mutex);
+        logFile << str;
+    }
+
+    void Logger::LoggerContext::WriteBinary(span<const u8> record) {
+        std::lock_guard guard(mutex);
+        if (!binaryLog)
+            return;
+
+        auto &header{*reinterpret_cast<BinaryLogHeader *>(binaryLog)};
+        auto ring{binaryLog + sizeof(BinaryLogHeader)};
+        auto offset{header.writeOffset % header.ringSize};
+        auto sizeEnd{std::min<size_t>(record.size(), header.ringSize - offset)};
+        std::memcpy(ring + offset, record.data(), sizeEnd);
+        std::memcpy(ring, record.data() + sizeEnd, record.size() - sizeEnd);
+        header.writeOffset += record.size();
+    }
+
+    static std::shared_mutex categoryMutex; //!< Synchronizes access to categoryFilters, this is only locked for logs which are more verbose than the configured level
+    static std::vector<std::pair<std::string, Logger::LogLevel>> categoryFilters; //!< The category filters set by SetCategoryFilter alongside the most verbose level they enable
+
+    bool Logger::IsCategoryEnabled(LogLevel level, const char *file) {
+        // Categories are matched against the path of the source file relative to the skyline source directory
+        std::string_view path{file};
+        constexpr std::string_view SourceDirectory{"/skyline/"};
+        auto position{path.rfind(SourceDirectory)};
+        if (position == std::string_view::npos)
+            return false;
+        path.remove_prefix(position + SourceDirectory.size());
+
+        std::shared_lock lock(categoryMutex);
+        for (const auto &[category, categoryLevel] : categoryFilters)
+            if (level <= categoryLevel && path.starts_with(category))
+                return true;
+        return false;
+    }
+
+    void Logger::SetCategoryFilter(std::string_view filter) {
+        constexpr std::array<std::string_view, 5> levelNames{"Error", "Warn", "Info", "Debug", "Verbose"}; // This corresponds to LogLevel
+
+        std::vector<std::pair<std::string, LogLevel>> filters;
+        LogLevel filtersLevel{LogLevel::Error};
+        std::vector<std::string_view> invalidEntries;
+        while (!filter.empty()) {
+            auto end{filter.find(',')};
+            auto entry{filter.substr(0, end)};
+            filter.remove_prefix(end == std::string_view::npos ? filter.size() : end + 1);
+
+            auto separator{entry.find('=')};
+            auto levelIt{separator != std::string_view::npos ? std::find(levelNames.begin(), levelNames.end(), entry.substr(separator + 1)) : levelNames.end()};
+            if (!separator || levelIt == levelNames.end()) {
+                invalidEntries.push_back(entry);
+                continue;
+            }
+
+            auto level{static_cast<LogLevel>(std::distance(levelNames.begin(), levelIt))};
+            filters.emplace_back(entry.substr(0, separator), level);
+            filtersLevel = std::max(filtersLevel, level);
+        }
+
+        {
+            std::unique_lock lock(categoryMutex);
+            categoryFilters = std::move(filters);
+            categoryLevel = filtersLevel;
+        }
+
+        // Warnings are only written after the filters are set as writing them requires reading the filters
+        for (auto entry : invalidEntries)
+            Warn("Log category filter is invalid, it should be formatted as 'category=level': '{}'", entry);
+    }
+
+    thread_local static std::string threadName;
     thread_local static Logger::LoggerContext *context{&Logger::EmulationContext};
+    thread_local static std::shared_ptr<LogRing> logRing;
+    thread_local static u32 threadId;
+    thread_local static std::vector<u8> recordBuffer;
 
     void Logger::UpdateTag() {
         std::array<char, 16> name;
@@ -28,7 +442,6 @@ namespace skyline {
             threadName = name.data();
         else
             threadName = "unk";
-        logTag = std::string("emu-cpp-") + threadName;
     }
 
     Logger::LoggerContext *Logger::GetContext() {
@@ -39,25 +452,62 @@ namespace skyline {
         context = pContext;
     }
 
-    void Logger::WriteAndroid(LogLevel level, const std::string &str) {
-        constexpr std::array<int, 5> levelAlog{ANDROID_LOG_ERROR, ANDROID_LOG_WARN, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE}; // This corresponds to LogLevel and provides its equivalent for NDK Logging
-        if (logTag.empty())
-            UpdateTag();
+    void Logger::Write(LogLevel level, const std::string &str) {
+        WriteRecord(level, 0, span(reinterpret_cast<const u8 *>(str.data()), str.size()));
+    }
 
-        __android_log_write(levelAlog[static_cast<u8>(level)], logTag.c_str(), str.c_str());
+    bool Logger::IsBinary() {
+        return context && context->binary;
     }
 
-    void Logger::Write(LogLevel level, const std::string &str) {
-        constexpr std::array<char, 5> levelCharacter{'E', 'W', 'I', 'D', 'V'}; // The LogLevel as written out to a file
-        WriteAndroid(level, str);
+    u32 Logger::GetFormatId(const char *function, const char *formatString) {
+        // Lookups are done in a thread-local cache first so the global table is only locked once per thread for every format string
+        thread_local std::map<std::pair<const char *, const char *>, u32> cachedIds;
+        std::pair key{function, formatString};
+        if (auto it{cachedIds.find(key)}; it != cachedIds.end())
+            return it->second;
 
-        if (context)
-            // We use RS (\036) and GS (\035) as our delimiters
-            context->Write(fmt::format("\036{}\035{}\035{}\035{}\n", levelCharacter[static_cast<u8>(level)], (util::GetTimeNs() / constant::NsInMillisecond) - context->start, threadName, str));
+        std::scoped_lock lock(formatMutex);
+        auto [it, inserted]{formatIds.try_emplace(key, static_cast<u32>(formatStrings.size() + 1))};
+        if (inserted)
+            formatStrings.push_back(key);
+        cachedIds.emplace(key, it->second);
+        return it->second;
     }
 
-    void Logger::LoggerContext::Write(const std::string &str) {
-        std::lock_guard guard(mutex);
-        logFile << str;
+    void Logger::WriteRecord(LogLevel level, u32 formatId, span<const u8> data) {
+        auto &backend{GetBackend()};
+        if (!logRing) [[unlikely]] {
+            logRing = backend.CreateRing();
+            threadId = static_cast<u32>(gettid());
+            if (threadName.empty())
+                UpdateTag();
+        }
+
+        LogRecordHeader header{
+            .context = context,
+            .timestamp = context ? (util::GetTimeNs() / constant::NsInMillisecond) - context->start : 0,
+            .length = static_cast<u32>(std::min(data.size(), LogRingSize - sizeof(LogRecordHeader))),
+            .formatId = formatId,
+            .threadId = threadId,
+            .level = level,
+        };
+        threadName.copy(header.threadName.data(), header.threadName.size() - 1);
+
+        // The record is written into the ring in a single write so the background thread never observes a partial record
+        recordBuffer.resize(sizeof(LogRecordHeader) + header.length);
+        std::memcpy(recordBuffer.data(), &header, sizeof(LogRecordHeader));
+        std::memcpy(recordBuffer.data() + sizeof(LogRecordHeader), data.data(), header.length);
+
+        // Logs are never dropped, if the background thread can't keep up then the writer waits on it as it would have on synchronous I/O
+        while (logRing->Free() < recordBuffer.size()) {
+            backend.Wake();
+            std::this_thread::yield();
+        }
+        logRing->Write(recordBuffer);
+
+        // Errors are written out immediately as they're likely to be followed by the process exiting, the thread is also woken early when the ring fills up to avoid waiting on it
+        if (level == LogLevel::Error || logRing->Free() < LogRingSize / 2)
+            backend.Wake();
     }
-}
\ No newline at end of file
+}
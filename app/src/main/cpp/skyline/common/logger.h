@@ -5,11 +5,18 @@
 
 #include <fstream>
 #include <mutex>
-#include "base.h"
+#include <vector>
+#include <unordered_map>
+#include "span.h"
+
+#ifndef SKYLINE_LOG_LEVEL
+#define SKYLINE_LOG_LEVEL Verbose //!< The most verbose level of logs that are compiled in, any calls to more verbose levels are removed entirely
+#endif
 
 namespace skyline {
     /**
      * @brief A wrapper around writing logs into a log file and logcat using Android Log APIs
+     * @note Logs are formatted on the calling thread and pushed into a lock-free ring for that thread, a background thread drains all rings and performs the I/O in batches
      */
     class Logger {
       private:
@@ -24,25 +31,76 @@ namespace skyline {
             Verbose,
         };
 
+        static constexpr LogLevel MaxLevel{LogLevel::SKYLINE_LOG_LEVEL}; //!< The most verbose level of logs that can be written, this is set at compile time
         static inline LogLevel configLevel{LogLevel::Verbose}; //!< The minimum level of logs to write
+        static inline LogLevel categoryLevel{LogLevel::Error}; //!< The most verbose level that any category filter enables, this allows skipping the filters for logs more verbose than it
+
+        /**
+         * @return If logs of the supplied level should be written, this is checked prior to any formatting
+         * @note The check against MaxLevel is folded at compile time for constant levels
+         */
+        static constexpr bool IsEnabled(LogLevel level) {
+            return level <= MaxLevel && level <= configLevel;
+        }
+
+        /**
+         * @return If logs of the supplied level from the supplied source file should be written, this additionally takes category filters into account
+         */
+        static bool IsEnabled(LogLevel level, const char *file) {
+            return level <= MaxLevel && (level <= configLevel || (level <= categoryLevel && IsCategoryEnabled(level, file)));
+        }
+
+        /**
+         * @return If a category filter enables logs of the supplied level from the supplied source file
+         */
+        static bool IsCategoryEnabled(LogLevel level, const char *file);
+
+        /**
+         * @brief Sets the category filters which enable logs from specific parts of the codebase at a more verbose level than the configured one
+         * @param filter A comma-separated list of "category=level" pairs, a category is a path relative to the skyline source directory such as "soc/gm20b" or "kernel/svc" and a level is the name of a LogLevel
+         */
+        static void SetCategoryFilter(std::string_view filter);
 
         /**
          * @brief Holds logger variables that cannot be static
          */
         struct LoggerContext {
-            std::mutex mutex; //!< Synchronizes all output I/O to ensure there are no races
-            std::ofstream logFile; //!< An output stream to the log file
+            std::mutex mutex; //!< Synchronizes all output I/O to ensure there are no races with the background thread
+            std::ofstream logFile; //!< An output stream to the log file, this holds the format string table for binary logs
             i64 start; //!< A timestamp in milliseconds for when the logger was started, this is used as the base for all log timestamps
+            bool binary{}; //!< If logs are written in the binary format, they aren't formatted on the device in that case and must be decoded offline
+            u8 *binaryLog{}; //!< A mapping of the binary log file, this is a header followed by a ring of records
+            size_t binaryLogSize{}; //!< The size of the binary log mapping in bytes
+            std::vector<bool> writtenFormats; //!< If the format string with an ID has been written to the string table yet
+            std::unordered_map<u32, std::string> writtenThreads; //!< The name of each thread as last written to the string table
 
             LoggerContext() {}
 
             void Initialize(const std::string &path);
 
+            /**
+             * @brief Initializes the context to write logs in the binary format, formatting is deferred to the offline decoder
+             * @param path The path of the binary log ring, the string table is written to the same path with a ".strings" suffix
+             * @param ringSize The size of the ring of records in bytes, the oldest records are overwritten once it's full
+             */
+            void InitializeBinary(const std::string &path, size_t ringSize);
+
+            /**
+             * @brief Writes out all logs submitted prior to this call and closes the log file
+             */
             void Finalize();
 
+            /**
+             * @brief Blocks till all logs submitted prior to this call have been written to the log file
+             */
             void Flush();
 
             void Write(const std::string &str);
+
+            /**
+             * @brief Writes a binary record into the ring, this must only be called by the background thread
+             */
+            void WriteBinary(span<const u8> record);
         };
         static inline LoggerContext EmulationContext, LoaderContext;
 
@@ -55,12 +113,8 @@ namespace skyline {
 
         static void SetContext(LoggerContext *context);
 
-        static void WriteAndroid(LogLevel level, const std::string &str);
-
-        static void Write(LogLevel level, const std::string &str);
-
         /**
-         * @brief A wrapper around a string which captures the calling function using Clang source location builtins
+         * @brief A wrapper around a string which captures the calling function and source file using Clang source location builtins
          * @note A function needs to be declared for every argument template specialization as CTAD cannot work with implicit casting
          * @url https://clang.llvm.org/docs/LanguageExtensions.html#source-location-builtins
          */
@@ -68,101 +122,184 @@ namespace skyline {
         struct FunctionString {
             S string;
             const char *function;
+            const char *file;
 
-            FunctionString(S string, const char *function = __builtin_FUNCTION()) : string(std::move(string)), function(function) {}
+            FunctionString(S string, const char *function = __builtin_FUNCTION(), const char *file = __builtin_FILE()) : string(std::move(string)), function(function), file(file) {}
 
             std::string operator*() {
                 return std::string(function) + ": " + std::string(string);
             }
         };
 
+        /**
+         * @brief Submits a formatted log for the current context to be written by the background thread
+         */
+        static void Write(LogLevel level, const std::string &str);
+
+        /**
+         * @brief Submits a record to the background thread
+         * @param formatId The ID of the format string for binary records with serialized arguments, 0 for records with a formatted message
+         */
+        static void WriteRecord(LogLevel level, u32 formatId, span<const u8> data);
+
+        /**
+         * @return If logs in the current context are written in the binary format
+         */
+        static bool IsBinary();
+
+        /**
+         * @return A unique ID for the supplied format string, these are written to the string table of the binary log so it can be decoded
+         */
+        static u32 GetFormatId(const char *function, const char *formatString);
+
+        /**
+         * @brief The type of a serialized argument in a binary record
+         */
+        enum class ArgumentType : u8 {
+            Signed, //!< A 64-bit signed integer
+            Unsigned, //!< A 64-bit unsigned integer
+            Float, //!< A 64-bit floating point value
+            Bool, //!< A single byte boolean
+            Char, //!< A single character
+            String, //!< A 32-bit length followed by the characters of the string, this is also used for any types without a dedicated serialization which are formatted on the device
+        };
+
+        template<typename T>
+        static void SerializeValue(std::vector<u8> &buffer, ArgumentType type, const T &value) {
+            buffer.push_back(static_cast<u8>(type));
+            auto offset{buffer.size()};
+            buffer.resize(offset + sizeof(T));
+            std::memcpy(buffer.data() + offset, &value, sizeof(T));
+        }
+
+        static void SerializeString(std::vector<u8> &buffer, std::string_view string) {
+            SerializeValue(buffer, ArgumentType::String, static_cast<u32>(string.size()));
+            buffer.insert(buffer.end(), string.begin(), string.end());
+        }
+
+        template<typename T>
+        static void SerializeArgument(std::vector<u8> &buffer, const T &argument) {
+            using Type = std::decay_t<T>;
+            if constexpr (std::is_same_v<Type, bool>)
+                SerializeValue(buffer, ArgumentType::Bool, static_cast<u8>(argument));
+            else if constexpr (std::is_same_v<Type, char>)
+                SerializeValue(buffer, ArgumentType::Char, argument);
+            else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type> && sizeof(Type) <= sizeof(i64))
+                SerializeValue(buffer, ArgumentType::Signed, static_cast<i64>(argument));
+            else if constexpr (std::is_integral_v<Type> && sizeof(Type) <= sizeof(u64))
+                SerializeValue(buffer, ArgumentType::Unsigned, static_cast<u64>(argument));
+            else if constexpr (std::is_floating_point_v<Type>)
+                SerializeValue(buffer, ArgumentType::Float, static_cast<double>(argument));
+            else if constexpr (std::is_convertible_v<const Type &, std::string_view>)
+                SerializeString(buffer, std::string_view{argument});
+            else if constexpr (std::is_pointer_v<Type>)
+                SerializeValue(buffer, ArgumentType::Unsigned, static_cast<u64>(reinterpret_cast<uintptr_t>(argument))); // Pointers are formatted as integers as they are by FmtCast
+            else
+                SerializeString(buffer, util::Format("{}", argument));
+        }
+
+        /**
+         * @brief Writes a log with a constant format string, in binary contexts the arguments are serialized rather than being formatted
+         */
+        template<typename... Args>
+        static void WriteFormat(LogLevel level, FunctionString<const char *> &formatString, Args &&... args) {
+            if (IsBinary()) {
+                thread_local std::vector<u8> arguments;
+                arguments.clear();
+                (SerializeArgument(arguments, args), ...);
+                WriteRecord(level, GetFormatId(formatString.function, formatString.string), arguments);
+            } else {
+                Write(level, util::Format(*formatString, args...));
+            }
+        }
+
         template<typename... Args>
         static void Error(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, util::Format(*formatString, args...));
+            if (IsEnabled(LogLevel::Error, formatString.file))
+                WriteFormat(LogLevel::Error, formatString, args...);
         }
 
         template<typename... Args>
         static void Error(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
+            if (IsEnabled(LogLevel::Error, formatString.file))
                 Write(LogLevel::Error, util::Format(*formatString, args...));
         }
 
         template<typename S, typename... Args>
         static void ErrorNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
+            if (IsEnabled(LogLevel::Error))
                 Write(LogLevel::Error, util::Format(formatString, args...));
         }
 
         template<typename... Args>
         static void Warn(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, util::Format(*formatString, args...));
+            if (IsEnabled(LogLevel::Warn, formatString.file))
+                WriteFormat(LogLevel::Warn, formatString, args...);
         }
 
         template<typename... Args>
         static void Warn(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
+            if (IsEnabled(LogLevel::Warn, formatString.file))
                 Write(LogLevel::Warn, util::Format(*formatString, args...));
         }
 
         template<typename S, typename... Args>
         static void WarnNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
+            if (IsEnabled(LogLevel::Warn))
                 Write(LogLevel::Warn, util::Format(formatString, args...));
         }
 
         template<typename... Args>
         static void Info(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, util::Format(*formatString, args...));
+            if (IsEnabled(LogLevel::Info, formatString.file))
+                WriteFormat(LogLevel::Info, formatString, args...);
         }
 
         template<typename... Args>
         static void Info(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
+            if (IsEnabled(LogLevel::Info, formatString.file))
                 Write(LogLevel::Info, util::Format(*formatString, args...));
         }
 
         template<typename S, typename... Args>
         static void InfoNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
+            if (IsEnabled(LogLevel::Info))
                 Write(LogLevel::Info, util::Format(formatString, args...));
         }
 
         template<typename... Args>
         static void Debug(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, util::Format(*formatString, args...));
+            if (IsEnabled(LogLevel::Debug, formatString.file))
+                WriteFormat(LogLevel::Debug, formatString, args...);
         }
 
         template<typename... Args>
         static void Debug(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
+            if (IsEnabled(LogLevel::Debug, formatString.file))
                 Write(LogLevel::Debug, util::Format(*formatString, args...));
         }
 
         template<typename S, typename... Args>
         static void DebugNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Debug <= configLevel)
+            if (IsEnabled(LogLevel::Debug))
                 Write(LogLevel::Debug, util::Format(formatString, args...));
         }
 
         template<typename... Args>
         static void Verbose(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, util::Format(*formatString, args...));
+            if (IsEnabled(LogLevel::Verbose, formatString.file))
+                WriteFormat(LogLevel::Verbose, formatString, args...);
         }
 
         template<typename... Args>
         static void Verbose(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
+            if (IsEnabled(LogLevel::Verbose, formatString.file))
                 Write(LogLevel::Verbose, util::Format(*formatString, args...));
         }
 
         template<typename S, typename... Args>
         static void VerboseNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Verbose <= configLevel)
+            if (IsEnabled(LogLevel::Verbose))
                 Write(LogLevel::Verbose, util::Format(formatString, args...));
         }
     };
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <common/base.h>
+
+namespace skyline::perf {
+    /**
+     * @brief The subsystems which memory is accounted to, these are ordered the same as the snapshot returned to Kotlin
+     */
+    enum class MemoryCategory : u8 {
+        GuestHeap, //!< Committed guest heap memory backed by KPrivateMemory
+        SharedMemory, //!< Host memory backing KSharedMemory and KTransferMemory objects
+        TextureImages, //!< Device memory allocated for images
+        StagingBuffers, //!< Host-visible memory allocated for dedicated staging buffers and the staging ring
+        PipelineCache, //!< The size of the data in the Vulkan pipeline cache as of its last save
+        ShaderCache, //!< The SPIR-V of all shaders retained by the shader cache
+        AudioBuffers, //!< The sample buffers of audio tracks
+        BlockCache, //!< The blocks retained by the VFS block cache
+        Count,
+    };
+
+    constexpr std::array<const char *, static_cast<size_t>(MemoryCategory::Count)> MemoryCategoryNames{
+        "Guest Heap Memory",
+        "Shared Memory",
+        "Texture Memory",
+        "Staging Buffer Memory",
+        "Pipeline Cache Memory",
+        "Shader Cache Memory",
+        "Audio Buffer Memory",
+        "Block Cache Memory",
+    }; //!< The names of the Perfetto counter tracks of every category, these must have a static lifetime
+
+    /**
+     * @brief The amount of memory allocated by each subsystem in bytes, this is updated by the subsystems themselves whenever they allocate or free memory
+     * @note Updates are relaxed as the counters are only used for display and eviction heuristics, a snapshot may not be consistent across categories
+     */
+    class MemoryAccounting {
+      private:
+        std::array<std::atomic<u64>, static_cast<size_t>(MemoryCategory::Count)> usage{};
+
+      public:
+        using Snapshot = std::array<u64, static_cast<size_t>(MemoryCategory::Count)>;
+
+        void Add(MemoryCategory category, u64 size) {
+            usage[static_cast<size_t>(category)].fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void Sub(MemoryCategory category, u64 size) {
+            usage[static_cast<size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Replaces the usage of a category, this is for subsystems that can only query their usage rather than tracking every allocation
+         */
+        void Set(MemoryCategory category, u64 size) {
+            usage[static_cast<size_t>(category)].store(size, std::memory_order_relaxed);
+        }
+
+        u64 Get(MemoryCategory category) const {
+            return usage[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+        }
+
+        Snapshot GetSnapshot() const {
+            Snapshot snapshot;
+            for (size_t index{}; index < snapshot.size(); index++)
+                snapshot[index] = usage[index].load(std::memory_order_relaxed);
+            return snapshot;
+        }
+    };
+
+    inline MemoryAccounting SharedMemoryAccounting{}; //!< The memory accounting of the emulator, allocations outlive emulation runs so this is never reset
+}
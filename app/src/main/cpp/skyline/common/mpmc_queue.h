@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <atomic>
+#include <common/trace.h>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A bounded lock-free queue for passing items between any amount of producer and consumer threads
+     * @note Every slot carries a sequence number which denotes if it's ready to be produced into or consumed from for a given position, this is based on Dmitry Vyukov's bounded MPMC queue
+     * @note Both sides block by waiting on the sequence of the slot they're contending for when the queue is full or empty respectively, there's no locking in the common case
+     */
+    template<typename Type>
+    class MpmcQueue {
+      private:
+        struct Slot {
+            std::atomic<size_t> sequence; //!< The position this slot is ready to be produced into if it's equal to it, or consumed from if it's a single position past it
+            Type item;
+        };
+
+        std::vector<Slot> buffer;
+        size_t mask; //!< A mask for wrapping a position into an index into the buffer, the size of the buffer is always a power of two
+        alignas(64) std::atomic<size_t> tail{}; //!< The position of the next item to be produced
+        alignas(64) std::atomic<size_t> head{}; //!< The position of the next item to be consumed
+
+      public:
+        /**
+         * @param size The capacity of the queue, this must be a power of two
+         */
+        MpmcQueue(size_t size) : buffer(size), mask(size - 1) {
+            if (!std::has_single_bit(size))
+                throw exception("The size of an MpmcQueue must be a power of two: {}", size);
+
+            for (size_t index{}; index < size; index++)
+                buffer[index].sequence.store(index, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue &) = delete;
+
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        /**
+         * @brief Moves an item into the queue, blocking while the queue is full
+         */
+        void Push(Type &&item) {
+            auto position{tail.load(std::memory_order_relaxed)};
+            while (true) {
+                auto &slot{buffer[position & mask]};
+                auto sequence{slot.sequence.load(std::memory_order_acquire)};
+                auto difference{static_cast<ssize_t>(sequence - position)};
+                if (difference == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.item = std::move(item);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        slot.sequence.notify_all();
+                        return;
+                    }
+                } else if (difference < 0) [[unlikely]] {
+                    // The slot still holds an item from the previous lap, the queue is full till it's consumed
+                    TRACE_EVENT("containers", "MpmcQueue::Push");
+                    slot.sequence.wait(sequence, std::memory_order_acquire);
+                    position = tail.load(std::memory_order_relaxed);
+                } else {
+                    position = tail.load(std::memory_order_relaxed); // Another producer has claimed this position
+                }
+            }
+        }
+
+        /**
+         * @brief Moves an item into the queue if it isn't full
+         * @return If the item was pushed into the queue, this never blocks so it can be used from signal handlers
+         */
+        bool TryPush(Type &&item) {
+            auto position{tail.load(std::memory_order_relaxed)};
+            while (true) {
+                auto &slot{buffer[position & mask]};
+                auto sequence{slot.sequence.load(std::memory_order_acquire)};
+                auto difference{static_cast<ssize_t>(sequence - position)};
+                if (difference == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.item = std::move(item);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        slot.sequence.notify_all();
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Moves the oldest item out of the queue, blocking while the queue is empty
+         */
+        Type Pop() {
+            auto position{head.load(std::memory_order_relaxed)};
+            while (true) {
+                auto &slot{buffer[position & mask]};
+                auto sequence{slot.sequence.load(std::memory_order_acquire)};
+                auto difference{static_cast<ssize_t>(sequence - (position + 1))};
+                if (difference == 0) {
+                    if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        Type item{std::move(slot.item)};
+                        slot.item = Type{}; // Release any resources held by the moved-from item
+                        slot.sequence.store(position + mask + 1, std::memory_order_release);
+                        slot.sequence.notify_all();
+                        return item;
+                    }
+                } else if (difference < 0) {
+                    // The slot hasn't been produced into yet, the queue is empty till it is
+                    TRACE_EVENT("containers", "MpmcQueue::Pop");
+                    slot.sequence.wait(sequence, std::memory_order_acquire);
+                    position = head.load(std::memory_order_relaxed);
+                } else {
+                    position = head.load(std::memory_order_relaxed); // Another consumer has claimed this position
+                }
+            }
+        }
+    };
+}
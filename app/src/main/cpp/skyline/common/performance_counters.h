@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <common/base.h>
+
+namespace skyline::perf {
+    /**
+     * @brief A block of performance counters that is shared with the Kotlin UI through a direct ByteBuffer, it's read directly by the performance overlay without any JNI calls
+     * @note The layout of this must be kept in sync with PerformanceCounters.kt, all fields are naturally aligned and in native byte order
+     * @note Fields are updated individually, a reader may observe a mix of two updates which is acceptable for display
+     */
+    struct Counters {
+        static constexpr size_t CoreCount{4}; //!< The amount of guest cores, this must match constant::CoreCount
+
+        std::atomic<u32> presentCount; //!< The amount of frames presented, this is incremented after all other per-present counters have been updated
+        std::atomic<u32> fps; //!< An approximation of the amount of frames being presented every second
+        std::atomic<float> averageFrametimeMs; //!< The average time between presented frames in milliseconds
+        std::atomic<float> averageFrametimeDeviationMs; //!< The average deviation of the frametime from its average in milliseconds
+        std::array<std::atomic<float>, CoreCount> coreUtilization; //!< The percentage of time guest threads held each guest core since the last present
+        std::atomic<float> gpuTimeMs; //!< The host GPU execution time of command buffers completed since the last present in milliseconds, this requires the GPU to support timestamp queries
+        std::atomic<u32> gpfifoDepth; //!< The amount of GP entries across all channels which are pending processing
+        std::atomic<u32> audioUnderruns; //!< The amount of underruns reported by the audio output stream
+        u32 _pad0_;
+        std::atomic<u64> textureMemory; //!< The amount of device memory allocated for images in bytes
+
+        /**
+         * @brief Resets all counters to their initial state, this is done at the start of emulation
+         */
+        void Reset() {
+            presentCount = 0;
+            fps = 0;
+            averageFrametimeMs = averageFrametimeDeviationMs = 0.0f;
+            for (auto &utilization : coreUtilization)
+                utilization = 0.0f;
+            gpuTimeMs = 0.0f;
+            gpfifoDepth = 0;
+            audioUnderruns = 0;
+        }
+    };
+    static_assert(sizeof(Counters) == 0x38 && offsetof(Counters, coreUtilization) == 0x10 && offsetof(Counters, gpfifoDepth) == 0x24 && offsetof(Counters, textureMemory) == 0x30);
+    static_assert(std::atomic<u64>::is_always_lock_free && std::atomic<float>::is_always_lock_free);
+
+    inline Counters SharedCounters{}; //!< The performance counters of the emulator, there's only a single instance which is retained across emulation runs
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <dlfcn.h>
+#include "performance_hint.h"
+
+namespace skyline::perf {
+    PerformanceHintSession::PerformanceHintSession() {
+        void *library{dlopen("libandroid.so", RTLD_LOCAL | RTLD_LAZY)};
+        if (!library)
+            return;
+
+        Functions loaded{
+            .getManager = reinterpret_cast<decltype(Functions::getManager)>(dlsym(library, "APerformanceHint_getManager")),
+            .createSession = reinterpret_cast<decltype(Functions::createSession)>(dlsym(library, "APerformanceHint_createSession")),
+            .updateTargetWorkDuration = reinterpret_cast<decltype(Functions::updateTargetWorkDuration)>(dlsym(library, "APerformanceHint_updateTargetWorkDuration")),
+            .reportActualWorkDuration = reinterpret_cast<decltype(Functions::reportActualWorkDuration)>(dlsym(library, "APerformanceHint_reportActualWorkDuration")),
+            .closeSession = reinterpret_cast<decltype(Functions::closeSession)>(dlsym(library, "APerformanceHint_closeSession")),
+            .setThreads = reinterpret_cast<decltype(Functions::setThreads)>(dlsym(library, "APerformanceHint_setThreads")),
+        };
+        if (!loaded.getManager || !loaded.createSession || !loaded.updateTargetWorkDuration || !loaded.reportActualWorkDuration || !loaded.closeSession)
+            return;
+
+        manager = loaded.getManager();
+        if (manager)
+            functions = loaded;
+        else
+            Logger::Info("ADPF isn't supported on this device");
+    }
+
+    void PerformanceHintSession::UpdateSessionLocked(i64 target) {
+        if (threadsDirty) {
+            threadsDirty = false;
+            if (session && functions->setThreads && functions->setThreads(session, threadIds.data(), threadIds.size()) == 0)
+                return;
+
+            if (session) {
+                functions->closeSession(session);
+                session = nullptr;
+            }
+            if (threadIds.empty())
+                return;
+
+            // The session may not be created if the host has no ADPF support despite exposing the API, it's retried on the next change of threads
+            session = functions->createSession(manager, threadIds.data(), threadIds.size(), target);
+            targetDuration = target;
+        }
+
+        if (session && target != targetDuration) {
+            functions->updateTargetWorkDuration(session, target);
+            targetDuration = target;
+        }
+    }
+
+    void PerformanceHintSession::AddThread(i32 tid) {
+        if (!functions)
+            return;
+
+        std::scoped_lock lock(mutex);
+        if (std::find(threadIds.begin(), threadIds.end(), tid) == threadIds.end()) {
+            threadIds.push_back(tid);
+            threadsDirty = true;
+        }
+    }
+
+    void PerformanceHintSession::RemoveThread(i32 tid) {
+        if (!functions)
+            return;
+
+        std::scoped_lock lock(mutex);
+        if (std::erase(threadIds, tid)) {
+            threadsDirty = true;
+            // A session with a thread that has exited can't be used, it's updated immediately rather than on the next frame
+            if (session)
+                UpdateSessionLocked(targetDuration);
+        }
+    }
+
+    void PerformanceHintSession::ReportFrame(i64 target, i64 actual) {
+        if (!functions || target <= 0 || actual <= 0)
+            return;
+
+        std::scoped_lock lock(mutex);
+        UpdateSessionLocked(target);
+        if (session)
+            functions->reportActualWorkDuration(session, actual);
+    }
+}
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <optional>
+#include <common.h>
+
+struct APerformanceHintManager;
+struct APerformanceHintSession;
+
+namespace skyline::perf {
+    /**
+     * @brief A wrapper around an Android Dynamic Performance Framework (ADPF) hint session, the duration of the work done for every guest frame is reported to it so the CPU governor can raise clocks before frames are missed rather than after
+     * @note APerformanceHintManager was added in API 33 which is newer than our minimum API level and NDK, the functions are loaded from libandroid at runtime and all calls are no-ops when it's unavailable
+     * @note Threads can register at any point, the session is recreated with the new set of threads if the host doesn't support APerformanceHint_setThreads (API 34)
+     */
+    class PerformanceHintSession {
+      private:
+        struct Functions {
+            APerformanceHintManager *(*getManager)();
+            APerformanceHintSession *(*createSession)(APerformanceHintManager *manager, const i32 *threadIds, size_t size, i64 initialTargetWorkDurationNanos);
+            int (*updateTargetWorkDuration)(APerformanceHintSession *session, i64 targetDurationNanos);
+            int (*reportActualWorkDuration)(APerformanceHintSession *session, i64 actualDurationNanos);
+            void (*closeSession)(APerformanceHintSession *session);
+            int (*setThreads)(APerformanceHintSession *session, const i32 *threadIds, size_t size); //!< This is optional as it was added in API 34
+        };
+
+        std::optional<Functions> functions; //!< The ADPF functions, this is empty if the host doesn't support ADPF
+        APerformanceHintManager *manager{};
+        std::mutex mutex; //!< Synchronizes all access to the session and the set of threads
+        APerformanceHintSession *session{};
+        std::vector<i32> threadIds; //!< The TIDs of all threads which are part of the session
+        bool threadsDirty{}; //!< If the set of threads has changed since the session was created or updated
+        i64 targetDuration{}; //!< The target work duration the session was last supplied with in nanoseconds
+
+        PerformanceHintSession();
+
+        /**
+         * @brief Applies any changes to the set of threads to the session, it's (re)created if required
+         */
+        void UpdateSessionLocked(i64 target);
+
+      public:
+        /**
+         * @note The session is intentionally leaked as threads may unregister during static destruction
+         */
+        static PerformanceHintSession &Get() {
+            static auto *session{new PerformanceHintSession()};
+            return *session;
+        }
+
+        /**
+         * @brief Adds a thread to the session, this should be done for all threads on the critical path of a guest frame
+         * @param tid The kernel TID of the thread as returned by gettid()
+         */
+        void AddThread(i32 tid);
+
+        /**
+         * @brief Removes a thread from the session, this must be done before the thread exits
+         */
+        void RemoveThread(i32 tid);
+
+        /**
+         * @brief Reports the duration of the work done for a single guest frame
+         * @param target The duration a frame should take to meet the frame rate of the guest in nanoseconds
+         * @param actual The duration of the work done for the frame in nanoseconds
+         */
+        void ReportFrame(i64 target, i64 actual);
+    };
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "precise_sleep.h"
+
+namespace skyline::util {
+    namespace {
+        constexpr i64 MinimumSpinNs{20'000}; //!< The minimum duration at the end of a sleep which is spun on rather than slept through
+        constexpr i64 MaximumSpinNs{100'000}; //!< The maximum duration which is spun on, this bounds the CPU time wasted on hosts with an excessive timer slack at the cost of overshooting on them
+        constexpr size_t SlackSamples{8}; //!< The amount of sleeps the timer slack is measured over
+        constexpr i64 SlackSampleNs{200'000}; //!< The duration of every sleep the timer slack is measured with
+
+        i64 GetMonotonicNs() {
+            timespec time;
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return static_cast<i64>(time.tv_sec) * constant::NsInSecond + time.tv_nsec;
+        }
+
+        /**
+         * @return A timerfd on CLOCK_MONOTONIC for the calling thread
+         */
+        int GetThreadTimer() {
+            thread_local struct ThreadTimer {
+                int fd;
+
+                ThreadTimer() : fd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) {
+                    if (fd < 0)
+                        throw exception("timerfd_create has failed with '{}'", strerror(errno));
+                }
+
+                ~ThreadTimer() {
+                    close(fd);
+                }
+            } timer;
+            return timer.fd;
+        }
+
+        /**
+         * @brief Blocks on the timerfd of the calling thread till the supplied time on CLOCK_MONOTONIC
+         * @note Signals interrupting the wait are retried as any sleeps must not end early
+         */
+        void SleepUntil(i64 deadline) {
+            int fd{GetThreadTimer()};
+            itimerspec spec{.it_value = {
+                .tv_sec = static_cast<time_t>(deadline / constant::NsInSecond),
+                .tv_nsec = static_cast<long>(deadline % constant::NsInSecond),
+            }};
+            if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr))
+                throw exception("timerfd_settime has failed with '{}'", strerror(errno));
+
+            u64 expirations;
+            while (read(fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR && GetMonotonicNs() < deadline);
+        }
+
+        /**
+         * @return The duration at the end of a sleep which should be spun on, this is the worst overshoot of the host timer over several short sleeps
+         */
+        i64 GetSpinDuration() {
+            static i64 spinDuration{[] {
+                i64 slack{};
+                for (size_t sample{}; sample < SlackSamples; sample++) {
+                    auto deadline{GetMonotonicNs() + SlackSampleNs};
+                    SleepUntil(deadline);
+                    slack = std::max(slack, GetMonotonicNs() - deadline);
+                }
+
+                auto duration{std::clamp(slack, MinimumSpinNs, MaximumSpinNs)};
+                Logger::Info("Host timer slack: {}µs, spinning for the last {}µs of sleeps", slack / 1000, duration / 1000);
+                return duration;
+            }()};
+            return spinDuration;
+        }
+    }
+
+    void PreciseSleep(std::chrono::nanoseconds duration) {
+        // Guests may sleep for durations up to INT64_MAX to block indefinitely, the deadline is saturated rather than overflowing into an invalid time
+        auto start{GetMonotonicNs()};
+        auto deadline{duration.count() > std::numeric_limits<i64>::max() - start ? std::numeric_limits<i64>::max() : start + duration.count()};
+
+        auto spinDuration{GetSpinDuration()};
+        if (duration.count() > spinDuration)
+            SleepUntil(deadline - spinDuration);
+
+        while (GetMonotonicNs() < deadline)
+            asm volatile("YIELD");
+    }
+}
@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::util {
+    /**
+     * @brief Sleeps for the supplied duration with a far lower overshoot than nanosleep
+     * @note The bulk of the sleep is an absolute timerfd wait which ends early by the timer slack of the host, the remainder is spun on with the 'yield' hint as host sleeps regularly overshoot by 50µs to several ms which breaks frame pacing in titles that sleep in a loop to wait for vsync
+     * @note The timer slack is measured once on the first call, the timerfd is per-thread and created on first use by a thread
+     */
+    void PreciseSleep(std::chrono::nanoseconds duration);
+}
@@ -17,10 +17,31 @@ namespace skyline {
 
         std::tuple preferences{
             PREF_ELEM("log_level", logLevel, static_cast<Logger::LogLevel>(element.text().as_uint(static_cast<unsigned int>(Logger::LogLevel::Info)))),
+            PREF_ELEM("log_filter", logFilter, element.text().as_string()),
+            PREF_ELEM("log_binary", logBinary, element.attribute("value").as_bool()),
             PREF_ELEM("username_value", username, element.text().as_string()),
             PREF_ELEM("operation_mode", operationMode, element.attribute("value").as_bool()),
+            PREF_ELEM("host_core_affinity", hostCoreAffinity, element.attribute("value").as_bool()),
+            PREF_ELEM("verify_integrity", verifyIntegrity, element.attribute("value").as_bool()),
+            PREF_ELEM("block_cache_size", blockCacheSize, element.attribute("value").as_uint(64)),
+            PREF_ELEM("texture_cache_size", textureCacheSize, element.attribute("value").as_uint(512)),
+            PREF_ELEM("pin_cache_size", pinCacheSize, element.attribute("value").as_uint(256)),
             PREF_ELEM("force_triple_buffering", forceTripleBuffering, element.attribute("value").as_bool()),
             PREF_ELEM("disable_frame_throttling", disableFrameThrottling, element.attribute("value").as_bool()),
+            PREF_ELEM("frame_pacing", framePacing, element.attribute("value").as_bool()),
+            PREF_ELEM("frame_skip", frameSkip, element.attribute("value").as_bool()),
+            PREF_ELEM("frame_skip_rendering", frameSkipRendering, element.attribute("value").as_bool()),
+            PREF_ELEM("enable_macro_jit", enableMacroJit, element.attribute("value").as_bool()),
+            PREF_ELEM("skip_uncompiled_draws", skipUncompiledDraws, element.attribute("value").as_bool()),
+            PREF_ELEM("parallel_recording", parallelRecording, element.attribute("value").as_bool()),
+            PREF_ELEM("perf_stats", perfStats, element.attribute("value").as_bool()),
+            PREF_ELEM("method_statistics", methodStatistics, element.attribute("value").as_bool()),
+            PREF_ELEM("gpfifo_capture", gpfifoCapture, element.attribute("value").as_bool()),
+            PREF_ELEM("host_libc_functions", hostLibcFunctions, element.attribute("value").as_bool()),
+            PREF_ELEM("guest_profiler", guestProfiler, element.attribute("value").as_bool()),
+            PREF_ELEM("resolution_scale", resolutionScale, element.attribute("value").as_uint(100)),
+            PREF_ELEM("texture_deduplication", textureDeduplication, element.attribute("value").as_bool()),
+            PREF_ELEM("thermal_policy", thermalPolicy, element.attribute("value").as_bool()),
         };
 
         #undef PREF_ELEM
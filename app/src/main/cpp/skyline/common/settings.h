@@ -12,10 +12,35 @@ namespace skyline {
     class Settings {
       public:
         Logger::LogLevel logLevel; //!< The minimum level that logs need to be for them to be printed
+        std::string logFilter; //!< The category filters which enable more verbose logging for specific parts of the codebase, see Logger::SetCategoryFilter
+        bool logBinary; //!< If emulation logs should be written in the binary format which defers formatting to an offline decoder
         std::string username; //!< The name set by the user to be supplied to the guest
         bool operationMode; //!< If the emulated Switch should be handheld or docked
+        bool hostCoreAffinity; //!< If guest threads should be pinned to host CPU clusters according to the guest core they're resident on
+        bool verifyIntegrity; //!< If the hashes of ROM contents should be verified as they're read to detect corrupted dumps
+        u32 blockCacheSize; //!< The amount of memory in MiB that decrypted ROM data may be cached in, 0 disables the cache
+        u32 textureCacheSize; //!< The amount of disk space in MiB that decoded textures may be cached in, 0 doesn't limit the size of the cache
+        u32 pinCacheSize; //!< The amount of memory in MiB that unpinned nvmap handles may stay mapped into the SMMU for, 0 only unmaps them when the SMMU runs out of space
         bool forceTripleBuffering; //!< If the presentation engine should always triple buffer even if the swapchain supports double buffering
         bool disableFrameThrottling; //!< Allow the guest to submit frames without any blocking calls
+        bool framePacing; //!< If frames should be presented with mailbox presentation right before the display refresh they target, this minimizes latency without tearing
+        bool frameSkip; //!< If every other frame should be dropped rather than presented while the host GPU can't keep up with the frame rate of the guest
+        bool frameSkipRendering; //!< If rendering into presentable textures should also be skipped for frames which are dropped by frame skipping
+        bool enableMacroJit; //!< If GPU macros should be compiled to native code rather than being interpreted
+        bool skipUncompiledDraws; //!< If draws should be skipped while their pipeline is being compiled rather than waiting on it
+        bool parallelRecording; //!< If large render passes should be recorded into secondary command buffers on worker threads
+        bool perfStats; //!< If the performance overlay is shown, this enables measuring the GPU execution time of command buffers
+        bool methodStatistics; //!< If statistics should be collected for all GPU methods, these are emitted to Perfetto every frame and logged on exit
+        bool gpfifoCapture; //!< If the command stream of every GPU channel should be captured into a file in the app's files directory
+        bool hostLibcFunctions; //!< If well-known libc functions in guest executables should be redirected to their host implementations
+        bool guestProfiler; //!< If guest threads should be sampled by a profiler which writes their call stacks into a file in the app's files directory on exit
+        u32 resolutionScale; //!< The percentage of the guest resolution that render targets are rendered at on the host
+        bool textureDeduplication; //!< If textures with identical guest contents should be copied from each other on the host GPU rather than being uploaded individually
+        bool thermalPolicy; //!< If the resolution scale, frame skipping and pipeline compilation should be restricted in steps as the host heats up
+
+        // These aren't preferences, they're supplied by the intent that launched emulation for automated benchmark runs
+        u32 automationFrames{}; //!< The amount of frames that an automated run presents before writing its report and stopping emulation, 0 disables automation
+        std::string automationInput; //!< The path of an input replay file that is played back during an automated run, this is optional
 
         /**
          * @param fd An FD to the preference XML file
@@ -126,6 +126,12 @@ namespace skyline::signal {
         TlsRestorer = function;
     }
 
+    static bool (*AccessViolationHandler)(void *){};
+
+    void SetAccessViolationHandler(bool (*function)(void *fault)) {
+        AccessViolationHandler = function;
+    }
+
     struct DefaultSignalHandler {
         void (*function)(int, struct siginfo *, void *){};
 
@@ -158,7 +164,9 @@ namespace skyline::signal {
             tls = TlsRestorer();
 
         auto handler{ThreadSignalHandlers.at(static_cast<size_t>(signal))};
-        if (handler) {
+        if (signal == SIGSEGV && AccessViolationHandler && AccessViolationHandler(info->si_addr)) {
+            // The fault was resolved, returning from the handler will retry the faulting access
+        } else if (handler) {
             handler(signal, info, context, &tls);
         } else {
             auto defaultHandler{DefaultSignalHandlers.at(static_cast<size_t>(signal)).function};
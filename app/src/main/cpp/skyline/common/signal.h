@@ -75,6 +75,12 @@ namespace skyline::signal {
      */
     void SetTlsRestorer(void *(*function)());
 
+    /**
+     * @brief Sets a handler which is called for any SIGSEGV on any thread prior to the thread's own signal handler, this is used for resolving faults on intentionally protected memory
+     * @param function A function which returns true if it has resolved the fault and the faulting access should be retried, it must be safe to call from a signal handler
+     */
+    void SetAccessViolationHandler(bool (*function)(void *fault));
+
     using SignalHandler = void (*)(int, struct siginfo *, ucontext *, void **);
 
     /**
@@ -100,4 +106,11 @@ namespace skyline::signal {
             sigaddset(&set, signal);
         Sigprocmask(SIG_BLOCK, set, nullptr);
     }
+
+    inline void UnblockSignal(std::initializer_list<int> signals) {
+        sigset_t set{};
+        for (int signal : signals)
+            sigaddset(&set, signal);
+        Sigprocmask(SIG_UNBLOCK, set, nullptr);
+    }
 }
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <atomic>
+#include <common/trace.h>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A bounded lock-free queue for passing items from a single producer thread to a single consumer thread
+     * @note Both sides block by waiting on the opposing index when the queue is full or empty respectively, there's no locking in the common case
+     * @note The head and tail are on separate cache lines so the producer and consumer don't contend on the same line
+     */
+    template<typename Type>
+    class SpscQueue {
+      private:
+        std::vector<Type> buffer; //!< The ring of items, this is a single item larger than the capacity to distinguish between a full and an empty queue
+        alignas(64) std::atomic<size_t> head{}; //!< The index of the next item to be consumed, this is only written to by the consumer
+        alignas(64) std::atomic<size_t> tail{}; //!< The index of the next item to be produced, this is only written to by the producer
+
+        /**
+         * @brief Blocks till the consumer has moved its head past the supplied index which the producer wants to advance its tail to
+         */
+        void WaitForSpace(size_t nextTail) {
+            size_t currentHead;
+            while ((currentHead = head.load(std::memory_order_acquire)) == nextTail) [[unlikely]] {
+                TRACE_EVENT("containers", "SpscQueue::WaitForSpace");
+                head.wait(currentHead, std::memory_order_acquire);
+            }
+        }
+
+        /**
+         * @brief Blocks till the producer has produced items past the supplied head
+         * @return The tail of the queue, all items between the head and it are available for consumption
+         */
+        size_t WaitForItems(size_t currentHead) {
+            size_t currentTail;
+            while ((currentTail = tail.load(std::memory_order_acquire)) == currentHead) {
+                TRACE_EVENT("containers", "SpscQueue::WaitForItems");
+                tail.wait(currentTail, std::memory_order_acquire);
+            }
+            return currentTail;
+        }
+
+        /**
+         * @brief Copies the items into the ring starting at the supplied index, this is split into at most two contiguous copies around the end of the ring
+         */
+        void CopyIn(size_t index, span<const Type> items) {
+            auto countEnd{std::min(items.size(), buffer.size() - index)};
+            if constexpr (std::is_trivially_copyable_v<Type>) {
+                std::memcpy(buffer.data() + index, items.data(), countEnd * sizeof(Type));
+                std::memcpy(buffer.data(), items.data() + countEnd, (items.size() - countEnd) * sizeof(Type));
+            } else {
+                std::copy_n(items.begin(), countEnd, buffer.begin() + index);
+                std::copy(items.begin() + countEnd, items.end(), buffer.begin());
+            }
+        }
+
+      public:
+        SpscQueue(size_t size) : buffer(size + 1) {}
+
+        SpscQueue(const SpscQueue &) = delete;
+
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        /**
+         * @brief Moves an item into the queue, blocking while the queue is full
+         */
+        void Push(Type &&item) {
+            auto currentTail{tail.load(std::memory_order_relaxed)};
+            auto nextTail{(currentTail + 1) % buffer.size()};
+            WaitForSpace(nextTail);
+
+            buffer[currentTail] = std::move(item);
+            tail.store(nextTail, std::memory_order_release);
+            tail.notify_one();
+        }
+
+        void Push(const Type &item) {
+            Push(Type{item});
+        }
+
+        /**
+         * @brief Copies all items from the buffer into the queue, blocking while the queue is full
+         * @param published A function that is called after every run of items that fit into the queue at a time has been published, prior to waiting for more space
+         * @note The consumer is only notified once for all items that fit into the queue at a time rather than for every item
+         * @note This never blocks if there's enough space for all items, they're then copied and published in a single step
+         */
+        template<typename PublishedFunction>
+        void Append(span<const Type> items, PublishedFunction published) {
+            while (!items.empty()) {
+                auto currentTail{tail.load(std::memory_order_relaxed)};
+                WaitForSpace((currentTail + 1) % buffer.size());
+
+                auto freeSpace{(head.load(std::memory_order_acquire) + buffer.size() - currentTail - 1) % buffer.size()};
+                auto count{std::min(items.size(), freeSpace)};
+                CopyIn(currentTail, items.first(count));
+
+                tail.store((currentTail + count) % buffer.size(), std::memory_order_release);
+                tail.notify_one();
+                published();
+                items = items.subspan(count);
+            }
+        }
+
+        void Append(span<const Type> items) {
+            Append(items, [] {});
+        }
+
+        /**
+         * @brief Moves the oldest item out of the queue, blocking while the queue is empty
+         */
+        Type Pop() {
+            auto currentHead{head.load(std::memory_order_relaxed)};
+            WaitForItems(currentHead);
+
+            Type item{std::move(buffer[currentHead])};
+            buffer[currentHead] = Type{}; // Release any resources held by the moved-from item
+            head.store((currentHead + 1) % buffer.size(), std::memory_order_release);
+            head.notify_one();
+            return item;
+        }
+
+        /**
+         * @brief A blocking for-each that runs on every item and waits for new items to run on them as well
+         * @param function A function that is called for each item with a reference to it
+         * @param drained A function that is called after every batch of items that were available at a time, prior to waiting on more items
+         * @note The producer is only notified once after every batch of items that were available at a time
+         */
+        template<typename Function, typename DrainedFunction>
+        [[noreturn]] void Process(Function function, DrainedFunction drained) {
+            while (true) {
+                auto currentHead{head.load(std::memory_order_relaxed)};
+                auto currentTail{WaitForItems(currentHead)};
+
+                while (currentHead != currentTail) {
+                    function(buffer[currentHead]);
+                    if constexpr (!std::is_trivially_destructible_v<Type>)
+                        buffer[currentHead] = Type{};
+
+                    currentHead = (currentHead + 1) % buffer.size();
+                    head.store(currentHead, std::memory_order_release);
+                }
+                head.notify_one();
+                drained();
+            }
+        }
+
+        template<typename Function>
+        [[noreturn]] void Process(Function function) {
+            Process(std::move(function), [] {});
+        }
+
+        /**
+         * @brief A non-blocking for-each that runs on every item that's available at the time of the call and returns once they've been consumed
+         * @note The producer is only notified once after all items have been consumed
+         */
+        template<typename Function>
+        void ProcessAvailable(Function function) {
+            auto currentHead{head.load(std::memory_order_relaxed)};
+            auto currentTail{tail.load(std::memory_order_acquire)};
+            if (currentHead == currentTail)
+                return;
+
+            while (currentHead != currentTail) {
+                function(buffer[currentHead]);
+                if constexpr (!std::is_trivially_destructible_v<Type>)
+                    buffer[currentHead] = Type{};
+
+                currentHead = (currentHead + 1) % buffer.size();
+                head.store(currentHead, std::memory_order_release);
+            }
+            head.notify_one();
+        }
+
+        /**
+         * @return If there are no items in the queue, this should only be called by the consumer
+         */
+        bool Empty() {
+            return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+        }
+    };
+}
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <atomic>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A fixed-size lock-free ring buffer of trivially copyable elements for streaming data from a single producer thread to a single consumer thread
+     * @tparam Capacity The capacity of the ring buffer in elements, this must be a power of two so the free-running indices can be wrapped with a mask
+     * @note Neither side ever blocks, writing into a full buffer drops the elements that don't fit which makes it suitable for real-time consumers
+     */
+    template<typename Type, size_t Capacity>
+    class SpscRingBuffer {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "The size of the ring buffer must be a power of two");
+
+      private:
+        std::array<Type, Capacity> array{};
+        alignas(64) std::atomic<size_t> head{}; //!< The free-running index of the oldest element, this is only written to by the consumer
+        alignas(64) std::atomic<size_t> tail{}; //!< The free-running index after the newest element, this is only written to by the producer
+
+      public:
+        /**
+         * @brief Copies as many elements from the supplied buffer into the ring buffer as there's space for
+         * @return The amount of elements that were written
+         * @note This must only be called from the producer thread
+         */
+        size_t Write(span<const Type> buffer) {
+            auto currentTail{tail.load(std::memory_order_relaxed)};
+            auto size{std::min(buffer.size(), Capacity - (currentTail - head.load(std::memory_order_acquire)))};
+
+            auto offset{currentTail & (Capacity - 1)};
+            auto sizeEnd{std::min(size, Capacity - offset)};
+            std::memcpy(array.data() + offset, buffer.data(), sizeEnd * sizeof(Type));
+            std::memcpy(array.data(), buffer.data() + sizeEnd, (size - sizeEnd) * sizeof(Type));
+
+            tail.store(currentTail + size, std::memory_order_release);
+            return size;
+        }
+
+        /**
+         * @return The amount of elements that can be written without any being dropped
+         * @note This must only be called from the producer thread, more space may have been freed by the time it returns
+         */
+        size_t Free() const {
+            return Capacity - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+        }
+
+        /**
+         * @return The longest contiguous span of elements starting at the oldest element, this is empty if there are no elements
+         * @note This must only be called from the consumer thread, the elements stay valid till they're consumed
+         */
+        span<const Type> Peek() {
+            auto currentHead{head.load(std::memory_order_relaxed)};
+            auto offset{currentHead & (Capacity - 1)};
+            auto size{std::min(tail.load(std::memory_order_acquire) - currentHead, Capacity - offset)};
+            return span<const Type>(array.data() + offset, size);
+        }
+
+        /**
+         * @return The amount of elements in the buffer
+         * @note This must only be called from the consumer thread, more elements may have been written by the time it returns
+         */
+        size_t Size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Releases the supplied amount of the oldest elements back to the producer
+         * @note This must only be called from the consumer thread with a count no larger than the amount of elements that were peeked
+         */
+        void Consume(size_t count) {
+            head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+    };
+}
@@ -4,13 +4,31 @@
 #pragma once
 
 #include <pthread.h>
+#include <array>
+#include <atomic>
 
 namespace skyline {
+    namespace detail {
+        /**
+         * @brief A cached pointer to the instance of a ThreadLocal for the current thread
+         */
+        struct ThreadLocalSlot {
+            void *pointer;
+            u64 generation; //!< The generation of the ThreadLocal which the pointer belongs to, this is zero for an empty slot
+        };
+
+        constexpr size_t ThreadLocalSlotCount{32}; //!< The amount of slots in the per-thread cache, ThreadLocals with colliding slots still work but evict each other's cached pointers
+
+        inline thread_local std::array<ThreadLocalSlot, ThreadLocalSlotCount> ThreadLocalSlots{}; //!< A static TLS cache of the instances of ThreadLocals, this is indexed by the generation of a ThreadLocal
+        inline std::atomic<u64> ThreadLocalGeneration{1}; //!< The generation of the next ThreadLocal, generations are never reused so a stale slot can't be mistaken for that of a newer ThreadLocal
+    }
+
     /**
      * @brief A thread-local RAII-bound wrapper class which unlike `thread_local` doesn't require the member to be static
      * @note Caller must ensure any arguments passed into the constructor remain valid throughout its lifetime
      * @note Caller must ensure the destructors of the object doesn't have any thread-local dependencies as they might be called from another thread
      * @note RAII-bound means that *all* thread-local instances of the object will be destroyed after this class is destroyed but can also be destroyed when a thread owning an instance dies
+     * @note Accesses are a lookup into a static TLS slot array while the pthread key is only used to look up instances on a cache miss and to destroy them when a thread dies, pthread_getspecific is far slower than static TLS
      */
     template<typename Type, bool TrivialDestructor = std::is_trivially_destructible_v<Type>>
     class ThreadLocal;
@@ -20,6 +38,19 @@ namespace skyline {
       private:
         pthread_key_t key;
         std::function<Type *()> constructor;
+        u64 generation{detail::ThreadLocalGeneration.fetch_add(1, std::memory_order_relaxed)};
+
+        Type *GetSlow(detail::ThreadLocalSlot &slot) {
+            auto pointer{static_cast<Type *>(pthread_getspecific(key))};
+            if (!pointer) {
+                pointer = constructor();
+                if (int result = pthread_setspecific(key, pointer))
+                    throw exception("Cannot set pthread_key to constructed type: {}", strerror(result));
+            }
+
+            slot = {pointer, generation};
+            return pointer;
+        }
 
       public:
         template<typename... Args>
@@ -29,15 +60,10 @@ namespace skyline {
         }
 
         Type *operator->() {
-            auto pointer{pthread_getspecific(key)};
-            if (pointer)
-                return static_cast<Type *>(pointer);
-
-            Type *object{constructor(*this)};
-            if (int result = pthread_setspecific(key, object))
-                throw exception("Cannot set pthread_key to constructed type: {}", strerror(result));
-
-            return object;
+            auto &slot{detail::ThreadLocalSlots[generation % detail::ThreadLocalSlotCount]};
+            if (slot.generation == generation) [[likely]]
+                return static_cast<Type *>(slot.pointer);
+            return GetSlow(slot);
         }
 
         Type &operator*() {
@@ -61,6 +87,11 @@ namespace skyline {
             IntrustiveTypeNode(ThreadLocal &threadLocal, Args &&... args) : object(std::forward<Args>(args)...), threadLocal(threadLocal) {}
 
             ~IntrustiveTypeNode() {
+                // The cached pointer must be invalidated as this may be destroyed by the pthread key destructor prior to the thread's last access
+                auto &slot{detail::ThreadLocalSlots[threadLocal.generation % detail::ThreadLocalSlotCount]};
+                if (slot.generation == threadLocal.generation && slot.pointer == &object)
+                    slot = {};
+
                 auto current{threadLocal.list.load(std::memory_order_acquire)};
                 while (current == this)
                     if (threadLocal.list.compare_exchange_strong(current, next, std::memory_order_release, std::memory_order_consume))
@@ -79,6 +110,24 @@ namespace skyline {
         pthread_key_t key;
         std::function<IntrustiveTypeNode *(ThreadLocal &)> constructor;
         std::atomic<IntrustiveTypeNode *> list{}; //!< An atomic instrusive linked list of all instances of the object to call non-trivial destructors for the objects
+        u64 generation{detail::ThreadLocalGeneration.fetch_add(1, std::memory_order_relaxed)};
+
+        Type *GetSlow(detail::ThreadLocalSlot &slot) {
+            auto node{static_cast<IntrustiveTypeNode *>(pthread_getspecific(key))};
+            if (!node) {
+                node = constructor(*this);
+                if (int result = pthread_setspecific(key, node))
+                    throw exception("Cannot set pthread_key to constructed type: {}", strerror(result));
+
+                auto next{list.load(std::memory_order_acquire)};
+                do {
+                    node->next = next;
+                } while (!list.compare_exchange_strong(next, node, std::memory_order_release, std::memory_order_consume));
+            }
+
+            slot = {&node->object, generation};
+            return &node->object;
+        }
 
       public:
         template<typename... Args>
@@ -92,20 +141,10 @@ namespace skyline {
         }
 
         Type *operator->() {
-            auto pointer{pthread_getspecific(key)};
-            if (pointer)
-                return &static_cast<IntrustiveTypeNode *>(pointer)->object;
-
-            IntrustiveTypeNode *node{constructor(*this)};
-            if (int result = pthread_setspecific(key, node))
-                throw exception("Cannot set pthread_key to constructed type: {}", strerror(result));
-
-            auto next{list.load(std::memory_order_acquire)};
-            do {
-                node->next = next;
-            } while (!list.compare_exchange_strong(next, node, std::memory_order_release, std::memory_order_consume));
-
-            return &node->object;
+            auto &slot{detail::ThreadLocalSlots[generation % detail::ThreadLocalSlotCount]};
+            if (slot.generation == generation) [[likely]]
+                return static_cast<Type *>(slot.pointer);
+            return GetSlow(slot);
         }
 
         Type &operator*() {
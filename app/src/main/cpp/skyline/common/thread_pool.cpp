@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "thread_pool.h"
+
+namespace skyline {
+    ThreadPool::ThreadPool(size_t workerCount) {
+        threads.reserve(workerCount);
+        for (size_t index{}; index < workerCount; index++)
+            threads.emplace_back(&ThreadPool::WorkerThread, this, index);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::scoped_lock lock(mutex);
+            exit = true;
+        }
+        workCondition.notify_all();
+
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    void ThreadPool::WorkerThread(size_t index) {
+        pthread_setname_np(pthread_self(), fmt::format("Sky-Worker{}", index).c_str());
+
+        size_t seenGeneration{};
+        std::unique_lock lock(mutex);
+        while (true) {
+            workCondition.wait(lock, [&]() { return exit || generation != seenGeneration; });
+            if (exit)
+                return;
+
+            seenGeneration = generation;
+            if (!function)
+                continue; // The job has already been completed by the other threads before we woke up
+
+            // The job is registered with the worker count while the mutex is held, this ensures the caller can't return and invalidate it while we're processing it
+            auto &jobFunction{*function};
+            auto jobCount{count};
+            activeWorkers++;
+
+            lock.unlock();
+            RunJob(jobFunction, jobCount);
+            lock.lock();
+
+            if (--activeWorkers == 0)
+                doneCondition.notify_all();
+        }
+    }
+
+    void ThreadPool::RunJob(const std::function<void(size_t)> &jobFunction, size_t jobCount) {
+        size_t index;
+        while ((index = next.fetch_add(1, std::memory_order_relaxed)) < jobCount)
+            jobFunction(index);
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &pFunction) {
+        std::unique_lock jobLock(jobMutex);
+        ExecuteJob(count, pFunction);
+    }
+
+    bool ThreadPool::TryParallelFor(size_t count, const std::function<void(size_t)> &pFunction) {
+        std::unique_lock jobLock(jobMutex, std::try_to_lock);
+        if (!jobLock)
+            return false;
+
+        ExecuteJob(count, pFunction);
+        return true;
+    }
+
+    void ThreadPool::ExecuteJob(size_t count, const std::function<void(size_t)> &pFunction) {
+        {
+            std::scoped_lock lock(mutex);
+            function = &pFunction;
+            this->count = count;
+            next.store(0, std::memory_order_relaxed);
+            generation++;
+        }
+        workCondition.notify_all();
+
+        RunJob(pFunction, count);
+
+        // All work items have been claimed at this point, we only need to wait for any workers still executing theirs
+        std::unique_lock lock(mutex);
+        doneCondition.wait(lock, [&]() { return activeWorkers == 0; });
+        function = nullptr;
+    }
+}
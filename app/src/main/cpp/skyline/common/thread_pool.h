@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <thread>
+#include <condition_variable>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A small pool of worker threads which splits a range of independent work items across the workers and the calling thread
+     * @note Only a single job can be executed at a time, concurrent callers of ParallelFor are serialized
+     */
+    class ThreadPool {
+      private:
+        std::vector<std::thread> threads;
+        std::mutex jobMutex; //!< Serializes callers of ParallelFor so only a single job is executed at a time
+        std::mutex mutex; //!< Synchronizes all members below
+        std::condition_variable workCondition; //!< Signalled when a new job has been posted or the pool is being destroyed
+        std::condition_variable doneCondition; //!< Signalled when a worker has stopped processing a job
+        const std::function<void(size_t)> *function{}; //!< The function of the current job, this is only valid while a job is active
+        size_t count{}; //!< The amount of work items in the current job
+        std::atomic<size_t> next{}; //!< The index of the next work item of the current job which hasn't been claimed yet
+        size_t generation{}; //!< A counter which is incremented for every posted job, workers use this to detect new jobs
+        size_t activeWorkers{}; //!< The amount of workers that are currently processing work items of the current job
+        bool exit{}; //!< If the workers should exit
+
+        void WorkerThread(size_t index);
+
+        /**
+         * @brief Claims and executes work items of the current job until there are none left
+         */
+        void RunJob(const std::function<void(size_t)> &jobFunction, size_t jobCount);
+
+        /**
+         * @brief Posts a job to the workers and participates in it till all work items have been executed
+         * @note The job mutex must be held by the caller
+         */
+        void ExecuteJob(size_t count, const std::function<void(size_t)> &function);
+
+      public:
+        /**
+         * @param workerCount The amount of worker threads to create, the calling thread of ParallelFor is used in addition to these
+         */
+        ThreadPool(size_t workerCount);
+
+        ~ThreadPool();
+
+        /**
+         * @brief Calls the supplied function with every index in [0, count) across the workers and the calling thread, this blocks till all work items have been executed
+         * @note The function must not throw as it may be executing on a worker thread
+         */
+        void ParallelFor(size_t count, const std::function<void(size_t)> &function);
+
+        /**
+         * @brief Identical to ParallelFor but returns immediately rather than waiting if another job is already being executed
+         * @return If the job was executed, the caller should execute the work items itself otherwise
+         */
+        bool TryParallelFor(size_t count, const std::function<void(size_t)> &function);
+    };
+}
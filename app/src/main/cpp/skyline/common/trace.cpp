@@ -1,3 +1,174 @@
+#include <bit>
+#include <cmath>
+#include <unordered_map>
 #include "trace.h"
 
 PERFETTO_TRACK_EVENT_STATIC_STORAGE(); //!< Expands into a structure with static storage for all track events
+
+namespace skyline::trace {
+    static std::array<std::atomic<i64>, BootPhaseCount> bootPhaseTimes{}; //!< The accumulated time in nanoseconds of every boot phase
+    static std::atomic<i64> bootStart{}; //!< The timestamp at which the boot started, this is 0 prior to a boot being started
+    static std::atomic<i64> firstGpuSubmission{}; //!< The offset of the first GPU submission from the start of the boot
+    static std::atomic<bool> firstFramePresented{};
+
+    void BootProfile::Start() {
+        for (auto &time : bootPhaseTimes)
+            time.store(0, std::memory_order_relaxed);
+        firstGpuSubmission.store(0, std::memory_order_relaxed);
+        firstFramePresented.store(false, std::memory_order_relaxed);
+        bootStart.store(util::GetTimeNs(), std::memory_order_release);
+    }
+
+    i64 BootProfile::GetStart() {
+        return bootStart.load(std::memory_order_acquire);
+    }
+
+    void BootProfile::AddPhaseTime(BootPhase phase, i64 durationNs) {
+        bootPhaseTimes[static_cast<size_t>(phase)].fetch_add(durationNs, std::memory_order_relaxed);
+    }
+
+    void BootProfile::MarkFirstGpuSubmission() {
+        auto start{bootStart.load(std::memory_order_acquire)};
+        if (!start || firstGpuSubmission.load(std::memory_order_relaxed))
+            return;
+
+        i64 expected{};
+        if (firstGpuSubmission.compare_exchange_strong(expected, util::GetTimeNs() - start, std::memory_order_relaxed))
+            TRACE_EVENT_INSTANT("boot", "FirstGpuSubmission");
+    }
+
+    void BootProfile::MarkFirstFramePresented() {
+        auto start{bootStart.load(std::memory_order_acquire)};
+        if (!start || firstFramePresented.exchange(true, std::memory_order_relaxed))
+            return;
+
+        i64 firstFrame{util::GetTimeNs() - start};
+        TRACE_EVENT_INSTANT("boot", "FirstFramePresented");
+
+        auto phaseTime{[](BootPhase phase) { return bootPhaseTimes[static_cast<size_t>(phase)].load(std::memory_order_relaxed); }};
+        // This is a single line of JSON so it can be extracted from logs by tooling to track boot times across builds
+        Logger::Info("Boot profile: {{\"first_frame_ns\":{},\"first_gpu_submission_ns\":{},\"key_loading_ns\":{},\"partition_parsing_ns\":{},\"nca_header_decryption_ns\":{},\"romfs_index_ns\":{},\"nso_decompression_ns\":{},\"nce_patching_ns\":{},\"service_init_ns\":{}}}",
+                     firstFrame, firstGpuSubmission.load(std::memory_order_relaxed),
+                     phaseTime(BootPhase::KeyLoading), phaseTime(BootPhase::PartitionParsing), phaseTime(BootPhase::NcaHeaderDecryption), phaseTime(BootPhase::RomFsIndex),
+                     phaseTime(BootPhase::NsoDecompression), phaseTime(BootPhase::NcePatching), phaseTime(BootPhase::ServiceInit));
+    }
+
+    /**
+     * @brief The counters of a single call on a single thread, these are only written by the owning thread
+     */
+    struct LatencyCounters {
+        std::atomic<u64> count;
+        std::atomic<i64> totalNs;
+        std::atomic<i64> maxNs;
+        std::array<std::atomic<u64>, LatencyHistograms::BucketCount> buckets;
+    };
+
+    constexpr size_t LatencyChunkSize{0x20}; //!< The amount of calls in a chunk of counters, chunks are allocated lazily so threads only pay for the calls they make
+    constexpr size_t LatencyChunkCount{0x80}; //!< The maximum amount of chunks, calls with IDs beyond this aren't recorded
+
+    /**
+     * @brief The counters of all calls made by a single thread
+     */
+    struct ThreadLatencies {
+        std::array<std::atomic<std::array<LatencyCounters, LatencyChunkSize> *>, LatencyChunkCount> chunks{};
+
+        ~ThreadLatencies() {
+            for (auto &chunk : chunks)
+                delete chunk.load(std::memory_order_relaxed);
+        }
+    };
+
+    static std::mutex latencyMutex; //!< Synchronizes access to latencyNames, latencyIds and latencyThreads
+    static std::vector<const char *> latencyNames; //!< The name of every call, the ID of a call is its index
+    static std::unordered_map<const char *, u32> latencyIds;
+    static std::vector<std::shared_ptr<ThreadLatencies>> latencyThreads; //!< The counters of every thread that has recorded a call, these are retained after a thread exits so its calls remain in the totals
+
+    u32 LatencyHistograms::GetId(const char *name) {
+        thread_local std::unordered_map<const char *, u32> cachedIds;
+        if (auto it{cachedIds.find(name)}; it != cachedIds.end()) [[likely]]
+            return it->second;
+
+        std::scoped_lock lock(latencyMutex);
+        auto [it, inserted]{latencyIds.try_emplace(name, static_cast<u32>(latencyNames.size()))};
+        if (inserted)
+            latencyNames.push_back(name);
+        cachedIds.emplace(name, it->second);
+        return it->second;
+    }
+
+    void LatencyHistograms::Record(u32 id, i64 durationNs) {
+        thread_local std::shared_ptr<ThreadLatencies> thread{[] {
+            auto latencies{std::make_shared<ThreadLatencies>()};
+            std::scoped_lock lock(latencyMutex);
+            latencyThreads.push_back(latencies);
+            return latencies;
+        }()};
+
+        if (id >= LatencyChunkSize * LatencyChunkCount) [[unlikely]]
+            return;
+
+        auto &chunkPointer{thread->chunks[id / LatencyChunkSize]};
+        auto chunk{chunkPointer.load(std::memory_order_relaxed)};
+        if (!chunk) [[unlikely]] {
+            chunk = new std::array<LatencyCounters, LatencyChunkSize>{};
+            chunkPointer.store(chunk, std::memory_order_release);
+        }
+
+        // Only this thread writes to the counters, they're atomic so concurrent snapshots read consistent values without any read-modify-write operations being required here
+        auto &counters{(*chunk)[id % LatencyChunkSize]};
+        auto bucket{std::clamp<i64>(durationNs > 0 ? (63 - std::countl_zero(static_cast<u64>(durationNs))) - 9 : 0, 0, BucketCount - 1)};
+        counters.count.store(counters.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counters.totalNs.store(counters.totalNs.load(std::memory_order_relaxed) + durationNs, std::memory_order_relaxed);
+        if (durationNs > counters.maxNs.load(std::memory_order_relaxed))
+            counters.maxNs.store(durationNs, std::memory_order_relaxed);
+        auto &bucketCount{counters.buckets[static_cast<size_t>(bucket)]};
+        bucketCount.store(bucketCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::vector<LatencyHistograms::Summary> LatencyHistograms::Snapshot() {
+        std::unique_lock lock(latencyMutex);
+        auto names{latencyNames};
+        auto threads{latencyThreads};
+        lock.unlock();
+
+        std::vector<Summary> summaries(names.size());
+        for (size_t id{}; id < summaries.size(); id++)
+            summaries[id].name = names[id];
+
+        for (const auto &thread : threads) {
+            for (size_t chunkIndex{}; chunkIndex < LatencyChunkCount; chunkIndex++) {
+                auto chunk{thread->chunks[chunkIndex].load(std::memory_order_acquire)};
+                if (!chunk)
+                    continue;
+
+                for (size_t index{}; index < LatencyChunkSize; index++) {
+                    auto id{chunkIndex * LatencyChunkSize + index};
+                    auto &counters{(*chunk)[index]};
+                    if (id >= summaries.size() || !counters.count.load(std::memory_order_relaxed))
+                        continue;
+
+                    auto &summary{summaries[id]};
+                    summary.count += counters.count.load(std::memory_order_relaxed);
+                    summary.totalNs += counters.totalNs.load(std::memory_order_relaxed);
+                    summary.maxNs = std::max(summary.maxNs, counters.maxNs.load(std::memory_order_relaxed));
+                    for (size_t bucket{}; bucket < BucketCount; bucket++)
+                        summary.buckets[bucket] += counters.buckets[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::erase_if(summaries, [](const Summary &summary) { return !summary.count; });
+        return summaries;
+    }
+
+    i64 LatencyHistograms::Summary::Percentile(double fraction) const {
+        auto target{static_cast<u64>(std::ceil(static_cast<double>(count) * fraction))};
+        u64 accumulated{};
+        for (size_t bucket{}; bucket < BucketCount; bucket++) {
+            accumulated += buckets[bucket];
+            if (accumulated >= target)
+                return bucket == BucketCount - 1 ? maxNs : std::min(i64{1} << (bucket + 10), maxNs);
+        }
+        return maxNs;
+    }
+}
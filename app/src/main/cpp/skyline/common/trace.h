@@ -13,8 +13,11 @@ PERFETTO_DEFINE_CATEGORIES(
     perfetto::Category("kernel").SetDescription("Events from parts of the HLE kernel"),
     perfetto::Category("guest").SetDescription("Events relating to guest code"),
     perfetto::Category("gpu").SetDescription("Events from the emulated GPU"),
+    perfetto::Category("host1x").SetDescription("Events from host1x and its classes"),
     perfetto::Category("service").SetDescription("Events from the HLE sysmodule implementations"),
-    perfetto::Category("containers").SetDescription("Events from custom container implementations")
+    perfetto::Category("audio").SetDescription("Events from audio rendering and output"),
+    perfetto::Category("containers").SetDescription("Events from custom container implementations"),
+    perfetto::Category("boot").SetDescription("Events from the phases of booting a title")
 );
 
 namespace skyline::trace {
@@ -23,5 +26,128 @@ namespace skyline::trace {
      */
     enum class TrackIds : u64 {
         Presentation = std::numeric_limits<u64>::max(),
+        GpuExecution = std::numeric_limits<u64>::max() - 1, //!< Slices for the execution of command buffers on the host GPU, see gpu::TimestampTracer
+    };
+
+    /**
+     * @brief The phases of booting a title which are timed individually by BootProfile
+     */
+    enum class BootPhase : u8 {
+        KeyLoading, //!< Parsing the key files in KeyStore
+        PartitionParsing, //!< Parsing the headers of PFS0/HFS0 partitions in PartitionFileSystem
+        NcaHeaderDecryption, //!< Decrypting the headers of NCAs
+        RomFsIndex, //!< Loading the metadata tables of a RomFS
+        NsoDecompression, //!< Reading and decompressing the segments of NSOs
+        NcePatching, //!< Determining and applying the NCE patches of executables
+        ServiceInit, //!< Constructing HLE services
+    };
+    constexpr size_t BootPhaseCount{static_cast<size_t>(BootPhase::ServiceInit) + 1};
+
+    /**
+     * @brief Collects the time spent in each boot phase and logs a machine-readable summary of it once the title presents its first frame
+     * @note Phases may run on several threads concurrently, the time of a phase is the sum of its time across all threads rather than wall-clock time
+     */
+    class BootProfile {
+      public:
+        /**
+         * @brief Resets all timings and starts timing a new boot, the offsets of the first GPU submission and the first frame are relative to this
+         */
+        static void Start();
+
+        /**
+         * @return The timestamp at which the current boot was started in nanoseconds, this is 0 if no boot has been started
+         */
+        static i64 GetStart();
+
+        static void AddPhaseTime(BootPhase phase, i64 durationNs);
+
+        /**
+         * @brief Records the time at which the first command buffer is submitted to the host GPU, subsequent calls have no effect
+         */
+        static void MarkFirstGpuSubmission();
+
+        /**
+         * @brief Records the time at which the first frame is presented and logs the summary of the boot, subsequent calls have no effect
+         */
+        static void MarkFirstFramePresented();
+    };
+
+    /**
+     * @brief A scoped timer which adds its lifetime to the time of a boot phase
+     */
+    class BootPhaseScope {
+      private:
+        BootPhase phase;
+        i64 start;
+
+      public:
+        BootPhaseScope(BootPhase phase) : phase(phase), start(util::GetTimeNs()) {}
+
+        ~BootPhaseScope() {
+            BootProfile::AddPhaseTime(phase, util::GetTimeNs() - start);
+        }
     };
 }
+
+namespace skyline::trace {
+    /**
+     * @brief Log-bucketed latency histograms for HLE calls such as SVCs and service commands, these are cheap enough to always be collected
+     * @note Every thread records into its own counters without any synchronization, the counters of all threads are only merged when a snapshot is taken
+     */
+    class LatencyHistograms {
+      public:
+        static constexpr size_t BucketCount{24}; //!< The amount of buckets in a histogram, bucket N covers [2^(N + 9), 2^(N + 10)) nanoseconds while the first and last buckets also cover everything below and above them
+
+        /**
+         * @brief The merged histogram of a single call across all threads
+         */
+        struct Summary {
+            const char *name;
+            u64 count;
+            i64 totalNs;
+            i64 maxNs;
+            std::array<u64, BucketCount> buckets;
+
+            /**
+             * @return An upper bound on the latency of the supplied fraction of calls in nanoseconds, this is the upper bound of the bucket which the percentile falls into
+             */
+            i64 Percentile(double fraction) const;
+        };
+
+        /**
+         * @return A unique ID for the call with the supplied name, this is cached per-thread so it only locks the first time a thread observes a call
+         * @param name A string with a static lifetime, calls are identified by the address of their name
+         */
+        static u32 GetId(const char *name);
+
+        static void Record(u32 id, i64 durationNs);
+
+        /**
+         * @return The merged histograms of every call that has been recorded at least once
+         */
+        static std::vector<Summary> Snapshot();
+    };
+
+    /**
+     * @brief A scoped timer which records its lifetime into the latency histogram of a call
+     */
+    class LatencyScope {
+      private:
+        u32 id;
+        i64 start;
+
+      public:
+        LatencyScope(const char *name) : id(LatencyHistograms::GetId(name)), start(util::GetTimeNs()) {}
+
+        ~LatencyScope() {
+            LatencyHistograms::Record(id, util::GetTimeNs() - start);
+        }
+    };
+}
+
+/**
+ * @brief Emits a Perfetto slice for the current scope and adds its duration to the supplied boot phase
+ */
+#define TRACE_BOOT_PHASE(phase, name) \
+    TRACE_EVENT("boot", name);         \
+    ::skyline::trace::BootPhaseScope PERFETTO_UID(bootPhaseScope)(::skyline::trace::BootPhase::phase)
@@ -10,16 +10,23 @@
 #include "base.h"
 
 namespace skyline::util {
+    /**
+     * @return The supplied duration in CNTVCT ticks converted to nanoseconds
+     */
+    inline i64 TicksToNs(u64 ticks) {
+        u64 frequency;
+        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        return static_cast<i64>(((ticks / frequency) * constant::NsInSecond) + (((ticks % frequency) * constant::NsInSecond + (frequency / 2)) / frequency));
+    }
+
     /**
      * @brief Returns the current time in nanoseconds
      * @return The current time in nanoseconds
      */
     inline i64 GetTimeNs() {
-        u64 frequency;
-        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
         u64 ticks;
         asm("MRS %0, CNTVCT_EL0" : "=r"(ticks));
-        return static_cast<i64>(((ticks / frequency) * constant::NsInSecond) + (((ticks % frequency) * constant::NsInSecond + (frequency / 2)) / frequency));
+        return TicksToNs(ticks);
     }
 
     /**
@@ -32,6 +39,17 @@ namespace skyline::util {
         return ticks;
     }
 
+    /**
+     * @return The current time in ticks of the guest GPU timer, this runs at 614.4MHz
+     */
+    inline u64 GetGpuTimeTicks() {
+        constexpr i64 NsToTickNumerator{384};
+        constexpr i64 NsToTickDenominator{625};
+
+        i64 nsTime{GetTimeNs()};
+        return static_cast<u64>((nsTime / NsToTickDenominator) * NsToTickNumerator + ((nsTime % NsToTickDenominator) * NsToTickNumerator) / NsToTickDenominator);
+    }
+
     /**
      * @brief A way to implicitly convert a pointer to uintptr_t and leave it unaffected if it isn't a pointer
      */
@@ -92,6 +110,15 @@ namespace skyline::util {
             return (PointerValue(value) % multiple) == 0;
     }
 
+    /**
+     * @return The quotient of the division rounded up to the next integer
+     */
+    template<typename Type>
+    requires std::is_unsigned_v<Type> && std::is_integral_v<Type>
+    constexpr Type DivideCeil(Type dividend, Type divisor) {
+        return (dividend + divisor - 1) / divisor;
+    }
+
     template<typename TypeVal>
     requires IsPointerOrUnsignedIntegral<TypeVal>
     constexpr bool IsPageAligned(TypeVal value) {
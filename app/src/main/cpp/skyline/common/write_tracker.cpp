@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fstream>
+#include "signal.h"
+#include "write_tracker.h"
+
+namespace skyline {
+    WriteTracker::Trap::Trap(span<u8> region, int permission, bool pageGranular) : region(region), permission(permission), pageGranular(pageGranular), dirtyPages(pageGranular ? util::AlignUp(region.size() / PAGE_SIZE, 64) / 64 : 0) {
+        // All pages start off dirty as the region has never been read
+        for (auto &word : dirtyPages)
+            word.store(~0ULL, std::memory_order_relaxed);
+    }
+
+    void WriteTracker::Trap::MarkDirty(u8 *start, u8 *end) {
+        // The bits are set prior to the trap being marked as dirty so they're visible to anyone observing the trap as dirty
+        if (pageGranular) {
+            size_t firstPage{static_cast<size_t>(std::max(start, region.data()) - region.data()) / PAGE_SIZE};
+            size_t endPage{util::AlignUp(static_cast<size_t>(std::min(end, region.data() + region.size()) - region.data()), PAGE_SIZE) / PAGE_SIZE};
+            for (size_t page{firstPage}; page < endPage; page++)
+                dirtyPages[page / 64].fetch_or(1ULL << (page % 64), std::memory_order_relaxed);
+        }
+        dirty.store(true, std::memory_order_release);
+    }
+
+    std::vector<u64> WriteTracker::Trap::TakeDirtyPages() {
+        std::vector<u64> pages(dirtyPages.size());
+        for (size_t index{}; index < dirtyPages.size(); index++)
+            pages[index] = dirtyPages[index].exchange(0, std::memory_order_acq_rel);
+        faultCount.store(0, std::memory_order_relaxed);
+        return pages;
+    }
+
+    void WriteTracker::Trap::ClearDirtyPages() {
+        for (auto &word : dirtyPages)
+            word.store(0, std::memory_order_relaxed);
+        faultCount.store(0, std::memory_order_relaxed);
+    }
+
+    WriteTracker::WriteTracker() : table(std::make_unique<TrapTable>()) {
+        if (instance)
+            throw exception("Only a single instance of WriteTracker may exist at a time");
+        publishedTable.store(table.get());
+        instance = this;
+        signal::SetAccessViolationHandler(&AccessViolationHandler);
+    }
+
+    WriteTracker::~WriteTracker() {
+        signal::SetAccessViolationHandler(nullptr);
+        instance = nullptr;
+
+        std::scoped_lock lock(mutex);
+        PublishTable();
+    }
+
+    void WriteTracker::PublishTable() {
+        if (!tableStale)
+            return;
+
+        auto newTable{std::make_unique<TrapTable>()};
+        newTable->reserve(traps.size());
+        for (auto trap : traps)
+            newTable->push_back(TrapEntry{trap->region.data(), trap->region.data() + trap->region.size(), nullptr, trap});
+        std::sort(newTable->begin(), newTable->end(), [](const TrapEntry &a, const TrapEntry &b) { return a.start < b.start; });
+
+        u8 *maxEnd{};
+        for (auto &entry : *newTable)
+            entry.maxEnd = maxEnd = std::max(maxEnd, entry.end);
+
+        publishedTable.store(newTable.get());
+
+        // Readers count themselves into the epoch they observed, any that could have read the old table have counted themselves into the epoch prior to this increment
+        auto epoch{readerEpoch.fetch_add(1)};
+        auto &oldReaders{readerCounts[epoch & 1]};
+        while (oldReaders.load())
+            std::this_thread::yield();
+
+        table = std::move(newTable);
+        tableStale = false;
+
+        for (auto trap : retiredTraps)
+            delete trap;
+        retiredTraps.clear();
+    }
+
+    template<typename Function>
+    void WriteTracker::ForEachTrap(const TrapTable &traps, u8 *start, u8 *end, Function function) {
+        // All entries prior to the first one starting at or after the end of the range could overlap it, they're scanned backwards till no prior entry can end after the start of the range
+        auto it{std::lower_bound(traps.begin(), traps.end(), end, [](const TrapEntry &entry, u8 *address) { return entry.start < address; })};
+        while (it != traps.begin()) {
+            --it;
+            if (it->maxEnd <= start)
+                break;
+            if (it->end > start)
+                function(*it->trap);
+        }
+    }
+
+    void WriteTracker::Unprotect(const TrapTable &traps, span<u8> range, int permission) {
+        mprotect(range.data(), range.size(), permission);
+        ForEachTrap(traps, range.data(), range.data() + range.size(), [&](Trap &trap) {
+            trap.MarkDirty(range.data(), range.data() + range.size());
+        });
+    }
+
+    void WriteTracker::ResolveAccess(const TrapTable &traps, Trap &trap) {
+        if (!trap.accessTrapped.load(std::memory_order_acquire))
+            return;
+
+        // Any other threads accessing the region concurrently will block on the mutex till the region has been filled
+        std::scoped_lock lock(trap.accessMutex);
+        if (!trap.accessTrapped.load(std::memory_order_acquire))
+            return; // Another thread has already resolved the access while we were waiting
+
+        Unprotect(traps, trap.region, trap.permission);
+        auto callback{std::move(trap.accessCallback)};
+        trap.accessCallback = {};
+        callback();
+
+        trap.ClearDirtyPages();
+        trap.dirty.store(false, std::memory_order_release);
+        mprotect(trap.region.data(), trap.region.size(), GetProtectedPermission(trap.permission));
+        trap.accessTrapped.store(false, std::memory_order_release);
+    }
+
+    bool WriteTracker::AccessViolationHandler(void *fault) {
+        auto tracker{instance};
+        if (!tracker)
+            return false;
+
+        // The reader is counted into the current epoch, if a table was published in between then the count is moved into the new epoch as the publisher might not wait on it otherwise
+        auto epoch{tracker->readerEpoch.load()};
+        tracker->readerCounts[epoch & 1].fetch_add(1);
+        while (auto currentEpoch{tracker->readerEpoch.load()} != epoch) {
+            tracker->readerCounts[epoch & 1].fetch_sub(1);
+            epoch = currentEpoch;
+            tracker->readerCounts[epoch & 1].fetch_add(1);
+        }
+
+        const auto &traps{*tracker->publishedTable.load()};
+
+        // We unprotect the entirety of every trap containing the faulting address rather than just the page as it's likely that writes to the rest of the region will follow
+        // Page-granular traps are the exception, only the faulting page is unprotected till they've faulted too often for it to be worthwhile
+        // If the access was to a region with a pending access callback, it's filled and write-protected instead, a write will fault again on retrying and dirty it as usual
+        auto address{reinterpret_cast<u8 *>(fault)};
+        bool handled{};
+        ForEachTrap(traps, address, address + 1, [&](Trap &trap) {
+            if (trap.accessTrapped.load(std::memory_order_acquire))
+                tracker->ResolveAccess(traps, trap);
+            else if (!(trap.permission & PROT_WRITE))
+                return; // The region wasn't writable prior to being trapped, the fault is a genuine access violation which unprotecting it wouldn't resolve
+            else if (trap.pageGranular && trap.faultCount.fetch_add(1, std::memory_order_relaxed) < MaxPageFaults)
+                Unprotect(traps, span<u8>{util::AlignDown(address, PAGE_SIZE), PAGE_SIZE}, trap.permission);
+            else
+                Unprotect(traps, trap.region, trap.permission);
+            handled = true;
+        });
+
+        tracker->readerCounts[epoch & 1].fetch_sub(1);
+        return handled;
+    }
+
+    int WriteTracker::QueryPermission(span<u8> region) {
+        // There's no syscall to query the protection of a mapping, the mappings of the process are parsed instead with each line being formatted as "start-end rwxp ..."
+        auto start{reinterpret_cast<u64>(region.data())}, end{start + region.size()};
+        std::ifstream mapsFile("/proc/self/maps");
+        std::string line;
+        int permission{};
+        bool mapped{};
+        while (std::getline(mapsFile, line)) {
+            char *separator;
+            u64 mappingStart{std::strtoull(line.c_str(), &separator, 16)};
+            u64 mappingEnd{std::strtoull(separator + 1, &separator, 16)};
+            if (mappingStart >= end)
+                break; // The mappings are sorted by address so none of the following ones can overlap the region
+            if (mappingEnd <= start)
+                continue;
+
+            mapped = true;
+            if (separator[1] == 'r')
+                permission |= PROT_READ;
+            if (separator[2] == 'w')
+                permission |= PROT_WRITE;
+            if (separator[3] == 'x')
+                permission |= PROT_EXEC;
+        }
+        return mapped ? permission : UnprotectedPermission;
+    }
+
+    std::shared_ptr<WriteTracker::Trap> WriteTracker::CreateTrap(span<u8> region, bool pageGranular, int permission) {
+        auto start{util::AlignDown(reinterpret_cast<u64>(region.data()), PAGE_SIZE)}, end{util::AlignUp(reinterpret_cast<u64>(region.data() + region.size()), PAGE_SIZE)};
+        span<u8> alignedRegion{reinterpret_cast<u8 *>(start), end - start};
+        auto trap{new Trap(alignedRegion, permission < 0 ? QueryPermission(alignedRegion) : permission, pageGranular)};
+
+        // The table isn't published till the trap is protected for the first time as faults can't occur on its region prior to that, this batches the creation of many traps into a single table
+        std::scoped_lock lock(mutex);
+        traps.insert(trap);
+        tableStale = true;
+
+        return std::shared_ptr<Trap>(trap, [this](Trap *trap) {
+            std::scoped_lock lock(mutex);
+            traps.erase(trap);
+            tableStale = true;
+
+            // Any other traps overlapping the pages are marked as dirty as their pages won't be protected anymore, the trap itself is only deleted once a table without it has been published as the signal handler may still be reading it
+            Unprotect(*table, trap->region, trap->permission);
+            retiredTraps.push_back(trap);
+        });
+    }
+
+    std::vector<u64> WriteTracker::Protect(Trap &trap) {
+        std::scoped_lock lock(mutex);
+        PublishTable();
+        ResolveAccess(*table, trap);
+
+        // The trap is marked clean prior to protecting its pages, a concurrent fault on them unprotects them prior to dirtying it, so the trap is never left clean with unprotected pages
+        // The same applies to the dirty bitmap, a page dirtied after it's taken is protected with its bit set and will be included in the next bitmap
+        auto dirtyPages{trap.TakeDirtyPages()};
+        trap.dirty.store(false, std::memory_order_release);
+        mprotect(trap.region.data(), trap.region.size(), GetProtectedPermission(trap.permission));
+        return dirtyPages;
+    }
+
+    void WriteTracker::TrapAccess(Trap &trap, std::function<void()> callback) {
+        std::scoped_lock lock(mutex);
+        PublishTable();
+        std::scoped_lock accessLock(trap.accessMutex);
+        trap.accessCallback = std::move(callback);
+        trap.ClearDirtyPages();
+        trap.dirty.store(false, std::memory_order_release);
+        trap.accessTrapped.store(true, std::memory_order_release);
+        mprotect(trap.region.data(), trap.region.size(), TrappedPermission);
+    }
+}
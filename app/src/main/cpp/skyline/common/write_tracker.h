@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <functional>
+#include <unordered_set>
+#include <sys/mman.h>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief Tracks CPU writes to regions of guest memory at page granularity by write-protecting them and catching the resulting SIGSEGV
+     * @note Any write to a protected page from any thread marks all traps overlapping it as dirty and unprotects their pages, there's no way to distinguish between guest and host writes
+     * @note Reads can be trapped as well by removing all access to a region, this is used to defer filling guest memory till it's actually accessed
+     * @note Only a single instance of this class can exist at a time as it's invoked from the process-wide signal handler
+     */
+    class WriteTracker {
+      public:
+        /**
+         * @brief A page-aligned region of guest memory which is tracked for writes
+         */
+        struct Trap {
+            span<u8> region; //!< The page-aligned region of guest memory covered by this trap
+            int permission; //!< The host protection of the region prior to it being trapped, it's restored whenever the region is unprotected
+            std::atomic<bool> dirty{true}; //!< If the region may have been written to since it was last protected, this starts off true as the region has never been read
+            std::atomic<bool> accessTrapped{}; //!< If all accesses to the region are trapped till the access callback has been run
+            std::mutex accessMutex; //!< Synchronizes setting and running the access callback
+            std::function<void()> accessCallback; //!< A callback which fills the region with its contents, it's run on the first access of any kind to the region after being set
+            bool pageGranular; //!< If a write only unprotects the page it's in rather than the entire region, this lets the owner determine which pages were written to at the cost of more faults
+            std::vector<std::atomic<u64>> dirtyPages; //!< A bitmap of the pages in the region which may have been written to since it was last protected, this is only maintained for page-granular traps
+            std::atomic<u32> faultCount{}; //!< The amount of faults on the region since it was last protected, page-granular traps are entirely unprotected once this exceeds MaxPageFaults
+
+            Trap(span<u8> region, int permission, bool pageGranular);
+
+            /**
+             * @brief Marks the pages of the region overlapping the supplied range as dirty alongside the trap itself
+             */
+            void MarkDirty(u8 *start, u8 *end);
+
+            /**
+             * @brief Clears the dirty bitmap and returns its prior contents, this is empty for traps that aren't page-granular
+             */
+            std::vector<u64> TakeDirtyPages();
+
+            /**
+             * @brief Clears the dirty bitmap without allocating, this is safe to call from the signal handler
+             */
+            void ClearDirtyPages();
+        };
+
+      private:
+        static constexpr int TrappedPermission{PROT_NONE}; //!< The permission of guest memory covered by a trap with a pending access callback
+        static constexpr int UnprotectedPermission{PROT_READ | PROT_WRITE | PROT_EXEC}; //!< The permission assumed for regions without a host mapping, this matches the permissions of all guest private memory
+        static constexpr u32 MaxPageFaults{16}; //!< The maximum amount of single page faults on a page-granular trap before it's unprotected entirely, this bounds the cost of a large region being rewritten in its entirety
+
+        static inline WriteTracker *instance{}; //!< The instance that the signal handler delegates to
+
+        /**
+         * @brief A trap in the table that the signal handler looks up traps in
+         */
+        struct TrapEntry {
+            u8 *start;
+            u8 *end;
+            u8 *maxEnd; //!< The maximum end of this and all prior entries, this bounds the backwards scan for traps overlapping an address as traps may overlap each other
+            Trap *trap;
+        };
+
+        /**
+         * @brief An immutable table of all traps sorted by the start of their regions, it's replaced as a whole on any change so the signal handler can read it without any locks
+         */
+        using TrapTable = std::vector<TrapEntry>;
+
+        std::mutex mutex; //!< Synchronizes all changes to the traps and publishing of tables, the signal handler never locks this
+        std::unordered_set<Trap *> traps; //!< All traps which haven't been removed, this is the source of the next table
+        std::vector<Trap *> retiredTraps; //!< Removed traps which may still be in the published table, they're deleted once a table without them has been published
+        bool tableStale{}; //!< If the traps have changed since the last table was published
+        std::unique_ptr<TrapTable> table; //!< The table which is currently published
+        std::atomic<const TrapTable *> publishedTable{}; //!< The table that the signal handler reads, this is read-copy-update with the grace period tracked by the reader counters below
+        std::atomic<u32> readerEpoch{}; //!< The epoch that new readers count themselves into, it's incremented for every published table
+        std::array<std::atomic<u32>, 2> readerCounts{}; //!< The amount of readers of the published table in the current and prior epoch
+
+        /**
+         * @brief Publishes a table with the current traps if they've changed, waits for all readers of the prior table and deletes any retired traps
+         * @note The mutex must be locked
+         */
+        void PublishTable();
+
+        /**
+         * @brief Calls the supplied function with every trap in the table that overlaps the supplied range
+         */
+        template<typename Function>
+        static void ForEachTrap(const TrapTable &traps, u8 *start, u8 *end, Function function);
+
+        /**
+         * @return The protection a clean trap on memory with the supplied original protection is set to, this is the original protection without write access
+         */
+        static constexpr int GetProtectedPermission(int permission) {
+            return permission & ~PROT_WRITE;
+        }
+
+        /**
+         * @brief Restores the supplied original protection of the pages in the supplied range and marks all traps overlapping any of them as dirty
+         * @note Pages are unprotected prior to marking traps as dirty so a trap being protected concurrently is never left clean with unprotected pages
+         */
+        static void Unprotect(const TrapTable &traps, span<u8> range, int permission);
+
+        /**
+         * @brief Runs the access callback of the trap if it's pending, the trap is clean and write-protected afterwards
+         * @param traps The table of traps, the region is unprotected through it so any overlapping traps are dirtied as their pages become writable while the callback runs
+         */
+        void ResolveAccess(const TrapTable &traps, Trap &trap);
+
+        /**
+         * @brief The access violation handler that is called from the signal handler
+         * @return If the fault was caused by a trap and has been resolved, the faulting access can be retried in that case
+         * @note This doesn't take any locks aside from the access mutex of traps with a pending access callback, it reads the published table and counts itself as a reader of it
+         */
+        static bool AccessViolationHandler(void *fault);
+
+      public:
+        WriteTracker();
+
+        ~WriteTracker();
+
+        /**
+         * @return The host protection of the pages in the supplied region, this is a union of the protections if they differ and UnprotectedPermission if they aren't mapped
+         * @note This reads the mappings of the process which is relatively expensive, it should be called once for a set of traps on the same mapping rather than for each of them
+         */
+        static int QueryPermission(span<u8> region);
+
+        /**
+         * @brief Creates a trap for the supplied region of guest memory, it's unprotected and dirty till it is protected for the first time
+         * @param pageGranular If the trap tracks which of its pages were written to, see Trap::pageGranular
+         * @param permission The current host protection of the region as returned by QueryPermission, it's queried if this is negative
+         * @note The trap is removed when the returned object is destroyed, its region is then restored to its original protection
+         */
+        std::shared_ptr<Trap> CreateTrap(span<u8> region, bool pageGranular = false, int permission = -1);
+
+        /**
+         * @brief Marks a trap as clean and write-protects its pages, this must be done prior to reading from the region so writes during the read aren't missed
+         * @return A bitmap of the pages of the region that were dirty prior to this, it's empty for traps that aren't page-granular
+         * @note Any pending access callback is run prior to protecting the trap as the region wouldn't have valid contents otherwise
+         */
+        std::vector<u64> Protect(Trap &trap);
+
+        /**
+         * @brief Traps all accesses to the region of a trap, the supplied callback is run on the first access to fill the region with its contents
+         * @note The callback is run from the signal handler of the accessing thread, it must not lock anything that thread might hold or create and destroy traps
+         * @note The trap is considered clean as the callback is expected to overwrite the entire region, any prior writes are discarded
+         */
+        void TrapAccess(Trap &trap, std::function<void()> callback);
+    };
+}
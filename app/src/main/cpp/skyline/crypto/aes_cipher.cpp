@@ -4,25 +4,82 @@
 #include "aes_cipher.h"
 
 namespace skyline::crypto {
-    AesCipher::AesCipher(span<u8> key, mbedtls_cipher_type_t type) {
+    AesCipher::AesCipher(span<u8> key, mbedtls_cipher_type_t type) : type(type) {
         mbedtls_cipher_init(&decryptContext);
         if (mbedtls_cipher_setup(&decryptContext, mbedtls_cipher_info_from_type(type)) != 0)
             throw exception("Failed to setup decryption context");
 
         if (mbedtls_cipher_setkey(&decryptContext, key.data(), static_cast<int>(key.size() * 8), MBEDTLS_DECRYPT) != 0)
             throw exception("Failed to set key for decryption context");
+
+        if (HardwareAes128::IsSupported()) {
+            HardwareAes128::RoundKeys unusedKeys;
+            if (type == MBEDTLS_CIPHER_AES_128_CTR && key.size() == HardwareAes128::BlockSize) {
+                HardwareAes128::ExpandKey(key, encryptKeys, unusedKeys);
+                hardware = true;
+            } else if (type == MBEDTLS_CIPHER_AES_128_XTS && key.size() == HardwareAes128::BlockSize * 2) {
+                // The first half of an XTS key is used for the data while the second half is used for encrypting the tweak
+                HardwareAes128::ExpandKey(key.first(HardwareAes128::BlockSize), unusedKeys, decryptKeys);
+                HardwareAes128::ExpandKey(key.subspan(HardwareAes128::BlockSize), encryptKeys, unusedKeys);
+                hardware = true;
+            }
+        }
+
+        if (type == MBEDTLS_CIPHER_AES_128_CTR && !hardware) {
+            ctrContext.emplace();
+            mbedtls_aes_init(&*ctrContext);
+            if (mbedtls_aes_setkey_enc(&*ctrContext, key.data(), static_cast<unsigned int>(key.size() * 8)) != 0)
+                throw exception("Failed to set key for CTR context");
+        }
     }
 
     AesCipher::~AesCipher() {
         mbedtls_cipher_free(&decryptContext);
+        if (ctrContext)
+            mbedtls_aes_free(&*ctrContext);
+    }
+
+    void AesCipher::CtrDecrypt(u8 *destination, const u8 *source, size_t size, HardwareAes128::Block counter) {
+        if (hardware) {
+            HardwareAes128::CtrCrypt(encryptKeys, counter, destination, source, size);
+            return;
+        }
+
+        if (!ctrContext)
+            throw exception("Stateless CTR decryption used with a non-CTR cipher");
+
+        // All state of the decryption is local, the context is only read from
+        size_t streamOffset{};
+        HardwareAes128::Block streamBlock{};
+        if (mbedtls_aes_crypt_ctr(&*ctrContext, size, &streamOffset, counter.data(), streamBlock.data(), source, destination) != 0)
+            throw exception("Failed to decrypt CTR data");
     }
 
-    void AesCipher::SetIV(const std::array<u8, 0x10> &iv) {
-        if (mbedtls_cipher_set_iv(&decryptContext, iv.data(), iv.size()) != 0)
+    void AesCipher::SetIV(const std::array<u8, 0x10> &pIv) {
+        if (hardware) {
+            iv = pIv;
+            return;
+        }
+
+        if (mbedtls_cipher_set_iv(&decryptContext, pIv.data(), pIv.size()) != 0)
             throw exception("Failed to set IV for decryption context");
     }
 
     void AesCipher::Decrypt(u8 *destination, u8 *source, size_t size) {
+        if (hardware) {
+            if (type == MBEDTLS_CIPHER_AES_128_CTR) {
+                HardwareAes128::CtrCrypt(encryptKeys, iv, destination, source, size);
+                return;
+            } else if (size % HardwareAes128::BlockSize == 0) [[likely]] {
+                HardwareAes128::XtsDecrypt(decryptKeys, encryptKeys, iv, destination, source, size);
+                return;
+            }
+
+            // XTS data units which aren't a multiple of the block size need ciphertext stealing which is only implemented by mbedtls
+            if (mbedtls_cipher_set_iv(&decryptContext, iv.data(), iv.size()) != 0)
+                throw exception("Failed to set IV for decryption context");
+        }
+
         constexpr size_t maxBufferSize = 1024 * 1024; //!< Buffer shouldn't grow larger than 1 MiB
 
         std::optional<std::vector<u8>> buf{};
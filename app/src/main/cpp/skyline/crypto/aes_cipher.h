@@ -4,11 +4,14 @@
 #pragma once
 
 #include <mbedtls/cipher.h>
+#include <mbedtls/aes.h>
 #include <common.h>
+#include "aes_hardware.h"
 
 namespace skyline::crypto {
     /**
      * @brief Wrapper for mbedtls for AES decryption using a cipher
+     * @note AES-128-CTR and AES-128-XTS are done with the ARMv8 Cryptography Extensions rather than mbedtls when the host supports them
      * @note The IV state must be appropriately locked during multi-threaded usage
      */
     class AesCipher {
@@ -16,6 +19,13 @@ namespace skyline::crypto {
         mbedtls_cipher_context_t decryptContext;
         std::vector<u8> buffer; //!< A buffer used to avoid constant memory allocation
 
+        mbedtls_cipher_type_t type;
+        bool hardware{}; //!< If the hardware implementation is used for this cipher rather than mbedtls
+        HardwareAes128::Block iv{}; //!< The IV for the hardware implementation, for CTR this is advanced by decryption
+        HardwareAes128::RoundKeys encryptKeys{}; //!< The encryption round keys for CTR or the tweak encryption round keys for XTS
+        HardwareAes128::RoundKeys decryptKeys{}; //!< The decryption round keys for XTS, these are unused for CTR
+        std::optional<mbedtls_aes_context> ctrContext; //!< An AES context with the encryption key schedule for stateless CTR decryption without hardware support, this is only read from after construction
+
         /**
          * @brief Calculates IV for XTS, basically just big to little endian conversion
          */
@@ -49,6 +59,13 @@ namespace skyline::crypto {
             Decrypt(data.data(), data.data(), data.size());
         }
 
+        /**
+         * @brief Decrypts data with AES-CTR using the supplied counter rather than the IV state of the cipher
+         * @note This doesn't modify any state of the cipher, so it can be called concurrently from multiple threads
+         * @note The destination and source buffers can be the same
+         */
+        void CtrDecrypt(u8 *destination, const u8 *source, size_t size, HardwareAes128::Block counter);
+
         /**
          * @brief Decrypts data with XTS, IV will get calculated with the given sector
          */
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include "aes_hardware.h"
+
+namespace skyline::crypto {
+    using LoadedRoundKeys = std::array<uint8x16_t, HardwareAes128::RoundCount + 1>;
+
+    static LoadedRoundKeys LoadRoundKeys(const HardwareAes128::RoundKeys &keys) {
+        LoadedRoundKeys loaded;
+        for (size_t round{}; round < loaded.size(); round++)
+            loaded[round] = vld1q_u8(keys[round].data());
+        return loaded;
+    }
+
+    /**
+     * @brief Encrypts several independent blocks at once, interleaving them hides the latency of the AES instructions
+     */
+    template<size_t Count>
+    static void EncryptBlocks(std::array<uint8x16_t, Count> &blocks, const LoadedRoundKeys &keys) {
+        for (size_t round{}; round < HardwareAes128::RoundCount - 1; round++)
+            for (auto &block : blocks)
+                block = vaesmcq_u8(vaeseq_u8(block, keys[round]));
+        for (auto &block : blocks)
+            block = veorq_u8(vaeseq_u8(block, keys[HardwareAes128::RoundCount - 1]), keys[HardwareAes128::RoundCount]);
+    }
+
+    template<size_t Count>
+    static void DecryptBlocks(std::array<uint8x16_t, Count> &blocks, const LoadedRoundKeys &keys) {
+        for (size_t round{}; round < HardwareAes128::RoundCount - 1; round++)
+            for (auto &block : blocks)
+                block = vaesimcq_u8(vaesdq_u8(block, keys[round]));
+        for (auto &block : blocks)
+            block = veorq_u8(vaesdq_u8(block, keys[HardwareAes128::RoundCount - 1]), keys[HardwareAes128::RoundCount]);
+    }
+
+    bool HardwareAes128::IsSupported() {
+        static const bool supported{(getauxval(AT_HWCAP) & HWCAP_AES) != 0};
+        return supported;
+    }
+
+    /**
+     * @return The supplied word with the AES S-box applied to each byte
+     */
+    static u32 SubWord(u32 word) {
+        // AESE with a zero round key does ShiftRows followed by SubBytes, with the word duplicated across all columns ShiftRows has no effect
+        auto state{vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(word)), vdupq_n_u8(0))};
+        return vgetq_lane_u32(vreinterpretq_u32_u8(state), 0);
+    }
+
+    void HardwareAes128::ExpandKey(span<const u8> key, RoundKeys &encryptKeys, RoundKeys &decryptKeys) {
+        if (key.size() != BlockSize)
+            throw exception("Unexpected AES-128 key size: 0x{:X}", key.size());
+
+        constexpr std::array<u8, RoundCount> RoundConstants{0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+
+        std::array<u32, (RoundCount + 1) * 4> words; //!< The key schedule as little-endian words, each byte of a word corresponds to a row of the state
+        std::memcpy(words.data(), key.data(), BlockSize);
+        for (size_t index{4}; index < words.size(); index++) {
+            u32 temp{words[index - 1]};
+            if (index % 4 == 0)
+                temp = SubWord((temp >> 8) | (temp << 24)) ^ RoundConstants[(index / 4) - 1];
+            words[index] = words[index - 4] ^ temp;
+        }
+        std::memcpy(encryptKeys.data(), words.data(), sizeof(words));
+
+        // The equivalent inverse cipher uses the encryption keys in reverse with InvMixColumns applied to all but the first and last
+        decryptKeys.front() = encryptKeys.back();
+        for (size_t round{1}; round < RoundCount; round++)
+            vst1q_u8(decryptKeys[round].data(), vaesimcq_u8(vld1q_u8(encryptKeys[RoundCount - round].data())));
+        decryptKeys.back() = encryptKeys.front();
+    }
+
+    void HardwareAes128::CtrCrypt(const RoundKeys &encryptKeys, Block &counter, u8 *destination, const u8 *source, size_t size) {
+        auto keys{LoadRoundKeys(encryptKeys)};
+
+        u64 counterHigh, counterLow;
+        std::memcpy(&counterHigh, counter.data(), sizeof(u64));
+        std::memcpy(&counterLow, counter.data() + sizeof(u64), sizeof(u64));
+        counterHigh = util::SwapEndianness(counterHigh);
+        counterLow = util::SwapEndianness(counterLow);
+
+        auto nextCounter{[&]() {
+            auto block{vcombine_u8(vrev64_u8(vcreate_u8(counterHigh)), vrev64_u8(vcreate_u8(counterLow)))};
+            if (++counterLow == 0) [[unlikely]]
+                counterHigh++;
+            return block;
+        }};
+
+        constexpr size_t ParallelBlocks{4};
+        for (; size >= ParallelBlocks * BlockSize; size -= ParallelBlocks * BlockSize) {
+            std::array<uint8x16_t, ParallelBlocks> blocks;
+            for (auto &block : blocks)
+                block = nextCounter();
+            EncryptBlocks(blocks, keys);
+
+            for (auto &block : blocks) {
+                vst1q_u8(destination, veorq_u8(vld1q_u8(source), block));
+                source += BlockSize;
+                destination += BlockSize;
+            }
+        }
+
+        for (; size; ) {
+            std::array<uint8x16_t, 1> block{nextCounter()};
+            EncryptBlocks(block, keys);
+
+            if (size >= BlockSize) {
+                vst1q_u8(destination, veorq_u8(vld1q_u8(source), block[0]));
+                source += BlockSize;
+                destination += BlockSize;
+                size -= BlockSize;
+            } else {
+                // The final partial block only uses as much of the keystream as is required
+                Block keystream;
+                vst1q_u8(keystream.data(), block[0]);
+                for (size_t index{}; index < size; index++)
+                    destination[index] = source[index] ^ keystream[index];
+                size = 0;
+            }
+        }
+
+        counterHigh = util::SwapEndianness(counterHigh);
+        counterLow = util::SwapEndianness(counterLow);
+        std::memcpy(counter.data(), &counterHigh, sizeof(u64));
+        std::memcpy(counter.data() + sizeof(u64), &counterLow, sizeof(u64));
+    }
+
+    /**
+     * @return The XTS tweak multiplied by the primitive element of GF(2^128), the tweak is treated as a little-endian integer
+     */
+    static uint8x16_t MultiplyTweak(uint8x16_t tweak) {
+        auto words{vreinterpretq_u64_u8(tweak)};
+        u64 low{vgetq_lane_u64(words, 0)}, high{vgetq_lane_u64(words, 1)};
+        u64 carry{high >> 63};
+        high = (high << 1) | (low >> 63);
+        low = (low << 1) ^ (carry * 0x87);
+        return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(low), vcreate_u64(high)));
+    }
+
+    void HardwareAes128::XtsDecrypt(const RoundKeys &decryptKeys, const RoundKeys &tweakKeys, const Block &tweak, u8 *destination, const u8 *source, size_t size) {
+        if (size % BlockSize)
+            throw exception("XTS data unit isn't a multiple of the block size: 0x{:X}", size);
+
+        std::array<uint8x16_t, 1> currentTweak{vld1q_u8(tweak.data())};
+        EncryptBlocks(currentTweak, LoadRoundKeys(tweakKeys));
+
+        auto keys{LoadRoundKeys(decryptKeys)};
+        constexpr size_t ParallelBlocks{4};
+        while (size) {
+            size_t count{std::min(size / BlockSize, ParallelBlocks)};
+
+            std::array<uint8x16_t, ParallelBlocks> tweaks, blocks;
+            for (size_t index{}; index < ParallelBlocks; index++) {
+                tweaks[index] = currentTweak[0];
+                blocks[index] = index < count ? veorq_u8(vld1q_u8(source + (index * BlockSize)), tweaks[index]) : vdupq_n_u8(0);
+                if (index < count)
+                    currentTweak[0] = MultiplyTweak(currentTweak[0]);
+            }
+
+            DecryptBlocks(blocks, keys);
+
+            for (size_t index{}; index < count; index++)
+                vst1q_u8(destination + (index * BlockSize), veorq_u8(blocks[index], tweaks[index]));
+
+            source += count * BlockSize;
+            destination += count * BlockSize;
+            size -= count * BlockSize;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::crypto {
+    /**
+     * @brief An implementation of AES-128 using the ARMv8 Cryptography Extensions (AESE/AESD/AESMC/AESIMC), these are several times faster than a generic software implementation
+     * @note IsSupported must be checked prior to using any other functions as they'll raise SIGILL on hosts without the extensions
+     */
+    class HardwareAes128 {
+      public:
+        static constexpr size_t RoundCount{10};
+        static constexpr size_t BlockSize{0x10};
+        using Block = std::array<u8, BlockSize>;
+        using RoundKeys = std::array<Block, RoundCount + 1>; //!< The expanded key schedule for all rounds of a single direction
+
+        /**
+         * @return If the host CPU supports the AES instructions from the ARMv8 Cryptography Extensions
+         */
+        static bool IsSupported();
+
+        /**
+         * @brief Expands a 128-bit key into the round keys for encryption and decryption, the decryption keys are in the order they're used in for the equivalent inverse cipher
+         */
+        static void ExpandKey(span<const u8> key, RoundKeys &encryptKeys, RoundKeys &decryptKeys);
+
+        /**
+         * @brief Encrypts or decrypts data with AES-CTR, the counter is treated as a 128-bit big-endian integer
+         * @param counter The counter of the first block, this is advanced past all blocks which were (partially) used
+         * @note The destination and source buffers can be the same
+         */
+        static void CtrCrypt(const RoundKeys &encryptKeys, Block &counter, u8 *destination, const u8 *source, size_t size);
+
+        /**
+         * @brief Decrypts a single data unit encrypted with AES-XTS
+         * @param decryptKeys The decryption round keys derived from the first half of the XTS key
+         * @param tweakKeys The encryption round keys derived from the second half of the XTS key
+         * @param size The size of the data unit, this must be a multiple of the block size as ciphertext stealing isn't supported
+         * @note The destination and source buffers can be the same
+         */
+        static void XtsDecrypt(const RoundKeys &decryptKeys, const RoundKeys &tweakKeys, const Block &tweak, u8 *destination, const u8 *source, size_t size);
+    };
+}
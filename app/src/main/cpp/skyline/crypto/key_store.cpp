@@ -1,11 +1,13 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include <vfs/os_filesystem.h>
 #include "key_store.h"
 
 namespace skyline::crypto {
     KeyStore::KeyStore(const std::string &rootPath) {
+        TRACE_BOOT_PHASE(KeyLoading, "KeyStore::KeyStore");
         vfs::OsFileSystem root(rootPath);
         if (root.FileExists("title.keys"))
             ReadPairs(root.OpenFile("title.keys"), &KeyStore::PopulateTitleKeys);
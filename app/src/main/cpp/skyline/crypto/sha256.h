@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::crypto {
+    /**
+     * @brief SHA-256 hashing using the ARMv8 Cryptography Extensions (SHA256H/SHA256H2/SHA256SU0/SHA256SU1) when they're supported, Mbed TLS is used as a fallback otherwise
+     */
+    class Sha256 {
+      public:
+        static constexpr size_t DigestSize{0x20};
+        using Digest = std::array<u8, DigestSize>;
+
+        /**
+         * @return If the host CPU supports the SHA-256 instructions from the ARMv8 Cryptography Extensions
+         */
+        static bool IsHardwareSupported();
+
+        /**
+         * @return The SHA-256 digest of the supplied data
+         */
+        static Digest Hash(span<const u8> data);
+    };
+}
@@ -22,7 +22,7 @@ namespace skyline::gpu {
         #endif
 
         auto instanceLayers{context.enumerateInstanceLayerProperties()};
-        if (Logger::configLevel >= Logger::LogLevel::Debug) {
+        if (Logger::IsEnabled(Logger::LogLevel::Debug)) {
             std::string layers;
             for (const auto &instanceLayer : instanceLayers)
                 layers += util::Format("\n* {} (Sv{}.{}.{}, Iv{}.{}.{}) - {}", instanceLayer.layerName, VK_VERSION_MAJOR(instanceLayer.specVersion), VK_VERSION_MINOR(instanceLayer.specVersion), VK_VERSION_PATCH(instanceLayer.specVersion), VK_VERSION_MAJOR(instanceLayer.implementationVersion), VK_VERSION_MINOR(instanceLayer.implementationVersion), VK_VERSION_PATCH(instanceLayer.implementationVersion), instanceLayer.description);
@@ -43,7 +43,7 @@ namespace skyline::gpu {
         };
 
         auto instanceExtensions{context.enumerateInstanceExtensionProperties()};
-        if (Logger::configLevel >= Logger::LogLevel::Debug) {
+        if (Logger::IsEnabled(Logger::LogLevel::Debug)) {
             std::string extensions;
             for (const auto &instanceExtension : instanceExtensions)
                 extensions += util::Format("\n* {} (v{}.{}.{})", instanceExtension.extensionName, VK_VERSION_MAJOR(instanceExtension.specVersion), VK_VERSION_MINOR(instanceExtension.specVersion), VK_VERSION_PATCH(instanceExtension.specVersion));
@@ -119,7 +119,7 @@ namespace skyline::gpu {
         return std::move(vk::raii::PhysicalDevices(instance).front()); // We just select the first device as we aren't expecting multiple GPUs
     }
 
-    vk::raii::Device GPU::CreateDevice(const vk::raii::PhysicalDevice &physicalDevice, typeof(vk::DeviceQueueCreateInfo::queueCount) &vkQueueFamilyIndex) {
+    vk::raii::Device GPU::CreateDevice(const vk::raii::PhysicalDevice &physicalDevice, typeof(vk::DeviceQueueCreateInfo::queueCount) &vkQueueFamilyIndex, u32 &vkTransferQueueFamilyIndex, bool &supportsTimelineSemaphore, bool &supportsPushDescriptors, bool &supportsDisplayTiming, bool &supportsMemoryBudget, bool &supportsConditionalRendering) {
         auto properties{physicalDevice.getProperties()}; // We should check for required properties here, if/when we have them
 
         // auto features{physicalDevice.getFeatures()}; // Same as above
@@ -135,9 +135,51 @@ namespace skyline::gpu {
                 throw exception("Cannot find Vulkan device extension: \"{}\"", requiredExtension);
         }
 
+        std::vector<const char *> enabledDeviceExtensions(requiredDeviceExtensions.begin(), requiredDeviceExtensions.end());
+
+        vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR, vk::PhysicalDeviceConditionalRenderingFeaturesEXT> enabledFeatures{};
+        enabledFeatures.get<vk::PhysicalDeviceFeatures2>().features.occlusionQueryPrecise = physicalDevice.getFeatures().occlusionQueryPrecise; // Guest sample counters are exact, the host only counts exactly with this
+        supportsTimelineSemaphore = std::any_of(deviceExtensions.begin(), deviceExtensions.end(), [](const vk::ExtensionProperties &deviceExtension) {
+            return std::string_view(deviceExtension.extensionName) == std::string_view(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        }) && physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>().get<vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>().timelineSemaphore;
+        if (supportsTimelineSemaphore) {
+            enabledDeviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            enabledFeatures.get<vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>().timelineSemaphore = true;
+        } else {
+            enabledFeatures.unlink<vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>();
+        }
+
+        supportsPushDescriptors = std::any_of(deviceExtensions.begin(), deviceExtensions.end(), [](const vk::ExtensionProperties &deviceExtension) {
+            return std::string_view(deviceExtension.extensionName) == std::string_view(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        });
+        if (supportsPushDescriptors)
+            enabledDeviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+        supportsDisplayTiming = std::any_of(deviceExtensions.begin(), deviceExtensions.end(), [](const vk::ExtensionProperties &deviceExtension) {
+            return std::string_view(deviceExtension.extensionName) == std::string_view(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+        });
+        if (supportsDisplayTiming)
+            enabledDeviceExtensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+
+        supportsMemoryBudget = std::any_of(deviceExtensions.begin(), deviceExtensions.end(), [](const vk::ExtensionProperties &deviceExtension) {
+            return std::string_view(deviceExtension.extensionName) == std::string_view(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        });
+        if (supportsMemoryBudget)
+            enabledDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+        supportsConditionalRendering = std::any_of(deviceExtensions.begin(), deviceExtensions.end(), [](const vk::ExtensionProperties &deviceExtension) {
+            return std::string_view(deviceExtension.extensionName) == std::string_view(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+        }) && physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceConditionalRenderingFeaturesEXT>().get<vk::PhysicalDeviceConditionalRenderingFeaturesEXT>().conditionalRendering;
+        if (supportsConditionalRendering) {
+            enabledDeviceExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+            enabledFeatures.get<vk::PhysicalDeviceConditionalRenderingFeaturesEXT>().conditionalRendering = true;
+        } else {
+            enabledFeatures.unlink<vk::PhysicalDeviceConditionalRenderingFeaturesEXT>();
+        }
+
         auto queueFamilies{physicalDevice.getQueueFamilyProperties()};
-        float queuePriority{1.0f}; //!< The priority of the only queue we use, it's set to the maximum of 1.0
-        vk::DeviceQueueCreateInfo queue{[&] {
+        float queuePriority{1.0f}; //!< The priority of all queues we use, it's set to the maximum of 1.0
+        std::vector<vk::DeviceQueueCreateInfo> queues{[&] {
             typeof(vk::DeviceQueueCreateInfo::queueFamilyIndex) index{};
             for (const auto &queueFamily : queueFamilies) {
                 if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics && queueFamily.queueFlags & vk::QueueFlagBits::eCompute) {
@@ -153,26 +195,46 @@ namespace skyline::gpu {
             throw exception("Cannot find a queue family with both eGraphics and eCompute bits set");
         }()};
 
-        if (Logger::configLevel >= Logger::LogLevel::Info) {
+        // A transfer-only queue family is backed by the copy engines of the GPU which can run uploads concurrently with rendering, waits across queues are only supported with a timeline semaphore
+        vkTransferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        if (supportsTimelineSemaphore) {
+            for (u32 index{}; index < queueFamilies.size(); index++) {
+                auto flags{queueFamilies[index].queueFlags};
+                if (flags & vk::QueueFlagBits::eTransfer && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+                    vkTransferQueueFamilyIndex = index;
+                    queues.push_back(vk::DeviceQueueCreateInfo{
+                        .queueFamilyIndex = index,
+                        .queueCount = 1,
+                        .pQueuePriorities = &queuePriority,
+                    });
+                    break;
+                }
+            }
+        }
+
+        if (Logger::IsEnabled(Logger::LogLevel::Info)) {
             std::string extensionString;
             for (const auto &extension : deviceExtensions)
                 extensionString += util::Format("\n* {} (v{}.{}.{})", extension.extensionName, VK_VERSION_MAJOR(extension.specVersion), VK_VERSION_MINOR(extension.specVersion), VK_VERSION_PATCH(extension.specVersion));
 
             std::string queueString;
             u32 familyIndex{};
-            for (const auto &queueFamily : queueFamilies)
-                queueString += util::Format("\n* {}x{}{}{}{}{}: TSB{} MIG({}x{}x{}){}", queueFamily.queueCount, queueFamily.queueFlags & vk::QueueFlagBits::eGraphics ? 'G' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eCompute ? 'C' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eTransfer ? 'T' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eSparseBinding ? 'S' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eProtected ? 'P' : '-', queueFamily.timestampValidBits, queueFamily.minImageTransferGranularity.width, queueFamily.minImageTransferGranularity.height, queueFamily.minImageTransferGranularity.depth, familyIndex++ == vkQueueFamilyIndex ? " <--" : "");
+            for (const auto &queueFamily : queueFamilies) {
+                queueString += util::Format("\n* {}x{}{}{}{}{}: TSB{} MIG({}x{}x{}){}", queueFamily.queueCount, queueFamily.queueFlags & vk::QueueFlagBits::eGraphics ? 'G' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eCompute ? 'C' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eTransfer ? 'T' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eSparseBinding ? 'S' : '-', queueFamily.queueFlags & vk::QueueFlagBits::eProtected ? 'P' : '-', queueFamily.timestampValidBits, queueFamily.minImageTransferGranularity.width, queueFamily.minImageTransferGranularity.height, queueFamily.minImageTransferGranularity.depth, familyIndex == vkQueueFamilyIndex ? " <--" : (familyIndex == vkTransferQueueFamilyIndex ? " <-- (Transfer)" : ""));
+                familyIndex++;
+            }
 
             Logger::Info("Vulkan Device:\nName: {}\nType: {}\nVulkan Version: {}.{}.{}\nDriver Version: {}.{}.{}\nQueues:{}\nExtensions:{}", properties.deviceName, vk::to_string(properties.deviceType), VK_VERSION_MAJOR(properties.apiVersion), VK_VERSION_MINOR(properties.apiVersion), VK_VERSION_PATCH(properties.apiVersion), VK_VERSION_MAJOR(properties.driverVersion), VK_VERSION_MINOR(properties.driverVersion), VK_VERSION_PATCH(properties.driverVersion), queueString, extensionString);
         }
 
         return vk::raii::Device(physicalDevice, vk::DeviceCreateInfo{
-            .queueCreateInfoCount = 1,
-            .pQueueCreateInfos = &queue,
-            .enabledExtensionCount = requiredDeviceExtensions.size(),
-            .ppEnabledExtensionNames = requiredDeviceExtensions.data(),
+            .pNext = &enabledFeatures.get<vk::PhysicalDeviceFeatures2>(),
+            .queueCreateInfoCount = static_cast<u32>(queues.size()),
+            .pQueueCreateInfos = queues.data(),
+            .enabledExtensionCount = static_cast<u32>(enabledDeviceExtensions.size()),
+            .ppEnabledExtensionNames = enabledDeviceExtensions.data(),
         });
     }
 
-    GPU::GPU(const DeviceState &state) : vkInstance(CreateInstance(state, vkContext)), vkDebugReportCallback(CreateDebugReportCallback(vkInstance)), vkPhysicalDevice(CreatePhysicalDevice(vkInstance)), vkDevice(CreateDevice(vkPhysicalDevice, vkQueueFamilyIndex)), vkQueue(vkDevice, vkQueueFamilyIndex, 0), memory(*this), scheduler(*this), presentation(state, *this), texture(*this) {}
+    GPU::GPU(const DeviceState &state) : vkInstance(CreateInstance(state, vkContext)), vkDebugReportCallback(CreateDebugReportCallback(vkInstance)), vkPhysicalDevice(CreatePhysicalDevice(vkInstance)), vkDevice(CreateDevice(vkPhysicalDevice, vkQueueFamilyIndex, vkTransferQueueFamilyIndex, supportsTimelineSemaphore, supportsPushDescriptors, supportsDisplayTiming, supportsMemoryBudget, supportsConditionalRendering)), vkQueue(vkDevice, vkQueueFamilyIndex, 0), vkTransferQueue(vkTransferQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED ? vk::raii::Queue(vkDevice, vkTransferQueueFamilyIndex, 0) : vk::raii::Queue(nullptr)), pipelineCache(*this), pipelineCompiler(state.settings->skipUncompiledDraws), shaderCache(*this), copyPool(CopyWorkerCount), memory(*this), descriptor(*this), swizzlePass(*this), formatConversionPass(*this), timestamps(*this, state.settings->perfStats || state.settings->frameSkip), scheduler(state, *this), presentation(state, *this), texture(*this, state.settings->resolutionScale, state.settings->textureDeduplication), buffer(*this), renderPassCache(*this), framebufferCache(*this) {}
 }
@@ -3,10 +3,23 @@
 
 #pragma once
 
+#include <common/thread_pool.h>
+#include <common/write_tracker.h>
 #include "gpu/memory_manager.h"
+#include "gpu/descriptor_allocator.h"
+#include "gpu/pipeline_cache.h"
+#include "gpu/pipeline_compiler.h"
+#include "gpu/shader_cache.h"
+#include "gpu/timestamp_tracer.h"
 #include "gpu/command_scheduler.h"
 #include "gpu/presentation_engine.h"
 #include "gpu/texture_manager.h"
+#include "gpu/buffer_manager.h"
+#include "gpu/texture/swizzle_pass.h"
+#include "gpu/texture/format_conversion_pass.h"
+#include "gpu/texture/decode_cache.h"
+#include "gpu/render_pass_cache.h"
+#include "gpu/framebuffer_cache.h"
 
 namespace skyline::gpu {
     /**
@@ -22,7 +35,15 @@ namespace skyline::gpu {
 
         static vk::raii::PhysicalDevice CreatePhysicalDevice(const vk::raii::Instance &instance);
 
-        static vk::raii::Device CreateDevice(const vk::raii::PhysicalDevice &physicalDevice, typeof(vk::DeviceQueueCreateInfo::queueCount)& queueConfiguration);
+        /**
+         * @param vkTransferQueueFamilyIndex Set to the index of a dedicated transfer queue family if one was found and a queue from it has been created on the device, this is VK_QUEUE_FAMILY_IGNORED otherwise
+         * @param supportsTimelineSemaphore Set to if VK_KHR_timeline_semaphore was supported and has been enabled on the device
+         * @param supportsPushDescriptors Set to if VK_KHR_push_descriptor was supported and has been enabled on the device
+         * @param supportsDisplayTiming Set to if VK_GOOGLE_display_timing was supported and has been enabled on the device
+         * @param supportsMemoryBudget Set to if VK_EXT_memory_budget was supported and has been enabled on the device
+         * @param supportsConditionalRendering Set to if VK_EXT_conditional_rendering was supported and has been enabled on the device
+         */
+        static vk::raii::Device CreateDevice(const vk::raii::PhysicalDevice &physicalDevice, typeof(vk::DeviceQueueCreateInfo::queueCount)& queueConfiguration, u32 &vkTransferQueueFamilyIndex, bool &supportsTimelineSemaphore, bool &supportsPushDescriptors, bool &supportsDisplayTiming, bool &supportsMemoryBudget, bool &supportsConditionalRendering);
 
       public:
         static constexpr u32 VkApiVersion{VK_API_VERSION_1_1}; //!< The version of core Vulkan that we require
@@ -32,15 +53,40 @@ namespace skyline::gpu {
         vk::raii::DebugReportCallbackEXT vkDebugReportCallback; //!< An RAII Vulkan debug report manager which calls into 'GPU::DebugCallback'
         vk::raii::PhysicalDevice vkPhysicalDevice;
         u32 vkQueueFamilyIndex{};
+        u32 vkTransferQueueFamilyIndex{VK_QUEUE_FAMILY_IGNORED}; //!< The family of a queue which only supports transfers, this is VK_QUEUE_FAMILY_IGNORED if the device doesn't have one or it can't be used
+        bool supportsTimelineSemaphore{}; //!< If VK_KHR_timeline_semaphore is enabled on the device, submissions are pipelined through a timeline semaphore when this is the case
+        bool supportsPushDescriptors{}; //!< If VK_KHR_push_descriptor is enabled on the device, descriptors are pushed into command buffers rather than allocated when this is the case
+        bool supportsDisplayTiming{}; //!< If VK_GOOGLE_display_timing is enabled on the device, paced frames are presented with a desired present time and their timings are read back when this is the case
+        bool supportsMemoryBudget{}; //!< If VK_EXT_memory_budget is enabled on the device, the memory budget is queried from the driver rather than estimated by VMA when this is the case
+        bool supportsConditionalRendering{}; //!< If VK_EXT_conditional_rendering is enabled on the device, guest render conditions on pending query results are evaluated on the GPU when this is the case
         vk::raii::Device vkDevice;
         std::mutex queueMutex; //!< Synchronizes access to the queue as it is externally synchronized
         vk::raii::Queue vkQueue; //!< A Vulkan Queue supporting graphics and compute operations
+        std::mutex transferQueueMutex; //!< Synchronizes access to the transfer queue
+        vk::raii::Queue vkTransferQueue; //!< A Vulkan Queue which only supports transfers, uploads submitted to it can execute concurrently with work on the graphics queue, this is null without a dedicated transfer queue family
+        PipelineCache pipelineCache; //!< This must be constructed prior to anything creating pipelines as they should all be created with it
+        PipelineCompiler pipelineCompiler; //!< This must be destroyed prior to the pipeline cache as compile requests may still be in flight
+        ShaderCache shaderCache;
+
+        WriteTracker writeTracker; //!< This must outlive all textures as their traps reference it
+
+        static constexpr size_t CopyWorkerCount{3}; //!< The amount of workers in the copy pool, this is kept small as the guest's own threads are competing for the same cores
+        ThreadPool copyPool; //!< A pool for splitting CPU texture (de)swizzling of large textures across threads, this must outlive the scheduler as fence cycles may copy textures back to the guest on destruction
 
         memory::MemoryManager memory;
+        DescriptorAllocator descriptor; //!< This must outlive the scheduler as pools are recycled when the fence cycles they're attached to are destroyed
+        TextureDecodeCache decodeCache;
+        SwizzlePass swizzlePass;
+        FormatConversionPass formatConversionPass;
+        TimestampTracer timestamps; //!< This must outlive the scheduler as query sets are resolved when the fence cycles they're attached to are destroyed
         CommandScheduler scheduler;
         PresentationEngine presentation;
 
         TextureManager texture;
+        BufferManager buffer;
+
+        RenderPassCache renderPassCache;
+        FramebufferCache framebufferCache;
 
         GPU(const DeviceState &state);
     };
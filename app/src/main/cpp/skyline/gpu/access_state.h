@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vulkan/vulkan_raii.hpp>
+#include <common.h>
+
+namespace skyline::gpu {
+    /**
+     * @brief A pipeline barrier which the dependencies of several accesses are merged into, this is recorded as a single global memory barrier as that's no more expensive than several buffer or image barriers on most implementations
+     */
+    struct PipelineBarrier {
+        vk::PipelineStageFlags srcStages;
+        vk::PipelineStageFlags dstStages;
+        vk::AccessFlags srcAccess;
+        vk::AccessFlags dstAccess;
+
+        /**
+         * @return If any dependency has been merged into the barrier
+         */
+        explicit operator bool() const {
+            return static_cast<bool>(dstStages);
+        }
+
+        void Record(const vk::raii::CommandBuffer &commandBuffer) const {
+            commandBuffer.pipelineBarrier(srcStages, dstStages, {}, vk::MemoryBarrier{
+                .srcAccessMask = srcAccess,
+                .dstAccessMask = dstAccess,
+            }, {}, {});
+        }
+    };
+
+    /**
+     * @brief The accesses of the GPU to a resource which any subsequent access needs to be synchronized with, this is used to only emit barriers between accesses that actually conflict
+     * @note Reads are only synchronized with the last write while writes are synchronized with all reads since it and the last write itself
+     */
+    struct AccessState {
+        static constexpr vk::AccessFlags WriteAccess{vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eHostWrite | vk::AccessFlagBits::eMemoryWrite};
+
+        vk::PipelineStageFlags writeStages; //!< The stages of the last write, this is empty if the resource hasn't been written to
+        vk::AccessFlags writeAccess;
+        vk::PipelineStageFlags visibleStages; //!< The stages that the last write has been made visible to, reads from these don't require another barrier
+        vk::AccessFlags visibleAccess;
+        vk::PipelineStageFlags readStages; //!< The stages which have read from the resource since the last write, a subsequent write needs an execution dependency on these
+        u64 renderPassIndex{}; //!< The index of the render pass that the last access was in, accesses inside the same render pass are synchronized by its subpass dependencies instead
+
+        /**
+         * @brief Accounts for an access to the resource, any dependency required to synchronize it with prior accesses is merged into the supplied barrier
+         * @note Accesses which both read and write are treated as writes, the dependency on the last write covers the read
+         */
+        void Access(PipelineBarrier &barrier, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+            if (access & WriteAccess) {
+                if (readStages) {
+                    // Write-after-read hazards only need an execution dependency as there's nothing to make available
+                    barrier.srcStages |= readStages;
+                    barrier.dstStages |= stages;
+                }
+
+                if (writeStages) {
+                    barrier.srcStages |= writeStages;
+                    barrier.srcAccess |= writeAccess;
+                    barrier.dstStages |= stages;
+                    barrier.dstAccess |= access;
+                }
+
+                writeStages = stages;
+                writeAccess = access & WriteAccess;
+                visibleStages = {};
+                visibleAccess = {};
+                readStages = {};
+            } else {
+                if (writeStages && ((stages & ~visibleStages) || (access & ~visibleAccess))) {
+                    barrier.srcStages |= writeStages;
+                    barrier.srcAccess |= writeAccess;
+                    barrier.dstStages |= stages;
+                    barrier.dstAccess |= access;
+
+                    visibleStages |= stages;
+                    visibleAccess |= access;
+                }
+
+                readStages |= stages;
+            }
+        }
+    };
+}
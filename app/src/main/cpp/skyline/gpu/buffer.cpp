@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include "buffer.h"
+
+namespace skyline::gpu {
+    Buffer::Buffer(GPU &gpu, span<u8> pGuest) : gpu(gpu), backing(gpu.memory.AllocateBuffer(pGuest.size())), guest(pGuest) {
+        if (!util::IsAligned(guest.data(), PAGE_SIZE) || !util::IsAligned(guest.size(), PAGE_SIZE))
+            throw exception("Guest buffer isn't page-aligned: 0x{:X} (0x{:X} bytes)", reinterpret_cast<u64>(guest.data()), guest.size());
+
+        // The protection of the buffer is only queried once for all of its pages as querying it is expensive
+        auto permission{WriteTracker::QueryPermission(guest)};
+        pageTraps.reserve(guest.size() / PAGE_SIZE);
+        for (auto page{guest.data()}; page < guest.data() + guest.size(); page += PAGE_SIZE)
+            pageTraps.push_back(gpu.writeTracker.CreateTrap(span<u8>{page, PAGE_SIZE}, false, permission)); // All traps start off dirty so the entire buffer is uploaded on the first synchronization
+    }
+
+    bool Buffer::IsDirty() {
+        return std::any_of(pageTraps.begin(), pageTraps.end(), [](const std::shared_ptr<WriteTracker::Trap> &trap) {
+            return trap->dirty.load(std::memory_order_acquire);
+        });
+    }
+
+    bool Buffer::IsDirty(vk::DeviceSize offset, vk::DeviceSize size) {
+        auto first{pageTraps.begin() + static_cast<ssize_t>(offset / PAGE_SIZE)}, last{pageTraps.begin() + static_cast<ssize_t>(util::AlignUp(offset + size, PAGE_SIZE) / PAGE_SIZE)};
+        return std::any_of(first, last, [](const std::shared_ptr<WriteTracker::Trap> &trap) {
+            return trap->dirty.load(std::memory_order_acquire);
+        });
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Buffer::RecordUploads(const vk::raii::CommandBuffer &commandBuffer) {
+        // We coalesce contiguous dirty pages into a single copy region, this keeps the amount of regions low for sequential writes
+        std::vector<std::pair<size_t, size_t>> runs; //!< The index of the first page and the page count of all runs of dirty pages
+        size_t dirtyPages{};
+        for (size_t index{}; index < pageTraps.size(); index++) {
+            if (!pageTraps[index]->dirty.load(std::memory_order_acquire))
+                continue;
+
+            if (!runs.empty() && runs.back().first + runs.back().second == index)
+                runs.back().second++;
+            else
+                runs.emplace_back(index, 1);
+            dirtyPages++;
+        }
+
+        if (runs.empty())
+            return nullptr;
+
+        auto stagingBuffer{gpu.memory.AllocateRingStagingBuffer(dirtyPages * PAGE_SIZE)};
+        std::vector<vk::BufferCopy> copies;
+        copies.reserve(runs.size());
+        vk::DeviceSize stagingOffset{};
+        for (auto [firstPage, pageCount] : runs) {
+            // The traps must be protected before the guest buffer is read from, any writes during the read will dirty them again
+            for (size_t index{firstPage}; index < firstPage + pageCount; index++)
+                gpu.writeTracker.Protect(*pageTraps[index]);
+
+            auto offset{firstPage * PAGE_SIZE}, size{pageCount * PAGE_SIZE};
+            std::memcpy(stagingBuffer->data() + stagingOffset, guest.data() + offset, size);
+            copies.push_back(vk::BufferCopy{
+                .srcOffset = stagingBuffer->offset + stagingOffset,
+                .dstOffset = offset,
+                .size = size,
+            });
+            stagingOffset += size;
+        }
+
+        RecordCopies(commandBuffer, stagingBuffer->vkBuffer, copies);
+        generation.fetch_add(1, std::memory_order_release);
+        return stagingBuffer;
+    }
+
+    void Buffer::RecordCopies(const vk::raii::CommandBuffer &commandBuffer, vk::Buffer source, span<const vk::BufferCopy> copies) {
+        commandBuffer.copyBuffer(source, backing.vkBuffer, vk::ArrayProxy<const vk::BufferCopy>(static_cast<u32>(copies.size()), copies.data()));
+    }
+
+    void Buffer::SynchronizeHost() {
+        TRACE_EVENT("gpu", "Buffer::SynchronizeHost");
+
+        if (!IsDirty())
+            return;
+
+        std::shared_ptr<memory::StagingBuffer> stagingBuffer;
+        auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &) {
+            // This submission isn't tracked by the CommandExecutor, the uploads are conservatively ordered after any prior reads and before any subsequent reads of the buffer
+            constexpr vk::PipelineStageFlags ReadStages{vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer};
+            commandBuffer.pipelineBarrier(ReadStages, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {});
+
+            stagingBuffer = RecordUploads(commandBuffer);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, ReadStages, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead,
+            }, {}, {});
+        })};
+        if (stagingBuffer)
+            lCycle->AttachObject(stagingBuffer);
+        lCycle->AttachObject(shared_from_this());
+        cycle = lCycle;
+    }
+
+    void Buffer::SynchronizeHostWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
+        TRACE_EVENT("gpu", "Buffer::SynchronizeHostWithBuffer");
+
+        auto stagingBuffer{RecordUploads(commandBuffer)};
+        if (stagingBuffer) {
+            pCycle->AttachObjects(stagingBuffer, shared_from_this());
+            cycle = pCycle;
+        }
+    }
+
+    void Buffer::RecordInlineWrite(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, vk::DeviceSize offset) {
+        if (offset + stagingBuffer->size() > guest.size())
+            throw exception("Inline write out of bounds: 0x{:X} + 0x{:X} (Size: 0x{:X})", offset, stagingBuffer->size(), guest.size());
+
+        vk::BufferCopy copy{
+            .srcOffset = stagingBuffer->offset,
+            .dstOffset = offset,
+            .size = stagingBuffer->size(),
+        };
+        RecordCopies(commandBuffer, stagingBuffer->vkBuffer, span<const vk::BufferCopy>(&copy, 1));
+        generation.fetch_add(1, std::memory_order_release);
+        pCycle->AttachObjects(stagingBuffer, shared_from_this());
+        cycle = pCycle;
+    }
+
+    void Buffer::RecordCopy(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const BufferView &source, vk::DeviceSize offset) {
+        if (offset + source.size > guest.size())
+            throw exception("Buffer copy out of bounds: 0x{:X} + 0x{:X} (Size: 0x{:X})", offset, source.size, guest.size());
+
+        vk::BufferCopy copy{
+            .srcOffset = source.offset,
+            .dstOffset = offset,
+            .size = source.size,
+        };
+        RecordCopies(commandBuffer, source.buffer->backing.vkBuffer, span<const vk::BufferCopy>(&copy, 1));
+        generation.fetch_add(1, std::memory_order_release);
+        pCycle->AttachObjects(source.buffer, shared_from_this());
+        source.buffer->cycle = pCycle;
+        cycle = pCycle;
+    }
+}
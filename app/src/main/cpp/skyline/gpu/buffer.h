@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/write_tracker.h>
+#include "memory_manager.h"
+#include "access_state.h"
+
+namespace skyline::gpu {
+    class GPU;
+    class BufferManager;
+    struct BufferView;
+
+    /**
+     * @brief A buffer which is backed by a device-local host buffer while being synchronized with a contiguous range of guest memory
+     * @note Every page of the guest buffer is tracked for CPU writes individually so only pages which were written to are uploaded again, this is what makes re-uploading large vertex or constant buffers cheap
+     * @note Guest writes are only propagated from the CPU to the GPU, any writes to the buffer on the host GPU aren't synchronized back to the guest
+     * @note This class conforms to the Lockable and BasicLockable C++ named requirements
+     */
+    class Buffer : public std::enable_shared_from_this<Buffer>, public FenceCycleDependency {
+      private:
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes any mutations to the buffer or its backing
+        memory::Buffer backing;
+        std::vector<std::shared_ptr<WriteTracker::Trap>> pageTraps; //!< A trap for each page of the guest buffer in order
+
+        friend BufferManager;
+
+        /**
+         * @brief Copies all runs of contiguous dirty pages into a single staging buffer and records copies of them into the backing
+         * @return The staging buffer which must be attached to the cycle the commands are submitted with, this is null when no pages were dirty
+         */
+        std::shared_ptr<memory::StagingBuffer> RecordUploads(const vk::raii::CommandBuffer &commandBuffer);
+
+        /**
+         * @brief Records copies from the source buffer into the backing
+         * @note No barriers are recorded by this, the caller is responsible for synchronizing the copies with other accesses to the backing
+         */
+        void RecordCopies(const vk::raii::CommandBuffer &commandBuffer, vk::Buffer source, span<const vk::BufferCopy> copies);
+
+      public:
+        span<u8> guest; //!< The page-aligned CPU mapping of the guest buffer
+        std::weak_ptr<FenceCycle> cycle; //!< A fence cycle for when any host operation mutating the buffer has completed
+        AccessState accessState; //!< The GPU accesses to the buffer from nodes in the command stream, this is only used by the CommandExecutor
+        std::atomic<u64> generation{}; //!< A counter which is incremented whenever the contents of the backing are changed, derived data such as conversions is only valid for the generation it was created from
+
+        Buffer(GPU &gpu, span<u8> guest);
+
+        vk::Buffer GetBacking() const {
+            return backing.vkBuffer;
+        }
+
+        /**
+         * @brief Acquires an exclusive lock on the buffer for the calling thread
+         * @note Naming is in accordance to the BasicLockable named requirement
+         */
+        void lock() {
+            mutex.lock();
+        }
+
+        /**
+         * @brief Relinquishes an existing lock on the buffer by the calling thread
+         * @note Naming is in accordance to the BasicLockable named requirement
+         */
+        void unlock() {
+            mutex.unlock();
+        }
+
+        /**
+         * @brief Attempts to acquire an exclusive lock but returns immediately if it's captured by another thread
+         * @note Naming is in accordance to the Lockable named requirement
+         */
+        bool try_lock() {
+            return mutex.try_lock();
+        }
+
+        /**
+         * @return If any page of the guest buffer has been written to since it was last synchronized
+         */
+        bool IsDirty();
+
+        /**
+         * @return If any page overlapping the supplied range of the guest buffer has been written to since it was last synchronized
+         */
+        bool IsDirty(vk::DeviceSize offset, vk::DeviceSize size);
+
+        /**
+         * @brief Synchronizes the host buffer with the guest by uploading all dirty pages in a separate submission
+         * @note The buffer **must** be locked prior to calling this
+         */
+        void SynchronizeHost();
+
+        /**
+         * @brief Synchronizes the host buffer with the guest by recording uploads of all dirty pages into the supplied command buffer
+         * @note This must not be recorded inside a render pass as it includes transfers, they must be synchronized with other accesses by the caller
+         * @note The buffer **must** be locked prior to calling this
+         */
+        void SynchronizeHostWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle);
+
+        /**
+         * @brief Records a copy of data that the GPU wrote to the guest buffer from the supplied staging buffer into the backing, the write must be synchronized with other GPU accesses by the caller
+         * @note The guest buffer must already contain the data, the pages it dirtied are uploaded again on the next synchronization which is recorded prior to this and is overwritten by it
+         * @note This must not be recorded inside a render pass as it includes transfers
+         * @note The buffer **must** be locked prior to calling this
+         */
+        void RecordInlineWrite(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, vk::DeviceSize offset);
+
+        /**
+         * @brief Records a copy of a range of another buffer's backing into the backing, the copy must be synchronized with other GPU accesses of either buffer by the caller
+         * @param offset The offset into this buffer that the contents of the view are copied to
+         * @note The guest buffer should already contain the copied data as the copy isn't synchronized back to it
+         * @note This must not be recorded inside a render pass as it includes transfers
+         * @note Both buffers **must** be locked prior to calling this
+         */
+        void RecordCopy(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const BufferView &source, vk::DeviceSize offset);
+    };
+
+    /**
+     * @brief A view into a range of a Buffer which corresponds to a range of guest memory
+     */
+    struct BufferView {
+        std::shared_ptr<Buffer> buffer;
+        vk::DeviceSize offset; //!< The offset of the view into the buffer
+        vk::DeviceSize size;
+    };
+}
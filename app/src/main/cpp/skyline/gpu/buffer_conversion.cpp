@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include "buffer_conversion.h"
+
+namespace skyline::gpu {
+    namespace {
+        constexpr u32 BufferConversionSpirv[]{
+            #include "buffer_conversion.comp.spv.inc"
+        };
+
+        constexpr std::array<u32, 6> QuadCorners{0, 1, 2, 0, 2, 3}; //!< The corners of a quad which make up its two triangles
+
+        /**
+         * @return The amount of vertices in a source of the supplied size, this accounts for the last vertex not being padded to the stride
+         */
+        u32 GetVertexCount(vk::DeviceSize sourceSize, u32 stride, u32 vertexSize) {
+            return sourceSize >= vertexSize ? static_cast<u32>((sourceSize - vertexSize) / stride + 1) : 0;
+        }
+    }
+
+    u32 BufferConversion::GetOutputWords(vk::DeviceSize sourceSize) const {
+        switch (type) {
+            case Type::IndicesU8ToU16:
+                return static_cast<u32>(util::AlignUp(sourceSize * sizeof(u16), sizeof(u32)) / sizeof(u32));
+            case Type::QuadIndicesU8:
+                return static_cast<u32>(sourceSize / 4) * 3; // Every quad is 6 u16 indices
+            case Type::QuadIndicesU16:
+                return static_cast<u32>(sourceSize / (4 * sizeof(u16))) * 3;
+            case Type::QuadIndicesU32:
+                return static_cast<u32>(sourceSize / (4 * sizeof(u32))) * 6;
+            case Type::Vertex3x8To4x8:
+                return GetVertexCount(sourceSize, stride, 3);
+            case Type::Vertex3x16To4x16:
+                return GetVertexCount(sourceSize, stride, 3 * sizeof(u16)) * 2;
+        }
+        throw exception("Unknown buffer conversion: {}", static_cast<u32>(type));
+    }
+
+    BufferConversionPass::BufferConversionPass(GPU &gpu) : gpu(gpu),
+        descriptorSetLayout(gpu.descriptor.CreateSetLayout([] {
+            constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> bindings{
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 1,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+            };
+            return span<const vk::DescriptorSetLayoutBinding>(bindings);
+        }())),
+        pipelineLayout(gpu.vkDevice, [this] {
+            constexpr static vk::PushConstantRange pushConstantRange{
+                .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                .size = sizeof(PushConstants),
+            };
+            return vk::PipelineLayoutCreateInfo{
+                .setLayoutCount = 1,
+                .pSetLayouts = &*descriptorSetLayout.vkLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+        }()),
+        shaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(BufferConversionSpirv),
+            .pCode = BufferConversionSpirv,
+        }),
+        pipeline(gpu.vkDevice, gpu.pipelineCache.vkPipelineCache, vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = *shaderModule,
+                .pName = "main",
+            },
+            .layout = *pipelineLayout,
+        }) {}
+
+    void BufferConversionPass::ConvertOnCpu(const BufferConversion &conversion, span<const u8> source, span<u32> output) {
+        TRACE_EVENT("gpu", "BufferConversionPass::ConvertOnCpu");
+
+        // Reads past the end of the source are zero, this matches the shader and covers the padding of the last word
+        auto readByte{[&](size_t offset) -> u32 {
+            return offset < source.size() ? source[offset] : 0;
+        }};
+        auto readHalf{[&](size_t offset) {
+            return readByte(offset) | (readByte(offset + 1) << 8);
+        }};
+        auto readIndex{[&](size_t index, size_t indexSize) {
+            size_t offset{index * indexSize};
+            if (indexSize == sizeof(u8))
+                return readByte(offset);
+            else if (indexSize == sizeof(u16))
+                return readHalf(offset);
+            return readHalf(offset) | (readHalf(offset + 2) << 16);
+        }};
+        auto readQuadIndex{[&](size_t element, size_t indexSize) {
+            return readIndex((element / 6) * 4 + QuadCorners[element % 6], indexSize);
+        }};
+
+        using Type = BufferConversion::Type;
+        for (size_t word{}; word < output.size(); word++) {
+            switch (conversion.type) {
+                case Type::IndicesU8ToU16:
+                    output[word] = readByte(word * 2) | (readByte(word * 2 + 1) << 16);
+                    break;
+
+                case Type::QuadIndicesU8:
+                case Type::QuadIndicesU16: {
+                    size_t indexSize{conversion.type == Type::QuadIndicesU8 ? sizeof(u8) : sizeof(u16)};
+                    output[word] = readQuadIndex(word * 2, indexSize) | (readQuadIndex(word * 2 + 1, indexSize) << 16);
+                    break;
+                }
+
+                case Type::QuadIndicesU32:
+                    output[word] = readQuadIndex(word, sizeof(u32));
+                    break;
+
+                case Type::Vertex3x8To4x8: {
+                    size_t offset{word * conversion.stride};
+                    output[word] = readByte(offset) | (readByte(offset + 1) << 8) | (readByte(offset + 2) << 16) | (conversion.padding << 24);
+                    break;
+                }
+
+                case Type::Vertex3x16To4x16: {
+                    size_t offset{(word / 2) * conversion.stride};
+                    output[word] = (word % 2 == 0) ? (readHalf(offset) | (readHalf(offset + 2) << 16)) : (readHalf(offset + 4) | (conversion.padding << 16));
+                    break;
+                }
+            }
+        }
+    }
+
+    void BufferConversionPass::Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const BufferConversion &conversion, vk::Buffer source, vk::DeviceSize sourceBufferSize, vk::DeviceSize sourceOffset, vk::DeviceSize sourceSize, const ConvertedBuffer &output) {
+        TRACE_EVENT("gpu", "BufferConversionPass::Record");
+
+        PushConstants constants{
+            .type = conversion.type,
+            .sourceOffset = static_cast<u32>(sourceOffset),
+            .sourceSize = static_cast<u32>(sourceSize),
+            .stride = conversion.stride,
+            .padding = conversion.padding,
+            .outputSize = conversion.GetOutputWords(sourceSize),
+        };
+
+        // The entire source buffer is bound as guest data is rarely aligned to the storage buffer offset alignment, the shader offsets its reads instead
+        std::array<DescriptorAllocator::DescriptorInfo, 2> descriptors{
+            vk::DescriptorBufferInfo{
+                .buffer = source,
+                .offset = 0,
+                .range = sourceBufferSize,
+            },
+            vk::DescriptorBufferInfo{
+                .buffer = output.backing.vkBuffer,
+                .offset = 0,
+                .range = output.backing.size,
+            },
+        };
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        gpu.descriptor.Bind(commandBuffer, cycle, vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSetLayout, descriptors);
+        commandBuffer.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+        commandBuffer.dispatch(util::AlignUp(constants.outputSize, WorkgroupSize) / WorkgroupSize, 1, 1);
+    }
+}
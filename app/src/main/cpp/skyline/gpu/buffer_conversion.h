@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "memory_manager.h"
+#include "descriptor_allocator.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A conversion of guest index or vertex data into a layout which is supported by all host drivers
+     */
+    struct BufferConversion {
+        /**
+         * @note This must match the conversion types in buffer_conversion.comp
+         */
+        enum class Type : u32 {
+            IndicesU8ToU16, //!< Widens u8 indices to u16 as VK_EXT_index_type_uint8 isn't supported by most mobile drivers
+            QuadIndicesU8, //!< Splits every quad of u8 indices into two triangles of u16 indices
+            QuadIndicesU16, //!< Splits every quad of u16 indices into two triangles of u16 indices
+            QuadIndicesU32, //!< Splits every quad of u32 indices into two triangles of u32 indices
+            Vertex3x8To4x8, //!< Pads vertices with three 8-bit components to four components, three-component formats are rarely supported as vertex formats
+            Vertex3x16To4x16, //!< Pads vertices with three 16-bit components to four components
+        } type;
+        u32 stride{}; //!< The stride of the source vertices in bytes, this is only used by vertex conversions
+        u32 padding{}; //!< The value of the fourth component added by vertex conversions, this should be the equivalent of 1 in the format to match the defaults of Vulkan
+
+        constexpr bool operator==(const BufferConversion &) const = default;
+
+        /**
+         * @return The amount of 32-bit words in the output of the conversion of a source of the supplied size, the last word is padded with zeroes if required
+         */
+        u32 GetOutputWords(vk::DeviceSize sourceSize) const;
+    };
+
+    /**
+     * @brief A device-local buffer holding the output of a conversion of guest data
+     */
+    struct ConvertedBuffer : public FenceCycleDependency {
+        memory::Buffer backing;
+
+        ConvertedBuffer(memory::Buffer backing) : backing(std::move(backing)) {}
+    };
+
+    /**
+     * @brief A compute pass which performs buffer conversions on the GPU, this avoids reading large guest buffers on the CPU for every conversion
+     * @note This class is thread-safe as it can be recorded into command buffers from several threads
+     */
+    class BufferConversionPass {
+      private:
+        /**
+         * @note This must match the push constant block in buffer_conversion.comp
+         */
+        struct PushConstants {
+            BufferConversion::Type type;
+            u32 sourceOffset;
+            u32 sourceSize;
+            u32 stride;
+            u32 padding;
+            u32 outputSize;
+        };
+
+        static constexpr u32 WorkgroupSize{64}; //!< The amount of invocations in a workgroup, this must match 'local_size_x' in the shader
+
+        GPU &gpu;
+        DescriptorAllocator::SetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::ShaderModule shaderModule;
+        vk::raii::Pipeline pipeline;
+
+      public:
+        BufferConversionPass(GPU &gpu);
+
+        /**
+         * @brief Converts guest data on the CPU into the supplied output
+         * @param output A span which must be GetOutputWords words in size
+         */
+        static void ConvertOnCpu(const BufferConversion &conversion, span<const u8> source, span<u32> output);
+
+        /**
+         * @brief Records a conversion of a range of the source buffer into the output buffer
+         * @note No barriers are recorded by this, the caller is responsible for synchronizing the conversion with other accesses to either buffer
+         */
+        void Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const BufferConversion &conversion, vk::Buffer source, vk::DeviceSize sourceBufferSize, vk::DeviceSize sourceOffset, vk::DeviceSize sourceSize, const ConvertedBuffer &output);
+    };
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <gpu/interconnect/command_executor.h>
+#include "buffer_manager.h"
+
+namespace skyline::gpu {
+    BufferManager::BufferManager(GPU &gpu) : gpu(gpu), conversionPass(gpu) {}
+
+    std::optional<BufferView> BufferManager::Find(span<u8> guestMapping) {
+        // Any buffer which contains the guest mapping must overlap the region of its first byte, so we only need to check that bucket
+        auto region{regions.find(reinterpret_cast<u64>(guestMapping.data()) >> RegionBits)};
+        if (region == regions.end())
+            return std::nullopt;
+
+        for (auto &buffer : region->second)
+            if (buffer->guest.contains(guestMapping))
+                return BufferView{buffer, static_cast<vk::DeviceSize>(guestMapping.data() - buffer->guest.data()), guestMapping.size()};
+
+        return std::nullopt;
+    }
+
+    void BufferManager::Insert(const std::shared_ptr<Buffer> &buffer) {
+        auto start{reinterpret_cast<u64>(buffer->guest.data()) >> RegionBits}, end{(reinterpret_cast<u64>(buffer->guest.data()) + buffer->guest.size() - 1) >> RegionBits};
+        for (auto region{start}; region <= end; region++)
+            regions[region].push_back(buffer);
+    }
+
+    void BufferManager::Remove(const std::shared_ptr<Buffer> &buffer) {
+        auto start{reinterpret_cast<u64>(buffer->guest.data()) >> RegionBits}, end{(reinterpret_cast<u64>(buffer->guest.data()) + buffer->guest.size() - 1) >> RegionBits};
+        for (auto index{start}; index <= end; index++) {
+            auto region{regions.find(index)};
+            if (region == regions.end())
+                continue;
+
+            auto &buffers{region->second};
+            buffers.erase(std::remove(buffers.begin(), buffers.end(), buffer), buffers.end());
+            if (buffers.empty())
+                regions.erase(region);
+        }
+    }
+
+    std::optional<BufferView> BufferManager::Lookup(span<u8> guestMapping) {
+        std::shared_lock lock(mutex);
+        return Find(guestMapping);
+    }
+
+    BufferView BufferManager::FindOrCreate(span<u8> guestMapping) {
+        {
+            // Lookups are far more common than insertions so we first try to find a match with shared access, this allows concurrent lookups from several channels
+            std::shared_lock lock(mutex);
+            if (auto view{Find(guestMapping)})
+                return *view;
+        }
+
+        std::unique_lock lock(mutex);
+        if (auto view{Find(guestMapping)})
+            return *view; // Another thread may have created a matching buffer between us releasing the shared lock and acquiring exclusive access
+
+        // We extend the range to cover all buffers overlapping it, they're replaced by a single buffer so the index never contains overlapping buffers
+        auto start{util::AlignDown(guestMapping.data(), PAGE_SIZE)}, end{util::AlignUp(guestMapping.data() + guestMapping.size(), PAGE_SIZE)};
+        std::vector<std::shared_ptr<Buffer>> overlaps;
+        for (auto index{reinterpret_cast<u64>(start) >> RegionBits}; index <= (reinterpret_cast<u64>(end) - 1) >> RegionBits; index++) {
+            auto region{regions.find(index)};
+            if (region == regions.end())
+                continue;
+
+            for (auto &buffer : region->second) {
+                auto bufferEnd{buffer->guest.data() + buffer->guest.size()};
+                if (buffer->guest.data() < end && bufferEnd > start && std::find(overlaps.begin(), overlaps.end(), buffer) == overlaps.end()) {
+                    overlaps.push_back(buffer);
+                    start = std::min(start, buffer->guest.data());
+                    end = std::max(end, bufferEnd);
+                }
+            }
+        }
+
+        for (auto &overlap : overlaps)
+            Remove(overlap);
+
+        // The new buffer starts off entirely dirty so it doesn't need any contents of the overlapping buffers, they only contain guest data as host writes aren't supported
+        auto buffer{std::make_shared<Buffer>(gpu, span<u8>{start, static_cast<size_t>(end - start)})};
+        Insert(buffer);
+
+        return BufferView{buffer, static_cast<vk::DeviceSize>(guestMapping.data() - start), guestMapping.size()};
+    }
+
+    void BufferManager::PurgeConversions() {
+        for (auto it{conversions.begin()}; it != conversions.end();) {
+            auto source{it->second.source.lock()};
+            if (!source || source->generation.load(std::memory_order_acquire) != it->second.generation)
+                it = conversions.erase(it);
+            else
+                it++;
+        }
+
+        if (conversions.size() > MaxConversions)
+            conversions.clear(); // All conversions are still valid but we don't track their usage, clearing them bounds the memory they use
+    }
+
+    std::shared_ptr<ConvertedBuffer> BufferManager::GetConverted(interconnect::CommandExecutor &executor, const BufferView &source, const BufferConversion &conversion) {
+        auto outputWords{conversion.GetOutputWords(source.size)};
+        if (!outputWords)
+            throw exception("Conversion of 0x{:X} bytes has no output", source.size);
+
+        // The generation is read prior to the conversion so a concurrent upload of the source range can only cause a redundant conversion rather than a stale one
+        auto generation{source.buffer->generation.load(std::memory_order_acquire)};
+        ConversionKey key{source.buffer.get(), source.offset, source.size, conversion.type, conversion.stride, conversion.padding};
+        {
+            std::scoped_lock lock(conversionMutex);
+            auto it{conversions.find(key)};
+            if (it != conversions.end() && it->second.generation == generation && it->second.source.lock() == source.buffer && !source.buffer->IsDirty(source.offset, source.size))
+                return it->second.output;
+        }
+
+        auto output{std::make_shared<ConvertedBuffer>(gpu.memory.AllocateBuffer(outputWords * sizeof(u32)))};
+        constexpr vk::PipelineStageFlags ConsumerStages{vk::PipelineStageFlagBits::eVertexInput};
+        constexpr vk::AccessFlags ConsumerAccess{vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eVertexAttributeRead};
+        if (source.size >= GpuConversionThreshold) {
+            executor.AttachBuffer(source.buffer.get(), vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+            executor.AddOutsideRpCommand([this, conversion, source, output](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &) {
+                conversionPass.Record(commandBuffer, cycle, conversion, source.buffer->GetBacking(), source.buffer->guest.size(), source.offset, source.size, *output);
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, ConsumerStages, {}, vk::MemoryBarrier{
+                    .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                    .dstAccessMask = ConsumerAccess,
+                }, {}, {});
+                cycle->AttachObjects(source.buffer, output);
+            });
+        } else {
+            auto stagingBuffer{gpu.memory.AllocateRingStagingBuffer(output->backing.size)};
+            BufferConversionPass::ConvertOnCpu(conversion, source.buffer->guest.subspan(source.offset, source.size), stagingBuffer->cast<u32>());
+            executor.AddOutsideRpCommand([stagingBuffer, output](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &) {
+                commandBuffer.copyBuffer(stagingBuffer->vkBuffer, output->backing.vkBuffer, vk::BufferCopy{
+                    .srcOffset = stagingBuffer->offset,
+                    .size = output->backing.size,
+                });
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, ConsumerStages, {}, vk::MemoryBarrier{
+                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                    .dstAccessMask = ConsumerAccess,
+                }, {}, {});
+                cycle->AttachObjects(stagingBuffer, output);
+            });
+        }
+
+        std::scoped_lock lock(conversionMutex);
+        conversions.insert_or_assign(key, Conversion{source.buffer, generation, output});
+        if (conversions.size() > MaxConversions)
+            PurgeConversions();
+        return output;
+    }
+}
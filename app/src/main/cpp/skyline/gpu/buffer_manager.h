@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <shared_mutex>
+#include <map>
+#include "buffer.h"
+#include "buffer_conversion.h"
+
+namespace skyline::gpu {
+    namespace interconnect {
+        class CommandExecutor;
+    }
+
+    /**
+     * @brief The Buffer Manager is responsible for maintaining a global view of buffers being mapped from the guest to the host, any lookups and creation of host buffers from equivalent guest buffers alongside coalescing of any overlaps with existing buffers
+     * @note Buffers are looked up by their CPU mapping rather than their GPU virtual address as the manager is shared between all channels and their address spaces, the caller is responsible for translating addresses with the GMMU of its channel
+     * @note Conversions of ranges of buffers into layouts the host supports are cached by their source range and the generation of the source buffer, they're only redone once the guest has written to the range
+     */
+    class BufferManager {
+      private:
+        static constexpr size_t RegionBits{16}; //!< The log2 of the size of the regions that the address space is split into for indexing buffers, this is larger than a page to avoid large buffers occupying thousands of buckets
+        static constexpr size_t RegionSize{1ULL << RegionBits};
+
+        GPU &gpu;
+        std::shared_mutex mutex; //!< Synchronizes access to the buffer index, lookups only require shared access while insertions require exclusive access
+        std::unordered_map<u64, std::vector<std::shared_ptr<Buffer>>> regions; //!< A map from the index of a region to all buffers which overlap it, buffers never overlap each other as any overlaps are coalesced into a single buffer
+
+        static constexpr vk::DeviceSize GpuConversionThreshold{0x10000}; //!< The size of a source range in bytes from which it's converted on the GPU, smaller ranges are cheaper to convert on the CPU than to dispatch
+        static constexpr size_t MaxConversions{0x400}; //!< The amount of cached conversions after which stale ones are purged
+
+        /**
+         * @brief A cached conversion of a range of a buffer
+         */
+        struct Conversion {
+            std::weak_ptr<Buffer> source; //!< The source buffer, this is used to detect a different buffer being allocated at the address of a destroyed one
+            u64 generation; //!< The generation of the source buffer that the conversion was created from
+            std::shared_ptr<ConvertedBuffer> output;
+        };
+
+        using ConversionKey = std::tuple<Buffer *, vk::DeviceSize, vk::DeviceSize, BufferConversion::Type, u32, u32>; //!< The source buffer and range alongside the parameters of the conversion
+
+        BufferConversionPass conversionPass;
+        std::mutex conversionMutex; //!< Synchronizes access to the cached conversions
+        std::map<ConversionKey, Conversion> conversions;
+
+        /**
+         * @brief Erases all conversions of destroyed buffers or outdated generations
+         * @note The conversion mutex must be locked
+         */
+        void PurgeConversions();
+
+        /**
+         * @return A view of a pre-existing buffer which contains the entire guest range, or nothing if there is none
+         * @note The mutex must be locked, shared locking is sufficient
+         */
+        std::optional<BufferView> Find(span<u8> guestMapping);
+
+        /**
+         * @brief Inserts or removes a buffer from the buckets of all regions it overlaps
+         * @note The mutex must be locked exclusively
+         */
+        void Insert(const std::shared_ptr<Buffer> &buffer);
+
+        void Remove(const std::shared_ptr<Buffer> &buffer);
+
+      public:
+        BufferManager(GPU &gpu);
+
+        /**
+         * @return A view of a pre-existing buffer which contains the supplied guest range, or nothing if no buffer has been created for it
+         * @note This never creates a buffer, it's used by writes which only need to be mirrored into buffers that already exist
+         */
+        std::optional<BufferView> Lookup(span<u8> guestMapping);
+
+        /**
+         * @return A view of a pre-existing or newly created buffer which contains the supplied contiguous guest range
+         * @note Any existing buffers which partially overlap the range are replaced by a single buffer covering all of them, views of the replaced buffers remain valid but won't be synchronized with the guest anymore
+         */
+        BufferView FindOrCreate(span<u8> guestMapping);
+
+        /**
+         * @return A buffer holding the supplied range converted with the supplied conversion, a cached conversion is returned if the range hasn't changed since it was created
+         * @note The conversion is recorded into the executor as a command outside of a render pass which makes its output visible to vertex input, it must be requested prior to the draws using it
+         * @note Small ranges are converted on the CPU from guest memory while large ones are converted on the GPU from the backing of the buffer, which is attached to the executor for this
+         */
+        std::shared_ptr<ConvertedBuffer> GetConverted(interconnect::CommandExecutor &executor, const BufferView &source, const BufferConversion &conversion);
+    };
+}
@@ -2,42 +2,130 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <gpu.h>
+#include <loader/loader.h>
+#include <kernel/types/KProcess.h>
+#include <common/signal.h>
+#include <common/trace.h>
 #include "command_scheduler.h"
 
 namespace skyline::gpu {
-    CommandScheduler::CommandBufferSlot::CommandBufferSlot(vk::raii::Device &device, vk::CommandBuffer commandBuffer, vk::raii::CommandPool &pool)
+    CommandScheduler::Timeline::Timeline(const vk::raii::Device &device) : semaphore(device, vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfoKHR>{
+        vk::SemaphoreCreateInfo{},
+        vk::SemaphoreTypeCreateInfoKHR{
+            .semaphoreType = vk::SemaphoreTypeKHR::eTimeline,
+            .initialValue = 0,
+        },
+    }.get<vk::SemaphoreCreateInfo>()) {}
+
+    CommandScheduler::CommandBufferSlot::CommandBufferSlot(vk::raii::Device &device, vk::CommandBuffer commandBuffer, vk::raii::CommandPool &pool, Timeline *timeline)
         : device(device),
           commandBuffer(device, commandBuffer, pool),
-          fence(device, vk::FenceCreateInfo{}),
-          cycle(std::make_shared<FenceCycle>(device, *fence)) {}
+          fence(timeline ? vk::raii::Fence{nullptr} : vk::raii::Fence{device, vk::FenceCreateInfo{}}),
+          timeline(timeline),
+          cycle(CreateCycle()) {}
 
-    bool CommandScheduler::CommandBufferSlot::AllocateIfFree(CommandScheduler::CommandBufferSlot &slot) {
-        if (!slot.active.test_and_set(std::memory_order_acq_rel)) {
-            if (slot.cycle->Poll()) {
-                slot.commandBuffer.reset();
-                slot.cycle = std::make_shared<FenceCycle>(slot.device, *slot.fence);
-                return true;
-            } else {
-                slot.active.clear(std::memory_order_release);
-            }
-        }
-        return false;
+    std::shared_ptr<FenceCycle> CommandScheduler::CommandBufferSlot::CreateCycle() {
+        if (timeline)
+            return std::make_shared<FenceCycle>(device, *timeline->semaphore, timeline->completedValue);
+        else
+            return std::make_shared<FenceCycle>(device, *fence);
     }
 
-    CommandScheduler::CommandScheduler(GPU &pGpu) : gpu(pGpu), pool(std::ref(pGpu.vkDevice), vk::CommandPoolCreateInfo{
+    CommandScheduler::TransferQueue::TransferQueue(GPU &gpu) : timeline(gpu.vkDevice), pool(std::ref(gpu.vkDevice), vk::CommandPoolCreateInfo{
         .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-        .queueFamilyIndex = pGpu.vkQueueFamilyIndex,
+        .queueFamilyIndex = gpu.vkTransferQueueFamilyIndex,
     }) {}
 
-    CommandScheduler::ActiveCommandBuffer CommandScheduler::AllocateCommandBuffer() {
-        auto slot{std::find_if(pool->buffers.begin(), pool->buffers.end(), CommandBufferSlot::AllocateIfFree)};
-        auto slotId{std::distance(pool->buffers.begin(), slot)};
-        if (slot != pool->buffers.end())
-            return ActiveCommandBuffer(*slot);
+    CommandScheduler::CommandScheduler(const DeviceState &state, GPU &pGpu) : state(state), gpu(pGpu), pool(std::ref(pGpu.vkDevice), vk::CommandPoolCreateInfo{
+        .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+        .queueFamilyIndex = pGpu.vkQueueFamilyIndex,
+    }), secondaryPool(std::ref(pGpu.vkDevice), vk::CommandPoolCreateInfo{
+        .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+        .queueFamilyIndex = pGpu.vkQueueFamilyIndex,
+    }) {
+        if (gpu.supportsTimelineSemaphore) {
+            timeline.emplace(gpu.vkDevice);
+            submissionThread = std::thread(&CommandScheduler::SubmissionThread, this);
+        }
+
+        if (gpu.vkTransferQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED)
+            transfer.emplace(gpu);
+    }
+
+    CommandScheduler::~CommandScheduler() {
+        if (submissionThread.joinable()) {
+            pthread_kill(submissionThread.native_handle(), SIGINT);
+            submissionThread.join();
+        }
+    }
+
+    void CommandScheduler::SubmissionThread() {
+        pthread_setname_np(pthread_self(), "Sky-VkSubmit");
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+            submissionQueue.Process([this](const PendingSubmission &submission) {
+                TRACE_EVENT("gpu", "CommandScheduler::SubmissionThread");
+
+                // Resources released by the transfer queue are acquired at the start of command buffers, the transfers need to have completed by then
+                u32 waitCount{submission.transferValue ? 1U : 0U};
+                vk::PipelineStageFlags waitStage{vk::PipelineStageFlagBits::eAllCommands};
+                vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfoKHR> submitInfo{
+                    vk::SubmitInfo{
+                        .waitSemaphoreCount = waitCount,
+                        .pWaitSemaphores = waitCount ? &*transfer->timeline.semaphore : nullptr,
+                        .pWaitDstStageMask = &waitStage,
+                        .commandBufferCount = 1,
+                        .pCommandBuffers = &submission.commandBuffer,
+                        .signalSemaphoreCount = 1,
+                        .pSignalSemaphores = &*timeline->semaphore,
+                    },
+                    vk::TimelineSemaphoreSubmitInfoKHR{
+                        .waitSemaphoreValueCount = waitCount,
+                        .pWaitSemaphoreValues = &submission.transferValue,
+                        .signalSemaphoreValueCount = 1,
+                        .pSignalSemaphoreValues = &submission.value,
+                    },
+                };
+
+                std::scoped_lock lock(gpu.queueMutex);
+                gpu.vkQueue.submit(submitInfo.get<vk::SubmitInfo>());
+                trace::BootProfile::MarkFirstGpuSubmission();
+            });
+        } catch (const signal::SignalException &e) {
+            if (e.signal != SIGINT) {
+                Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+                signal::BlockSignal({SIGINT});
+                state.process->Kill(false);
+            }
+        } catch (const std::exception &e) {
+            Logger::Error(e.what());
+            signal::BlockSignal({SIGINT});
+            state.process->Kill(false);
+        }
+    }
+
+    CommandScheduler::ActiveCommandBuffer CommandScheduler::AllocateCommandBuffer(CommandPool &commandPool, Timeline *timeline) {
+        if (commandPool.ringSize) {
+            auto &slot{*commandPool.ring[commandPool.ringStart]};
+            if (commandPool.buffers.size() >= CommandPool::HighWaterMark) [[unlikely]] {
+                TRACE_EVENT("gpu", "CommandScheduler::AllocateCommandBuffer::Wait");
+                slot.cycle->Wait();
+            }
+
+            if (slot.cycle->Poll()) {
+                commandPool.PopSlot();
+                slot.commandBuffer.reset();
+                slot.cycle = slot.CreateCycle();
+                return ActiveCommandBuffer(commandPool, slot);
+            }
+        } else if (commandPool.buffers.size() >= CommandPool::HighWaterMark) [[unlikely]] {
+            throw exception("All {} command buffers in the pool are being recorded to concurrently", CommandPool::HighWaterMark);
+        }
 
         vk::CommandBuffer commandBuffer;
         vk::CommandBufferAllocateInfo commandBufferAllocateInfo{
-            .commandPool = *pool->vkCommandPool,
+            .commandPool = *commandPool.vkCommandPool,
             .level = vk::CommandBufferLevel::ePrimary,
             .commandBufferCount = 1,
         };
@@ -45,14 +133,91 @@ namespace skyline::gpu {
         auto result{(*gpu.vkDevice).allocateCommandBuffers(&commandBufferAllocateInfo, &commandBuffer, *gpu.vkDevice.getDispatcher())};
         if (result != vk::Result::eSuccess)
             vk::throwResultException(result, __builtin_FUNCTION());
-        return ActiveCommandBuffer(pool->buffers.emplace_back(gpu.vkDevice, commandBuffer, pool->vkCommandPool));
+        return ActiveCommandBuffer(commandPool, commandPool.buffers.emplace_back(gpu.vkDevice, commandBuffer, commandPool.vkCommandPool, timeline));
     }
 
-    void CommandScheduler::SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, vk::Fence fence) {
-        std::scoped_lock lock(gpu.queueMutex);
-        gpu.vkQueue.submit(vk::SubmitInfo{
+    vk::raii::CommandBuffer &CommandScheduler::AllocateSecondaryCommandBuffer(const std::shared_ptr<FenceCycle> &cycle) {
+        auto &commandPool{*secondaryPool};
+        if (!commandPool.slots.empty()) {
+            // Secondary command buffers are executed in roughly the order they're allocated, only the oldest one needs to be checked
+            auto &slot{commandPool.slots.front()};
+            auto slotCycle{slot.cycle.lock()};
+            if (!slotCycle || slotCycle->Poll()) {
+                commandPool.slots.splice(commandPool.slots.end(), commandPool.slots, commandPool.slots.begin());
+                slot.commandBuffer.reset();
+                slot.cycle = cycle;
+                return slot.commandBuffer;
+            }
+        }
+
+        auto commandBuffers{vk::raii::CommandBuffers(gpu.vkDevice, vk::CommandBufferAllocateInfo{
+            .commandPool = *commandPool.vkCommandPool,
+            .level = vk::CommandBufferLevel::eSecondary,
             .commandBufferCount = 1,
-            .pCommandBuffers = &*commandBuffer,
-        }, fence);
+        })};
+        return commandPool.slots.emplace_back(SecondaryCommandPool::Slot{std::move(commandBuffers.front()), cycle}).commandBuffer;
+    }
+
+    void CommandScheduler::BeginCommandBuffer(ActiveCommandBuffer &commandBuffer) {
+        commandBuffer->begin(vk::CommandBufferBeginInfo{
+            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+        });
+        gpu.timestamps.BeginCommandBuffer(*commandBuffer, commandBuffer.GetFenceCycle(), "Command Buffer");
+    }
+
+    void CommandScheduler::EndCommandBuffer(ActiveCommandBuffer &commandBuffer) {
+        gpu.timestamps.EndCommandBuffer(*commandBuffer);
+        commandBuffer->end();
+    }
+
+    void CommandScheduler::CancelCommandBuffer(ActiveCommandBuffer &commandBuffer) {
+        gpu.timestamps.AbortCommandBuffer(commandBuffer.GetFenceCycle()); // This must be done prior to cancelling the cycle as that destroys the query set
+        commandBuffer.GetFenceCycle()->Cancel();
+    }
+
+    void CommandScheduler::SubmitCommandBuffer(ActiveCommandBuffer &commandBuffer) {
+        if (timeline) {
+            // The value is assigned and the submission is queued atomically as the values must be signalled in ascending order
+            std::scoped_lock lock(timeline->submissionMutex);
+            auto value{++timeline->value};
+            commandBuffer.GetFenceCycle()->AssignTimelineValue(value);
+            submissionQueue.Push(PendingSubmission{
+                .commandBuffer = **commandBuffer,
+                .value = value,
+                .transferValue = transfer ? transfer->submittedValue.load(std::memory_order_acquire) : 0,
+            });
+        } else {
+            std::scoped_lock lock(gpu.queueMutex);
+            gpu.vkQueue.submit(vk::SubmitInfo{
+                .commandBufferCount = 1,
+                .pCommandBuffers = &**commandBuffer,
+            }, commandBuffer.GetFence());
+        }
+    }
+
+    void CommandScheduler::SubmitTransferCommandBuffer(ActiveCommandBuffer &commandBuffer) {
+        auto value{++transfer->timeline.value};
+        commandBuffer.GetFenceCycle()->AssignTimelineValue(value);
+
+        vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfoKHR> submitInfo{
+            vk::SubmitInfo{
+                .commandBufferCount = 1,
+                .pCommandBuffers = &**commandBuffer,
+                .signalSemaphoreCount = 1,
+                .pSignalSemaphores = &*transfer->timeline.semaphore,
+            },
+            vk::TimelineSemaphoreSubmitInfoKHR{
+                .signalSemaphoreValueCount = 1,
+                .pSignalSemaphoreValues = &value,
+            },
+        };
+
+        {
+            std::scoped_lock lock(gpu.transferQueueMutex);
+            gpu.vkTransferQueue.submit(submitInfo.get<vk::SubmitInfo>());
+        }
+
+        // The value is only published after the submission so graphics submissions never wait on a signal operation that hasn't been submitted yet
+        transfer->submittedValue.store(value, std::memory_order_release);
     }
 }
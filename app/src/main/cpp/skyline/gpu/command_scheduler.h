@@ -4,45 +4,113 @@
 #pragma once
 
 #include <common/thread_local.h>
+#include <common/circular_queue.h>
 #include "fence_cycle.h"
 
 namespace skyline::gpu {
     /**
      * @brief The allocation and synchronized submission of command buffers to the host GPU is handled by this class
+     * @note If VK_KHR_timeline_semaphore is supported, submissions are tracked using values on a single timeline semaphore and are handed off to a dedicated thread which submits them to the queue
+     * @note If the device has a dedicated transfer queue, uploads can be submitted to it with their own timeline semaphore which all subsequent submissions to the graphics queue wait on
      */
     class CommandScheduler {
       private:
+        /**
+         * @brief The state of the timeline semaphore which all submissions signal when it's supported
+         */
+        struct Timeline {
+            vk::raii::Semaphore semaphore;
+            std::atomic<u64> completedValue{}; //!< The highest value the semaphore has been observed to reach, this is shared between all cycles
+            std::mutex submissionMutex; //!< Synchronizes assigning values and pushing submissions to the queue as they must be submitted in ascending order
+            u64 value{}; //!< The value assigned to the latest submission
+
+            Timeline(const vk::raii::Device &device);
+        };
+
         /**
          * @brief A wrapper around a command buffer which tracks its state to avoid concurrent usage
          */
         struct CommandBufferSlot {
-            std::atomic_flag active{true}; //!< If the command buffer is currently being recorded to
             const vk::raii::Device &device;
             vk::raii::CommandBuffer commandBuffer;
-            vk::raii::Fence fence; //!< A fence used for tracking all submits of a buffer
+            vk::raii::Fence fence; //!< A fence used for tracking all submits of a buffer, this is null when the timeline semaphore is used instead
+            Timeline *timeline; //!< The timeline used for tracking all submits of a buffer, this is null when a fence is used instead
             std::shared_ptr<FenceCycle> cycle; //!< The latest cycle on the fence, all waits must be performed through this
 
-            CommandBufferSlot(vk::raii::Device &device, vk::CommandBuffer commandBuffer, vk::raii::CommandPool &pool);
+            CommandBufferSlot(vk::raii::Device &device, vk::CommandBuffer commandBuffer, vk::raii::CommandPool &pool, Timeline *timeline);
+
+            /**
+             * @return A new cycle on the fence or timeline of this slot
+             */
+            std::shared_ptr<FenceCycle> CreateCycle();
+        };
+
+        /**
+         * @brief A command pool designed to be thread-local to respect external synchronization for all command buffers and the associated pool
+         * @note If we utilized a single global pool there would need to be a mutex around command buffer recording which would incur significant costs
+         */
+        struct CommandPool {
+            static constexpr size_t HighWaterMark{0x40}; //!< The maximum amount of command buffers in a pool, allocations past this wait on the oldest submission rather than growing the pool
+
+            vk::raii::CommandPool vkCommandPool;
+            std::list<CommandBufferSlot> buffers;
+            std::array<CommandBufferSlot *, HighWaterMark> ring{}; //!< A ring of all slots which aren't being recorded to in the order they were submitted, slots are reclaimed from the front as their fences are signalled in the same order
+            size_t ringStart{}; //!< The index of the oldest slot in the ring
+            size_t ringSize{}; //!< The amount of slots in the ring
+
+            template<typename... Args>
+            constexpr CommandPool(Args &&... args) : vkCommandPool(std::forward<Args>(args)...) {}
+
+            /**
+             * @brief Pushes a slot onto the back of the ring after it has been submitted or cancelled
+             */
+            void PushSlot(CommandBufferSlot &slot) {
+                ring[(ringStart + ringSize++) % HighWaterMark] = &slot;
+            }
+
+            /**
+             * @brief Removes the oldest slot from the ring
+             */
+            CommandBufferSlot &PopSlot() {
+                auto &slot{*ring[ringStart]};
+                ringStart = (ringStart + 1) % HighWaterMark;
+                ringSize--;
+                return slot;
+            }
+        };
 
+        /**
+         * @brief A thread-local pool of secondary command buffers, these are executed by primary command buffers so they're reused once the cycle of the primary one has been signalled
+         */
+        struct SecondaryCommandPool {
             /**
-             * @brief Attempts to allocate the buffer if it is free (Not being recorded/executing)
-             * @return If the allocation was successful or not
+             * @brief A secondary command buffer alongside the cycle of the primary command buffer which it was last executed by
              */
-            static bool AllocateIfFree(CommandBufferSlot &slot);
+            struct Slot {
+                vk::raii::CommandBuffer commandBuffer;
+                std::weak_ptr<FenceCycle> cycle;
+            };
+
+            vk::raii::CommandPool vkCommandPool;
+            std::list<Slot> slots; //!< All slots in the order they were last allocated in, the oldest slot is at the front
+
+            template<typename... Args>
+            constexpr SecondaryCommandPool(Args &&... args) : vkCommandPool(std::forward<Args>(args)...) {}
         };
 
         /**
-         * @brief An active command buffer occupies a slot and ensures that its status is updated correctly
+         * @brief An active command buffer occupies a slot and returns it to the ring of its pool once it's done
          */
         class ActiveCommandBuffer {
           private:
+            CommandPool &pool;
             CommandBufferSlot &slot;
 
           public:
-            constexpr ActiveCommandBuffer(CommandBufferSlot &slot) : slot(slot) {}
+            constexpr ActiveCommandBuffer(CommandPool &pool, CommandBufferSlot &slot) : pool(pool), slot(slot) {}
 
             ~ActiveCommandBuffer() {
-                slot.active.clear(std::memory_order_release);
+                pool.PushSlot(slot);
             }
 
             vk::Fence GetFence() {
@@ -62,50 +130,95 @@ namespace skyline::gpu {
             }
         };
 
+        /**
+         * @brief The state of the dedicated transfer queue, it has a single pool as submissions to it are serialized
+         */
+        struct TransferQueue {
+            Timeline timeline; //!< The timeline semaphore signalled by all transfer submissions, it's separate from the graphics timeline as they're signalled out of order relative to each other
+            std::atomic<u64> submittedValue{}; //!< The value of the latest transfer submission, graphics submissions wait on this to guarantee ownership of any released resources can be acquired
+            std::mutex mutex; //!< Synchronizes recording and submitting to the transfer queue as the pool is shared
+            CommandPool pool;
+
+            TransferQueue(GPU &gpu);
+        };
+
+        const DeviceState &state;
         GPU &gpu;
+        std::optional<Timeline> timeline; //!< The timeline semaphore used for tracking submissions, this is only present when it's supported by the device
+        ThreadLocal<CommandPool> pool;
+        ThreadLocal<SecondaryCommandPool> secondaryPool;
+        std::optional<TransferQueue> transfer; //!< The transfer queue state, this is only present when the device has a dedicated transfer queue
 
         /**
-         * @brief A command pool designed to be thread-local to respect external synchronization for all command buffers and the associated pool
-         * @note If we utilized a single global pool there would need to be a mutex around command buffer recording which would incur significant costs
+         * @brief Allocates an existing or new primary command buffer from the supplied pool
+         * @param timeline The timeline semaphore that submissions of the command buffer are tracked with, this is null if fences are used instead
+         * @note This is O(1) as only the oldest submission in the ring is checked, it'll block on the oldest submission if the pool has reached its high-water mark
          */
-        struct CommandPool {
-            vk::raii::CommandPool vkCommandPool;
-            std::list<CommandBufferSlot> buffers;
+        ActiveCommandBuffer AllocateCommandBuffer(CommandPool &commandPool, Timeline *timeline);
 
-            template<typename... Args>
-            constexpr CommandPool(Args &&... args) : vkCommandPool(std::forward<Args>(args)...) {}
+        /**
+         * @brief A command buffer that has been recorded and is pending submission by the submission thread
+         */
+        struct PendingSubmission {
+            vk::CommandBuffer commandBuffer;
+            u64 value; //!< The value which the timeline semaphore will be signalled with on completion
+            u64 transferValue; //!< The value of the transfer timeline semaphore which is waited on prior to execution, this is 0 if there have been no transfer submissions
         };
-        ThreadLocal<CommandPool> pool;
+
+        static constexpr size_t SubmissionQueueSize{0x20}; //!< The maximum amount of submissions that can be pending, this is a generous bound as submission itself should be quick
+        CircularQueue<PendingSubmission> submissionQueue{SubmissionQueueSize};
+        std::thread submissionThread; //!< The thread which owns submission to the queue when the timeline semaphore is used, this allows the recording threads to move on without waiting on the driver
+
+        /**
+         * @brief Submits all pending submissions to the GPU queue as they arrive
+         */
+        void SubmissionThread();
 
         /**
-         * @brief Allocates an existing or new primary command buffer from the pool
+         * @brief Begins recording a command buffer, this also starts tracing its execution on the GPU if the "gpu" category is being traced
          */
-        ActiveCommandBuffer AllocateCommandBuffer();
+        void BeginCommandBuffer(ActiveCommandBuffer &commandBuffer);
 
         /**
-         * @brief Submits a single command buffer to the GPU queue with an optional fence
+         * @brief Ends recording a command buffer, it must be submitted after this
          */
-        void SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, vk::Fence fence = {});
+        void EndCommandBuffer(ActiveCommandBuffer &commandBuffer);
+
+        /**
+         * @brief Cancels a command buffer which failed to be recorded or submitted
+         */
+        void CancelCommandBuffer(ActiveCommandBuffer &commandBuffer);
+
+        /**
+         * @brief Submits a single command buffer to the GPU queue, this will either be done directly with the fence of the slot or by handing it off to the submission thread with a value on the timeline semaphore
+         */
+        void SubmitCommandBuffer(ActiveCommandBuffer &commandBuffer);
+
+        /**
+         * @brief Submits a single command buffer to the transfer queue with the next value on the transfer timeline semaphore
+         * @note The transfer mutex must be locked by the calling thread
+         */
+        void SubmitTransferCommandBuffer(ActiveCommandBuffer &commandBuffer);
 
       public:
-        CommandScheduler(GPU &gpu);
+        CommandScheduler(const DeviceState &state, GPU &gpu);
+
+        ~CommandScheduler();
 
         /**
          * @brief Submits a command buffer recorded with the supplied function synchronously
          */
         template<typename RecordFunction>
         std::shared_ptr<FenceCycle> Submit(RecordFunction recordFunction) {
-            auto commandBuffer{AllocateCommandBuffer()};
+            auto commandBuffer{AllocateCommandBuffer(*pool, timeline ? &*timeline : nullptr)};
             try {
-                commandBuffer->begin(vk::CommandBufferBeginInfo{
-                    .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
-                });
+                BeginCommandBuffer(commandBuffer);
                 recordFunction(*commandBuffer);
-                commandBuffer->end();
-                SubmitCommandBuffer(*commandBuffer, commandBuffer.GetFence());
+                EndCommandBuffer(commandBuffer);
+                SubmitCommandBuffer(commandBuffer);
                 return commandBuffer.GetFenceCycle();
             } catch (...) {
-                commandBuffer.GetFenceCycle()->Cancel();
+                CancelCommandBuffer(commandBuffer);
                 std::rethrow_exception(std::current_exception());
             }
         }
@@ -115,14 +228,49 @@ namespace skyline::gpu {
          */
         template<typename RecordFunction>
         std::shared_ptr<FenceCycle> SubmitWithCycle(RecordFunction recordFunction) {
-            auto commandBuffer{AllocateCommandBuffer()};
+            auto commandBuffer{AllocateCommandBuffer(*pool, timeline ? &*timeline : nullptr)};
+            try {
+                BeginCommandBuffer(commandBuffer);
+                recordFunction(*commandBuffer, commandBuffer.GetFenceCycle());
+                EndCommandBuffer(commandBuffer);
+                SubmitCommandBuffer(commandBuffer);
+                return commandBuffer.GetFenceCycle();
+            } catch (...) {
+                CancelCommandBuffer(commandBuffer);
+                std::rethrow_exception(std::current_exception());
+            }
+        }
+
+        /**
+         * @brief Allocates a secondary command buffer from a pool local to the calling thread, it's reused once the supplied cycle has been signalled
+         * @param cycle The cycle of the primary command buffer which the secondary command buffer will be executed by
+         * @note The command buffer must only be recorded to by the calling thread
+         */
+        vk::raii::CommandBuffer &AllocateSecondaryCommandBuffer(const std::shared_ptr<FenceCycle> &cycle);
+
+        /**
+         * @return If there is a dedicated transfer queue which SubmitTransfer can be used with
+         */
+        bool HasTransferQueue() const {
+            return transfer.has_value();
+        }
+
+        /**
+         * @brief Submits a command buffer recorded with the supplied function to the dedicated transfer queue, this executes concurrently with any work on the graphics queue
+         * @note Any resource written by the command buffer must have its ownership released to the graphics queue family at the end of it, all graphics submissions after this wait on it so the ownership can be acquired by any of them
+         * @note Only transfer commands can be recorded, this must only be used when HasTransferQueue is true
+         */
+        template<typename RecordFunction>
+        std::shared_ptr<FenceCycle> SubmitTransfer(RecordFunction recordFunction) {
+            std::scoped_lock lock(transfer->mutex);
+            auto commandBuffer{AllocateCommandBuffer(transfer->pool, &transfer->timeline)};
             try {
                 commandBuffer->begin(vk::CommandBufferBeginInfo{
                     .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
                 });
-                recordFunction(*commandBuffer, commandBuffer.GetFenceCycle());
+                recordFunction(*commandBuffer);
                 commandBuffer->end();
-                SubmitCommandBuffer(*commandBuffer, commandBuffer.GetFence());
+                SubmitTransferCommandBuffer(commandBuffer);
                 return commandBuffer.GetFenceCycle();
             } catch (...) {
                 commandBuffer.GetFenceCycle()->Cancel();
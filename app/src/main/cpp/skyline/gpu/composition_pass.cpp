@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include "composition_pass.h"
+
+namespace skyline::gpu {
+    namespace {
+        constexpr u32 CompositionVertexSpirv[]{
+            #include "composition.vert.spv.inc"
+        };
+
+        constexpr u32 CompositionFragmentSpirv[]{
+            #include "composition.frag.spv.inc"
+        };
+    }
+
+    CompositionPass::CompositionPass(GPU &gpu) : gpu(gpu),
+        descriptorSetLayout(gpu.descriptor.CreateSetLayout([] {
+            constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> bindings{
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eFragment,
+                },
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 1,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eFragment,
+                },
+            };
+            return span<const vk::DescriptorSetLayoutBinding>(bindings);
+        }())),
+        sampler(gpu.vkDevice, vk::SamplerCreateInfo{
+            .magFilter = vk::Filter::eLinear,
+            .minFilter = vk::Filter::eLinear,
+            .mipmapMode = vk::SamplerMipmapMode::eNearest,
+            .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+            .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+            .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        }),
+        pipelineLayout(gpu.vkDevice, [this] {
+            constexpr static vk::PushConstantRange pushConstantRange{
+                .stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+                .size = sizeof(PushConstants),
+            };
+            return vk::PipelineLayoutCreateInfo{
+                .setLayoutCount = 1,
+                .pSetLayouts = &*descriptorSetLayout.vkLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+        }()),
+        vertexShaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(CompositionVertexSpirv),
+            .pCode = CompositionVertexSpirv,
+        }),
+        fragmentShaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(CompositionFragmentSpirv),
+            .pCode = CompositionFragmentSpirv,
+        }) {}
+
+    CompositionPass::FormatPipeline &CompositionPass::GetPipeline(texture::Format format) {
+        auto it{std::find_if(pipelines.begin(), pipelines.end(), [&](const FormatPipeline &pipeline) { return pipeline.format == format->vkFormat; })};
+        if (it != pipelines.end())
+            return *it;
+
+        // The prior contents of the destination are cleared as the VIC always fills the entire output surface, the destination is left in the general layout so it can be used by anything afterwards
+        vk::AttachmentDescription attachment{
+            .format = *format,
+            .samples = vk::SampleCountFlagBits::e1,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eStore,
+            .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+            .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+            .initialLayout = vk::ImageLayout::eUndefined,
+            .finalLayout = vk::ImageLayout::eGeneral,
+        };
+        vk::AttachmentReference attachmentReference{
+            .attachment = 0,
+            .layout = vk::ImageLayout::eColorAttachmentOptimal,
+        };
+        vk::SubpassDescription subpass{
+            .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &attachmentReference,
+        };
+        std::array<vk::SubpassDependency, 2> dependencies{
+            vk::SubpassDependency{
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = 0,
+                .srcStageMask = vk::PipelineStageFlagBits::eAllCommands,
+                .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead,
+            },
+            vk::SubpassDependency{
+                .srcSubpass = 0,
+                .dstSubpass = VK_SUBPASS_EXTERNAL,
+                .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                .dstStageMask = vk::PipelineStageFlagBits::eAllCommands,
+                .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+            },
+        };
+        auto renderPass{gpu.renderPassCache.GetRenderPass(vk::RenderPassCreateInfo{
+            .attachmentCount = 1,
+            .pAttachments = &attachment,
+            .subpassCount = 1,
+            .pSubpasses = &subpass,
+            .dependencyCount = static_cast<u32>(dependencies.size()),
+            .pDependencies = dependencies.data(),
+        })};
+
+        std::array<vk::PipelineShaderStageCreateInfo, 2> stages{
+            vk::PipelineShaderStageCreateInfo{
+                .stage = vk::ShaderStageFlagBits::eVertex,
+                .module = *vertexShaderModule,
+                .pName = "main",
+            },
+            vk::PipelineShaderStageCreateInfo{
+                .stage = vk::ShaderStageFlagBits::eFragment,
+                .module = *fragmentShaderModule,
+                .pName = "main",
+            },
+        };
+        vk::PipelineVertexInputStateCreateInfo vertexInputState{};
+        vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
+            .topology = vk::PrimitiveTopology::eTriangleStrip,
+        };
+        vk::PipelineViewportStateCreateInfo viewportState{
+            .viewportCount = 1,
+            .scissorCount = 1,
+        };
+        vk::PipelineRasterizationStateCreateInfo rasterizationState{
+            .polygonMode = vk::PolygonMode::eFill,
+            .cullMode = vk::CullModeFlagBits::eNone,
+            .lineWidth = 1.0f,
+        };
+        vk::PipelineMultisampleStateCreateInfo multisampleState{
+            .rasterizationSamples = vk::SampleCountFlagBits::e1,
+        };
+        // Layers are blended over all prior layers with their alpha, the alpha of the destination accumulates the coverage of all layers
+        vk::PipelineColorBlendAttachmentState colorBlendAttachment{
+            .blendEnable = true,
+            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+            .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .colorBlendOp = vk::BlendOp::eAdd,
+            .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+            .dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .alphaBlendOp = vk::BlendOp::eAdd,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+        };
+        vk::PipelineColorBlendStateCreateInfo colorBlendState{
+            .attachmentCount = 1,
+            .pAttachments = &colorBlendAttachment,
+        };
+        constexpr static std::array<vk::DynamicState, 2> dynamicStates{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+        vk::PipelineDynamicStateCreateInfo dynamicState{
+            .dynamicStateCount = static_cast<u32>(dynamicStates.size()),
+            .pDynamicStates = dynamicStates.data(),
+        };
+
+        return pipelines.emplace_back(FormatPipeline{
+            .format = format->vkFormat,
+            .renderPass = renderPass,
+            .pipeline = vk::raii::Pipeline(gpu.vkDevice, gpu.pipelineCache.vkPipelineCache, vk::GraphicsPipelineCreateInfo{
+                .stageCount = static_cast<u32>(stages.size()),
+                .pStages = stages.data(),
+                .pVertexInputState = &vertexInputState,
+                .pInputAssemblyState = &inputAssemblyState,
+                .pViewportState = &viewportState,
+                .pRasterizationState = &rasterizationState,
+                .pMultisampleState = &multisampleState,
+                .pColorBlendState = &colorBlendState,
+                .pDynamicState = &dynamicState,
+                .layout = *pipelineLayout,
+                .renderPass = renderPass,
+                .subpass = 0,
+            }),
+        });
+    }
+
+    bool CompositionPass::IsSupported(const Texture &texture) {
+        return (texture.usage & vk::ImageUsageFlagBits::eSampled) && (texture.usage & vk::ImageUsageFlagBits::eColorAttachment) && texture.format->vkAspect == vk::ImageAspectFlagBits::eColor && texture.dimensions.GetType() == vk::ImageType::e2D && texture.sampleCount == vk::SampleCountFlagBits::e1 && texture.mipLevels == 1 && texture.layerCount == 1;
+    }
+
+    void CompositionPass::Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, TextureView &destination, std::array<float, 4> clearColor, span<Layer> layers) {
+        TRACE_EVENT("gpu", "CompositionPass::Record");
+
+        vk::ImageSubresourceRange subresource{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .levelCount = 1,
+            .layerCount = 1,
+        };
+
+        // All textures that are sampled from are transitioned into the general layout prior to the render pass, the same texture may be sampled by multiple layers
+        std::vector<Texture *> sources;
+        std::vector<vk::ImageMemoryBarrier> barriers;
+        for (auto &layer : layers) {
+            for (auto view : {&layer.luma, layer.chroma ? &*layer.chroma : nullptr}) {
+                if (!view || std::find(sources.begin(), sources.end(), view->backing.get()) != sources.end())
+                    continue;
+
+                auto source{view->backing.get()};
+                sources.push_back(source);
+                source->RecordDeferredLayout(commandBuffer);
+                barriers.push_back(vk::ImageMemoryBarrier{
+                    .image = source->GetBacking(),
+                    .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                    .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+                    .oldLayout = std::exchange(source->layout, vk::ImageLayout::eGeneral),
+                    .newLayout = vk::ImageLayout::eGeneral,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .subresourceRange = subresource,
+                });
+            }
+        }
+        if (!barriers.empty())
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barriers);
+
+        auto &pipeline{GetPipeline(destination.format)};
+        auto destinationView{destination.GetView()};
+        auto &texture{destination.backing};
+        vk::Extent2D extent{texture->dimensions.width, texture->dimensions.height};
+        auto framebuffer{gpu.framebufferCache.GetFramebuffer(vk::FramebufferCreateInfo{
+            .renderPass = pipeline.renderPass,
+            .attachmentCount = 1,
+            .pAttachments = &destinationView,
+            .width = extent.width,
+            .height = extent.height,
+            .layers = 1,
+        }, span<const std::shared_ptr<Texture>>(&texture, 1))};
+
+        texture->RecordDeferredLayout(commandBuffer);
+        vk::ClearValue clearValue{vk::ClearColorValue{clearColor}};
+        commandBuffer.beginRenderPass(vk::RenderPassBeginInfo{
+            .renderPass = pipeline.renderPass,
+            .framebuffer = framebuffer,
+            .renderArea = {.extent = extent},
+            .clearValueCount = 1,
+            .pClearValues = &clearValue,
+        }, vk::SubpassContents::eInline);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.pipeline);
+        commandBuffer.setViewport(0, vk::Viewport{
+            .width = static_cast<float>(extent.width),
+            .height = static_cast<float>(extent.height),
+            .maxDepth = 1.0f,
+        });
+        commandBuffer.setScissor(0, vk::Rect2D{.extent = extent});
+
+        for (auto &layer : layers) {
+            auto lumaView{layer.luma.GetView()};
+            auto chromaView{layer.chroma ? layer.chroma->GetView() : lumaView}; // RGB layers bind their only plane twice as the set layout is the same for all layers
+            std::array<DescriptorAllocator::DescriptorInfo, 2> descriptors{
+                vk::DescriptorImageInfo{
+                    .sampler = *sampler,
+                    .imageView = lumaView,
+                    .imageLayout = vk::ImageLayout::eGeneral,
+                },
+                vk::DescriptorImageInfo{
+                    .sampler = *sampler,
+                    .imageView = chromaView,
+                    .imageLayout = vk::ImageLayout::eGeneral,
+                },
+            };
+            gpu.descriptor.Bind(commandBuffer, cycle, vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, descriptorSetLayout, descriptors);
+
+            PushConstants constants{
+                .destination = {layer.destination[0] * 2.0f - 1.0f, layer.destination[1] * 2.0f - 1.0f, layer.destination[2] * 2.0f - 1.0f, layer.destination[3] * 2.0f - 1.0f},
+                .source = layer.source,
+                .matrix = layer.matrix,
+                .alpha = layer.alpha,
+                .planar = layer.chroma.has_value(),
+            };
+            commandBuffer.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, constants);
+            commandBuffer.draw(4, 1, 0, 0);
+        }
+
+        commandBuffer.endRenderPass();
+        texture->layout = vk::ImageLayout::eGeneral;
+    }
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "descriptor_allocator.h"
+#include "texture/texture.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A graphics pass which composites layers of YUV or RGB surfaces into a single plane of a destination with colour conversion, scaling and blending applied, this is used to emulate the VIC on the host GPU
+     * @note Every layer is drawn into a rectangle of the destination with a colour matrix applied to its samples, YUV destinations are composited one plane at a time with a matrix that produces the channels of that plane
+     * @note This class is **NOT** thread-safe and should only be used from a single thread
+     */
+    class CompositionPass {
+      public:
+        /**
+         * @brief A surface which is drawn into a rectangle of the destination
+         */
+        struct Layer {
+            TextureView luma; //!< The luma plane of YUV surfaces or the entirety of RGB surfaces
+            std::optional<TextureView> chroma; //!< The plane of interleaved U and V samples of YUV surfaces, RGB surfaces have none
+            std::array<float, 4> source; //!< The left, top, right and bottom edges of the sampled region in normalized coordinates
+            std::array<float, 4> destination; //!< The left, top, right and bottom edges of the region that's drawn into in normalized coordinates
+            std::array<std::array<float, 4>, 3> matrix; //!< The rows of a 3x4 matrix which maps the sampled channels and a constant 1 onto the channels written to the destination
+            float alpha; //!< The alpha that the layer is blended with, layers with an alpha of 1 overwrite the destination
+        };
+
+      private:
+        /**
+         * @note This must match the push constant block in composition.vert and composition.frag
+         */
+        struct PushConstants {
+            std::array<float, 4> destination; //!< The edges of the destination region in normalized device coordinates
+            std::array<float, 4> source;
+            std::array<std::array<float, 4>, 3> matrix;
+            float alpha;
+            u32 planar; //!< If the chroma channels are sampled from a separate plane
+        };
+
+        /**
+         * @brief A pipeline for drawing into destinations of a specific format
+         */
+        struct FormatPipeline {
+            vk::Format format;
+            vk::RenderPass renderPass;
+            vk::raii::Pipeline pipeline;
+        };
+
+        GPU &gpu;
+        DescriptorAllocator::SetLayout descriptorSetLayout;
+        vk::raii::Sampler sampler; //!< A linear sampler as layers are scaled into their destination region
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::ShaderModule vertexShaderModule;
+        vk::raii::ShaderModule fragmentShaderModule;
+        std::vector<FormatPipeline> pipelines; //!< The pipelines for all destination formats that have been composited into, there's only ever a handful of these
+
+        /**
+         * @return The pipeline for the supplied destination format, it's created if it doesn't exist yet
+         */
+        FormatPipeline &GetPipeline(texture::Format format);
+
+      public:
+        CompositionPass(GPU &gpu);
+
+        /**
+         * @return If the supplied texture can be composited into or sampled from by this pass
+         */
+        static bool IsSupported(const Texture &texture);
+
+        /**
+         * @brief Records clearing the destination to the supplied colour and drawing all layers into it in order
+         * @note The destination is left in VK_IMAGE_LAYOUT_GENERAL and all layers are transitioned into it, they must have a defined layout by the time the command buffer is executed
+         * @note All textures **must** be locked prior to calling this, the caller is responsible for attaching them to the cycle and synchronizing them with the guest
+         */
+        void Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, TextureView &destination, std::array<float, 4> clearColor, span<Layer> layers);
+    };
+}
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "descriptor_allocator.h"
+
+namespace skyline::gpu {
+    DescriptorAllocator::DescriptorPool::DescriptorPool(const vk::raii::Device &device, const vk::DescriptorPoolCreateInfo &createInfo) : vkPool(device, createInfo) {}
+
+    DescriptorAllocator::DescriptorAllocator(GPU &gpu) : gpu(gpu) {}
+
+    void DescriptorAllocator::RecyclePool(DescriptorPool *pool) {
+        // No other references to the pool exist at this point so it can be reset without holding the mutex
+        pool->cache.clear();
+        pool->lastCycle.reset();
+        (*gpu.vkDevice).resetDescriptorPool(*pool->vkPool, {}, *gpu.vkDevice.getDispatcher());
+
+        std::scoped_lock lock(mutex);
+        freePools.push_back(pool);
+    }
+
+    std::shared_ptr<DescriptorAllocator::DescriptorPool> DescriptorAllocator::AcquirePool() {
+        DescriptorPool *pool;
+        if (!freePools.empty()) {
+            pool = freePools.back();
+            freePools.pop_back();
+        } else {
+            constexpr std::array<vk::DescriptorPoolSize, 8> poolSizes{
+                vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eStorageBuffer, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eSampledImage, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eSampler, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eStorageImage, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eUniformTexelBuffer, PoolDescriptorCount},
+                vk::DescriptorPoolSize{vk::DescriptorType::eStorageTexelBuffer, PoolDescriptorCount},
+            };
+
+            pool = &pools.emplace_back(gpu.vkDevice, vk::DescriptorPoolCreateInfo{
+                .maxSets = PoolSetCount,
+                .poolSizeCount = poolSizes.size(),
+                .pPoolSizes = poolSizes.data(),
+            });
+        }
+
+        return std::shared_ptr<DescriptorPool>(pool, [this](DescriptorPool *pool) {
+            RecyclePool(pool);
+        });
+    }
+
+    DescriptorAllocator::SetLayout DescriptorAllocator::CreateSetLayout(span<const vk::DescriptorSetLayoutBinding> bindings) {
+        for (const auto &binding : bindings)
+            if (binding.descriptorCount != 1)
+                throw exception("Binding {} has a descriptor count of {}, only a single descriptor per binding is supported", binding.binding, binding.descriptorCount);
+
+        SetLayout layout{
+            .vkLayout = vk::raii::DescriptorSetLayout(gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+                .flags = gpu.supportsPushDescriptors ? vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR : vk::DescriptorSetLayoutCreateFlags{},
+                .bindingCount = static_cast<u32>(bindings.size()),
+                .pBindings = bindings.data(),
+            }),
+            .bindings = {bindings.begin(), bindings.end()},
+        };
+
+        if (!gpu.supportsPushDescriptors) {
+            std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+            entries.reserve(bindings.size());
+            for (size_t index{}; index < bindings.size(); index++) {
+                entries.push_back(vk::DescriptorUpdateTemplateEntry{
+                    .dstBinding = bindings[index].binding,
+                    .descriptorCount = 1,
+                    .descriptorType = bindings[index].descriptorType,
+                    .offset = index * sizeof(DescriptorInfo),
+                    .stride = sizeof(DescriptorInfo),
+                });
+            }
+
+            layout.vkUpdateTemplate.emplace(gpu.vkDevice, vk::DescriptorUpdateTemplateCreateInfo{
+                .descriptorUpdateEntryCount = static_cast<u32>(entries.size()),
+                .pDescriptorUpdateEntries = entries.data(),
+                .templateType = vk::DescriptorUpdateTemplateType::eDescriptorSet,
+                .descriptorSetLayout = *layout.vkLayout,
+            });
+        }
+
+        return layout;
+    }
+
+    vk::DescriptorSet DescriptorAllocator::GetSet(const std::shared_ptr<FenceCycle> &cycle, const SetLayout &layout, span<const DescriptorInfo> descriptors) {
+        if (descriptors.size() != layout.bindings.size())
+            throw exception("Descriptor count mismatch with layout: {} (Layout: {})", descriptors.size(), layout.bindings.size());
+
+        auto hash{std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(descriptors.data()), descriptors.size_bytes()))};
+        hash ^= std::hash<VkDescriptorSetLayout>{}(*layout.vkLayout) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+
+        std::shared_ptr<DescriptorPool> retiredPool; //!< A pool that was exhausted, this must only be released after the mutex is unlocked as it may be recycled on release
+        std::scoped_lock lock(mutex);
+        if (!activePool)
+            activePool = AcquirePool();
+
+        auto attachPool{[&] {
+            // The pool only needs to be attached once to each cycle, any prior sets from it will be kept alive by the same attachment
+            auto &lastCycle{activePool->lastCycle};
+            if (lastCycle.owner_before(cycle) || cycle.owner_before(lastCycle)) {
+                cycle->AttachObject(activePool);
+                lastCycle = cycle;
+            }
+        }};
+
+        if (auto it{activePool->cache.find(hash)}; it != activePool->cache.end()) {
+            for (const auto &cached : it->second) {
+                if (cached.layout == *layout.vkLayout && std::memcmp(cached.descriptors.data(), descriptors.data(), descriptors.size_bytes()) == 0) {
+                    attachPool();
+                    return cached.set;
+                }
+            }
+        }
+
+        vk::DescriptorSet set;
+        vk::DescriptorSetAllocateInfo allocateInfo{
+            .descriptorPool = *activePool->vkPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &*layout.vkLayout,
+        };
+        auto result{(*gpu.vkDevice).allocateDescriptorSets(&allocateInfo, &set, *gpu.vkDevice.getDispatcher())};
+        if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool) {
+            // The active pool has been exhausted, it'll be recycled once all cycles using it have been signalled
+            retiredPool = std::exchange(activePool, AcquirePool());
+            allocateInfo.descriptorPool = *activePool->vkPool;
+            result = (*gpu.vkDevice).allocateDescriptorSets(&allocateInfo, &set, *gpu.vkDevice.getDispatcher());
+        }
+        if (result != vk::Result::eSuccess)
+            throw exception("Failed to allocate a descriptor set: {}", vk::to_string(result));
+
+        (*gpu.vkDevice).updateDescriptorSetWithTemplate(set, **layout.vkUpdateTemplate, descriptors.data(), *gpu.vkDevice.getDispatcher());
+
+        activePool->cache[hash].push_back(DescriptorPool::CachedSet{
+            .layout = *layout.vkLayout,
+            .descriptors = {descriptors.begin(), descriptors.end()},
+            .set = set,
+        });
+        attachPool();
+        return set;
+    }
+
+    void DescriptorAllocator::Bind(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, u32 setIndex, const SetLayout &layout, span<const DescriptorInfo> descriptors) {
+        if (!gpu.supportsPushDescriptors) {
+            commandBuffer.bindDescriptorSets(bindPoint, pipelineLayout, setIndex, GetSet(cycle, layout, descriptors), {});
+            return;
+        }
+
+        if (descriptors.size() != layout.bindings.size())
+            throw exception("Descriptor count mismatch with layout: {} (Layout: {})", descriptors.size(), layout.bindings.size());
+
+        boost::container::small_vector<vk::WriteDescriptorSet, 8> writes;
+        for (size_t index{}; index < descriptors.size(); index++) {
+            const auto &binding{layout.bindings[index]};
+            const auto &descriptor{descriptors[index]};
+            vk::WriteDescriptorSet write{
+                .dstBinding = binding.binding,
+                .descriptorCount = 1,
+                .descriptorType = binding.descriptorType,
+            };
+
+            switch (binding.descriptorType) {
+                case vk::DescriptorType::eSampler:
+                case vk::DescriptorType::eCombinedImageSampler:
+                case vk::DescriptorType::eSampledImage:
+                case vk::DescriptorType::eStorageImage:
+                case vk::DescriptorType::eInputAttachment:
+                    write.pImageInfo = &descriptor.image;
+                    break;
+
+                case vk::DescriptorType::eUniformTexelBuffer:
+                case vk::DescriptorType::eStorageTexelBuffer:
+                    write.pTexelBufferView = &descriptor.texelBuffer;
+                    break;
+
+                default:
+                    write.pBufferInfo = &descriptor.buffer;
+                    break;
+            }
+
+            writes.push_back(write);
+        }
+
+        commandBuffer.pushDescriptorSetKHR(bindPoint, pipelineLayout, setIndex, vk::ArrayProxy<const vk::WriteDescriptorSet>(static_cast<u32>(writes.size()), writes.data()));
+    }
+}
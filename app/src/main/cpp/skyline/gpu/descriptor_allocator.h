@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "fence_cycle.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief An allocator for transient descriptor sets which are only valid for the fence cycles they're allocated in, pools are recycled as a whole once all cycles using them have been signalled
+     * @note When VK_KHR_push_descriptor is supported, descriptors are pushed directly into the command buffer and no sets are allocated at all
+     * @note This class is thread-safe as it can be used from several threads recording command buffers concurrently
+     */
+    class DescriptorAllocator {
+      public:
+        /**
+         * @brief A single descriptor in the format expected by descriptor update templates, every binding of a layout is supplied as one of these in the order of the bindings
+         * @note The constructors zero the entire union prior to filling it in as it's hashed and compared bytewise for the descriptor set cache
+         */
+        union DescriptorInfo {
+            vk::DescriptorBufferInfo buffer;
+            vk::DescriptorImageInfo image;
+            vk::BufferView texelBuffer;
+
+            DescriptorInfo() {
+                std::memset(this, 0, sizeof(DescriptorInfo)); // We need to zero any padding alongside the inactive members
+            }
+
+            DescriptorInfo(vk::DescriptorBufferInfo pBuffer) : DescriptorInfo() {
+                buffer = pBuffer;
+            }
+
+            DescriptorInfo(vk::DescriptorImageInfo pImage) : DescriptorInfo() {
+                image = pImage;
+            }
+
+            DescriptorInfo(vk::BufferView pTexelBuffer) : DescriptorInfo() {
+                texelBuffer = pTexelBuffer;
+            }
+        };
+
+        /**
+         * @brief A descriptor set layout with all state required to update or push descriptors into it
+         * @note All bindings in the layout must have a descriptor count of 1
+         */
+        struct SetLayout {
+            vk::raii::DescriptorSetLayout vkLayout;
+            std::optional<vk::raii::DescriptorUpdateTemplate> vkUpdateTemplate; //!< The template used to update allocated sets, push descriptor layouts don't have one as they build writes directly
+            std::vector<vk::DescriptorSetLayoutBinding> bindings;
+        };
+
+      private:
+        /**
+         * @brief A pool which is reset and recycled once the last cycle that allocated from it has been signalled, its lifetime is tracked through shared pointers held by any such cycles
+         */
+        struct DescriptorPool : public FenceCycleDependency {
+            struct CachedSet {
+                vk::DescriptorSetLayout layout;
+                std::vector<DescriptorInfo> descriptors;
+                vk::DescriptorSet set;
+            };
+
+            vk::raii::DescriptorPool vkPool;
+            std::weak_ptr<FenceCycle> lastCycle; //!< The last cycle the pool was attached to, this avoids attaching it to the same cycle for every set
+            std::unordered_map<size_t, std::vector<CachedSet>> cache; //!< Sets allocated from this pool keyed by a hash of their layout and contents, they can be reused by any cycle which has the pool attached
+
+            DescriptorPool(const vk::raii::Device &device, const vk::DescriptorPoolCreateInfo &createInfo);
+        };
+
+        static constexpr u32 PoolSetCount{0x200}; //!< The amount of descriptor sets in a single pool
+        static constexpr u32 PoolDescriptorCount{PoolSetCount * 4}; //!< The amount of descriptors of each type in a single pool
+
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to the pools and the cache
+        std::list<DescriptorPool> pools; //!< All pools that were created, they're retained for the lifetime of the allocator and only ever reset
+        std::vector<DescriptorPool *> freePools; //!< Pools which have been reset and can be used again
+        std::shared_ptr<DescriptorPool> activePool; //!< The pool that sets are currently allocated from
+
+        /**
+         * @brief Resets a pool once the last reference to it has been dropped and returns it to the free list
+         */
+        void RecyclePool(DescriptorPool *pool);
+
+        /**
+         * @return A pool from the free list or a newly created one if there are none
+         * @note The mutex must be locked when calling this
+         */
+        std::shared_ptr<DescriptorPool> AcquirePool();
+
+      public:
+        DescriptorAllocator(GPU &gpu);
+
+        /**
+         * @return A layout with the supplied bindings, this must be used for any layouts which are bound through this allocator as push descriptor layouts require a creation flag
+         */
+        SetLayout CreateSetLayout(span<const vk::DescriptorSetLayoutBinding> bindings);
+
+        /**
+         * @return A descriptor set with the supplied descriptors written into it which is valid until the supplied cycle has been signalled
+         * @note An existing set with identical contents is returned if one was allocated from the active pool, new sets are updated with a single templated update
+         * @note This cannot be used with push descriptor layouts
+         */
+        vk::DescriptorSet GetSet(const std::shared_ptr<FenceCycle> &cycle, const SetLayout &layout, span<const DescriptorInfo> descriptors);
+
+        /**
+         * @brief Binds the supplied descriptors to a set index of the pipeline layout, this will push them directly into the command buffer if push descriptors are supported
+         */
+        void Bind(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, u32 setIndex, const SetLayout &layout, span<const DescriptorInfo> descriptors);
+    };
+}
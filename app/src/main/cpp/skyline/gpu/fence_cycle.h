@@ -20,7 +20,7 @@ namespace skyline::gpu {
     };
 
     /**
-     * @brief A wrapper around a Vulkan Fence which only tracks a single reset -> signal cycle with the ability to attach lifetimes of objects to it
+     * @brief A wrapper around a Vulkan Fence or a value on a timeline semaphore which only tracks a single reset -> signal cycle with the ability to attach lifetimes of objects to it
      * @note This provides the guarantee that the fence must be signalled prior to destruction when objects are to be destroyed
      * @note All waits to the fence **must** be done through the same instance of this, the state of the fence changing externally will lead to UB
      */
@@ -28,7 +28,11 @@ namespace skyline::gpu {
       private:
         std::atomic_flag signalled;
         const vk::raii::Device &device;
-        vk::Fence fence;
+        vk::Fence fence; //!< The fence signalled at the end of the cycle, this is null for cycles on a timeline semaphore
+        vk::Semaphore semaphore; //!< The timeline semaphore which reaches the value of the cycle at its end, this is null for cycles on a fence
+        static constexpr u64 UnsubmittedValue{std::numeric_limits<u64>::max()}; //!< The value of cycles on a timeline semaphore which haven't been submitted yet, the semaphore never reaches it so they're never considered signalled
+        std::atomic<u64> value{UnsubmittedValue}; //!< The value of the timeline semaphore at which this cycle is signalled, this is assigned when the cycle is submitted
+        std::atomic<u64> *completedValue{}; //!< The highest value the timeline semaphore has been observed to reach by the host, this is shared between all cycles on the semaphore so most checks don't require calling into the driver
         std::shared_ptr<FenceCycleDependency> list;
 
         /**
@@ -44,13 +48,40 @@ namespace skyline::gpu {
             }
         }
 
+        /**
+         * @brief Raises the shared completed value of the timeline semaphore to the supplied value if it's lower
+         */
+        void UpdateCompletedValue(u64 observedValue) {
+            auto current{completedValue->load(std::memory_order_relaxed)};
+            while (current < observedValue && !completedValue->compare_exchange_weak(current, observedValue, std::memory_order_release, std::memory_order_relaxed));
+        }
+
       public:
+        bool tracked{}; //!< If all accesses to resources by the commands of this cycle are tracked by the command executor, its later submissions are ordered after them by barriers rather than waiting on the cycle
+
         FenceCycle(const vk::raii::Device &device, vk::Fence fence) : signalled(false), device(device), fence(fence) {
             device.resetFences(fence);
         }
 
+        /**
+         * @note The cycle isn't signalled till its value has been assigned with AssignTimelineValue and reached by the semaphore, waits prior to that block till it's assigned
+         */
+        FenceCycle(const vk::raii::Device &device, vk::Semaphore semaphore, std::atomic<u64> &completedValue) : signalled(false), device(device), semaphore(semaphore), completedValue(&completedValue) {}
+
+        /**
+         * @brief Assigns the timeline semaphore value that the submission of this cycle will signal
+         */
+        void AssignTimelineValue(u64 pValue) {
+            value.store(pValue, std::memory_order_release);
+            value.notify_all();
+        }
+
         ~FenceCycle() {
-            Wait();
+            // A cycle on a timeline semaphore that was never submitted would never be signalled, it's cancelled instead as there's nothing to wait on
+            if (semaphore && value.load(std::memory_order_acquire) == UnsubmittedValue)
+                Cancel();
+            else
+                Wait();
         }
 
         /**
@@ -59,6 +90,11 @@ namespace skyline::gpu {
         void Cancel() {
             if (!signalled.test_and_set(std::memory_order_release))
                 DestroyDependencies();
+
+            // Any threads waiting on the cycle to be submitted are woken up, they'll observe it as signalled
+            auto expected{UnsubmittedValue};
+            if (semaphore && value.compare_exchange_strong(expected, 0, std::memory_order_acq_rel))
+                value.notify_all();
         }
 
         /**
@@ -67,19 +103,52 @@ namespace skyline::gpu {
         void Wait() {
             if (signalled.test(std::memory_order_consume))
                 return;
-            while (device.waitForFences(fence, false, std::numeric_limits<u64>::max()) != vk::Result::eSuccess);
+            if (semaphore) {
+                // The semaphore can't be waited on till the value has been assigned, a cancellation also wakes us up and is caught by the test below
+                value.wait(UnsubmittedValue, std::memory_order_acquire);
+                if (signalled.test(std::memory_order_consume))
+                    return;
+
+                u64 waitValue{value.load(std::memory_order_acquire)};
+                if (completedValue->load(std::memory_order_acquire) < waitValue) {
+                    while (device.waitSemaphoresKHR(vk::SemaphoreWaitInfoKHR{
+                        .semaphoreCount = 1,
+                        .pSemaphores = &semaphore,
+                        .pValues = &waitValue,
+                    }, std::numeric_limits<u64>::max()) != vk::Result::eSuccess);
+                    UpdateCompletedValue(waitValue);
+                }
+            } else {
+                while (device.waitForFences(fence, false, std::numeric_limits<u64>::max()) != vk::Result::eSuccess);
+            }
             if (!signalled.test_and_set(std::memory_order_release))
                 DestroyDependencies();
         }
 
         /**
          * @brief Wait on a fence cycle with a timeout in nanoseconds
-         * @return If the wait was successful or timed out
+         * @return If the wait was successful or timed out, a cycle on a timeline semaphore which hasn't been submitted yet is treated as timed out
          */
         bool Wait(std::chrono::duration<u64, std::nano> timeout) {
             if (signalled.test(std::memory_order_consume))
                 return true;
-            if (device.waitForFences(fence, false, timeout.count()) == vk::Result::eSuccess) {
+            bool success;
+            if (semaphore) {
+                u64 waitValue{value.load(std::memory_order_acquire)};
+                if (waitValue == UnsubmittedValue)
+                    return false;
+
+                success = completedValue->load(std::memory_order_acquire) >= waitValue || device.waitSemaphoresKHR(vk::SemaphoreWaitInfoKHR{
+                    .semaphoreCount = 1,
+                    .pSemaphores = &semaphore,
+                    .pValues = &waitValue,
+                }, timeout.count()) == vk::Result::eSuccess;
+                if (success)
+                    UpdateCompletedValue(waitValue);
+            } else {
+                success = device.waitForFences(fence, false, timeout.count()) == vk::Result::eSuccess;
+            }
+            if (success) {
                 if (!signalled.test_and_set(std::memory_order_release))
                     DestroyDependencies();
                 return true;
@@ -94,8 +163,22 @@ namespace skyline::gpu {
         bool Poll() {
             if (signalled.test(std::memory_order_consume))
                 return true;
-            auto status{(*device).getFenceStatus(fence, *device.getDispatcher())};
-            if (status == vk::Result::eSuccess) {
+            bool success;
+            if (semaphore) {
+                u64 pollValue{value.load(std::memory_order_acquire)};
+                if (pollValue == UnsubmittedValue)
+                    return false; // The cycle can't have been signalled if it hasn't been submitted, this is checked explicitly to avoid querying the semaphore
+
+                success = completedValue->load(std::memory_order_acquire) >= pollValue;
+                if (!success) {
+                    // We only query the semaphore when the cached value is behind, the queried value is shared with all other cycles to avoid querying for each of them
+                    UpdateCompletedValue((*device).getSemaphoreCounterValueKHR(semaphore, *device.getDispatcher()));
+                    success = completedValue->load(std::memory_order_acquire) >= pollValue;
+                }
+            } else {
+                success = (*device).getFenceStatus(fence, *device.getDispatcher()) == vk::Result::eSuccess;
+            }
+            if (success) {
                 if (!signalled.test_and_set(std::memory_order_release))
                     DestroyDependencies();
                 return true;
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "framebuffer_cache.h"
+
+namespace skyline::gpu {
+    size_t FramebufferCache::FramebufferKeyHash::operator()(const FramebufferKey &key) const {
+        size_t hash{std::hash<VkRenderPass>{}(static_cast<VkRenderPass>(key.renderPass))};
+        auto combine{[&hash](size_t value) {
+            hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        }};
+        combine((static_cast<size_t>(key.extent.width) << 32) | key.extent.height);
+        for (auto attachment : key.attachments)
+            combine(std::hash<VkImageView>{}(static_cast<VkImageView>(attachment)));
+        return hash;
+    }
+
+    bool FramebufferCache::CachedFramebuffer::Valid() const {
+        return std::none_of(textures.begin(), textures.end(), [](const std::weak_ptr<Texture> &texture) {
+            return texture.expired();
+        });
+    }
+
+    FramebufferCache::FramebufferCache(GPU &gpu) : gpu(gpu) {}
+
+    vk::Framebuffer FramebufferCache::GetFramebuffer(const vk::FramebufferCreateInfo &createInfo, span<const std::shared_ptr<Texture>> textures) {
+        FramebufferKey key{
+            .renderPass = createInfo.renderPass,
+            .extent = {createInfo.width, createInfo.height},
+            .attachments = {createInfo.pAttachments, createInfo.pAttachments + createInfo.attachmentCount},
+        };
+
+        std::scoped_lock lock(mutex);
+        auto it{framebuffers.find(key)};
+        if (it != framebuffers.end()) {
+            if (it->second.Valid())
+                return *it->second.framebuffer;
+            framebuffers.erase(it); // The image view handles have been recycled from a destroyed texture, the framebuffer must be recreated
+        }
+
+        TRACE_EVENT("gpu", "FramebufferCache::GetFramebuffer::Create");
+
+        if (framebuffers.size() >= EvictionThreshold)
+            std::erase_if(framebuffers, [](const auto &item) {
+                return !item.second.Valid();
+            });
+
+        return *framebuffers.emplace(std::move(key), CachedFramebuffer{
+            .framebuffer = vk::raii::Framebuffer(gpu.vkDevice, createInfo),
+            .textures = {textures.begin(), textures.end()},
+        }).first->second.framebuffer;
+    }
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vulkan/vulkan_raii.hpp>
+#include <common.h>
+
+namespace skyline::gpu {
+    class GPU;
+    class Texture;
+
+    /**
+     * @brief A cache of Vulkan framebuffers keyed on their render pass, dimensions and the set of image views bound to them
+     * @note This class is thread-safe and is shared between all command executors
+     * @note Framebuffers are evicted once any texture that their image views belong to has been destroyed, this also prevents a new image view with a recycled handle from matching
+     */
+    class FramebufferCache {
+      private:
+        struct FramebufferKey {
+            vk::RenderPass renderPass;
+            vk::Extent2D extent;
+            std::vector<vk::ImageView> attachments;
+
+            bool operator==(const FramebufferKey &) const = default;
+        };
+
+        struct FramebufferKeyHash {
+            size_t operator()(const FramebufferKey &key) const;
+        };
+
+        struct CachedFramebuffer {
+            vk::raii::Framebuffer framebuffer;
+            std::vector<std::weak_ptr<Texture>> textures; //!< The textures backing the attachments of the framebuffer, the framebuffer is stale if any of these have expired
+
+            /**
+             * @return If all textures backing the attachments of the framebuffer are still alive
+             */
+            bool Valid() const;
+        };
+
+        static constexpr size_t EvictionThreshold{0x100}; //!< The amount of framebuffers in the cache after which stale ones are evicted on creation of a new framebuffer
+
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to the cache
+        std::unordered_map<FramebufferKey, CachedFramebuffer, FramebufferKeyHash> framebuffers;
+
+      public:
+        FramebufferCache(GPU &gpu);
+
+        /**
+         * @param textures All textures backing the attachments in the creation info, these are used to track the validity of the framebuffer
+         * @return A framebuffer matching the supplied creation info, it'll be created if there's no valid matching framebuffer in the cache
+         * @note The returned framebuffer is valid for as long as the supplied textures are alive
+         */
+        vk::Framebuffer GetFramebuffer(const vk::FramebufferCreateInfo &createInfo, span<const std::shared_ptr<Texture>> textures);
+    };
+}
@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu.h>
+
+namespace skyline::gpu::interconnect {
+    /**
+     * @brief A linear arena which typed command nodes are placement-constructed into and recorded from in the order they were added
+     * @note Memory is retained across resets so that steady-state node creation requires no heap allocations
+     */
+    class CommandArena {
+      private:
+        /**
+         * @brief The type-erased header of every node in the arena, nodes form a singly linked list through this
+         */
+        struct NodeHeader {
+            NodeHeader *next{};
+            void (*record)(NodeHeader *header, vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu);
+            void (*destroy)(NodeHeader *header);
+        };
+
+        template<typename NodeType>
+        struct Node : public NodeHeader {
+            NodeType node;
+
+            template<typename... Args>
+            Node(Args &&... args) : NodeHeader{nullptr, &Record, &Destroy}, node(std::forward<Args>(args)...) {}
+
+            static void Record(NodeHeader *header, vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+                static_cast<Node *>(header)->node(commandBuffer, cycle, gpu);
+            }
+
+            static void Destroy(NodeHeader *header) {
+                std::destroy_at(static_cast<Node *>(header));
+            }
+        };
+
+        static constexpr size_t BlockSize{0x10000}; //!< The minimum size of a block of memory in the arena
+
+        /**
+         * @brief A contiguous block of memory which nodes are linearly allocated from
+         */
+        struct Block {
+            std::unique_ptr<u8[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t offset{}; //!< The offset of free memory in the last block
+        NodeHeader *head{}; //!< The oldest node in the arena
+        NodeHeader *tail{}; //!< The newest node in the arena
+        size_t size{}; //!< The amount of nodes in the arena, this excludes any nodes that have been split off from it
+
+        /**
+         * @return A pointer to uninitialized memory of the supplied size and alignment from the arena
+         */
+        u8 *Allocate(size_t size, size_t alignment) {
+            if (!blocks.empty()) {
+                auto &block{blocks.back()};
+                auto alignedOffset{util::AlignUp(offset, alignment)};
+                if (alignedOffset + size <= block.size) [[likely]] {
+                    offset = alignedOffset + size;
+                    return block.data.get() + alignedOffset;
+                }
+            }
+
+            auto blockSize{std::max(size, BlockSize)};
+            blocks.push_back(Block{std::make_unique<u8[]>(blockSize), blockSize});
+            offset = size;
+            return blocks.back().data.get();
+        }
+
+      public:
+        /**
+         * @brief An opaque reference to a node in the arena which nodes can be split off after
+         */
+        class Marker {
+          private:
+            NodeHeader *node{}; //!< The node which the marker is after, this is null for the start of the arena
+            friend CommandArena;
+
+          public:
+            Marker() = default;
+
+          private:
+            Marker(NodeHeader *node) : node(node) {}
+        };
+
+        /**
+         * @brief A sequence of nodes which has been split off from the arena, these can be recorded independently of it such as into secondary command buffers
+         * @note The memory of the nodes is still owned by the arena, the list must be destroyed prior to the arena being reset
+         */
+        class NodeList {
+          private:
+            NodeHeader *head{};
+            NodeHeader *tail{};
+            size_t size{};
+            friend CommandArena;
+
+          public:
+            NodeList() = default;
+
+            NodeList(const NodeList &) = delete;
+
+            NodeList &operator=(const NodeList &) = delete;
+
+            NodeList(NodeList &&other) : head(std::exchange(other.head, nullptr)), tail(std::exchange(other.tail, nullptr)), size(std::exchange(other.size, 0)) {}
+
+            NodeList &operator=(NodeList &&other) {
+                Destroy();
+                head = std::exchange(other.head, nullptr);
+                tail = std::exchange(other.tail, nullptr);
+                size = std::exchange(other.size, 0);
+                return *this;
+            }
+
+            ~NodeList() {
+                Destroy();
+            }
+
+            void Destroy() {
+                for (auto node{head}; node;) {
+                    auto next{node->next};
+                    node->destroy(node);
+                    node = next;
+                }
+                head = tail = nullptr;
+                size = 0;
+            }
+
+            size_t Size() const {
+                return size;
+            }
+
+            /**
+             * @brief Records all nodes in the list into the supplied command buffer in order
+             */
+            void Record(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) const {
+                for (auto node{head}; node; node = node->next)
+                    node->record(node, commandBuffer, cycle, gpu);
+            }
+
+            /**
+             * @brief Splits the list into up to the supplied amount of consecutive lists with an equal amount of nodes
+             */
+            std::vector<NodeList> Split(size_t count) && {
+                std::vector<NodeList> lists;
+                auto nodesPerList{(size + count - 1) / count};
+                while (head) {
+                    auto &list{lists.emplace_back()};
+                    list.head = head;
+                    for (list.tail = head, list.size = 1; list.size < nodesPerList && list.tail->next; list.size++)
+                        list.tail = list.tail->next;
+                    head = std::exchange(list.tail->next, nullptr);
+                }
+                tail = nullptr;
+                size = 0;
+                return lists;
+            }
+        };
+
+        CommandArena() = default;
+
+        CommandArena(const CommandArena &) = delete;
+
+        CommandArena &operator=(const CommandArena &) = delete;
+
+        CommandArena(CommandArena &&other) : blocks(std::move(other.blocks)), offset(std::exchange(other.offset, 0)), head(std::exchange(other.head, nullptr)), tail(std::exchange(other.tail, nullptr)), size(std::exchange(other.size, 0)) {
+            other.blocks.clear();
+        }
+
+        CommandArena &operator=(CommandArena &&other) {
+            Reset();
+            blocks = std::move(other.blocks);
+            other.blocks.clear();
+            offset = std::exchange(other.offset, 0);
+            head = std::exchange(other.head, nullptr);
+            tail = std::exchange(other.tail, nullptr);
+            size = std::exchange(other.size, 0);
+            return *this;
+        }
+
+        ~CommandArena() {
+            Reset();
+        }
+
+        /**
+         * @brief Placement-constructs a node at the end of the arena
+         * @return A reference to the constructed node, this remains valid till the arena is reset
+         */
+        template<typename NodeType, typename... Args>
+        NodeType &Emplace(Args &&... args) {
+            static_assert(alignof(Node<NodeType>) <= alignof(std::max_align_t));
+            auto node{new (Allocate(sizeof(Node<NodeType>), alignof(Node<NodeType>))) Node<NodeType>(std::forward<Args>(args)...)};
+            if (tail)
+                tail->next = node;
+            else
+                head = node;
+            tail = node;
+            size++;
+            return node->node;
+        }
+
+        /**
+         * @return The amount of nodes in the arena
+         */
+        size_t Size() {
+            return size;
+        }
+
+        /**
+         * @return A marker after the newest node in the arena
+         */
+        Marker GetTail() {
+            return Marker{tail};
+        }
+
+        /**
+         * @brief Splits off all nodes after the supplied marker from the arena, they're no longer recorded with it
+         */
+        NodeList SplitAfter(Marker marker) {
+            NodeList list;
+            list.head = marker.node ? marker.node->next : head;
+            if (!list.head)
+                return list;
+
+            list.tail = tail;
+            for (auto node{list.head}; node; node = node->next)
+                list.size++;
+            size -= list.size;
+
+            if (marker.node)
+                marker.node->next = nullptr;
+            else
+                head = nullptr;
+            tail = marker.node;
+            return list;
+        }
+
+        /**
+         * @brief Appends all nodes of a list to the end of the arena, they're recorded and destroyed with it
+         */
+        void Append(NodeList &&list) {
+            if (!list.head)
+                return;
+
+            if (tail)
+                tail->next = list.head;
+            else
+                head = list.head;
+            tail = list.tail;
+            size += std::exchange(list.size, 0);
+            list.head = list.tail = nullptr;
+        }
+
+        /**
+         * @return If there are no nodes in the arena
+         */
+        bool Empty() {
+            return head == nullptr;
+        }
+
+        /**
+         * @brief Records all nodes in the arena into the supplied command buffer in the order they were added
+         */
+        void Record(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+            for (auto node{head}; node; node = node->next)
+                node->record(node, commandBuffer, cycle, gpu);
+        }
+
+        /**
+         * @brief Destroys all nodes in the arena while retaining its memory, any blocks are coalesced into a single block so later usage doesn't need to allocate
+         */
+        void Reset() {
+            for (auto node{head}; node;) {
+                auto next{node->next};
+                node->destroy(node);
+                node = next;
+            }
+            head = tail = nullptr;
+            size = 0;
+            offset = 0;
+
+            if (blocks.size() > 1) {
+                size_t totalSize{};
+                for (const auto &block : blocks)
+                    totalSize += block.size;
+                blocks.clear();
+                blocks.push_back(Block{std::make_unique<u8[]>(totalSize), totalSize});
+            }
+        }
+    };
+}
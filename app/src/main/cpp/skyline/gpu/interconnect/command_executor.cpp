@@ -2,101 +2,486 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <gpu.h>
+#include <loader/loader.h>
+#include <kernel/types/KProcess.h>
+#include <common/signal.h>
 #include "command_executor.h"
 
 namespace skyline::gpu::interconnect {
-    CommandExecutor::CommandExecutor(const DeviceState &state) : gpu(*state.gpu) {}
+    static std::atomic<u64> RenderPassCount{}; //!< The amount of render passes created by all executors, this is used to assign them unique indices
 
-    bool CommandExecutor::CreateRenderPass(vk::Rect2D renderArea) {
-        if (renderPass && renderPass->renderArea != renderArea) {
-            nodes.emplace_back(std::in_place_type_t<node::RenderPassEndNode>());
-            renderPass = nullptr;
+    CommandExecutor::CommandExecutor(const DeviceState &state) : state(state), gpu(*state.gpu), queries(gpu), recordThread(&CommandExecutor::RecordThread, this), completionThread(&CommandExecutor::CompletionThread, this) {
+        if (state.settings->parallelRecording)
+            recordPool.emplace(RecordWorkerCount);
+    }
+
+    CommandExecutor::~CommandExecutor() {
+        for (auto thread : {&recordThread, &completionThread}) {
+            if (thread->joinable()) {
+                pthread_kill(thread->native_handle(), SIGINT);
+                thread->join();
+            }
+        }
+    }
+
+    void CommandExecutor::RecordThread() {
+        pthread_setname_np(pthread_self(), "GPU-Record");
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+            while (true) {
+                auto submission{submissionQueue.Pop()};
+                Record(submission);
+                recordedCount.fetch_add(1, std::memory_order_release);
+                recordedCount.notify_all();
+            }
+        } catch (const signal::SignalException &e) {
+            if (e.signal != SIGINT) {
+                Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+                signal::BlockSignal({SIGINT});
+                state.process->Kill(false);
+            }
+        } catch (const std::exception &e) {
+            Logger::Error(e.what());
+            signal::BlockSignal({SIGINT});
+            state.process->Kill(false);
         }
+    }
+
+    void CommandExecutor::CompletionThread() {
+        pthread_setname_np(pthread_self(), "GPU-Completion");
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+            completionQueue.Process([this](Completion &completion) {
+                if (completion.cycle) {
+                    {
+                        TRACE_EVENT("gpu", "CommandExecutor::WaitCompletion");
+                        completion.cycle->Wait();
+                    }
+
+                    completion.arena.Reset();
+                    std::scoped_lock lock(arenaMutex);
+                    freeArenas.push_back(std::move(completion.arena));
+                }
+
+                // Reports are written back prior to the callback as the guest observes them after being signalled by it, the batch is released afterwards to recycle its pools
+                queries.Resolve(completion.queries);
+                completion.queries = {};
+
+                // Semaphores are released in order after the reports as the guest commonly uses them to signal the reports being available
+                for (const auto &release : completion.releases) {
+                    if (release.fourWords) {
+                        struct FourWordResult {
+                            u64 value;
+                            u64 timestamp;
+                        } result{release.value, util::GetGpuTimeTicks()};
+                        std::memcpy(release.address, &result, sizeof(result));
+                    } else {
+                        auto result{static_cast<u32>(release.value)};
+                        std::memcpy(release.address, &result, sizeof(result));
+                    }
+                }
+
+                // Callbacks such as syncpoint increments are only called once the host GPU has actually reached this point in the command stream
+                if (completion.callback)
+                    completion.callback();
+            });
+        } catch (const signal::SignalException &e) {
+            if (e.signal != SIGINT) {
+                Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+                signal::BlockSignal({SIGINT});
+                state.process->Kill(false);
+            }
+        } catch (const std::exception &e) {
+            Logger::Error(e.what());
+            signal::BlockSignal({SIGINT});
+            state.process->Kill(false);
+        }
+    }
+
+    void CommandExecutor::Record(Submission &submission) {
+        std::shared_ptr<FenceCycle> cycle;
+        if (!submission.arena.Empty()) {
+            TRACE_EVENT("gpu", "CommandExecutor::Record");
+
+            // Textures used by prior submissions aren't waited on as the barriers of this one order it after them, only the submission FramesInFlight back is waited on, prior to locking anything, to bound how far the host can get ahead of the GPU
+            auto &frameCycle{frameCycles[frameIndex]};
+            if (frameCycle) {
+                TRACE_EVENT("gpu", "CommandExecutor::WaitFrame");
+                frameCycle->Wait();
+            }
+
+            // Textures are locked for the duration of recording as the assembling thread may concurrently be using them
+            std::vector<std::unique_lock<Texture>> textureLocks;
+            textureLocks.reserve(submission.syncTextures.size());
+            for (auto texture : submission.syncTextures)
+                textureLocks.emplace_back(*texture);
+
+            std::vector<std::unique_lock<Buffer>> bufferLocks;
+            bufferLocks.reserve(submission.syncBuffers.size());
+            for (auto buffer : submission.syncBuffers)
+                bufferLocks.emplace_back(*buffer);
+
+            cycle = gpu.scheduler.SubmitWithCycle([this, &submission](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle) {
+                cycle->tracked = true;
+
+                // Any deferred layout transitions are batched into a single barrier prior to the first node rather than each texture recording its own, prior submissions may still be accessing the textures
+                layoutBarriers.clear();
+                for (auto texture : submission.syncTextures)
+                    texture->RecordDeferredLayout(layoutBarriers);
+                if (!layoutBarriers.empty())
+                    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, layoutBarriers);
+
+                if (submission.prologueBarrier)
+                    submission.prologueBarrier.Record(commandBuffer);
+
+                submission.queries.RecordReset(commandBuffer);
+
+                // Textures without a guest texture such as transient attachments only exist on the host and have nothing to synchronize
+                for (auto texture : submission.syncTextures)
+                    if (texture->guest)
+                        texture->SynchronizeHostWithBuffer(commandBuffer, cycle);
+
+                for (auto buffer : submission.syncBuffers)
+                    buffer->SynchronizeHostWithBuffer(commandBuffer, cycle);
+
+                submission.arena.Record(commandBuffer, cycle, gpu);
+
+                for (auto texture : submission.syncTextures)
+                    if (texture->guest)
+                        texture->SynchronizeGuestWithBuffer(commandBuffer, cycle);
+            });
+
+            frameCycle = cycle;
+            frameIndex = (frameIndex + 1) % FramesInFlight;
+        }
+
+        // The pending records of the textures are only dropped after they've been unlocked as any waiters lock them right after
+        for (auto texture : submission.syncTextures)
+            if (texture->pendingRecords.fetch_sub(1, std::memory_order_release) == 1)
+                texture->pendingRecords.notify_all();
+
+        // Submissions without a cycle are still queued as their callback must be ordered after the completion of prior submissions
+        if (cycle || submission.callback || !submission.queries.reports.empty() || !submission.releases.empty())
+            completionQueue.Push(Completion{
+                .cycle = std::move(cycle),
+                .arena = std::move(submission.arena),
+                .queries = std::move(submission.queries),
+                .releases = std::move(submission.releases),
+                .callback = std::move(submission.callback),
+            });
+    }
+
+    void CommandExecutor::TrackAccess(AccessState &accessState, vk::PipelineStageFlags stages, vk::AccessFlags access, bool attachment) {
+        if (attachment && renderPass && accessState.renderPassIndex == renderPassIndex) {
+            PipelineBarrier subpassBarrier{}; // Accesses from earlier subpasses are synchronized by the subpass dependencies of the render pass
+            accessState.Access(subpassBarrier, stages, access);
+        } else {
+            accessState.Access(pendingBarrier, stages, access);
+            accessState.renderPassIndex = 0;
+        }
+    }
+
+    void CommandExecutor::FlushBarrier() {
+        if (pendingBarrier) {
+            arena.Emplace<node::BarrierNode>(pendingBarrier);
+            pendingBarrier = {};
+        }
+    }
+
+    bool CommandExecutor::CreateRenderPass(vk::Rect2D renderArea, span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment) {
+        auto forEachAttachment{[&](auto function) {
+            for (auto &attachment : inputAttachments)
+                function(*attachment.backing, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eInputAttachmentRead);
+            for (auto &attachment : colorAttachments)
+                function(*attachment.backing, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
+            if (depthStencilAttachment)
+                function(*depthStencilAttachment->backing, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests, vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+        }};
+
+        if (renderPass) {
+            vk::Extent2D attachmentExtent{std::numeric_limits<u32>::max(), std::numeric_limits<u32>::max()};
+            forEachAttachment([&](Texture &texture, vk::PipelineStageFlags, vk::AccessFlags) {
+                attachmentExtent.width = std::min(attachmentExtent.width, texture.dimensions.width);
+                attachmentExtent.height = std::min(attachmentExtent.height, texture.dimensions.height);
+            });
+
+            if (!renderPass->MergeRenderArea(renderArea, attachmentExtent))
+                FinishRenderPass();
+        }
+
+        forEachAttachment([this](Texture &texture, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+            if (syncTextures.emplace(&texture).second && texture.guest)
+                texture.accessState.Access(prologueBarrier, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+            TrackAccess(texture.accessState, stages, access, true);
+        });
+
+        // Barriers can't be recorded inside a render pass, it needs to be ended if any attachment requires one
+        if (pendingBarrier)
+            FinishRenderPass();
 
         bool newRenderPass{renderPass == nullptr};
-        if (newRenderPass)
+        if (newRenderPass) {
             // We need to create a render pass if one doesn't already exist or the current one isn't compatible
-            renderPass = &std::get<node::RenderPassNode>(nodes.emplace_back(std::in_place_type_t<node::RenderPassNode>(), renderArea));
+            FlushBarrier();
+            renderPass = &arena.Emplace<node::RenderPassNode>(renderArea);
+            renderPassMarker = arena.GetTail();
+            renderPassStart = arena.Size();
+            renderPassIndex = ++RenderPassCount;
+        }
+
+        forEachAttachment([this](Texture &texture, vk::PipelineStageFlags, vk::AccessFlags) {
+            texture.accessState.renderPassIndex = renderPassIndex;
+        });
 
         return newRenderPass;
     }
 
-    void CommandExecutor::AddSubpass(const std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)> &function, vk::Rect2D renderArea, std::vector<TextureView> inputAttachments, std::vector<TextureView> colorAttachments, std::optional<TextureView> depthStencilAttachment) {
+    bool CommandExecutor::CreateSubpass(vk::Rect2D renderArea, span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment) {
+        bool newRenderPass{CreateRenderPass(renderArea, inputAttachments, colorAttachments, depthStencilAttachment)};
+        bool reuseSubpass{!newRenderPass && renderPass->MatchesSubpass(inputAttachments, colorAttachments, depthStencilAttachment)};
+        if (!reuseSubpass)
+            renderPass->AddSubpass(inputAttachments, colorAttachments, depthStencilAttachment);
+        clearSubpass = false;
+
         for (const auto &attachments : {inputAttachments, colorAttachments})
             for (const auto &attachment : attachments)
-                syncTextures.emplace(attachment.backing.get());
+                UpdateAttachmentStore(attachment.backing.get(), false);
         if (depthStencilAttachment)
-            syncTextures.emplace(depthStencilAttachment->backing.get());
+            UpdateAttachmentStore(depthStencilAttachment->backing.get(), false);
+
+        return newRenderPass || reuseSubpass;
+    }
+
+    void CommandExecutor::UpdateAttachmentStore(Texture *texture, bool overwritten) {
+        auto &storingRenderPass{storedAttachments[texture]};
+        if (overwritten && storingRenderPass && storingRenderPass != renderPass)
+            storingRenderPass->DiscardAttachments(texture); // The contents stored by the prior render pass are overwritten without ever being read
+        storingRenderPass = renderPass;
+    }
+
+    bool CommandExecutor::IsRenderingSkipped(span<TextureView> colorAttachments) {
+        if (!state.settings->frameSkipRendering || colorAttachments.empty())
+            return false;
 
-        bool newRenderPass{CreateRenderPass(renderArea)};
-        renderPass->AddSubpass(inputAttachments, colorAttachments, depthStencilAttachment ? &*depthStencilAttachment : nullptr);
-        if (newRenderPass)
-            nodes.emplace_back(std::in_place_type_t<node::FunctionNode>(), function);
-        else
-            nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), function);
+        for (const auto &attachment : colorAttachments)
+            if (!attachment.backing->presentable.load(std::memory_order_relaxed))
+                return false; // Any other attachments may be read by later frames, only rendering whose sole consumer is the dropped presentation can be skipped
+
+        auto target{colorAttachments.front().backing.get()};
+        auto queuedFrames{gpu.presentation.queuedFrames.load(std::memory_order_relaxed)};
+        if (target != frameTarget || queuedFrames != frameTargetIndex) {
+            frameTarget = target;
+            frameTargetIndex = queuedFrames;
+            frameSkipped = gpu.presentation.SkipFrameRendering();
+        }
+
+        if (frameSkipped)
+            for (const auto &attachment : colorAttachments)
+                attachment.backing->presentSkipped.store(true, std::memory_order_release);
+        return frameSkipped;
+    }
+
+    void CommandExecutor::NextSubpass() {
+        auto previous{arena.GetTail()};
+        auto &node{arena.Emplace<node::NextSubpassNode>()};
+        subpassTransitions.push_back(SubpassTransition{previous, arena.GetTail(), &node});
+    }
+
+    void CommandExecutor::SplitRenderPassIntoSecondaries() {
+        // The nodes of every subpass are split off back to front, the transitions between subpasses remain in the primary command buffer
+        std::vector<CommandArena::NodeList> subpasses(subpassTransitions.size() + 1);
+        std::vector<CommandArena::NodeList> transitions(subpassTransitions.size());
+        for (size_t index{subpassTransitions.size()}; index > 0; index--) {
+            auto &transition{subpassTransitions[index - 1]};
+            subpasses[index] = arena.SplitAfter(transition.marker);
+            transitions[index - 1] = arena.SplitAfter(transition.previous);
+            transition.node->contents = vk::SubpassContents::eSecondaryCommandBuffers;
+        }
+        subpasses[0] = arena.SplitAfter(renderPassMarker);
+        renderPass->subpassContents = vk::SubpassContents::eSecondaryCommandBuffers;
+
+        for (u32 index{}; index < subpasses.size(); index++) {
+            if (index)
+                arena.Append(std::move(transitions[index - 1]));
+
+            // Every thread records a similar amount of nodes, subpasses that are too small to be worth splitting are recorded into a single secondary command buffer
+            auto &nodes{subpasses[index]};
+            auto count{std::clamp<size_t>(nodes.Size() / MinSecondaryNodes, 1, RecordWorkerCount + 1)};
+            arena.Emplace<node::SecondaryCommandsNode>(*renderPass, index, std::move(nodes).Split(count), *recordPool);
+        }
+    }
+
+    void CommandExecutor::FinishRenderPass() {
+        if (renderPass) {
+            if (recordPool && arena.Size() - renderPassStart >= MinSecondaryNodes)
+                SplitRenderPassIntoSecondaries();
+            arena.Emplace<node::RenderPassEndNode>();
+            renderPass = nullptr;
+            subpassTransitions.clear();
+        }
+    }
+
+    void CommandExecutor::AttachTexture(Texture *texture, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+        // The synchronization of the texture prior to execution is conservatively treated as a write by transfers, it may not write anything if the texture isn't dirty
+        if (syncTextures.emplace(texture).second && texture->guest)
+            texture->accessState.Access(prologueBarrier, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        TrackAccess(texture->accessState, stages, access);
+
+        // Transfers may read or only partially overwrite the texture, the contents stored by any prior render pass must be retained
+        storedAttachments.erase(texture);
+    }
+
+    void CommandExecutor::AttachBuffer(Buffer *buffer, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+        if (syncBuffers.emplace(buffer).second)
+            buffer->accessState.Access(prologueBarrier, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        TrackAccess(buffer->accessState, stages, access);
     }
 
     void CommandExecutor::AddClearColorSubpass(TextureView attachment, const vk::ClearColorValue &value) {
+        if (!queries.IsRenderEnabled())
+            return; // Clears are subject to the render condition like draws
+
+        if (IsRenderingSkipped(span<TextureView>(&attachment, 1))) [[unlikely]]
+            return;
+
+        if (queries.IsRenderConditional()) [[unlikely]] {
+            // Load operations can't be conditional, the clear is recorded as a command inside a subpass within the scope of the condition instead
+            AddSubpass([extent = attachment.backing->dimensions, value](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+                commandBuffer.clearAttachments(vk::ClearAttachment{
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .colorAttachment = 0,
+                    .clearValue = value,
+                }, vk::ClearRect{
+                    .rect = vk::Rect2D{.extent = extent},
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                });
+            }, vk::Rect2D{.extent = attachment.backing->dimensions}, {}, {attachment});
+            return;
+        }
+
+        // The render area can't grow beyond the attachment, it's guaranteed to cover the entire attachment after this
         bool newRenderPass{CreateRenderPass(vk::Rect2D{
             .extent = attachment.backing->dimensions,
-        })};
-        renderPass->AddSubpass({}, attachment, nullptr);
+        }, {}, attachment, nullptr)};
 
-        if (renderPass->ClearColorAttachment(0, value)) {
-            if (!newRenderPass)
-                nodes.emplace_back(std::in_place_type_t<node::NextSubpassNode>());
-        } else {
-            auto function{[scissor = attachment.backing->dimensions, value](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+        auto &texture{*attachment.backing};
+        auto clearFunction{[scissor = texture.dimensions, value](u32 colorAttachment) {
+            return [scissor, value, colorAttachment](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
                 commandBuffer.clearAttachments(vk::ClearAttachment{
                     .aspectMask = vk::ImageAspectFlagBits::eColor,
-                    .colorAttachment = 0,
+                    .colorAttachment = colorAttachment,
                     .clearValue = value,
                 }, vk::ClearRect{
                     .rect = vk::Rect2D{.extent = scissor},
                     .baseArrayLayer = 0,
                     .layerCount = 1,
                 });
-            }};
+            };
+        }};
+
+        if (!newRenderPass) {
+            if (auto colorAttachment{renderPass->GetColorAttachment(attachment)}) {
+                // The attachment is already bound to the current subpass, it can be cleared inside it rather than progressing to another subpass
+                UpdateAttachmentStore(&texture, false);
+                auto function{clearFunction(*colorAttachment)};
+                arena.Emplace<node::FunctionNode<decltype(function)>>(function);
+                return;
+            }
+
+            if (clearSubpass) {
+                // Games commonly clear every render target separately, these are folded into the load operations of a single subpass
+                if (auto colorAttachment{renderPass->AppendColorAttachment(attachment)}) {
+                    if (renderPass->ClearColorAttachment(*colorAttachment, value)) {
+                        UpdateAttachmentStore(&texture, texture.mipLevels == 1 && texture.layerCount == 1);
+                    } else {
+                        UpdateAttachmentStore(&texture, false);
+                        auto function{clearFunction(*colorAttachment)};
+                        arena.Emplace<node::FunctionNode<decltype(function)>>(function);
+                    }
+                    return;
+                }
+            }
+        }
+
+        renderPass->AddSubpass({}, attachment, nullptr);
+        clearSubpass = true;
+        if (!newRenderPass)
+            NextSubpass();
+
+        if (renderPass->ClearColorAttachment(0, value)) {
+            // VK_ATTACHMENT_LOAD_OP_CLEAR overwrites the view without reading it, if it covers the entire texture then any prior store of it is redundant
+            UpdateAttachmentStore(&texture, texture.mipLevels == 1 && texture.layerCount == 1);
+        } else {
+            UpdateAttachmentStore(&texture, false);
 
-            if (newRenderPass)
-                nodes.emplace_back(std::in_place_type_t<node::FunctionNode>(), function);
-            else
-                nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), function);
+            auto function{clearFunction(0)};
+            arena.Emplace<node::FunctionNode<decltype(function)>>(function);
         }
     }
 
-    void CommandExecutor::Execute() {
-        if (!nodes.empty()) {
-            TRACE_EVENT("gpu", "CommandExecutor::Execute");
+    void CommandExecutor::SetRenderCondition(RenderCondition condition, u8 *address) {
+        if (auto copy{queries.SetRenderCondition(condition, address)})
+            AddOutsideRpCommand([copy = *copy](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+                copy.Record(commandBuffer);
+            });
+    }
 
-            if (renderPass) {
-                nodes.emplace_back(std::in_place_type_t<node::RenderPassEndNode>());
-                renderPass = nullptr;
-            }
+    void CommandExecutor::FlushReleases() {
+        if (!releases.empty())
+            Execute();
+    }
 
-            gpu.scheduler.SubmitWithCycle([this](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle) {
-                for (auto texture : syncTextures)
-                    texture->SynchronizeHostWithBuffer(commandBuffer, cycle);
-
-                using namespace node;
-                for (NodeVariant &node : nodes) {
-                    #define NODE(name) [&](name& node) { node(commandBuffer, cycle, gpu); }
-                    std::visit(VariantVisitor{
-                        NODE(FunctionNode),
-                        NODE(RenderPassNode),
-                        NODE(NextSubpassNode),
-                        NODE(NextSubpassFunctionNode),
-                        NODE(RenderPassEndNode),
-                    }, node);
-                    #undef NODE
-                }
+    void CommandExecutor::Execute(std::function<void()> callback) {
+        FinishRenderPass();
 
-                for (auto texture : syncTextures)
-                    texture->SynchronizeGuestWithBuffer(commandBuffer, cycle);
-            })->Wait();
+        // The synchronization of textures back to the guest after execution reads them with transfers
+        for (auto texture : syncTextures)
+            if (texture->guest)
+                TrackAccess(texture->accessState, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+        FlushBarrier();
+
+        // Submissions without any nodes are still queued as their callback, reports and releases need to be ordered after any prior submissions
+        auto queryBatch{queries.Flush()};
+        if (!arena.Empty() || callback || !queryBatch.reports.empty() || !releases.empty()) {
+            TRACE_EVENT("gpu", "CommandExecutor::Execute");
 
-            nodes.clear();
+            for (auto texture : syncTextures)
+                texture->pendingRecords.fetch_add(1, std::memory_order_relaxed);
+
+            submittedCount++;
+            submissionQueue.Push(Submission{
+                .arena = std::move(arena),
+                .syncTextures = std::move(syncTextures),
+                .syncBuffers = std::move(syncBuffers),
+                .prologueBarrier = std::exchange(prologueBarrier, {}),
+                .queries = std::move(queryBatch),
+                .releases = std::exchange(releases, {}),
+                .callback = std::move(callback),
+            });
+
+            {
+                std::scoped_lock lock(arenaMutex);
+                if (!freeArenas.empty()) {
+                    arena = std::move(freeArenas.back());
+                    freeArenas.pop_back();
+                }
+            }
             syncTextures.clear();
+            syncBuffers.clear();
+            storedAttachments.clear(); // The textures are read by their synchronization to the guest after execution, the last store of every attachment is required
+        }
+    }
+
+    void CommandExecutor::WaitRecorded() {
+        u64 recorded{recordedCount.load(std::memory_order_acquire)};
+        if (recorded != submittedCount) {
+            TRACE_EVENT("gpu", "CommandExecutor::WaitRecorded");
+            do {
+                recordedCount.wait(recorded, std::memory_order_acquire);
+            } while ((recorded = recordedCount.load(std::memory_order_acquire)) != submittedCount);
         }
     }
 }
@@ -3,45 +3,307 @@
 
 #pragma once
 
-#include <boost/container/stable_vector.hpp>
 #include <unordered_set>
+#include <common/spsc_queue.h>
+#include "command_arena.h"
 #include "command_nodes.h"
+#include "query_manager.h"
 
 namespace skyline::gpu::interconnect {
     /**
      * @brief Assembles a Vulkan command stream with various nodes and manages execution of the produced graph
+     * @note Nodes are assembled on the calling thread while a dedicated recording thread records and submits them, this allows decoding methods to overlap with Vulkan command recording
+     * @note A completion thread waits on submissions in the order they were submitted and calls their callbacks once the host GPU has reached them, the recording thread only waits on the submission FramesInFlight back
+     * @note If parallel recording is enabled, large render passes are recorded into secondary command buffers across several threads and executed from the primary command buffer
+     * @note The accesses of nodes to resources are tracked so barriers are only recorded between nodes with conflicting accesses, all dependencies prior to a node are merged into a single barrier
+     * @note Guest sample counters and render conditions are applied to all commands inside subpasses through the QueryManager, reports are written back by the completion thread
      * @note This class is **NOT** thread-safe and should not be utilized by multiple threads concurrently
      */
     class CommandExecutor {
       private:
+        const DeviceState &state;
         GPU &gpu;
-        boost::container::stable_vector<node::NodeVariant> nodes;
+        QueryManager queries; //!< This must outlive the submission and completion queues as their batches return query pools to it
+        CommandArena arena; //!< The arena that all nodes are constructed into, it's handed off to the recording thread on execution
         node::RenderPassNode *renderPass{};
+        CommandArena::Marker renderPassMarker; //!< A marker after the node of the current render pass, all nodes after it are contained in the render pass
+        size_t renderPassStart{}; //!< The amount of nodes in the arena after the node of the current render pass
+
+        /**
+         * @brief The position of a transition to the next subpass of the current render pass in the arena
+         */
+        struct SubpassTransition {
+            CommandArena::Marker previous; //!< A marker after the last node of the prior subpass
+            CommandArena::Marker marker; //!< A marker after the node of the transition, all nodes after it are in the next subpass
+            node::NextSubpassNode *node;
+        };
+        std::vector<SubpassTransition> subpassTransitions; //!< The transitions between all subpasses of the current render pass
+
+        /**
+         * @brief A command inside a subpass which is recorded within the scope of its query and conditional rendering
+         */
+        template<typename Function>
+        struct ScopedFunction {
+            Function function;
+            QueryManager::Scope scope;
+
+            void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+                scope.Begin(commandBuffer);
+                function(commandBuffer, cycle, gpu);
+                scope.End(commandBuffer);
+            }
+        };
+
+        static constexpr size_t RecordWorkerCount{2}; //!< The amount of workers in the record pool, the recording thread records a secondary command buffer alongside them
+        static constexpr size_t MinSecondaryNodes{0x40}; //!< The minimum amount of nodes in a render pass for it to be recorded into secondary command buffers, smaller ones aren't worth the overhead
+        std::optional<ThreadPool> recordPool; //!< A pool which records large render passes into secondary command buffers, this is only present when parallel recording is enabled
+        u64 renderPassIndex{}; //!< A globally unique index of the current render pass, this is used to determine if the last access to an attachment was inside it
         std::unordered_set<Texture*> syncTextures; //!< All textures that need to be synced prior to and after execution
+        std::unordered_set<Buffer *> syncBuffers; //!< All buffers that need to be synced prior to execution
+        PipelineBarrier pendingBarrier; //!< The dependencies of all accesses since the last node, this is recorded prior to the next node
+        PipelineBarrier prologueBarrier; //!< The dependencies of the synchronization of attached resources prior to execution on their accesses in prior submissions
+        bool clearSubpass{}; //!< If the current subpass only contains clears, unlike draws these don't depend on the amount of attachments bound to the subpass so more can be bound to it
+        std::unordered_map<Texture *, node::RenderPassNode *> storedAttachments; //!< The last render pass in the current submission which stores each texture as an attachment, the store is discarded if the texture is overwritten before being read
+        Texture *frameTarget{}; //!< The presentable texture that was last rendered into, a different one being rendered into marks the start of a new frame for frame skipping
+        u64 frameTargetIndex{}; //!< The amount of frames queued by the guest when the frame target was last changed, this also marks the start of a new frame if the guest only renders into a single presentable texture
+        bool frameSkipped{}; //!< If rendering into presentable textures is being skipped for the current frame
+
+        std::mutex arenaMutex;
+        std::vector<CommandArena> freeArenas; //!< Arenas that have been recorded and reset by the recording thread, these are reused to avoid reallocating their memory
+
+        /**
+         * @brief A write of a guest semaphore which is deferred till all commands prior to it have completed on the host GPU
+         */
+        struct SemaphoreRelease {
+            u8 *address; //!< A host pointer to the guest semaphore
+            u64 value;
+            bool fourWords; //!< If the value is written alongside a timestamp of the release rather than as a single word
+        };
+        std::vector<SemaphoreRelease> releases; //!< The semaphore releases since the last execution
+
+        /**
+         * @brief A batch of nodes that has been handed off to the recording thread
+         */
+        struct Submission {
+            CommandArena arena;
+            std::unordered_set<Texture *> syncTextures;
+            std::unordered_set<Buffer *> syncBuffers;
+            PipelineBarrier prologueBarrier; //!< A barrier recorded prior to synchronizing the attached resources
+            QueryManager::Batch queries;
+            std::vector<SemaphoreRelease> releases;
+            std::function<void()> callback; //!< A function called after the GPU has finished executing the nodes
+        };
+
+        static constexpr size_t SubmissionQueueSize{4}; //!< The maximum amount of submissions that can be pending recording, the assembling thread is blocked after this to bound latency
+        SpscQueue<Submission> submissionQueue{SubmissionQueueSize};
+        std::thread recordThread; //!< The thread that records and submits all nodes
+        u64 submittedCount{}; //!< The amount of submissions pushed into the queue, this is only used by the assembling thread
+        std::atomic<u64> recordedCount{}; //!< The amount of submissions that have been recorded, this is only written to by the recording thread
+        std::vector<vk::ImageMemoryBarrier> layoutBarriers; //!< The deferred layout transitions of the textures in a submission, these are batched into a single barrier, this is only used by the recording thread
+
+        static constexpr size_t FramesInFlight{3}; //!< The maximum amount of submissions that can be executing on the GPU while another is recorded, the host only waits on the submission this many submissions prior
+        std::array<std::shared_ptr<FenceCycle>, FramesInFlight> frameCycles; //!< A ring of the cycles of the last submissions, this is only used by the recording thread
+        size_t frameIndex{}; //!< The index of the slot in the ring for the next submission
+
+        /**
+         * @brief A submission which has been submitted to the host GPU and is pending completion
+         */
+        struct Completion {
+            std::shared_ptr<FenceCycle> cycle; //!< The cycle of the submitted command buffer, this is null for submissions without any nodes
+            CommandArena arena; //!< The arena of the submission, this is only reset after completion as nodes may refer to resources in use by the GPU
+            QueryManager::Batch queries; //!< The queries of the submission, its reports are written back prior to the callback being called
+            std::vector<SemaphoreRelease> releases; //!< The semaphore releases of the submission, these are written after its reports and prior to the callback being called
+            std::function<void()> callback;
+        };
+
+        static constexpr size_t CompletionQueueSize{8}; //!< The maximum amount of submissions that can be in flight on the GPU, the recording thread is blocked after this
+        SpscQueue<Completion> completionQueue{CompletionQueueSize};
+        std::thread completionThread; //!< The thread that waits on submissions to complete and calls their callbacks
+
+        /**
+         * @brief Records and submits all submissions in the queue as they arrive
+         */
+        void RecordThread();
+
+        /**
+         * @brief Records the nodes of a submission into a command buffer and submits it, it's then handed off to the completion thread
+         */
+        void Record(Submission &submission);
+
+        /**
+         * @brief Waits on all submitted command buffers in order and calls their callbacks after they've completed on the GPU
+         */
+        void CompletionThread();
+
+        /**
+         * @brief Accounts for an access to a resource by the next node, the dependencies on any conflicting prior accesses are merged into the pending barrier
+         * @param attachment If the access is by a subpass of the current render pass, dependencies on accesses from earlier subpasses of it are handled by the render pass itself
+         */
+        void TrackAccess(AccessState &accessState, vk::PipelineStageFlags stages, vk::AccessFlags access, bool attachment = false);
 
         /**
+         * @brief Records the pending barrier prior to the next node if there are any pending dependencies
+         * @note This must not be called inside a render pass
+         */
+        void FlushBarrier();
+
+        /**
+         * @brief Accounts for a texture being used as an attachment in the current render pass, this infers if the contents stored by a prior render pass are ever read
+         * @param overwritten If the entire texture is overwritten by the current render pass before being read, the store of the prior render pass is discarded in this case
+         */
+        void UpdateAttachmentStore(Texture *texture, bool overwritten);
+
+        /**
+         * @return If rendering into the supplied attachments should be skipped as they're all presentable textures and the current frame is dropped by frame skipping
+         * @note The attachments are marked so their next presentation is dropped if rendering into them is skipped
+         */
+        bool IsRenderingSkipped(span<TextureView> colorAttachments);
+
+        /**
+         * @brief Attaches and tracks the accesses of all attachments of a subpass, the current render pass is ended if it's incompatible or any attachment requires a barrier
+         * @note The current render pass is compatible if its render area can be grown to cover the supplied one, this allows passes targeting the same attachments with different areas to merge
          * @return If a new render pass was created by the function or the current one was reused as it was compatible
          */
-        bool CreateRenderPass(vk::Rect2D renderArea);
+        bool CreateRenderPass(vk::Rect2D renderArea, span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment);
+
+        /**
+         * @brief Adds a subpass with the supplied attachments to the current render pass or a new one, the current subpass is reused if it has the same attachments
+         * @return If the command can be recorded without progressing to the next subpass, this is the case for the first subpass of a new render pass or a reused subpass
+         */
+        bool CreateSubpass(vk::Rect2D renderArea, span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment);
+
+        /**
+         * @brief Progresses to the next subpass of the current render pass
+         */
+        void NextSubpass();
+
+        /**
+         * @brief Moves the contents of every subpass of the current render pass into nodes which record them into secondary command buffers across the record pool
+         */
+        void SplitRenderPassIntoSecondaries();
+
+        /**
+         * @brief Ends the current render pass if there is one, this is required prior to any commands which can't be recorded inside a render pass
+         */
+        void FinishRenderPass();
 
       public:
         CommandExecutor(const DeviceState &state);
 
+        ~CommandExecutor();
+
         /**
          * @brief Adds a command that needs to be executed inside a subpass configured with certain attachments
+         * @note The command is skipped if the render condition is known to be false, it's wrapped in the scope of the current query and predicate otherwise
          * @note Any texture supplied to this **must** be locked by the calling thread, it should also undergo no persistent layout transitions till execution
          */
-        void AddSubpass(const std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)> &function, vk::Rect2D renderArea, std::vector<TextureView> inputAttachments = {}, std::vector<TextureView> colorAttachments = {}, std::optional<TextureView> depthStencilAttachment = {});
+        template<typename Function>
+        void AddSubpass(Function &&function, vk::Rect2D renderArea, std::vector<TextureView> inputAttachments = {}, std::vector<TextureView> colorAttachments = {}, std::optional<TextureView> depthStencilAttachment = {}) {
+            if (!queries.IsRenderEnabled())
+                return; // The render condition is known to be false, the command has no effect
+
+            if (IsRenderingSkipped(colorAttachments)) [[unlikely]]
+                return;
+
+            if (!CreateSubpass(renderArea, inputAttachments, colorAttachments, depthStencilAttachment ? &*depthStencilAttachment : nullptr))
+                NextSubpass();
+
+            if (queries.IsScopeRequired()) [[unlikely]] {
+                // Queries and conditional rendering are scoped to the command itself as they can't span subpasses, this also keeps them within a single secondary command buffer
+                arena.Emplace<node::FunctionNode<ScopedFunction<std::decay_t<Function>>>>(ScopedFunction<std::decay_t<Function>>{std::forward<Function>(function), queries.CreateScope()});
+            } else {
+                arena.Emplace<node::FunctionNode<std::decay_t<Function>>>(std::forward<Function>(function));
+            }
+        }
+
+        /**
+         * @brief Adds a command that needs to be executed outside the scope of a render pass, such as a transfer
+         * @note Any render pass that is currently active is ended by this, it should be avoided between draws that could otherwise share a render pass
+         */
+        template<typename Function>
+        void AddOutsideRpCommand(Function &&function) {
+            FinishRenderPass();
+            FlushBarrier();
+            arena.Emplace<node::FunctionNode<std::decay_t<Function>>>(std::forward<Function>(function));
+        }
+
+        /**
+         * @brief Attaches a buffer to the current submission, it's locked and synchronized with the guest prior to any nodes being recorded
+         * @param stages The pipeline stages that the next node added with AddOutsideRpCommand accesses the buffer from
+         * @param access The types of access of the next node to the buffer, a barrier is only recorded prior to it if these conflict with prior accesses
+         * @note The buffer must be kept alive till execution by a node which uses it
+         */
+        void AttachBuffer(Buffer *buffer, vk::PipelineStageFlags stages, vk::AccessFlags access);
+
+        /**
+         * @brief Attaches a texture to the current submission, it's locked and synchronized with the guest prior to any nodes being recorded and synchronized back to the guest afterwards
+         * @param stages The pipeline stages that the next node added with AddOutsideRpCommand accesses the texture from
+         * @param access The types of access of the next node to the texture, a barrier is only recorded prior to it if these conflict with prior accesses
+         * @note The texture must be kept alive till execution by a node which uses it
+         */
+        void AttachTexture(Texture *texture, vk::PipelineStageFlags stages, vk::AccessFlags access);
 
         /**
          * @brief Adds a subpass that clears the entirety of the specified attachment with a value, it may utilize VK_ATTACHMENT_LOAD_OP_CLEAR for a more efficient clear when possible
+         * @note The clear is subject to the render condition, load operations aren't used for clears conditional on the GPU
+         * @note Consecutive clears of several attachments are folded into a single subpass and clears of attachments bound to the current subpass are recorded inside it
          * @note Any texture supplied to this **must** be locked by the calling thread, it should also undergo no persistent layout transitions till execution
          */
         void AddClearColorSubpass(TextureView attachment, const vk::ClearColorValue& value);
 
         /**
-         * @brief Execute all the nodes and submit the resulting command buffer to the GPU
+         * @brief Enables or disables counting the samples passed by later commands inside subpasses into the guest counter
+         */
+        void SetSampleCounting(bool enable) {
+            queries.SetCounting(enable);
+        }
+
+        /**
+         * @brief Resets the guest sample counter to zero
+         */
+        void ResetSampleCounter() {
+            queries.ResetCounter();
+        }
+
+        /**
+         * @brief Reports the current value of the guest sample counter to guest memory, it's written back once this submission has completed prior to the callback supplied to Execute being called
+         * @param address A host pointer to the guest report, it must be valid for the size of the report
+         */
+        void ReportSamplesPassed(u8 *address, bool fourWords) {
+            queries.Report(address, fourWords);
+        }
+
+        /**
+         * @brief Queues a write of a guest semaphore that's performed by the completion thread once all prior commands have completed on the host GPU
+         * @param address A host pointer to the semaphore, it must be valid for 16 bytes if fourWords is set or 4 bytes otherwise
+         * @param fourWords If the value is written alongside a timestamp of the release, the value is truncated to 32 bits otherwise
+         * @note The release is submitted with the next execution, FlushReleases must be called prior to the guest waiting on it
+         */
+        void ReleaseSemaphore(u8 *address, u64 value, bool fourWords) {
+            releases.push_back(SemaphoreRelease{address, value, fourWords});
+        }
+
+        /**
+         * @brief Executes all pending commands if there are pending semaphore releases, this doesn't wait on the execution
+         * @note This should be called whenever no further commands are expected soon as the guest may be waiting on a release
+         */
+        void FlushReleases();
+
+        /**
+         * @brief Sets the condition under which later commands inside subpasses are performed
+         * @param address A host pointer to the reports that the condition depends on
+         */
+        void SetRenderCondition(RenderCondition condition, u8 *address);
+
+        /**
+         * @brief Hands off all the nodes to the recording thread which records them and submits the resulting command buffer to the GPU
+         * @param callback A function that is called on the recording thread after the GPU has finished executing the nodes of this and all prior calls, it is called even if there are no nodes
+         */
+        void Execute(std::function<void()> callback = {});
+
+        /**
+         * @brief Waits on all prior calls to Execute being recorded, this must be done prior to the CPU accessing guest memory that nodes may write to as their textures are only marked as dirty on the GPU once they're recorded
          */
-        void Execute();
+        void WaitRecorded();
     };
 }
@@ -4,15 +4,6 @@
 #include "command_nodes.h"
 
 namespace skyline::gpu::interconnect::node {
-    RenderPassNode::Storage::~Storage() {
-        if (device) {
-            if (framebuffer)
-                (**device).destroy(framebuffer, nullptr, *device->getDispatcher());
-            if (renderPass)
-                (**device).destroy(renderPass, nullptr, *device->getDispatcher());
-        }
-    }
-
     u32 RenderPassNode::AddAttachment(TextureView &view) {
         auto &textures{storage->textures};
         auto texture{std::find(textures.begin(), textures.end(), view.backing)};
@@ -24,11 +15,22 @@ namespace skyline::gpu::interconnect::node {
         if (attachment == attachments.end()) {
             // If we cannot find any matches for the specified attachment, we add it as a new one
             attachments.push_back(vkView);
+            // The contents of transient attachments never leave the render pass, they're neither loaded nor stored
+            auto loadOp{view.backing->transient ? vk::AttachmentLoadOp::eDontCare : vk::AttachmentLoadOp::eLoad};
+            auto storeOp{view.backing->transient ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore};
             attachmentDescriptions.push_back(vk::AttachmentDescription{
                 .format = *view.format,
+                .samples = view.backing->sampleCount,
+                .loadOp = loadOp,
+                .storeOp = storeOp,
+                .stencilLoadOp = loadOp,
+                .stencilStoreOp = storeOp,
                 .initialLayout = view.backing->layout,
                 .finalLayout = view.backing->layout,
             });
+            attachmentBackings.push_back(view.backing.get());
+            attachmentExtent.width = std::min(attachmentExtent.width, view.backing->dimensions.width);
+            attachmentExtent.height = std::min(attachmentExtent.height, view.backing->dimensions.height);
             return static_cast<u32>(attachments.size() - 1);
         } else {
             // If we've got a match from a previous subpass, we need to preserve the attachment till the current subpass
@@ -97,6 +99,23 @@ namespace skyline::gpu::interconnect::node {
         }
     }
 
+    bool RenderPassNode::MergeRenderArea(vk::Rect2D area, vk::Extent2D extent) {
+        if (renderArea == area)
+            return true;
+
+        auto left{std::min(renderArea.offset.x, area.offset.x)}, top{std::min(renderArea.offset.y, area.offset.y)};
+        auto right{std::max(renderArea.offset.x + static_cast<i32>(renderArea.extent.width), area.offset.x + static_cast<i32>(area.extent.width))};
+        auto bottom{std::max(renderArea.offset.y + static_cast<i32>(renderArea.extent.height), area.offset.y + static_cast<i32>(area.extent.height))};
+        if (right > static_cast<i32>(std::min(attachmentExtent.width, extent.width)) || bottom > static_cast<i32>(std::min(attachmentExtent.height, extent.height)))
+            return false;
+
+        renderArea = vk::Rect2D{
+            .offset = {left, top},
+            .extent = {static_cast<u32>(right - left), static_cast<u32>(bottom - top)},
+        };
+        return true;
+    }
+
     void RenderPassNode::AddSubpass(span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment) {
         attachmentReferences.reserve(attachmentReferences.size() + inputAttachments.size() + colorAttachments.size() + (depthStencilAttachment ? 1 : 0));
 
@@ -137,7 +156,45 @@ namespace skyline::gpu::interconnect::node {
         });
     }
 
-    bool RenderPassNode::ClearColorAttachment(u32 colorAttachment, const vk::ClearColorValue &value) {
+    bool RenderPassNode::MatchesSubpass(span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment) {
+        auto &subpass{subpassDescriptions.back()};
+        bool hasDepthStencil{reinterpret_cast<uintptr_t>(subpass.pDepthStencilAttachment) != NoDepthStencil};
+        if (subpass.inputAttachmentCount != inputAttachments.size() || subpass.colorAttachmentCount != colorAttachments.size() || hasDepthStencil != (depthStencilAttachment != nullptr))
+            return false;
+
+        // All references of a subpass are contiguous, they're in the same order as the views are supplied to AddSubpass
+        auto reference{RebasePointer(attachmentReferences, subpass.pInputAttachments)};
+        for (const auto &views : {inputAttachments, colorAttachments})
+            for (auto &view : views)
+                if (attachments[(reference++)->attachment] != view.GetView())
+                    return false;
+
+        return !depthStencilAttachment || attachments[reference->attachment] == depthStencilAttachment->GetView();
+    }
+
+    std::optional<u32> RenderPassNode::GetColorAttachment(TextureView &view) {
+        auto &subpass{subpassDescriptions.back()};
+        auto references{RebasePointer(attachmentReferences, subpass.pColorAttachments)};
+        auto vkView{view.GetView()};
+        for (u32 index{}; index < subpass.colorAttachmentCount; index++)
+            if (attachments[references[index].attachment] == vkView)
+                return index;
+        return std::nullopt;
+    }
+
+    std::optional<u32> RenderPassNode::AppendColorAttachment(TextureView &view) {
+        // The references of the current subpass must end with its color attachments for an additional one to be contiguous with them, any prior use of the view would require preserving it with a dependency
+        auto &subpass{subpassDescriptions.back()};
+        if (reinterpret_cast<uintptr_t>(subpass.pDepthStencilAttachment) != NoDepthStencil || std::find(attachments.begin(), attachments.end(), view.GetView()) != attachments.end())
+            return std::nullopt;
+
+        attachmentReferences.push_back(vk::AttachmentReference{
+            .attachment = AddAttachment(view),
+            .layout = view.backing->layout,
+        });
+        return subpass.colorAttachmentCount++;
+    }
+u32 colorAttachment, const vk::ClearColorValue &value) {
         auto attachmentReference{RebasePointer(attachmentReferences, subpassDescriptions.back().pColorAttachments) + colorAttachment};
         auto attachmentIndex{attachmentReference->attachment};
 
@@ -146,7 +203,7 @@ namespace skyline::gpu::interconnect::node {
                 return false;
 
         auto &attachmentDescription{attachmentDescriptions.at(attachmentIndex)};
-        if (attachmentDescription.loadOp == vk::AttachmentLoadOp::eLoad) {
+        if (attachmentDescription.loadOp != vk::AttachmentLoadOp::eClear) {
             attachmentDescription.loadOp = vk::AttachmentLoadOp::eClear;
 
             clearValues.resize(attachmentIndex + 1);
@@ -160,9 +217,16 @@ namespace skyline::gpu::interconnect::node {
         return false;
     }
 
-    void RenderPassNode::operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
-        storage->device = &gpu.vkDevice;
+    void RenderPassNode::DiscardAttachments(const Texture *texture) {
+        for (size_t index{}; index < attachmentBackings.size(); index++) {
+            if (attachmentBackings[index] == texture) {
+                attachmentDescriptions[index].storeOp = vk::AttachmentStoreOp::eDontCare;
+                attachmentDescriptions[index].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            }
+        }
+    }
 
+    void RenderPassNode::operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
         auto preserveAttachmentIt{preserveAttachmentReferences.begin()};
         for (auto &subpassDescription : subpassDescriptions) {
             subpassDescription.pInputAttachments = RebasePointer(attachmentReferences, subpassDescription.pInputAttachments);
@@ -182,37 +246,35 @@ namespace skyline::gpu::interconnect::node {
         for (auto &texture : storage->textures) {
             texture->lock();
             texture->WaitOnBacking();
-            if (texture->cycle.lock() != cycle)
-                texture->WaitOnFence();
+            texture->WaitOnFence(cycle);
         }
 
-        auto renderPass{(*gpu.vkDevice).createRenderPass(vk::RenderPassCreateInfo{
+        vkRenderPass = gpu.renderPassCache.GetRenderPass(vk::RenderPassCreateInfo{
             .attachmentCount = static_cast<u32>(attachmentDescriptions.size()),
             .pAttachments = attachmentDescriptions.data(),
             .subpassCount = static_cast<u32>(subpassDescriptions.size()),
             .pSubpasses = subpassDescriptions.data(),
             .dependencyCount = static_cast<u32>(subpassDependencies.size()),
             .pDependencies = subpassDependencies.data(),
-        }, nullptr, *gpu.vkDevice.getDispatcher())};
-        storage->renderPass = renderPass;
+        });
 
-        auto framebuffer{(*gpu.vkDevice).createFramebuffer(vk::FramebufferCreateInfo{
-            .renderPass = renderPass,
+        vkFramebuffer = gpu.framebufferCache.GetFramebuffer(vk::FramebufferCreateInfo{
+            .renderPass = vkRenderPass,
             .attachmentCount = static_cast<u32>(attachments.size()),
             .pAttachments = attachments.data(),
-            .width = renderArea.extent.width,
-            .height = renderArea.extent.height,
+            .width = static_cast<u32>(renderArea.offset.x) + renderArea.extent.width,
+            .height = static_cast<u32>(renderArea.offset.y) + renderArea.extent.height,
             .layers = 1,
-        }, nullptr, *gpu.vkDevice.getDispatcher())};
-        storage->framebuffer = framebuffer;
+        }, storage->textures);
 
+        gpu.timestamps.BeginRange(commandBuffer, "Render Pass");
         commandBuffer.beginRenderPass(vk::RenderPassBeginInfo{
-            .renderPass = renderPass,
-            .framebuffer = framebuffer,
+            .renderPass = vkRenderPass,
+            .framebuffer = vkFramebuffer,
             .renderArea = renderArea,
             .clearValueCount = static_cast<u32>(clearValues.size()),
             .pClearValues = clearValues.data(),
-        }, vk::SubpassContents::eInline);
+        }, subpassContents);
 
         cycle->AttachObjects(storage);
 
@@ -221,4 +283,41 @@ namespace skyline::gpu::interconnect::node {
             texture->cycle = cycle;
         }
     }
+
+    void SecondaryCommandsNode::operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+        if (nodes.empty())
+            return;
+
+        vk::CommandBufferInheritanceInfo inheritanceInfo{
+            .renderPass = renderPass.vkRenderPass,
+            .subpass = subpass,
+            .framebuffer = renderPass.vkFramebuffer,
+        };
+
+        std::vector<vk::CommandBuffer> commandBuffers(nodes.size());
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+        pool.ParallelFor(nodes.size(), [&](size_t index) {
+            try {
+                auto &secondary{gpu.scheduler.AllocateSecondaryCommandBuffer(cycle)};
+                secondary.begin(vk::CommandBufferBeginInfo{
+                    .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+                    .pInheritanceInfo = &inheritanceInfo,
+                });
+                nodes[index].Record(secondary, cycle, gpu);
+                secondary.end();
+                commandBuffers[index] = *secondary;
+            } catch (...) {
+                // Exceptions can't propagate out of the pool, they're rethrown on the recording thread instead
+                std::scoped_lock lock(exceptionMutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+        });
+
+        if (exception)
+            std::rethrow_exception(exception);
+
+        commandBuffer.executeCommands(commandBuffers);
+    }
 }
@@ -4,24 +4,35 @@
 #pragma once
 
 #include <gpu.h>
+#include "command_arena.h"
 
 namespace skyline::gpu::interconnect::node {
     /**
-     * @brief A generic node for simply executing a function
+     * @brief A generic node for simply executing a function, the function is stored inline in the node to avoid any heap allocations
      */
-    template<typename FunctionSignature = void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)>
-    struct FunctionNodeBase {
-        std::function<FunctionSignature> function;
+    template<typename Function>
+    struct FunctionNode {
+        Function function;
 
-        FunctionNodeBase(std::function<FunctionSignature> function) : function(function) {}
+        FunctionNode(Function function) : function(std::move(function)) {}
 
-        template<class... Args>
-        void operator()(Args &&... args) {
-            function(std::forward<Args>(args)...);
+        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+            function(commandBuffer, cycle, gpu);
         }
     };
 
-    using FunctionNode = FunctionNodeBase<>;
+    /**
+     * @brief A node which records a pipeline barrier, these are inserted by the CommandExecutor between nodes with conflicting accesses to a resource
+     */
+    struct BarrierNode {
+        PipelineBarrier barrier;
+
+        BarrierNode(PipelineBarrier barrier) : barrier(barrier) {}
+
+        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+            barrier.Record(commandBuffer);
+        }
+    };
 
     /**
      * @brief Creates and begins a VkRenderPass alongside managing all resources bound to it and to the subpasses inside it
@@ -30,20 +41,18 @@ namespace skyline::gpu::interconnect::node {
       private:
         /**
          * @brief Storage for all resources in the VkRenderPass that have their lifetimes bond to the completion fence
+         * @note The render pass and framebuffer are owned by the caches in GPU, the textures being retained here keeps the cached framebuffer valid till completion
          */
         struct Storage : public FenceCycleDependency {
-            vk::raii::Device *device{};
-            vk::Framebuffer framebuffer{};
-            vk::RenderPass renderPass{};
             std::vector<std::shared_ptr<Texture>> textures;
-
-            ~Storage();
         };
 
         std::shared_ptr<Storage> storage;
 
         std::vector<vk::ImageView> attachments;
         std::vector<vk::AttachmentDescription> attachmentDescriptions;
+        std::vector<Texture *> attachmentBackings; //!< The texture backing each attachment, there may be several attachments with the same backing
+        vk::Extent2D attachmentExtent{std::numeric_limits<u32>::max(), std::numeric_limits<u32>::max()}; //!< The extent of the smallest attachment, the render area cannot grow beyond this as the framebuffer must fit inside every attachment
 
         std::vector<vk::AttachmentReference> attachmentReferences;
         std::vector<std::vector<u32>> preserveAttachmentReferences; //!< Any attachment that must be preserved to be utilized by a future subpass, these are stored per-subpass to ensure contiguity
@@ -64,6 +73,10 @@ namespace skyline::gpu::interconnect::node {
 
         vk::Rect2D renderArea;
         std::vector<vk::ClearValue> clearValues;
+        vk::SubpassContents subpassContents{vk::SubpassContents::eInline}; //!< The contents of the first subpass, the contents of later subpasses are supplied by NextSubpassNode
+
+        vk::RenderPass vkRenderPass; //!< The render pass that was begun by this node, this is only valid after it has been recorded
+        vk::Framebuffer vkFramebuffer; //!< The framebuffer that the render pass was begun with, this is only valid after it has been recorded
 
         RenderPassNode(vk::Rect2D renderArea) : storage(std::make_shared<Storage>()), renderArea(renderArea) {}
 
@@ -73,11 +86,35 @@ namespace skyline::gpu::interconnect::node {
          */
         u32 AddAttachment(TextureView &view);
 
+        /**
+         * @brief Grows the render area to the bounding box of it and the supplied area if the framebuffer would still fit inside all attachments
+         * @param extent The extent of the smallest attachment that'll be added for the area
+         * @return If the area could be merged into the render area, a new render pass is required otherwise
+         */
+        bool MergeRenderArea(vk::Rect2D area, vk::Extent2D extent);
+
         /**
          * @brief Creates a subpass with the attachments bound in the specified order
          */
         void AddSubpass(span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment);
 
+        /**
+         * @return If the current subpass has exactly the supplied attachments bound in the same order, commands using them can be recorded in it without a new subpass
+         */
+        bool MatchesSubpass(span<TextureView> inputAttachments, span<TextureView> colorAttachments, TextureView *depthStencilAttachment);
+
+        /**
+         * @return The index of the supplied view in the color attachments of the current subpass, if it's bound as one
+         */
+        std::optional<u32> GetColorAttachment(TextureView &view);
+
+        /**
+         * @brief Binds an additional color attachment to the current subpass
+         * @return The index of the attachment in the color attachments of the current subpass, this fails if the view is already bound to the render pass or the subpass has a depth stencil attachment
+         * @note This must only be used while the current subpass contains no commands that depend on its amount of color attachments such as draws
+         */
+        std::optional<u32> AppendColorAttachment(TextureView &view);
+
         /**
          * @brief Clears a color attachment in the current subpass with VK_ATTACHMENT_LOAD_OP_LOAD
          * @param colorAttachment The index of the attachment in the attachments bound to the current subpass
@@ -86,6 +123,12 @@ namespace skyline::gpu::interconnect::node {
          */
         bool ClearColorAttachment(u32 colorAttachment, const vk::ClearColorValue &value);
 
+        /**
+         * @brief Discards the contents of all attachments backed by the supplied texture at the end of the render pass rather than storing them
+         * @note This must only be used when the contents are overwritten entirely before they're read again, on tilers this avoids writing the tile memory back to the attachment
+         */
+        void DiscardAttachments(const Texture *texture);
+
         void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu);
     };
 
@@ -93,21 +136,26 @@ namespace skyline::gpu::interconnect::node {
      * @brief A node which progresses to the next subpass during a render pass
      */
     struct NextSubpassNode {
+        vk::SubpassContents contents{vk::SubpassContents::eInline}; //!< The contents of the next subpass
+
         void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
-            commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+            commandBuffer.nextSubpass(contents);
         }
     };
 
     /**
-     * @brief A FunctionNode which progresses to the next subpass prior to calling the function
+     * @brief A node which records the nodes of a subpass into secondary command buffers across several threads and executes them from the primary command buffer
+     * @note The subpass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, the nodes must be safe to record concurrently with each other
      */
-    struct NextSubpassFunctionNode : private FunctionNode {
-        using FunctionNode::FunctionNode;
+    struct SecondaryCommandsNode {
+        RenderPassNode &renderPass;
+        u32 subpass; //!< The index of the subpass in the render pass
+        std::vector<CommandArena::NodeList> nodes; //!< The nodes of the subpass, every list is recorded into its own secondary command buffer
+        ThreadPool &pool;
 
-        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
-            commandBuffer.nextSubpass(vk::SubpassContents::eInline);
-            FunctionNode::operator()(commandBuffer, cycle, gpu);
-        }
+        SecondaryCommandsNode(RenderPassNode &renderPass, u32 subpass, std::vector<CommandArena::NodeList> nodes, ThreadPool &pool) : renderPass(renderPass), subpass(subpass), nodes(std::move(nodes)), pool(pool) {}
+
+        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu);
     };
 
     /**
@@ -116,8 +164,7 @@ namespace skyline::gpu::interconnect::node {
     struct RenderPassEndNode {
         void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
             commandBuffer.endRenderPass();
+            gpu.timestamps.EndRange(commandBuffer);
         }
     };
-
-    using NodeVariant = std::variant<FunctionNode, RenderPassNode, NextSubpassNode, NextSubpassFunctionNode, RenderPassEndNode>; //!< A variant encompassing all command nodes types
 }
@@ -9,6 +9,7 @@
 #include <soc/gm20b/engines/maxwell/types.h>
 
 #include "command_executor.h"
+#include "pipeline_state.h"
 
 namespace skyline::gpu::interconnect {
     namespace maxwell3d = soc::gm20b::engine::maxwell3d::type;
@@ -25,14 +26,7 @@ namespace skyline::gpu::interconnect {
 
         struct RenderTarget {
             bool disabled{true}; //!< If this RT has been disabled and will be an unbound attachment instead
-            union {
-                u64 gpuAddress;
-                struct {
-                    u32 gpuAddressLow;
-                    u32 gpuAddressHigh;
-                };
-            };
-            u32 widthBytes; //!< The width in bytes for linear textures
+            u64 gpuAddress{};
             GuestTexture guest;
             std::optional<TextureView> view;
 
@@ -50,156 +44,112 @@ namespace skyline::gpu::interconnect {
             .extent.height = std::numeric_limits<i32>::max(),
             .extent.width = std::numeric_limits<i32>::max(),
         }; //!< A scissor which displays the entire viewport, utilized when the viewport scissor is disabled
-
+        PipelineStateKey pipelineState; //!< The key of the pipeline for the current state, this is only updated by the setters for the groups of state that changed rather than being rebuilt for every draw
 
       public:
+        /**
+         * @return The host format corresponding to the supplied guest RT format, an empty format is returned for ColorFormat::None
+         */
+        static texture::Format ConvertRenderTargetFormat(maxwell3d::RenderTarget::ColorFormat format) {
+            switch (format) {
+                case maxwell3d::RenderTarget::ColorFormat::None:
+                    return {};
+                case maxwell3d::RenderTarget::ColorFormat::R32B32G32A32Float:
+                    return format::R32B32G32A32Float;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Unorm:
+                    return format::R16G16B16A16Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Snorm:
+                    return format::R16G16B16A16Snorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Sint:
+                    return format::R16G16B16A16Sint;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Uint:
+                    return format::R16G16B16A16Uint;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Float:
+                    return format::R16G16B16A16Float;
+                case maxwell3d::RenderTarget::ColorFormat::A2B10G10R10Unorm:
+                    return format::A2B10G10R10Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R8G8B8A8Unorm:
+                    return format::R8G8B8A8Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::A8B8G8R8Srgb:
+                    return format::A8B8G8R8Srgb;
+                case maxwell3d::RenderTarget::ColorFormat::A8B8G8R8Snorm:
+                    return format::A8B8G8R8Snorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16Unorm:
+                    return format::R16G16Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16Snorm:
+                    return format::R16G16Snorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16Sint:
+                    return format::R16G16Sint;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16Uint:
+                    return format::R16G16Uint;
+                case maxwell3d::RenderTarget::ColorFormat::R16G16Float:
+                    return format::R16G16Float;
+                case maxwell3d::RenderTarget::ColorFormat::B10G11R11Float:
+                    return format::B10G11R11Float;
+                case maxwell3d::RenderTarget::ColorFormat::R32Float:
+                    return format::R32Float;
+                case maxwell3d::RenderTarget::ColorFormat::R8G8Unorm:
+                    return format::R8G8Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R8G8Snorm:
+                    return format::R8G8Snorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16Unorm:
+                    return format::R16Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R16Float:
+                    return format::R16Float;
+                case maxwell3d::RenderTarget::ColorFormat::R8Unorm:
+                    return format::R8Unorm;
+                case maxwell3d::RenderTarget::ColorFormat::R8Snorm:
+                    return format::R8Snorm;
+                case maxwell3d::RenderTarget::ColorFormat::R8Sint:
+                    return format::R8Sint;
+                case maxwell3d::RenderTarget::ColorFormat::R8Uint:
+                    return format::R8Uint;
+                default:
+                    throw exception("Cannot translate the supplied RT format: 0x{:X}", static_cast<u32>(format));
+            }
+        }
+
         GraphicsContext(GPU &gpu, soc::gm20b::ChannelContext &channelCtx, gpu::interconnect::CommandExecutor &executor) : gpu(gpu), channelCtx(channelCtx), executor(executor) {
             scissors.fill(DefaultScissor);
         }
 
         /* Render Targets + Render Target Control */
 
-        void SetRenderTargetAddressHigh(size_t index, u32 high) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.gpuAddressHigh = high;
-            renderTarget.guest.mappings.clear();
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetAddressLow(size_t index, u32 low) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.gpuAddressLow = low;
-            renderTarget.guest.mappings.clear();
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetWidth(size_t index, u32 value) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.widthBytes = value;
-            if (renderTarget.guest.tileConfig.mode == texture::TileMode::Linear && renderTarget.guest.format)
-                value /= renderTarget.guest.format->bpb; // Width is in bytes rather than format units for linear textures
-            renderTarget.guest.dimensions.width = value;
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetHeight(size_t index, u32 value) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.guest.dimensions.height = value;
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetFormat(size_t index, maxwell3d::RenderTarget::ColorFormat format) {
+        /**
+         * @brief Rebuilds the guest texture of a render target from its register state, the host view is only looked up when the render target is used
+         */
+        void SetRenderTarget(size_t index, maxwell3d::RenderTarget target) {
             auto &renderTarget{renderTargets.at(index)};
-            renderTarget.guest.format = [&]() -> texture::Format {
-                switch (format) {
-                    case maxwell3d::RenderTarget::ColorFormat::None:
-                        return {};
-                    case maxwell3d::RenderTarget::ColorFormat::R32B32G32A32Float:
-                        return format::R32B32G32A32Float;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Unorm:
-                        return format::R16G16B16A16Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Snorm:
-                        return format::R16G16B16A16Snorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Sint:
-                        return format::R16G16B16A16Sint;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Uint:
-                        return format::R16G16B16A16Uint;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16B16A16Float:
-                        return format::R16G16B16A16Float;
-                    case maxwell3d::RenderTarget::ColorFormat::A2B10G10R10Unorm:
-                        return format::A2B10G10R10Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R8G8B8A8Unorm:
-                        return format::R8G8B8A8Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::A8B8G8R8Srgb:
-                        return format::A8B8G8R8Srgb;
-                    case maxwell3d::RenderTarget::ColorFormat::A8B8G8R8Snorm:
-                        return format::A8B8G8R8Snorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16Unorm:
-                        return format::R16G16Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16Snorm:
-                        return format::R16G16Snorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16Sint:
-                        return format::R16G16Sint;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16Uint:
-                        return format::R16G16Uint;
-                    case maxwell3d::RenderTarget::ColorFormat::R16G16Float:
-                        return format::R16G16Float;
-                    case maxwell3d::RenderTarget::ColorFormat::B10G11R11Float:
-                        return format::B10G11R11Float;
-                    case maxwell3d::RenderTarget::ColorFormat::R32Float:
-                        return format::R32Float;
-                    case maxwell3d::RenderTarget::ColorFormat::R8G8Unorm:
-                        return format::R8G8Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R8G8Snorm:
-                        return format::R8G8Snorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16Unorm:
-                        return format::R16Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R16Float:
-                        return format::R16Float;
-                    case maxwell3d::RenderTarget::ColorFormat::R8Unorm:
-                        return format::R8Unorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R8Snorm:
-                        return format::R8Snorm;
-                    case maxwell3d::RenderTarget::ColorFormat::R8Sint:
-                        return format::R8Sint;
-                    case maxwell3d::RenderTarget::ColorFormat::R8Uint:
-                        return format::R8Uint;
-                    default:
-                        throw exception("Cannot translate the supplied RT format: 0x{:X}", static_cast<u32>(format));
-                }
-            }();
-
-            if (renderTarget.guest.tileConfig.mode == texture::TileMode::Linear && renderTarget.guest.format)
-                renderTarget.guest.dimensions.width = renderTarget.widthBytes / renderTarget.guest.format->bpb;
+            auto &guest{renderTarget.guest};
 
-            renderTarget.disabled = !renderTarget.guest.format;
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetTileMode(size_t index, maxwell3d::RenderTarget::TileMode mode) {
-            auto &renderTarget{renderTargets.at(index)};
-            auto &config{renderTarget.guest.tileConfig};
-            if (mode.isLinear) {
-                if (config.mode != texture::TileMode::Linear && renderTarget.guest.format) {
-                    // Width is provided in bytes rather than format units for linear textures
-                    renderTarget.widthBytes = renderTarget.guest.dimensions.width;
-                    renderTarget.guest.dimensions.width /= renderTarget.guest.format->bpb;
-                }
+            renderTarget.gpuAddress = target.address.Pack();
+            guest.format = ConvertRenderTargetFormat(target.format);
+            renderTarget.disabled = !guest.format;
+            pipelineState.SetColorFormat(index, target.format);
 
-                config.mode = texture::TileMode::Linear;
+            if (target.tileMode.isLinear) {
+                guest.tileConfig = texture::TileConfig{.mode = texture::TileMode::Linear};
+                guest.dimensions.width = guest.format ? target.width / guest.format->bpb : target.width; // Width is provided in bytes rather than format units for linear textures
             } else [[likely]] {
-                if (config.mode == texture::TileMode::Linear && renderTarget.guest.format)
-                    renderTarget.guest.dimensions.width = renderTarget.widthBytes;
-
-                config = texture::TileConfig{
+                guest.tileConfig = texture::TileConfig{
                     .mode = texture::TileMode::Block,
-                    .blockHeight = static_cast<u8>(1U << mode.blockHeightLog2),
-                    .blockDepth = static_cast<u8>(1U << mode.blockDepthLog2),
+                    .blockHeight = static_cast<u8>(1U << target.tileMode.blockHeightLog2),
+                    .blockDepth = static_cast<u8>(1U << target.tileMode.blockDepthLog2),
                 };
+                guest.dimensions.width = target.width;
             }
-            renderTarget.view.reset();
-        }
-
-        void SetRenderTargetArrayMode(size_t index, maxwell3d::RenderTarget::ArrayMode mode) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.guest.layerCount = mode.layerCount;
-            if (mode.volume)
-                throw exception("RT Array Volumes are not supported (with layer count = {})", mode.layerCount);
-            renderTarget.view.reset();
-        }
+            guest.dimensions.height = target.height;
 
-        void SetRenderTargetLayerStride(size_t index, u32 layerStrideLsr2) {
-            auto &renderTarget{renderTargets.at(index)};
-            renderTarget.guest.layerStride = layerStrideLsr2 << 2;
-            renderTarget.view.reset();
-        }
+            if (target.arrayMode.volume)
+                throw exception("RT Array Volumes are not supported (with layer count = {})", target.arrayMode.layerCount);
+            guest.layerCount = target.arrayMode.layerCount;
+            guest.layerStride = target.layerStrideLsr2 << 2;
 
-        void SetRenderTargetBaseLayer(size_t index, u32 baseArrayLayer) {
-            auto &renderTarget{renderTargets.at(index)};
-            if (baseArrayLayer > std::numeric_limits<u16>::max())
-                throw exception("Base array layer ({}) exceeds the range of array count ({}) (with layer count = {})", baseArrayLayer, std::numeric_limits<u16>::max(), renderTarget.guest.layerCount);
+            if (target.baseLayer > std::numeric_limits<u16>::max())
+                throw exception("Base array layer ({}) exceeds the range of array count ({}) (with layer count = {})", target.baseLayer, std::numeric_limits<u16>::max(), guest.layerCount);
+            guest.baseArrayLayer = static_cast<u16>(target.baseLayer);
 
-            renderTarget.guest.baseArrayLayer = static_cast<u16>(baseArrayLayer);
+            guest.mappings.clear();
             renderTarget.view.reset();
         }
 
@@ -218,12 +168,13 @@ namespace skyline::gpu::interconnect {
 
             renderTarget.guest.type = static_cast<texture::TextureType>(renderTarget.guest.dimensions.GetType());
 
-            renderTarget.view = gpu.texture.FindOrCreate(renderTarget.guest);
+            renderTarget.view = gpu.texture.FindOrCreate(renderTarget.guest, true);
             return &renderTarget.view.value();
         }
 
         void UpdateRenderTargetControl(maxwell3d::RenderTargetControl control) {
             renderTargetControl = control;
+            pipelineState.SetRenderTargetControl(control);
         }
 
         /* Viewport Transforms */
@@ -250,6 +201,25 @@ namespace skyline::gpu::interconnect {
             viewport.maxDepth = scale + translate; // Counteract the subtraction of the maxDepth (p_z - o_z) by minDepth (o_z) for the host scale
         }
 
+        void SetViewport(size_t index, const maxwell3d::ViewportTransform &transform) {
+            SetViewportX(index, transform.scaleX, transform.translateX);
+            SetViewportY(index, transform.scaleY, transform.translateY);
+            SetViewportZ(index, transform.scaleZ, transform.translateZ);
+        }
+
+        /**
+         * @return The viewport scaled to the resolution of the supplied render target, viewports are stored in guest coordinates as the render target they apply to can change independently of them
+         * @note The depth range isn't affected by the resolution and is returned as-is
+         */
+        vk::Viewport GetViewport(size_t index, const Texture &renderTarget) const {
+            auto viewport{viewports.at(index)};
+            viewport.x *= renderTarget.resolutionScale;
+            viewport.y *= renderTarget.resolutionScale;
+            viewport.width *= renderTarget.resolutionScale;
+            viewport.height *= renderTarget.resolutionScale;
+            return viewport;
+        }
+
         /* Buffer Clears */
 
         void UpdateClearColorValue(size_t index, u32 value) {
@@ -275,19 +245,21 @@ namespace skyline::gpu::interconnect {
                 if (aspect == vk::ImageAspectFlags{})
                     return;
 
+                // The scissor is in guest coordinates, it's clamped to the guest texture prior to being scaled to the resolution of the host texture
+                auto &guestDimensions{renderTarget.backing->guest->dimensions};
                 auto scissor{scissors.at(renderTargetIndex)};
-                scissor.extent.width = static_cast<u32>(std::min(static_cast<i32>(renderTarget.backing->dimensions.width) - scissor.offset.x,
+                scissor.extent.width = static_cast<u32>(std::min(static_cast<i32>(guestDimensions.width) - scissor.offset.x,
                                                                  static_cast<i32>(scissor.extent.width)));
-                scissor.extent.height = static_cast<u32>(std::min(static_cast<i32>(renderTarget.backing->dimensions.height) - scissor.offset.y,
+                scissor.extent.height = static_cast<u32>(std::min(static_cast<i32>(guestDimensions.height) - scissor.offset.y,
                                                                   static_cast<i32>(scissor.extent.height)));
 
                 if (scissor.extent.width == 0 || scissor.extent.height == 0)
                     return;
 
-                if (scissor.extent.width == renderTarget.backing->dimensions.width && scissor.extent.height == renderTarget.backing->dimensions.height && renderTarget.range.baseArrayLayer == 0 && renderTarget.range.layerCount == 1 && clear.layerId == 0) {
+                if (scissor.extent.width == guestDimensions.width && scissor.extent.height == guestDimensions.height && renderTarget.range.baseArrayLayer == 0 && renderTarget.range.layerCount == 1 && clear.layerId == 0) {
                     executor.AddClearColorSubpass(renderTarget, clearColorValue);
                 } else {
-                    executor.AddSubpass([aspect, clearColorValue = clearColorValue, layerId = clear.layerId, scissor](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+                    executor.AddSubpass([aspect, clearColorValue = clearColorValue, layerId = clear.layerId, scissor = renderTarget.backing->ScaleRect(scissor)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
                         commandBuffer.clearAttachments(vk::ClearAttachment{
                             .aspectMask = aspect,
                             .colorAttachment = 0,
@@ -311,20 +283,72 @@ namespace skyline::gpu::interconnect {
                 .offset.x = scissor->horizontal.minimum,
                 .extent.width = static_cast<u32>(scissor->horizontal.maximum - scissor->horizontal.minimum),
                 .offset.y = scissor->vertical.minimum,
-                .extent.height = static_cast<u32>(scissor->horizontal.maximum - scissor->vertical.minimum),
+                .extent.height = static_cast<u32>(scissor->vertical.maximum - scissor->vertical.minimum),
             } : DefaultScissor;
         }
 
-        void SetScissorHorizontal(size_t index, maxwell3d::Scissor::ScissorBounds bounds) {
-            auto &scissor{scissors.at(index)};
-            scissor.offset.x = bounds.minimum;
-            scissor.extent.width = bounds.maximum - bounds.minimum;
+        /* Pipeline State */
+
+        void SetRasterizerState(bool rasterizerEnable, maxwell3d::PolygonMode polygonModeFront, maxwell3d::PolygonMode polygonModeBack, bool cullFaceEnable, maxwell3d::CullFace cullFace, maxwell3d::FrontFace frontFace) {
+            pipelineState.SetRasterizer(rasterizerEnable, polygonModeFront, polygonModeBack, cullFaceEnable, cullFace, frontFace);
+        }
+
+        void SetDepthStencilState(bool depthTestEnable, bool depthWriteEnable, maxwell3d::CompareOp depthFunc, bool stencilEnable, bool twoSideEnable, maxwell3d::StencilOp frontFailOp, maxwell3d::StencilOp frontDepthFailOp, maxwell3d::StencilOp frontPassOp, maxwell3d::CompareOp frontCompareOp, maxwell3d::StencilOp backFailOp, maxwell3d::StencilOp backDepthFailOp, maxwell3d::StencilOp backPassOp, maxwell3d::CompareOp backCompareOp) {
+            pipelineState.SetDepthStencil(depthTestEnable, depthWriteEnable, depthFunc, stencilEnable, twoSideEnable, frontFailOp, frontDepthFailOp, frontPassOp, frontCompareOp, backFailOp, backDepthFailOp, backPassOp, backCompareOp);
+        }
+
+        void SetMultisampleState(maxwell3d::MultisampleControl control) {
+            pipelineState.SetMultisample(control);
         }
 
-        void SetScissorVertical(size_t index, maxwell3d::Scissor::ScissorBounds bounds) {
-            auto &scissor{scissors.at(index)};
-            scissor.offset.y = bounds.minimum;
-            scissor.extent.height = bounds.maximum - bounds.minimum;
+        void SetAttachmentBlendState(size_t index, bool enable, bool separateAlpha, maxwell3d::Blend::Op colorOp, maxwell3d::Blend::Factor colorSrcFactor, maxwell3d::Blend::Factor colorDestFactor, maxwell3d::Blend::Op alphaOp, maxwell3d::Blend::Factor alphaSrcFactor, maxwell3d::Blend::Factor alphaDestFactor, maxwell3d::ColorWriteMask writeMask) {
+            pipelineState.SetAttachmentBlend(index, enable, separateAlpha, colorOp, colorSrcFactor, colorDestFactor, alphaOp, alphaSrcFactor, alphaDestFactor, writeMask);
+        }
+
+        void SetVertexAttribute(size_t index, maxwell3d::VertexAttribute attribute) {
+            pipelineState.SetVertexAttribute(index, attribute);
+        }
+
+        /**
+         * @return The key of the pipeline matching the current state, this is only valid after the dirty state has been flushed
+         */
+        const PipelineStateKey &GetPipelineState() const {
+            return pipelineState;
+        }
+
+        /* Constant Buffers */
+
+        /**
+         * @brief Writes a run of constant buffer update words to guest memory and mirrors them into the host buffer backing it, if there is one
+         * @note The host write is recorded into the command stream rather than relying on the next synchronization, so draws recorded prior to it still observe the older contents
+         */
+        void ConstantBufferUpdate(u64 gpuAddress, span<u32> data) {
+            span<u8> mapping;
+            if (auto phys{channelCtx.gmmuTlb.Translate(gpuAddress, data.size_bytes())}) [[likely]] {
+                mapping = span(phys, data.size_bytes());
+            } else {
+                auto mappings{channelCtx.asCtx->gmmu.TranslateRange(gpuAddress, data.size_bytes())};
+                if (mappings.size() != 1) [[unlikely]] {
+                    // Updates spanning several CPU mappings can't belong to a single host buffer, so they're only written to the guest
+                    channelCtx.asCtx->gmmu.Write(gpuAddress, data);
+                    return;
+                }
+                mapping = mappings.front();
+            }
+
+            std::memcpy(mapping.data(), data.data(), data.size_bytes());
+
+            auto view{gpu.buffer.Lookup(mapping)};
+            if (!view)
+                return; // Buffers which haven't been created yet will upload the written data when they are
+
+            auto stagingBuffer{gpu.memory.AllocateRingStagingBuffer(data.size_bytes())};
+            std::memcpy(stagingBuffer->data(), data.data(), data.size_bytes());
+
+            executor.AttachBuffer(view->buffer.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+            executor.AddOutsideRpCommand([view = *view, stagingBuffer = std::move(stagingBuffer)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &) {
+                view.buffer->RecordInlineWrite(commandBuffer, cycle, stagingBuffer, view.offset);
+            });
         }
     };
 }
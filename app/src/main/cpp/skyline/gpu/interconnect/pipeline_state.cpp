@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <vulkan/vulkan.hpp>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#else
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#endif
+#include "pipeline_state.h"
+
+namespace skyline::gpu::interconnect {
+    namespace {
+        vk::PolygonMode ConvertPolygonMode(maxwell3d::PolygonMode mode) {
+            switch (mode) {
+                case maxwell3d::PolygonMode::Point:
+                    return vk::PolygonMode::ePoint;
+                case maxwell3d::PolygonMode::Line:
+                    return vk::PolygonMode::eLine;
+                case maxwell3d::PolygonMode::Fill:
+                    return vk::PolygonMode::eFill;
+                default:
+                    throw exception("Invalid polygon mode: 0x{:X}", static_cast<u32>(mode));
+            }
+        }
+
+        vk::CullModeFlags ConvertCullFace(maxwell3d::CullFace face) {
+            switch (face) {
+                case maxwell3d::CullFace::Front:
+                    return vk::CullModeFlagBits::eFront;
+                case maxwell3d::CullFace::Back:
+                    return vk::CullModeFlagBits::eBack;
+                case maxwell3d::CullFace::FrontAndBack:
+                    return vk::CullModeFlagBits::eFrontAndBack;
+                default:
+                    throw exception("Invalid cull face: 0x{:X}", static_cast<u32>(face));
+            }
+        }
+
+        vk::FrontFace ConvertFrontFace(maxwell3d::FrontFace face) {
+            switch (face) {
+                case maxwell3d::FrontFace::Clockwise:
+                    return vk::FrontFace::eClockwise;
+                case maxwell3d::FrontFace::CounterClockwise:
+                    return vk::FrontFace::eCounterClockwise;
+                default:
+                    throw exception("Invalid front face: 0x{:X}", static_cast<u32>(face));
+            }
+        }
+
+        vk::CompareOp ConvertCompareOp(maxwell3d::CompareOp op) {
+            using MCO = maxwell3d::CompareOp;
+            using VCO = vk::CompareOp;
+
+            switch (op) {
+                case MCO::Never:
+                case MCO::NeverGL:
+                    return VCO::eNever;
+                case MCO::Less:
+                case MCO::LessGL:
+                    return VCO::eLess;
+                case MCO::Equal:
+                case MCO::EqualGL:
+                    return VCO::eEqual;
+                case MCO::LessOrEqual:
+                case MCO::LessOrEqualGL:
+                    return VCO::eLessOrEqual;
+                case MCO::Greater:
+                case MCO::GreaterGL:
+                    return VCO::eGreater;
+                case MCO::NotEqual:
+                case MCO::NotEqualGL:
+                    return VCO::eNotEqual;
+                case MCO::GreaterOrEqual:
+                case MCO::GreaterOrEqualGL:
+                    return VCO::eGreaterOrEqual;
+                case MCO::Always:
+                case MCO::AlwaysGL:
+                    return VCO::eAlways;
+                default:
+                    throw exception("Invalid compare operation: 0x{:X}", static_cast<u32>(op));
+            }
+        }
+
+        vk::StencilOp ConvertStencilOp(maxwell3d::StencilOp op) {
+            using MSO = maxwell3d::StencilOp;
+            using VSO = vk::StencilOp;
+
+            switch (op) {
+                case MSO::Keep:
+                    return VSO::eKeep;
+                case MSO::Zero:
+                    return VSO::eZero;
+                case MSO::Replace:
+                    return VSO::eReplace;
+                case MSO::IncrementAndClamp:
+                    return VSO::eIncrementAndClamp;
+                case MSO::DecrementAndClamp:
+                    return VSO::eDecrementAndClamp;
+                case MSO::Invert:
+                    return VSO::eInvert;
+                case MSO::IncrementAndWrap:
+                    return VSO::eIncrementAndWrap;
+                case MSO::DecrementAndWrap:
+                    return VSO::eDecrementAndWrap;
+                default:
+                    throw exception("Invalid stencil operation: 0x{:X}", static_cast<u32>(op));
+            }
+        }
+
+        vk::BlendOp ConvertBlendOp(maxwell3d::Blend::Op op) {
+            using MBO = maxwell3d::Blend::Op;
+            using VBO = vk::BlendOp;
+
+            switch (op) {
+                case MBO::Add:
+                case MBO::AddGL:
+                    return VBO::eAdd;
+                case MBO::Subtract:
+                case MBO::SubtractGL:
+                    return VBO::eSubtract;
+                case MBO::ReverseSubtract:
+                case MBO::ReverseSubtractGL:
+                    return VBO::eReverseSubtract;
+                case MBO::Minimum:
+                case MBO::MinimumGL:
+                    return VBO::eMin;
+                case MBO::Maximum:
+                case MBO::MaximumGL:
+                    return VBO::eMax;
+                default:
+                    throw exception("Invalid blend operation: 0x{:X}", static_cast<u32>(op));
+            }
+        }
+
+        vk::BlendFactor ConvertBlendFactor(maxwell3d::Blend::Factor factor) {
+            using MBF = maxwell3d::Blend::Factor;
+            using VBF = vk::BlendFactor;
+
+            switch (factor) {
+                case MBF::Zero:
+                case MBF::ZeroGL:
+                    return VBF::eZero;
+                case MBF::One:
+                case MBF::OneGL:
+                    return VBF::eOne;
+                case MBF::SourceColor:
+                case MBF::SourceColorGL:
+                    return VBF::eSrcColor;
+                case MBF::OneMinusSourceColor:
+                case MBF::OneMinusSourceColorGL:
+                    return VBF::eOneMinusSrcColor;
+                case MBF::SourceAlpha:
+                case MBF::SourceAlphaGL:
+                    return VBF::eSrcAlpha;
+                case MBF::OneMinusSourceAlpha:
+                case MBF::OneMinusSourceAlphaGL:
+                    return VBF::eOneMinusSrcAlpha;
+                case MBF::DestAlpha:
+                case MBF::DestAlphaGL:
+                    return VBF::eDstAlpha;
+                case MBF::OneMinusDestAlpha:
+                case MBF::OneMinusDestAlphaGL:
+                    return VBF::eOneMinusDstAlpha;
+                case MBF::DestColor:
+                case MBF::DestColorGL:
+                    return VBF::eDstColor;
+                case MBF::OneMinusDestColor:
+                case MBF::OneMinusDestColorGL:
+                    return VBF::eOneMinusDstColor;
+                case MBF::SourceAlphaSaturate:
+                case MBF::SourceAlphaSaturateGL:
+                    return VBF::eSrcAlphaSaturate;
+                case MBF::Source1Color:
+                case MBF::Source1ColorGL:
+                    return VBF::eSrc1Color;
+                case MBF::OneMinusSource1Color:
+                case MBF::OneMinusSource1ColorGL:
+                    return VBF::eOneMinusSrc1Color;
+                case MBF::Source1Alpha:
+                case MBF::Source1AlphaGL:
+                    return VBF::eSrc1Alpha;
+                case MBF::OneMinusSource1Alpha:
+                case MBF::OneMinusSource1AlphaGL:
+                    return VBF::eOneMinusSrc1Alpha;
+                case MBF::ConstantColor:
+                case MBF::ConstantColorGL:
+                    return VBF::eConstantColor;
+                case MBF::OneMinusConstantColor:
+                case MBF::OneMinusConstantColorGL:
+                    return VBF::eOneMinusConstantColor;
+                case MBF::ConstantAlpha:
+                case MBF::ConstantAlphaGL:
+                    return VBF::eConstantAlpha;
+                case MBF::OneMinusConstantAlpha:
+                case MBF::OneMinusConstantAlphaGL:
+                    return VBF::eOneMinusConstantAlpha;
+                default:
+                    throw exception("Invalid blend factor: 0x{:X}", static_cast<u32>(factor));
+            }
+        }
+    }
+
+    void PipelineStateKey::SetRasterizer(bool rasterizerEnable, maxwell3d::PolygonMode front, maxwell3d::PolygonMode back, bool cullFaceEnable, maxwell3d::CullFace cullFace, maxwell3d::FrontFace frontFace) {
+        rasterizer.rasterizerDiscardEnable = !rasterizerEnable;
+        rasterizer.polygonModeFront = static_cast<u32>(ConvertPolygonMode(front));
+        rasterizer.polygonModeBack = static_cast<u32>(ConvertPolygonMode(back));
+        rasterizer.cullMode = cullFaceEnable ? static_cast<u32>(static_cast<VkCullModeFlags>(ConvertCullFace(cullFace))) : 0;
+        rasterizer.frontFace = static_cast<u32>(ConvertFrontFace(frontFace));
+    }
+
+    void PipelineStateKey::SetDepthStencil(bool depthTestEnable, bool depthWriteEnable, maxwell3d::CompareOp depthFunc, bool stencilEnable, bool twoSideEnable, maxwell3d::StencilOp frontFailOp, maxwell3d::StencilOp frontDepthFailOp, maxwell3d::StencilOp frontPassOp, maxwell3d::CompareOp frontCompareOp, maxwell3d::StencilOp backFailOp, maxwell3d::StencilOp backDepthFailOp, maxwell3d::StencilOp backPassOp, maxwell3d::CompareOp backCompareOp) {
+        rasterizer.depthTestEnable = depthTestEnable;
+        rasterizer.depthWriteEnable = depthTestEnable && depthWriteEnable; // Depth writes are skipped entirely when the test is disabled
+        rasterizer.depthCompareOp = depthTestEnable ? static_cast<u32>(ConvertCompareOp(depthFunc)) : 0;
+
+        rasterizer.stencilTestEnable = stencilEnable;
+        if (stencilEnable) {
+            stencil.frontFailOp = static_cast<u32>(ConvertStencilOp(frontFailOp));
+            stencil.frontDepthFailOp = static_cast<u32>(ConvertStencilOp(frontDepthFailOp));
+            stencil.frontPassOp = static_cast<u32>(ConvertStencilOp(frontPassOp));
+            stencil.frontCompareOp = static_cast<u32>(ConvertCompareOp(frontCompareOp));
+
+            if (twoSideEnable) {
+                stencil.backFailOp = static_cast<u32>(ConvertStencilOp(backFailOp));
+                stencil.backDepthFailOp = static_cast<u32>(ConvertStencilOp(backDepthFailOp));
+                stencil.backPassOp = static_cast<u32>(ConvertStencilOp(backPassOp));
+                stencil.backCompareOp = static_cast<u32>(ConvertCompareOp(backCompareOp));
+            } else {
+                // The front stencil state is used for both faces when two-sided stencil is disabled
+                stencil.backFailOp = stencil.frontFailOp;
+                stencil.backDepthFailOp = stencil.frontDepthFailOp;
+                stencil.backPassOp = stencil.frontPassOp;
+                stencil.backCompareOp = stencil.frontCompareOp;
+            }
+        } else {
+            stencil.raw = 0;
+        }
+    }
+
+    void PipelineStateKey::SetMultisample(maxwell3d::MultisampleControl control) {
+        rasterizer.alphaToCoverageEnable = control.alphaToCoverage;
+        rasterizer.alphaToOneEnable = control.alphaToOne;
+    }
+
+    void PipelineStateKey::SetAttachmentBlend(size_t index, bool enable, bool separateAlpha, maxwell3d::Blend::Op colorOp, maxwell3d::Blend::Factor colorSrcFactor, maxwell3d::Blend::Factor colorDestFactor, maxwell3d::Blend::Op alphaOp, maxwell3d::Blend::Factor alphaSrcFactor, maxwell3d::Blend::Factor alphaDestFactor, maxwell3d::ColorWriteMask writeMask) {
+        AttachmentBlendState state{};
+        if (enable) {
+            state.blendEnable = true;
+            state.colorBlendOp = static_cast<u32>(ConvertBlendOp(colorOp));
+            state.srcColorBlendFactor = static_cast<u32>(ConvertBlendFactor(colorSrcFactor));
+            state.dstColorBlendFactor = static_cast<u32>(ConvertBlendFactor(colorDestFactor));
+
+            if (separateAlpha) {
+                state.alphaBlendOp = static_cast<u32>(ConvertBlendOp(alphaOp));
+                state.srcAlphaBlendFactor = static_cast<u32>(ConvertBlendFactor(alphaSrcFactor));
+                state.dstAlphaBlendFactor = static_cast<u32>(ConvertBlendFactor(alphaDestFactor));
+            } else {
+                state.alphaBlendOp = state.colorBlendOp;
+                state.srcAlphaBlendFactor = state.srcColorBlendFactor;
+                state.dstAlphaBlendFactor = state.dstColorBlendFactor;
+            }
+        }
+
+        vk::ColorComponentFlags mask{};
+        if (writeMask.r)
+            mask |= vk::ColorComponentFlagBits::eR;
+        if (writeMask.g)
+            mask |= vk::ColorComponentFlagBits::eG;
+        if (writeMask.b)
+            mask |= vk::ColorComponentFlagBits::eB;
+        if (writeMask.a)
+            mask |= vk::ColorComponentFlagBits::eA;
+        state.colorWriteMask = static_cast<u32>(static_cast<VkColorComponentFlags>(mask));
+
+        attachmentBlend.at(index) = state;
+    }
+
+    size_t PipelineStateKey::Hash() const {
+        #if defined(__ARM_FEATURE_CRC32)
+        auto words{reinterpret_cast<const u32 *>(this)};
+        u32 crc{~0U};
+        for (size_t index{}; index < sizeof(PipelineStateKey) / sizeof(u32); index++)
+            crc = __crc32cw(crc, words[index]);
+        return ~crc;
+        #else
+        return XXH64(this, sizeof(PipelineStateKey), 0);
+        #endif
+    }
+}
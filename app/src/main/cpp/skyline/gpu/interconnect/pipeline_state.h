@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <soc/gm20b/engines/maxwell/types.h>
+
+namespace skyline::gpu::interconnect {
+    namespace maxwell3d = soc::gm20b::engine::maxwell3d::type;
+
+    /**
+     * @brief A compact bit-packed representation of all guest state which affects the creation of a host graphics pipeline, it's used as the key to look up pipelines
+     * @note All fields hold host Vulkan enumerant values rather than guest values, equivalent guest values (such as the GL variants) collapse into the same key
+     * @note State which doesn't apply (such as blend factors on a RT without blending) is zeroed to avoid redundant pipelines, this also means that they're never translated
+     * @note Any state which is dynamic on the host (viewports, scissors, stencil masks and references, blend constants) isn't a part of the key
+     */
+    struct PipelineStateKey {
+        union RasterizerState {
+            u32 raw;
+
+            struct {
+                u32 polygonModeFront : 2; //!< vk::PolygonMode
+                u32 polygonModeBack : 2; //!< vk::PolygonMode, Vulkan only supports a single mode for both faces and this is used to catch mismatching modes
+                u32 cullMode : 2; //!< vk::CullModeFlags
+                u32 frontFace : 1; //!< vk::FrontFace
+                u32 rasterizerDiscardEnable : 1;
+                u32 depthTestEnable : 1;
+                u32 depthWriteEnable : 1;
+                u32 depthCompareOp : 3; //!< vk::CompareOp
+                u32 stencilTestEnable : 1;
+                u32 alphaToCoverageEnable : 1;
+                u32 alphaToOneEnable : 1;
+                u32 _pad_ : 16;
+            };
+        } rasterizer{};
+        static_assert(sizeof(RasterizerState) == sizeof(u32));
+
+        union StencilState {
+            u32 raw;
+
+            struct {
+                u32 frontFailOp : 3; //!< vk::StencilOp
+                u32 frontPassOp : 3; //!< vk::StencilOp
+                u32 frontDepthFailOp : 3; //!< vk::StencilOp
+                u32 frontCompareOp : 3; //!< vk::CompareOp
+                u32 backFailOp : 3; //!< vk::StencilOp
+                u32 backPassOp : 3; //!< vk::StencilOp
+                u32 backDepthFailOp : 3; //!< vk::StencilOp
+                u32 backCompareOp : 3; //!< vk::CompareOp
+                u32 _pad_ : 8;
+            };
+        } stencil{};
+        static_assert(sizeof(StencilState) == sizeof(u32));
+
+        union AttachmentBlendState {
+            u32 raw;
+
+            struct {
+                u32 blendEnable : 1;
+                u32 srcColorBlendFactor : 5; //!< vk::BlendFactor
+                u32 dstColorBlendFactor : 5; //!< vk::BlendFactor
+                u32 colorBlendOp : 3; //!< vk::BlendOp
+                u32 srcAlphaBlendFactor : 5; //!< vk::BlendFactor
+                u32 dstAlphaBlendFactor : 5; //!< vk::BlendFactor
+                u32 alphaBlendOp : 3; //!< vk::BlendOp
+                u32 colorWriteMask : 4; //!< vk::ColorComponentFlags
+                u32 _pad_ : 1;
+            };
+        };
+        static_assert(sizeof(AttachmentBlendState) == sizeof(u32));
+
+        std::array<AttachmentBlendState, maxwell3d::RenderTargetCount> attachmentBlend{};
+        std::array<u8, maxwell3d::RenderTargetCount> colorFormats{}; //!< The guest format of each RT, the host format is derived from this when the pipeline is created
+        u32 renderTargetControl{}; //!< The raw value of maxwell3d::RenderTargetControl
+        std::array<u32, maxwell3d::VertexAttributeCount> vertexAttributes{}; //!< The raw value of each maxwell3d::VertexAttribute
+
+        /**
+         * @brief Translates the guest rasterizer state into the key, this doesn't include any depth/stencil or multisample state
+         */
+        void SetRasterizer(bool rasterizerEnable, maxwell3d::PolygonMode front, maxwell3d::PolygonMode back, bool cullFaceEnable, maxwell3d::CullFace cullFace, maxwell3d::FrontFace frontFace);
+
+        /**
+         * @brief Translates the guest depth and stencil state into the key, any state which doesn't apply due to the test being disabled is zeroed
+         */
+        void SetDepthStencil(bool depthTestEnable, bool depthWriteEnable, maxwell3d::CompareOp depthFunc, bool stencilEnable, bool twoSideEnable, maxwell3d::StencilOp frontFailOp, maxwell3d::StencilOp frontDepthFailOp, maxwell3d::StencilOp frontPassOp, maxwell3d::CompareOp frontCompareOp, maxwell3d::StencilOp backFailOp, maxwell3d::StencilOp backDepthFailOp, maxwell3d::StencilOp backPassOp, maxwell3d::CompareOp backCompareOp);
+
+        void SetMultisample(maxwell3d::MultisampleControl control);
+
+        /**
+         * @brief Translates the blend state and write mask of a single RT into the key, the blend equation is zeroed when blending is disabled
+         * @param separateAlpha If the alpha equation is separate from the color equation, the color equation is used for alpha otherwise
+         */
+        void SetAttachmentBlend(size_t index, bool enable, bool separateAlpha, maxwell3d::Blend::Op colorOp, maxwell3d::Blend::Factor colorSrcFactor, maxwell3d::Blend::Factor colorDestFactor, maxwell3d::Blend::Op alphaOp, maxwell3d::Blend::Factor alphaSrcFactor, maxwell3d::Blend::Factor alphaDestFactor, maxwell3d::ColorWriteMask writeMask);
+
+        void SetColorFormat(size_t index, maxwell3d::RenderTarget::ColorFormat format) {
+            colorFormats.at(index) = static_cast<u8>(format);
+        }
+
+        void SetRenderTargetControl(maxwell3d::RenderTargetControl control) {
+            renderTargetControl = util::BitCast<u32>(control);
+        }
+
+        void SetVertexAttribute(size_t index, maxwell3d::VertexAttribute attribute) {
+            vertexAttributes.at(index) = attribute.raw;
+        }
+
+        /**
+         * @return A hash of the entire key, this uses the ARMv8 CRC32 instructions when they're available as they're significantly faster than a generic hash for a key of this size
+         */
+        size_t Hash() const;
+
+        bool operator==(const PipelineStateKey &other) const {
+            return std::memcmp(this, &other, sizeof(PipelineStateKey)) == 0;
+        }
+    };
+    static_assert(sizeof(PipelineStateKey) <= 0xC0, "The pipeline state key should fit in 3 cache lines");
+    static_assert(std::has_unique_object_representations_v<PipelineStateKey>, "The pipeline state key must not have any padding as it's hashed and compared bytewise");
+
+    /**
+     * @brief A hasher for PipelineStateKey which can be used with std::unordered_map
+     */
+    struct PipelineStateKeyHash {
+        size_t operator()(const PipelineStateKey &key) const {
+            return key.Hash();
+        }
+    };
+}
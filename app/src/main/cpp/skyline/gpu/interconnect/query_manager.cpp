@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include "query_manager.h"
+
+namespace skyline::gpu::interconnect {
+    QueryManager::QueryPool::QueryPool(QueryManager &manager, vk::raii::QueryPool vkPool) : manager(manager), vkPool(std::move(vkPool)) {}
+
+    QueryManager::QueryPool::~QueryPool() {
+        std::scoped_lock lock(manager.poolMutex);
+        manager.freePools.push_back(std::move(vkPool));
+    }
+
+    void QueryManager::Batch::RecordReset(vk::raii::CommandBuffer &commandBuffer) {
+        for (const auto &pool : pools)
+            commandBuffer.resetQueryPool(*pool->vkPool, 0, pool->count);
+    }
+
+    void QueryManager::Scope::Begin(vk::raii::CommandBuffer &commandBuffer) const {
+        if (predicate)
+            commandBuffer.beginConditionalRenderingEXT(vk::ConditionalRenderingBeginInfoEXT{
+                .buffer = predicate,
+                .offset = predicateOffset,
+            });
+
+        if (pool)
+            commandBuffer.beginQuery(pool, query, flags);
+    }
+
+    void QueryManager::Scope::End(vk::raii::CommandBuffer &commandBuffer) const {
+        if (pool)
+            commandBuffer.endQuery(pool, query);
+
+        if (predicate)
+            commandBuffer.endConditionalRenderingEXT();
+    }
+
+    void QueryManager::PredicateCopy::Record(vk::raii::CommandBuffer &commandBuffer) const {
+        // Commands conditional on a prior use of the same predicate may still be reading it
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eConditionalRenderingEXT, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {});
+
+        // The GPU waits on the query being available rather than the CPU, the query is always ended prior to this as it's outside of the render pass it was written in
+        commandBuffer.copyQueryPoolResults(pool, query, 1, predicate, predicateOffset, sizeof(u32), vk::QueryResultFlagBits::eWait);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eConditionalRenderingEXT, {}, vk::MemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask = vk::AccessFlagBits::eConditionalRenderingReadEXT,
+        }, {}, {});
+    }
+
+    QueryManager::QueryManager(GPU &gpu) : gpu(gpu), preciseQueries(gpu.vkPhysicalDevice.getFeatures().occlusionQueryPrecise) {}
+
+    QueryManager::Query QueryManager::AllocateQuery() {
+        if (!currentPool || currentPool->count == PoolSize) {
+            std::unique_lock lock(poolMutex);
+            if (!freePools.empty()) {
+                auto vkPool{std::move(freePools.back())};
+                freePools.pop_back();
+                lock.unlock();
+                currentPool = std::make_shared<QueryPool>(*this, std::move(vkPool));
+            } else {
+                lock.unlock();
+                currentPool = std::make_shared<QueryPool>(*this, vk::raii::QueryPool(gpu.vkDevice, vk::QueryPoolCreateInfo{
+                    .queryType = vk::QueryType::eOcclusion,
+                    .queryCount = PoolSize,
+                }));
+            }
+            batch.pools.push_back(currentPool);
+        }
+
+        return Query{currentPool, currentPool->count++};
+    }
+
+    std::optional<u64> QueryManager::ReadReport(u8 *address) {
+        bool fourWords{true};
+        if (auto it{reports.find(address)}; it != reports.end()) {
+            auto &report{*it->second};
+            if (!report.written.load(std::memory_order_acquire))
+                return std::nullopt;
+
+            report.queries.clear(); // The pools of written reports don't need to be retained any longer
+            fourWords = report.fourWords;
+        }
+
+        if (fourWords) {
+            u64 value;
+            std::memcpy(&value, address, sizeof(value));
+            return value;
+        } else {
+            u32 value;
+            std::memcpy(&value, address, sizeof(value));
+            return value;
+        }
+    }
+
+    QueryManager::Scope QueryManager::CreateScope() {
+        Scope scope{};
+        if (counting) {
+            auto query{AllocateQuery()};
+            scope.pool = *query.pool->vkPool;
+            scope.query = query.index;
+            scope.flags = preciseQueries ? vk::QueryControlFlagBits::ePrecise : vk::QueryControlFlags{};
+            counter.push_back(std::move(query));
+        }
+
+        if (activePredicate != std::numeric_limits<vk::DeviceSize>::max()) {
+            scope.predicate = predicates->vkBuffer;
+            scope.predicateOffset = activePredicate;
+        }
+
+        return scope;
+    }
+
+    void QueryManager::SetCounting(bool enable) {
+        counting = enable;
+    }
+
+    void QueryManager::ResetCounter() {
+        counter.clear();
+    }
+
+    void QueryManager::Report(u8 *address, bool fourWords) {
+        auto report{std::make_shared<CounterReport>()};
+        report->address = address;
+        report->fourWords = fourWords;
+        report->queries = counter;
+        batch.reports.push_back(report);
+        reports.insert_or_assign(address, std::move(report));
+
+        // Reports are usually written to a small set of addresses, this bounds the tracked reports if the guest writes them to a ring instead
+        if (reports.size() > MaxReports)
+            std::erase_if(reports, [](const auto &entry) { return entry.second->written.load(std::memory_order_acquire); });
+    }
+
+    std::optional<QueryManager::PredicateCopy> QueryManager::SetRenderCondition(RenderCondition condition, u8 *address) {
+        renderEnabled = true;
+        activePredicate = std::numeric_limits<vk::DeviceSize>::max();
+
+        switch (condition) {
+            case RenderCondition::Never:
+                renderEnabled = false;
+                return std::nullopt;
+
+            case RenderCondition::Always:
+                return std::nullopt;
+
+            case RenderCondition::IfNonZero: {
+                if (auto value{ReadReport(address)}) {
+                    renderEnabled = *value != 0;
+                    return std::nullopt;
+                }
+
+                auto &report{*reports.at(address)};
+                if (report.queries.empty()) {
+                    renderEnabled = false; // The report will be zero as no samples have been counted into it
+                    return std::nullopt;
+                }
+
+                // A sum of several queries can't be evaluated by conditional rendering, draws are performed unconditionally instead which is always correct for occlusion culling as it only skips draws
+                if (report.queries.size() != 1 || !gpu.supportsConditionalRendering)
+                    return std::nullopt;
+
+                if (!predicates)
+                    predicates.emplace(gpu.memory.AllocateBuffer(PredicateCount * sizeof(u32)));
+                activePredicate = (predicateIndex++ % PredicateCount) * sizeof(u32);
+
+                auto &query{report.queries.front()};
+                batch.retained.push_back(query);
+                return PredicateCopy{*query.pool->vkPool, query.index, predicates->vkBuffer, activePredicate};
+            }
+
+            case RenderCondition::IfEqual:
+            case RenderCondition::IfNotEqual: {
+                // Equality of reports which haven't been written back yet isn't evaluated, draws are performed unconditionally in that case
+                auto first{ReadReport(address)}, second{ReadReport(address + ReportStride)};
+                if (first && second)
+                    renderEnabled = (*first == *second) == (condition == RenderCondition::IfEqual);
+                return std::nullopt;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    QueryManager::Batch QueryManager::Flush() {
+        currentPool.reset();
+        return std::exchange(batch, {});
+    }
+
+    void QueryManager::Resolve(Batch &batch) {
+        if (batch.reports.empty())
+            return;
+
+        TRACE_EVENT("gpu", "QueryManager::Resolve");
+
+        struct FourWordResult {
+            u64 value;
+            u64 timestamp;
+        };
+
+        std::array<u64, PoolSize> results;
+        for (const auto &report : batch.reports) {
+            u64 value{};
+            const auto &queries{report->queries};
+            for (size_t index{}; index < queries.size();) {
+                // Queries are allocated linearly so consecutive queries are usually contiguous in the same pool, they're read back together
+                const auto &first{queries[index]};
+                u32 count{1};
+                while (index + count < queries.size() && queries[index + count].pool == first.pool && queries[index + count].index == first.index + count)
+                    count++;
+
+                // The submission has completed by the time a batch is resolved so all queries should be available without waiting
+                auto result{(*gpu.vkDevice).getQueryPoolResults(*first.pool->vkPool, first.index, count, count * sizeof(u64), results.data(), sizeof(u64), vk::QueryResultFlagBits::e64, *gpu.vkDevice.getDispatcher())};
+                if (result == vk::Result::eSuccess)
+                    for (u32 query{}; query < count; query++)
+                        value += results[query];
+                else
+                    Logger::Warn("Failed to read back {} occlusion queries: {}", count, vk::to_string(result));
+
+                index += count;
+            }
+
+            if (report->fourWords) {
+                FourWordResult fourWordResult{value, util::GetGpuTimeTicks()};
+                std::memcpy(report->address, &fourWordResult, sizeof(fourWordResult));
+            } else {
+                auto oneWordResult{static_cast<u32>(value)};
+                std::memcpy(report->address, &oneWordResult, sizeof(oneWordResult));
+            }
+
+            report->written.store(true, std::memory_order_release);
+        }
+    }
+}
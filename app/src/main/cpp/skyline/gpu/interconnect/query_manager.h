@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/memory_manager.h>
+
+namespace skyline::gpu {
+    class GPU;
+}
+
+namespace skyline::gpu::interconnect {
+    /**
+     * @brief The conditions under which guest draws are performed, these correspond to the modes of the guest render enable
+     */
+    enum class RenderCondition {
+        Never,
+        Always,
+        IfNonZero, //!< Draws are performed if the report at the address is non-zero
+        IfEqual, //!< Draws are performed if the two reports at the address are equal
+        IfNotEqual, //!< Draws are performed if the two reports at the address are not equal
+    };
+
+    /**
+     * @brief Translates guest sample counters into host occlusion queries and guest render conditions into host conditional rendering
+     * @note Every command inside a subpass is wrapped in its own host query while the guest is counting samples, guest reports sum all queries since the last reset of the counter and are written back to guest memory from the completion thread once the submission containing them has completed, the CPU never waits on query results
+     * @note Query pools are batched per submission and reset at its start, they're recycled once neither a pending report nor the guest counter refers to any of their queries
+     * @note A render condition on a single-query report that hasn't been written back yet is evaluated on the GPU with VK_EXT_conditional_rendering, conditions on written reports are evaluated on the CPU and any others fall back to drawing unconditionally
+     * @note This class is **NOT** thread-safe and should only be used by the thread assembling commands for the executor that owns it, aside from the resolution of completed batches
+     */
+    class QueryManager {
+      private:
+        static constexpr u32 PoolSize{0x100}; //!< The amount of queries in every host query pool
+        static constexpr u32 PredicateCount{0x100}; //!< The amount of slots in the ring of predicates for conditional rendering
+        static constexpr size_t MaxReports{0x400}; //!< The amount of tracked reports after which any that have been written back are no longer tracked
+        static constexpr size_t ReportStride{0x10}; //!< The offset of the second report compared by equality conditions, this is the size of a four word report
+
+        /**
+         * @brief A host occlusion query pool which queries are allocated from linearly
+         */
+        struct QueryPool {
+            QueryManager &manager;
+            vk::raii::QueryPool vkPool;
+            u32 count{}; //!< The amount of queries allocated from the pool, these are reset prior to the submission the pool was allocated in
+
+            QueryPool(QueryManager &manager, vk::raii::QueryPool vkPool);
+
+            /**
+             * @note The host query pool is returned to the manager for reuse
+             */
+            ~QueryPool();
+        };
+
+        /**
+         * @brief A single host occlusion query
+         */
+        struct Query {
+            std::shared_ptr<QueryPool> pool;
+            u32 index;
+        };
+
+        /**
+         * @brief A guest report of the amount of samples passed which is written back to guest memory once all queries summed into it have completed
+         */
+        struct CounterReport {
+            u8 *address; //!< A host pointer to the guest report
+            bool fourWords; //!< If the report is written as a value and a timestamp rather than a single word
+            std::vector<Query> queries; //!< All queries since the last reset of the guest counter, this is cleared by the assembling thread once it has observed the report being written back
+            std::atomic<bool> written{}; //!< If the report has been written back to guest memory
+        };
+
+      public:
+        /**
+         * @brief The queries and reports of a single submission
+         */
+        struct Batch {
+            std::vector<std::shared_ptr<QueryPool>> pools; //!< The pools that the queries in the submission were allocated from
+            std::vector<std::shared_ptr<CounterReport>> reports;
+            std::vector<Query> retained; //!< Queries from prior submissions which are read by the submission, their pools must not be reused till it has completed
+
+            /**
+             * @brief Resets all queries allocated from the pools of the batch, this must be recorded prior to any of them being used
+             */
+            void RecordReset(vk::raii::CommandBuffer &commandBuffer);
+        };
+
+        /**
+         * @brief The host state of a single guest command inside a subpass, it's trivially copyable so it can be stored in the node of the command
+         */
+        struct Scope {
+            vk::QueryPool pool; //!< The pool of the query that samples are counted into, this is null if samples aren't counted
+            u32 query;
+            vk::QueryControlFlags flags;
+            vk::Buffer predicate; //!< The buffer holding the predicate for conditional rendering, this is null if the command is performed unconditionally
+            vk::DeviceSize predicateOffset;
+
+            void Begin(vk::raii::CommandBuffer &commandBuffer) const;
+
+            void End(vk::raii::CommandBuffer &commandBuffer) const;
+        };
+
+        /**
+         * @brief A copy of the result of a query into a predicate, it must be recorded outside a render pass
+         */
+        struct PredicateCopy {
+            vk::QueryPool pool;
+            u32 query;
+            vk::Buffer predicate;
+            vk::DeviceSize predicateOffset;
+
+            void Record(vk::raii::CommandBuffer &commandBuffer) const;
+        };
+
+      private:
+        GPU &gpu;
+        bool preciseQueries; //!< If occlusion queries count the exact amount of samples rather than only if any samples passed
+        std::mutex poolMutex; //!< Synchronizes access to the free pools as pools are released from the completion thread
+        std::vector<vk::raii::QueryPool> freePools; //!< This must outlive all pools as they're returned to it on destruction
+        bool counting{}; //!< If the guest is counting samples
+        std::vector<Query> counter; //!< All queries since the last reset of the guest counter
+        std::shared_ptr<QueryPool> currentPool; //!< The pool that queries are currently allocated from, this is only used by a single submission
+        Batch batch; //!< The batch of the current submission
+        std::unordered_map<u8 *, std::shared_ptr<CounterReport>> reports; //!< The last report from the host counter to each guest address
+
+        bool renderEnabled{true}; //!< If commands are performed at all, this is false if the condition is known to be false on the CPU
+        std::optional<memory::Buffer> predicates; //!< A ring of predicates for conditional rendering, this is only allocated once required
+        u32 predicateIndex{}; //!< The index of the next predicate in the ring
+        vk::DeviceSize activePredicate{std::numeric_limits<vk::DeviceSize>::max()}; //!< The offset of the predicate that commands are currently conditional on, this is the maximum value when they're unconditional
+
+        Query AllocateQuery();
+
+        /**
+         * @return The current value of the report at the supplied address or std::nullopt if it hasn't been written back yet
+         * @note Reports that didn't originate from the host counter are always considered written, they're assumed to be four words in size
+         */
+        std::optional<u64> ReadReport(u8 *address);
+
+      public:
+        QueryManager(GPU &gpu);
+
+        /**
+         * @return If the next command inside a subpass should be performed, commands can be skipped entirely if the render condition is known to be false
+         */
+        bool IsRenderEnabled() {
+            return renderEnabled;
+        }
+
+        /**
+         * @return If commands are conditional on a predicate evaluated on the GPU
+         */
+        bool IsRenderConditional() {
+            return activePredicate != std::numeric_limits<vk::DeviceSize>::max();
+        }
+
+        /**
+         * @return If the next command inside a subpass requires a scope
+         */
+        bool IsScopeRequired() {
+            return counting || IsRenderConditional();
+        }
+
+        /**
+         * @return The scope of the next command inside a subpass, this allocates a query if samples are being counted
+         */
+        Scope CreateScope();
+
+        /**
+         * @brief Enables or disables counting samples into the guest counter
+         */
+        void SetCounting(bool enable);
+
+        /**
+         * @brief Resets the guest counter to zero
+         */
+        void ResetCounter();
+
+        /**
+         * @brief Reports the current value of the guest counter to guest memory once all queries in it have completed
+         * @param address A host pointer to the guest report, it must be valid for the size of the report
+         */
+        void Report(u8 *address, bool fourWords);
+
+        /**
+         * @brief Sets the condition under which later commands are performed
+         * @param address A host pointer to the reports that the condition depends on, this is ignored for conditions that don't depend on any reports
+         * @return A copy of a query result into the predicate that later commands are conditional on, this must be recorded prior to any of them
+         */
+        std::optional<PredicateCopy> SetRenderCondition(RenderCondition condition, u8 *address);
+
+        /**
+         * @return The batch of the current submission, all later queries are allocated from new pools
+         */
+        Batch Flush();
+
+        /**
+         * @brief Writes back all reports in a batch to guest memory, this must only be called after the submission of the batch has completed
+         */
+        void Resolve(Batch &batch);
+    };
+}
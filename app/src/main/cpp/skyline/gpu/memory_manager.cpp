@@ -2,6 +2,9 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <gpu.h>
+#include <common/performance_counters.h>
+#include <common/memory_accounting.h>
+#include <common/trace.h>
 #include "memory_manager.h"
 
 namespace skyline::gpu::memory {
@@ -14,12 +17,28 @@ namespace skyline::gpu::memory {
     }
 
     StagingBuffer::~StagingBuffer() {
+        if (vmaAllocator && vmaAllocation && vkBuffer) {
+            // Suballocations from a StagingRing have no allocation of their own, only dedicated buffers and the backing of the ring are accounted for
+            VmaAllocationInfo allocationInfo;
+            vmaGetAllocationInfo(vmaAllocator, vmaAllocation, &allocationInfo);
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::StagingBuffers, allocationInfo.size);
+
+            vmaDestroyBuffer(vmaAllocator, vkBuffer, vmaAllocation);
+        }
+    }
+
+    Buffer::~Buffer() {
         if (vmaAllocator && vmaAllocation && vkBuffer)
             vmaDestroyBuffer(vmaAllocator, vkBuffer, vmaAllocation);
     }
 
     Image::~Image() {
         if (vmaAllocator && vmaAllocation && vkImage) {
+            VmaAllocationInfo allocationInfo;
+            vmaGetAllocationInfo(vmaAllocator, vmaAllocation, &allocationInfo);
+            perf::SharedCounters.textureMemory.fetch_sub(allocationInfo.size, std::memory_order_relaxed);
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::TextureImages, allocationInfo.size);
+
             if (pointer)
                 vmaUnmapMemory(vmaAllocator, vmaAllocation);
             vmaDestroyImage(vmaAllocator, vkImage, vmaAllocation);
@@ -33,6 +52,53 @@ namespace skyline::gpu::memory {
         return pointer;
     }
 
+    StagingRing::StagingRing(std::shared_ptr<StagingBuffer> buffer, vk::DeviceSize alignment) : buffer(std::move(buffer)), alignment(alignment) {}
+
+    void StagingRing::Free(vk::DeviceSize offset) {
+        std::scoped_lock lock(mutex);
+        auto suballocation{std::find_if(suballocations.begin(), suballocations.end(), [offset](const Suballocation &suballocation) {
+            return suballocation.offset == offset;
+        })};
+        suballocation->free = true;
+
+        while (!suballocations.empty() && suballocations.front().free)
+            suballocations.pop_front();
+    }
+
+    std::shared_ptr<StagingBuffer> StagingRing::Allocate(vk::DeviceSize size) {
+        auto alignedSize{util::AlignUp(size, alignment)};
+
+        std::scoped_lock lock(mutex);
+        vk::DeviceSize offset;
+        if (suballocations.empty()) {
+            // The ring is entirely free, we can restart from the beginning to avoid fragmentation at the end
+            if (alignedSize > buffer->size())
+                return nullptr;
+            offset = 0;
+        } else {
+            // The live region is [tail, head) if it hasn't wrapped around, otherwise it's [tail, end) and [0, head)
+            auto tail{suballocations.front().offset};
+            offset = head;
+            if (offset > tail) {
+                if (offset + alignedSize > buffer->size()) {
+                    if (alignedSize >= tail)
+                        return nullptr;
+                    offset = 0; // We wrap around to the start of the ring, the space at the end is skipped
+                }
+            } else if (offset + alignedSize >= tail) {
+                return nullptr; // Overtaking the tail would make the head equal to it, this is disallowed as it'd be indistinguishable from not having wrapped around
+            }
+        }
+
+        head = offset + alignedSize;
+        suballocations.push_back(Suballocation{offset, false});
+
+        return std::shared_ptr<StagingBuffer>(new StagingBuffer(buffer->data() + offset, size, nullptr, buffer->vkBuffer, nullptr, offset), [this](StagingBuffer *suballocation) {
+            Free(suballocation->offset);
+            delete suballocation;
+        });
+    }
+
     MemoryManager::MemoryManager(const GPU &pGpu) : gpu(pGpu) {
         auto instanceDispatcher{gpu.vkInstance.getDispatcher()};
         auto deviceDispatcher{gpu.vkDevice.getDispatcher()};
@@ -61,6 +127,7 @@ namespace skyline::gpu::memory {
             .vkGetPhysicalDeviceMemoryProperties2KHR = instanceDispatcher->vkGetPhysicalDeviceMemoryProperties2,
         };
         VmaAllocatorCreateInfo allocatorCreateInfo{
+            .flags = gpu.supportsMemoryBudget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0U,
             .physicalDevice = *gpu.vkPhysicalDevice,
             .device = *gpu.vkDevice,
             .instance = *gpu.vkInstance,
@@ -69,23 +136,115 @@ namespace skyline::gpu::memory {
         };
         ThrowOnFail(vmaCreateAllocator(&allocatorCreateInfo, &vmaAllocator));
         // TODO: Use VK_KHR_dedicated_allocation when available (Should be on Adreno GPUs)
+
+        // Suballocations are aligned to at least 16 bytes as that is the largest texel block size, this isn't a multiple of non power of two block sizes
+        auto limits{gpu.vkPhysicalDevice.getProperties().limits};
+
+        constexpr vk::MemoryPropertyFlags UnifiedMemoryFlags{vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eDeviceLocal};
+        auto memoryProperties{gpu.vkPhysicalDevice.getMemoryProperties()};
+        unifiedMemory = std::any_of(memoryProperties.memoryTypes.begin(), memoryProperties.memoryTypes.begin() + memoryProperties.memoryTypeCount, [&](const vk::MemoryType &type) {
+            return (type.propertyFlags & UnifiedMemoryFlags) == UnifiedMemoryFlags;
+        });
+        lazilyAllocatedMemory = std::any_of(memoryProperties.memoryTypes.begin(), memoryProperties.memoryTypes.begin() + memoryProperties.memoryTypeCount, [&](const vk::MemoryType &type) {
+            return static_cast<bool>(type.propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated);
+        });
+        for (u32 heap{}; heap < memoryProperties.memoryHeapCount; heap++)
+            if (memoryProperties.memoryHeaps[heap].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                deviceLocalHeaps |= 1U << heap;
+        stagingRing.emplace(AllocateStagingBuffer(StagingRingSize), std::max<vk::DeviceSize>(limits.minStorageBufferOffsetAlignment, 16));
     }
 
     MemoryManager::~MemoryManager() {
+        stagingRing.reset();
         vmaDestroyAllocator(vmaAllocator);
     }
 
+    void MemoryManager::SetCurrentFrame(u32 frame) {
+        vmaSetCurrentFrameIndex(vmaAllocator, frame);
+
+        if (TRACE_EVENT_CATEGORY_ENABLED("gpu")) {
+            auto snapshot{perf::SharedMemoryAccounting.GetSnapshot()};
+            for (size_t index{}; index < snapshot.size(); index++)
+                TRACE_COUNTER("gpu", perfetto::CounterTrack(perf::MemoryCategoryNames[index], "bytes"), snapshot[index]);
+
+            auto [usage, budget]{GetDeviceLocalBudget()};
+            TRACE_COUNTER("gpu", perfetto::CounterTrack("Device Memory Usage", "bytes"), usage);
+            TRACE_COUNTER("gpu", perfetto::CounterTrack("Device Memory Budget", "bytes"), budget);
+        }
+    }
+
+    std::pair<vk::DeviceSize, vk::DeviceSize> MemoryManager::GetDeviceLocalBudget() {
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetBudget(vmaAllocator, budgets.data());
+
+        // All device-local heaps are accounted for together as images may be allocated from any of them
+        vk::DeviceSize usage{}, budget{};
+        for (u32 heap{}; heap < VK_MAX_MEMORY_HEAPS; heap++) {
+            if (deviceLocalHeaps & (1U << heap)) {
+                usage += budgets[heap].usage;
+                budget += budgets[heap].budget;
+            }
+        }
+        return {usage, budget};
+    }
+
+    bool MemoryManager::IsOverBudget() {
+        auto [usage, budget]{GetDeviceLocalBudget()};
+
+        // With unified memory the host-side caches are drawn from the same physical memory as the budget, they're counted so that their growth leads to textures being evicted
+        if (unifiedMemory)
+            for (auto category : {perf::MemoryCategory::PipelineCache, perf::MemoryCategory::ShaderCache, perf::MemoryCategory::BlockCache})
+                usage += perf::SharedMemoryAccounting.Get(category);
+
+        return static_cast<float>(usage) > static_cast<float>(budget) * BudgetThreshold;
+    }
+
     std::shared_ptr<StagingBuffer> MemoryManager::AllocateStagingBuffer(vk::DeviceSize size) {
+        // Staging buffers are shared with the transfer queue concurrently as they're written by the host, an ownership transfer for every upload would be wasteful
+        std::array<u32, 2> queueFamilies{gpu.vkQueueFamilyIndex, gpu.vkTransferQueueFamilyIndex};
+        bool concurrent{gpu.vkTransferQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED};
+        vk::BufferCreateInfo bufferCreateInfo{
+            .size = size,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer,
+            .sharingMode = concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = concurrent ? 2U : 1U,
+            .pQueueFamilyIndices = queueFamilies.data(),
+        };
+        VmaAllocationCreateInfo allocationCreateInfo{
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+        };
+
+        VkBuffer buffer;
+        VmaAllocation allocation;
+        VmaAllocationInfo allocationInfo;
+        ThrowOnFail(vmaCreateBuffer(vmaAllocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &allocationCreateInfo, &buffer, &allocation, &allocationInfo));
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::StagingBuffers, allocationInfo.size);
+
+        return std::make_shared<memory::StagingBuffer>(reinterpret_cast<u8 *>(allocationInfo.pMappedData), size, vmaAllocator, buffer, allocation);
+    }
+
+    std::shared_ptr<StagingBuffer> MemoryManager::AllocateRingStagingBuffer(vk::DeviceSize size) {
+        if (size <= MaxRingAllocationSize) {
+            auto buffer{stagingRing->Allocate(size)};
+            if (buffer)
+                return buffer;
+        }
+
+        // The ring is exhausted or the buffer is too large for it, we fall back to a dedicated allocation rather than waiting on the GPU
+        return AllocateStagingBuffer(size);
+    }
+
+    Buffer MemoryManager::AllocateBuffer(vk::DeviceSize size) {
         vk::BufferCreateInfo bufferCreateInfo{
             .size = size,
-            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | (gpu.supportsConditionalRendering ? vk::BufferUsageFlagBits::eConditionalRenderingEXT : vk::BufferUsageFlags{}),
             .sharingMode = vk::SharingMode::eExclusive,
             .queueFamilyIndexCount = 1,
             .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
         };
         VmaAllocationCreateInfo allocationCreateInfo{
-            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY,
         };
 
         VkBuffer buffer;
@@ -93,7 +252,7 @@ namespace skyline::gpu::memory {
         VmaAllocationInfo allocationInfo;
         ThrowOnFail(vmaCreateBuffer(vmaAllocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &allocationCreateInfo, &buffer, &allocation, &allocationInfo));
 
-        return std::make_shared<memory::StagingBuffer>(reinterpret_cast<u8 *>(allocationInfo.pMappedData), allocationInfo.size, vmaAllocator, buffer, allocation);
+        return Buffer(vmaAllocator, buffer, allocation, size);
     }
 
     Image MemoryManager::AllocateImage(const vk::ImageCreateInfo &createInfo) {
@@ -105,10 +264,41 @@ namespace skyline::gpu::memory {
         VmaAllocation allocation;
         VmaAllocationInfo allocationInfo;
         ThrowOnFail(vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo));
+        perf::SharedCounters.textureMemory.fetch_add(allocationInfo.size, std::memory_order_relaxed);
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::TextureImages, allocationInfo.size);
 
         return Image(vmaAllocator, image, allocation);
     }
 
+    Image MemoryManager::AllocateTransientImage(const vk::ImageCreateInfo &createInfo) {
+        if (!(createInfo.usage & vk::ImageUsageFlagBits::eTransientAttachment))
+            throw exception("Transient images must be created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT");
+
+        // Devices without lazily allocated memory still benefit from the usage as the driver can avoid storing the attachment, it's backed by regular device memory on these
+        VmaAllocationCreateInfo allocationCreateInfo{
+            .usage = lazilyAllocatedMemory ? VMA_MEMORY_USAGE_UNKNOWN : VMA_MEMORY_USAGE_GPU_ONLY,
+            .requiredFlags = lazilyAllocatedMemory ? static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eLazilyAllocated) : 0,
+        };
+
+        VkImage image;
+        VmaAllocation allocation;
+        VmaAllocationInfo allocationInfo;
+        ThrowOnFail(vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo));
+        perf::SharedCounters.textureMemory.fetch_add(allocationInfo.size, std::memory_order_relaxed);
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::TextureImages, allocationInfo.size);
+
+        return Image(vmaAllocator, image, allocation);
+    }
+
+    bool MemoryManager::SupportsMappedImage(const vk::ImageCreateInfo &createInfo) {
+        if (!unifiedMemory)
+            return false;
+
+        vk::ImageFormatProperties properties;
+        auto result{(*gpu.vkPhysicalDevice).getImageFormatProperties(createInfo.format, createInfo.imageType, vk::ImageTiling::eLinear, createInfo.usage, createInfo.flags, &properties, *gpu.vkPhysicalDevice.getDispatcher())};
+        return result == vk::Result::eSuccess && createInfo.extent.width <= properties.maxExtent.width && createInfo.extent.height <= properties.maxExtent.height && createInfo.extent.depth <= properties.maxExtent.depth && createInfo.mipLevels <= properties.maxMipLevels && createInfo.arrayLayers <= properties.maxArrayLayers && (properties.sampleCounts & createInfo.samples);
+    }
+
     Image MemoryManager::AllocateMappedImage(const vk::ImageCreateInfo &createInfo) {
         VmaAllocationCreateInfo allocationCreateInfo{
             .usage = VMA_MEMORY_USAGE_UNKNOWN,
@@ -119,6 +309,8 @@ namespace skyline::gpu::memory {
         VmaAllocation allocation;
         VmaAllocationInfo allocationInfo;
         ThrowOnFail(vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo));
+        perf::SharedCounters.textureMemory.fetch_add(allocationInfo.size, std::memory_order_relaxed);
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::TextureImages, allocationInfo.size);
 
         return Image(vmaAllocator, image, allocation);
     }
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <deque>
 #include <vk_mem_alloc.h>
 #include "fence_cycle.h"
 
@@ -15,11 +16,13 @@ namespace skyline::gpu::memory {
         VmaAllocator vmaAllocator;
         VmaAllocation vmaAllocation;
         vk::Buffer vkBuffer;
+        vk::DeviceSize offset; //!< The offset of the mapping into the buffer, this is only non-zero for suballocations from a StagingRing
 
-        constexpr StagingBuffer(u8 *pointer, size_t size, VmaAllocator vmaAllocator, vk::Buffer vkBuffer, VmaAllocation vmaAllocation)
+        constexpr StagingBuffer(u8 *pointer, size_t size, VmaAllocator vmaAllocator, vk::Buffer vkBuffer, VmaAllocation vmaAllocation, vk::DeviceSize offset = 0)
             : vmaAllocator(vmaAllocator),
               vkBuffer(vkBuffer),
               vmaAllocation(vmaAllocation),
+              offset(offset),
               span(pointer, size) {}
 
         StagingBuffer(const StagingBuffer &) = delete;
@@ -27,7 +30,9 @@ namespace skyline::gpu::memory {
         constexpr StagingBuffer(StagingBuffer &&other)
             : vmaAllocator(std::exchange(other.vmaAllocator, nullptr)),
               vmaAllocation(std::exchange(other.vmaAllocation, nullptr)),
-              vkBuffer(std::exchange(other.vkBuffer, {})) {}
+              vkBuffer(std::exchange(other.vkBuffer, {})),
+              offset(other.offset),
+              span(other) {}
 
         StagingBuffer &operator=(const StagingBuffer &) = delete;
 
@@ -36,6 +41,36 @@ namespace skyline::gpu::memory {
         ~StagingBuffer();
     };
 
+    /**
+     * @brief A device-local Vulkan buffer which VMA allocates and manages the backing memory for, it can't be mapped on the CPU and must be written to with transfers
+     */
+    struct Buffer {
+        VmaAllocator vmaAllocator;
+        VmaAllocation vmaAllocation;
+        vk::Buffer vkBuffer;
+        vk::DeviceSize size;
+
+        constexpr Buffer(VmaAllocator vmaAllocator, vk::Buffer vkBuffer, VmaAllocation vmaAllocation, vk::DeviceSize size)
+            : vmaAllocator(vmaAllocator),
+              vkBuffer(vkBuffer),
+              vmaAllocation(vmaAllocation),
+              size(size) {}
+
+        Buffer(const Buffer &) = delete;
+
+        constexpr Buffer(Buffer &&other)
+            : vmaAllocator(std::exchange(other.vmaAllocator, nullptr)),
+              vmaAllocation(std::exchange(other.vmaAllocation, nullptr)),
+              vkBuffer(std::exchange(other.vkBuffer, {})),
+              size(other.size) {}
+
+        Buffer &operator=(const Buffer &) = delete;
+
+        Buffer &operator=(Buffer &&) = default;
+
+        ~Buffer();
+    };
+
     /**
      * @brief A Vulkan image which VMA allocates and manages the backing memory for
      * @note Any images created with VMA_ALLOCATION_CREATE_MAPPED_BIT must not be utilized with this since it'll unconditionally unmap when a pointer is present which is illegal when an image was created with that flag as unmapping will be automatically performed on image deletion
@@ -81,13 +116,59 @@ namespace skyline::gpu::memory {
         u8 *data();
     };
 
+    /**
+     * @brief A persistently mapped buffer which staging buffers are suballocated from in FIFO order, this avoids a VMA allocation for every small upload or readback
+     * @note Suballocations are released by the fence cycles they're attached to and are reclaimed in the order they were allocated, a long-lived suballocation will hold back reclamation of all later ones
+     * @note This class is thread-safe
+     */
+    class StagingRing {
+      private:
+        /**
+         * @brief A live suballocation of the ring
+         */
+        struct Suballocation {
+            vk::DeviceSize offset;
+            bool free; //!< If the suballocation has been released, it can only be reclaimed once all prior ones have been reclaimed
+        };
+
+        std::shared_ptr<StagingBuffer> buffer; //!< The buffer backing the entire ring
+        vk::DeviceSize alignment; //!< The alignment of all suballocations, this satisfies the requirements of both transfers and storage buffer descriptors
+        std::mutex mutex; //!< Synchronizes all members below
+        vk::DeviceSize head{}; //!< The offset past the end of the most recent suballocation
+        std::deque<Suballocation> suballocations; //!< All suballocations which haven't been reclaimed, the front is the oldest
+
+        void Free(vk::DeviceSize offset);
+
+      public:
+        StagingRing(std::shared_ptr<StagingBuffer> buffer, vk::DeviceSize alignment);
+
+        /**
+         * @return A suballocation of the ring or nullptr if there isn't enough space in the ring for it
+         * @note The ring must outlive all suballocations
+         */
+        std::shared_ptr<StagingBuffer> Allocate(vk::DeviceSize size);
+    };
+
     /**
      * @brief An abstraction over memory operations done in Vulkan, it's used for all allocations on the host GPU
      */
     class MemoryManager {
       private:
+        static constexpr vk::DeviceSize StagingRingSize{32 * 1024 * 1024}; //!< The size of the staging ring, this is enough for a few frames worth of uploads
+        static constexpr vk::DeviceSize MaxRingAllocationSize{StagingRingSize / 4}; //!< The largest staging buffer which is suballocated from the ring, larger ones would exhaust it too quickly and are allocated separately
+        static constexpr float BudgetThreshold{0.9f}; //!< The fraction of the budget after which memory is considered to be over budget, this leaves headroom for allocations until resources are evicted
+
         const GPU &gpu;
         VmaAllocator vmaAllocator{VK_NULL_HANDLE};
+        std::optional<StagingRing> stagingRing;
+        bool unifiedMemory{}; //!< If the device has a memory type which is device-local, host-visible and host-coherent which all mapped images are allocated from
+        bool lazilyAllocatedMemory{}; //!< If the device has a lazily allocated memory type which transient attachments are allocated from, this is generally only the case on tilers
+        u32 deviceLocalHeaps{}; //!< A mask of the memory heaps which are device-local, their usage is compared against the budget
+
+        /**
+         * @return The combined usage and budget of all device-local heaps in bytes
+         */
+        std::pair<vk::DeviceSize, vk::DeviceSize> GetDeviceLocalBudget();
 
       public:
         MemoryManager(const GPU &gpu);
@@ -95,10 +176,35 @@ namespace skyline::gpu::memory {
         ~MemoryManager();
 
         /**
-         * @brief Creates a buffer which is optimized for staging (Transfer Source)
+         * @brief Informs VMA about the index of the current frame, the memory budget is only queried from the driver once per frame
+         * @note The memory accounting of all subsystems and the device-local budget are traced as counters once per frame
+         */
+        void SetCurrentFrame(u32 frame);
+
+        /**
+         * @return If the usage of device-local memory is close to exceeding the budget, exceeding it may cause the process to be killed on mobile devices
+         * @note The budget is supplied by the driver with VK_EXT_memory_budget, otherwise it's estimated by VMA from the sizes of the heaps
+         * @note On devices with unified memory, the memory accounted to host-side caches is counted against the budget as well
+         */
+        bool IsOverBudget();
+
+        /**
+         * @brief Creates a buffer which is optimized for staging (Transfer Source), it can also be bound as a storage buffer for compute passes over its contents
          */
         std::shared_ptr<StagingBuffer> AllocateStagingBuffer(vk::DeviceSize size);
 
+        /**
+         * @brief Creates a staging buffer in the same way as AllocateStagingBuffer but suballocates it from a ring where possible, this is far cheaper for short-lived buffers
+         * @note The returned buffer may have a non-zero offset into its Vulkan buffer which must be respected by all commands using it, it's aligned sufficiently for any transfers of formats with a power of two block size and storage buffer descriptors
+         * @note The buffer should be released soon after use as it holds back reclamation of any buffers allocated after it
+         */
+        std::shared_ptr<StagingBuffer> AllocateRingStagingBuffer(vk::DeviceSize size);
+
+        /**
+         * @brief Creates a device-local buffer which can be bound for any usage that guest buffers require, it's allocated and deallocated using RAII
+         */
+        Buffer AllocateBuffer(vk::DeviceSize size);
+
         /**
          * @brief Creates an image which is allocated and deallocated using RAII
          */
@@ -106,7 +212,21 @@ namespace skyline::gpu::memory {
 
         /**
          * @brief Creates an image which is allocated and deallocated using RAII and is optimal for being mapped on the CPU
+         * @note SupportsMappedImage must be checked prior to calling this
          */
         Image AllocateMappedImage(const vk::ImageCreateInfo &createInfo);
+
+        /**
+         * @brief Creates a transient attachment which is allocated and deallocated using RAII, the memory backing it is lazily allocated when supported
+         * @note The usage in the creation info must include VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and may only include attachment usages alongside it
+         * @note The contents of the image must never leave a render pass, on tilers they only ever reside in tile memory and lazily allocated memory is never committed
+         */
+        Image AllocateTransientImage(const vk::ImageCreateInfo &createInfo);
+
+        /**
+         * @return If an image with the supplied creation info can be allocated with AllocateMappedImage, this requires unified memory and support for the format with linear tiling
+         * @note The tiling in the creation info is ignored and linear tiling is assumed
+         */
+        bool SupportsMappedImage(const vk::ImageCreateInfo &createInfo);
     };
 }
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include <common/memory_accounting.h>
+#include "pipeline_cache.h"
+
+namespace skyline::gpu {
+    PipelineCache::PipelineCache(GPU &gpu) : gpu(gpu), vkPipelineCache(gpu.vkDevice, vk::PipelineCacheCreateInfo{}) {}
+
+    PipelineCache::~PipelineCache() {
+        {
+            std::scoped_lock lock(mutex);
+            exit = true;
+        }
+        exitCondition.notify_all();
+
+        if (saveThread.joinable())
+            saveThread.join();
+
+        perf::SharedMemoryAccounting.Set(perf::MemoryCategory::PipelineCache, 0);
+    }
+
+    void PipelineCache::Save() {
+        if (!directory)
+            return;
+
+        TRACE_EVENT("gpu", "PipelineCache::Save");
+
+        try {
+            auto data{vkPipelineCache.getData()};
+            perf::SharedMemoryAccounting.Set(perf::MemoryCategory::PipelineCache, data.size()); // The driver doesn't expose the size of the cache any other way, it's only as up-to-date as the last save
+            if (data.size() <= savedSize)
+                return;
+
+            directory->Store(filename, FileMagic, FileVersion, data);
+            savedSize = data.size();
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write the pipeline cache: {}", e.what());
+        }
+    }
+
+    void PipelineCache::SaveThread() {
+        pthread_setname_np(pthread_self(), "GPU-PipeCache");
+
+        std::unique_lock lock(mutex);
+        while (!exitCondition.wait_for(lock, SaveInterval, [this]() { return exit; }))
+            Save();
+        Save();
+    }
+
+    void PipelineCache::Open(const std::string &path, u64 titleId) {
+        std::scoped_lock lock(mutex);
+        if (directory)
+            throw exception("The pipeline cache cannot be opened more than once");
+
+        auto properties{gpu.vkPhysicalDevice.getProperties()};
+        std::string uuid;
+        for (auto byte : properties.pipelineCacheUUID)
+            uuid += util::Format("{:02X}", byte);
+        filename = util::Format("{}_{}_{:08X}.bin", vfs::CacheDirectory::GetTitleKey(titleId), uuid, properties.driverVersion);
+
+        try {
+            directory = std::make_shared<vfs::CacheDirectory>(path);
+            if (auto data{directory->Load(filename, FileMagic, FileVersion)}) {
+                // Any pipelines which were created prior to opening the cache are retained by merging the loaded data into the existing cache
+                vk::raii::PipelineCache loadedCache(gpu.vkDevice, vk::PipelineCacheCreateInfo{
+                    .initialDataSize = data->size(),
+                    .pInitialData = data->data(),
+                });
+                vkPipelineCache.merge(*loadedCache);
+                savedSize = data->size();
+                perf::SharedMemoryAccounting.Set(perf::MemoryCategory::PipelineCache, savedSize);
+                Logger::Info("Loaded {} bytes of pipeline cache data from '{}'", data->size(), filename);
+            }
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to load the pipeline cache: {}", e.what());
+        }
+
+        saveThread = std::thread(&PipelineCache::SaveThread, this);
+    }
+}
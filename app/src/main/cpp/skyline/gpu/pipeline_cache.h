@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <vfs/cache_directory.h>
+#include <common.h>
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A Vulkan pipeline cache which is persisted to disk per-title, this avoids recompiling the same pipelines on every boot
+     * @note Files are keyed by the title ID alongside the pipeline cache UUID and version of the driver as the data is only valid for the driver that created it
+     * @note The cache is written back on a dedicated thread periodically and on destruction, writes are skipped when no pipelines were added since the last one
+     */
+    class PipelineCache {
+      private:
+        static constexpr u32 FileMagic{util::MakeMagic<u32>("SKPC")}; //!< "SKPC" - Skyline Pipeline Cache
+        static constexpr u32 FileVersion{1};
+        static constexpr std::chrono::seconds SaveInterval{30}; //!< The interval at which the cache is written back to disk
+
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes all access to the file and the exit flag
+        std::condition_variable exitCondition;
+        bool exit{}; //!< If the save thread should write back the cache and exit
+        std::shared_ptr<vfs::CacheDirectory> directory; //!< The directory holding the cache files, this is null till the cache is opened, the data is hashed by it as not all drivers validate the data
+        std::string filename; //!< The name of the file for the current title and driver
+        size_t savedSize{}; //!< The size of the data at the last write, pipeline caches only ever grow so this is used to skip redundant writes
+        std::thread saveThread;
+
+        /**
+         * @brief Writes the cache back to disk if it has grown since the last write
+         * @note The mutex must be locked
+         */
+        void Save();
+
+        void SaveThread();
+
+      public:
+        vk::raii::PipelineCache vkPipelineCache; //!< The cache that should be supplied to all pipeline creation
+
+        PipelineCache(GPU &gpu);
+
+        ~PipelineCache();
+
+        /**
+         * @brief Loads the cache for the supplied title from the directory and starts writing back to it periodically
+         * @note Pipelines may be created with the cache prior to this, they'll be written back to the file alongside any loaded pipelines
+         */
+        void Open(const std::string &path, u64 titleId);
+    };
+}
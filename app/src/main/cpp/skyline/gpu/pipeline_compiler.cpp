@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "pipeline_compiler.h"
+
+namespace skyline::gpu {
+    PipelineCompiler::PipelineCompiler(bool skipUncompiledDraws) : queue(QueueSize), skipUncompiledDraws(skipUncompiledDraws) {
+        threads.reserve(WorkerCount);
+        for (size_t index{}; index < WorkerCount; index++)
+            threads.emplace_back(&PipelineCompiler::WorkerThread, this, index);
+    }
+
+    PipelineCompiler::~PipelineCompiler() {
+        // All workers need to be running to pop the exit requests
+        SetConcurrency(WorkerCount);
+        for (size_t index{}; index < threads.size(); index++)
+            queue.Push(CompileTask{});
+
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    void PipelineCompiler::WorkerThread(size_t index) {
+        pthread_setname_np(pthread_self(), fmt::format("GPU-Compiler{}", index).c_str());
+
+        while (true) {
+            {
+                std::unique_lock lock(concurrencyMutex);
+                concurrencyCondition.wait(lock, [&]() { return index < concurrency; });
+            }
+
+            auto task{queue.Pop()};
+            if (!task.valid())
+                return;
+
+            TRACE_EVENT("gpu", "PipelineCompiler::Compile");
+            task(); // Any exceptions are stored in the future rather than being propagated here
+        }
+    }
+
+    void PipelineCompiler::SetConcurrency(size_t count) {
+        {
+            std::scoped_lock lock(concurrencyMutex);
+            concurrency = std::clamp<size_t>(count, 1, WorkerCount);
+        }
+        concurrencyCondition.notify_all();
+    }
+
+    std::shared_ptr<vk::raii::Pipeline> PipelineCompiler::GetPipeline(const PipelineFuture &future) {
+        if (skipUncompiledDraws && future.wait_for(std::chrono::seconds::zero()) != std::future_status::ready)
+            return nullptr;
+
+        TRACE_EVENT("gpu", "PipelineCompiler::GetPipeline");
+        return future.get();
+    }
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <future>
+#include <condition_variable>
+#include <common/mpmc_queue.h>
+#include <common.h>
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A pool of worker threads which compile pipelines asynchronously, this keeps pipeline compilation off the GPFIFO thread
+     * @note Pipelines are returned as futures which can be polled each draw, if a pipeline isn't ready the draw is either skipped or blocks on it depending on the user's settings
+     */
+    class PipelineCompiler {
+      public:
+        using PipelineFuture = std::shared_future<std::shared_ptr<vk::raii::Pipeline>>;
+
+      private:
+        using CompileTask = std::packaged_task<std::shared_ptr<vk::raii::Pipeline>()>;
+
+        static constexpr size_t WorkerCount{2}; //!< The amount of compiler threads, this is kept small as the guest's own threads are competing for the same cores
+        static constexpr size_t QueueSize{0x100}; //!< The amount of compile requests that can be queued prior to requesting ones blocking
+
+        MpmcQueue<CompileTask> queue; //!< The queue of compile requests, an invalid task signals a worker to exit
+        std::vector<std::thread> threads;
+        std::mutex concurrencyMutex;
+        std::condition_variable concurrencyCondition; //!< Signalled when the concurrency is raised
+        size_t concurrency{WorkerCount}; //!< The amount of workers which may compile pipelines, workers with an index at or beyond this wait till it's raised
+        bool skipUncompiledDraws; //!< If draws should be skipped rather than waiting on their pipeline while it's being compiled
+
+        void WorkerThread(size_t index);
+
+      public:
+        PipelineCompiler(bool skipUncompiledDraws);
+
+        ~PipelineCompiler();
+
+        /**
+         * @brief Limits the amount of workers which compile pipelines concurrently, a worker that's compiling finishes its current pipeline first
+         * @param count The amount of workers, this is clamped to between 1 and the amount of workers
+         */
+        void SetConcurrency(size_t count);
+
+        /**
+         * @brief Queues a pipeline to be compiled by the supplied function on a worker thread
+         * @note The function should own all state required to create the pipeline as it outlives the calling scope, it should use the pipeline cache of the GPU
+         */
+        template<typename Function>
+        PipelineFuture Compile(Function &&function) {
+            CompileTask task([function = std::forward<Function>(function)]() mutable {
+                return std::make_shared<vk::raii::Pipeline>(function());
+            });
+            PipelineFuture future{task.get_future().share()};
+            queue.Push(std::move(task));
+            return future;
+        }
+
+        /**
+         * @return The pipeline if it has been compiled, if it hasn't then this returns null when draws should be skipped or otherwise waits on it
+         * @note Any exceptions thrown during compilation are rethrown by this
+         */
+        std::shared_ptr<vk::raii::Pipeline> GetPipeline(const PipelineFuture &future);
+    };
+}
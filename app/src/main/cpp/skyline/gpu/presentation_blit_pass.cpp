@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <common/trace.h>
+#include "presentation_blit_pass.h"
+
+namespace skyline::gpu {
+    using namespace service::hosbinder;
+
+    namespace {
+        constexpr u32 PresentationBlitVertexSpirv[]{
+            #include "presentation_blit.vert.spv.inc"
+        };
+
+        constexpr u32 PresentationBlitFragmentSpirv[]{
+            #include "presentation_blit.frag.spv.inc"
+        };
+
+        /**
+         * @brief A transform of centered image coordinates in the form of a 2x2 matrix, every window transform is a composition of flips and a rotation by a multiple of 90 degrees so all elements are -1, 0 or 1
+         */
+        using TransformMatrix = std::array<std::array<i32, 2>, 2>;
+
+        constexpr TransformMatrix Multiply(const TransformMatrix &a, const TransformMatrix &b) {
+            TransformMatrix result{};
+            for (size_t row{}; row < 2; row++)
+                for (size_t column{}; column < 2; column++)
+                    result[row][column] = a[row][0] * b[0][column] + a[row][1] * b[1][column];
+            return result;
+        }
+
+        /**
+         * @return The matrix of a window transform, the flips are applied prior to the clockwise rotation as they are by the Android compositor
+         */
+        constexpr TransformMatrix GetTransformMatrix(NativeWindowTransform transform) {
+            auto bits{static_cast<u32>(transform)};
+            TransformMatrix matrix{{{1, 0}, {0, 1}}};
+            if (bits & static_cast<u32>(NativeWindowTransform::MirrorHorizontal))
+                matrix = Multiply({{{-1, 0}, {0, 1}}}, matrix);
+            if (bits & static_cast<u32>(NativeWindowTransform::MirrorVertical))
+                matrix = Multiply({{{1, 0}, {0, -1}}}, matrix);
+            if (bits & static_cast<u32>(NativeWindowTransform::Rotate90))
+                matrix = Multiply({{{0, -1}, {1, 0}}}, matrix); // Y points downwards in image coordinates, so this maps the right edge onto the bottom edge
+            return matrix;
+        }
+    }
+
+    PresentationBlitPass::PresentationBlitPass(GPU &gpu, texture::Format pFormat) : gpu(gpu),
+        descriptorSetLayout(gpu.descriptor.CreateSetLayout([] {
+            constexpr static vk::DescriptorSetLayoutBinding binding{
+                .binding = 0,
+                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                .descriptorCount = 1,
+                .stageFlags = vk::ShaderStageFlagBits::eFragment,
+            };
+            return span<const vk::DescriptorSetLayoutBinding>(&binding, 1);
+        }())),
+        sampler(gpu.vkDevice, vk::SamplerCreateInfo{
+            .magFilter = vk::Filter::eNearest,
+            .minFilter = vk::Filter::eNearest,
+            .mipmapMode = vk::SamplerMipmapMode::eNearest,
+            .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+            .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+            .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        }),
+        pipelineLayout(gpu.vkDevice, [this] {
+            constexpr static vk::PushConstantRange pushConstantRange{
+                .stageFlags = vk::ShaderStageFlagBits::eVertex,
+                .size = sizeof(PushConstants),
+            };
+            return vk::PipelineLayoutCreateInfo{
+                .setLayoutCount = 1,
+                .pSetLayouts = &*descriptorSetLayout.vkLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+        }()),
+        vertexShaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(PresentationBlitVertexSpirv),
+            .pCode = PresentationBlitVertexSpirv,
+        }),
+        fragmentShaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(PresentationBlitFragmentSpirv),
+            .pCode = PresentationBlitFragmentSpirv,
+        }),
+        renderPass([&] {
+            // The prior contents of the swapchain image are discarded as the entire image is drawn over
+            vk::AttachmentDescription attachment{
+                .format = *pFormat,
+                .samples = vk::SampleCountFlagBits::e1,
+                .loadOp = vk::AttachmentLoadOp::eDontCare,
+                .storeOp = vk::AttachmentStoreOp::eStore,
+                .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+                .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+                .initialLayout = vk::ImageLayout::eUndefined,
+                .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+            };
+            vk::AttachmentReference attachmentReference{
+                .attachment = 0,
+                .layout = vk::ImageLayout::eColorAttachmentOptimal,
+            };
+            vk::SubpassDescription subpass{
+                .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &attachmentReference,
+            };
+            vk::SubpassDependency dependency{
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = 0,
+                .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+            };
+            return gpu.renderPassCache.GetRenderPass(vk::RenderPassCreateInfo{
+                .attachmentCount = 1,
+                .pAttachments = &attachment,
+                .subpassCount = 1,
+                .pSubpasses = &subpass,
+                .dependencyCount = 1,
+                .pDependencies = &dependency,
+            });
+        }()),
+        pipeline([&] {
+            std::array<vk::PipelineShaderStageCreateInfo, 2> stages{
+                vk::PipelineShaderStageCreateInfo{
+                    .stage = vk::ShaderStageFlagBits::eVertex,
+                    .module = *vertexShaderModule,
+                    .pName = "main",
+                },
+                vk::PipelineShaderStageCreateInfo{
+                    .stage = vk::ShaderStageFlagBits::eFragment,
+                    .module = *fragmentShaderModule,
+                    .pName = "main",
+                },
+            };
+            vk::PipelineVertexInputStateCreateInfo vertexInputState{};
+            vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
+                .topology = vk::PrimitiveTopology::eTriangleList,
+            };
+            vk::PipelineViewportStateCreateInfo viewportState{
+                .viewportCount = 1,
+                .scissorCount = 1,
+            };
+            vk::PipelineRasterizationStateCreateInfo rasterizationState{
+                .polygonMode = vk::PolygonMode::eFill,
+                .cullMode = vk::CullModeFlagBits::eNone,
+                .lineWidth = 1.0f,
+            };
+            vk::PipelineMultisampleStateCreateInfo multisampleState{
+                .rasterizationSamples = vk::SampleCountFlagBits::e1,
+            };
+            vk::PipelineColorBlendAttachmentState colorBlendAttachment{
+                .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+            };
+            vk::PipelineColorBlendStateCreateInfo colorBlendState{
+                .attachmentCount = 1,
+                .pAttachments = &colorBlendAttachment,
+            };
+            constexpr static std::array<vk::DynamicState, 2> dynamicStates{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+            vk::PipelineDynamicStateCreateInfo dynamicState{
+                .dynamicStateCount = static_cast<u32>(dynamicStates.size()),
+                .pDynamicStates = dynamicStates.data(),
+            };
+
+            return vk::raii::Pipeline(gpu.vkDevice, gpu.pipelineCache.vkPipelineCache, vk::GraphicsPipelineCreateInfo{
+                .stageCount = static_cast<u32>(stages.size()),
+                .pStages = stages.data(),
+                .pVertexInputState = &vertexInputState,
+                .pInputAssemblyState = &inputAssemblyState,
+                .pViewportState = &viewportState,
+                .pRasterizationState = &rasterizationState,
+                .pMultisampleState = &multisampleState,
+                .pColorBlendState = &colorBlendState,
+                .pDynamicState = &dynamicState,
+                .layout = *pipelineLayout,
+                .renderPass = renderPass,
+                .subpass = 0,
+            });
+        }()),
+        format(pFormat) {}
+
+    bool PresentationBlitPass::IsSupported(const Texture &texture) {
+        return (texture.usage & vk::ImageUsageFlagBits::eSampled) && texture.format->vkAspect == vk::ImageAspectFlagBits::eColor && texture.dimensions.GetType() == vk::ImageType::e2D && texture.sampleCount == vk::SampleCountFlagBits::e1;
+    }
+
+    vk::Extent2D PresentationBlitPass::GetTransformedExtent(vk::Extent2D extent, NativeWindowTransform transform, NativeWindowTransform surfaceTransform) {
+        auto matrix{Multiply(GetTransformMatrix(surfaceTransform), GetTransformMatrix(transform))};
+        if (matrix[0][0] == 0)
+            return vk::Extent2D{extent.height, extent.width}; // The axes are swapped by an odd amount of rotations by 90 degrees
+        return extent;
+    }
+
+    void PresentationBlitPass::Blit(const std::shared_ptr<Texture> &source, const std::shared_ptr<Texture> &destination, vk::Rect2D region, NativeWindowTransform transform, NativeWindowTransform surfaceTransform) {
+        TRACE_EVENT("gpu", "PresentationBlitPass::Blit");
+
+        destination->WaitOnBacking();
+        destination->WaitOnFence();
+
+        source->WaitOnBacking();
+        source->WaitOnFence();
+
+        if (source->layout == vk::ImageLayout::eUndefined)
+            throw exception("Cannot blit from image with undefined layout");
+        else if (destination->format != format)
+            throw exception("Cannot blit into image with a format other than the pass format");
+
+        // Destination coordinates are mapped onto source coordinates with the inverse of the combined transform, this is the transpose as the matrix is orthogonal
+        auto matrix{Multiply(GetTransformMatrix(surfaceTransform), GetTransformMatrix(transform))};
+        std::array<float, 2> scale{static_cast<float>(region.extent.width) / static_cast<float>(source->dimensions.width), static_cast<float>(region.extent.height) / static_cast<float>(source->dimensions.height)};
+        std::array<float, 2> offset{static_cast<float>(region.offset.x) / static_cast<float>(source->dimensions.width), static_cast<float>(region.offset.y) / static_cast<float>(source->dimensions.height)};
+        PushConstants constants{};
+        for (size_t axis{}; axis < 2; axis++) {
+            constants.origin[axis] = offset[axis] + scale[axis] * (0.5f - 0.5f * static_cast<float>(matrix[0][axis] + matrix[1][axis]));
+            constants.xAxis[axis] = scale[axis] * static_cast<float>(matrix[0][axis]);
+            constants.yAxis[axis] = scale[axis] * static_cast<float>(matrix[1][axis]);
+        }
+
+        vk::ImageSubresourceRange subresource{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .levelCount = 1,
+            .layerCount = 1,
+        };
+        auto sourceView{TextureView(source, vk::ImageViewType::e2D, subresource).GetView()};
+        vk::ImageView destinationView;
+        {
+            std::scoped_lock lock(*destination);
+            destinationView = TextureView(destination, vk::ImageViewType::e2D, subresource).GetView();
+        }
+
+        vk::Extent2D extent{destination->dimensions.width, destination->dimensions.height};
+        auto framebuffer{gpu.framebufferCache.GetFramebuffer(vk::FramebufferCreateInfo{
+            .renderPass = renderPass,
+            .attachmentCount = 1,
+            .pAttachments = &destinationView,
+            .width = extent.width,
+            .height = extent.height,
+            .layers = 1,
+        }, span<const std::shared_ptr<Texture>>(&destination, 1))};
+
+        // Sources in the general layout are sampled in it directly, any others are transitioned into a read-only layout for the duration of the pass
+        auto sampledLayout{source->layout == vk::ImageLayout::eGeneral ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal};
+
+        auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
+            source->RecordDeferredLayout(commandBuffer);
+            destination->RecordDeferredLayout(commandBuffer);
+
+            auto sourceBacking{source->GetBacking()};
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = sourceBacking,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+                .oldLayout = source->layout,
+                .newLayout = sampledLayout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+
+            commandBuffer.beginRenderPass(vk::RenderPassBeginInfo{
+                .renderPass = renderPass,
+                .framebuffer = framebuffer,
+                .renderArea = {.extent = extent},
+            }, vk::SubpassContents::eInline);
+
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline);
+            std::array<DescriptorAllocator::DescriptorInfo, 1> descriptors{
+                vk::DescriptorImageInfo{
+                    .sampler = *sampler,
+                    .imageView = sourceView,
+                    .imageLayout = sampledLayout,
+                },
+            };
+            gpu.descriptor.Bind(commandBuffer, pCycle, vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, descriptorSetLayout, descriptors);
+            commandBuffer.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, constants);
+            commandBuffer.setViewport(0, vk::Viewport{
+                .width = static_cast<float>(extent.width),
+                .height = static_cast<float>(extent.height),
+                .maxDepth = 1.0f,
+            });
+            commandBuffer.setScissor(0, vk::Rect2D{.extent = extent});
+            commandBuffer.draw(3, 1, 0, 0);
+
+            commandBuffer.endRenderPass();
+
+            if (sampledLayout != source->layout)
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, vk::ImageMemoryBarrier{
+                    .image = sourceBacking,
+                    .srcAccessMask = vk::AccessFlagBits::eShaderRead,
+                    .dstAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                    .oldLayout = sampledLayout,
+                    .newLayout = source->layout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .subresourceRange = subresource,
+                });
+        })};
+        destination->layout = vk::ImageLayout::ePresentSrcKHR;
+
+        lCycle->AttachObjects(source, destination);
+        source->cycle = lCycle;
+        destination->cycle = lCycle;
+    }
+}
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <services/hosbinder/native_window.h>
+#include "descriptor_allocator.h"
+#include "texture/texture.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A graphics pass which draws a region of a frame into a swapchain image with any flips and rotations applied, this is used to pre-rotate frames into the orientation of the display
+     * @note Pre-rotating frames avoids the Android compositor having to rotate every frame in an additional full-screen composition pass, the crop and guest transform are applied alongside the rotation as the window can't apply them to a pre-rotated buffer
+     * @note This class is **NOT** thread-safe and should only be used from the presentation thread
+     */
+    class PresentationBlitPass {
+      private:
+        /**
+         * @brief The source coordinates at the top-left corner of the destination alongside the change in them across its width and height
+         * @note This must match the push constant block in presentation_blit.vert
+         */
+        struct PushConstants {
+            std::array<float, 2> origin;
+            std::array<float, 2> xAxis;
+            std::array<float, 2> yAxis;
+        };
+
+        GPU &gpu;
+        DescriptorAllocator::SetLayout descriptorSetLayout;
+        vk::raii::Sampler sampler; //!< A nearest sampler as the source region is always drawn at its own resolution
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::ShaderModule vertexShaderModule;
+        vk::raii::ShaderModule fragmentShaderModule;
+        vk::RenderPass renderPass;
+        vk::raii::Pipeline pipeline;
+
+      public:
+        texture::Format format; //!< The format of the images that are drawn into
+
+        PresentationBlitPass(GPU &gpu, texture::Format format);
+
+        /**
+         * @return If the supplied texture can be drawn from by this pass, any others have to be copied into swapchain images without pre-rotation
+         */
+        static bool IsSupported(const Texture &texture);
+
+        /**
+         * @return The extent of a region after both of the supplied transforms have been applied to it
+         */
+        static vk::Extent2D GetTransformedExtent(vk::Extent2D extent, service::hosbinder::NativeWindowTransform transform, service::hosbinder::NativeWindowTransform surfaceTransform);
+
+        /**
+         * @brief Draws a region of the source texture into the entirety of the destination with the guest transform and then the surface transform applied
+         * @note The destination is transitioned into VK_IMAGE_LAYOUT_PRESENT_SRC_KHR by this, the source texture **must** be locked prior to calling this
+         */
+        void Blit(const std::shared_ptr<Texture> &source, const std::shared_ptr<Texture> &destination, vk::Rect2D region, service::hosbinder::NativeWindowTransform transform, service::hosbinder::NativeWindowTransform surfaceTransform);
+    };
+}
@@ -1,31 +1,35 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <unistd.h>
 #include <android/native_window_jni.h>
 #include <android/choreographer.h>
 #include <common/settings.h>
 #include <common/signal.h>
+#include <common/performance_hint.h>
 #include <jvm.h>
 #include <gpu.h>
+#include <soc.h>
 #include <loader/loader.h>
+#include <kernel/scheduler.h>
 #include <kernel/types/KProcess.h>
 #include "presentation_engine.h"
 #include "native_window.h"
 #include "texture/format.h"
 
-extern jint Fps;
-extern jfloat AverageFrametimeMs;
-extern jfloat AverageFrametimeDeviationMs;
-
 namespace skyline::gpu {
+    static_assert(constant::CoreCount == perf::Counters::CoreCount);
+
     using namespace service::hosbinder;
 
     PresentationEngine::PresentationEngine(const DeviceState &state, GPU &gpu)
         : state(state),
           gpu(gpu),
           acquireFence(gpu.vkDevice, vk::FenceCreateInfo{}),
+          automation(state.settings->automationFrames ? std::make_unique<Automation>(state) : nullptr),
           presentationTrack(static_cast<u64>(trace::TrackIds::Presentation), perfetto::ProcessTrack::Current()),
           choreographerThread(&PresentationEngine::ChoreographerThread, this),
+          presentThread(&PresentationEngine::PresentThread, this),
           vsyncEvent(std::make_shared<kernel::type::KEvent>(state, true)) {
         auto desc{presentationTrack.Serialize()};
         desc.set_name("Presentation");
@@ -33,6 +37,18 @@ namespace skyline::gpu {
     }
 
     PresentationEngine::~PresentationEngine() {
+        if (presentThread.joinable()) {
+            {
+                std::scoped_lock lock(presentMutex);
+                presentStop = true;
+            }
+            presentCondition.notify_all();
+            presentThread.join();
+        }
+
+        if (guestThreadId)
+            perf::PerformanceHintSession::Get().RemoveThread(guestThreadId);
+
         auto env{state.jvm->GetEnv()};
         if (!env->IsSameObject(jSurface, nullptr))
             env->DeleteGlobalRef(jSurface);
@@ -86,6 +102,104 @@ namespace skyline::gpu {
         }
     }
 
+    /**
+     * @return The current time in nanoseconds on the CLOCK_MONOTONIC clock which all Android display timestamps are based on
+     */
+    i64 GetMonotonicTime() {
+        timespec time;
+        if (clock_gettime(CLOCK_MONOTONIC, &time))
+            throw exception("Failed to clock_gettime with '{}'", strerror(errno));
+        return (time.tv_sec * constant::NsInSecond) + time.tv_nsec;
+    }
+
+    /**
+     * @return The CPU time consumed by the calling thread in nanoseconds
+     */
+    static i64 GetThreadCpuTime() {
+        timespec time;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time))
+            throw exception("Failed to clock_gettime with '{}'", strerror(errno));
+        return (time.tv_sec * constant::NsInSecond) + time.tv_nsec;
+    }
+
+    void PresentationEngine::PresentThread() {
+        pthread_setname_np(pthread_self(), "Skyline-Present");
+        auto tid{static_cast<i32>(gettid())};
+        perf::PerformanceHintSession::Get().AddThread(tid);
+        if (state.settings->thermalPolicy)
+            thermalPolicy.emplace(gpu);
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+            while (true) {
+                PresentRequest request;
+                {
+                    std::unique_lock lock(presentMutex);
+                    presentCondition.wait(lock, [this]() { return presentStop || !presentQueue.empty(); });
+                    if (presentStop)
+                        break;
+
+                    request = std::move(presentQueue.front());
+                    presentQueue.pop_front();
+                    presentInFlight = true;
+                }
+
+                // The guest thread's work on a frame is measured against the duration of the refreshes it should be shown for, frames with a swap interval of 0 target a single refresh
+                i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : DefaultRefreshCycleDuration};
+                perf::PerformanceHintSession::Get().ReportFrame(refreshCycle * static_cast<i64>(std::max<u64>(request.swapInterval, 1)), request.workDuration);
+
+                if (!request.dropped) {
+                    request.fence.Wait(state.soc->host1x);
+
+                    if (IsFrameSkipped(request)) {
+                        TRACE_EVENT_INSTANT("gpu", "Frame Skipped", presentationTrack);
+                        PaceSkippedFrame(request.swapInterval);
+                    } else {
+                        std::scoped_lock textureLock(*request.texture);
+                        u64 frameId;
+                        PresentFrame(request.texture, request.timestamp, request.swapInterval, request.crop, request.scalingMode, request.transform, frameId);
+                        lastFrameTime = GetMonotonicTime();
+                    }
+
+                    if (thermalPolicy)
+                        thermalPolicy->Update(averageFrametimeNs, refreshCycle * static_cast<i64>(request.swapInterval));
+
+                    // Textures are only evicted between frames, they're stamped with the frame they were last used in
+                    gpu.texture.EndFrame();
+
+                    if (state.settings->frameSkip)
+                        UpdateFrameSkip(request.swapInterval);
+                }
+
+                request.releaseCallback();
+                {
+                    std::scoped_lock lock(presentMutex);
+                    presentInFlight = false;
+                }
+                releaseCondition.notify_all();
+            }
+        } catch (const signal::SignalException &e) {
+            Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+            if (state.process)
+                state.process->Kill(false);
+            else
+                std::rethrow_exception(std::current_exception());
+        } catch (const std::exception &e) {
+            Logger::Error(e.what());
+            if (state.process)
+                state.process->Kill(false);
+            else
+                std::rethrow_exception(std::current_exception());
+        }
+
+        // Any threads waiting on frames to be released are woken up as the frames left in the queue will never be released
+        {
+            std::scoped_lock lock(presentMutex);
+            presentStop = true;
+        }
+        releaseCondition.notify_all();
+    }
+
     NativeWindowTransform GetAndroidTransform(vk::SurfaceTransformFlagBitsKHR transform) {
         using NativeWindowTransform = NativeWindowTransform;
         switch (transform) {
@@ -109,7 +223,7 @@ namespace skyline::gpu {
         }
     }
 
-    void PresentationEngine::UpdateSwapchain(texture::Format format, texture::Dimensions extent) {
+    void PresentationEngine::UpdateSwapchain(texture::Format format, texture::Dimensions extent, vk::SurfaceTransformFlagBitsKHR preTransform) {
         auto minImageCount{std::max(vkSurfaceCapabilities.minImageCount, state.settings->forceTripleBuffering ? 3U : 2U)};
         if (minImageCount > MaxSwapchainImageCount)
             throw exception("Requesting swapchain with higher image count ({}) than maximum slot count ({})", minImageCount, MaxSwapchainImageCount);
@@ -130,9 +244,18 @@ namespace skyline::gpu {
         if ((capabilities.supportedUsageFlags & presentUsage) != presentUsage)
             throw exception("Swapchain doesn't support image usage '{}': {}", vk::to_string(presentUsage), vk::to_string(capabilities.supportedUsageFlags));
 
-        auto requestedMode{state.settings->disableFrameThrottling ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eFifo};
         auto modes{gpu.vkPhysicalDevice.getSurfacePresentModesKHR(**vkSurface)};
-        if (std::find(modes.begin(), modes.end(), requestedMode) == modes.end())
+        auto isModeSupported{[&](vk::PresentModeKHR mode) {
+            return std::find(modes.begin(), modes.end(), mode) != modes.end();
+        }};
+
+        // Frame pacing requires mailbox presentation as frames are throttled by us instead, we fall back to FIFO on surfaces without mailbox support
+        framePacing = !state.settings->disableFrameThrottling && state.settings->framePacing && isModeSupported(vk::PresentModeKHR::eMailbox);
+        presentMargin = DefaultPresentMargin;
+        lastTargetPresentTime = 0;
+
+        auto requestedMode{state.settings->disableFrameThrottling || framePacing ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eFifo};
+        if (!isModeSupported(requestedMode))
             throw exception("Swapchain doesn't support present mode: {}", vk::to_string(requestedMode));
 
         vkSwapchain.emplace(gpu.vkDevice, vk::SwapchainCreateInfoKHR{
@@ -144,6 +267,7 @@ namespace skyline::gpu {
             .imageArrayLayers = 1,
             .imageUsage = presentUsage,
             .imageSharingMode = vk::SharingMode::eExclusive,
+            .preTransform = preTransform,
             .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eInherit,
             .presentMode = requestedMode,
             .clipped = true,
@@ -156,7 +280,7 @@ namespace skyline::gpu {
         for (size_t index{}; index < vkImages.size(); index++) {
             auto &slot{images[index]};
             slot = std::make_shared<Texture>(*state.gpu, vkImages[index], extent, format, vk::ImageLayout::eUndefined, vk::ImageTiling::eOptimal);
-            slot->TransitionLayout(vk::ImageLayout::ePresentSrcKHR);
+            slot->DeferLayoutTransition(vk::ImageLayout::ePresentSrcKHR); // This is recorded alongside the first copy into the image rather than being submitted for every image
         }
         for (size_t index{vkImages.size()}; index < MaxSwapchainImageCount; index++)
             // We need to clear all the slots which aren't filled, keeping around stale slots could lead to issues
@@ -164,6 +288,60 @@ namespace skyline::gpu {
 
         swapchainFormat = format;
         swapchainExtent = extent;
+        swapchainTransform = preTransform;
+
+        int result;
+        if (preTransform != vk::SurfaceTransformFlagBitsKHR::eIdentity) {
+            if (!blitPass || blitPass->format != format)
+                blitPass.emplace(gpu, format);
+
+            // The crop is applied while pre-rotating as the window would apply it to the rotated buffer, any prior crop must be removed
+            if (windowCrop) {
+                AndroidRect emptyCrop{};
+                if ((result = window->perform(window, NATIVE_WINDOW_SET_CROP, &emptyCrop)))
+                    throw exception("Removing the layer crop failed with {}", result);
+                windowCrop = {};
+            }
+        } else if (windowTransform != NativeWindowTransform::Identity && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(windowTransform)))) {
+            // The buffer transform of the window is overwritten with the inverse of the pre-transform on the creation of a swapchain, the guest transform has to be reapplied
+            throw exception("Setting the buffer transform to '{}' failed with {}", ToString(windowTransform), result);
+        }
+    }
+
+    vk::SurfaceTransformFlagBitsKHR PresentationEngine::GetPreTransform(const Texture &texture) {
+        auto transform{vkSurfaceCapabilities.currentTransform};
+        if (transform == vk::SurfaceTransformFlagBitsKHR::eIdentity || transform == vk::SurfaceTransformFlagBitsKHR::eInherit || !(vkSurfaceCapabilities.supportedTransforms & transform) || !PresentationBlitPass::IsSupported(texture))
+            return vk::SurfaceTransformFlagBitsKHR::eIdentity;
+        return transform;
+    }
+
+    i64 PresentationEngine::PredictPresentTime(i64 timestamp, u64 swapInterval) {
+        i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : DefaultRefreshCycleDuration};
+        i64 lastRefreshTime{lastChoreographerTime}; // This is written by the Choreographer thread, we need a consistent value throughout prediction
+
+        // The frame can't be displayed on a refresh sooner than we can present it by or sooner than its swap interval after the last paced frame
+        i64 target{std::max(GetMonotonicTime() + presentMargin, timestamp)};
+        if (lastTargetPresentTime)
+            target = std::max(target, lastTargetPresentTime + (refreshCycle * static_cast<i64>(swapInterval)) - (refreshCycle / 2)); // Half a refresh cycle of slack avoids skipping a refresh due to jitter in the measured refresh cycle
+
+        // The target is snapped to the next refresh on the grid extrapolated from the last Choreographer callback
+        if (lastRefreshTime && target > lastRefreshTime)
+            target = lastRefreshTime + (((target - lastRefreshTime) + refreshCycle - 1) / refreshCycle) * refreshCycle;
+
+        lastTargetPresentTime = target;
+        return target;
+    }
+
+    void PresentationEngine::UpdatePresentMargin() {
+        i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : DefaultRefreshCycleDuration};
+        for (const auto &timing : vkSwapchain->getPastPresentationTimingGOOGLE()) {
+            if (static_cast<i64>(timing.actualPresentTime) > static_cast<i64>(timing.desiredPresentTime) + (refreshCycle / 2))
+                // The frame missed the refresh it targeted, the margin is increased substantially as missing a refresh is far costlier than a slightly higher latency
+                presentMargin = std::min(presentMargin + (refreshCycle / 4), refreshCycle);
+            else if (static_cast<i64>(timing.presentMargin) > MinimumPresentMargin)
+                // The frame was presented earlier than it needed to be, the margin is gradually reduced to present later
+                presentMargin = std::max(presentMargin - ((static_cast<i64>(timing.presentMargin) - MinimumPresentMargin) / 8), MinimumPresentMargin);
+        }
     }
 
     void PresentationEngine::UpdateSurface(jobject newSurface) {
@@ -187,15 +365,19 @@ namespace skyline::gpu {
             if (!gpu.vkPhysicalDevice.getSurfaceSupportKHR(gpu.vkQueueFamilyIndex, **vkSurface))
                 throw exception("Vulkan Queue doesn't support presentation with surface");
             vkSurfaceCapabilities = gpu.vkPhysicalDevice.getSurfaceCapabilitiesKHR(**vkSurface);
-
-            if (swapchainExtent && swapchainFormat)
-                UpdateSwapchain(swapchainFormat, swapchainExtent);
+            transformHint.store(GetAndroidTransform(vkSurfaceCapabilities.currentTransform), std::memory_order_relaxed);
+            surfaceAvailable.store(true, std::memory_order_release);
 
             if (window->common.magic != AndroidNativeWindowMagic)
                 throw exception("ANativeWindow* has unexpected magic: {} instead of {}", span(&window->common.magic, 1).as_string(true), span<const u8>(reinterpret_cast<const u8 *>(&AndroidNativeWindowMagic), sizeof(u32)).as_string(true));
             if (window->common.version != sizeof(ANativeWindow))
                 throw exception("ANativeWindow* has unexpected version: {} instead of {}", window->common.version, sizeof(ANativeWindow));
 
+            // A pre-rotated swapchain is only recreated if the new surface is in the same orientation, it's recreated with the extent of the new orientation on the next frame otherwise
+            // The guest transform is reapplied to the window alongside the creation of the swapchain
+            if (swapchainExtent && swapchainFormat && (swapchainTransform == vk::SurfaceTransformFlagBitsKHR::eIdentity || swapchainTransform == vkSurfaceCapabilities.currentTransform))
+                UpdateSwapchain(swapchainFormat, swapchainExtent, swapchainTransform);
+
             int result;
             if (windowCrop && (result = window->perform(window, NATIVE_WINDOW_SET_CROP, &windowCrop)))
                 throw exception("Setting the layer crop to ({}-{})x({}-{}) failed with {}", windowCrop.left, windowCrop.right, windowCrop.top, windowCrop.bottom, result);
@@ -203,28 +385,105 @@ namespace skyline::gpu {
             if (windowScalingMode != NativeWindowScalingMode::ScaleToWindow && (result = window->perform(window, NATIVE_WINDOW_SET_SCALING_MODE, static_cast<i32>(windowScalingMode))))
                 throw exception("Setting the layer scaling mode to '{}' failed with {}", ToString(windowScalingMode), result);
 
-            if (windowTransform != NativeWindowTransform::Identity && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(windowTransform))))
-                throw exception("Setting the buffer transform to '{}' failed with {}", ToString(windowTransform), result);
-
             if ((result = window->perform(window, NATIVE_WINDOW_ENABLE_FRAME_TIMESTAMPS, true)))
                 throw exception("Enabling frame timestamps failed with {}", result);
 
             surfaceCondition.notify_all();
         } else {
+            surfaceAvailable.store(false, std::memory_order_release);
             vkSurface.reset();
             window = nullptr;
         }
+        perf::PerformanceHintSession::Get().RemoveThread(tid);
     }
 
-    void PresentationEngine::Present(const std::shared_ptr<Texture> &texture, i64 timestamp, u64 swapInterval, AndroidRect crop, NativeWindowScalingMode scalingMode, NativeWindowTransform transform, u64 &frameId) {
+    void PresentationEngine::Present(const std::shared_ptr<Texture> &texture, const AndroidFence &fence, i64 timestamp, u64 swapInterval, AndroidRect crop, NativeWindowScalingMode scalingMode, NativeWindowTransform transform, std::function<void()> releaseCallback) {
+        auto tid{static_cast<i32>(gettid())};
+        auto cpuTime{GetThreadCpuTime()};
+        {
+            std::scoped_lock lock(presentMutex);
+            i64 workDuration{};
+            if (tid == guestThreadId) {
+                workDuration = cpuTime - guestThreadCpuTime;
+            } else {
+                // The work of a newly presenting thread can only be measured from its second frame onwards
+                auto &session{perf::PerformanceHintSession::Get()};
+                if (guestThreadId)
+                    session.RemoveThread(guestThreadId);
+                session.AddThread(tid);
+                guestThreadId = tid;
+            }
+            guestThreadCpuTime = cpuTime;
+
+            auto pendingCount{static_cast<size_t>(std::count_if(presentQueue.begin(), presentQueue.end(), [](const PresentRequest &request) { return !request.dropped; }))};
+            if (pendingCount >= PresentQueueDepth) {
+                // The oldest pending frame is dropped rather than blocking the guest, it's released by the present thread to keep releases in order and off the calling thread
+                auto oldest{std::find_if(presentQueue.begin(), presentQueue.end(), [](const PresentRequest &request) { return !request.dropped; })};
+                oldest->dropped = true;
+                TRACE_EVENT_INSTANT("gpu", "Frame Dropped", presentationTrack);
+            }
+
+            texture->presentable.store(true, std::memory_order_relaxed);
+            queuedFrames.fetch_add(1, std::memory_order_relaxed);
+            presentQueue.push_back(PresentRequest{
+                .texture = texture,
+                .fence = fence,
+                .timestamp = timestamp,
+                .swapInterval = swapInterval,
+                .crop = crop,
+                .scalingMode = scalingMode,
+                .transform = transform,
+                .releaseCallback = std::move(releaseCallback),
+                .workDuration = workDuration,
+            });
+        }
+        presentCondition.notify_one();
+    }
+
+    void PresentationEngine::ReleaseQueuedFrames() {
+        std::unique_lock lock(presentMutex);
+        for (auto &request : presentQueue)
+            request.dropped = true;
+        presentCondition.notify_one();
+        releaseCondition.wait(lock, [this]() { return presentStop || (presentQueue.empty() && !presentInFlight); });
+    }
+
+    void PresentationEngine::PresentFrame(const std::shared_ptr<Texture> &texture, i64 timestamp, u64 swapInterval, AndroidRect crop, NativeWindowScalingMode scalingMode, NativeWindowTransform transform, u64 &frameId) {
         std::unique_lock lock(mutex);
         surfaceCondition.wait(lock, [this]() { return vkSurface.has_value(); });
 
-        if (texture->format != swapchainFormat || texture->dimensions != swapchainExtent)
-            UpdateSwapchain(texture->format, texture->dimensions);
+        if (crop && texture->IsScaled()) {
+            // The crop is supplied at the guest resolution, it needs to be scaled to the resolution of the swapchain which matches the host texture
+            auto scaledCrop{texture->ScaleRect(vk::Rect2D{
+                .offset = {static_cast<i32>(crop.left), static_cast<i32>(crop.top)},
+                .extent = {crop.right - crop.left, crop.bottom - crop.top},
+            })};
+            crop = AndroidRect{
+                .left = static_cast<u32>(scaledCrop.offset.x),
+                .top = static_cast<u32>(scaledCrop.offset.y),
+                .right = static_cast<u32>(scaledCrop.offset.x) + scaledCrop.extent.width,
+                .bottom = static_cast<u32>(scaledCrop.offset.y) + scaledCrop.extent.height,
+            };
+        }
+
+        // Frames are pre-rotated into the orientation of the display when possible, this avoids the compositor rotating every frame in an additional composition pass
+        // The crop and guest transform are applied alongside the rotation as the window can't apply them to a pre-rotated buffer, the swapchain matches the extent of the transformed crop so the region is drawn 1:1
+        auto preTransform{GetPreTransform(*texture)};
+        vk::Rect2D region{.extent = {texture->dimensions.width, texture->dimensions.height}};
+        texture::Dimensions extent{texture->dimensions};
+        if (preTransform != vk::SurfaceTransformFlagBitsKHR::eIdentity) {
+            if (crop) {
+                region.offset = vk::Offset2D{static_cast<i32>(std::min(crop.left, texture->dimensions.width - 1)), static_cast<i32>(std::min(crop.top, texture->dimensions.height - 1))};
+                region.extent = vk::Extent2D{std::min(crop.right, texture->dimensions.width) - static_cast<u32>(region.offset.x), std::min(crop.bottom, texture->dimensions.height) - static_cast<u32>(region.offset.y)};
+            }
+            extent = texture::Dimensions{PresentationBlitPass::GetTransformedExtent(region.extent, transform, GetAndroidTransform(preTransform))};
+        }
+
+        if (!vkSwapchain || texture->format != swapchainFormat || extent != swapchainExtent || preTransform != swapchainTransform)
+            UpdateSwapchain(texture->format, extent, preTransform);
 
         int result;
-        if (crop && crop != windowCrop) {
+        if (crop && crop != windowCrop && swapchainTransform == vk::SurfaceTransformFlagBitsKHR::eIdentity) {
             if ((result = window->perform(window, NATIVE_WINDOW_SET_CROP, &crop)))
                 throw exception("Setting the layer crop to ({}-{})x({}-{}) failed with {}", crop.left, crop.right, crop.top, crop.bottom, result);
             windowCrop = crop;
@@ -237,7 +496,7 @@ namespace skyline::gpu {
         }
 
         if (transform != windowTransform) {
-            if ((result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(transform))))
+            if (swapchainTransform == vk::SurfaceTransformFlagBitsKHR::eIdentity && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(transform))))
                 throw exception("Setting the buffer transform to '{}' failed with {}", ToString(transform), result);
             windowTransform = transform;
         }
@@ -253,49 +512,94 @@ namespace skyline::gpu {
         }
 
         std::ignore = gpu.vkDevice.waitForFences(*acquireFence, true, std::numeric_limits<u64>::max());
-        images.at(nextImage.second)->CopyFrom(texture, vk::ImageSubresourceRange{
-            .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .levelCount = 1,
-            .layerCount = 1,
-        });
+
+        // Frames written by the CPU are uploaded straight into the swapchain image, all other frames have to be copied from the host texture into it
+        auto &image{images.at(nextImage.second)};
+        if (swapchainTransform != vk::SurfaceTransformFlagBitsKHR::eIdentity) {
+            texture->SynchronizeHost();
+            blitPass->Blit(texture, image, region, transform, GetAndroidTransform(swapchainTransform));
+        } else if (!texture->SynchronizeHostInto(image)) {
+            texture->SynchronizeHost();
+            image->CopyFrom(texture, vk::ImageSubresourceRange{
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .levelCount = 1,
+                .layerCount = 1,
+            });
+        }
 
         if (timestamp) {
             // If the timestamp is specified, we need to convert it from the util::GetTimeNs base to the CLOCK_MONOTONIC one
             // We do so by getting an offset from the current time in nanoseconds and then adding it to the current time in CLOCK_MONOTONIC
             // Note: It's important we do this right before present as going past the timestamp could lead to fewer Binder IPC calls
             i64 current{util::GetTimeNs()};
-            if (current < timestamp) {
-                timespec time;
-                if (clock_gettime(CLOCK_MONOTONIC, &time))
-                    throw exception("Failed to clock_gettime with '{}'", strerror(errno));
-                timestamp = ((time.tv_sec * constant::NsInSecond) + time.tv_nsec) + (timestamp - current);
-            } else {
+            if (current < timestamp)
+                timestamp = GetMonotonicTime() + (timestamp - current);
+            else
                 timestamp = 0;
-            }
         }
 
-        if (swapInterval > 1)
+        bool paced{framePacing && swapInterval}; //!< If this frame is paced by us, frames with a swap interval of 0 are presented immediately as they are unthrottled
+        if (paced) {
+            if (gpu.supportsDisplayTiming)
+                UpdatePresentMargin();
+
+            // We wait till right before the targeted refresh to present the frame, this throttles the guest without queueing frames in the swapchain which would add latency
+            timestamp = PredictPresentTime(timestamp, swapInterval);
+            i64 wakeTime{timestamp - presentMargin};
+            timespec wakeTimespec{
+                .tv_sec = static_cast<time_t>(wakeTime / constant::NsInSecond),
+                .tv_nsec = static_cast<long>(wakeTime % constant::NsInSecond),
+            };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTimespec, nullptr) == EINTR);
+        } else if (swapInterval > 1) {
             // If we have a swap interval above 1 we have to adjust the timestamp to emulate the swap interval
             timestamp = std::max(timestamp, lastChoreographerTime + (refreshCycleDuration * static_cast<i64>(swapInterval) * 2));
+        }
 
-        auto lastTimestamp{std::exchange(windowLastTimestamp, timestamp)};
-        if (!timestamp && lastTimestamp)
-            // We need to nullify the timestamp if it transitioned from being specified (non-zero) to unspecified (zero)
-            timestamp = NativeWindowTimestampAuto;
+        // The desired present time of VK_GOOGLE_display_timing is applied to the window by the driver, we must not set the window timestamp ourselves in that case
+        bool displayTimed{paced && gpu.supportsDisplayTiming};
+        if (!displayTimed) {
+            auto lastTimestamp{std::exchange(windowLastTimestamp, timestamp)};
+            if (!timestamp && lastTimestamp)
+                // We need to nullify the timestamp if it transitioned from being specified (non-zero) to unspecified (zero)
+                timestamp = NativeWindowTimestampAuto;
 
-        if (timestamp && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TIMESTAMP, timestamp)))
-            throw exception("Setting the buffer timestamp to {} failed with {}", timestamp, result);
+            if (timestamp && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TIMESTAMP, timestamp)))
+                throw exception("Setting the buffer timestamp to {} failed with {}", timestamp, result);
+        } else {
+            windowLastTimestamp = timestamp;
+        }
 
         if ((result = window->perform(window, NATIVE_WINDOW_GET_NEXT_FRAME_ID, &frameId)))
             throw exception("Retrieving the next frame's ID failed with {}", result);
 
+        vk::Result presentResult;
         {
+            vk::PresentTimeGOOGLE presentTime{
+                .presentID = nextPresentId,
+                .desiredPresentTime = static_cast<u64>(timestamp),
+            };
+            vk::PresentTimesInfoGOOGLE presentTimesInfo{
+                .swapchainCount = 1,
+                .pTimes = &presentTime,
+            };
+            if (displayTimed && ++nextPresentId == 0)
+                nextPresentId = 1;
+
             std::lock_guard queueLock(gpu.queueMutex);
-            std::ignore = gpu.vkQueue.presentKHR(vk::PresentInfoKHR{
+            presentResult = gpu.vkQueue.presentKHR(vk::PresentInfoKHR{
+                .pNext = displayTimed ? &presentTimesInfo : nullptr,
                 .swapchainCount = 1,
                 .pSwapchains = &**vkSwapchain,
                 .pImageIndices = &nextImage.second,
-            }); // We don't care about suboptimal images as they are caused by not respecting the transform hint, we handle transformations externally
+            });
+        }
+
+        // Suboptimal presentation is caused by the pre-transform not matching the orientation of the display, it's expected if we couldn't pre-rotate the frame
+        // If the pre-transform matched the orientation we last knew of then the display has been rotated, the surface is queried again so the swapchain is recreated in the new orientation on the next frame
+        if (presentResult == vk::Result::eSuboptimalKHR && swapchainTransform == vkSurfaceCapabilities.currentTransform) {
+            vkSurfaceCapabilities = gpu.vkPhysicalDevice.getSurfaceCapabilitiesKHR(**vkSurface);
+            transformHint.store(GetAndroidTransform(vkSurfaceCapabilities.currentTransform), std::memory_order_relaxed);
         }
 
         if (frameTimestamp) {
@@ -308,25 +612,117 @@ namespace skyline::gpu {
 
             i64 currentFrametime{now - frameTimestamp};
             averageFrametimeNs = weightedAverage(sampleWeight, averageFrametimeNs, currentFrametime);
-            AverageFrametimeMs = static_cast<jfloat>(averageFrametimeNs) / constant::NsInMillisecond;
 
             i64 currentFrametimeDeviation{std::abs(averageFrametimeNs - currentFrametime)};
             averageFrametimeDeviationNs = weightedAverage(sampleWeight, averageFrametimeDeviationNs, currentFrametimeDeviation);
-            AverageFrametimeDeviationMs = static_cast<jfloat>(averageFrametimeDeviationNs) / constant::NsInMillisecond;
 
-            Fps = static_cast<jint>(std::round(static_cast<float>(constant::NsInSecond) / static_cast<float>(averageFrametimeNs)));
+            auto fps{static_cast<u32>(std::round(static_cast<float>(constant::NsInSecond) / static_cast<float>(averageFrametimeNs)))};
 
-            TRACE_EVENT_INSTANT("gpu", "Present", presentationTrack, "FrameTimeNs", now - frameTimestamp, "Fps", Fps);
+            TRACE_EVENT_INSTANT("gpu", "Present", presentationTrack, "FrameTimeNs", now - frameTimestamp, "Fps", fps);
 
+            UpdatePerformanceCounters(now, fps);
             frameTimestamp = now;
         } else {
             frameTimestamp = util::GetTimeNs();
+            UpdatePerformanceCounters(frameTimestamp, 0);
+            trace::BootProfile::MarkFirstFramePresented();
+        }
+
+        if (automation) [[unlikely]]
+            automation->OnFramePresented(frameTimestamp);
+    }
+
+    bool PresentationEngine::IsFrameSkipped(const PresentRequest &request) {
+        // The mark is always consumed as rendering into the texture may have been skipped prior to frame skipping being disabled
+        if (request.texture->presentSkipped.exchange(false, std::memory_order_acquire))
+            return true;
+
+        // Presentation alone is skipped for every other frame if rendering isn't skipped, frames with rendering skipped are dropped through the mark instead
+        if (!frameSkipping.load(std::memory_order_relaxed) || state.settings->frameSkipRendering)
+            return false;
+        skipNextPresent = !skipNextPresent;
+        return !skipNextPresent;
+    }
+
+    void PresentationEngine::PaceSkippedFrame(u64 swapInterval) {
+        i64 wakeTime;
+        {
+            std::scoped_lock lock(mutex);
+            i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : DefaultRefreshCycleDuration};
+            if (framePacing && swapInterval)
+                // The refresh the dropped frame would have targeted is reserved so the next frame targets the one after it
+                wakeTime = PredictPresentTime(0, swapInterval) - presentMargin;
+            else
+                wakeTime = lastFrameTime + (refreshCycle * static_cast<i64>(swapInterval));
         }
+
+        timespec wakeTimespec{
+            .tv_sec = static_cast<time_t>(wakeTime / constant::NsInSecond),
+            .tv_nsec = static_cast<long>(wakeTime % constant::NsInSecond),
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTimespec, nullptr) == EINTR);
+        lastFrameTime = std::max(wakeTime, GetMonotonicTime());
+    }
+
+    void PresentationEngine::UpdateFrameSkip(u64 swapInterval) {
+        // GPU time is only resolved once command buffers complete, any lag in this is smoothed over by the average
+        auto gpuTime{gpu.timestamps.GetGpuTime()};
+        i64 frameGpuTime{gpuTime - std::exchange(frameSkipGpuTime, gpuTime)};
+        averageGpuFrametimeNs = (((FrameSkipWeight - 1) * averageGpuFrametimeNs) + frameGpuTime) / FrameSkipWeight;
+
+        if (frameSkipHold) {
+            frameSkipHold--;
+            return;
+        }
+
+        // Unthrottled frames have no budget as the guest isn't waiting on the display
+        i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : DefaultRefreshCycleDuration};
+        auto budget{static_cast<float>(refreshCycle * static_cast<i64>(swapInterval))};
+        auto ratio{static_cast<float>(averageGpuFrametimeNs) / budget};
+        bool skipping{frameSkipping.load(std::memory_order_relaxed)};
+        auto enableRatio{thermalPolicy && thermalPolicy->GetLevel() >= 2 ? FrameSkipThermalEnableRatio : FrameSkipEnableRatio};
+        if (!skipping && swapInterval && ratio > enableRatio) {
+            frameSkipping.store(true, std::memory_order_relaxed);
+            frameSkipHold = FrameSkipHoldFrames;
+            Logger::Info("Enabling frame skipping as the GPU frame time is {:.2f}ms with a budget of {:.2f}ms", static_cast<float>(averageGpuFrametimeNs) / constant::NsInMillisecond, budget / constant::NsInMillisecond);
+        } else if (skipping && (!swapInterval || ratio < (state.settings->frameSkipRendering ? FrameSkipRenderingDisableRatio : FrameSkipDisableRatio))) {
+            frameSkipping.store(false, std::memory_order_relaxed);
+            frameSkipHold = FrameSkipHoldFrames;
+            Logger::Info("Disabling frame skipping as the GPU frame time is {:.2f}ms", static_cast<float>(averageGpuFrametimeNs) / constant::NsInMillisecond);
+        }
+    }
+
+    bool PresentationEngine::SkipFrameRendering() {
+        return state.settings->frameSkipRendering && frameSkipping.load(std::memory_order_relaxed) && (frameSkipParity.fetch_add(1, std::memory_order_relaxed) & 1);
+    }
+
+    void PresentationEngine::UpdatePerformanceCounters(i64 now, u32 fps) {
+        auto &counters{perf::SharedCounters};
+        counters.fps.store(fps, std::memory_order_relaxed);
+        counters.averageFrametimeMs.store(static_cast<float>(averageFrametimeNs) / constant::NsInMillisecond, std::memory_order_relaxed);
+        counters.averageFrametimeDeviationMs.store(static_cast<float>(averageFrametimeDeviationNs) / constant::NsInMillisecond, std::memory_order_relaxed);
+
+        i64 elapsed{now - frameTimestamp}; // This is zero for the first frame which only establishes the baseline for all deltas
+        for (u8 coreId{}; coreId < constant::CoreCount; coreId++) {
+            auto heldTime{state.scheduler->GetCoreHeldTime(coreId)};
+            if (elapsed > 0)
+                counters.coreUtilization[coreId].store(std::min(static_cast<float>(heldTime - lastCoreHeldTime[coreId]) * 100.0f / static_cast<float>(elapsed), 100.0f), std::memory_order_relaxed);
+            lastCoreHeldTime[coreId] = heldTime;
+        }
+
+        auto gpuTime{gpu.timestamps.GetGpuTime()};
+        counters.gpuTimeMs.store(static_cast<float>(gpuTime - lastGpuTime) / constant::NsInMillisecond, std::memory_order_relaxed);
+        lastGpuTime = gpuTime;
+
+        counters.presentCount.fetch_add(1, std::memory_order_release);
     }
 
     NativeWindowTransform PresentationEngine::GetTransformHint() {
-        std::unique_lock lock(mutex);
-        surfaceCondition.wait(lock, [this]() { return vkSurface.has_value(); });
-        return GetAndroidTransform(vkSurfaceCapabilities.currentTransform);
+        if (!surfaceAvailable.load(std::memory_order_acquire)) {
+            // We only need to lock the mutex if there's no surface yet, it's held by the present thread throughout presentation otherwise
+            std::unique_lock lock(mutex);
+            surfaceCondition.wait(lock, [this]() { return vkSurface.has_value(); });
+        }
+        return transformHint.load(std::memory_order_relaxed);
     }
 }
@@ -3,12 +3,17 @@
 
 #pragma once
 
+#include <deque>
 #include <jni.h>
 #include <android/looper.h>
 #include <common/trace.h>
+#include <common/performance_counters.h>
+#include <automation.h>
 #include <kernel/types/KEvent.h>
 #include <services/hosbinder/GraphicBufferProducer.h>
 #include "texture/texture.h"
+#include "presentation_blit_pass.h"
+#include "thermal_policy.h"
 
 struct ANativeWindow;
 
@@ -27,16 +32,20 @@ namespace skyline::gpu {
         ANativeWindow *window{}; //!< The backing Android Native Window for the surface we draw to, we keep this around to access private APIs not exposed via Vulkan
         service::hosbinder::AndroidRect windowCrop{}; //!< A rectangle with the bounds of the current crop performed on the image prior to presentation
         service::hosbinder::NativeWindowScalingMode windowScalingMode{service::hosbinder::NativeWindowScalingMode::ScaleToWindow}; //!< The mode in which the cropped image is scaled up to the surface
-        service::hosbinder::NativeWindowTransform windowTransform{}; //!< The transformation performed on the image prior to presentation
+        service::hosbinder::NativeWindowTransform windowTransform{}; //!< The transformation performed on the image prior to presentation, this is applied by the window unless frames are pre-rotated
         u64 windowLastTimestamp{}; //!< The last timestamp submitted to the window, 0 or CLOCK_MONOTONIC value
 
         std::optional<vk::raii::SurfaceKHR> vkSurface; //!< The Vulkan Surface object that is backed by ANativeWindow
         vk::SurfaceCapabilitiesKHR vkSurfaceCapabilities; //!< The capabilities of the current Vulkan Surface
+        std::atomic<bool> surfaceAvailable{}; //!< If there's a valid Vulkan surface, this can be read without locking the mutex
+        std::atomic<service::hosbinder::NativeWindowTransform> transformHint{}; //!< The transform hint of the current surface, this is cached to avoid contending with presentation for the mutex
 
         std::optional<vk::raii::SwapchainKHR> vkSwapchain; //!< The Vulkan swapchain and the properties associated with it
         vk::raii::Fence acquireFence; //!< A fence for acquiring an image from the swapchain
         texture::Format swapchainFormat{}; //!< The image format of the textures in the current swapchain
         texture::Dimensions swapchainExtent{}; //!< The extent of images in the current swapchain
+        vk::SurfaceTransformFlagBitsKHR swapchainTransform{vk::SurfaceTransformFlagBitsKHR::eIdentity}; //!< The pre-transform of the current swapchain, frames are pre-rotated by us rather than by the compositor when this isn't the identity
+        std::optional<PresentationBlitPass> blitPass; //!< The pass that frames are pre-rotated with, this is only created once a swapchain is pre-rotated
 
         static constexpr size_t MaxSwapchainImageCount{6}; //!< The maximum amount of swapchain textures, this affects the amount of images that can be in the swapchain
         std::array<std::shared_ptr<Texture>, MaxSwapchainImageCount> images; //!< All the swapchain textures in the same order as supplied by the host swapchain
@@ -44,6 +53,9 @@ namespace skyline::gpu {
         i64 frameTimestamp{}; //!< The timestamp of the last frame being shown in nanoseconds
         i64 averageFrametimeNs{}; //!< The average time between frames in nanoseconds
         i64 averageFrametimeDeviationNs{}; //!< The average deviation of frametimes in nanoseconds
+        std::array<u64, perf::Counters::CoreCount> lastCoreHeldTime{}; //!< The held time of every guest core as of the last update of the performance counters in nanoseconds
+        i64 lastGpuTime{}; //!< The total GPU execution time as of the last update of the performance counters in nanoseconds
+        std::unique_ptr<Automation> automation; //!< The automated benchmark run that's driven by presented frames, this is only allocated when one was requested
         perfetto::Track presentationTrack; //!< Perfetto track used for presentation events
 
         std::thread choreographerThread; //!< A thread for signalling the V-Sync event and measure the refresh cycle duration using AChoreographer
@@ -52,6 +64,56 @@ namespace skyline::gpu {
         i64 refreshCycleDuration{}; //!< The duration of a single refresh cycle for the display in nanoseconds
         bool choreographerStop{}; //!< If the Choreographer thread should stop on the next ALooper_wake()
 
+        static constexpr i64 DefaultRefreshCycleDuration{constant::NsInSecond / 60}; //!< The refresh cycle duration that's assumed prior to the Choreographer measuring it
+        static constexpr i64 DefaultPresentMargin{4 * constant::NsInMillisecond}; //!< The initial margin between presenting a paced frame and the refresh it targets, this is only adjusted with display timing feedback
+        static constexpr i64 MinimumPresentMargin{constant::NsInMillisecond}; //!< The lowest margin that display timing feedback can reduce the present margin to
+        bool framePacing{}; //!< If the current swapchain uses mailbox presentation with frames being paced by us rather than being queued by the swapchain
+        i64 presentMargin{DefaultPresentMargin}; //!< The estimated time prior to a refresh that a frame must be presented by to be displayed on it
+        i64 lastTargetPresentTime{}; //!< The CLOCK_MONOTONIC time of the refresh that the last paced frame targeted
+        u32 nextPresentId{1}; //!< The ID supplied to VK_GOOGLE_display_timing for the next paced frame, 0 is reserved for frames without an ID
+
+        static constexpr i64 FrameSkipWeight{8}; //!< The amount of frames that the GPU frame time is averaged over for frame skipping
+        static constexpr float FrameSkipEnableRatio{1.1f}; //!< The ratio of the GPU frame time to the frame budget of the guest above which frame skipping is enabled
+        static constexpr float FrameSkipThermalEnableRatio{1.0f}; //!< The enable ratio while the thermal policy is at its second level or above, frames are skipped as soon as they miss the budget as the host is likely to throttle further
+        static constexpr float FrameSkipDisableRatio{0.9f}; //!< The ratio of the GPU frame time to the frame budget below which frame skipping is disabled again when only presentation is skipped
+        static constexpr float FrameSkipRenderingDisableRatio{0.6f}; //!< The ratio below which frame skipping is disabled again when rendering is skipped too, this is lower as skipped rendering reduces the GPU time of dropped frames
+        static constexpr u32 FrameSkipHoldFrames{60}; //!< The amount of frames after frame skipping is enabled or disabled before it can be toggled again, this avoids oscillating between the two
+        std::atomic<bool> frameSkipping{}; //!< If every other frame is currently being dropped as the host GPU isn't keeping up with the guest
+        std::atomic<u32> frameSkipParity{}; //!< A counter of frames that rendering has been decided on, rendering is skipped for every other one while frame skipping
+        bool skipNextPresent{}; //!< If the next frame should be dropped while frame skipping without rendering being skipped
+        i64 averageGpuFrametimeNs{}; //!< The average GPU execution time of guest frames in nanoseconds
+        i64 frameSkipGpuTime{}; //!< The total GPU execution time as of the last guest frame in nanoseconds
+        u32 frameSkipHold{}; //!< The amount of frames till frame skipping may be toggled again
+        i64 lastFrameTime{}; //!< The CLOCK_MONOTONIC time at which the last frame was presented or dropped by frame skipping
+
+        /**
+         * @brief A frame that has been queued by the guest and is pending presentation on the present thread
+         */
+        struct PresentRequest {
+            std::shared_ptr<Texture> texture;
+            service::hosbinder::AndroidFence fence; //!< A fence which is signalled once the contents of the texture are valid
+            i64 timestamp;
+            u64 swapInterval;
+            service::hosbinder::AndroidRect crop;
+            service::hosbinder::NativeWindowScalingMode scalingMode;
+            service::hosbinder::NativeWindowTransform transform;
+            std::function<void()> releaseCallback; //!< A function called once the frame has been presented or dropped, the guest can reuse the texture after this
+            bool dropped{}; //!< If the frame has been superseded by a newer frame while the queue was full, it's released without being presented
+            i64 workDuration{}; //!< The CPU time the presenting guest thread spent on the frame in nanoseconds, this is 0 if it's unknown
+        };
+
+        static constexpr size_t PresentQueueDepth{2}; //!< The maximum amount of frames pending presentation, the oldest pending frame is dropped when a frame is queued beyond this
+        std::mutex presentMutex; //!< Synchronizes access to the present queue
+        std::condition_variable presentCondition; //!< Signalled when a frame is queued or when the present thread should stop
+        std::deque<PresentRequest> presentQueue; //!< All frames that have been queued but not yet presented or released, in the order they were queued
+        bool presentStop{}; //!< If the present thread should stop on the next wakeup, this is also set when it exits due to an exception
+        bool presentInFlight{}; //!< If the present thread has taken a frame from the queue and hasn't released it yet
+        std::condition_variable releaseCondition; //!< Signalled when the present thread has released a frame or has stopped
+        i32 guestThreadId{}; //!< The TID of the guest thread which last presented a frame, it's part of the ADPF session alongside the present and GPFIFO threads
+        i64 guestThreadCpuTime{}; //!< The CPU time of the guest thread as of its last present in nanoseconds
+        std::optional<ThermalPolicy> thermalPolicy; //!< The policy that rendering is degraded by as the host heats up, this is only created on the present thread when it's enabled as it's exclusively used by it
+        std::thread presentThread; //!< A thread which presents all queued frames, this avoids blocking the guest on acquiring swapchain images or on fences
+
         /**
          * @url https://developer.android.com/ndk/reference/group/choreographer#achoreographer_postframecallback64
          */
@@ -63,12 +125,66 @@ namespace skyline::gpu {
         void ChoreographerThread();
 
         /**
+         * @param preTransform The transform that frames are pre-rotated with prior to presentation, this must be supported by the surface
          * @note 'PresentationEngine::mutex' **must** be locked prior to calling this
          */
-        void UpdateSwapchain(texture::Format format, texture::Dimensions extent);
+        void UpdateSwapchain(texture::Format format, texture::Dimensions extent, vk::SurfaceTransformFlagBitsKHR preTransform);
+
+        /**
+         * @return The transform that the supplied frame should be pre-rotated with, this is the identity if the surface is in its native orientation or the frame can't be pre-rotated
+         * @note 'PresentationEngine::mutex' **must** be locked prior to calling this
+         */
+        vk::SurfaceTransformFlagBitsKHR GetPreTransform(const Texture &texture);
+
+        /**
+         * @brief Predicts the time of the refresh that a paced frame should be displayed on from the refresh cycle measured by the Choreographer
+         * @param timestamp The earliest CLOCK_MONOTONIC time at which the frame may be presented, 0 if there's no such restriction
+         * @return The CLOCK_MONOTONIC time of the targeted refresh
+         */
+        i64 PredictPresentTime(i64 timestamp, u64 swapInterval);
+
+        /**
+         * @brief Adjusts the present margin with the timings of past paced frames that VK_GOOGLE_display_timing has reported
+         * @note 'PresentationEngine::mutex' **must** be locked prior to calling this
+         */
+        void UpdatePresentMargin();
+
+        /**
+         * @brief The entry point for the present thread, it presents or releases queued frames in order till it's stopped
+         */
+        void PresentThread();
+
+        /**
+         * @brief Synchronizes the supplied texture with the guest and presents it to the screen, this blocks till the texture has been copied into a swapchain image and presented
+         * @note The texture **must** be locked prior to calling this
+         */
+        void PresentFrame(const std::shared_ptr<Texture> &texture, i64 timestamp, u64 swapInterval, service::hosbinder::AndroidRect crop, service::hosbinder::NativeWindowScalingMode scalingMode, service::hosbinder::NativeWindowTransform transform, u64 &frameId);
+
+        /**
+         * @return If the supplied frame should be dropped by frame skipping, this may be due to rendering into its texture having been skipped
+         * @note This must only be called once per frame after its fence has been signalled, rendering into it is guaranteed to have been recorded by then
+         */
+        bool IsFrameSkipped(const PresentRequest &request);
+
+        /**
+         * @brief Waits till the supplied frame would have been displayed had it not been dropped, this keeps the cadence of frames observed by the guest steady while skipping
+         */
+        void PaceSkippedFrame(u64 swapInterval);
+
+        /**
+         * @brief Enables or disables frame skipping based on the GPU execution time of the last frame relative to the frame budget of the guest
+         */
+        void UpdateFrameSkip(u64 swapInterval);
+
+        /**
+         * @brief Updates the shared performance counters after a frame has been presented
+         * @param now The timestamp at which the frame was presented, the core and GPU times are measured relative to the last frame
+         */
+        void UpdatePerformanceCounters(i64 now, u32 fps);
 
       public:
         std::shared_ptr<kernel::type::KEvent> vsyncEvent; //!< Signalled every time a frame is drawn
+        std::atomic<u64> queuedFrames{}; //!< The amount of frames the guest has queued for presentation, this is used to delimit guest frames
 
         PresentationEngine(const DeviceState &state, GPU &gpu);
 
@@ -80,20 +196,33 @@ namespace skyline::gpu {
         void UpdateSurface(jobject newSurface);
 
         /**
-         * @brief Queue the supplied texture to be presented to the screen
+         * @brief Queue the supplied texture to be presented to the screen by the present thread, this returns immediately
+         * @param fence A fence which is waited on by the present thread prior to presenting the texture
          * @param timestamp The earliest timestamp (relative to skyline::util::GetTickNs) at which the frame must be presented, it should be 0 when it doesn't matter
          * @param swapInterval The amount of display refreshes that must take place prior to presenting this image
          * @param crop A rectangle with bounds that the image will be cropped to
          * @param scalingMode The mode by which the image must be scaled up to the surface
          * @param transform A transformation that should be performed on the image
-         * @param frameId The ID of this frame for correlating it with presentation timing readouts
-         * @note The texture **must** be locked prior to calling this
+         * @param releaseCallback A function called from the present thread once the frame has been presented or dropped, it must not lock anything held by the calling thread during this call
+         * @note The texture **must not** be locked by the calling thread as it's locked by the present thread
+         */
+        void Present(const std::shared_ptr<Texture> &texture, const service::hosbinder::AndroidFence &fence, i64 timestamp, u64 swapInterval, service::hosbinder::AndroidRect crop, service::hosbinder::NativeWindowScalingMode scalingMode, service::hosbinder::NativeWindowTransform transform, std::function<void()> releaseCallback);
+
+        /**
+         * @brief Drops all frames pending presentation and waits till the present thread has released them and any frame it's presenting
+         * @note This must be called prior to destroying anything referenced by the release callbacks of queued frames, the calling thread must not hold anything they lock
          */
-        void Present(const std::shared_ptr<Texture> &texture, i64 timestamp, u64 swapInterval, service::hosbinder::AndroidRect crop, service::hosbinder::NativeWindowScalingMode scalingMode, service::hosbinder::NativeWindowTransform transform, u64 &frameId);
+        void ReleaseQueuedFrames();
 
         /**
          * @return A transform that the application should render with to elide costly transforms later
          */
         service::hosbinder::NativeWindowTransform GetTransformHint();
+
+        /**
+         * @return If rendering into presentable textures should be skipped for the frame being started, this is true for every other frame while frame skipping is active and rendering is skipped alongside presentation
+         * @note This should only be called once per frame, it's thread-safe as frames may be rendered by any GPU channel
+         */
+        bool SkipFrameRendering();
     };
 }
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "render_pass_cache.h"
+
+namespace skyline::gpu {
+    RenderPassCache::RenderPassKey::RenderPassKey(const vk::RenderPassCreateInfo &createInfo) : attachments(createInfo.pAttachments, createInfo.pAttachments + createInfo.attachmentCount), dependencies(createInfo.pDependencies, createInfo.pDependencies + createInfo.dependencyCount) {
+        subpasses.reserve(createInfo.subpassCount);
+        for (const auto &subpass : span<const vk::SubpassDescription>(createInfo.pSubpasses, createInfo.subpassCount)) {
+            subpasses.push_back(SubpassKey{
+                .inputAttachments = {subpass.pInputAttachments, subpass.pInputAttachments + subpass.inputAttachmentCount},
+                .colorAttachments = {subpass.pColorAttachments, subpass.pColorAttachments + subpass.colorAttachmentCount},
+                .depthStencilAttachment = subpass.pDepthStencilAttachment ? std::optional{*subpass.pDepthStencilAttachment} : std::nullopt,
+                .preserveAttachments = {subpass.pPreserveAttachments, subpass.pPreserveAttachments + subpass.preserveAttachmentCount},
+            });
+        }
+    }
+
+    namespace {
+        /**
+         * @brief Combines the hash of the raw contents of an array of Vulkan structures into the supplied hash
+         * @note This is only valid for structures without any padding or pointers
+         */
+        template<typename Type>
+        void HashCombine(size_t &hash, const Type *data, size_t count) {
+            auto value{std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(data), count * sizeof(Type)))};
+            hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        }
+
+        template<typename Type>
+        void HashCombine(size_t &hash, const std::vector<Type> &vector) {
+            HashCombine(hash, vector.data(), vector.size());
+        }
+    }
+
+    size_t RenderPassCache::RenderPassKeyHash::operator()(const RenderPassKey &key) const {
+        size_t hash{};
+        HashCombine(hash, key.attachments);
+        for (const auto &subpass : key.subpasses) {
+            HashCombine(hash, subpass.inputAttachments);
+            HashCombine(hash, subpass.colorAttachments);
+            if (subpass.depthStencilAttachment)
+                HashCombine(hash, &*subpass.depthStencilAttachment, 1);
+            HashCombine(hash, subpass.preserveAttachments);
+        }
+        HashCombine(hash, key.dependencies);
+        return hash;
+    }
+
+    RenderPassCache::RenderPassCache(GPU &gpu) : gpu(gpu) {}
+
+    vk::RenderPass RenderPassCache::GetRenderPass(const vk::RenderPassCreateInfo &createInfo) {
+        RenderPassKey key{createInfo};
+
+        std::scoped_lock lock(mutex);
+        auto it{renderPasses.find(key)};
+        if (it != renderPasses.end())
+            return *it->second;
+
+        TRACE_EVENT("gpu", "RenderPassCache::GetRenderPass::Create");
+        return *renderPasses.emplace(std::move(key), vk::raii::RenderPass(gpu.vkDevice, createInfo)).first->second;
+    }
+}
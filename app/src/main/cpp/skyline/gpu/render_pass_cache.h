@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vulkan/vulkan_raii.hpp>
+#include <common.h>
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A cache of Vulkan render passes keyed on the contents of their creation info, this avoids recreating identical render passes which is expensive on certain drivers
+     * @note This class is thread-safe and is shared between all command executors
+     * @note Render passes are retained for the lifetime of the cache as they hold no references to any other objects
+     */
+    class RenderPassCache {
+      private:
+        /**
+         * @brief All state of a single subpass in a render pass with any pointers resolved into owned storage
+         */
+        struct SubpassKey {
+            std::vector<vk::AttachmentReference> inputAttachments;
+            std::vector<vk::AttachmentReference> colorAttachments;
+            std::optional<vk::AttachmentReference> depthStencilAttachment;
+            std::vector<u32> preserveAttachments;
+
+            bool operator==(const SubpassKey &) const = default;
+        };
+
+        /**
+         * @brief All state used to create a render pass which includes the formats and load/store operations of attachments alongside the layout of all subpasses
+         */
+        struct RenderPassKey {
+            std::vector<vk::AttachmentDescription> attachments;
+            std::vector<SubpassKey> subpasses;
+            std::vector<vk::SubpassDependency> dependencies;
+
+            RenderPassKey(const vk::RenderPassCreateInfo &createInfo);
+
+            bool operator==(const RenderPassKey &) const = default;
+        };
+
+        struct RenderPassKeyHash {
+            size_t operator()(const RenderPassKey &key) const;
+        };
+
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to the cache
+        std::unordered_map<RenderPassKey, vk::raii::RenderPass, RenderPassKeyHash> renderPasses;
+
+      public:
+        RenderPassCache(GPU &gpu);
+
+        /**
+         * @return A render pass matching the supplied creation info, it'll be created if there's no matching render pass in the cache
+         * @note The returned render pass is valid for the lifetime of the cache
+         */
+        vk::RenderPass GetRenderPass(const vk::RenderPassCreateInfo &createInfo);
+    };
+}
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#include <gpu.h>
+#include <common/trace.h>
+#include <common/memory_accounting.h>
+#include "shader_cache.h"
+
+namespace skyline::gpu {
+    namespace {
+        /**
+         * @brief The fixed-size part of a serialized shader, it's followed by the constant buffers as pairs of slots and sizes and then the SPIR-V words
+         */
+        struct SerializedShader {
+            u64 key;
+            shader_compiler::ir::Stage stage;
+            u8 positionInput;
+            u8 positionOutput;
+            u8 _pad_;
+            u32 constantBufferCount;
+            u32 spirvSize; //!< The size of the SPIR-V in words
+            std::array<u8, 32> inputGenerics;
+            std::array<u8, 32> outputGenerics;
+            std::array<u8, 8> fragColors;
+        };
+
+        template<typename T>
+        void Write(std::vector<u8> &output, const T &value) {
+            auto bytes{reinterpret_cast<const u8 *>(&value)};
+            output.insert(output.end(), bytes, bytes + sizeof(T));
+        }
+
+        /**
+         * @brief A cursor over serialized data which throws on reads past the end of it
+         */
+        struct Reader {
+            span<const u8> data;
+            size_t offset{};
+
+            template<typename T>
+            T Read() {
+                if (offset + sizeof(T) > data.size())
+                    throw exception("Unexpected end of data at 0x{:X}", offset);
+
+                T value;
+                std::memcpy(&value, data.data() + offset, sizeof(T));
+                offset += sizeof(T);
+                return value;
+            }
+        };
+    }
+
+    ShaderCache::ShaderCache(GPU &gpu) : gpu(gpu) {}
+
+    ShaderCache::~ShaderCache() {
+        {
+            std::scoped_lock lock(mutex);
+            exit = true;
+        }
+        exitCondition.notify_all();
+
+        if (saveThread.joinable())
+            saveThread.join();
+
+        for (const auto &[key, shader] : shaders)
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::ShaderCache, shader->compiled.spirv.size() * sizeof(u32));
+    }
+
+    std::shared_ptr<ShaderCache::Shader> ShaderCache::CreateShader(shader_compiler::CompiledShader compiled) {
+        vk::raii::ShaderModule module(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = compiled.spirv.size() * sizeof(u32),
+            .pCode = compiled.spirv.data(),
+        });
+        return std::make_shared<Shader>(Shader{std::move(compiled), std::move(module)});
+    }
+
+    void ShaderCache::Load() {
+        TRACE_EVENT("gpu", "ShaderCache::Load");
+
+        auto data{directory->Load(filename, FileMagic, FileVersion)};
+        if (!data)
+            return;
+
+        size_t count{};
+        try {
+            Reader reader{*data};
+            while (reader.offset < data->size()) {
+                auto header{reader.Read<SerializedShader>()};
+
+                shader_compiler::CompiledShader compiled{
+                    .stage = header.stage,
+                    .info = {
+                        .inputGenerics = header.inputGenerics,
+                        .outputGenerics = header.outputGenerics,
+                        .positionInput = header.positionInput,
+                        .positionOutput = header.positionOutput,
+                        .fragColors = header.fragColors,
+                    },
+                };
+
+                for (u32 index{}; index < header.constantBufferCount; index++) {
+                    auto slot{reader.Read<u32>()};
+                    compiled.info.constantBuffers[slot] = reader.Read<u32>();
+                }
+
+                compiled.spirv.resize(header.spirvSize);
+                for (auto &word : compiled.spirv)
+                    word = reader.Read<u32>();
+
+                auto shader{CreateShader(std::move(compiled))};
+                std::scoped_lock lock(mutex);
+                if (exit)
+                    return;
+                auto spirvSize{shader->compiled.spirv.size() * sizeof(u32)};
+                if (shaders.try_emplace(header.key, std::move(shader)).second)
+                    perf::SharedMemoryAccounting.Add(perf::MemoryCategory::ShaderCache, spirvSize);
+                count++;
+            }
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to load the shader cache after {} shaders: {}", count, e.what());
+        }
+
+        Logger::Info("Loaded {} shaders from '{}'", count, filename);
+    }
+
+    void ShaderCache::Save() {
+        if (!directory || !dirty)
+            return;
+
+        TRACE_EVENT("gpu", "ShaderCache::Save");
+
+        std::vector<u8> data;
+        for (const auto &[key, shader] : shaders) {
+            const auto &compiled{shader->compiled};
+            const auto &info{compiled.info};
+            Write(data, SerializedShader{
+                .key = key,
+                .stage = compiled.stage,
+                .positionInput = info.positionInput,
+                .positionOutput = info.positionOutput,
+                .constantBufferCount = static_cast<u32>(info.constantBuffers.size()),
+                .spirvSize = static_cast<u32>(compiled.spirv.size()),
+                .inputGenerics = info.inputGenerics,
+                .outputGenerics = info.outputGenerics,
+                .fragColors = info.fragColors,
+            });
+
+            for (auto [slot, size] : info.constantBuffers) {
+                Write(data, slot);
+                Write(data, size);
+            }
+
+            auto spirv{span<const u32>(compiled.spirv).cast<const u8>()};
+            data.insert(data.end(), spirv.begin(), spirv.end());
+        }
+
+        directory->Store(filename, FileMagic, FileVersion, data);
+        dirty = false;
+    }
+
+    void ShaderCache::SaveThread() {
+        pthread_setname_np(pthread_self(), "GPU-ShaderCache");
+
+        Load();
+
+        std::unique_lock lock(mutex);
+        while (!exitCondition.wait_for(lock, SaveInterval, [this]() { return exit; }))
+            Save();
+        Save();
+    }
+
+    void ShaderCache::Open(const std::string &path, u64 titleId) {
+        std::scoped_lock lock(mutex);
+        if (directory)
+            throw exception("The shader cache cannot be opened more than once");
+
+        filename = util::Format("{}_shaders.bin", vfs::CacheDirectory::GetTitleKey(titleId));
+
+        try {
+            directory = std::make_shared<vfs::CacheDirectory>(path);
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to open the shader cache: {}", e.what());
+            return;
+        }
+
+        saveThread = std::thread(&ShaderCache::SaveThread, this);
+    }
+
+    std::shared_ptr<ShaderCache::Shader> ShaderCache::GetShader(span<const u8> binary, u64 specialisation) {
+        u64 key{XXH64(binary.data(), binary.size(), specialisation)};
+        {
+            std::scoped_lock lock(mutex);
+            if (auto it{shaders.find(key)}; it != shaders.end())
+                return it->second;
+        }
+
+        // Translation is performed without holding the lock as it's expensive, if another thread inserted the same shader in the meantime then that one is used
+        auto shader{CreateShader(shader_compiler::CompileShader(binary))};
+
+        std::scoped_lock lock(mutex);
+        auto [it, inserted]{shaders.try_emplace(key, std::move(shader))};
+        if (inserted)
+            perf::SharedMemoryAccounting.Add(perf::MemoryCategory::ShaderCache, it->second->compiled.spirv.size() * sizeof(u32));
+        dirty |= inserted;
+        return it->second;
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <vfs/cache_directory.h>
+#include <gpu/shader_compiler/compiler.h>
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A cache of translated guest shaders which is persisted to disk per-title, this avoids translating the same shaders again on every boot
+     * @note Shaders are keyed by a hash of the guest binary seeded with a hash of any state the translation was specialised on
+     * @note The file is loaded on a dedicated thread which also creates shader modules for all loaded shaders ahead of use, it's then written back by the same thread periodically and on destruction
+     */
+    class ShaderCache {
+      public:
+        /**
+         * @brief A translated shader alongside its host shader module
+         */
+        struct Shader {
+            shader_compiler::CompiledShader compiled;
+            vk::raii::ShaderModule module;
+        };
+
+      private:
+        static constexpr u32 FileMagic{util::MakeMagic<u32>("SKSC")}; //!< "SKSC" - Skyline Shader Cache
+        static constexpr u32 FileVersion{1}; //!< This must be incremented whenever the output of the shader compiler changes as stale translations would be loaded otherwise
+        static constexpr std::chrono::seconds SaveInterval{30}; //!< The interval at which the cache is written back to disk
+
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes all access to the shaders, the file and the exit flag
+        std::condition_variable exitCondition;
+        bool exit{};
+        bool dirty{}; //!< If shaders have been translated since the last write
+        std::unordered_map<u64, std::shared_ptr<Shader>> shaders;
+        std::shared_ptr<vfs::CacheDirectory> directory; //!< The directory holding the cache files, this is null till the cache is opened
+        std::string filename; //!< The name of the file for the current title
+        std::thread saveThread;
+
+        std::shared_ptr<Shader> CreateShader(shader_compiler::CompiledShader compiled);
+
+        /**
+         * @brief Loads all shaders in the file and creates their shader modules, shaders which have been translated in the meantime are retained
+         */
+        void Load();
+
+        /**
+         * @brief Writes the cache back to disk if any shaders have been translated since the last write
+         * @note The mutex must be locked
+         */
+        void Save();
+
+        void SaveThread();
+
+      public:
+        ShaderCache(GPU &gpu);
+
+        ~ShaderCache();
+
+        /**
+         * @brief Loads the cache for the supplied title from the directory in the background and starts writing back to it periodically
+         * @note Shaders may be translated prior to this, they'll be written back to the file alongside any loaded shaders
+         */
+        void Open(const std::string &path, u64 titleId);
+
+        /**
+         * @param binary The guest program starting with its SPH, this should be bounded consistently by the caller as the entire span is hashed
+         * @param specialisation A hash of any state which affected the translation, it's 0 for unspecialised shaders
+         * @return The shader for the supplied binary, it's translated and inserted into the cache if it isn't in it yet
+         */
+        std::shared_ptr<Shader> GetShader(span<const u8> binary, u64 specialisation = 0);
+    };
+}
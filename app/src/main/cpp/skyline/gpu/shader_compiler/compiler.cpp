@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "maxwell_decoder.h"
+#include "passes.h"
+#include "spirv_emitter.h"
+#include "compiler.h"
+
+namespace skyline::gpu::shader_compiler {
+    CompiledShader CompileShader(span<const u8> binary) {
+        TRACE_EVENT("gpu", "shader_compiler::CompileShader");
+
+        auto program{DecodeMaxwell(binary)};
+        pass::Optimize(program);
+        return CompiledShader{
+            .stage = program.stage,
+            .info = program.info,
+            .spirv = EmitSpirv(program),
+        };
+    }
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "ir.h"
+
+namespace skyline::gpu::shader_compiler {
+    /**
+     * @brief A guest program translated into a host shader alongside the metadata required to create a pipeline with it
+     */
+    struct CompiledShader {
+        ir::Stage stage;
+        ir::ProgramInfo info;
+        std::vector<u32> spirv;
+    };
+
+    /**
+     * @brief Translates a Maxwell program into SPIR-V by decoding it into the IR, optimising it and emitting the result
+     * @note The stages are exposed separately in their own headers, this allows them to be extended with caching, specialisation or driver workarounds on the IR
+     */
+    CompiledShader CompileShader(span<const u8> binary);
+}
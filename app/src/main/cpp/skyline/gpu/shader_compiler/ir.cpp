@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unordered_map>
+#include "ir.h"
+
+namespace skyline::gpu::shader_compiler::ir {
+    Type GetResultType(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::SetAttribute:
+            case Opcode::SetFragColor:
+                return Type::Void;
+
+            case Opcode::ImmU32:
+            case Opcode::GetConstant:
+            case Opcode::BitCastU32:
+            case Opcode::IAdd:
+            case Opcode::INeg:
+                return Type::U32;
+
+            case Opcode::ImmF32:
+            case Opcode::GetAttribute:
+            case Opcode::BitCastF32:
+            case Opcode::FAdd:
+            case Opcode::FMul:
+            case Opcode::FFma:
+            case Opcode::FNeg:
+            case Opcode::FAbs:
+            case Opcode::FSaturate:
+                return Type::F32;
+
+            case Opcode::Identity:
+                throw exception("The type of an identity depends on its argument");
+        }
+        throw exception("Unknown IR opcode: {}", static_cast<u32>(opcode));
+    }
+
+    bool HasSideEffects(Opcode opcode) {
+        return opcode == Opcode::SetAttribute || opcode == Opcode::SetFragColor;
+    }
+
+    Inst::Inst(Opcode opcode, std::initializer_list<Inst *> arguments, u32 immediate, u32 index) : opcode(opcode), immediate(immediate), index(index) {
+        if (arguments.size() > MaxArgs)
+            throw exception("IR instructions can't have more than {} arguments", MaxArgs);
+
+        size_t argIndex{};
+        for (auto argument : arguments)
+            SetArg(argIndex++, argument);
+    }
+
+    void Inst::SetArg(size_t argIndex, Inst *value) {
+        auto &arg{args[argIndex]};
+        if (arg)
+            arg->uses--;
+        arg = value;
+        if (arg)
+            arg->uses++;
+    }
+
+    void Inst::ClearArgs() {
+        for (size_t argIndex{}; argIndex < MaxArgs; argIndex++)
+            SetArg(argIndex, nullptr);
+    }
+
+    void Inst::ReplaceWith(Inst *value) {
+        Inst *forwarded{value}; // The value is retained prior to clearing the arguments as it may be one of them
+        forwarded->uses++;
+        ClearArgs();
+        opcode = Opcode::Identity;
+        args[0] = forwarded;
+    }
+
+    void Inst::ReplaceWithImmediate(Type type, u32 value) {
+        ClearArgs();
+        opcode = type == Type::F32 ? Opcode::ImmF32 : Opcode::ImmU32;
+        immediate = value;
+        index = 0;
+    }
+
+    void Inst::ResolveArgs() {
+        for (size_t argIndex{}; argIndex < MaxArgs; argIndex++) {
+            Inst *arg{args[argIndex]};
+            if (!arg || arg->opcode != Opcode::Identity)
+                continue;
+
+            while (arg->opcode == Opcode::Identity)
+                arg = arg->args[0];
+            SetArg(argIndex, arg);
+        }
+    }
+
+    u32 ProgramInfo::GetConstantBufferBinding(u32 slot) const {
+        auto it{constantBuffers.find(slot)};
+        if (it == constantBuffers.end())
+            throw exception("Constant buffer {} isn't used by the program", slot);
+        return static_cast<u32>(std::distance(constantBuffers.begin(), it));
+    }
+
+    Inst *Program::AsF32(Inst *value) {
+        if (value->GetType() == Type::F32)
+            return value;
+        return Emit(Opcode::BitCastF32, {value});
+    }
+
+    Inst *Program::AsU32(Inst *value) {
+        if (value->GetType() == Type::U32)
+            return value;
+        return Emit(Opcode::BitCastU32, {value});
+    }
+
+    static const char *GetOpcodeName(Opcode opcode) {
+        #define OPCODE(name) case Opcode::name: return #name
+        switch (opcode) {
+            OPCODE(Identity);
+            OPCODE(ImmU32);
+            OPCODE(ImmF32);
+            OPCODE(GetConstant);
+            OPCODE(GetAttribute);
+            OPCODE(SetAttribute);
+            OPCODE(SetFragColor);
+            OPCODE(BitCastF32);
+            OPCODE(BitCastU32);
+            OPCODE(FAdd);
+            OPCODE(FMul);
+            OPCODE(FFma);
+            OPCODE(FNeg);
+            OPCODE(FAbs);
+            OPCODE(FSaturate);
+            OPCODE(IAdd);
+            OPCODE(INeg);
+        }
+        #undef OPCODE
+        return "Unknown";
+    }
+
+    std::string Dump(const Program &program) {
+        std::unordered_map<const Inst *, size_t> names;
+        std::string output;
+        for (const auto &inst : program.insts) {
+            size_t name{names.size()};
+            names.emplace(&inst, name);
+
+            output += util::Format("%{} = {}", name, GetOpcodeName(inst.opcode));
+            for (auto arg : inst.args)
+                if (arg)
+                    output += util::Format(" %{}", names.at(arg));
+            if (inst.IsImmediate() || inst.opcode == Opcode::GetConstant || inst.opcode == Opcode::GetAttribute || inst.opcode == Opcode::SetAttribute || inst.opcode == Opcode::SetFragColor)
+                output += util::Format(" [imm: 0x{:X}, index: {}]", inst.immediate, inst.index);
+            output += '\n';
+        }
+        return output;
+    }
+}
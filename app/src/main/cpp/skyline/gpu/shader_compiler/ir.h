@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <common.h>
+
+namespace skyline::gpu::shader_compiler::ir {
+    /**
+     * @brief The type of the value produced by an instruction, Maxwell registers are untyped so the decoder inserts bitcasts between these
+     */
+    enum class Type : u8 {
+        Void, //!< The instruction doesn't produce a value and is only executed for its side effects
+        U32,
+        F32,
+    };
+
+    enum class Opcode : u8 {
+        Identity, //!< Forwards the first argument, this is left behind by passes replacing an instruction and is removed by dead code elimination
+        ImmU32, //!< A 32-bit integer constant held in the immediate
+        ImmF32, //!< A 32-bit float constant with the bits held in the immediate
+        GetConstant, //!< Reads a word from a constant buffer, the immediate is the offset in bytes and the index is the slot
+        GetAttribute, //!< Reads a component of an input attribute, the immediate is the Maxwell attribute address of the component
+        SetAttribute, //!< Writes a float argument to a component of an output attribute, the immediate is the Maxwell attribute address of the component
+        SetFragColor, //!< Writes a float argument to a component of a fragment color output, the index is the render target and the immediate is the component
+        BitCastF32, //!< Reinterprets a U32 as a F32
+        BitCastU32, //!< Reinterprets a F32 as a U32
+        FAdd,
+        FMul,
+        FFma,
+        FNeg,
+        FAbs,
+        FSaturate, //!< Clamps a float to [0, 1]
+        IAdd,
+        INeg,
+    };
+
+    /**
+     * @return The type of the value produced by an instruction with the supplied opcode
+     */
+    Type GetResultType(Opcode opcode);
+
+    /**
+     * @return If an instruction with the supplied opcode has an effect beyond its result, these must never be eliminated
+     */
+    bool HasSideEffects(Opcode opcode);
+
+    /**
+     * @brief A single SSA instruction, every instruction defines at most one value which is consumed by referencing the instruction itself
+     */
+    struct Inst {
+        static constexpr size_t MaxArgs{3};
+
+        Opcode opcode;
+        std::array<Inst *, MaxArgs> args{};
+        u32 immediate{}; //!< An opcode-specific immediate operand, see the documentation of the opcode
+        u32 index{}; //!< An opcode-specific index operand, see the documentation of the opcode
+        u32 uses{}; //!< The amount of arguments of other instructions which refer to this one
+
+        Inst(Opcode opcode, std::initializer_list<Inst *> arguments, u32 immediate, u32 index);
+
+        Type GetType() const {
+            return GetResultType(opcode);
+        }
+
+        bool IsImmediate() const {
+            return opcode == Opcode::ImmU32 || opcode == Opcode::ImmF32;
+        }
+
+        float GetF32() const {
+            return util::BitCast<float>(immediate);
+        }
+
+        /**
+         * @brief Replaces an argument of the instruction while keeping the use counts of both values up to date
+         */
+        void SetArg(size_t index, Inst *value);
+
+        /**
+         * @brief Drops all arguments of the instruction, this is required prior to removing or repurposing it
+         */
+        void ClearArgs();
+
+        /**
+         * @brief Turns the instruction into an identity of the supplied value, all references to it are redirected by ResolveArgs
+         */
+        void ReplaceWith(Inst *value);
+
+        /**
+         * @brief Turns the instruction into a constant while dropping its arguments
+         */
+        void ReplaceWithImmediate(Type type, u32 value);
+
+        /**
+         * @brief Redirects any argument that refers to an identity to the value forwarded by it
+         */
+        void ResolveArgs();
+    };
+
+    enum class Stage : u8 {
+        Vertex,
+        Fragment,
+    };
+
+    /**
+     * @brief A component of an attribute decomposed from its Maxwell attribute address
+     */
+    struct AttributeComponent {
+        static constexpr u32 PositionBase{0x70}; //!< The address of the first component of the position
+        static constexpr u32 GenericBase{0x80}; //!< The address of the first component of generic attribute 0, each generic attribute is 0x10 bytes
+        static constexpr u32 GenericEnd{0x280};
+
+        bool isPosition; //!< If this is a component of the position rather than of a generic attribute
+        u32 index; //!< The index of the generic attribute, this is 0 for the position
+        u32 component;
+
+        constexpr AttributeComponent(u32 address) : isPosition(address < GenericBase), index(isPosition ? 0 : (address - GenericBase) / 0x10), component((address / sizeof(u32)) % 4) {}
+    };
+
+    /**
+     * @brief Metadata about the resources and interface of a program, this is filled in by analysis passes and consumed by the backend and pipeline creation
+     */
+    struct ProgramInfo {
+        std::map<u32, u32> constantBuffers; //!< A map from the slot of each constant buffer the program reads to the size in bytes that it requires to be bound
+        std::array<u8, 32> inputGenerics{}; //!< A mask of the components of each generic input attribute that are read
+        std::array<u8, 32> outputGenerics{}; //!< A mask of the components of each generic output attribute that are written
+        u8 positionInput{}; //!< A mask of the components of the position (FragCoord in fragment programs) that are read
+        u8 positionOutput{}; //!< A mask of the components of the position that are written
+        std::array<u8, 8> fragColors{}; //!< A mask of the components of each render target that are written
+
+        /**
+         * @return The binding of the constant buffer in the supplied slot, bindings are assigned densely in the order of the slots
+         */
+        u32 GetConstantBufferBinding(u32 slot) const;
+    };
+
+    /**
+     * @brief A program in the IR, it's a single block of instructions in execution order as control flow isn't decoded yet
+     * @note Instructions are stored in a list so they can be removed or inserted by passes without invalidating references to them
+     */
+    struct Program {
+        Stage stage;
+        std::list<Inst> insts;
+        ProgramInfo info;
+
+        Inst *Emit(Opcode opcode, std::initializer_list<Inst *> args = {}, u32 immediate = 0, u32 index = 0) {
+            return &insts.emplace_back(opcode, args, immediate, index);
+        }
+
+        Inst *ImmU32(u32 value) {
+            return Emit(Opcode::ImmU32, {}, value);
+        }
+
+        Inst *ImmF32(float value) {
+            return Emit(Opcode::ImmF32, {}, util::BitCast<u32>(value));
+        }
+
+        /**
+         * @return The supplied value as a F32, a bitcast is inserted if it's of another type
+         */
+        Inst *AsF32(Inst *value);
+
+        /**
+         * @return The supplied value as a U32, a bitcast is inserted if it's of another type
+         */
+        Inst *AsU32(Inst *value);
+    };
+
+    /**
+     * @brief Dumps the program in a human readable form for debugging translation issues
+     */
+    std::string Dump(const Program &program);
+}
@@ -0,0 +1,529 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <bit>
+#include "maxwell_decoder.h"
+
+namespace skyline::gpu::shader_compiler {
+    namespace {
+        enum class MaxwellOpcode {
+            MOV_reg,
+            MOV_cbuf,
+            MOV_imm,
+            MOV32I,
+            FADD_reg,
+            FADD_cbuf,
+            FADD_imm,
+            FADD32I,
+            FMUL_reg,
+            FMUL_cbuf,
+            FMUL_imm,
+            FMUL32I,
+            FFMA_reg,
+            FFMA_rc,
+            FFMA_cr,
+            FFMA_imm,
+            FFMA32I,
+            IADD_reg,
+            IADD_cbuf,
+            IADD_imm,
+            IADD32I,
+            IPA,
+            ALD,
+            AST,
+            LDC,
+            EXIT,
+            NOP,
+        };
+
+        /**
+         * @brief An encoding of an instruction in the form of the fixed bits in the top 16 bits of it
+         */
+        struct Encoding {
+            u16 mask;
+            u16 expected;
+            MaxwellOpcode opcode;
+            const char *name;
+
+            /**
+             * @param pattern A string of 16 characters from the MSB downwards where '0' and '1' are fixed bits and '-' is a variable bit, spaces are ignored
+             */
+            constexpr Encoding(std::string_view pattern, MaxwellOpcode opcode, const char *name) : mask(), expected(), opcode(opcode), name(name) {
+                for (char character : pattern) {
+                    if (character == ' ')
+                        continue;
+                    mask <<= 1;
+                    expected <<= 1;
+                    if (character != '-') {
+                        mask |= 1;
+                        expected |= character == '1' ? 1 : 0;
+                    }
+                }
+            }
+        };
+
+        #define ENCODING(name, pattern) Encoding{pattern, MaxwellOpcode::name, #name}
+        constexpr std::array Encodings{
+            ENCODING(MOV_reg, "0101 1100 1001 1---"),
+            ENCODING(MOV_cbuf, "0100 1100 1001 1---"),
+            ENCODING(MOV_imm, "0011 100- 1001 1---"),
+            ENCODING(MOV32I, "0000 0001 0000 ----"),
+            ENCODING(FADD_reg, "0101 1100 0101 1---"),
+            ENCODING(FADD_cbuf, "0100 1100 0101 1---"),
+            ENCODING(FADD_imm, "0011 100- 0101 1---"),
+            ENCODING(FADD32I, "0000 10-- ---- ----"),
+            ENCODING(FMUL_reg, "0101 1100 0110 1---"),
+            ENCODING(FMUL_cbuf, "0100 1100 0110 1---"),
+            ENCODING(FMUL_imm, "0011 100- 0110 1---"),
+            ENCODING(FMUL32I, "0001 1110 ---- ----"),
+            ENCODING(FFMA_reg, "0101 1001 1--- ----"),
+            ENCODING(FFMA_rc, "0101 0001 1--- ----"),
+            ENCODING(FFMA_cr, "0100 1001 1--- ----"),
+            ENCODING(FFMA_imm, "0011 001- 1--- ----"),
+            ENCODING(FFMA32I, "0000 11-- ---- ----"),
+            ENCODING(IADD_reg, "0101 1100 0001 0---"),
+            ENCODING(IADD_cbuf, "0100 1100 0001 0---"),
+            ENCODING(IADD_imm, "0011 100- 0001 0---"),
+            ENCODING(IADD32I, "0001 110- ---- ----"),
+            ENCODING(IPA, "1110 0000 ---- ----"),
+            ENCODING(ALD, "1110 1111 1101 1---"),
+            ENCODING(AST, "1110 1111 1111 0---"),
+            ENCODING(LDC, "1110 1111 1001 0---"),
+            ENCODING(EXIT, "1110 0011 0000 ----"),
+            ENCODING(NOP, "0101 0000 1011 0---"),
+        };
+        #undef ENCODING
+
+        /**
+         * @return The most specific encoding that matches the instruction, this is the one with the most fixed bits
+         */
+        const Encoding &FindEncoding(u64 instruction) {
+            u16 top{static_cast<u16>(instruction >> 48)};
+            const Encoding *match{};
+            for (const auto &encoding : Encodings)
+                if ((top & encoding.mask) == encoding.expected && (!match || std::popcount(encoding.mask) > std::popcount(match->mask)))
+                    match = &encoding;
+
+            if (!match)
+                throw exception("Unknown Maxwell instruction: 0x{:016X}", instruction);
+            return *match;
+        }
+
+        /**
+         * @brief A wrapper over a raw instruction for extracting its fields
+         */
+        struct Instruction {
+            u64 raw;
+
+            constexpr u64 Bits(size_t offset, size_t size) const {
+                return (raw >> offset) & ((1ULL << size) - 1);
+            }
+
+            constexpr bool Bit(size_t offset) const {
+                return (raw >> offset) & 1;
+            }
+
+            constexpr u8 Register(size_t offset) const {
+                return static_cast<u8>(Bits(offset, 8));
+            }
+
+            constexpr u8 Dest() const {
+                return Register(0);
+            }
+
+            constexpr u8 SrcA() const {
+                return Register(8);
+            }
+
+            constexpr u8 SrcB() const {
+                return Register(20);
+            }
+
+            constexpr u8 SrcC() const {
+                return Register(39);
+            }
+
+            /**
+             * @return The 20-bit signed integer immediate of the immediate forms of instructions, the sign is held separately in bit 56
+             */
+            constexpr u32 Imm20Int() const {
+                u32 value{static_cast<u32>(Bits(20, 19) | (Bits(56, 1) << 19))};
+                return Bit(56) ? (value | 0xFFF00000) : value;
+            }
+
+            /**
+             * @return The 20-bit float immediate of the immediate forms of instructions, these are the top bits of a 32-bit float
+             */
+            constexpr u32 Imm20Float() const {
+                return static_cast<u32>(Bits(20, 19) | (Bits(56, 1) << 19)) << 12;
+            }
+
+            constexpr u32 Imm32() const {
+                return static_cast<u32>(Bits(20, 32));
+            }
+
+            constexpr u32 CbufIndex() const {
+                return static_cast<u32>(Bits(34, 5));
+            }
+
+            constexpr u32 CbufOffset() const {
+                return static_cast<u32>(Bits(20, 14)) * sizeof(u32);
+            }
+        };
+
+        /**
+         * @brief Per-program state for decoding instructions into the IR
+         */
+        class Decoder {
+          private:
+            static constexpr u8 ZeroRegister{0xFF}; //!< RZ, this always reads as zero and discards writes
+            static constexpr u8 TruePredicate{7}; //!< PT, this always evaluates to true
+
+            ir::Program &program;
+            span<const u32> header; //!< The SPH of the program
+            std::array<ir::Inst *, ZeroRegister> registers{}; //!< The latest SSA value of every GPR, registers that haven't been written yet are lazily initialised to zero
+
+            ir::Inst *GetRegister(u8 reg) {
+                if (reg == ZeroRegister)
+                    return program.ImmU32(0);
+
+                auto &value{registers[reg]};
+                if (!value)
+                    value = program.ImmU32(0);
+                return value;
+            }
+
+            void SetRegister(u8 reg, ir::Inst *value) {
+                if (reg != ZeroRegister)
+                    registers[reg] = value;
+            }
+
+            ir::Inst *GetF32(u8 reg) {
+                return program.AsF32(GetRegister(reg));
+            }
+
+            ir::Inst *GetConstant(u32 index, u32 offset) {
+                return program.Emit(ir::Opcode::GetConstant, {}, offset, index);
+            }
+
+            ir::Inst *ApplyFloatModifiers(ir::Inst *value, bool abs, bool neg) {
+                if (abs)
+                    value = program.Emit(ir::Opcode::FAbs, {value});
+                if (neg)
+                    value = program.Emit(ir::Opcode::FNeg, {value});
+                return value;
+            }
+
+            ir::Inst *ApplySaturate(ir::Inst *value, bool saturate) {
+                return saturate ? program.Emit(ir::Opcode::FSaturate, {value}) : value;
+            }
+
+            /**
+             * @return The second operand of an instruction with register, constant buffer and immediate forms
+             */
+            ir::Inst *GetOperandB(Instruction inst, MaxwellOpcode opcode, bool isFloat) {
+                switch (opcode) {
+                    case MaxwellOpcode::MOV_reg:
+                    case MaxwellOpcode::FADD_reg:
+                    case MaxwellOpcode::FMUL_reg:
+                    case MaxwellOpcode::FFMA_reg:
+                    case MaxwellOpcode::IADD_reg:
+                        return GetRegister(inst.SrcB());
+
+                    case MaxwellOpcode::MOV_cbuf:
+                    case MaxwellOpcode::FADD_cbuf:
+                    case MaxwellOpcode::FMUL_cbuf:
+                    case MaxwellOpcode::FFMA_cr:
+                    case MaxwellOpcode::IADD_cbuf:
+                        return GetConstant(inst.CbufIndex(), inst.CbufOffset());
+
+                    case MaxwellOpcode::FFMA_rc:
+                        return GetRegister(inst.SrcC());
+
+                    case MaxwellOpcode::MOV_imm:
+                    case MaxwellOpcode::FADD_imm:
+                    case MaxwellOpcode::FMUL_imm:
+                    case MaxwellOpcode::FFMA_imm:
+                    case MaxwellOpcode::IADD_imm:
+                        return isFloat ? program.Emit(ir::Opcode::ImmF32, {}, inst.Imm20Float()) : program.ImmU32(inst.Imm20Int());
+
+                    default:
+                        throw exception("Instruction doesn't have a second operand");
+                }
+            }
+
+            /**
+             * @brief Throws if the attribute at the supplied address isn't supported, only the position and generic attributes which directly follow it are
+             */
+            static void ValidateAttribute(u32 address) {
+                if (address % sizeof(u32) || address < ir::AttributeComponent::PositionBase || address >= ir::AttributeComponent::GenericEnd)
+                    throw exception("Unsupported attribute address: 0x{:X}", address);
+            }
+
+            void DecodeAttributeLoad(Instruction inst) {
+                if (inst.SrcA() != ZeroRegister)
+                    throw exception("Indexed attribute loads aren't supported");
+                if (inst.Bit(32) || inst.Bit(31))
+                    throw exception("Loads from outputs or patch attributes aren't supported");
+
+                u32 base{static_cast<u32>(inst.Bits(20, 10))};
+                u32 count{static_cast<u32>(inst.Bits(47, 2)) + 1};
+                for (u32 element{}; element < count; element++) {
+                    u32 address{base + element * static_cast<u32>(sizeof(u32))};
+                    ValidateAttribute(address);
+                    SetRegister(inst.Dest() + element, program.Emit(ir::Opcode::GetAttribute, {}, address));
+                }
+            }
+
+            void DecodeAttributeStore(Instruction inst) {
+                if (inst.SrcA() != ZeroRegister)
+                    throw exception("Indexed attribute stores aren't supported");
+                if (inst.Bit(31))
+                    throw exception("Stores to patch attributes aren't supported");
+                if (program.stage != ir::Stage::Vertex)
+                    throw exception("Attribute stores are only supported in vertex programs");
+
+                u32 base{static_cast<u32>(inst.Bits(20, 10))};
+                u32 count{static_cast<u32>(inst.Bits(47, 2)) + 1};
+                for (u32 element{}; element < count; element++) {
+                    u32 address{base + element * static_cast<u32>(sizeof(u32))};
+                    ValidateAttribute(address);
+                    program.Emit(ir::Opcode::SetAttribute, {GetF32(static_cast<u8>(inst.Dest() + element))}, address);
+                }
+            }
+
+            void DecodeInterpolate(Instruction inst) {
+                if (program.stage != ir::Stage::Fragment)
+                    throw exception("IPA is only supported in fragment programs");
+                if (inst.Bit(38))
+                    throw exception("Indexed attribute interpolation isn't supported");
+
+                u32 address{static_cast<u32>(inst.Bits(28, 10))};
+                ValidateAttribute(address);
+
+                // Perspective correction is performed by the host during interpolation, IPA.MULTIPLY by the reciprocal of W is redundant and treated like IPA.PASS
+                // Flat (IPA.CONSTANT) interpolation isn't decorated yet and is interpolated like any other attribute
+                auto value{program.Emit(ir::Opcode::GetAttribute, {}, address)};
+                SetRegister(inst.Dest(), ApplySaturate(value, inst.Bit(51)));
+            }
+
+            void DecodeLoadConstant(Instruction inst) {
+                constexpr u32 SizeB32{4}, SizeB64{5};
+                u32 size{static_cast<u32>(inst.Bits(48, 3))};
+                if (inst.SrcA() != ZeroRegister || inst.Bits(44, 2))
+                    throw exception("Indexed constant buffer loads aren't supported");
+                if (size != SizeB32 && size != SizeB64)
+                    throw exception("Unsupported LDC size: {}", size);
+
+                auto offset{static_cast<i16>(inst.Bits(20, 16))};
+                if (offset < 0 || offset % sizeof(u32))
+                    throw exception("Unsupported LDC offset: {}", offset);
+
+                u32 index{static_cast<u32>(inst.Bits(36, 5))};
+                SetRegister(inst.Dest(), GetConstant(index, static_cast<u32>(offset)));
+                if (size == SizeB64)
+                    SetRegister(inst.Dest() + 1, GetConstant(index, static_cast<u32>(offset) + sizeof(u32)));
+            }
+
+            /**
+             * @brief Emits the implicit writes of the final register values to the outputs of the program
+             */
+            void DecodeExit() {
+                if (program.stage != ir::Stage::Fragment)
+                    return;
+
+                constexpr size_t OmapTargetWord{18}, OmapFlagsWord{19};
+                constexpr u32 OmapDepthBit{1U << 1};
+
+                // Fragment outputs are read from consecutive registers starting at R0 for every enabled component of every render target
+                u32 targetMask{header[OmapTargetWord]};
+                u8 reg{};
+                for (u32 target{}; target < program.info.fragColors.size(); target++) {
+                    for (u32 component{}; component < 4; component++) {
+                        if (!(targetMask & (1U << (target * 4 + component))))
+                            continue;
+                        program.Emit(ir::Opcode::SetFragColor, {GetF32(reg++)}, component, target);
+                    }
+                }
+
+                if (header[OmapFlagsWord] & OmapDepthBit)
+                    Logger::Warn("Fragment depth output isn't supported, it's ignored");
+            }
+
+          public:
+            Decoder(ir::Program &program, span<const u32> header) : program(program), header(header) {}
+
+            /**
+             * @return If decoding should continue after the instruction
+             */
+            bool Decode(u64 raw) {
+                Instruction inst{raw};
+                const auto &encoding{FindEncoding(raw)};
+
+                if (inst.Bits(16, 3) != TruePredicate || inst.Bit(19))
+                    throw exception("Predicated instructions aren't supported: {}", encoding.name);
+
+                switch (auto opcode{encoding.opcode}) {
+                    case MaxwellOpcode::NOP:
+                        break;
+
+                    case MaxwellOpcode::EXIT: {
+                        constexpr u64 ConditionTrue{0xF};
+                        if (inst.Bits(0, 5) != ConditionTrue)
+                            throw exception("Conditional EXIT isn't supported");
+                        DecodeExit();
+                        return false;
+                    }
+
+                    case MaxwellOpcode::MOV_reg:
+                    case MaxwellOpcode::MOV_cbuf:
+                    case MaxwellOpcode::MOV_imm:
+                        SetRegister(inst.Dest(), GetOperandB(inst, opcode, false));
+                        break;
+
+                    case MaxwellOpcode::MOV32I:
+                        SetRegister(inst.Dest(), program.ImmU32(inst.Imm32()));
+                        break;
+
+                    case MaxwellOpcode::FADD_reg:
+                    case MaxwellOpcode::FADD_cbuf:
+                    case MaxwellOpcode::FADD_imm: {
+                        auto a{ApplyFloatModifiers(GetF32(inst.SrcA()), inst.Bit(46), inst.Bit(48))};
+                        auto b{ApplyFloatModifiers(program.AsF32(GetOperandB(inst, opcode, true)), inst.Bit(49), inst.Bit(45))};
+                        SetRegister(inst.Dest(), ApplySaturate(program.Emit(ir::Opcode::FAdd, {a, b}), inst.Bit(50)));
+                        break;
+                    }
+
+                    case MaxwellOpcode::FADD32I: {
+                        auto a{ApplyFloatModifiers(GetF32(inst.SrcA()), inst.Bit(54), inst.Bit(56))};
+                        auto b{ApplyFloatModifiers(program.Emit(ir::Opcode::ImmF32, {}, inst.Imm32()), inst.Bit(57), inst.Bit(53))};
+                        SetRegister(inst.Dest(), program.Emit(ir::Opcode::FAdd, {a, b}));
+                        break;
+                    }
+
+                    case MaxwellOpcode::FMUL_reg:
+                    case MaxwellOpcode::FMUL_cbuf:
+                    case MaxwellOpcode::FMUL_imm: {
+                        constexpr std::array<float, 8> Scales{1.0f, 0.5f, 0.25f, 0.125f, 8.0f, 4.0f, 2.0f, 1.0f}; //!< The multipliers of the result for each FMUL scale mode
+                        auto a{GetF32(inst.SrcA())};
+                        auto b{ApplyFloatModifiers(program.AsF32(GetOperandB(inst, opcode, true)), false, inst.Bit(48))};
+                        auto result{program.Emit(ir::Opcode::FMul, {a, b})};
+                        if (auto scale{inst.Bits(41, 3)})
+                            result = program.Emit(ir::Opcode::FMul, {result, program.ImmF32(Scales[scale])});
+                        SetRegister(inst.Dest(), ApplySaturate(result, inst.Bit(50)));
+                        break;
+                    }
+
+                    case MaxwellOpcode::FMUL32I: {
+                        auto result{program.Emit(ir::Opcode::FMul, {GetF32(inst.SrcA()), program.Emit(ir::Opcode::ImmF32, {}, inst.Imm32())})};
+                        SetRegister(inst.Dest(), ApplySaturate(result, inst.Bit(55)));
+                        break;
+                    }
+
+                    case MaxwellOpcode::FFMA_reg:
+                    case MaxwellOpcode::FFMA_rc:
+                    case MaxwellOpcode::FFMA_cr:
+                    case MaxwellOpcode::FFMA_imm: {
+                        ir::Inst *c;
+                        if (opcode == MaxwellOpcode::FFMA_rc)
+                            c = GetConstant(inst.CbufIndex(), inst.CbufOffset());
+                        else
+                            c = GetRegister(inst.SrcC());
+
+                        auto a{GetF32(inst.SrcA())};
+                        auto b{ApplyFloatModifiers(program.AsF32(GetOperandB(inst, opcode, true)), false, inst.Bit(48))};
+                        c = ApplyFloatModifiers(program.AsF32(c), false, inst.Bit(49));
+                        SetRegister(inst.Dest(), ApplySaturate(program.Emit(ir::Opcode::FFma, {a, b, c}), inst.Bit(50)));
+                        break;
+                    }
+
+                    case MaxwellOpcode::FFMA32I: {
+                        // FFMA32I accumulates into the destination register as there's no space for another source register
+                        auto a{ApplyFloatModifiers(GetF32(inst.SrcA()), false, inst.Bit(56))};
+                        auto c{ApplyFloatModifiers(GetF32(inst.Dest()), false, inst.Bit(57))};
+                        auto result{program.Emit(ir::Opcode::FFma, {a, program.Emit(ir::Opcode::ImmF32, {}, inst.Imm32()), c})};
+                        SetRegister(inst.Dest(), ApplySaturate(result, inst.Bit(55)));
+                        break;
+                    }
+
+                    case MaxwellOpcode::IADD_reg:
+                    case MaxwellOpcode::IADD_cbuf:
+                    case MaxwellOpcode::IADD_imm: {
+                        if (inst.Bit(43) || inst.Bit(50))
+                            throw exception("IADD with extended precision or saturation isn't supported");
+
+                        auto a{program.AsU32(GetRegister(inst.SrcA()))};
+                        auto b{program.AsU32(GetOperandB(inst, opcode, false))};
+                        if (inst.Bit(49))
+                            a = program.Emit(ir::Opcode::INeg, {a});
+                        if (inst.Bit(48))
+                            b = program.Emit(ir::Opcode::INeg, {b});
+                        SetRegister(inst.Dest(), program.Emit(ir::Opcode::IAdd, {a, b}));
+                        break;
+                    }
+
+                    case MaxwellOpcode::IADD32I: {
+                        if (inst.Bit(53) || inst.Bit(54))
+                            throw exception("IADD32I with extended precision or saturation isn't supported");
+
+                        auto a{program.AsU32(GetRegister(inst.SrcA()))};
+                        if (inst.Bit(56))
+                            a = program.Emit(ir::Opcode::INeg, {a});
+                        SetRegister(inst.Dest(), program.Emit(ir::Opcode::IAdd, {a, program.ImmU32(inst.Imm32())}));
+                        break;
+                    }
+
+                    case MaxwellOpcode::IPA:
+                        DecodeInterpolate(inst);
+                        break;
+
+                    case MaxwellOpcode::ALD:
+                        DecodeAttributeLoad(inst);
+                        break;
+
+                    case MaxwellOpcode::AST:
+                        DecodeAttributeStore(inst);
+                        break;
+
+                    case MaxwellOpcode::LDC:
+                        DecodeLoadConstant(inst);
+                        break;
+                }
+
+                return true;
+            }
+        };
+    }
+
+    ir::Program DecodeMaxwell(span<const u8> binary) {
+        if (binary.size() < ShaderProgramHeaderSize)
+            throw exception("Program is smaller than its header: 0x{:X} bytes", binary.size());
+
+        auto header{binary.subspan(0, ShaderProgramHeaderSize).cast<const u32>()};
+        constexpr u32 SphTypeVtg{1}, SphTypePs{2};
+        constexpr u32 ShaderTypeVertexA{1}, ShaderTypeVertexB{2};
+        u32 sphType{header[0] & 0x1F}, shaderType{(header[0] >> 10) & 0xF};
+
+        ir::Program program;
+        if (sphType == SphTypePs)
+            program.stage = ir::Stage::Fragment;
+        else if (sphType == SphTypeVtg && (shaderType == ShaderTypeVertexA || shaderType == ShaderTypeVertexB))
+            program.stage = ir::Stage::Vertex;
+        else
+            throw exception("Unsupported shader type: SPH type {}, shader type {}", sphType, shaderType);
+
+        Decoder decoder{program, header};
+        auto code{binary.subspan(ShaderProgramHeaderSize)};
+        auto words{code.first(util::AlignDown(code.size(), sizeof(u64))).cast<const u64>()};
+
+        constexpr size_t SchedulingInterval{4}; //!< Every group of 4 words starts with a word holding the scheduling information of the following 3 instructions
+        for (size_t index{}; index < words.size(); index++) {
+            if (index % SchedulingInterval == 0)
+                continue;
+            if (!decoder.Decode(words[index]))
+                return program;
+        }
+
+        throw exception("Program has no terminating EXIT within 0x{:X} bytes", binary.size());
+    }
+}
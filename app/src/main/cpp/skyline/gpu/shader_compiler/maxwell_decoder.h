@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "ir.h"
+
+namespace skyline::gpu::shader_compiler {
+    constexpr size_t ShaderProgramHeaderSize{0x50}; //!< The size of the SPH (Shader Program Header) which every Maxwell program starts with
+
+    /**
+     * @brief Decodes a Maxwell (SM5.x) program into the IR, all register accesses are resolved into SSA values in the process
+     * @param binary The program starting with its SPH, trailing data after the terminating EXIT is ignored
+     * @note Only straight-line programs with a subset of the ALU and attribute instructions are supported so far, an exception is thrown on anything else
+     */
+    ir::Program DecodeMaxwell(span<const u8> binary);
+}
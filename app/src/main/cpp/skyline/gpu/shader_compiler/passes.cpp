@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cmath>
+#include "passes.h"
+
+namespace skyline::gpu::shader_compiler::pass {
+    namespace {
+        void FoldF32(ir::Inst &inst, float value) {
+            inst.ReplaceWithImmediate(ir::Type::F32, util::BitCast<u32>(value));
+        }
+
+        void FoldU32(ir::Inst &inst, u32 value) {
+            inst.ReplaceWithImmediate(ir::Type::U32, value);
+        }
+
+        bool IsImmediateF32(const ir::Inst *inst, float value) {
+            return inst->opcode == ir::Opcode::ImmF32 && inst->immediate == util::BitCast<u32>(value);
+        }
+
+        /**
+         * @brief Folds an instruction if all of its arguments are immediates or simplifies it if it's a trivial identity
+         */
+        void Fold(ir::Inst &inst) {
+            auto a{inst.args[0]}, b{inst.args[1]}, c{inst.args[2]};
+            switch (inst.opcode) {
+                case ir::Opcode::BitCastF32:
+                case ir::Opcode::BitCastU32:
+                    if (a->IsImmediate())
+                        inst.ReplaceWithImmediate(inst.GetType(), a->immediate);
+                    else if (a->opcode == (inst.opcode == ir::Opcode::BitCastF32 ? ir::Opcode::BitCastU32 : ir::Opcode::BitCastF32))
+                        inst.ReplaceWith(a->args[0]);
+                    break;
+
+                case ir::Opcode::FNeg:
+                    if (a->IsImmediate())
+                        FoldF32(inst, -a->GetF32());
+                    else if (a->opcode == ir::Opcode::FNeg)
+                        inst.ReplaceWith(a->args[0]);
+                    break;
+
+                case ir::Opcode::FAbs:
+                    if (a->IsImmediate())
+                        FoldF32(inst, std::fabs(a->GetF32()));
+                    else if (a->opcode == ir::Opcode::FAbs)
+                        inst.ReplaceWith(a);
+                    break;
+
+                case ir::Opcode::FSaturate:
+                    if (a->IsImmediate()) // Saturation flushes NaNs to zero on Maxwell
+                        FoldF32(inst, std::isnan(a->GetF32()) ? 0.0f : std::clamp(a->GetF32(), 0.0f, 1.0f));
+                    else if (a->opcode == ir::Opcode::FSaturate)
+                        inst.ReplaceWith(a);
+                    break;
+
+                case ir::Opcode::FAdd:
+                    if (a->IsImmediate() && b->IsImmediate())
+                        FoldF32(inst, a->GetF32() + b->GetF32());
+                    else if (IsImmediateF32(b, -0.0f)) // Only the addition of negative zero is an identity, positive zero turns a negative zero positive
+                        inst.ReplaceWith(a);
+                    else if (IsImmediateF32(a, -0.0f))
+                        inst.ReplaceWith(b);
+                    break;
+
+                case ir::Opcode::FMul:
+                    if (a->IsImmediate() && b->IsImmediate())
+                        FoldF32(inst, a->GetF32() * b->GetF32());
+                    else if (IsImmediateF32(b, 1.0f))
+                        inst.ReplaceWith(a);
+                    else if (IsImmediateF32(a, 1.0f))
+                        inst.ReplaceWith(b);
+                    break;
+
+                case ir::Opcode::FFma:
+                    if (a->IsImmediate() && b->IsImmediate() && c->IsImmediate())
+                        FoldF32(inst, std::fma(a->GetF32(), b->GetF32(), c->GetF32()));
+                    break;
+
+                case ir::Opcode::IAdd:
+                    if (a->IsImmediate() && b->IsImmediate())
+                        FoldU32(inst, a->immediate + b->immediate);
+                    else if (b->opcode == ir::Opcode::ImmU32 && b->immediate == 0)
+                        inst.ReplaceWith(a);
+                    else if (a->opcode == ir::Opcode::ImmU32 && a->immediate == 0)
+                        inst.ReplaceWith(b);
+                    break;
+
+                case ir::Opcode::INeg:
+                    if (a->IsImmediate())
+                        FoldU32(inst, static_cast<u32>(-static_cast<i64>(a->immediate)));
+                    else if (a->opcode == ir::Opcode::INeg)
+                        inst.ReplaceWith(a->args[0]);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        /**
+         * @return A mask with the bit of the supplied component set
+         */
+        constexpr u8 ComponentBit(u32 component) {
+            return static_cast<u8>(1U << component);
+        }
+    }
+
+    void ConstantPropagation(ir::Program &program) {
+        // Instructions only ever refer to earlier ones in a single block so a forward walk sees all arguments folded prior to their users
+        for (auto &inst : program.insts) {
+            inst.ResolveArgs();
+            Fold(inst);
+        }
+    }
+
+    void DeadCodeElimination(ir::Program &program) {
+        // Walking backwards lets a single pass remove entire chains of dead instructions as users are removed prior to their arguments
+        auto &insts{program.insts};
+        for (auto it{insts.end()}; it != insts.begin();) {
+            --it;
+            if (it->uses == 0 && (it->opcode == ir::Opcode::Identity || !ir::HasSideEffects(it->opcode))) {
+                it->ClearArgs();
+                it = insts.erase(it);
+            }
+        }
+    }
+
+    void CollectInfo(ir::Program &program) {
+        auto &info{program.info};
+        info = {};
+
+        for (const auto &inst : program.insts) {
+            switch (inst.opcode) {
+                case ir::Opcode::GetConstant: {
+                    // Constant buffers are bound as arrays of vec4s so the size is rounded up to cover an entire one
+                    auto &size{info.constantBuffers[inst.index]};
+                    size = std::max<u32>(size, util::AlignUp(inst.immediate + sizeof(u32), sizeof(u32) * 4));
+                    break;
+                }
+
+                case ir::Opcode::GetAttribute: {
+                    ir::AttributeComponent attribute{inst.immediate};
+                    if (attribute.isPosition)
+                        info.positionInput |= ComponentBit(attribute.component);
+                    else
+                        info.inputGenerics[attribute.index] |= ComponentBit(attribute.component);
+                    break;
+                }
+
+                case ir::Opcode::SetAttribute: {
+                    ir::AttributeComponent attribute{inst.immediate};
+                    if (attribute.isPosition)
+                        info.positionOutput |= ComponentBit(attribute.component);
+                    else
+                        info.outputGenerics[attribute.index] |= ComponentBit(attribute.component);
+                    break;
+                }
+
+                case ir::Opcode::SetFragColor:
+                    info.fragColors[inst.index] |= ComponentBit(inst.immediate);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+    void Optimize(ir::Program &program) {
+        ConstantPropagation(program);
+        DeadCodeElimination(program);
+        CollectInfo(program);
+    }
+}
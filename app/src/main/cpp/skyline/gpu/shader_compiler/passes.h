@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "ir.h"
+
+namespace skyline::gpu::shader_compiler::pass {
+    /**
+     * @brief Folds instructions with constant arguments into constants and simplifies trivial identities such as redundant bitcasts and double negations
+     * @note Float folding is performed with host semantics, denormals aren't flushed like Maxwell does by default as guest shaders don't depend on it in practice
+     */
+    void ConstantPropagation(ir::Program &program);
+
+    /**
+     * @brief Removes all instructions without side effects whose values are never used, this includes identities left behind by other passes
+     */
+    void DeadCodeElimination(ir::Program &program);
+
+    /**
+     * @brief Determines the range of every constant buffer read by the program and the attributes it accesses, this is stored in the info of the program
+     * @note This should run after dead code elimination so resources which are only read by eliminated instructions aren't bound
+     */
+    void CollectInfo(ir::Program &program);
+
+    /**
+     * @brief Runs all optimisation and analysis passes on the program in the order they depend on each other
+     */
+    void Optimize(ir::Program &program);
+}
@@ -0,0 +1,369 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unordered_map>
+#include "spirv_emitter.h"
+
+namespace skyline::gpu::shader_compiler {
+    namespace {
+        /**
+         * @brief The subset of SPIR-V enumerants used by the emitter, the values are from the SPIR-V and GLSL.std.450 specifications
+         */
+        namespace spv {
+            constexpr u32 Magic{0x07230203};
+            constexpr u32 Version10{0x00010000};
+
+            enum Op : u16 {
+                OpExtInstImport = 11,
+                OpExtInst = 12,
+                OpMemoryModel = 14,
+                OpEntryPoint = 15,
+                OpExecutionMode = 16,
+                OpCapability = 17,
+                OpTypeVoid = 19,
+                OpTypeInt = 21,
+                OpTypeFloat = 22,
+                OpTypeVector = 23,
+                OpTypeArray = 28,
+                OpTypeStruct = 30,
+                OpTypePointer = 32,
+                OpTypeFunction = 33,
+                OpConstant = 43,
+                OpFunction = 54,
+                OpFunctionEnd = 56,
+                OpVariable = 59,
+                OpLoad = 61,
+                OpStore = 62,
+                OpAccessChain = 65,
+                OpDecorate = 71,
+                OpMemberDecorate = 72,
+                OpBitcast = 124,
+                OpSNegate = 126,
+                OpFNegate = 127,
+                OpIAdd = 128,
+                OpFAdd = 129,
+                OpFMul = 133,
+                OpLabel = 248,
+                OpReturn = 253,
+            };
+
+            enum GlslStd450 : u32 {
+                FAbs = 4,
+                Fma = 50,
+                NClamp = 81,
+            };
+
+            constexpr u32 CapabilityShader{1};
+            constexpr u32 AddressingModelLogical{0}, MemoryModelGlsl450{1};
+            constexpr u32 ExecutionModelVertex{0}, ExecutionModelFragment{4};
+            constexpr u32 ExecutionModeOriginUpperLeft{7};
+            constexpr u32 StorageClassInput{1}, StorageClassUniform{2}, StorageClassOutput{3};
+            constexpr u32 DecorationBlock{2}, DecorationArrayStride{6}, DecorationBuiltIn{11}, DecorationLocation{30}, DecorationBinding{33}, DecorationDescriptorSet{34}, DecorationOffset{35};
+            constexpr u32 BuiltInPosition{0}, BuiltInFragCoord{15};
+            constexpr u32 FunctionControlNone{0};
+        }
+
+        /**
+         * @brief Assembles the sections of a SPIR-V module in the order mandated by the logical layout
+         */
+        class SpirvEmitter {
+          private:
+            const ir::Program &program;
+            u32 nextId{1};
+
+            std::vector<u32> preamble; //!< Capabilities, extended instruction imports and the memory model in that order
+            std::vector<u32> entryPoints; //!< Entry points and their execution modes
+            std::vector<u32> annotations;
+            std::vector<u32> globals; //!< Types, constants and global variables
+            std::vector<u32> code; //!< The function bodies
+
+            std::map<std::vector<u32>, u32> uniqueIds; //!< A map from the opcode and operands of non-aggregate types and constants to their ID, these must not be declared more than once
+            std::unordered_map<const ir::Inst *, u32> values; //!< A map from IR instructions to the ID of their result
+
+            u32 glslStd450{}, voidType{}, u32Type{}, f32Type{}, vec4Type{}, uvec4Type{};
+            u32 inputF32Pointer{}, outputF32Pointer{}, uniformU32Pointer{};
+            std::vector<u32> interfaceVariables; //!< All input and output variables, these must be listed by the entry point
+            std::map<u32, u32> constantBufferVariables; //!< A map from constant buffer slots to their variable
+            std::array<u32, 32> inputGenerics{}, outputGenerics{};
+            std::array<u32, 8> fragColors{};
+            u32 positionInput{}, positionOutput{};
+
+            u32 AllocateId() {
+                return nextId++;
+            }
+
+            static void Op(std::vector<u32> &section, u16 opcode, std::initializer_list<u32> operands) {
+                section.push_back(static_cast<u32>(operands.size() + 1) << 16 | opcode);
+                section.insert(section.end(), operands);
+            }
+
+            /**
+             * @brief Appends an instruction with a null-terminated literal string after the supplied operands
+             */
+            static void OpWithString(std::vector<u32> &section, u16 opcode, std::initializer_list<u32> operands, std::string_view string, span<const u32> trailingOperands = {}) {
+                size_t stringWords{string.size() / sizeof(u32) + 1}; // The terminator is always included and pads the last word with zeroes
+                section.push_back(static_cast<u32>(operands.size() + stringWords + trailingOperands.size() + 1) << 16 | opcode);
+                section.insert(section.end(), operands);
+
+                size_t offset{section.size()};
+                section.resize(offset + stringWords);
+                std::memcpy(section.data() + offset, string.data(), string.size());
+
+                section.insert(section.end(), trailingOperands.begin(), trailingOperands.end());
+            }
+
+            /**
+             * @return The ID of a non-aggregate type or constant with the supplied opcode and operands, it's declared if it doesn't exist yet
+             * @param resultTypeFirst If the first operand is the result type which precedes the result ID
+             */
+            u32 Unique(u16 opcode, std::initializer_list<u32> operands, bool resultTypeFirst = false) {
+                std::vector<u32> key{opcode};
+                key.insert(key.end(), operands);
+                auto [it, inserted]{uniqueIds.try_emplace(std::move(key))};
+                if (!inserted)
+                    return it->second;
+
+                u32 id{AllocateId()};
+                globals.push_back(static_cast<u32>(operands.size() + 2) << 16 | opcode);
+                auto operand{operands.begin()};
+                if (resultTypeFirst)
+                    globals.push_back(*operand++);
+                globals.push_back(id);
+                globals.insert(globals.end(), operand, operands.end());
+                return it->second = id;
+            }
+
+            u32 ConstantU32(u32 value) {
+                return Unique(spv::OpConstant, {u32Type, value}, true);
+            }
+
+            u32 ConstantF32(u32 bits) {
+                return Unique(spv::OpConstant, {f32Type, bits}, true);
+            }
+
+            u32 Variable(u32 pointerType, u32 storageClass) {
+                u32 id{AllocateId()};
+                Op(globals, spv::OpVariable, {pointerType, id, storageClass});
+                if (storageClass == spv::StorageClassInput || storageClass == spv::StorageClassOutput)
+                    interfaceVariables.push_back(id);
+                return id;
+            }
+
+            /**
+             * @return A vec4 variable in the supplied storage class which is decorated with the supplied decoration
+             */
+            u32 Vec4Variable(u32 storageClass, u32 decoration, u32 value) {
+                u32 id{Variable(Unique(spv::OpTypePointer, {storageClass, vec4Type}), storageClass)};
+                Op(annotations, spv::OpDecorate, {id, decoration, value});
+                return id;
+            }
+
+            void DeclareTypes() {
+                glslStd450 = AllocateId();
+                OpWithString(preamble, spv::OpExtInstImport, {glslStd450}, "GLSL.std.450");
+
+                voidType = Unique(spv::OpTypeVoid, {});
+                u32Type = Unique(spv::OpTypeInt, {32, 0});
+                f32Type = Unique(spv::OpTypeFloat, {32});
+                vec4Type = Unique(spv::OpTypeVector, {f32Type, 4});
+                uvec4Type = Unique(spv::OpTypeVector, {u32Type, 4});
+                inputF32Pointer = Unique(spv::OpTypePointer, {spv::StorageClassInput, f32Type});
+                outputF32Pointer = Unique(spv::OpTypePointer, {spv::StorageClassOutput, f32Type});
+                uniformU32Pointer = Unique(spv::OpTypePointer, {spv::StorageClassUniform, u32Type});
+            }
+
+            void DeclareInterface() {
+                const auto &info{program.info};
+
+                for (auto [slot, size] : info.constantBuffers) {
+                    // The array and struct are declared per-buffer rather than deduplicated as each one is decorated, aggregates may be declared more than once
+                    u32 arrayType{AllocateId()};
+                    Op(globals, spv::OpTypeArray, {arrayType, uvec4Type, ConstantU32(size / (sizeof(u32) * 4))});
+                    Op(annotations, spv::OpDecorate, {arrayType, spv::DecorationArrayStride, sizeof(u32) * 4});
+
+                    u32 structType{AllocateId()};
+                    Op(globals, spv::OpTypeStruct, {structType, arrayType});
+                    Op(annotations, spv::OpDecorate, {structType, spv::DecorationBlock});
+                    Op(annotations, spv::OpMemberDecorate, {structType, 0, spv::DecorationOffset, 0});
+
+                    u32 variable{Variable(Unique(spv::OpTypePointer, {spv::StorageClassUniform, structType}), spv::StorageClassUniform)};
+                    Op(annotations, spv::OpDecorate, {variable, spv::DecorationDescriptorSet, ConstantBufferDescriptorSet});
+                    Op(annotations, spv::OpDecorate, {variable, spv::DecorationBinding, info.GetConstantBufferBinding(slot)});
+                    constantBufferVariables.emplace(slot, variable);
+                }
+
+                for (u32 index{}; index < info.inputGenerics.size(); index++)
+                    if (info.inputGenerics[index])
+                        inputGenerics[index] = Vec4Variable(spv::StorageClassInput, spv::DecorationLocation, index);
+
+                if (info.positionInput) {
+                    if (program.stage != ir::Stage::Fragment)
+                        throw exception("Position inputs are only supported in fragment programs");
+                    positionInput = Vec4Variable(spv::StorageClassInput, spv::DecorationBuiltIn, spv::BuiltInFragCoord);
+                }
+
+                for (u32 index{}; index < info.outputGenerics.size(); index++)
+                    if (info.outputGenerics[index])
+                        outputGenerics[index] = Vec4Variable(spv::StorageClassOutput, spv::DecorationLocation, index);
+
+                if (info.positionOutput)
+                    positionOutput = Vec4Variable(spv::StorageClassOutput, spv::DecorationBuiltIn, spv::BuiltInPosition);
+
+                for (u32 index{}; index < info.fragColors.size(); index++)
+                    if (info.fragColors[index])
+                        fragColors[index] = Vec4Variable(spv::StorageClassOutput, spv::DecorationLocation, index);
+            }
+
+            u32 Value(const ir::Inst *inst) {
+                return values.at(inst);
+            }
+
+            u32 Emit(u16 opcode, u32 resultType, std::initializer_list<u32> operands) {
+                u32 id{AllocateId()};
+                code.push_back(static_cast<u32>(operands.size() + 3) << 16 | opcode);
+                code.push_back(resultType);
+                code.push_back(id);
+                code.insert(code.end(), operands);
+                return id;
+            }
+
+            u32 EmitGlsl(u32 resultType, u32 instruction, std::initializer_list<u32> operands) {
+                std::vector<u32> allOperands{glslStd450, instruction};
+                allOperands.insert(allOperands.end(), operands);
+
+                u32 id{AllocateId()};
+                code.push_back(static_cast<u32>(allOperands.size() + 3) << 16 | spv::OpExtInst);
+                code.push_back(resultType);
+                code.push_back(id);
+                code.insert(code.end(), allOperands.begin(), allOperands.end());
+                return id;
+            }
+
+            /**
+             * @return A pointer to the supplied component of an attribute's variable
+             */
+            u32 AttributePointer(u32 address, bool output) {
+                ir::AttributeComponent attribute{address};
+                u32 variable;
+                if (output)
+                    variable = attribute.isPosition ? positionOutput : outputGenerics[attribute.index];
+                else
+                    variable = attribute.isPosition ? positionInput : inputGenerics[attribute.index];
+
+                if (!variable)
+                    throw exception("Attribute 0x{:X} wasn't declared, the info of the program is stale", address);
+
+                return Emit(spv::OpAccessChain, output ? outputF32Pointer : inputF32Pointer, {variable, ConstantU32(attribute.component)});
+            }
+
+            u32 EmitInst(const ir::Inst &inst) {
+                auto arg{[&](size_t index) { return Value(inst.args[index]); }};
+                switch (inst.opcode) {
+                    case ir::Opcode::Identity:
+                        return Value(inst.args[0]);
+
+                    case ir::Opcode::ImmU32:
+                        return ConstantU32(inst.immediate);
+
+                    case ir::Opcode::ImmF32:
+                        return ConstantF32(inst.immediate);
+
+                    case ir::Opcode::GetConstant: {
+                        constexpr u32 Vec4Size{sizeof(u32) * 4};
+                        auto pointer{Emit(spv::OpAccessChain, uniformU32Pointer, {
+                            constantBufferVariables.at(inst.index),
+                            ConstantU32(0),
+                            ConstantU32(inst.immediate / Vec4Size),
+                            ConstantU32((inst.immediate % Vec4Size) / sizeof(u32)),
+                        })};
+                        return Emit(spv::OpLoad, u32Type, {pointer});
+                    }
+
+                    case ir::Opcode::GetAttribute:
+                        return Emit(spv::OpLoad, f32Type, {AttributePointer(inst.immediate, false)});
+
+                    case ir::Opcode::SetAttribute:
+                        Op(code, spv::OpStore, {AttributePointer(inst.immediate, true), arg(0)});
+                        return 0;
+
+                    case ir::Opcode::SetFragColor: {
+                        auto pointer{Emit(spv::OpAccessChain, outputF32Pointer, {fragColors.at(inst.index), ConstantU32(inst.immediate)})};
+                        Op(code, spv::OpStore, {pointer, arg(0)});
+                        return 0;
+                    }
+
+                    case ir::Opcode::BitCastF32:
+                        return Emit(spv::OpBitcast, f32Type, {arg(0)});
+
+                    case ir::Opcode::BitCastU32:
+                        return Emit(spv::OpBitcast, u32Type, {arg(0)});
+
+                    case ir::Opcode::FAdd:
+                        return Emit(spv::OpFAdd, f32Type, {arg(0), arg(1)});
+
+                    case ir::Opcode::FMul:
+                        return Emit(spv::OpFMul, f32Type, {arg(0), arg(1)});
+
+                    case ir::Opcode::FFma:
+                        return EmitGlsl(f32Type, spv::Fma, {arg(0), arg(1), arg(2)});
+
+                    case ir::Opcode::FNeg:
+                        return Emit(spv::OpFNegate, f32Type, {arg(0)});
+
+                    case ir::Opcode::FAbs:
+                        return EmitGlsl(f32Type, spv::FAbs, {arg(0)});
+
+                    case ir::Opcode::FSaturate:
+                        // NClamp is used as it flushes NaNs to the lower bound which matches the behaviour of Maxwell's saturation
+                        return EmitGlsl(f32Type, spv::NClamp, {arg(0), ConstantF32(util::BitCast<u32>(0.0f)), ConstantF32(util::BitCast<u32>(1.0f))});
+
+                    case ir::Opcode::IAdd:
+                        return Emit(spv::OpIAdd, u32Type, {arg(0), arg(1)});
+
+                    case ir::Opcode::INeg:
+                        return Emit(spv::OpSNegate, u32Type, {arg(0)});
+                }
+                throw exception("Unknown IR opcode: {}", static_cast<u32>(inst.opcode));
+            }
+
+            void EmitFunction(u32 function) {
+                u32 functionType{Unique(spv::OpTypeFunction, {voidType})};
+                Op(code, spv::OpFunction, {voidType, function, spv::FunctionControlNone, functionType});
+                Op(code, spv::OpLabel, {AllocateId()});
+
+                for (const auto &inst : program.insts)
+                    values.emplace(&inst, EmitInst(inst));
+
+                Op(code, spv::OpReturn, {});
+                Op(code, spv::OpFunctionEnd, {});
+            }
+
+          public:
+            SpirvEmitter(const ir::Program &program) : program(program) {}
+
+            std::vector<u32> Emit() {
+                Op(preamble, spv::OpCapability, {spv::CapabilityShader});
+                DeclareTypes();
+                Op(preamble, spv::OpMemoryModel, {spv::AddressingModelLogical, spv::MemoryModelGlsl450});
+                DeclareInterface();
+
+                u32 function{AllocateId()};
+                EmitFunction(function);
+
+                bool isFragment{program.stage == ir::Stage::Fragment};
+                OpWithString(entryPoints, spv::OpEntryPoint, {isFragment ? spv::ExecutionModelFragment : spv::ExecutionModelVertex, function}, "main", interfaceVariables);
+                if (isFragment)
+                    Op(entryPoints, spv::OpExecutionMode, {function, spv::ExecutionModeOriginUpperLeft});
+
+                std::vector<u32> module{spv::Magic, spv::Version10, 0, nextId, 0};
+                for (auto section : {&preamble, &entryPoints, &annotations, &globals, &code})
+                    module.insert(module.end(), section->begin(), section->end());
+                return module;
+            }
+        };
+    }
+
+    std::vector<u32> EmitSpirv(const ir::Program &program) {
+        return SpirvEmitter{program}.Emit();
+    }
+}
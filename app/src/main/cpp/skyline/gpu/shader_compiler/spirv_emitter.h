@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "ir.h"
+
+namespace skyline::gpu::shader_compiler {
+    constexpr u32 ConstantBufferDescriptorSet{0}; //!< The descriptor set which all constant buffers are bound in as uniform buffers
+
+    /**
+     * @brief Emits a SPIR-V 1.0 module for a program with a single entry point named "main"
+     * @note The interface of the module is declared from the info of the program, CollectInfo must have run on it beforehand
+     * @note Constant buffers are declared as uniform buffers of vec4s at the bindings returned by ProgramInfo::GetConstantBufferBinding, generic attributes and fragment colors are at locations matching their index
+     */
+    std::vector<u32> EmitSpirv(const ir::Program &program);
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+// Samples a layer and applies its colour matrix, YUV layers sample luma and chroma from separate planes while RGB layers only have a single plane
+// The push constant block must match CompositionPass::PushConstants
+#version 450
+
+layout(push_constant) uniform Parameters {
+    vec4 destination;
+    vec4 source;
+    vec4 matrix[3]; // The rows of a 3x4 matrix mapping the sampled channels and a constant 1 onto the channels of the destination
+    float alpha; // The alpha of the entire layer
+    uint planar; // If the chroma channels are sampled from the chroma plane rather than the luma plane
+};
+
+layout(set = 0, binding = 0) uniform sampler2D luma;
+layout(set = 0, binding = 1) uniform sampler2D chroma;
+
+layout(location = 0) in vec2 sourceCoordinates;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    vec4 texel = texture(luma, sourceCoordinates);
+    vec4 channels = planar != 0 ? vec4(texel.r, texture(chroma, sourceCoordinates).rg, 1.0) : texel;
+    vec4 transformed = vec4(channels.rgb, 1.0);
+    color = vec4(dot(matrix[0], transformed), dot(matrix[1], transformed), dot(matrix[2], transformed), channels.a * alpha);
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+// Draws a quad covering the destination region of a layer with the corresponding source coordinates
+// The push constant block must match CompositionPass::PushConstants
+#version 450
+
+layout(push_constant) uniform Parameters {
+    vec4 destination; // The left, top, right and bottom edges of the destination region in normalized device coordinates
+    vec4 source; // The left, top, right and bottom edges of the sampled region in normalized coordinates
+    vec4 matrix[3];
+    float alpha;
+    uint planar;
+};
+
+layout(location = 0) out vec2 sourceCoordinates;
+
+void main() {
+    // The quad is drawn as a triangle strip with the corners in the order of top-left, top-right, bottom-left and bottom-right
+    vec2 position = vec2(float(gl_VertexIndex & 1), float(gl_VertexIndex >> 1));
+    sourceCoordinates = mix(source.xy, source.zw, position);
+    gl_Position = vec4(mix(destination.xy, destination.zw, position), 0.0, 1.0);
+}
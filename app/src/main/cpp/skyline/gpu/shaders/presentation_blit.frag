@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+
+layout(location = 0) in vec2 sourceCoordinates;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    color = texture(source, sourceCoordinates);
+}
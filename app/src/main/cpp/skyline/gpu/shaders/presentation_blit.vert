@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+// Draws a single triangle covering the entire destination with source coordinates that have the transform of the pass applied to them
+// The push constant block must match PresentationBlitPass::PushConstants
+#version 450
+
+layout(push_constant) uniform Parameters {
+    vec2 origin; // The source coordinates at the top-left corner of the destination
+    vec2 xAxis; // The change in source coordinates across the width of the destination
+    vec2 yAxis; // The change in source coordinates across the height of the destination
+};
+
+layout(location = 0) out vec2 sourceCoordinates;
+
+void main() {
+    // The triangle spans [0, 2] in destination coordinates, the part outside of [0, 1] is clipped
+    vec2 position = vec2(float((gl_VertexIndex << 1) & 2), float(gl_VertexIndex & 2));
+    sourceCoordinates = origin + position.x * xAxis + position.y * yAxis;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "bc_decoder.h"
+
+namespace skyline::gpu::texture::bcn {
+    namespace {
+        constexpr u32 BlockDimensions{4}; //!< The width and height of a block in pixels, this is the same for all BCn formats
+        constexpr u32 OutputBpp{sizeof(u32)}; //!< The bytes per pixel of the decoded R8G8B8A8 output
+
+        using Texel = std::array<u8, 4>;
+        using Texels = std::array<Texel, BlockDimensions * BlockDimensions>; //!< A decoded block of texels in row-major order
+
+        constexpr u8 Expand5(u32 value) {
+            return static_cast<u8>((value << 3) | (value >> 2));
+        }
+
+        constexpr u8 Expand6(u32 value) {
+            return static_cast<u8>((value << 2) | (value >> 4));
+        }
+
+        /**
+         * @brief Decodes a BC1 colour block, this is also used for the colour component of BC2 and BC3
+         * @param punchThrough If the 3-colour mode with transparent black is used when the first endpoint isn't larger than the second, this is only the case for BC1
+         */
+        void DecodeColourBlock(const u8 *block, Texels &texels, bool punchThrough) {
+            u16 colour0, colour1;
+            u32 indices;
+            std::memcpy(&colour0, block, sizeof(u16));
+            std::memcpy(&colour1, block + sizeof(u16), sizeof(u16));
+            std::memcpy(&indices, block + (sizeof(u16) * 2), sizeof(u32));
+
+            std::array<Texel, 4> palette{
+                Texel{Expand5(colour0 >> 11), Expand6((colour0 >> 5) & 0x3F), Expand5(colour0 & 0x1F), 0xFF},
+                Texel{Expand5(colour1 >> 11), Expand6((colour1 >> 5) & 0x3F), Expand5(colour1 & 0x1F), 0xFF},
+            };
+
+            if (colour0 > colour1 || !punchThrough) {
+                for (size_t channel{}; channel < 3; channel++) {
+                    palette[2][channel] = static_cast<u8>((2 * palette[0][channel] + palette[1][channel]) / 3);
+                    palette[3][channel] = static_cast<u8>((palette[0][channel] + 2 * palette[1][channel]) / 3);
+                }
+                palette[2][3] = palette[3][3] = 0xFF;
+            } else {
+                for (size_t channel{}; channel < 3; channel++)
+                    palette[2][channel] = static_cast<u8>((palette[0][channel] + palette[1][channel]) / 2);
+                palette[2][3] = 0xFF;
+                palette[3] = {}; // Transparent black
+            }
+
+            for (size_t texel{}; texel < texels.size(); texel++)
+                texels[texel] = palette[(indices >> (texel * 2)) & 0b11];
+        }
+
+        /**
+         * @brief Decodes a BC3 alpha block into a single channel of the texels, this is also used for BC4 and each channel of BC5
+         */
+        void DecodeChannelBlock(const u8 *block, Texels &texels, size_t channel) {
+            std::array<u8, 8> palette{block[0], block[1]};
+            if (palette[0] > palette[1]) {
+                for (u32 index{1}; index < 7; index++)
+                    palette[index + 1] = static_cast<u8>(((7 - index) * palette[0] + index * palette[1]) / 7);
+            } else {
+                for (u32 index{1}; index < 5; index++)
+                    palette[index + 1] = static_cast<u8>(((5 - index) * palette[0] + index * palette[1]) / 5);
+                palette[6] = 0x00;
+                palette[7] = 0xFF;
+            }
+
+            u64 indices{};
+            std::memcpy(&indices, block + 2, 6); // 16 3-bit indices are packed into 48 bits
+            for (size_t texel{}; texel < texels.size(); texel++)
+                texels[texel][channel] = palette[(indices >> (texel * 3)) & 0b111];
+        }
+
+        /**
+         * @brief Decodes BC2 explicit 4-bit alpha into the alpha channel of the texels
+         */
+        void DecodeExplicitAlphaBlock(const u8 *block, Texels &texels) {
+            u64 alpha;
+            std::memcpy(&alpha, block, sizeof(u64));
+            for (size_t texel{}; texel < texels.size(); texel++)
+                texels[texel][3] = static_cast<u8>(((alpha >> (texel * 4)) & 0xF) * 0x11);
+        }
+
+        /**
+         * @brief Decodes every block of an image with the supplied function and writes the resulting texels to the output
+         */
+        template<typename BlockDecoder>
+        void DecodeBlocks(const u8 *input, u8 *output, u32 width, u32 height, size_t blockSize, BlockDecoder decodeBlock) {
+            // Textures with dimensions that aren't a multiple of the block dimensions have partial blocks at their edges, only the texels inside the texture are written from these
+            auto blocksX{util::DivideCeil(width, BlockDimensions)}, blocksY{util::DivideCeil(height, BlockDimensions)};
+            size_t outputPitch{width * OutputBpp};
+
+            Texels texels;
+            for (u32 blockY{}; blockY < blocksY; blockY++) {
+                u32 rows{std::min(BlockDimensions, height - (blockY * BlockDimensions))};
+                for (u32 blockX{}; blockX < blocksX; blockX++) {
+                    decodeBlock(input, texels);
+                    input += blockSize;
+
+                    u32 columns{std::min(BlockDimensions, width - (blockX * BlockDimensions))};
+                    auto blockOutput{output + (blockY * BlockDimensions * outputPitch) + (blockX * BlockDimensions * OutputBpp)};
+                    for (u32 row{}; row < rows; row++)
+                        std::memcpy(blockOutput + (row * outputPitch), &texels[row * BlockDimensions], columns * OutputBpp);
+                }
+            }
+        }
+    }
+
+    bool IsSupported(const FormatBase &format) {
+        switch (format.vkFormat) {
+            case vk::Format::eBc1RgbaUnormBlock:
+            case vk::Format::eBc2UnormBlock:
+            case vk::Format::eBc3UnormBlock:
+            case vk::Format::eBc4UnormBlock:
+            case vk::Format::eBc5UnormBlock:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void Decode(const FormatBase &format, const u8 *input, u8 *output, u32 width, u32 height) {
+        switch (format.vkFormat) {
+            case vk::Format::eBc1RgbaUnormBlock:
+                DecodeBlocks(input, output, width, height, format.bpb, [](const u8 *block, Texels &texels) {
+                    DecodeColourBlock(block, texels, true);
+                });
+                break;
+
+            case vk::Format::eBc2UnormBlock:
+                DecodeBlocks(input, output, width, height, format.bpb, [](const u8 *block, Texels &texels) {
+                    DecodeColourBlock(block + sizeof(u64), texels, false);
+                    DecodeExplicitAlphaBlock(block, texels);
+                });
+                break;
+
+            case vk::Format::eBc3UnormBlock:
+                DecodeBlocks(input, output, width, height, format.bpb, [](const u8 *block, Texels &texels) {
+                    DecodeColourBlock(block + sizeof(u64), texels, false);
+                    DecodeChannelBlock(block, texels, 3);
+                });
+                break;
+
+            case vk::Format::eBc4UnormBlock:
+                DecodeBlocks(input, output, width, height, format.bpb, [](const u8 *block, Texels &texels) {
+                    texels.fill({0x00, 0x00, 0x00, 0xFF});
+                    DecodeChannelBlock(block, texels, 0);
+                });
+                break;
+
+            case vk::Format::eBc5UnormBlock:
+                DecodeBlocks(input, output, width, height, format.bpb, [](const u8 *block, Texels &texels) {
+                    texels.fill({0x00, 0x00, 0x00, 0xFF});
+                    DecodeChannelBlock(block, texels, 0);
+                    DecodeChannelBlock(block + sizeof(u64), texels, 1);
+                });
+                break;
+
+            default:
+                throw exception("Decoding '{}' on the CPU isn't supported", vk::to_string(format.vkFormat));
+        }
+    }
+}
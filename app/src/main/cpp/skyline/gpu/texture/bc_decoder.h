@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "texture.h"
+
+namespace skyline::gpu::texture::bcn {
+    /**
+     * @return If the supplied format can be decoded by the CPU decoder
+     */
+    bool IsSupported(const FormatBase &format);
+
+    /**
+     * @brief Decodes a linear BCn compressed image into a tightly packed R8G8B8A8 image
+     * @param width The width of the image in pixels, any partial blocks at the edge of the image are skipped
+     * @param height The height of the image in pixels, multiple depth slices can be decoded at once by multiplying this with the depth
+     */
+    void Decode(const FormatBase &format, const u8 *input, u8 *output, u32 width, u32 height);
+}
@@ -3,13 +3,173 @@
 
 #pragma once
 
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+#include <common/thread_pool.h>
+#include <common/trace.h>
 #include "texture.h"
 
 namespace skyline::gpu {
+    namespace detail {
+        constexpr u8 SectorWidth{16}; //!< The width of a sector in bytes
+        constexpr u8 GobWidth{64}; //!< The width of a GOB in bytes
+        constexpr u8 GobHeight{8}; //!< The height of a GOB in lines
+        constexpr u16 GobSize{GobWidth * GobHeight}; //!< The size of a GOB in bytes
+
+        /**
+         * @brief Deswizzles a single 512-byte GOB into 8 lines of 64 bytes in linear memory
+         * @param pitch The offset between lines in the linear output
+         * @note Sectors in a GOB are ordered such that every 64 bytes of it contain two 32 byte halves of two consecutive lines interleaved at a sector granularity, this lets us copy a GOB with 8 sequential 64 byte loads
+         */
+        inline void DeswizzleGob(const u8 *gob, u8 *linear, u32 pitch) {
+            for (u32 half{}; half < 2; half++) { // The left and right 32 byte halves of the GOB
+                for (u32 linePair{}; linePair < GobHeight / 2; linePair++) {
+                    auto line{linear + (linePair * 2 * pitch) + (half * (GobWidth / 2))};
+                    #ifdef __ARM_NEON
+                    auto sectors{vld1q_u8_x4(gob)};
+                    vst1q_u8(line, sectors.val[0]);
+                    vst1q_u8(line + SectorWidth, sectors.val[2]);
+                    vst1q_u8(line + pitch, sectors.val[1]);
+                    vst1q_u8(line + pitch + SectorWidth, sectors.val[3]);
+                    #else
+                    std::memcpy(line, gob, SectorWidth);
+                    std::memcpy(line + SectorWidth, gob + (SectorWidth * 2), SectorWidth);
+                    std::memcpy(line + pitch, gob + SectorWidth, SectorWidth);
+                    std::memcpy(line + pitch + SectorWidth, gob + (SectorWidth * 3), SectorWidth);
+                    #endif
+                    gob += SectorWidth * 4;
+                }
+            }
+        }
+
+        /**
+         * @brief Swizzles 8 lines of 64 bytes from linear memory into a single 512-byte GOB, this is the inverse of DeswizzleGob
+         */
+        inline void SwizzleGob(const u8 *linear, u8 *gob, u32 pitch) {
+            for (u32 half{}; half < 2; half++) {
+                for (u32 linePair{}; linePair < GobHeight / 2; linePair++) {
+                    auto line{linear + (linePair * 2 * pitch) + (half * (GobWidth / 2))};
+                    #ifdef __ARM_NEON
+                    uint8x16x4_t sectors{{
+                        vld1q_u8(line),
+                        vld1q_u8(line + pitch),
+                        vld1q_u8(line + SectorWidth),
+                        vld1q_u8(line + pitch + SectorWidth),
+                    }};
+                    vst1q_u8_x4(gob, sectors);
+                    #else
+                    std::memcpy(gob, line, SectorWidth);
+                    std::memcpy(gob + SectorWidth, line + pitch, SectorWidth);
+                    std::memcpy(gob + (SectorWidth * 2), line + SectorWidth, SectorWidth);
+                    std::memcpy(gob + (SectorWidth * 3), line + pitch + SectorWidth, SectorWidth);
+                    #endif
+                    gob += SectorWidth * 4;
+                }
+            }
+        }
+
+        /**
+         * @brief The layout of a blocklinear guest texture in terms of ROBs (Rows Of Blocks), every ROB can be copied independently of the others
+         */
+        struct BlockLinearLayout {
+            u32 blockHeight; //!< The height of the blocks in GOBs
+            u32 robHeight; //!< The height of a single ROB in lines
+            u32 surfaceHeight; //!< The height of the surface in lines
+            u32 surfaceHeightRobs; //!< The height of the surface in ROBs
+            u32 robWidthBytes; //!< The width of a ROB in bytes
+            u32 robWidthBlocks; //!< The width of a ROB in blocks (and GOBs because block width == 1 on the Tegra X1)
+            u32 robBytes; //!< The size of a ROB in bytes in linear memory
+            u32 gobYOffset; //!< The offset of the next Y-axis GOB from the current one in linear space
+
+            BlockLinearLayout(const GuestTexture &guest)
+                : blockHeight(guest.tileConfig.blockHeight),
+                  robHeight(GobHeight * blockHeight),
+                  surfaceHeight(guest.dimensions.height / guest.format->blockHeight),
+                  surfaceHeightRobs(util::AlignUp(surfaceHeight, robHeight) / robHeight),
+                  robWidthBytes(util::AlignUp((guest.dimensions.width / guest.format->blockWidth) * guest.format->bpb, GobWidth)),
+                  robWidthBlocks(robWidthBytes / GobWidth),
+                  robBytes(robWidthBytes * robHeight),
+                  gobYOffset(robWidthBytes * GobHeight) {}
+        };
+
+        /**
+         * @brief Walks over every GOB of a single ROB of a blocklinear guest texture alongside the corresponding location in a linear buffer
+         * @param guestPointer A pointer to the start of the guest texture, not the ROB
+         * @param linearPointer A pointer to the start of the linear buffer, not the ROB
+         * @param function A function which is called with a pointer to the GOB in guest memory, a pointer to the GOB in linear memory and the pitch of the linear memory
+         */
+        template<typename GobFunction>
+        void ForEachGobInRob(const BlockLinearLayout &layout, u32 rob, u8 *guestPointer, u8 *linearPointer, GobFunction function) {
+            // Reference on Block-linear tiling: https://gist.github.com/PixelyIon/d9c35050af0ef5690566ca9f0965bc32
+            u32 blockHeight{layout.blockHeight};
+            if (rob != 0)
+                blockHeight = std::min(blockHeight, (layout.surfaceHeight - (rob * layout.robHeight)) / GobHeight); // Calculate the amount of Y GOBs which aren't padding
+            u32 paddingY{(layout.blockHeight - blockHeight) * GobSize}; // Calculate the amount of padding between contiguous GOBs
+
+            auto guestGob{guestPointer + (static_cast<size_t>(rob) * layout.robWidthBlocks * layout.blockHeight * GobSize)}; // Blocks in guest memory always contain the full amount of GOBs, including padding
+            auto linearBlock{linearPointer + (static_cast<size_t>(rob) * layout.robBytes)};
+            for (u32 block{}; block < layout.robWidthBlocks; block++) { // Every ROB contains `robWidthBlocks` Blocks
+                auto linearGob{linearBlock}; // We iterate through a GOB independently of the block
+                for (u32 gobY{}; gobY < blockHeight; gobY++) { // Every Block contains `blockHeight` Y-axis GOBs
+                    function(guestGob, linearGob, layout.robWidthBytes);
+                    guestGob += GobSize;
+                    linearGob += layout.gobYOffset; // Increment the linear GOB to the next Y-axis GOB
+                }
+                guestGob += paddingY; // Skip over any padding GOBs at the end of the block
+                linearBlock += GobWidth; // Increment the linear block to the next block (As Block Width = 1 GOB Width)
+            }
+        }
+
+        constexpr size_t ParallelCopyThreshold{0x100000}; //!< The minimum size of a texture in bytes for it to be copied across the threads of a pool, smaller textures aren't worth the overhead of waking up workers
+
+        /**
+         * @brief Walks over every GOB of a blocklinear guest texture alongside the corresponding location in a linear buffer
+         * @param threadPool A pool to split the ROBs across when the texture is large enough, they're walked on the calling thread if this is null
+         * @param function A function which is called with a pointer to the GOB in guest memory, a pointer to the GOB in linear memory and the pitch of the linear memory, it may be called concurrently for GOBs in different ROBs
+         */
+        template<typename GobFunction>
+        void ForEachGob(GuestTexture &guest, u8 *guestPointer, u8 *linearPointer, ThreadPool *threadPool, GobFunction function) {
+            BlockLinearLayout layout{guest};
+            if (threadPool && layout.surfaceHeightRobs > 1 && static_cast<size_t>(layout.robBytes) * layout.surfaceHeightRobs >= ParallelCopyThreshold) {
+                TRACE_EVENT("gpu", "ForEachGob (Parallel)");
+                threadPool->ParallelFor(layout.surfaceHeightRobs, [&](size_t rob) {
+                    ForEachGobInRob(layout, static_cast<u32>(rob), guestPointer, linearPointer, function);
+                });
+            } else {
+                for (u32 rob{}; rob < layout.surfaceHeightRobs; rob++) // Every Surface contains `surfaceHeightRobs` ROBs
+                    ForEachGobInRob(layout, rob, guestPointer, linearPointer, function);
+            }
+        }
+    }
+
     /**
      * @brief Copies the contents of a blocklinear guest texture to a linear output buffer
+     * @param threadPool An optional pool which large textures are deswizzled across
+     * @note This copies an entire GOB at a time with SIMD loads and stores where available
      */
-    void CopyBlockLinearToLinear(GuestTexture &guest, u8 *guestInput, u8 *linearOutput) {
+    inline void CopyBlockLinearToLinear(GuestTexture &guest, u8 *guestInput, u8 *linearOutput, ThreadPool *threadPool = nullptr) {
+        detail::ForEachGob(guest, guestInput, linearOutput, threadPool, [](u8 *guestGob, u8 *linearGob, u32 pitch) {
+            detail::DeswizzleGob(guestGob, linearGob, pitch);
+        });
+    }
+
+    /**
+     * @brief Copies the contents of a linear buffer to a blocklinear guest texture
+     * @param threadPool An optional pool which large textures are swizzled across
+     * @note This copies an entire GOB at a time with SIMD loads and stores where available
+     */
+    inline void CopyLinearToBlockLinear(GuestTexture &guest, u8 *linearInput, u8 *guestOutput, ThreadPool *threadPool = nullptr) {
+        detail::ForEachGob(guest, guestOutput, linearInput, threadPool, [](u8 *guestGob, u8 *linearGob, u32 pitch) {
+            detail::SwizzleGob(linearGob, guestGob, pitch);
+        });
+    }
+
+    /**
+     * @brief Copies the contents of a blocklinear guest texture to a linear output buffer
+     * @note This is a scalar reference implementation that copies a sector at a time, it should match the output of CopyBlockLinearToLinear exactly
+     */
+    inline void CopyBlockLinearToLinearReference(GuestTexture &guest, u8 *guestInput, u8 *linearOutput) {
         // Reference on Block-linear tiling: https://gist.github.com/PixelyIon/d9c35050af0ef5690566ca9f0965bc32
         constexpr u8 SectorWidth{16}; // The width of a sector in bytes
         constexpr u8 SectorHeight{2}; // The height of a sector in lines
@@ -54,8 +214,9 @@ namespace skyline::gpu {
 
     /**
      * @brief Copies the contents of a blocklinear guest texture to a linear output buffer
+     * @note This is a scalar reference implementation that copies a sector at a time, it should match the output of CopyLinearToBlockLinear exactly
      */
-    void CopyLinearToBlockLinear(GuestTexture &guest, u8 *linearInput, u8 *guestOutput) {
+    inline void CopyLinearToBlockLinearReference(GuestTexture &guest, u8 *linearInput, u8 *guestOutput) {
         // Reference on Block-linear tiling: https://gist.github.com/PixelyIon/d9c35050af0ef5690566ca9f0965bc32
         constexpr u8 SectorWidth{16}; // The width of a sector in bytes
         constexpr u8 SectorHeight{2}; // The height of a sector in lines
@@ -99,36 +260,48 @@ namespace skyline::gpu {
     }
 
     /**
-     * @brief Copies the contents of a pitch-linear guest texture to a linear output buffer
+     * @brief Copies the lines of a linear texture between two buffers with potentially differing pitches
+     * @note If the pitches match, this is a single copy of the entire texture rather than one per line
      */
-    void CopyPitchLinearToLinear(GuestTexture &guest, u8 *guestInput, u8 *linearOutput) {
+    inline void CopyLines(GuestTexture &guest, u8 *input, size_t inputPitch, u8 *output, size_t outputPitch) {
         auto sizeLine{guest.format->GetSize(guest.dimensions.width, 1)}; //!< The size of a single line of pixel data
-        auto sizeStride{guest.format->GetSize(guest.tileConfig.pitch, 1)}; //!< The size of a single stride of pixel data
+        if (guest.dimensions.height == 0)
+            return;
 
-        auto inputLine{guestInput};
-        auto outputLine{linearOutput};
+        if (inputPitch == outputPitch) {
+            std::memcpy(output, input, (inputPitch * (guest.dimensions.height - 1)) + sizeLine);
+            return;
+        }
+
+        auto inputLine{input};
+        auto outputLine{output};
 
         for (u32 line{}; line < guest.dimensions.height; line++) {
             std::memcpy(outputLine, inputLine, sizeLine);
-            inputLine += sizeStride;
-            outputLine += sizeLine;
+            inputLine += inputPitch;
+            outputLine += outputPitch;
         }
     }
 
     /**
-     * @brief Copies the contents of a linear buffer to a pitch-linear guest texture
+     * @brief Copies the contents of a pitch-linear guest texture to a linear output buffer
+     * @param linearPitch The pitch of lines in the linear buffer, it's assumed to be tightly packed if this is zero
      */
-    void CopyLinearToPitchLinear(GuestTexture &guest, u8 *linearInput, u8 *guestOutput) {
+    inline void CopyPitchLinearToLinear(GuestTexture &guest, u8 *guestInput, u8 *linearOutput, size_t linearPitch = 0) {
         auto sizeLine{guest.format->GetSize(guest.dimensions.width, 1)}; //!< The size of a single line of pixel data
         auto sizeStride{guest.format->GetSize(guest.tileConfig.pitch, 1)}; //!< The size of a single stride of pixel data
 
-        auto inputLine{linearInput};
-        auto outputLine{guestOutput};
+        CopyLines(guest, guestInput, sizeStride, linearOutput, linearPitch ? linearPitch : sizeLine);
+    }
 
-        for (u32 line{}; line < guest.dimensions.height; line++) {
-            std::memcpy(outputLine, inputLine, sizeLine);
-            inputLine += sizeLine;
-            outputLine += sizeStride;
-        }
+    /**
+     * @brief Copies the contents of a linear buffer to a pitch-linear guest texture
+     * @param linearPitch The pitch of lines in the linear buffer, it's assumed to be tightly packed if this is zero
+     */
+    inline void CopyLinearToPitchLinear(GuestTexture &guest, u8 *linearInput, u8 *guestOutput, size_t linearPitch = 0) {
+        auto sizeLine{guest.format->GetSize(guest.dimensions.width, 1)}; //!< The size of a single line of pixel data
+        auto sizeStride{guest.format->GetSize(guest.tileConfig.pitch, 1)}; //!< The size of a single stride of pixel data
+
+        CopyLines(guest, linearInput, linearPitch ? linearPitch : sizeLine, guestOutput, sizeStride);
     }
 }
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <lz4.h>
+#include <common/trace.h>
+#include "decode_cache.h"
+
+namespace skyline::gpu {
+    std::shared_ptr<vfs::CacheDirectory> TextureDecodeCache::GetDirectory() {
+        std::scoped_lock lock(mutex);
+        return directory;
+    }
+
+    std::string TextureDecodeCache::GetEntryName(u64 key) {
+        return util::Format("{:016X}.bin", key);
+    }
+
+    void TextureDecodeCache::Open(const std::string &path, size_t budget) {
+        try {
+            auto lDirectory{std::make_shared<vfs::CacheDirectory>(path, budget)};
+            std::scoped_lock lock(mutex);
+            directory = std::move(lDirectory);
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to open the texture decode cache at '{}': {}", path, e.what());
+        }
+    }
+
+    bool TextureDecodeCache::Load(u64 key, span<u8> output) {
+        auto lDirectory{GetDirectory()};
+        if (!lDirectory)
+            return false;
+
+        TRACE_EVENT("gpu", "TextureDecodeCache::Load");
+
+        auto entry{lDirectory->Load(GetEntryName(key), EntryMagic, EntryVersion)};
+        if (!entry || entry->size() < sizeof(EntryHeader))
+            return false;
+
+        auto header{*reinterpret_cast<EntryHeader *>(entry->data())};
+        if (header.size != output.size())
+            return false; // A mismatching size is a hash collision which can't be used
+
+        auto compressedSize{entry->size() - sizeof(EntryHeader)};
+        return LZ4_decompress_safe(reinterpret_cast<char *>(entry->data() + sizeof(EntryHeader)), reinterpret_cast<char *>(output.data()), static_cast<int>(compressedSize), static_cast<int>(output.size())) == static_cast<int>(output.size());
+    }
+
+    void TextureDecodeCache::Store(u64 key, span<u8> data) {
+        auto lDirectory{GetDirectory()};
+        if (!lDirectory)
+            return;
+
+        TRACE_EVENT("gpu", "TextureDecodeCache::Store");
+
+        std::vector<u8> entry(sizeof(EntryHeader) + static_cast<size_t>(LZ4_compressBound(static_cast<int>(data.size()))));
+        auto compressedSize{LZ4_compress_default(reinterpret_cast<char *>(data.data()), reinterpret_cast<char *>(entry.data() + sizeof(EntryHeader)), static_cast<int>(data.size()), static_cast<int>(entry.size() - sizeof(EntryHeader)))};
+        if (compressedSize <= 0) {
+            Logger::Warn("Failed to compress texture decode cache entry {:016X}", key);
+            return;
+        }
+
+        *reinterpret_cast<EntryHeader *>(entry.data()) = EntryHeader{
+            .size = data.size(),
+        };
+        entry.resize(sizeof(EntryHeader) + static_cast<size_t>(compressedSize));
+        lDirectory->Store(GetEntryName(key), EntryMagic, EntryVersion, entry);
+    }
+}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vfs/cache_directory.h>
+
+namespace skyline::gpu {
+    /**
+     * @brief An on-disk cache of guest textures which were decoded on the CPU, this avoids decoding the same textures again on later boots
+     * @note Entries are keyed by a hash of the guest texture data and its layout, they're LZ4 compressed as decoded textures are several times the size of the compressed data
+     * @note The least recently used entries are evicted once the cache exceeds its size budget
+     */
+    class TextureDecodeCache {
+      private:
+        /**
+         * @brief The header of the payload of a cache entry, it's followed by the LZ4 compressed decoded data
+         */
+        struct EntryHeader {
+            u64 size; //!< The size of the decoded data
+        };
+
+        static constexpr u32 EntryMagic{util::MakeMagic<u32>("SKTD")}; //!< "SKTD" - Skyline Texture Decode
+        static constexpr u32 EntryVersion{1};
+
+        std::mutex mutex; //!< Synchronizes opening the cache, concurrent accesses to entries are synchronized by the cache directory
+        std::shared_ptr<vfs::CacheDirectory> directory; //!< The directory holding all entries, this is null till the cache is opened
+
+        std::shared_ptr<vfs::CacheDirectory> GetDirectory();
+
+        static std::string GetEntryName(u64 key);
+
+      public:
+        /**
+         * @brief Opens the cache at the supplied directory, any lookups prior to this miss and stores are dropped
+         * @param budget The maximum size of the cache in bytes, 0 if it's unlimited
+         */
+        void Open(const std::string &path, size_t budget);
+
+        /**
+         * @brief Looks up a decoded texture in the cache
+         * @param output The buffer to write the decoded texture into, it must be the exact size of the decoded texture
+         * @return If the texture was found and written to the output
+         */
+        bool Load(u64 key, span<u8> output);
+
+        /**
+         * @brief Stores a decoded texture in the cache, any errors are logged and otherwise ignored as the cache is only an optimization
+         */
+        void Store(u64 key, span<u8> data);
+    };
+}
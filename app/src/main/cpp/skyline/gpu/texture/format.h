@@ -12,6 +12,7 @@ namespace skyline::gpu::format {
     using swc = gpu::texture::SwizzleChannel;
 
     constexpr Format R8G8B8A8Unorm{sizeof(u32), vkf::eR8G8B8A8Unorm};
+    constexpr Format B8G8R8A8Unorm{sizeof(u32), vkf::eB8G8R8A8Unorm};
     constexpr Format R5G6B5Unorm{sizeof(u16), vkf::eR5G6B5UnormPack16};
     constexpr Format A2B10G10R10Unorm{sizeof(u32), vkf::eA2B10G10R10UnormPack32};
     constexpr Format A8B8G8R8Srgb{sizeof(u32), vkf::eA8B8G8R8SrgbPack32};
@@ -23,6 +24,7 @@ namespace skyline::gpu::format {
     constexpr Format R16G16Float{sizeof(u32), vkf::eR16G16Sfloat};
     constexpr Format B10G11R11Float{sizeof(u32), vkf::eB10G11R11UfloatPack32};
     constexpr Format R32Float{sizeof(u32), vkf::eR32Sfloat};
+    constexpr Format R32G32Float{sizeof(u32) * 2, vkf::eR32G32Sfloat};
     constexpr Format R8G8Unorm{sizeof(u16), vkf::eR8G8Unorm};
     constexpr Format R8G8Snorm{sizeof(u16), vkf::eR8G8Snorm};
     constexpr Format R16Unorm{sizeof(u16), vkf::eR16Unorm};
@@ -35,11 +37,17 @@ namespace skyline::gpu::format {
         .blue = swc::Green,
         .green = swc::Blue,
     }};
+    constexpr Format R32G32B32A32Float{sizeof(u32) * 4, vkf::eR32G32B32A32Sfloat};
     constexpr Format R16G16B16A16Unorm{sizeof(u16) * 4, vkf::eR16G16B16A16Unorm};
     constexpr Format R16G16B16A16Snorm{sizeof(u16) * 4, vkf::eR16G16B16A16Snorm};
     constexpr Format R16G16B16A16Sint{sizeof(u16) * 4, vkf::eR16G16B16A16Sint};
     constexpr Format R16G16B16A16Uint{sizeof(u16) * 4, vkf::eR16G16B16A16Uint};
     constexpr Format R16G16B16A16Float{sizeof(u16) * 4, vkf::eR16G16B16A16Sfloat};
+    constexpr Format BC1Unorm{sizeof(u64), vkf::eBc1RgbaUnormBlock, .blockHeight = 4, .blockWidth = 4};
+    constexpr Format BC2Unorm{sizeof(u64) * 2, vkf::eBc2UnormBlock, .blockHeight = 4, .blockWidth = 4};
+    constexpr Format BC3Unorm{sizeof(u64) * 2, vkf::eBc3UnormBlock, .blockHeight = 4, .blockWidth = 4};
+    constexpr Format BC4Unorm{sizeof(u64), vkf::eBc4UnormBlock, .blockHeight = 4, .blockWidth = 4};
+    constexpr Format BC5Unorm{sizeof(u64) * 2, vkf::eBc5UnormBlock, .blockHeight = 4, .blockWidth = 4};
 
     /**
      * @brief Converts a Vulkan format to a Skyline format
@@ -48,6 +56,8 @@ namespace skyline::gpu::format {
         switch (format) {
             case vk::Format::eR8G8B8A8Unorm:
                 return R8G8B8A8Unorm;
+            case vk::Format::eB8G8R8A8Unorm:
+                return B8G8R8A8Unorm;
             case vk::Format::eR5G6B5UnormPack16:
                 return R5G6B5Unorm;
             case vk::Format::eA2B10G10R10UnormPack32:
@@ -70,6 +80,10 @@ namespace skyline::gpu::format {
                 return B10G11R11Float;
             case vk::Format::eR32Sfloat:
                 return format::R32Float;
+            case vk::Format::eR32G32Sfloat:
+                return R32G32Float;
+            case vk::Format::eR32G32B32A32Sfloat:
+                return R32G32B32A32Float;
             case vk::Format::eR16Unorm:
                 return R16Unorm;
             case vk::Format::eR16Sfloat:
@@ -96,6 +110,16 @@ namespace skyline::gpu::format {
                 return R16G16B16A16Uint;
             case vk::Format::eR16G16B16A16Sfloat:
                 return R16G16B16A16Float;
+            case vk::Format::eBc1RgbaUnormBlock:
+                return BC1Unorm;
+            case vk::Format::eBc2UnormBlock:
+                return BC2Unorm;
+            case vk::Format::eBc3UnormBlock:
+                return BC3Unorm;
+            case vk::Format::eBc4UnormBlock:
+                return BC4Unorm;
+            case vk::Format::eBc5UnormBlock:
+                return BC5Unorm;
             default:
                 throw exception("Vulkan format not supported: '{}'", vk::to_string(format));
         }
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "format_conversion_pass.h"
+#include "format.h"
+
+namespace skyline::gpu {
+    namespace {
+        constexpr u32 TextureFormatConversionSpirv[]{
+            #include "texture_format_conversion.comp.spv.inc"
+        };
+    }
+
+    FormatConversionPass::FormatConversionPass(GPU &gpu) : gpu(gpu),
+        descriptorSetLayout(gpu.descriptor.CreateSetLayout([] {
+            constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> bindings{
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 1,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+            };
+            return span<const vk::DescriptorSetLayoutBinding>(bindings);
+        }())),
+        pipelineLayout(gpu.vkDevice, [this] {
+            constexpr static vk::PushConstantRange pushConstantRange{
+                .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                .size = sizeof(PushConstants),
+            };
+            return vk::PipelineLayoutCreateInfo{
+                .setLayoutCount = 1,
+                .pSetLayouts = &*descriptorSetLayout.vkLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+        }()),
+        shaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(TextureFormatConversionSpirv),
+            .pCode = TextureFormatConversionSpirv,
+        }),
+        pipeline(gpu.vkDevice, gpu.pipelineCache.vkPipelineCache, vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = *shaderModule,
+                .pName = "main",
+            },
+            .layout = *pipelineLayout,
+        }) {}
+
+    texture::FormatConversion FormatConversionPass::GetConversion(texture::Format guestFormat, texture::Format &hostFormat) {
+        // Every conversion doubles the size of the texture, the shader relies on a single guest word always corresponding to two host words
+        switch (guestFormat->vkFormat) {
+            case vk::Format::eR16Unorm:
+                hostFormat = format::R32Float;
+                return texture::FormatConversion::Unorm16ToFloat32;
+            case vk::Format::eR16G16Unorm:
+                hostFormat = format::R32G32Float;
+                return texture::FormatConversion::Unorm16ToFloat32;
+            case vk::Format::eR16G16Snorm:
+                hostFormat = format::R32G32Float;
+                return texture::FormatConversion::Snorm16ToFloat32;
+            case vk::Format::eR16G16B16A16Unorm:
+                hostFormat = format::R32G32B32A32Float;
+                return texture::FormatConversion::Unorm16ToFloat32;
+            case vk::Format::eR16G16B16A16Snorm:
+                hostFormat = format::R32G32B32A32Float;
+                return texture::FormatConversion::Snorm16ToFloat32;
+            case vk::Format::eB10G11R11UfloatPack32:
+                hostFormat = format::R16G16B16A16Float;
+                return texture::FormatConversion::B10G11R11FloatToR16G16B16A16Float;
+            default:
+                return texture::FormatConversion::None;
+        }
+    }
+
+    void FormatConversionPass::Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &guestBuffer, const memory::StagingBuffer &hostBuffer, bool toGuest) {
+        TRACE_EVENT("gpu", "FormatConversionPass::Record");
+
+        PushConstants constants{
+            .conversion = conversion,
+            .guestWords = static_cast<u32>(guestBuffer.size() / sizeof(u32)),
+            .hostWords = static_cast<u32>(hostBuffer.size() / sizeof(u32)),
+            .toGuest = toGuest,
+        };
+
+        std::array<DescriptorAllocator::DescriptorInfo, 2> descriptors{
+            vk::DescriptorBufferInfo{
+                .buffer = guestBuffer.vkBuffer,
+                .offset = guestBuffer.offset,
+                .range = guestBuffer.size(),
+            },
+            vk::DescriptorBufferInfo{
+                .buffer = hostBuffer.vkBuffer,
+                .offset = hostBuffer.offset,
+                .range = hostBuffer.size(),
+            },
+        };
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        gpu.descriptor.Bind(commandBuffer, cycle, vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSetLayout, descriptors);
+        commandBuffer.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+        commandBuffer.dispatch(util::AlignUp(constants.guestWords, WorkgroupSize) / WorkgroupSize, 1, 1);
+    }
+
+    void FormatConversionPass::RecordToHost(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &guestBuffer, const memory::StagingBuffer &hostBuffer) {
+        Record(commandBuffer, cycle, conversion, guestBuffer, hostBuffer, false);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+            .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = hostBuffer.vkBuffer,
+            .offset = hostBuffer.offset,
+            .size = hostBuffer.size(),
+        }, {});
+    }
+
+    void FormatConversionPass::RecordToGuest(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &hostBuffer, const memory::StagingBuffer &guestBuffer) {
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = hostBuffer.vkBuffer,
+            .offset = hostBuffer.offset,
+            .size = hostBuffer.size(),
+        }, {});
+
+        Record(commandBuffer, cycle, conversion, guestBuffer, hostBuffer, true);
+
+        // The guest buffer may be swizzled by the swizzle pass afterwards rather than being read by the host directly
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eHost, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+            .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eHostRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = guestBuffer.vkBuffer,
+            .offset = guestBuffer.offset,
+            .size = guestBuffer.size(),
+        }, {});
+    }
+}
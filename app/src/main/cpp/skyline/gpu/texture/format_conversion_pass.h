@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/memory_manager.h>
+#include <gpu/descriptor_allocator.h>
+#include "texture.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief A compute pass which converts linear texture data between a guest format and the host format it's converted into, this avoids converting every synchronization on the CPU
+     * @note This class is thread-safe as it can be recorded into command buffers from several threads
+     */
+    class FormatConversionPass {
+      private:
+        /**
+         * @note This must match the push constant block in texture_format_conversion.comp
+         */
+        struct PushConstants {
+            texture::FormatConversion conversion;
+            u32 guestWords;
+            u32 hostWords;
+            u32 toGuest;
+        };
+
+        static constexpr u32 WorkgroupSize{64}; //!< The amount of invocations in a workgroup, this must match 'local_size_x' in the shader
+
+        GPU &gpu;
+        DescriptorAllocator::SetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::ShaderModule shaderModule;
+        vk::raii::Pipeline pipeline;
+
+        void Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &guestBuffer, const memory::StagingBuffer &hostBuffer, bool toGuest);
+
+      public:
+        FormatConversionPass(GPU &gpu);
+
+        /**
+         * @brief Picks a host format for a guest format which the host GPU can't render to
+         * @param hostFormat This is set to the host format which the guest format is converted into, it's left untouched if there's no conversion
+         * @return The conversion between the formats, this is None if the guest format can't be converted
+         * @note The host format must still be checked for support by the caller, it's only guaranteed to be supported by conformant drivers
+         */
+        static texture::FormatConversion GetConversion(texture::Format guestFormat, texture::Format &hostFormat);
+
+        /**
+         * @return The size of a buffer holding a texture of the supplied size in the guest format, it's padded to a whole amount of words as the shader operates on words
+         */
+        static vk::DeviceSize GetGuestBufferSize(vk::DeviceSize size) {
+            return util::AlignUp(size, sizeof(u32));
+        }
+
+        /**
+         * @brief Records a conversion of a buffer in the guest format into a buffer in the host format which can be copied into the texture
+         * @note This includes a barrier which makes the host buffer available for transfer operations
+         */
+        void RecordToHost(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &guestBuffer, const memory::StagingBuffer &hostBuffer);
+
+        /**
+         * @brief Records a conversion of a buffer in the host format which was copied from the texture into a buffer in the guest format
+         * @note This includes barriers which order it after transfers into the host buffer and make the guest buffer available to the host and subsequent compute passes
+         */
+        void RecordToGuest(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, texture::FormatConversion conversion, const memory::StagingBuffer &hostBuffer, const memory::StagingBuffer &guestBuffer);
+    };
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "swizzle_pass.h"
+
+namespace skyline::gpu {
+    namespace {
+        constexpr u32 BlockLinearCopySpirv[]{
+            #include "block_linear_copy.comp.spv.inc"
+        };
+
+        constexpr u32 SectorSize{16}; //!< The size of a sector in bytes, the shader copies a sector per invocation
+        constexpr u32 GobWidth{64}; //!< The width of a GOB in bytes
+
+        /**
+         * @return The width of a ROB of the supplied texture in bytes
+         */
+        u32 GetRobWidthBytes(const GuestTexture &guest) {
+            return util::AlignUp((guest.dimensions.width / guest.format->blockWidth) * guest.format->bpb, GobWidth);
+        }
+    }
+
+    SwizzlePass::SwizzlePass(GPU &gpu) : gpu(gpu),
+        descriptorSetLayout(gpu.descriptor.CreateSetLayout([] {
+            constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> bindings{
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+                vk::DescriptorSetLayoutBinding{
+                    .binding = 1,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                },
+            };
+            return span<const vk::DescriptorSetLayoutBinding>(bindings);
+        }())),
+        pipelineLayout(gpu.vkDevice, [this] {
+            constexpr static vk::PushConstantRange pushConstantRange{
+                .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                .size = sizeof(PushConstants),
+            };
+            return vk::PipelineLayoutCreateInfo{
+                .setLayoutCount = 1,
+                .pSetLayouts = &*descriptorSetLayout.vkLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            };
+        }()),
+        shaderModule(gpu.vkDevice, vk::ShaderModuleCreateInfo{
+            .codeSize = sizeof(BlockLinearCopySpirv),
+            .pCode = BlockLinearCopySpirv,
+        }),
+        pipeline(gpu.vkDevice, gpu.pipelineCache.vkPipelineCache, vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = *shaderModule,
+                .pName = "main",
+            },
+            .layout = *pipelineLayout,
+        }) {}
+
+    bool SwizzlePass::IsSupported(const GuestTexture &guest) {
+        // The linear buffer is tightly packed while the shader writes it with a pitch of a ROB, these must be equivalent
+        // We also don't handle 3D textures or array layers as the block depth and layer stride aren't accounted for
+        return guest.tileConfig.mode == texture::TileMode::Block && guest.mappings.size() == 1 && guest.dimensions.depth == 1 && guest.layerCount == 1 && guest.levelCount == 1 && GetRobWidthBytes(guest) == (guest.dimensions.width / guest.format->blockWidth) * guest.format->bpb && util::IsAligned(guest.mappings[0].size(), SectorSize);
+    }
+
+    void SwizzlePass::Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &blockLinearBuffer, const memory::StagingBuffer &linearBuffer, bool swizzle) {
+        TRACE_EVENT("gpu", "SwizzlePass::Record");
+
+        auto robWidthBytes{GetRobWidthBytes(guest)};
+        PushConstants constants{
+            .pitch = robWidthBytes,
+            .blockHeight = guest.tileConfig.blockHeight,
+            .robWidthBlocks = robWidthBytes / GobWidth,
+            .surfaceHeight = guest.dimensions.height / guest.format->blockHeight,
+            .blockLinearSectors = static_cast<u32>(guest.mappings[0].size() / SectorSize),
+            .linearSectors = static_cast<u32>(guest.format->GetSize(guest.dimensions) / SectorSize),
+            .swizzle = swizzle,
+        };
+
+        std::array<DescriptorAllocator::DescriptorInfo, 2> descriptors{
+            vk::DescriptorBufferInfo{
+                .buffer = blockLinearBuffer.vkBuffer,
+                .offset = blockLinearBuffer.offset,
+                .range = blockLinearBuffer.size(),
+            },
+            vk::DescriptorBufferInfo{
+                .buffer = linearBuffer.vkBuffer,
+                .offset = linearBuffer.offset,
+                .range = linearBuffer.size(),
+            },
+        };
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        gpu.descriptor.Bind(commandBuffer, cycle, vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSetLayout, descriptors);
+        commandBuffer.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+        commandBuffer.dispatch(util::AlignUp(constants.blockLinearSectors, WorkgroupSize) / WorkgroupSize, 1, 1);
+    }
+
+    void SwizzlePass::RecordDeswizzle(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &blockLinearBuffer, const memory::StagingBuffer &linearBuffer) {
+        Record(commandBuffer, cycle, guest, blockLinearBuffer, linearBuffer, false);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+            .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = linearBuffer.vkBuffer,
+            .offset = linearBuffer.offset,
+            .size = linearBuffer.size(),
+        }, {});
+    }
+
+    void SwizzlePass::RecordSwizzle(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &linearBuffer, const memory::StagingBuffer &blockLinearBuffer) {
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = linearBuffer.vkBuffer,
+            .offset = linearBuffer.offset,
+            .size = linearBuffer.size(),
+        }, {});
+
+        Record(commandBuffer, cycle, guest, blockLinearBuffer, linearBuffer, true);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eHost, {}, {}, vk::BufferMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+            .dstAccessMask = vk::AccessFlagBits::eHostRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = blockLinearBuffer.vkBuffer,
+            .offset = blockLinearBuffer.offset,
+            .size = blockLinearBuffer.size(),
+        }, {});
+    }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/memory_manager.h>
+#include <gpu/descriptor_allocator.h>
+
+namespace skyline::gpu {
+    class GPU;
+    struct GuestTexture;
+
+    /**
+     * @brief A compute pass which copies between blocklinear guest texture data and linear data on the host GPU, this avoids (de)swizzling large textures on the CPU
+     * @note This class is thread-safe as it can be recorded into command buffers from several threads
+     */
+    class SwizzlePass {
+      private:
+        /**
+         * @note This must match the push constant block in block_linear_copy.comp
+         */
+        struct PushConstants {
+            u32 pitch;
+            u32 blockHeight;
+            u32 robWidthBlocks;
+            u32 surfaceHeight;
+            u32 blockLinearSectors;
+            u32 linearSectors;
+            u32 swizzle;
+        };
+
+        static constexpr u32 WorkgroupSize{64}; //!< The amount of invocations in a workgroup, this must match 'local_size_x' in the shader
+
+        GPU &gpu;
+        DescriptorAllocator::SetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::ShaderModule shaderModule;
+        vk::raii::Pipeline pipeline;
+
+        void Record(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &blockLinearBuffer, const memory::StagingBuffer &linearBuffer, bool swizzle);
+
+      public:
+        SwizzlePass(GPU &gpu);
+
+        /**
+         * @return If the supplied guest texture can be (de)swizzled by this pass, any unsupported textures must be (de)swizzled on the CPU
+         */
+        static bool IsSupported(const GuestTexture &guest);
+
+        /**
+         * @brief Records a deswizzle of the contents of a buffer holding blocklinear guest texture data into a linear buffer which can be copied into the texture
+         * @note This includes a barrier which makes the linear buffer available for transfer operations
+         */
+        void RecordDeswizzle(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &blockLinearBuffer, const memory::StagingBuffer &linearBuffer);
+
+        /**
+         * @brief Records a swizzle of the contents of a linear buffer which was copied from the texture into a buffer holding blocklinear guest texture data
+         * @note This includes barriers which order it after transfers into the linear buffer and make the blocklinear buffer available to the host
+         */
+        void RecordSwizzle(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const GuestTexture &guest, const memory::StagingBuffer &linearBuffer, const memory::StagingBuffer &blockLinearBuffer);
+    };
+}
@@ -1,36 +1,88 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#define XXH_INLINE_ALL
+#include <bit>
+#include <xxhash.h>
 #include <gpu.h>
 #include <common/trace.h>
 #include <kernel/types/KProcess.h>
 #include "texture.h"
+#include "format.h"
 #include "copy.h"
+#include "bc_decoder.h"
 
 namespace skyline::gpu {
-    std::shared_ptr<memory::StagingBuffer> Texture::SynchronizeHostImpl(const std::shared_ptr<FenceCycle> &pCycle) {
+    std::shared_ptr<memory::StagingBuffer> Texture::SynchronizeHostImpl(const std::shared_ptr<FenceCycle> &pCycle, std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer, std::vector<vk::BufferImageCopy> &copyRegions, std::shared_ptr<memory::StagingBuffer> &conversionBuffer) {
         if (!guest)
             throw exception("Synchronization of host textures requires a valid guest texture to synchronize from");
-        else if (guest->dimensions != dimensions)
-            throw exception("Guest and host dimensions being different is not supported currently");
         else if (guest->mappings.size() > 1)
             throw exception("Synchronizing textures across {} mappings is not supported", guest->mappings.size());
 
-        auto pointer{guest->mappings[0].data()};
-        auto size{format->GetSize(dimensions)};
+        if (trap && !trap->dirty.load(std::memory_order_acquire))
+            return nullptr; // The guest texture hasn't been written to by the CPU since it was last synchronized, the host texture is already up to date
+
+        auto size{GetHostBufferSize()};
 
         WaitOnBacking();
+        std::vector<u64> dirtyPages;
+        if (trap)
+            dirtyPages = gpu.writeTracker.Protect(*trap); // The trap must be protected before the guest texture is read from, any writes during the read will dirty it again
+
+        // Only the initial upload is indexed by its contents as hashing would otherwise negate the benefit of partial uploads, the host texture no longer matches any prior hash after this
+        contentHash.store(0, std::memory_order_relaxed);
+        if (layout == vk::ImageLayout::eUndefined && trap)
+            gpu.texture.IndexContents(shared_from_this());
+
+        // Only the dirty blocks are uploaded if the host texture already holds the rest of the guest texture, this requires a staging buffer as the copy is done with multiple regions
+        if (!dirtyPages.empty() && layout != vk::ImageLayout::eUndefined && (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) && CanSynchronizePartially()) {
+            if (auto stagingBuffer{CopyDirtyBlocksFromGuest(dirtyPages, copyRegions)}) {
+                WaitOnFence(pCycle);
+                return stagingBuffer;
+            }
+        }
+
+        if (HasSubresources()) {
+            // Only the subresources overlapping dirty pages are uploaded if the host texture already holds the rest, scaled textures are excluded as their intermediate image doesn't retain its contents
+            auto subresources{GetGuestSubresources()};
+            bool partial{!dirtyPages.empty() && layout != vk::ImageLayout::eUndefined && !IsScaled()};
+            if (partial)
+                FilterDirtySubresources(subresources, dirtyPages);
+            if (subresources.empty())
+                return nullptr; // Only padding between subresources was written to
+
+            auto stagingBuffer{AllocateStagingBuffer(subresources.back().hostOffset + subresources.back().hostSize)};
+            for (auto &subresource : subresources)
+                CopyFromGuestSubresource(subresource.guest, stagingBuffer->data() + subresource.hostOffset);
+
+            // Scaled textures only have a single level, all of their layers are tightly packed which matches the layout of a single copy covering all of them
+            if (!IsScaled())
+                copyRegions = GetSubresourceCopies(subresources, stagingBuffer->offset);
+
+            WaitOnFence(pCycle);
+            return stagingBuffer;
+        }
+
+        if (IsConverted()) {
+            // The guest texture is copied into a buffer in the guest format which the format conversion pass converts into the staging buffer, it's always deswizzled on the CPU as the passes aren't chained
+            conversionBuffer = gpu.memory.AllocateRingStagingBuffer(FormatConversionPass::GetGuestBufferSize(guest->format->GetSize(guest->dimensions)));
+            CopyFromGuest(conversionBuffer->data(), 0, false, blockLinearBuffer);
+            auto stagingBuffer{AllocateStagingBuffer(size)};
+            WaitOnFence(pCycle);
+            return stagingBuffer;
+        }
 
         u8 *bufferData;
+        vk::DeviceSize bufferPitch{}; //!< The pitch of the lines in the buffer, this is only non-zero when it isn't tightly packed
         auto stagingBuffer{[&]() -> std::shared_ptr<memory::StagingBuffer> {
             if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
                 // We need a staging buffer for all optimal copies (since we aren't aware of the host optimal layout) and linear textures which we cannot map on the CPU since we do not have access to their backing VkDeviceMemory
-                auto stagingBuffer{gpu.memory.AllocateStagingBuffer(size)};
+                auto stagingBuffer{AllocateStagingBuffer(size)};
                 bufferData = stagingBuffer->data();
                 return stagingBuffer;
             } else if (tiling == vk::ImageTiling::eLinear) {
                 // We can optimize linear texture sync on a UMA by mapping the texture onto the CPU and copying directly into it rather than a staging buffer
-                bufferData = std::get<memory::Image>(backing).data();
+                bufferData = GetMappedBacking(bufferPitch);
                 if (cycle.lock() != pCycle)
                     WaitOnFence();
                 return nullptr;
@@ -39,20 +91,245 @@ namespace skyline::gpu {
             }
         }()};
 
-        if (guest->tileConfig.mode == texture::TileMode::Block)
-            CopyBlockLinearToLinear(*guest, pointer, bufferData);
-        else if (guest->tileConfig.mode == texture::TileMode::Pitch)
-            CopyPitchLinearToLinear(*guest, pointer, bufferData);
-        else if (guest->tileConfig.mode == texture::TileMode::Linear)
-            std::memcpy(bufferData, pointer, size);
+        CopyFromGuest(bufferData, bufferPitch, stagingBuffer != nullptr, blockLinearBuffer);
+
+        if (stagingBuffer)
+            WaitOnFence(pCycle);
+
+        return stagingBuffer;
+    }
+
+    bool Texture::CanSynchronizePartially() const {
+        return guest && guest->mappings.size() == 1 && guest->tileConfig.mode == texture::TileMode::Block && guest->tileConfig.blockDepth == 1 &&
+            !IsTranscoded() && !IsConverted() && !IsScaled() && mipLevels == 1 && layerCount == 1 && dimensions.depth == 1 && guest->dimensions == dimensions &&
+            (detail::GobWidth % guest->format->bpb) == 0; // Blocks must contain a whole amount of texels for them to be uploaded individually
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Texture::CopyDirtyBlocksFromGuest(span<const u64> dirtyPages, std::vector<vk::BufferImageCopy> &copyRegions) {
+        TRACE_EVENT("gpu", "Texture::CopyDirtyBlocksFromGuest");
+
+        detail::BlockLinearLayout blockLayout{*guest};
+        if (blockLayout.surfaceHeight % detail::GobHeight)
+            return nullptr; // Partial GOBs at the bottom of the texture aren't handled by the block walk
+
+        // Every dirty page is mapped to the range of blocks it overlaps, blocks in guest memory are contiguous and always contain the full amount of GOBs
+        auto mapping{guest->mappings[0]};
+        size_t mappingOffset{static_cast<size_t>(mapping.data() - trap->region.data())}; //!< The offset of the guest texture from the start of the page-aligned trap region
+        size_t blockBytes{static_cast<size_t>(blockLayout.blockHeight) * detail::GobSize};
+        size_t blockCount{static_cast<size_t>(blockLayout.surfaceHeightRobs) * blockLayout.robWidthBlocks};
+        std::vector<bool> dirtyBlocks(blockCount);
+        size_t dirtyBlockCount{};
+        for (size_t index{}; index < dirtyPages.size(); index++) {
+            for (u64 word{dirtyPages[index]}; word; word &= word - 1) {
+                size_t pageStart{(index * 64 + static_cast<size_t>(std::countr_zero(word))) * PAGE_SIZE}, pageEnd{pageStart + PAGE_SIZE};
+                if (pageEnd <= mappingOffset)
+                    continue;
 
-        if (stagingBuffer && cycle.lock() != pCycle)
-            WaitOnFence();
+                size_t start{pageStart > mappingOffset ? pageStart - mappingOffset : 0}, end{std::min(pageEnd - mappingOffset, blockCount * blockBytes)};
+                for (size_t block{start / blockBytes}; block < util::AlignUp(end, blockBytes) / blockBytes; block++) {
+                    if (!dirtyBlocks[block]) {
+                        dirtyBlocks[block] = true;
+                        dirtyBlockCount++;
+                    }
+                }
+            }
+        }
+
+        // Partial uploads are only worthwhile while most of the texture is clean, deswizzling the entire texture is cheaper than an excessive amount of regions otherwise
+        if (!dirtyBlockCount || dirtyBlockCount * 2 > blockCount)
+            return nullptr;
+
+        struct Run {
+            u32 rob;
+            u32 firstBlock;
+            u32 blockCount;
+            u32 lines; //!< The amount of lines in the ROB which aren't padding
+        };
+        std::vector<Run> runs;
+        size_t stagingSize{};
+        for (u32 rob{}; rob < blockLayout.surfaceHeightRobs; rob++) {
+            u32 lines{std::min(blockLayout.robHeight, blockLayout.surfaceHeight - (rob * blockLayout.robHeight))};
+            for (u32 block{}; block < blockLayout.robWidthBlocks; block++) {
+                if (!dirtyBlocks[static_cast<size_t>(rob) * blockLayout.robWidthBlocks + block])
+                    continue;
+
+                if (!runs.empty() && runs.back().rob == rob && runs.back().firstBlock + runs.back().blockCount == block)
+                    runs.back().blockCount++;
+                else
+                    runs.push_back(Run{rob, block, 1, lines});
+                stagingSize += static_cast<size_t>(detail::GobWidth) * lines;
+            }
+        }
+
+        auto stagingBuffer{AllocateStagingBuffer(stagingSize)};
+        u32 texelsPerBlock{(detail::GobWidth / guest->format->bpb) * guest->format->blockWidth}, linesToTexels{guest->format->blockHeight};
+        copyRegions.reserve(runs.size());
+        vk::DeviceSize stagingOffset{};
+        for (const auto &run : runs) {
+            u32 pitch{run.blockCount * detail::GobWidth};
+            u8 *linear{stagingBuffer->data() + stagingOffset};
+            for (u32 block{}; block < run.blockCount; block++) {
+                auto guestBlock{mapping.data() + ((static_cast<size_t>(run.rob) * blockLayout.robWidthBlocks) + run.firstBlock + block) * blockBytes};
+                for (u32 gobY{}; gobY < run.lines / detail::GobHeight; gobY++)
+                    detail::DeswizzleGob(guestBlock + (gobY * detail::GobSize), linear + (gobY * detail::GobHeight * pitch) + (block * detail::GobWidth), pitch);
+            }
+
+            u32 x{run.firstBlock * texelsPerBlock}, y{run.rob * blockLayout.robHeight * linesToTexels};
+            copyRegions.push_back(vk::BufferImageCopy{
+                .bufferOffset = stagingBuffer->offset + stagingOffset,
+                .bufferRowLength = run.blockCount * texelsPerBlock,
+                .bufferImageHeight = run.lines * linesToTexels,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .layerCount = 1,
+                },
+                .imageOffset = {static_cast<i32>(x), static_cast<i32>(y), 0},
+                .imageExtent = {std::min(run.blockCount * texelsPerBlock, dimensions.width - x), std::min(run.lines * linesToTexels, dimensions.height - y), 1},
+            });
+            stagingOffset += static_cast<vk::DeviceSize>(pitch) * run.lines;
+        }
 
         return stagingBuffer;
     }
 
-    void Texture::CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer) {
+    std::vector<Texture::GuestSubresource> Texture::GetGuestSubresources() const {
+        std::vector<GuestSubresource> subresources;
+        subresources.reserve(static_cast<size_t>(guest->levelCount) * guest->layerCount);
+        vk::DeviceSize hostOffset{};
+        for (u32 layer{}; layer < guest->layerCount; layer++) {
+            for (u32 level{}; level < guest->levelCount; level++) {
+                auto subresource{guest->GetSubresource(level, layer)};
+                vk::Extent3D extent{std::max(dimensions.width >> level, 1U), std::max(dimensions.height >> level, 1U), std::max(dimensions.depth >> level, 1U)};
+                auto hostSize{format->GetSize(subresource.dimensions)};
+                subresources.push_back(GuestSubresource{std::move(subresource), level, layer, extent, hostOffset, hostSize});
+                hostOffset += hostSize;
+            }
+        }
+        return subresources;
+    }
+
+    vk::DeviceSize Texture::GetHostBufferSize() const {
+        if (!HasSubresources())
+            return format->GetSize(guest->dimensions);
+
+        vk::DeviceSize size{};
+        for (u32 level{}; level < guest->levelCount; level++)
+            size += format->GetSize(guest->GetLevelDimensions(level));
+        return size * guest->layerCount;
+    }
+
+    void Texture::FilterDirtySubresources(std::vector<GuestSubresource> &subresources, span<const u64> dirtyPages) const {
+        auto isPageDirty{[&](size_t page) {
+            return (page / 64) < dirtyPages.size() && (dirtyPages[page / 64] & (1ULL << (page % 64)));
+        }};
+
+        vk::DeviceSize hostOffset{};
+        std::erase_if(subresources, [&](GuestSubresource &subresource) {
+            auto mapping{subresource.guest.mappings[0]};
+            size_t start{static_cast<size_t>(mapping.data() - trap->region.data())}, end{start + mapping.size()};
+            bool dirty{};
+            for (size_t page{start / PAGE_SIZE}; page < util::AlignUp(end, PAGE_SIZE) / PAGE_SIZE && !dirty; page++)
+                dirty = isPageDirty(page);
+
+            if (dirty) {
+                subresource.hostOffset = hostOffset;
+                hostOffset += subresource.hostSize;
+            }
+            return !dirty;
+        });
+    }
+
+    std::vector<vk::BufferImageCopy> Texture::GetSubresourceCopies(span<const GuestSubresource> subresources, vk::DeviceSize bufferOffset) const {
+        std::vector<vk::BufferImageCopy> copies;
+        copies.reserve(subresources.size());
+        for (const auto &subresource : subresources)
+            copies.push_back(vk::BufferImageCopy{
+                .bufferOffset = bufferOffset + subresource.hostOffset,
+                .bufferRowLength = subresource.guest.dimensions.width, // The guest dimensions of levels are padded to entire blocks unlike their extent
+                .bufferImageHeight = subresource.guest.dimensions.height,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .mipLevel = subresource.level,
+                    .baseArrayLayer = subresource.layer,
+                    .layerCount = 1,
+                },
+                .imageExtent = subresource.extent,
+            });
+        return copies;
+    }
+
+    void Texture::CopyFromGuestSubresource(GuestTexture &subresource, u8 *output) {
+        auto pointer{subresource.mappings[0].data()};
+        if (IsTranscoded())
+            DecodeGuest(subresource, output);
+        else if (subresource.tileConfig.mode == texture::TileMode::Block)
+            CopyBlockLinearToLinear(subresource, pointer, output, &gpu.copyPool);
+        else if (subresource.tileConfig.mode == texture::TileMode::Pitch)
+            CopyPitchLinearToLinear(subresource, pointer, output);
+        else if (subresource.tileConfig.mode == texture::TileMode::Linear)
+            std::memcpy(output, pointer, subresource.format->GetSize(subresource.dimensions));
+    }
+
+    void Texture::CopyFromGuest(u8 *bufferData, vk::DeviceSize bufferPitch, bool isStagingBuffer, std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer) {
+        if (HasSubresources()) {
+            for (auto &subresource : GetGuestSubresources())
+                CopyFromGuestSubresource(subresource.guest, bufferData + subresource.hostOffset);
+            return;
+        }
+
+        auto pointer{guest->mappings[0].data()};
+        if (IsTranscoded()) {
+            DecodeGuest(*guest, bufferData);
+        } else if (guest->tileConfig.mode == texture::TileMode::Block) {
+            if (isStagingBuffer && SwizzlePass::IsSupported(*guest)) {
+                // The deswizzle is deferred to a compute pass on the host GPU, we only need to copy the raw guest data into a buffer it can access
+                blockLinearBuffer = gpu.memory.AllocateRingStagingBuffer(guest->mappings[0].size());
+                std::memcpy(blockLinearBuffer->data(), pointer, guest->mappings[0].size());
+            } else {
+                CopyBlockLinearToLinear(*guest, pointer, bufferData, &gpu.copyPool);
+            }
+        } else if (guest->tileConfig.mode == texture::TileMode::Pitch) {
+            CopyPitchLinearToLinear(*guest, pointer, bufferData, bufferPitch);
+        } else if (guest->tileConfig.mode == texture::TileMode::Linear) {
+            if (bufferPitch)
+                CopyLines(*guest, pointer, guest->format->GetSize(guest->dimensions.width, 1), bufferData, bufferPitch);
+            else
+                std::memcpy(bufferData, pointer, guest->format->GetSize(guest->dimensions));
+        }
+    }
+
+    void Texture::DecodeGuest(GuestTexture &source, u8 *output) {
+        TRACE_EVENT("gpu", "Texture::DecodeGuest");
+
+        auto pointer{source.mappings[0].data()};
+        auto key{source.GetContentHash()};
+
+        span<u8> decoded(output, format->GetSize(source.dimensions));
+        if (gpu.decodeCache.Load(key, decoded))
+            return;
+
+        const u8 *linear{pointer};
+        std::vector<u8> deswizzled;
+        if (source.tileConfig.mode != texture::TileMode::Linear) {
+            deswizzled.resize(source.format->GetSize(source.dimensions));
+            if (source.tileConfig.mode == texture::TileMode::Block)
+                CopyBlockLinearToLinear(source, pointer, deswizzled.data(), &gpu.copyPool);
+            else
+                CopyPitchLinearToLinear(source, pointer, deswizzled.data());
+            linear = deswizzled.data();
+        }
+
+        texture::bcn::Decode(*source.format, linear, output, source.dimensions.width, source.dimensions.height * source.dimensions.depth);
+        gpu.decodeCache.Store(key, decoded);
+    }
+
+    void Texture::CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, const std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer, span<const vk::BufferImageCopy> copyRegions, const std::shared_ptr<memory::StagingBuffer> &conversionBuffer) {
+        if (blockLinearBuffer)
+            gpu.swizzlePass.RecordDeswizzle(commandBuffer, pCycle, *guest, *blockLinearBuffer, *stagingBuffer);
+        else if (conversionBuffer)
+            gpu.formatConversionPass.RecordToHost(commandBuffer, pCycle, conversion, *conversionBuffer, *stagingBuffer);
+
+        RecordDeferredLayout(commandBuffer);
         auto image{GetBacking()};
         if (layout == vk::ImageLayout::eUndefined)
             commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
@@ -70,7 +347,55 @@ namespace skyline::gpu {
                 },
             });
 
+        if (IsScaled()) {
+            // The guest texture is uploaded at its own resolution and then scaled into the backing, any prior blit from the guest resolution image must be done before it's overwritten
+            auto guestImage{guestResolutionImage->vkImage};
+            vk::ImageSubresourceRange subresource{
+                .aspectMask = format->vkAspect,
+                .levelCount = 1,
+                .layerCount = layerCount,
+            };
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = guestImage,
+                .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .oldLayout = vk::ImageLayout::eUndefined,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+
+            commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, guestImage, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy{
+                .bufferOffset = stagingBuffer->offset,
+                .imageExtent = guest->dimensions,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .layerCount = layerCount,
+                },
+            });
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = guestImage,
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+
+            commandBuffer.blitImage(guestImage, vk::ImageLayout::eTransferSrcOptimal, image, layout, GetScaledBlit(true), scaleFilter);
+            return;
+        }
+
+        if (!copyRegions.empty()) {
+            commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, image, layout, vk::ArrayProxy<const vk::BufferImageCopy>(static_cast<u32>(copyRegions.size()), copyRegions.data()));
+            return;
+        }
+
         commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, image, layout, vk::BufferImageCopy{
+            .bufferOffset = stagingBuffer->offset,
             .imageExtent = dimensions,
             .imageSubresource = {
                 .aspectMask = format->vkAspect,
@@ -79,7 +404,59 @@ namespace skyline::gpu {
         });
     }
 
+    bool Texture::CanUploadOnTransferQueue() const {
+        // Scaled or multi-level uploads require blits, converted uploads require a compute pass and depth/stencil copies require a graphics queue
+        return gpu.scheduler.HasTransferQueue() && !IsScaled() && !IsConverted() && mipLevels == 1 && format->vkAspect == vk::ImageAspectFlagBits::eColor;
+    }
+
+    void Texture::CopyFromStagingBufferOnTransferQueue(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer) {
+        auto image{GetBacking()};
+        vk::ImageSubresourceRange subresource{
+            .aspectMask = format->vkAspect,
+            .levelCount = 1,
+            .layerCount = layerCount,
+        };
+
+        // The prior contents of the backing are entirely overwritten, it can be used by the transfer queue family without ownership being released to it
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+            .image = image,
+            .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eTransferDstOptimal,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .subresourceRange = subresource,
+        });
+
+        commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, image, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy{
+            .bufferOffset = stagingBuffer->offset,
+            .imageExtent = dimensions,
+            .imageSubresource = {
+                .aspectMask = format->vkAspect,
+                .layerCount = layerCount,
+            },
+        });
+
+        if (layout == vk::ImageLayout::eUndefined || layout == vk::ImageLayout::ePreinitialized)
+            layout = vk::ImageLayout::eGeneral;
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, vk::ImageMemoryBarrier{
+            .image = image,
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+            .newLayout = layout,
+            .srcQueueFamilyIndex = gpu.vkTransferQueueFamilyIndex,
+            .dstQueueFamilyIndex = gpu.vkQueueFamilyIndex,
+            .subresourceRange = subresource,
+        });
+
+        // The acquire must be recorded with the same layouts as the release
+        backingLayout = vk::ImageLayout::eTransferDstOptimal;
+        acquireQueueFamily = gpu.vkTransferQueueFamilyIndex;
+    }
+
     void Texture::CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer) {
+        RecordDeferredLayout(commandBuffer);
         auto image{GetBacking()};
         commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
             .image = image,
@@ -96,13 +473,58 @@ namespace skyline::gpu {
             },
         });
 
-        commandBuffer.copyImageToBuffer(image, layout, stagingBuffer->vkBuffer, vk::BufferImageCopy{
-            .imageExtent = dimensions,
-            .imageSubresource = {
+        if (IsScaled()) {
+            // The backing is downscaled to the guest resolution before being read back as the guest expects the texture at its own resolution
+            auto guestImage{guestResolutionImage->vkImage};
+            vk::ImageSubresourceRange subresource{
                 .aspectMask = format->vkAspect,
+                .levelCount = 1,
                 .layerCount = layerCount,
-            },
-        });
+            };
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = guestImage,
+                .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .oldLayout = vk::ImageLayout::eUndefined,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+
+            commandBuffer.blitImage(image, layout, guestImage, vk::ImageLayout::eTransferDstOptimal, GetScaledBlit(false), scaleFilter);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = guestImage,
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+
+            commandBuffer.copyImageToBuffer(guestImage, vk::ImageLayout::eTransferSrcOptimal, stagingBuffer->vkBuffer, vk::BufferImageCopy{
+                .bufferOffset = stagingBuffer->offset,
+                .imageExtent = guest->dimensions,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .layerCount = layerCount,
+                },
+            });
+        } else if (HasSubresources()) {
+            auto copies{GetSubresourceCopies(GetGuestSubresources(), stagingBuffer->offset)};
+            commandBuffer.copyImageToBuffer(image, layout, stagingBuffer->vkBuffer, vk::ArrayProxy<const vk::BufferImageCopy>(static_cast<u32>(copies.size()), copies.data()));
+        } else {
+            commandBuffer.copyImageToBuffer(image, layout, stagingBuffer->vkBuffer, vk::BufferImageCopy{
+                .bufferOffset = stagingBuffer->offset,
+                .imageExtent = dimensions,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .layerCount = layerCount,
+                },
+            });
+        }
 
         commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, vk::BufferMemoryBarrier{
             .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
@@ -110,27 +532,221 @@ namespace skyline::gpu {
             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .buffer = stagingBuffer->vkBuffer,
-            .offset = 0,
+            .offset = stagingBuffer->offset,
             .size = stagingBuffer->size(),
         }, {});
     }
 
-    void Texture::CopyToGuest(u8 *hostBuffer) {
+    std::shared_ptr<memory::StagingBuffer> Texture::ConvertStagingBufferToGuest(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, std::shared_ptr<memory::StagingBuffer> stagingBuffer, bool persistent) {
+        if (!IsConverted())
+            return stagingBuffer;
+
+        auto guestSize{FormatConversionPass::GetGuestBufferSize(guest->format->GetSize(guest->dimensions))};
+        auto guestBuffer{persistent ? gpu.memory.AllocateStagingBuffer(guestSize) : gpu.memory.AllocateRingStagingBuffer(guestSize)};
+        gpu.formatConversionPass.RecordToGuest(commandBuffer, pCycle, conversion, *stagingBuffer, *guestBuffer);
+        pCycle->AttachObject(stagingBuffer);
+        return guestBuffer;
+    }
+
+    vk::ImageBlit Texture::GetScaledBlit(bool toBacking) const {
+        vk::ImageSubresourceLayers subresource{
+            .aspectMask = format->vkAspect,
+            .layerCount = layerCount,
+        };
+        std::array<vk::Offset3D, 2> guestOffsets{vk::Offset3D{}, vk::Offset3D{static_cast<i32>(guest->dimensions.width), static_cast<i32>(guest->dimensions.height), 1}};
+        std::array<vk::Offset3D, 2> hostOffsets{vk::Offset3D{}, vk::Offset3D{static_cast<i32>(dimensions.width), static_cast<i32>(dimensions.height), 1}};
+        return vk::ImageBlit{
+            .srcSubresource = subresource,
+            .srcOffsets = toBacking ? guestOffsets : hostOffsets,
+            .dstSubresource = subresource,
+            .dstOffsets = toBacking ? hostOffsets : guestOffsets,
+        };
+    }
+
+    vk::Rect2D Texture::ScaleRect(vk::Rect2D rect) const {
+        if (!IsScaled())
+            return rect;
+
+        // The edges are scaled rather than the extent so adjacent rectangles still line up after rounding
+        auto scaleEdge{[this](i64 edge, u32 limit) {
+            return static_cast<i32>(std::clamp<i64>(static_cast<i64>(std::lround(static_cast<double>(edge) * resolutionScale)), 0, limit));
+        }};
+        auto left{scaleEdge(rect.offset.x, dimensions.width)}, right{scaleEdge(static_cast<i64>(rect.offset.x) + rect.extent.width, dimensions.width)};
+        auto top{scaleEdge(rect.offset.y, dimensions.height)}, bottom{scaleEdge(static_cast<i64>(rect.offset.y) + rect.extent.height, dimensions.height)};
+        return vk::Rect2D{
+            .offset = {left, top},
+            .extent = {static_cast<u32>(right - left), static_cast<u32>(bottom - top)},
+        };
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Texture::AllocateStagingBuffer(vk::DeviceSize size) {
+        // Suballocations of the staging ring aren't aligned to the block size of formats with a non power of two block size, which is required for buffer <-> image copies
+        if (std::has_single_bit(format->bpb))
+            return gpu.memory.AllocateRingStagingBuffer(size);
+        return gpu.memory.AllocateStagingBuffer(size);
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Texture::AllocateBlockLinearBuffer() {
+        if (guest->tileConfig.mode != texture::TileMode::Block || !SwizzlePass::IsSupported(*guest))
+            return nullptr;
+
+        // The buffer is initialized with the current guest contents as the swizzle pass doesn't write to any padding past the end of the surface
+        auto mapping{guest->mappings[0]};
+        auto blockLinearBuffer{gpu.memory.AllocateRingStagingBuffer(mapping.size())};
+        std::memcpy(blockLinearBuffer->data(), mapping.data(), mapping.size());
+        return blockLinearBuffer;
+    }
+
+    u8 *Texture::GetMappedBacking(vk::DeviceSize &rowPitch) {
+        auto &image{std::get<memory::Image>(backing)};
+        auto subresourceLayout{(*gpu.vkDevice).getImageSubresourceLayout(image.vkImage, vk::ImageSubresource{
+            .aspectMask = format->vkAspect,
+        }, *gpu.vkDevice.getDispatcher())};
+
+        rowPitch = subresourceLayout.rowPitch != format->GetSize(dimensions.width, 1) ? subresourceLayout.rowPitch : 0;
+        return image.data() + subresourceLayout.offset;
+    }
+
+    void Texture::CopyToGuest(u8 *hostBuffer, vk::DeviceSize hostPitch, bool parallel) {
+        auto threadPool{parallel ? &gpu.copyPool : nullptr};
+        if (HasSubresources()) {
+            // Every subresource is copied separately as levels have their own layout and layers may be padded in guest memory
+            for (auto &subresource : GetGuestSubresources()) {
+                auto input{hostBuffer + subresource.hostOffset}, output{subresource.guest.mappings[0].data()};
+                if (subresource.guest.tileConfig.mode == texture::TileMode::Block)
+                    CopyLinearToBlockLinear(subresource.guest, input, output, threadPool);
+                else if (subresource.guest.tileConfig.mode == texture::TileMode::Pitch)
+                    CopyLinearToPitchLinear(subresource.guest, input, output);
+                else if (subresource.guest.tileConfig.mode == texture::TileMode::Linear)
+                    std::memcpy(output, input, subresource.guest.format->GetSize(subresource.guest.dimensions));
+            }
+            return;
+        }
+
         auto guestOutput{guest->mappings[0].data()};
-        auto size{format->GetSize(dimensions)};
 
         if (guest->tileConfig.mode == texture::TileMode::Block)
-            CopyLinearToBlockLinear(*guest, hostBuffer, guestOutput);
+            CopyLinearToBlockLinear(*guest, hostBuffer, guestOutput, threadPool);
         else if (guest->tileConfig.mode == texture::TileMode::Pitch)
-            CopyLinearToPitchLinear(*guest, hostBuffer, guestOutput);
+            CopyLinearToPitchLinear(*guest, hostBuffer, guestOutput, hostPitch);
+        else if (guest->tileConfig.mode == texture::TileMode::Linear && hostPitch)
+            CopyLines(*guest, hostBuffer, hostPitch, guestOutput, guest->format->GetSize(guest->dimensions.width, 1));
         else if (guest->tileConfig.mode == texture::TileMode::Linear)
-            std::memcpy(hostBuffer, guestOutput, format->GetSize(dimensions));
+            std::memcpy(guestOutput, hostBuffer, guest->format->GetSize(guest->dimensions));
+    }
+
+    Texture::DeferredTextureCopy::DeferredTextureCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer) : texture(std::move(texture)), stagingBuffer(std::move(stagingBuffer)) {}
+
+    Texture::DeferredTextureCopy::~DeferredTextureCopy() {
+        // The trap is owned by the texture and the callback is run or destroyed prior to the trap being removed, it's safe to capture the texture by reference
+        // The callback doesn't lock the texture as the accessing thread may already hold it, the staging buffer it reads from is exclusively owned by it
+        // The copy is done serially for the same reason, the accessing thread may be a worker of the copy pool or be inside a job on it which would deadlock on the pool's job mutex
+        texture->gpu.writeTracker.TrapAccess(*texture->trap, [texture = texture.get(), stagingBuffer = std::move(stagingBuffer)]() {
+            TRACE_EVENT("gpu", "Texture::DeferredTextureCopy");
+            texture->CopyToGuest(stagingBuffer->data(), 0, false);
+        });
     }
 
-    Texture::TextureBufferCopy::TextureBufferCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer) : texture(std::move(texture)), stagingBuffer(std::move(stagingBuffer)) {}
+    size_t GuestTexture::GetLayerStride() const {
+        if (layerStride)
+            return layerStride;
+
+        if (levelCount > 1) {
+            // Layers of blocklinear textures with multiple levels are padded to an entire block of the first level
+            auto size{GetLevelOffset(levelCount)};
+            if (tileConfig.mode == texture::TileMode::Block)
+                return util::AlignUp(size, static_cast<size_t>(detail::GobSize) * tileConfig.blockHeight * tileConfig.blockDepth);
+            return size;
+        }
+
+        if (tileConfig.mode == texture::TileMode::Linear)
+            return format->GetSize(dimensions);
+        else if (tileConfig.mode == texture::TileMode::Pitch)
+            return static_cast<size_t>(tileConfig.pitch) * (dimensions.height / format->blockHeight) * dimensions.depth;
+
+        // Layers of blocklinear textures are padded to entire blocks
+        detail::BlockLinearLayout layout{*this};
+        return static_cast<size_t>(layout.robWidthBlocks) * layout.blockHeight * detail::GobSize * layout.surfaceHeightRobs * dimensions.depth;
+    }
+
+    texture::Dimensions GuestTexture::GetLevelDimensions(u32 level) const {
+        return texture::Dimensions{
+            util::AlignUp(std::max(dimensions.width >> level, 1U), static_cast<u32>(format->blockWidth)),
+            util::AlignUp(std::max(dimensions.height >> level, 1U), static_cast<u32>(format->blockHeight)),
+            std::max(dimensions.depth >> level, 1U),
+        };
+    }
+
+    texture::TileConfig GuestTexture::GetLevelTileConfig(u32 level) const {
+        if (tileConfig.mode != texture::TileMode::Block || level == 0)
+            return tileConfig;
+
+        auto levelDimensions{GetLevelDimensions(level)};
+        u32 lines{levelDimensions.height / format->blockHeight};
+        auto config{tileConfig};
+        while (config.blockHeight > 1 && lines <= (config.blockHeight / 2U) * detail::GobHeight)
+            config.blockHeight /= 2;
+        while (config.blockDepth > 1 && levelDimensions.depth <= config.blockDepth / 2U)
+            config.blockDepth /= 2;
+        return config;
+    }
+
+    size_t GuestTexture::GetLevelSize(u32 level) const {
+        GuestTexture levelTexture{Mappings{}, GetLevelDimensions(level), format, GetLevelTileConfig(level), type};
+        return levelTexture.GetLayerStride();
+    }
+
+    size_t GuestTexture::GetLevelOffset(u32 level) const {
+        size_t offset{};
+        for (u32 index{}; index < level; index++)
+            offset += GetLevelSize(index);
+        return offset;
+    }
+
+    u64 GuestTexture::GetContentHash() const {
+        // The hash covers the layout of the guest texture alongside its contents as the same data can be interpreted in different ways
+        auto tileMode{tileConfig.mode};
+        std::array<u32, 6> layoutKey{
+            static_cast<u32>(format->vkFormat),
+            dimensions.width,
+            dimensions.height,
+            dimensions.depth,
+            static_cast<u32>(tileMode),
+            tileMode == texture::TileMode::Block ? (tileConfig.blockHeight | (tileConfig.blockDepth << 8U)) : (tileMode == texture::TileMode::Pitch ? tileConfig.pitch : 0),
+        };
+        auto mapping{mappings[0]};
+        return XXH64(mapping.data(), mapping.size(), XXH64(layoutKey.data(), sizeof(layoutKey), 0));
+    }
+
+    GuestTexture GuestTexture::GetSubresource(u32 level, u32 layer) const {
+        GuestTexture subresource{Mappings{}, GetLevelDimensions(level), format, GetLevelTileConfig(level), type, static_cast<u16>(baseArrayLayer + layer)};
+        if (!mappings.empty()) {
+            auto offset{(layer * GetLayerStride()) + GetLevelOffset(level)}, size{subresource.GetLayerStride()};
+            if (offset + size > mappings[0].size())
+                throw exception("Level {} of layer {} (0x{:X} - 0x{:X}) exceeds the mapping of the guest texture (0x{:X})", level, layer, offset, offset + size, mappings[0].size());
+            subresource.mappings.push_back(mappings[0].subspan(offset, size));
+        }
+        return subresource;
+    }
+
+    Texture::TextureBufferCopy::TextureBufferCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer, std::shared_ptr<memory::StagingBuffer> blockLinearBuffer) : texture(std::move(texture)), stagingBuffer(std::move(stagingBuffer)), blockLinearBuffer(std::move(blockLinearBuffer)) {}
 
     Texture::TextureBufferCopy::~TextureBufferCopy() {
-        texture->CopyToGuest(stagingBuffer ? stagingBuffer->data() : std::get<memory::Image>(texture->backing).data());
+        if (blockLinearBuffer) {
+            // The staging buffer may be larger than the guest texture as allocations are rounded up, only the size of the guest mapping is copied back
+            auto &mapping{texture->guest->mappings[0]};
+            mapping.copy_from(*blockLinearBuffer, mapping.size());
+        } else if (stagingBuffer) {
+            texture->CopyToGuest(stagingBuffer->data());
+        } else {
+            vk::DeviceSize rowPitch;
+            auto mapping{texture->GetMappedBacking(rowPitch)};
+            texture->CopyToGuest(mapping, rowPitch);
+        }
+
+        // The write to the guest texture will have dirtied the trap, it's protected again as the host texture matches it
+        if (texture->trap)
+            texture->gpu.writeTracker.Protect(*texture->trap);
     }
 
     Texture::Texture(GPU &gpu, BackingType &&backing, GuestTexture guest, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout layout, vk::ImageTiling tiling, u32 mipLevels, u32 layerCount, vk::SampleCountFlagBits sampleCount)
@@ -144,6 +760,7 @@ namespace skyline::gpu {
           mipLevels(mipLevels),
           layerCount(layerCount),
           sampleCount(sampleCount) {
+        CreateTrap();
         if (GetBacking())
             SynchronizeHost();
     }
@@ -159,35 +776,91 @@ namespace skyline::gpu {
           layerCount(layerCount),
           sampleCount(sampleCount) {}
 
-    Texture::Texture(GPU &pGpu, GuestTexture pGuest)
+    Texture::Texture(GPU &pGpu, GuestTexture pGuest, float pResolutionScale)
         : gpu(pGpu),
           guest(std::move(pGuest)),
           dimensions(guest->dimensions),
           format(guest->format),
           layout(vk::ImageLayout::eUndefined),
-          tiling((guest->tileConfig.mode == texture::TileMode::Block) ? vk::ImageTiling::eOptimal : vk::ImageTiling::eLinear),
-          mipLevels(1),
+          tiling(vk::ImageTiling::eOptimal),
+          mipLevels(guest->levelCount),
           layerCount(guest->layerCount),
           sampleCount(vk::SampleCountFlagBits::e1) {
+        // Compressed formats which the host GPU can't sample from are decoded on the CPU into an uncompressed format during synchronization
+        if (guest->format->IsCompressed() && texture::bcn::IsSupported(*guest->format) && !(gpu.vkPhysicalDevice.getFormatProperties(*guest->format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+            format = skyline::gpu::format::R8G8B8A8Unorm;
+
+        // Formats which the host GPU can't render to are converted into a wider format which represents the same values on the GPU during synchronization
+        if (!guest->format->IsCompressed() && !HasSubresources() && !(gpu.vkPhysicalDevice.getFormatProperties(*guest->format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eColorAttachment)) {
+            texture::Format hostFormat;
+            auto hostConversion{FormatConversionPass::GetConversion(guest->format, hostFormat)};
+            if (hostConversion != texture::FormatConversion::None && (gpu.vkPhysicalDevice.getFormatProperties(*hostFormat).optimalTilingFeatures & vk::FormatFeatureFlagBits::eColorAttachment)) {
+                conversion = hostConversion;
+                format = hostFormat;
+            }
+        }
+
+        // Scaling is done with blits between the guest and host resolution, so it's only supported for formats which can be blitted to and from
+        constexpr vk::FormatFeatureFlags BlitFeatures{vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst};
+        auto formatFeatures{gpu.vkPhysicalDevice.getFormatProperties(*format).optimalTilingFeatures};
+        if (pResolutionScale != 1.0f && !guest->format->IsCompressed() && guest->levelCount == 1 && guest->dimensions.GetType() == vk::ImageType::e2D && (formatFeatures & BlitFeatures) == BlitFeatures) {
+            resolutionScale = pResolutionScale;
+            dimensions.width = std::max(static_cast<u32>(std::lround(guest->dimensions.width * resolutionScale)), 1U);
+            dimensions.height = std::max(static_cast<u32>(std::lround(guest->dimensions.height * resolutionScale)), 1U);
+            if (formatFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)
+                scaleFilter = vk::Filter::eLinear;
+        }
+
+        // Color textures are sampleable wherever the format allows it as presented frames are drawn from them when they're pre-rotated
+        vk::ImageUsageFlags attachmentUsage{vk::ImageUsageFlagBits::eColorAttachment};
+        if (formatFeatures & vk::FormatFeatureFlagBits::eSampledImage)
+            attachmentUsage |= vk::ImageUsageFlagBits::eSampled;
+
         vk::ImageCreateInfo imageCreateInfo{
             .imageType = guest->dimensions.GetType(),
-            .format = *guest->format,
-            .extent = guest->dimensions,
-            .mipLevels = 1,
+            .format = *format,
+            .extent = dimensions,
+            .mipLevels = mipLevels,
             .arrayLayers = guest->layerCount,
             .samples = vk::SampleCountFlagBits::e1,
             .tiling = tiling,
-            .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+            .usage = (format->IsCompressed() ? vk::ImageUsageFlagBits::eSampled : attachmentUsage) | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
             .sharingMode = vk::SharingMode::eExclusive,
             .queueFamilyIndexCount = 1,
             .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
             .initialLayout = layout,
         };
+
+        // Pitch and linear guest textures are backed by a host-visible linear image on unified memory when possible, this allows synchronizing them with a CPU copy into the mapping rather than a staging buffer and transfer
+        // Blocklinear textures gain nothing from this as they need to be deswizzled regardless and linear images are slower for the GPU to render to or sample from
+        // Scaled textures are excluded as the mapping would be at the host resolution rather than the guest resolution
+        if (guest->tileConfig.mode != texture::TileMode::Block && !IsTranscoded() && !IsConverted() && !IsScaled() && guest->dimensions.GetType() == vk::ImageType::e2D && guest->layerCount == 1 && guest->levelCount == 1 && gpu.memory.SupportsMappedImage(imageCreateInfo)) {
+            imageCreateInfo.tiling = tiling = vk::ImageTiling::eLinear;
+            imageCreateInfo.initialLayout = layout = vk::ImageLayout::ePreinitialized; // The host writes into the mapping can precede the deferred transition, they're only retained across it from the preinitialized layout
+        }
+        usage = imageCreateInfo.usage;
+
         backing = tiling != vk::ImageTiling::eLinear ? gpu.memory.AllocateImage(imageCreateInfo) : gpu.memory.AllocateMappedImage(imageCreateInfo);
-        TransitionLayout(vk::ImageLayout::eGeneral);
+        if (IsScaled())
+            guestResolutionImage.emplace(gpu.memory.AllocateImage(vk::ImageCreateInfo{
+                .imageType = vk::ImageType::e2D,
+                .format = *format,
+                .extent = guest->dimensions,
+                .mipLevels = 1,
+                .arrayLayers = layerCount,
+                .samples = vk::SampleCountFlagBits::e1,
+                .tiling = vk::ImageTiling::eOptimal,
+                .usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+                .sharingMode = vk::SharingMode::eExclusive,
+                .queueFamilyIndexCount = 1,
+                .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+                .initialLayout = vk::ImageLayout::eUndefined,
+            }));
+        DeferLayoutTransition(vk::ImageLayout::eGeneral);
+        CreateTrap();
     }
 
-    Texture::Texture(GPU &gpu, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout initialLayout, vk::ImageUsageFlags usage, vk::ImageTiling tiling, u32 mipLevels, u32 layerCount, vk::SampleCountFlagBits sampleCount)
+    Texture::Texture(GPU &gpu, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout initialLayout, vk::ImageUsageFlags pUsage, vk::ImageTiling tiling, u32 mipLevels, u32 layerCount, vk::SampleCountFlagBits sampleCount)
         : gpu(gpu),
           dimensions(dimensions),
           format(format),
@@ -195,7 +868,8 @@ namespace skyline::gpu {
           tiling(tiling),
           mipLevels(mipLevels),
           layerCount(layerCount),
-          sampleCount(sampleCount) {
+          sampleCount(sampleCount),
+          transient(static_cast<bool>(pUsage & vk::ImageUsageFlagBits::eTransientAttachment)) {
         vk::ImageCreateInfo imageCreateInfo{
             .imageType = dimensions.GetType(),
             .format = *format,
@@ -204,15 +878,25 @@ namespace skyline::gpu {
             .arrayLayers = layerCount,
             .samples = sampleCount,
             .tiling = tiling,
-            .usage = usage | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+            .usage = transient ? pUsage : pUsage | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst, // Transient attachments may only have attachment usages
             .sharingMode = vk::SharingMode::eExclusive,
             .queueFamilyIndexCount = 1,
             .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
             .initialLayout = layout,
         };
-        backing = tiling != vk::ImageTiling::eLinear ? gpu.memory.AllocateImage(imageCreateInfo) : gpu.memory.AllocateMappedImage(imageCreateInfo);
+        usage = imageCreateInfo.usage;
+        if (transient)
+            backing = gpu.memory.AllocateTransientImage(imageCreateInfo);
+        else
+            backing = tiling != vk::ImageTiling::eLinear ? gpu.memory.AllocateImage(imageCreateInfo) : gpu.memory.AllocateMappedImage(imageCreateInfo);
         if (initialLayout != layout)
-            TransitionLayout(initialLayout);
+            DeferLayoutTransition(initialLayout);
+    }
+
+    void Texture::CreateTrap() {
+        // Synchronization is only supported for single mapping textures so there's no use in tracking any others
+        if (guest && guest->mappings.size() == 1)
+            trap = gpu.writeTracker.CreateTrap(guest->mappings[0], CanSynchronizePartially() || HasSubresources());
     }
 
     bool Texture::WaitOnBacking() {
@@ -238,11 +922,34 @@ namespace skyline::gpu {
         }
     }
 
+    void Texture::WaitOnFence(const std::shared_ptr<FenceCycle> &pCycle) {
+        auto lCycle{cycle.lock()};
+        if (lCycle && lCycle != pCycle && !(lCycle->tracked && pCycle->tracked)) {
+            TRACE_EVENT("gpu", "Texture::WaitOnFence");
+            lCycle->Wait();
+            cycle.reset();
+        }
+    }
+
+    void Texture::WaitOnRecord() {
+        u32 pending{pendingRecords.load(std::memory_order_acquire)};
+        if (pending) {
+            TRACE_EVENT("gpu", "Texture::WaitOnRecord");
+            do {
+                pendingRecords.wait(pending, std::memory_order_acquire);
+            } while ((pending = pendingRecords.load(std::memory_order_acquire)));
+        }
+    }
+
     void Texture::SwapBacking(BackingType &&pBacking, vk::ImageLayout pLayout) {
         WaitOnFence();
 
         backing = std::move(pBacking);
         layout = pLayout;
+        backingLayout.reset();
+        acquireQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        if (trap)
+            trap->dirty.store(true, std::memory_order_release); // The new backing needs to be synchronized with the guest regardless of CPU writes
         if (GetBacking())
             backingCondition.notify_all();
     }
@@ -253,13 +960,21 @@ namespace skyline::gpu {
 
         TRACE_EVENT("gpu", "Texture::TransitionLayout");
 
-        if (layout != pLayout)
+        if (layout != pLayout || backingLayout)
             cycle = gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
+                if (acquireQueueFamily != VK_QUEUE_FAMILY_IGNORED)
+                    RecordDeferredLayout(commandBuffer); // An ownership acquire can't be folded into another transition as its layouts must match the release
+
+                // A deferred transition is folded into this one as the layout it was deferred to is skipped over entirely
+                auto oldLayout{backingLayout.value_or(layout)};
+                backingLayout.reset();
+                layout = pLayout;
+
                 commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, vk::ImageMemoryBarrier{
                     .image = GetBacking(),
                     .srcAccessMask = vk::AccessFlagBits::eNoneKHR,
                     .dstAccessMask = vk::AccessFlagBits::eNoneKHR,
-                    .oldLayout = std::exchange(layout, pLayout),
+                    .oldLayout = oldLayout,
                     .newLayout = pLayout,
                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -272,33 +987,164 @@ namespace skyline::gpu {
             });
     }
 
+    void Texture::DeferLayoutTransition(vk::ImageLayout pLayout) {
+        if (layout == pLayout)
+            return;
+
+        if (!backingLayout)
+            backingLayout = layout;
+        layout = pLayout;
+        if (*backingLayout == layout)
+            backingLayout.reset(); // Transitioning back to the layout the backing is in doesn't require a barrier
+    }
+
+    void Texture::RecordDeferredLayout(std::vector<vk::ImageMemoryBarrier> &barriers) {
+        if (!backingLayout)
+            return;
+
+        barriers.push_back(vk::ImageMemoryBarrier{
+            .image = GetBacking(),
+            .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+            .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+            .oldLayout = *backingLayout,
+            .newLayout = layout,
+            .srcQueueFamilyIndex = acquireQueueFamily,
+            .dstQueueFamilyIndex = acquireQueueFamily != VK_QUEUE_FAMILY_IGNORED ? gpu.vkQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED,
+            .subresourceRange = {
+                .aspectMask = format->vkAspect,
+                .levelCount = mipLevels,
+                .layerCount = layerCount,
+            },
+        });
+        backingLayout.reset();
+        acquireQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    void Texture::RecordDeferredLayout(const vk::raii::CommandBuffer &commandBuffer) {
+        if (!backingLayout)
+            return;
+
+        std::vector<vk::ImageMemoryBarrier> barriers;
+        RecordDeferredLayout(barriers);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, barriers);
+    }
+
     void Texture::SynchronizeHost() {
         TRACE_EVENT("gpu", "Texture::SynchronizeHost");
 
-        auto stagingBuffer{SynchronizeHostImpl(nullptr)};
-        if (stagingBuffer) {
-            auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
-                CopyFromStagingBuffer(commandBuffer, stagingBuffer);
+        std::shared_ptr<memory::StagingBuffer> blockLinearBuffer, conversionBuffer;
+        std::vector<vk::BufferImageCopy> copyRegions;
+        auto stagingBuffer{SynchronizeHostImpl(nullptr, blockLinearBuffer, copyRegions, conversionBuffer)};
+        if (stagingBuffer && !blockLinearBuffer && copyRegions.empty() && CanUploadOnTransferQueue()) {
+            // Uploads on the transfer queue overlap with rendering rather than stalling the graphics queue, any prior use of the backing has been waited on by this point
+            auto lCycle{gpu.scheduler.SubmitTransfer([&](vk::raii::CommandBuffer &commandBuffer) {
+                CopyFromStagingBufferOnTransferQueue(commandBuffer, stagingBuffer);
             })};
             lCycle->AttachObjects(stagingBuffer, shared_from_this());
             cycle = lCycle;
+        } else if (stagingBuffer) {
+            auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
+                CopyFromStagingBuffer(commandBuffer, pCycle, stagingBuffer, blockLinearBuffer, copyRegions, conversionBuffer);
+            })};
+            lCycle->AttachObjects(stagingBuffer, shared_from_this());
+            if (blockLinearBuffer)
+                lCycle->AttachObject(blockLinearBuffer);
+            if (conversionBuffer)
+                lCycle->AttachObject(conversionBuffer);
+            cycle = lCycle;
         }
     }
 
     void Texture::SynchronizeHostWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
         TRACE_EVENT("gpu", "Texture::SynchronizeHostWithBuffer");
 
-        auto stagingBuffer{SynchronizeHostImpl(pCycle)};
+        std::shared_ptr<memory::StagingBuffer> blockLinearBuffer, conversionBuffer;
+        std::vector<vk::BufferImageCopy> copyRegions;
+        auto stagingBuffer{SynchronizeHostImpl(pCycle, blockLinearBuffer, copyRegions, conversionBuffer)};
         if (stagingBuffer) {
-            CopyFromStagingBuffer(commandBuffer, stagingBuffer);
+            CopyFromStagingBuffer(commandBuffer, pCycle, stagingBuffer, blockLinearBuffer, copyRegions, conversionBuffer);
             pCycle->AttachObjects(stagingBuffer, shared_from_this());
+            if (blockLinearBuffer)
+                pCycle->AttachObject(blockLinearBuffer);
+            if (conversionBuffer)
+                pCycle->AttachObject(conversionBuffer);
             cycle = pCycle;
         }
     }
 
+    bool Texture::SynchronizeHostInto(const std::shared_ptr<Texture> &destination) {
+        if (!guest || !trap || !trap->dirty.load(std::memory_order_acquire) || IsTranscoded() || IsConverted() || HasSubresources() || guest->mappings.size() > 1)
+            return false; // The host texture is up to date or decoding is required, it's cheaper to copy the host texture in either case
+        else if (destination->format != format || destination->dimensions != dimensions || guest->dimensions != dimensions)
+            return false;
+
+        TRACE_EVENT("gpu", "Texture::SynchronizeHostInto");
+
+        // The trap is deliberately left dirty as the host texture isn't updated by this, any writes during the read will at most tear this frame
+        std::shared_ptr<memory::StagingBuffer> blockLinearBuffer;
+        auto stagingBuffer{AllocateStagingBuffer(format->GetSize(dimensions))};
+        CopyFromGuest(stagingBuffer->data(), 0, true, blockLinearBuffer);
+
+        destination->WaitOnBacking();
+        destination->WaitOnFence();
+
+        auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
+            if (blockLinearBuffer)
+                gpu.swizzlePass.RecordDeswizzle(commandBuffer, pCycle, *guest, *blockLinearBuffer, *stagingBuffer);
+
+            destination->RecordDeferredLayout(commandBuffer);
+            auto image{destination->GetBacking()};
+            vk::ImageSubresourceRange subresource{
+                .aspectMask = format->vkAspect,
+                .levelCount = 1,
+                .layerCount = 1,
+            };
+            commandBuffer.pipelineBarrier(destination->layout != vk::ImageLayout::eUndefined ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eBottomOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = image,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .oldLayout = destination->layout,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
+            if (destination->layout == vk::ImageLayout::eUndefined)
+                destination->layout = vk::ImageLayout::eTransferDstOptimal;
+
+            commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, image, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy{
+                .bufferOffset = stagingBuffer->offset,
+                .imageExtent = dimensions,
+                .imageSubresource = {
+                    .aspectMask = format->vkAspect,
+                    .layerCount = 1,
+                },
+            });
+
+            if (destination->layout != vk::ImageLayout::eTransferDstOptimal)
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                    .image = image,
+                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                    .dstAccessMask = vk::AccessFlagBits::eMemoryRead,
+                    .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                    .newLayout = destination->layout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .subresourceRange = subresource,
+                });
+        })};
+        lCycle->AttachObjects(stagingBuffer, destination);
+        if (blockLinearBuffer)
+            lCycle->AttachObject(blockLinearBuffer);
+        destination->cycle = lCycle;
+        return true;
+    }
+
     void Texture::SynchronizeGuest() {
         if (!guest)
             throw exception("Synchronization of guest textures requires a valid guest texture to synchronize to");
+        else if (IsTranscoded())
+            throw exception("Synchronization of transcoded textures to the guest is not supported");
         else if (layout == vk::ImageLayout::eUndefined)
             return; // If the state of the host texture is undefined then so can the guest
         else if (guest->mappings.size() > 1)
@@ -313,17 +1159,25 @@ namespace skyline::gpu {
         WaitOnFence();
 
         if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
-            auto size{format->GetSize(dimensions)};
-            auto stagingBuffer{gpu.memory.AllocateStagingBuffer(size)};
+            auto size{GetHostBufferSize()};
+            auto stagingBuffer{AllocateStagingBuffer(size)};
+            auto blockLinearBuffer{AllocateBlockLinearBuffer()};
 
-            auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
+            auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
                 CopyIntoStagingBuffer(commandBuffer, stagingBuffer);
+                stagingBuffer = ConvertStagingBufferToGuest(commandBuffer, pCycle, std::move(stagingBuffer));
+                if (blockLinearBuffer)
+                    gpu.swizzlePass.RecordSwizzle(commandBuffer, pCycle, *guest, *stagingBuffer, *blockLinearBuffer);
             })};
-            lCycle->AttachObject(std::make_shared<TextureBufferCopy>(shared_from_this(), stagingBuffer));
+            lCycle->AttachObject(std::make_shared<TextureBufferCopy>(shared_from_this(), stagingBuffer, blockLinearBuffer));
             cycle = lCycle;
         } else if (tiling == vk::ImageTiling::eLinear) {
             // We can optimize linear texture sync on a UMA by mapping the texture onto the CPU and copying directly from it rather than using a staging buffer
-            CopyToGuest(std::get<memory::Image>(backing).data());
+            vk::DeviceSize rowPitch;
+            auto mapping{GetMappedBacking(rowPitch)};
+            CopyToGuest(mapping, rowPitch);
+            if (trap)
+                gpu.writeTracker.Protect(*trap);
         } else {
             throw exception("Host -> Guest synchronization of images tiled as '{}' isn't implemented", vk::to_string(tiling));
         }
@@ -332,6 +1186,8 @@ namespace skyline::gpu {
     void Texture::SynchronizeGuestWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
         if (!guest)
             throw exception("Synchronization of guest textures requires a valid guest texture to synchronize to");
+        else if (IsTranscoded())
+            throw exception("Synchronization of transcoded textures to the guest is not supported");
         else if (layout == vk::ImageLayout::eUndefined)
             return; // If the state of the host texture is undefined then so can the guest
         else if (guest->mappings.size() > 1)
@@ -343,18 +1199,33 @@ namespace skyline::gpu {
             return;
 
         WaitOnBacking();
-        if (cycle.lock() != pCycle)
-            WaitOnFence();
+        WaitOnFence(pCycle);
 
-        if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
-            auto size{format->GetSize(dimensions)};
-            auto stagingBuffer{gpu.memory.AllocateStagingBuffer(size)};
+        if ((tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) && trap) {
+            // The copy to the guest is deferred till it's accessed, which may never happen for textures that are only rendered to
+            // The staging buffer is held till then so it's not suballocated from the ring, the texture is swizzled on the CPU as the swizzle pass requires the current guest contents which would resolve the trap
+            auto stagingBuffer{IsConverted() ? AllocateStagingBuffer(GetHostBufferSize()) : gpu.memory.AllocateStagingBuffer(GetHostBufferSize())};
+            CopyIntoStagingBuffer(commandBuffer, stagingBuffer);
+            stagingBuffer = ConvertStagingBufferToGuest(commandBuffer, pCycle, std::move(stagingBuffer), true);
+            pCycle->AttachObject(std::make_shared<DeferredTextureCopy>(shared_from_this(), stagingBuffer));
+            cycle = pCycle;
+        } else if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
+            auto size{GetHostBufferSize()};
+            auto stagingBuffer{AllocateStagingBuffer(size)};
+            auto blockLinearBuffer{AllocateBlockLinearBuffer()};
 
             CopyIntoStagingBuffer(commandBuffer, stagingBuffer);
-            pCycle->AttachObject(std::make_shared<TextureBufferCopy>(shared_from_this(), stagingBuffer));
+            stagingBuffer = ConvertStagingBufferToGuest(commandBuffer, pCycle, std::move(stagingBuffer));
+            if (blockLinearBuffer)
+                gpu.swizzlePass.RecordSwizzle(commandBuffer, pCycle, *guest, *stagingBuffer, *blockLinearBuffer);
+            pCycle->AttachObject(std::make_shared<TextureBufferCopy>(shared_from_this(), stagingBuffer, blockLinearBuffer));
             cycle = pCycle;
         } else if (tiling == vk::ImageTiling::eLinear) {
-            CopyToGuest(std::get<memory::Image>(backing).data());
+            // The mapping is copied to the guest once the commands writing to the texture have completed, the barrier makes any writes to it visible to the host
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eHost, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eHostRead,
+            }, {}, {});
             pCycle->AttachObject(std::make_shared<TextureBufferCopy>(shared_from_this()));
             cycle = pCycle;
         } else {
@@ -362,54 +1233,71 @@ namespace skyline::gpu {
         }
     }
 
-    void Texture::CopyFrom(std::shared_ptr<Texture> source, const vk::ImageSubresourceRange &subresource) {
-        WaitOnBacking();
-        WaitOnFence();
+    void Texture::RecordTransferFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageSubresourceRange &sourceSubresource, const vk::ImageSubresourceRange &subresource, const std::function<void(vk::Image, vk::Image)> &transfer) {
+        source->RecordDeferredLayout(commandBuffer);
+        RecordDeferredLayout(commandBuffer);
 
-        source->WaitOnBacking();
-        source->WaitOnFence();
+        // The transitions into the transfer layouts are only ordered after prior transfers, any other prior accesses must be synchronized with the transfer stage beforehand which this chains with
+        auto sourceBacking{source->GetBacking()};
+        if (source->layout != vk::ImageLayout::eTransferSrcOptimal) {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = sourceBacking,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                .oldLayout = source->layout,
+                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = sourceSubresource,
+            });
+        }
 
-        if (source->layout == vk::ImageLayout::eUndefined)
-            throw exception("Cannot copy from image with undefined layout");
-        else if (source->dimensions != dimensions)
-            throw exception("Cannot copy from image with different dimensions");
-        else if (source->format != format)
-            throw exception("Cannot copy from image with different format");
+        auto destinationBacking{GetBacking()};
+        if (layout != vk::ImageLayout::eTransferDstOptimal) {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = destinationBacking,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .oldLayout = layout,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
 
-        TRACE_EVENT("gpu", "Texture::CopyFrom");
+            if (layout == vk::ImageLayout::eUndefined)
+                layout = vk::ImageLayout::eTransferDstOptimal;
+        }
 
-        auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
-            auto sourceBacking{source->GetBacking()};
-            if (source->layout != vk::ImageLayout::eTransferSrcOptimal) {
-                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
-                    .image = sourceBacking,
-                    .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
-                    .dstAccessMask = vk::AccessFlagBits::eTransferRead,
-                    .oldLayout = source->layout,
-                    .newLayout = vk::ImageLayout::eTransferSrcOptimal,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .subresourceRange = subresource,
-                });
-            }
+        transfer(sourceBacking, destinationBacking);
 
-            auto destinationBacking{GetBacking()};
-            if (layout != vk::ImageLayout::eTransferDstOptimal) {
-                commandBuffer.pipelineBarrier(layout != vk::ImageLayout::eUndefined ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eBottomOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
-                    .image = destinationBacking,
-                    .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
-                    .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
-                    .oldLayout = layout,
-                    .newLayout = vk::ImageLayout::eTransferDstOptimal,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .subresourceRange = subresource,
-                });
+        if (layout != vk::ImageLayout::eTransferDstOptimal)
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = destinationBacking,
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            });
 
-                if (layout == vk::ImageLayout::eUndefined)
-                    layout = vk::ImageLayout::eTransferDstOptimal;
-            }
+        if (layout != vk::ImageLayout::eTransferSrcOptimal)
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+                .image = sourceBacking,
+                .srcAccessMask = vk::AccessFlagBits::eTransferRead,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .newLayout = source->layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = sourceSubresource,
+            });
+    }
 
+    void Texture::RecordCopyFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageSubresourceRange &subresource) {
+        RecordTransferFrom(commandBuffer, source, subresource, subresource, [&](vk::Image sourceBacking, vk::Image destinationBacking) {
             vk::ImageSubresourceLayers subresourceLayers{
                 .aspectMask = subresource.aspectMask,
                 .mipLevel = subresource.baseMipLevel,
@@ -422,30 +1310,121 @@ namespace skyline::gpu {
                     .dstSubresource = subresourceLayers,
                     .extent = dimensions,
                 });
+        });
+    }
 
-            if (layout != vk::ImageLayout::eTransferDstOptimal)
-                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
-                    .image = destinationBacking,
-                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
-                    .dstAccessMask = vk::AccessFlagBits::eMemoryRead,
-                    .oldLayout = vk::ImageLayout::eTransferDstOptimal,
-                    .newLayout = layout,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .subresourceRange = subresource,
-                });
+    void Texture::RecordBlitFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageBlit &region, vk::Filter filter) {
+        vk::ImageSubresourceRange subresource{
+            .aspectMask = region.dstSubresource.aspectMask,
+            .baseMipLevel = region.dstSubresource.mipLevel,
+            .levelCount = 1,
+            .baseArrayLayer = region.dstSubresource.baseArrayLayer,
+            .layerCount = region.dstSubresource.layerCount,
+        };
+        vk::ImageSubresourceRange sourceSubresource{
+            .aspectMask = region.srcSubresource.aspectMask,
+            .baseMipLevel = region.srcSubresource.mipLevel,
+            .levelCount = 1,
+            .baseArrayLayer = region.srcSubresource.baseArrayLayer,
+            .layerCount = region.srcSubresource.layerCount,
+        };
+        RecordTransferFrom(commandBuffer, source, sourceSubresource, subresource, [&](vk::Image sourceBacking, vk::Image destinationBacking) {
+            commandBuffer.blitImage(sourceBacking, vk::ImageLayout::eTransferSrcOptimal, destinationBacking, vk::ImageLayout::eTransferDstOptimal, region, filter);
+        });
+    }
 
-            if (layout != vk::ImageLayout::eTransferSrcOptimal)
-                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
-                    .image = sourceBacking,
-                    .srcAccessMask = vk::AccessFlagBits::eTransferRead,
-                    .dstAccessMask = vk::AccessFlagBits::eMemoryWrite,
-                    .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
-                    .newLayout = source->layout,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .subresourceRange = subresource,
-                });
+    bool Texture::ReinterpretFrom(const std::shared_ptr<Texture> &source) {
+        // The guest contents of the source are newer than its host texture while its trap is dirty, the deferred initial transition is only pending while this texture is unused
+        if (!trap || !trap->dirty.load(std::memory_order_acquire) || !backingLayout || !cycle.expired() || IsTranscoded() || IsConverted() || mipLevels != 1)
+            return false;
+        else if (!source->trap || source->trap->dirty.load(std::memory_order_acquire) || source->layout == vk::ImageLayout::eUndefined || source->IsTranscoded() || source->IsConverted() || source->mipLevels != 1)
+            return false;
+
+        auto size{format->GetSize(guest->dimensions) * layerCount};
+        if (source->format->GetSize(source->guest->dimensions) * source->layerCount != size || source->layerCount != layerCount)
+            return false;
+
+        TRACE_EVENT("gpu", "Texture::ReinterpretFrom");
+
+        WaitOnBacking();
+        source->WaitOnBacking();
+        source->WaitOnFence();
+
+        // The texture is written in its entirety so the guest texture doesn't need to be read from, the trap is protected to catch any writes after this point
+        gpu.writeTracker.Protect(*trap);
+
+        // Both textures are tightly packed in a buffer with the same amount of bytes in each line, so the contents of the source can be copied into it as-is
+        auto stagingBuffer{gpu.memory.AllocateStagingBuffer(size)};
+        auto lCycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle) {
+            source->CopyIntoStagingBuffer(commandBuffer, stagingBuffer);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            }, {}, {});
+            CopyFromStagingBuffer(commandBuffer, pCycle, stagingBuffer);
+        })};
+        lCycle->AttachObjects(stagingBuffer, source, shared_from_this());
+        source->cycle = lCycle;
+        cycle = lCycle;
+        return true;
+    }
+
+    bool Texture::DuplicateFrom(const std::shared_ptr<Texture> &source) {
+        // The source must still hold the contents it was indexed with, the deferred initial transition is only pending while this texture is unused
+        if (!trap || !trap->dirty.load(std::memory_order_acquire) || !backingLayout || !cycle.expired() || mipLevels != 1)
+            return false;
+        else if (!source->trap || source->trap->dirty.load(std::memory_order_acquire) || source->layout == vk::ImageLayout::eUndefined || source->format != format || source->dimensions != dimensions || source->mipLevels != 1 || source->layerCount != layerCount)
+            return false;
+
+        auto sourceHash{source->contentHash.load(std::memory_order_relaxed)};
+        if (!sourceHash)
+            return false;
+
+        // The trap is protected before the guest texture is hashed so any writes during hashing dirty it again, it's marked dirty again if the contents differ as the host texture is left uninitialized
+        gpu.writeTracker.Protect(*trap);
+        if (guest->GetContentHash() != sourceHash) {
+            trap->dirty.store(true, std::memory_order_release);
+            return false;
+        }
+
+        TRACE_EVENT("gpu", "Texture::DuplicateFrom");
+
+        WaitOnBacking();
+        source->WaitOnBacking();
+        source->WaitOnFence();
+
+        auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
+            RecordCopyFrom(commandBuffer, source, vk::ImageSubresourceRange{
+                .aspectMask = format->vkAspect,
+                .levelCount = 1,
+                .layerCount = layerCount,
+            });
+        })};
+        lCycle->AttachObjects(source, shared_from_this());
+        source->cycle = lCycle;
+        cycle = lCycle;
+        contentHash.store(sourceHash, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Texture::CopyFrom(std::shared_ptr<Texture> source, const vk::ImageSubresourceRange &subresource) {
+        WaitOnBacking();
+        WaitOnFence();
+
+        source->WaitOnBacking();
+        source->WaitOnFence();
+
+        if (source->layout == vk::ImageLayout::eUndefined)
+            throw exception("Cannot copy from image with undefined layout");
+        else if (source->dimensions != dimensions)
+            throw exception("Cannot copy from image with different dimensions");
+        else if (source->format != format)
+            throw exception("Cannot copy from image with different format");
+
+        TRACE_EVENT("gpu", "Texture::CopyFrom");
+
+        auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
+            RecordCopyFrom(commandBuffer, source, subresource);
         })};
         lCycle->AttachObjects(std::move(source), shared_from_this());
         cycle = lCycle;
@@ -453,14 +1432,40 @@ namespace skyline::gpu {
 
     Texture::~Texture() {
         WaitOnFence();
+
+        // Any deferred copy to the guest must be done now as the contents of the texture would be lost otherwise
+        if (trap)
+            gpu.writeTracker.Protect(*trap);
     }
 
-    TextureView::TextureView(std::shared_ptr<Texture> backing, vk::ImageViewType type, vk::ImageSubresourceRange range, texture::Format format, vk::ComponentMapping mapping) : backing(std::move(backing)), type(type), format(format), mapping(mapping), range(range) {}
+    TextureView::TextureView(std::shared_ptr<Texture> pBacking, vk::ImageViewType type, vk::ImageSubresourceRange range, texture::Format pFormat, vk::ComponentMapping mapping) : backing(std::move(pBacking)), type(type), format(pFormat), mapping(mapping), range(range) {
+        // Views of transcoded or converted textures use the host format as the host GPU doesn't support the guest format
+        if (format && (backing->IsTranscoded() || backing->IsConverted()) && format == backing->guest->format)
+            format = backing->format;
+    }
 
-    vk::ImageView TextureView::GetView() {
-        if (view)
-            return **view;
+    size_t Texture::ViewKeyHash::operator()(const ViewKey &key) const {
+        // Every member is hashed separately rather than hashing the raw key as the layout of the key could have padding that differs between equal keys
+        size_t hash{};
+        auto combine{[&hash](auto value) {
+            hash ^= static_cast<size_t>(value) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+        }};
+        combine(reinterpret_cast<u64>(static_cast<VkImage>(key.image)));
+        combine(key.type);
+        combine(key.format);
+        combine(key.mapping.r);
+        combine(key.mapping.g);
+        combine(key.mapping.b);
+        combine(key.mapping.a);
+        combine(static_cast<VkImageAspectFlags>(key.range.aspectMask));
+        combine(key.range.baseMipLevel);
+        combine(key.range.levelCount);
+        combine(key.range.baseArrayLayer);
+        combine(key.range.layerCount);
+        return hash;
+    }
 
+    vk::ImageView TextureView::GetView() {
         auto viewType{[&]() {
             switch (backing->dimensions.GetType()) {
                 case vk::ImageType::e1D:
@@ -472,21 +1477,26 @@ namespace skyline::gpu {
             }
         }()};
 
-        vk::ImageViewCreateInfo createInfo{
+        Texture::ViewKey key{
             .image = backing->GetBacking(),
-            .viewType = viewType,
+            .type = viewType,
             .format = format ? *format : *backing->format,
-            .components = mapping,
-            .subresourceRange = range,
+            .mapping = mapping,
+            .range = range,
         };
 
         auto &views{backing->views};
-        auto iterator{std::find_if(views.begin(), views.end(), [&](const std::pair<vk::ImageViewCreateInfo, vk::raii::ImageView> &item) {
-            return item.first == createInfo;
-        })};
+        auto iterator{views.find(key)};
         if (iterator != views.end())
             return *iterator->second;
 
-        return *views.emplace_back(createInfo, vk::raii::ImageView(backing->gpu.vkDevice, createInfo)).second;
+        vk::ImageViewCreateInfo createInfo{
+            .image = key.image,
+            .viewType = key.type,
+            .format = key.format,
+            .components = key.mapping,
+            .subresourceRange = key.range,
+        };
+        return *views.emplace(key, vk::raii::ImageView(backing->gpu.vkDevice, createInfo)).first->second;
     }
 }
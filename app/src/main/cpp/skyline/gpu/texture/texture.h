@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <common/write_tracker.h>
 #include <gpu/memory_manager.h>
+#include <gpu/access_state.h>
 
 namespace skyline::gpu {
     namespace texture {
@@ -190,6 +192,17 @@ namespace skyline::gpu {
             }
         };
 
+        /**
+         * @brief A conversion between a guest format which the host GPU can't render to and a wider host format which represents the same values, it's done by the FormatConversionPass on every transfer between the guest and host texture
+         * @note This must match the conversion types in texture_format_conversion.comp
+         */
+        enum class FormatConversion : u32 {
+            None,
+            Unorm16ToFloat32, //!< 16-bit UNORM components are widened to 32-bit floats, 16-bit normalized formats are optional in Vulkan and unsupported as render targets by several mobile drivers
+            Snorm16ToFloat32, //!< 16-bit SNORM components are widened to 32-bit floats
+            B10G11R11FloatToR16G16B16A16Float, //!< Packed unsigned 11-bit and 10-bit floats are widened to 16-bit floats, B10G11R11 is only mandatory for sampling but not as a render target
+        };
+
         /**
          * @brief The layout of a texture in GPU memory
          * @note Refer to Chapter 20.1 of the Tegra X1 TRM for information
@@ -262,10 +275,11 @@ namespace skyline::gpu {
         u16 baseArrayLayer{};
         u16 layerCount{};
         u32 layerStride{}; //!< An optional hint regarding the size of a single layer, it will be set to 0 when not available
+        u16 levelCount{1}; //!< The amount of mip levels in the texture, every layer holds all of its levels after each other starting with the largest one
 
         GuestTexture() {}
 
-        GuestTexture(Mappings mappings, texture::Dimensions dimensions, texture::Format format, texture::TileConfig tileConfig, texture::TextureType type, u16 baseArrayLayer = 0, u16 layerCount = 1, u32 layerStride = 0)
+        GuestTexture(Mappings mappings, texture::Dimensions dimensions, texture::Format format, texture::TileConfig tileConfig, texture::TextureType type, u16 baseArrayLayer = 0, u16 layerCount = 1, u32 layerStride = 0, u16 levelCount = 1)
             : mappings(mappings),
               dimensions(dimensions),
               format(format),
@@ -273,9 +287,10 @@ namespace skyline::gpu {
               type(type),
               baseArrayLayer(baseArrayLayer),
               layerCount(layerCount),
-              layerStride(layerStride) {}
+              layerStride(layerStride),
+              levelCount(levelCount) {}
 
-        GuestTexture(span <u8> mapping, texture::Dimensions dimensions, texture::Format format, texture::TileConfig tileConfig, texture::TextureType type, u16 baseArrayLayer = 0, u16 layerCount = 1, u32 layerStride = 0)
+        GuestTexture(span <u8> mapping, texture::Dimensions dimensions, texture::Format format, texture::TileConfig tileConfig, texture::TextureType type, u16 baseArrayLayer = 0, u16 layerCount = 1, u32 layerStride = 0, u16 levelCount = 1)
             : mappings(1, mapping),
               dimensions(dimensions),
               format(format),
@@ -283,7 +298,45 @@ namespace skyline::gpu {
               type(type),
               baseArrayLayer(baseArrayLayer),
               layerCount(layerCount),
-              layerStride(layerStride) {}
+              layerStride(layerStride),
+              levelCount(levelCount) {}
+
+        /**
+         * @return The offset between consecutive layers of the texture in guest memory, this is the layer stride hint when it's available and is otherwise calculated from the layout of the texture
+         */
+        size_t GetLayerStride() const;
+
+        /**
+         * @return The dimensions of a mip level, they're padded to entire blocks of compressed formats as that's how levels are laid out in guest memory
+         */
+        texture::Dimensions GetLevelDimensions(u32 level) const;
+
+        /**
+         * @return The tiling of a mip level, the blocks of blocklinear levels shrink alongside the level till they no longer cover more than twice its height or depth
+         */
+        texture::TileConfig GetLevelTileConfig(u32 level) const;
+
+        /**
+         * @return The size of a mip level of a single layer in guest memory
+         */
+        size_t GetLevelSize(u32 level) const;
+
+        /**
+         * @return The offset of a mip level from the start of its layer in guest memory
+         */
+        size_t GetLevelOffset(u32 level) const;
+
+        /**
+         * @return A guest texture covering only a single mip level of a single layer, it has the layout of the level and a mapping covering only it if this texture has a mapping
+         * @note The texture must have at most a single mapping
+         */
+        GuestTexture GetSubresource(u32 level, u32 layer) const;
+
+        /**
+         * @return A hash of the contents of the texture in guest memory and the layout they're interpreted with, textures with equal hashes hold the same image
+         * @note The texture must have exactly a single mapping
+         */
+        u64 GetContentHash() const;
     };
 
     class TextureManager;
@@ -292,9 +345,6 @@ namespace skyline::gpu {
      * @brief A view into a specific subresource of a Texture
      */
     class TextureView {
-      private:
-        vk::raii::ImageView *view{};
-
       public:
         std::shared_ptr<Texture> backing;
         vk::ImageViewType type;
@@ -308,7 +358,8 @@ namespace skyline::gpu {
         TextureView(std::shared_ptr<Texture> backing, vk::ImageViewType type, vk::ImageSubresourceRange range, texture::Format format = {}, vk::ComponentMapping mapping = {});
 
         /**
-         * @return A Vulkan Image View that corresponds to the properties of this view
+         * @return A Vulkan Image View that corresponds to the properties of this view, it's shared with all other views of the texture with the same properties
+         * @note The backing texture **must** be locked prior to calling this
          */
         vk::ImageView GetView();
 
@@ -329,21 +380,138 @@ namespace skyline::gpu {
         using BackingType = std::variant<vk::Image, vk::raii::Image, memory::Image>;
         BackingType backing; //!< The Vulkan image that backs this texture, it is nullable
 
-        std::vector<std::pair<vk::ImageViewCreateInfo, vk::raii::ImageView>> views; //!< VkImageView(s) that have been constructed from this Texture, utilized for caching
+        /**
+         * @brief All properties of a TextureView which determine the VkImageView that is created for it
+         */
+        struct ViewKey {
+            vk::Image image; //!< The backing image which the view was created for, views of prior backings are retained as framebuffers may still reference them
+            vk::ImageViewType type;
+            vk::Format format;
+            vk::ComponentMapping mapping;
+            vk::ImageSubresourceRange range;
+
+            bool operator==(const ViewKey &) const = default;
+        };
+
+        struct ViewKeyHash {
+            size_t operator()(const ViewKey &key) const;
+        };
+
+        std::unordered_map<ViewKey, vk::raii::ImageView, ViewKeyHash> views; //!< VkImageView(s) that have been constructed from this Texture, these are shared between all TextureView(s) with the same properties
+
+        std::shared_ptr<WriteTracker::Trap> trap; //!< A trap tracking CPU writes to the guest texture, host synchronization is skipped when it isn't dirty
+        std::optional<memory::Image> guestResolutionImage; //!< An image at the resolution of the guest texture which is used as the intermediate for blits between the guest and the scaled backing, this only exists for scaled textures
+        vk::Filter scaleFilter{vk::Filter::eNearest}; //!< The filter used for blits between the guest resolution and the scaled backing, this is linear whenever the format supports it
 
         friend TextureManager;
         friend TextureView;
 
+        /**
+         * @brief A single mip level of a single layer of the guest texture alongside its location in a host buffer holding several subresources
+         */
+        struct GuestSubresource {
+            GuestTexture guest; //!< A guest texture covering only the subresource
+            u32 level;
+            u32 layer;
+            vk::Extent3D extent; //!< The extent of the subresource in the host texture, unlike the guest dimensions this isn't padded to entire blocks
+            vk::DeviceSize hostOffset; //!< The offset of the subresource in a tightly packed buffer in the host format
+            vk::DeviceSize hostSize; //!< The size of the subresource in the host format
+        };
+
+        /**
+         * @return If the guest texture consists of more than a single subresource, these are synchronized separately as each level has its own layout and layers may be padded
+         */
+        bool HasSubresources() const {
+            return guest && (guest->levelCount > 1 || guest->layerCount > 1);
+        }
+
+        /**
+         * @return All subresources of the guest texture in the order of guest memory, every layer is followed by the next one with all of its levels, they're packed in the same order in host buffers
+         */
+        std::vector<GuestSubresource> GetGuestSubresources() const;
+
+        /**
+         * @return The size of a tightly packed buffer holding every subresource of the guest texture in the host format
+         */
+        vk::DeviceSize GetHostBufferSize() const;
+
+        /**
+         * @brief Drops all subresources which don't overlap any of the supplied dirty pages of the trap and packs the remaining ones after each other
+         */
+        void FilterDirtySubresources(std::vector<GuestSubresource> &subresources, span<const u64> dirtyPages) const;
+
+        /**
+         * @return A copy region for every supplied subresource between the texture and a buffer holding them at their host offsets
+         */
+        std::vector<vk::BufferImageCopy> GetSubresourceCopies(span<const GuestSubresource> subresources, vk::DeviceSize bufferOffset) const;
+
+        /**
+         * @brief Copies a single subresource of the guest texture into a tightly packed buffer in the host format on the CPU, decoding or deswizzling it as required
+         */
+        void CopyFromGuestSubresource(GuestTexture &subresource, u8 *output);
+
         /**
          * @brief An implementation function for guest -> host texture synchronization, it allocates and copies data into a staging buffer or directly into a linear host texture
          * @return If a staging buffer was required for the texture sync, it's returned filled with guest texture data and must be copied to the host texture by the callee
+         * @param blockLinearBuffer This is set to a buffer with raw blocklinear guest data when the deswizzle should be done by the swizzle pass, the staging buffer will be uninitialized in that case
+         * @param copyRegions This is set to the regions of the staging buffer that need to be copied when only the dirty parts of the texture were synchronized, the staging buffer holds the entire texture if it's empty
+         * @param conversionBuffer This is set to a buffer with linear guest data in the guest format for converted textures, it must be converted into the staging buffer by the format conversion pass which is uninitialized in that case
+         */
+        std::shared_ptr<memory::StagingBuffer> SynchronizeHostImpl(const std::shared_ptr<FenceCycle> &pCycle, std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer, std::vector<vk::BufferImageCopy> &copyRegions, std::shared_ptr<memory::StagingBuffer> &conversionBuffer);
+
+        /**
+         * @return If the texture can be synchronized from only the pages of the guest texture that were written to, this requires a single level and layer 2D blocklinear texture which is uploaded without any conversion or scaling
          */
-        std::shared_ptr<memory::StagingBuffer> SynchronizeHostImpl(const std::shared_ptr<FenceCycle> &pCycle);
+        bool CanSynchronizePartially() const;
+
+        /**
+         * @brief Deswizzles only the blocks of the guest texture which overlap dirty pages into a staging buffer, every horizontal run of dirty blocks is tightly packed in it
+         * @param dirtyPages A bitmap of the dirty pages of the trap
+         * @param copyRegions This is set to a copy region for every run of dirty blocks
+         * @return The staging buffer holding the deswizzled runs, this is nullptr if too much of the texture is dirty for a partial upload to be worthwhile
+         */
+        std::shared_ptr<memory::StagingBuffer> CopyDirtyBlocksFromGuest(span<const u64> dirtyPages, std::vector<vk::BufferImageCopy> &copyRegions);
+
+        /**
+         * @brief Copies the guest texture into a linear buffer in the host format, decoding or deswizzling it as required
+         * @note The buffer is in the guest format for converted textures as the conversion is done on the GPU afterwards
+         * @param bufferPitch The pitch of lines in the buffer if it isn't tightly packed, otherwise zero
+         * @param isStagingBuffer If the buffer is a staging buffer which the swizzle pass can deswizzle into, blockLinearBuffer can only be set in that case
+         * @param blockLinearBuffer This is set to a buffer with raw blocklinear guest data when the deswizzle should be done by the swizzle pass, the buffer will be uninitialized in that case
+         */
+        void CopyFromGuest(u8 *bufferData, vk::DeviceSize bufferPitch, bool isStagingBuffer, std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer);
+
+        /**
+         * @brief Decodes the compressed guest texture into the supplied buffer in the host format, the decoded texture is looked up in and added to the decode cache
+         * @param source The guest texture or a single subresource of it
+         * @param output A tightly packed buffer which is the size of the source in the host format
+         */
+        void DecodeGuest(GuestTexture &source, u8 *output);
+
+        /**
+         * @return A blit region between the entirety of the guest resolution image and the scaled backing
+         * @param toBacking If the guest resolution image is the source of the blit rather than the destination
+         */
+        vk::ImageBlit GetScaledBlit(bool toBacking) const;
 
         /**
          * @brief Records commands for copying data from a staging buffer to the texture's backing into the supplied command buffer
+         * @param blockLinearBuffer A buffer containing raw blocklinear guest data that is deswizzled into the staging buffer on the GPU prior to the copy, if any
+         * @param copyRegions The regions of the staging buffer to copy into the backing, the entire texture is copied if this is empty
+         * @param conversionBuffer A buffer containing linear guest data in the guest format that is converted into the staging buffer on the GPU prior to the copy, if any
+         */
+        void CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, const std::shared_ptr<memory::StagingBuffer> &blockLinearBuffer = {}, span<const vk::BufferImageCopy> copyRegions = {}, const std::shared_ptr<memory::StagingBuffer> &conversionBuffer = {});
+
+        /**
+         * @return If an upload from a staging buffer can be done entirely with transfer commands on the dedicated transfer queue
          */
-        void CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer);
+        bool CanUploadOnTransferQueue() const;
+
+        /**
+         * @brief Records commands for copying data from a staging buffer to the entire backing into a command buffer for the transfer queue, ownership of the backing is released to the graphics queue family afterwards
+         * @note The acquiring half of the ownership transfer is recorded alongside the deferred layout transition by the next command buffer on the graphics queue using the texture
+         */
+        void CopyFromStagingBufferOnTransferQueue(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer);
 
         /**
          * @brief Records commands for copying data from the texture's backing to a staging buffer into the supplied command buffer
@@ -351,49 +519,148 @@ namespace skyline::gpu {
          */
         void CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer);
 
+        /**
+         * @brief Records a conversion of a staging buffer which the backing was copied into back into the guest format for converted textures
+         * @param persistent If the returned buffer is held past the lifetime of the cycle, it isn't suballocated from the staging ring in that case
+         * @return A buffer holding the contents of the staging buffer in the guest format, this is the staging buffer itself if the texture isn't converted
+         * @note The staging buffer is attached to the cycle as it's only read by the GPU in that case
+         */
+        std::shared_ptr<memory::StagingBuffer> ConvertStagingBufferToGuest(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, std::shared_ptr<memory::StagingBuffer> stagingBuffer, bool persistent = false);
+
+        /**
+         * @brief Records a transfer from the supplied source texture into the current texture with both of them transitioned into transfer layouts for its duration
+         * @param sourceSubresource The subresource of the source which is transferred from, it may differ from the subresource of this texture which is transferred to
+         * @param transfer A function which records the transfer commands with the backings of the source and destination
+         * @note Any prior accesses to either texture that aren't transfers must be synchronized with the transfer stage by the caller, the CommandExecutor does so for textures attached with transfer accesses
+         */
+        void RecordTransferFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageSubresourceRange &sourceSubresource, const vk::ImageSubresourceRange &subresource, const std::function<void(vk::Image, vk::Image)> &transfer);
+
+        /**
+         * @return A staging buffer for transfers to or from the texture, it's suballocated from the staging ring when possible
+         */
+        std::shared_ptr<memory::StagingBuffer> AllocateStagingBuffer(vk::DeviceSize size);
+
+        /**
+         * @return A buffer for the swizzle pass to write blocklinear guest data into, this is null if the guest texture must be swizzled on the CPU instead
+         */
+        std::shared_ptr<memory::StagingBuffer> AllocateBlockLinearBuffer();
+
+        /**
+         * @return A pointer to the first texel of the CPU mapping of the linear image backing the texture
+         * @param rowPitch Set to the pitch of lines in the mapping if it isn't tightly packed, otherwise zero
+         */
+        u8 *GetMappedBacking(vk::DeviceSize &rowPitch);
+
+        /**
+         * @brief Creates a trap for tracking CPU writes to the guest texture if it can be tracked
+         */
+        void CreateTrap();
+
         /**
          * @brief Copies data from the supplied host buffer into the guest texture
+         * @param hostPitch The pitch of lines in the host buffer if it isn't tightly packed, this is only supported for pitch and linear guest textures
          * @note The host buffer must be contain the entire image
+         * @note The guest texture is considered to be in sync with the host texture after this, any writes to it prior are discarded
+         * @param parallel If blocklinear textures can be swizzled on the copy pool, this must be false when called from the trap's access callback as the faulting thread may be inside a job of the pool already
+         * @note The trap isn't protected by this, the caller is responsible for protecting it afterwards if it isn't being accessed from the trap's access callback
          */
-        void CopyToGuest(u8 *hostBuffer);
+        void CopyToGuest(u8 *hostBuffer, vk::DeviceSize hostPitch = 0, bool parallel = true);
 
         /**
          * @brief A FenceCycleDependency that copies the contents of a staging buffer or mapped image backing the texture to the guest texture
+         * @note If a blocklinear buffer is supplied, it's already been swizzled on the GPU and is copied into the guest mapping verbatim
          */
         struct TextureBufferCopy : public FenceCycleDependency {
             std::shared_ptr<Texture> texture;
             std::shared_ptr<memory::StagingBuffer> stagingBuffer;
+            std::shared_ptr<memory::StagingBuffer> blockLinearBuffer;
 
-            TextureBufferCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer = {});
+            TextureBufferCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer = {}, std::shared_ptr<memory::StagingBuffer> blockLinearBuffer = {});
 
             ~TextureBufferCopy();
         };
 
+        /**
+         * @brief A FenceCycleDependency that traps all accesses to the guest texture to copy the contents of a linear staging buffer to it on the first access
+         * @note This avoids copying and swizzling textures on the CPU that are only accessed on the GPU, such as most render targets
+         * @note The texture must have a trap and the staging buffer must not be modified after this
+         */
+        struct DeferredTextureCopy : public FenceCycleDependency {
+            std::shared_ptr<Texture> texture;
+            std::shared_ptr<memory::StagingBuffer> stagingBuffer;
+
+            DeferredTextureCopy(std::shared_ptr<Texture> texture, std::shared_ptr<memory::StagingBuffer> stagingBuffer);
+
+            ~DeferredTextureCopy();
+        };
+
       public:
         std::weak_ptr<FenceCycle> cycle; //!< A fence cycle for when any host operation mutating the texture has completed, it must be waited on prior to any mutations to the backing
+        AccessState accessState; //!< The GPU accesses to the texture from nodes in the command stream, this is only used by the CommandExecutor
         std::optional<GuestTexture> guest;
         texture::Dimensions dimensions;
         texture::Format format;
-        vk::ImageLayout layout;
+        vk::ImageLayout layout; //!< The layout of the backing as seen by any commands recorded from now on, this includes any deferred transition
+        std::optional<vk::ImageLayout> backingLayout; //!< The layout the backing is actually in while a transition from it into 'layout' is deferred, this is empty without a deferred transition
+        u32 acquireQueueFamily{VK_QUEUE_FAMILY_IGNORED}; //!< The queue family which has released ownership of the backing to the graphics queue family, it's acquired alongside the deferred layout transition, this is VK_QUEUE_FAMILY_IGNORED without a pending acquire
         vk::ImageTiling tiling;
+        vk::ImageUsageFlags usage{}; //!< The usage flags that the backing was created with, this is empty for textures which wrap an externally created backing
         u32 mipLevels;
         u32 layerCount; //!< The amount of array layers in the image, utilized for efficient binding (Not to be confused with the depth or faces in a cubemap)
         vk::SampleCountFlagBits sampleCount;
+        float resolutionScale{1.0f}; //!< The factor that the dimensions of the host texture are scaled by relative to the guest texture, all guest transfers are scaled to and from the guest resolution
+        texture::FormatConversion conversion{}; //!< The conversion between the guest format and the host format of the texture, the host format only differs from the guest format if this isn't None or the texture is transcoded
+        bool transient{}; //!< If the texture is a transient attachment, its contents are never loaded into or stored from a render pass so they never leave tile memory on tilers
+        std::atomic<u64> lastUsedFrame{}; //!< The index of the frame in which the texture was last looked up through the TextureManager, textures which haven't been used for long are evicted first
+        std::atomic<bool> presentable{}; //!< If the texture has been presented by the guest, rendering into it may be skipped for frames which are dropped by frame skipping
+        std::atomic<bool> presentSkipped{}; //!< If rendering into the texture was skipped since it was last presented, its next presentation must be dropped as its contents are incomplete
+        std::atomic<u64> contentHash{}; //!< The GuestTexture::GetContentHash of the guest contents the host texture was initialized with while they haven't been modified by the GPU since, this is 0 when it's unknown and is only valid while the trap is clean
+        std::atomic<u32> pendingRecords{}; //!< The amount of executed submissions that the texture is attached to which haven't been recorded yet, its state only reflects the nodes of these once they have been
 
         Texture(GPU &gpu, BackingType &&backing, GuestTexture guest, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout layout, vk::ImageTiling tiling, u32 mipLevels = 1, u32 layerCount = 1, vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1);
 
         Texture(GPU &gpu, BackingType &&backing, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout layout, vk::ImageTiling tiling, u32 mipLevels = 1, u32 layerCount = 1, vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1);
 
-        Texture(GPU &gpu, GuestTexture guest);
+        /**
+         * @param resolutionScale The factor to scale the host texture by, this is only applied to uncompressed 2D textures which the host can blit and is ignored otherwise
+         */
+        Texture(GPU &gpu, GuestTexture guest, float resolutionScale = 1.0f);
 
         /**
          * @brief Creates and allocates memory for the backing to creates a texture object wrapping it
          * @param usage Usage flags that will applied aside from VK_IMAGE_USAGE_TRANSFER_SRC_BIT/VK_IMAGE_USAGE_TRANSFER_DST_BIT which are mandatory
+         * @note If the usage includes VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT then the texture is a transient attachment, it's backed by lazily allocated memory where possible and must only be used as an attachment which doesn't need to be loaded or stored, such as a depth buffer or multisampled color attachment which is resolved in the same render pass
          */
         Texture(GPU &gpu, texture::Dimensions dimensions, texture::Format format, vk::ImageLayout initialLayout = vk::ImageLayout::eGeneral, vk::ImageUsageFlags usage = {}, vk::ImageTiling tiling = vk::ImageTiling::eOptimal, u32 mipLevels = 1, u32 layerCount = 1, vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1);
 
         ~Texture();
 
+        /**
+         * @return If the guest texture is in a compressed format which is decoded on the CPU into the host format as the host GPU can't sample from it
+         */
+        bool IsTranscoded() const {
+            return guest && guest->format != format && guest->format->IsCompressed();
+        }
+
+        /**
+         * @return If the guest texture is in a format which the host GPU can't render to and is converted into a wider host format on the GPU during synchronization
+         */
+        bool IsConverted() const {
+            return conversion != texture::FormatConversion::None;
+        }
+
+        /**
+         * @return If the host texture is rendered at a different resolution than the guest texture
+         */
+        bool IsScaled() const {
+            return resolutionScale != 1.0f;
+        }
+
+        /**
+         * @return The supplied rectangle in guest texture coordinates scaled to the host texture, it's clamped to the bounds of the host texture
+         */
+        vk::Rect2D ScaleRect(vk::Rect2D rect) const;
+
         /**
          * @note The handle returned is nullable and the appropriate precautions should be taken
          */
@@ -442,6 +709,19 @@ namespace skyline::gpu {
          */
         void WaitOnFence();
 
+        /**
+         * @brief Waits on the fence cycle of the texture unless it's the supplied cycle or the supplied cycle is ordered after it on the GPU
+         * @note Tracked cycles are ordered after prior tracked cycles by the barriers of the command executor, the host only needs to wait on accesses it doesn't track
+         * @note The texture **must** be locked prior to calling this
+         */
+        void WaitOnFence(const std::shared_ptr<FenceCycle> &pCycle);
+
+        /**
+         * @brief Waits on all submissions that the texture is attached to being recorded, this must be done prior to any CPU-side changes to the state of the texture so they're ordered after the nodes of the submissions
+         * @note The texture **must not** be locked prior to calling this as the recording thread locks it
+         */
+        void WaitOnRecord();
+
         /**
          * @note All memory residing in the current backing is not copied to the new backing, it must be handled externally
          * @note The texture **must** be locked prior to calling this
@@ -454,6 +734,28 @@ namespace skyline::gpu {
          */
         void TransitionLayout(vk::ImageLayout layout);
 
+        /**
+         * @brief Defers the transition of the backing to the supplied layout till the next command buffer using the texture is recorded, this avoids a submission for every transition
+         * @note This must only be used on backings which haven't been used by the GPU yet, such as newly created ones, as the barrier doesn't synchronize with any prior access
+         * @note The contents of the backing are only retained across the transition if it's in the preinitialized layout
+         * @note The texture **must** be locked prior to calling this
+         */
+        void DeferLayoutTransition(vk::ImageLayout layout);
+
+        /**
+         * @brief Appends the barrier for a deferred layout transition if there is one, this allows the transitions of several textures to be batched into a single pipeline barrier
+         * @note The barriers **must** be recorded with a source stage of VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT and a destination stage of VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+         * @note The texture **must** be locked prior to calling this
+         */
+        void RecordDeferredLayout(std::vector<vk::ImageMemoryBarrier> &barriers);
+
+        /**
+         * @brief Records the barrier for a deferred layout transition if there is one, this must be called prior to recording any commands which use the backing
+         * @note Any pending acquire of the ownership of the backing from another queue family is a part of the deferred transition
+         * @note The texture **must** be locked prior to calling this
+         */
+        void RecordDeferredLayout(const vk::raii::CommandBuffer &commandBuffer);
+
         /**
          * @brief Converts the texture to have the specified format
          */
@@ -476,6 +778,14 @@ namespace skyline::gpu {
          */
         void SynchronizeHostWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle);
 
+        /**
+         * @brief Uploads the guest texture directly into a texture with the same format and dimensions rather than into this texture, this avoids an upload followed by a copy of the entire texture
+         * @return If the upload was done, this is only the case when the guest texture has been written to by the CPU since it was last synchronized and doesn't need to be decoded
+         * @note The host texture isn't updated by this, it remains dirty and will be uploaded on its next synchronization
+         * @note The texture **must** be locked prior to calling this
+         */
+        bool SynchronizeHostInto(const std::shared_ptr<Texture> &destination);
+
         /**
          * @brief Synchronizes the guest texture with the host texture after it has been modified
          * @note The texture **must** be locked prior to calling this
@@ -486,11 +796,46 @@ namespace skyline::gpu {
         /**
          * @brief Synchronizes the guest texture with the host texture after it has been modified
          * @note It is more efficient to call SynchronizeHost than allocating a command buffer purely for this function as it may conditionally not record any commands
+         * @note If the guest texture is trapped, the copy to it is deferred till it's accessed by the CPU rather than being done when the cycle is signalled
          * @note The texture **must** be locked prior to calling this
          * @note The guest texture should not be null prior to calling this
          */
         void SynchronizeGuestWithBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle);
 
+        /**
+         * @brief Records a copy of the contents of the supplied source texture into the current texture into the command buffer
+         * @note The source must have the same dimensions and format as this texture and a defined layout by the time the command buffer is executed
+         * @note Both textures **must** be locked prior to calling this, the caller is responsible for attaching them to the cycle of the command buffer
+         */
+        void RecordCopyFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageSubresourceRange &subresource = vk::ImageSubresourceRange{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS,
+        });
+
+        /**
+         * @brief Records a blit of a region of the supplied source texture into the current texture, this may scale and convert the format of the region
+         * @note The region must lie within both textures and their formats must support being blitted from and to
+         * @note Both textures **must** be locked prior to calling this, the caller is responsible for attaching them to the cycle of the command buffer
+         */
+        void RecordBlitFrom(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<Texture> &source, const vk::ImageBlit &region, vk::Filter filter);
+
+        /**
+         * @brief Copies the contents of a texture with an incompatible format but an identical guest memory layout into this texture on the GPU, the contents are reinterpreted as the format of this texture
+         * @return If the copy was done, this is only the case if the host texture of the source is up to date and this texture hasn't been used yet as the copy would otherwise discard newer contents
+         * @note The guest textures of both textures must only differ in their format and width with the same amount of bytes in each line
+         * @note Both textures **must** be locked prior to calling this
+         */
+        bool ReinterpretFrom(const std::shared_ptr<Texture> &source);
+
+        /**
+         * @brief Initializes this texture by copying the contents of a texture with identical guest contents on the GPU rather than uploading them from the guest
+         * @return If the copy was done, this is only the case if the guest contents of this texture still match the host contents of the source and this texture hasn't been used yet
+         * @note The source must have the same dimensions, format and guest layout as this texture
+         * @note Both textures **must** be locked prior to calling this
+         */
+        bool DuplicateFrom(const std::shared_ptr<Texture> &source);
+
         /**
          * @brief Copies the contents of the supplied source texture into the current texture
          */
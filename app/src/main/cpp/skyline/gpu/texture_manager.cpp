@@ -1,37 +1,41 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <gpu.h>
+#include <common/trace.h>
 #include "texture_manager.h"
 
 namespace skyline::gpu {
-    TextureManager::TextureManager(GPU &gpu) : gpu(gpu) {}
+    TextureManager::TextureManager(GPU &gpu, u32 resolutionScale, bool deduplication) : gpu(gpu), resolutionScale(static_cast<float>(resolutionScale) / 100.0f), deduplication(deduplication) {}
 
-    TextureView TextureManager::FindOrCreate(const GuestTexture &guestTexture) {
+    std::optional<TextureView> TextureManager::Find(const GuestTexture &guestTexture) {
         auto guestMapping{guestTexture.mappings.front()};
 
         // Iterate over all textures that overlap with the first mapping of the guest texture and compare the mappings:
         // 1) All mappings match up perfectly, we check that the rest of the supplied mappings correspond to mappings in the texture
         // 1.1) If they match as well, we check for format/dimensions/tiling config matching the texture and return or move onto (3)
         // 2) Only a contiguous range of mappings match, we check for if the overlap is meaningful with layout math, it can go two ways:
-        // 2.1) If there is a meaningful overlap, we check for format/dimensions/tiling config compatibility and return or move onto (3)
-        // 2.2) If there isn't, we move onto (3)
+        // 2.1) If the guest texture starts at a layer boundary and has the same layer layout, we return a view of the corresponding layers
+        // 2.2) If it doesn't, we move onto (3)
         // 3) If there's another overlap we go back to (1) with it else we go to (4)
         // 4) We check all the overlapping texture for if they're in the texture pool:
         // 4.1) If they are, we do nothing to them
         // 4.2) If they aren't, we delete them from the map
         // 5) Create a new texture and insert it in the map then return it
 
-        std::scoped_lock lock(mutex);
-        std::shared_ptr<Texture> match{};
-        auto mappingEnd{std::upper_bound(textures.begin(), textures.end(), guestMapping)}, hostMapping{mappingEnd};
-        while (hostMapping != textures.begin() && (--hostMapping)->end() > guestMapping.begin()) {
-            auto &hostMappings{hostMapping->texture->guest->mappings};
-            if (!hostMapping->contains(guestMapping))
+        // Any mapping which contains the guest mapping must overlap the region of its first byte, so we only need to check that bucket
+        auto region{regions.find(reinterpret_cast<u64>(guestMapping.data()) >> RegionBits)};
+        if (region == regions.end())
+            return std::nullopt;
+
+        for (auto &hostMapping : region->second) {
+            auto &hostMappings{hostMapping.texture->guest->mappings};
+            if (!hostMapping.contains(guestMapping))
                 continue;
 
             // We need to check that all corresponding mappings in the candidate texture and the guest texture match up
             // Only the start of the first matched mapping and the end of the last mapping can not match up as this is the case for views
-            auto firstHostMapping{hostMapping->iterator};
+            auto firstHostMapping{hostMapping.iterator};
             auto lastGuestMapping{guestTexture.mappings.back()};
             auto lastHostMapping{std::find_if(firstHostMapping, hostMappings.end(), [&lastGuestMapping](const span<u8> &it) {
                 return lastGuestMapping.begin() > it.begin() && lastGuestMapping.end() > it.end();
@@ -42,38 +46,247 @@ namespace skyline::gpu {
 
             if (firstHostMapping == hostMappings.begin() && firstHostMapping->begin() == guestMapping.begin() && mappingMatch && lastHostMapping == hostMappings.end() && lastGuestMapping.end() == std::prev(lastHostMapping)->end()) {
                 // We've gotten a perfect 1:1 match for *all* mappings from the start to end, we just need to check for compatibility aside from this
-                auto &matchGuestTexture{*hostMapping->texture->guest};
+                auto &matchGuestTexture{*hostMapping.texture->guest};
                 if (matchGuestTexture.format->IsCompatible(*guestTexture.format) && matchGuestTexture.dimensions == guestTexture.dimensions && matchGuestTexture.tileConfig == guestTexture.tileConfig) {
-                    auto &texture{hostMapping->texture};
+                    auto &texture{hostMapping.texture};
+                    texture->lastUsedFrame.store(frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
                     return TextureView(texture, static_cast<vk::ImageViewType>(guestTexture.type), vk::ImageSubresourceRange{
                         .aspectMask = guestTexture.format->vkAspect,
                         .levelCount = texture->mipLevels,
                         .layerCount = texture->layerCount,
                     }, guestTexture.format);
                 }
-            } /* else if (mappingMatch) {
-                // We've gotten a partial match with a certain subset of contiguous mappings matching, we need to check if this is a meaningful overlap
-                if (MeaningfulOverlap) {
-                    // TODO: Layout Checks + Check match against Base Layer in TIC
-                    auto &texture{hostMapping->texture};
-                    return TextureView(texture, static_cast<vk::ImageViewType>(guestTexture.type), vk::ImageSubresourceRange{
-                        .aspectMask = guestTexture.format->vkAspect,
-                        .levelCount = texture->mipLevels,
-                        .layerCount = texture->layerCount,
-                    }, guestTexture.format);
-                }
-            } */
+            }
+
+            // We've gotten a partial match with only a subrange of the texture overlapping, we need to check if this is a meaningful overlap
+            if (auto view{FindLayerView(hostMapping, guestTexture)})
+                return view;
+        }
+
+        return std::nullopt;
+    }
+
+    bool TextureManager::ContainsMappings(const TextureMapping &hostMapping, const GuestTexture &guestTexture) {
+        // Every guest mapping must correspond to a host mapping, only the start of the first and the end of the last guest mapping can lie inside one
+        auto &hostMappings{hostMapping.texture->guest->mappings};
+        auto hostIt{hostMapping.iterator};
+        for (auto guestIt{guestTexture.mappings.begin()}; guestIt != guestTexture.mappings.end(); guestIt++, hostIt++) {
+            bool first{guestIt == guestTexture.mappings.begin()}, last{std::next(guestIt) == guestTexture.mappings.end()};
+            if (hostIt == hostMappings.end() || (first ? guestIt->begin() < hostIt->begin() : guestIt->begin() != hostIt->begin()) || (last ? guestIt->end() > hostIt->end() : guestIt->end() != hostIt->end()))
+                return false;
+        }
+        return true;
+    }
+
+    std::optional<TextureView> TextureManager::FindLayerView(const TextureMapping &hostMapping, const GuestTexture &guestTexture) {
+        auto &texture{hostMapping.texture};
+        auto &hostGuest{*texture->guest};
+        if (!hostGuest.format->IsCompatible(*guestTexture.format) || hostGuest.dimensions != guestTexture.dimensions || !(hostGuest.tileConfig == guestTexture.tileConfig) || !ContainsMappings(hostMapping, guestTexture))
+            return std::nullopt;
+
+        // The offset of the guest texture into the texture is its offset into the host mapping alongside the size of all host mappings prior to it
+        auto offset{static_cast<size_t>(guestTexture.mappings.front().data() - hostMapping.data())};
+        for (auto it{hostGuest.mappings.begin()}; it != hostMapping.iterator; it++)
+            offset += it->size();
+
+        auto layerStride{hostGuest.GetLayerStride()};
+        if (!layerStride || offset % layerStride)
+            return std::nullopt;
+
+        auto baseLayer{offset / layerStride};
+        if (baseLayer + guestTexture.layerCount > texture->layerCount)
+            return std::nullopt;
+
+        texture->lastUsedFrame.store(frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return TextureView(texture, static_cast<vk::ImageViewType>(guestTexture.type), vk::ImageSubresourceRange{
+            .aspectMask = guestTexture.format->vkAspect,
+            .levelCount = texture->mipLevels,
+            .baseArrayLayer = static_cast<u32>(baseLayer),
+            .layerCount = guestTexture.layerCount,
+        }, guestTexture.format);
+    }
+
+    std::shared_ptr<Texture> TextureManager::FindReinterpretable(const GuestTexture &guestTexture) {
+        auto region{regions.find(reinterpret_cast<u64>(guestTexture.mappings.front().data()) >> RegionBits)};
+        if (region == regions.end())
+            return nullptr;
+
+        auto &format{*guestTexture.format};
+        if (format.IsCompressed() || format.vkAspect != vk::ImageAspectFlagBits::eColor)
+            return nullptr;
+
+        for (auto &hostMapping : region->second) {
+            auto &hostGuest{*hostMapping.texture->guest};
+            auto &hostFormat{*hostGuest.format};
+            bool mappingsMatch{std::equal(hostGuest.mappings.begin(), hostGuest.mappings.end(), guestTexture.mappings.begin(), guestTexture.mappings.end(), [](const span<u8> &lhs, const span<u8> &rhs) {
+                return lhs.data() == rhs.data() && lhs.size() == rhs.size();
+            })};
+
+            // Lines of both textures must have the same amount of bytes for their contents to be laid out identically in guest memory and in a tightly packed buffer
+            if (mappingsMatch && !hostFormat.IsCompatible(format) && !hostFormat.IsCompressed() && hostFormat.vkAspect == vk::ImageAspectFlagBits::eColor && hostGuest.tileConfig == guestTexture.tileConfig && hostGuest.layerCount == guestTexture.layerCount
+                && hostGuest.dimensions.height == guestTexture.dimensions.height && hostGuest.dimensions.depth == guestTexture.dimensions.depth && hostGuest.dimensions.width * hostFormat.bpb == guestTexture.dimensions.width * format.bpb)
+                return hostMapping.texture;
+        }
+
+        return nullptr;
+    }
+
+    std::shared_ptr<Texture> TextureManager::FindDuplicate(const GuestTexture &guestTexture) {
+        if (guestTexture.mappings.size() != 1 || guestTexture.levelCount != 1)
+            return nullptr;
+
+        auto hash{guestTexture.GetContentHash()};
+        std::scoped_lock lock(contentMutex);
+        auto content{contents.find(hash)};
+        if (content == contents.end())
+            return nullptr;
+
+        auto texture{content->second.lock()};
+        if (!texture || texture->contentHash.load(std::memory_order_relaxed) != hash)
+            return nullptr;
+
+        // The layout covered by the hash doesn't include the amount of layers, it only differs in the size of the mapping otherwise
+        if (texture->guest->layerCount != guestTexture.layerCount)
+            return nullptr;
+        return texture;
+    }
+
+    void TextureManager::IndexContents(const std::shared_ptr<Texture> &texture) {
+        if (!deduplication || texture->guest->mappings.size() != 1 || texture->guest->levelCount != 1)
+            return;
+
+        auto hash{texture->guest->GetContentHash()};
+        texture->contentHash.store(hash, std::memory_order_relaxed);
+
+        std::scoped_lock lock(contentMutex);
+        contents[hash] = texture;
+    }
+
+    void TextureManager::Insert(TextureMapping &&mapping) {
+        auto start{reinterpret_cast<u64>(mapping.data()) >> RegionBits}, end{(reinterpret_cast<u64>(mapping.data()) + mapping.size() - 1) >> RegionBits};
+        for (auto region{start}; region < end; region++)
+            regions[region].push_back(mapping);
+        regions[end].push_back(std::move(mapping));
+    }
+
+    void TextureManager::Evict() {
+        std::vector<std::shared_ptr<Texture>> evicted;
+        {
+            std::unique_lock lock(mutex);
+
+            // A texture is only referenced by the manager when all references to it are copies of its mappings, any view of it elsewhere holds another reference
+            struct Candidate {
+                const std::shared_ptr<Texture> *texture;
+                long mappings;
+            };
+            std::unordered_map<Texture *, Candidate> candidates;
+            for (auto &[index, mappings] : regions)
+                for (auto &mapping : mappings)
+                    candidates.try_emplace(mapping.texture.get(), Candidate{&mapping.texture}).first->second.mappings++;
+
+            auto currentFrame{frame.load(std::memory_order_relaxed)};
+            std::vector<const std::shared_ptr<Texture> *> cold;
+            for (auto &[texture, candidate] : candidates)
+                if (candidate.texture->use_count() == candidate.mappings && currentFrame - texture->lastUsedFrame.load(std::memory_order_relaxed) >= EvictionAge)
+                    cold.push_back(candidate.texture);
+
+            if (cold.empty())
+                return;
+
+            auto evictionCount{std::min(cold.size(), MaxEvictionsPerFrame)};
+            std::partial_sort(cold.begin(), cold.begin() + static_cast<ssize_t>(evictionCount), cold.end(), [](const std::shared_ptr<Texture> *lhs, const std::shared_ptr<Texture> *rhs) {
+                return (*lhs)->lastUsedFrame.load(std::memory_order_relaxed) < (*rhs)->lastUsedFrame.load(std::memory_order_relaxed);
+            });
+
+            std::unordered_set<Texture *> evictedSet;
+            evicted.reserve(evictionCount);
+            for (auto it{cold.begin()}; it != cold.begin() + static_cast<ssize_t>(evictionCount); it++) {
+                evicted.push_back(**it);
+                evictedSet.emplace((*it)->get());
+            }
+
+            for (auto it{regions.begin()}; it != regions.end();) {
+                std::erase_if(it->second, [&](const TextureMapping &mapping) { return evictedSet.contains(mapping.texture.get()); });
+                if (it->second.empty())
+                    it = regions.erase(it);
+                else
+                    it++;
+            }
+        }
+
+        if (deduplication) {
+            std::scoped_lock contentLock(contentMutex);
+            std::erase_if(contents, [](const auto &content) { return content.second.expired(); });
+        }
+
+        // The textures are destroyed after the mutex is released as their destruction may need to wait on the GPU
+        TRACE_EVENT_INSTANT("gpu", "TextureManager::Evict", "Count", evicted.size());
+        evicted.clear();
+    }
+
+    void TextureManager::EndFrame() {
+        auto currentFrame{frame.fetch_add(1, std::memory_order_relaxed) + 1};
+        gpu.memory.SetCurrentFrame(static_cast<u32>(currentFrame));
+        if (gpu.memory.IsOverBudget())
+            Evict();
+    }
+
+    std::shared_ptr<Texture> TextureManager::Lookup(u8 *guestAddress) {
+        std::shared_lock lock(mutex);
+        auto region{regions.find(reinterpret_cast<u64>(guestAddress) >> RegionBits)};
+        if (region == regions.end())
+            return nullptr;
+
+        for (auto &hostMapping : region->second) {
+            auto &hostMappings{hostMapping.texture->guest->mappings};
+            if (hostMapping.data() == guestAddress && hostMapping.iterator == hostMappings.begin() && hostMappings.size() == 1) {
+                hostMapping.texture->lastUsedFrame.store(frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                hostMapping.texture->contentHash.store(0, std::memory_order_relaxed); // The texture may be written to by the copy, it can't be duplicated from till it's synchronized again
+                return hostMapping.texture;
+            }
+        }
+
+        return nullptr;
+    }
+
+    TextureView TextureManager::FindOrCreate(const GuestTexture &guestTexture, bool renderTarget) {
+        {
+            // Lookups are far more common than insertions so we first try to find a match with shared access, this allows concurrent lookups from several channels
+            std::shared_lock lock(mutex);
+            if (auto view{Find(guestTexture)}) {
+                if (renderTarget)
+                    view->backing->contentHash.store(0, std::memory_order_relaxed); // Rendering into the texture makes its host contents diverge from the ones it was indexed with
+                return *view;
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        if (auto view{Find(guestTexture)}) {
+            if (renderTarget)
+                view->backing->contentHash.store(0, std::memory_order_relaxed);
+            return *view; // Another thread may have created a matching texture between us releasing the shared lock and acquiring exclusive access
         }
 
         // Create a texture as we cannot find one that matches
-        auto texture{std::make_shared<Texture>(gpu, guestTexture)};
-        auto it{texture->guest->mappings.begin()};
-        textures.emplace(mappingEnd, TextureMapping{texture, it, guestMapping});
-        while ((++it) != texture->guest->mappings.end()) {
-            guestMapping = *it;
-            auto mapping{std::upper_bound(textures.begin(), textures.end(), guestMapping)};
+        auto reinterpretable{FindReinterpretable(guestTexture)};
+        auto duplicate{deduplication && !reinterpretable && !renderTarget ? FindDuplicate(guestTexture) : nullptr};
+        auto texture{std::make_shared<Texture>(gpu, guestTexture, renderTarget ? resolutionScale * resolutionScaleFactor.load(std::memory_order_relaxed) : 1.0f)};
+        texture->lastUsedFrame.store(frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (auto it{texture->guest->mappings.begin()}; it != texture->guest->mappings.end(); it++)
             // TODO: Delete overlapping textures that aren't in texture pool
-            textures.emplace(mapping, TextureMapping{texture, it, guestMapping});
+            Insert(TextureMapping{texture, it, *it});
+
+        if (reinterpretable) {
+            // The textures are only locked after the mutex is released as the holder of a texture lock may be waiting on the mutex, the source may still have nodes writing to it pending recording
+            lock.unlock();
+            reinterpretable->WaitOnRecord();
+            std::scoped_lock textureLock(*reinterpretable, *texture);
+            texture->ReinterpretFrom(reinterpretable);
+        } else if (duplicate) {
+            lock.unlock();
+            duplicate->WaitOnRecord();
+            std::scoped_lock textureLock(*duplicate, *texture);
+            texture->DuplicateFrom(duplicate);
         }
 
         return TextureView(texture, static_cast<vk::ImageViewType>(guestTexture.type), vk::ImageSubresourceRange{
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <shared_mutex>
+#include <unordered_set>
 #include "texture/texture.h"
 #include <random>
 
@@ -26,16 +28,105 @@ namespace skyline::gpu {
                   iterator(iterator) {}
         };
 
+        static constexpr size_t RegionBits{16}; //!< The log2 of the size of the regions that the address space is split into for indexing texture mappings, this is larger than a page to avoid large textures occupying thousands of buckets
+        static constexpr size_t RegionSize{1ULL << RegionBits};
+
         GPU &gpu;
-        std::mutex mutex; //!< Synchronizes access to the texture mappings
-        std::vector<TextureMapping> textures; //!< A sorted vector of all texture mappings
+        float resolutionScale; //!< The factor that render targets are scaled by relative to their guest resolution
+        std::atomic<float> resolutionScaleFactor{1.0f}; //!< A factor that the resolution scale is multiplied by for render targets created from now on, this is lowered by the thermal policy
+        std::shared_mutex mutex; //!< Synchronizes access to the texture mappings, lookups only require shared access while insertions require exclusive access
+        std::unordered_map<u64, std::vector<TextureMapping>> regions; //!< A map from the index of a region to all texture mappings which overlap it, any mapping containing an address can be found in the bucket of that address
+
+        static constexpr u64 EvictionAge{120}; //!< The minimum amount of frames since a texture was last used for it to be evicted
+        static constexpr size_t MaxEvictionsPerFrame{32}; //!< The maximum amount of textures evicted in a single frame, this spreads out the cost of destroying them while the budget is checked again every frame
+        std::atomic<u64> frame{}; //!< The index of the current frame, textures are stamped with it whenever they're looked up
+
+        bool deduplication; //!< If textures are indexed by their guest contents so new textures with the same contents as an existing one are copied from it on the GPU
+        std::mutex contentMutex; //!< Synchronizes access to the content index, this is separate from the mutex as textures are indexed while they're synchronized
+        std::unordered_map<u64, std::weak_ptr<Texture>> contents; //!< A map from GuestTexture::GetContentHash to the last texture which was initialized with those contents
+
+        /**
+         * @brief Evicts the least recently used textures which aren't referenced outside of the manager and haven't been used in the last EvictionAge frames
+         * @note The guest copy of an evicted texture is up to date as it's synchronized back after every use, it's recreated from the guest texture on its next lookup
+         */
+        void Evict();
+
+        /**
+         * @return A view of a pre-existing texture which matches the guest texture, or nothing if there is none
+         * @note The mutex must be locked, shared locking is sufficient
+         */
+        std::optional<TextureView> Find(const GuestTexture &guestTexture);
+
+        /**
+         * @return If the mappings of the guest texture are a contiguous subrange of the mappings of the texture, starting in the supplied mapping
+         */
+        static bool ContainsMappings(const TextureMapping &hostMapping, const GuestTexture &guestTexture);
+
+        /**
+         * @return A view of the layers of the texture in the supplied mapping which the guest texture corresponds to, or nothing if it doesn't start at a layer boundary or the layouts of the layers differ
+         * @note The mutex must be locked, shared locking is sufficient
+         */
+        std::optional<TextureView> FindLayerView(const TextureMapping &hostMapping, const GuestTexture &guestTexture);
+
+        /**
+         * @return A texture with the same mappings and memory layout as the guest texture but an incompatible format, or null if there is none
+         * @note The contents of such a texture can be reinterpreted as the guest texture with a copy on the GPU rather than uploading the guest texture
+         * @note The mutex must be locked, shared locking is sufficient
+         */
+        std::shared_ptr<Texture> FindReinterpretable(const GuestTexture &guestTexture);
+
+        /**
+         * @return A texture which was initialized with the same guest contents as the guest texture, or null if there is none
+         * @note The returned texture may have been modified since, Texture::DuplicateFrom verifies that its contents are still identical
+         */
+        std::shared_ptr<Texture> FindDuplicate(const GuestTexture &guestTexture);
+
+        /**
+         * @brief Inserts a mapping into the buckets of all regions it overlaps
+         * @note The mutex must be locked exclusively
+         */
+        void Insert(TextureMapping &&mapping);
 
       public:
-        TextureManager(GPU &gpu);
+        /**
+         * @param resolutionScale The percentage of the guest resolution that render targets are created at
+         * @param deduplication If textures with identical guest contents should be copied from each other on the GPU rather than being uploaded individually
+         */
+        TextureManager(GPU &gpu, u32 resolutionScale, bool deduplication);
+
+        /**
+         * @brief Sets the factor that the resolution scale is multiplied by for render targets which are created after this
+         * @note Existing render targets retain their scale till they're evicted and recreated, rendering at mixed scales is already possible with formats that can't be scaled
+         */
+        void SetResolutionScaleFactor(float factor) {
+            resolutionScaleFactor.store(factor, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records the current guest contents of the texture in its content hash and indexes it by them, this does nothing if deduplication is disabled
+         * @note This must be called while the trap of the texture is protected and before the guest texture is read from, any writes during the read will dirty the trap and invalidate the hash
+         * @note The texture **must** be locked prior to calling this
+         */
+        void IndexContents(const std::shared_ptr<Texture> &texture);
+
+        /**
+         * @return A pre-existing texture which is backed by a single CPU mapping starting at the supplied address, or null if there is none
+         * @note This never creates a texture, it's used by copies which can only be done on the host GPU when they cover an existing texture
+         */
+        std::shared_ptr<Texture> Lookup(u8 *guestAddress);
 
         /**
          * @return A pre-existing or newly created Texture object which matches the specified criteria
+         * @param renderTarget If the texture is rendered to by the GPU, it's created at the scaled resolution if it doesn't exist yet
+         * @note Pre-existing textures are returned regardless of their scale, so textures sampled by the guest always alias the same host texture as the render target they were written by
+         * @note A guest texture corresponding to a range of layers of a pre-existing texture with a compatible format is returned as a view of those layers
+         */
+        TextureView FindOrCreate(const GuestTexture &guestTexture, bool renderTarget = false);
+
+        /**
+         * @brief Progresses to the next frame, textures which are unused are evicted if device memory is over budget
+         * @note This should be called once for every presented frame
          */
-        TextureView FindOrCreate(const GuestTexture &guestTexture);
+        void EndFrame();
     };
 }
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cmath>
+#include <dlfcn.h>
+#include <gpu.h>
+#include <common/trace.h>
+#include "thermal_policy.h"
+
+namespace skyline::gpu {
+    ThermalPolicy::ThermalPolicy(GPU &gpu) : gpu(gpu) {
+        void *library{dlopen("libandroid.so", RTLD_LOCAL | RTLD_LAZY)};
+        if (!library)
+            return;
+
+        auto acquireManager{reinterpret_cast<AcquireManagerFunction>(dlsym(library, "AThermal_acquireManager"))};
+        releaseManager = reinterpret_cast<ReleaseManagerFunction>(dlsym(library, "AThermal_releaseManager"));
+        getCurrentThermalStatus = reinterpret_cast<GetCurrentThermalStatusFunction>(dlsym(library, "AThermal_getCurrentThermalStatus"));
+        getThermalHeadroom = reinterpret_cast<GetThermalHeadroomFunction>(dlsym(library, "AThermal_getThermalHeadroom"));
+        if (!acquireManager || !releaseManager || !getCurrentThermalStatus) {
+            Logger::Info("AThermal isn't supported, the thermal policy is disabled");
+            return;
+        }
+
+        manager = acquireManager();
+    }
+
+    ThermalPolicy::~ThermalPolicy() {
+        if (manager)
+            releaseManager(manager);
+    }
+
+    u8 ThermalPolicy::GetTargetLevel(i64 averageFrametime, i64 frameBudget) {
+        u8 current{level.load(std::memory_order_relaxed)};
+        float headroom{getThermalHeadroom ? getThermalHeadroom(manager, ForecastSeconds) : std::numeric_limits<float>::quiet_NaN()};
+        if (std::isnan(headroom)) {
+            // The headroom is NaN if the host has no forecast for the device, the coarser thermal status is used instead which only changes once the host is already throttling
+            int status{getCurrentThermalStatus(manager)};
+            if (status < 0)
+                return current;
+            constexpr int FirstStatus{2}; // ATHERMAL_STATUS_MODERATE, the first status at which the host starts throttling
+            return static_cast<u8>(std::clamp(status - FirstStatus + 1, 0, LevelCount - 1));
+        }
+
+        TRACE_COUNTER("gpu", perfetto::CounterTrack("Thermal Headroom"), headroom);
+
+        u8 target{};
+        for (u8 index{}; index < HeadroomThresholds.size(); index++) {
+            // A level that's already applied is only left once the headroom is below its threshold by the hysteresis
+            float threshold{index < current ? HeadroomThresholds[index] - HeadroomHysteresis : HeadroomThresholds[index]};
+            if (headroom >= threshold)
+                target = static_cast<u8>(index + 1);
+        }
+
+        // Frames missing their budget while the host is warm are likely to be caused by reduced clocks, the current level is retained and the first level is entered in that case
+        if (headroom >= WarmHeadroom && frameBudget && static_cast<float>(averageFrametime) > static_cast<float>(frameBudget) * OverBudgetRatio)
+            target = std::max({target, current, static_cast<u8>(1)});
+
+        return target;
+    }
+
+    void ThermalPolicy::Apply() {
+        auto current{level.load(std::memory_order_relaxed)};
+        gpu.texture.SetResolutionScaleFactor(ResolutionScaleFactors[current]);
+        gpu.pipelineCompiler.SetConcurrency(CompilerConcurrency[current]);
+        TRACE_COUNTER("gpu", perfetto::CounterTrack("Thermal Level"), current);
+    }
+
+    void ThermalPolicy::Update(i64 averageFrametime, i64 frameBudget) {
+        if (!manager)
+            return;
+
+        auto now{util::GetTimeNs()};
+        if (now - lastPollTime < PollInterval)
+            return;
+        lastPollTime = now;
+
+        u8 current{level.load(std::memory_order_relaxed)};
+        u8 target{GetTargetLevel(averageFrametime, frameBudget)};
+        if (target > current) {
+            // Restrictions are applied immediately as the host throttling would cost more than any of them
+            releaseCount = 0;
+            level.store(target, std::memory_order_relaxed);
+            Apply();
+            Logger::Info("Raising the thermal level from {} to {}", current, target);
+        } else if (target < current) {
+            // Restrictions are lifted one level at a time after the thermal state has been stable for a while
+            if (++releaseCount >= ReleasePolls) {
+                releaseCount = 0;
+                level.store(current - 1, std::memory_order_relaxed);
+                Apply();
+                Logger::Info("Lowering the thermal level from {} to {}", current, current - 1);
+            }
+        } else {
+            releaseCount = 0;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+struct AThermalManager;
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief Degrades rendering in steps as the device heats up so performance declines gradually instead of falling off a cliff once the host starts throttling
+     * @note The thermal headroom forecast from AThermal (API 31) is polled once a second, the thermal status (API 30) is used when the forecast is unavailable, the functions are loaded from libandroid at runtime as both are newer than our minimum API level
+     * @note Every level lowers the scale of render targets created after it's applied, the amount of pipeline compiler threads and the frame time that frame skipping is enabled at
+     * @note This class is **NOT** thread-safe and should only be updated from the present thread, the level can be read from any thread
+     */
+    class ThermalPolicy {
+      public:
+        static constexpr u8 LevelCount{4}; //!< The amount of levels, level 0 is the unrestricted configuration of the user
+
+      private:
+        using AcquireManagerFunction = AThermalManager *(*)();
+        using ReleaseManagerFunction = void (*)(AThermalManager *manager);
+        using GetCurrentThermalStatusFunction = int (*)(AThermalManager *manager);
+        using GetThermalHeadroomFunction = float (*)(AThermalManager *manager, int forecastSeconds);
+
+        static constexpr i64 PollInterval{constant::NsInSecond}; //!< The minimum interval between queries of the thermal state, the headroom can't be queried more frequently than this
+        static constexpr int ForecastSeconds{10}; //!< The amount of seconds the headroom is forecast for, this is far enough ahead to step down before the host throttles
+        static constexpr std::array<float, LevelCount - 1> HeadroomThresholds{0.75f, 0.85f, 0.95f}; //!< The headroom at which every level after the first is entered, a headroom of 1.0 corresponds to severe throttling
+        static constexpr float HeadroomHysteresis{0.05f}; //!< The amount the headroom must fall below the threshold of a level for it to be left
+        static constexpr float WarmHeadroom{0.6f}; //!< The headroom above which frames missing their budget also raise the level, the host is warm enough that its clocks may already be limited
+        static constexpr float OverBudgetRatio{1.05f}; //!< The ratio of the average frame time to the frame budget above which frames are considered to be missing their budget
+        static constexpr u32 ReleasePolls{15}; //!< The amount of consecutive polls that a lower level must be warranted for before it's applied, this avoids oscillating between levels while the temperature is stable
+
+        static constexpr std::array<float, LevelCount> ResolutionScaleFactors{1.0f, 0.875f, 0.75f, 0.625f}; //!< The factor that the resolution scale of the user is multiplied by at every level
+        static constexpr std::array<size_t, LevelCount> CompilerConcurrency{2, 2, 1, 1}; //!< The amount of pipeline compiler threads which may run at every level
+
+        GPU &gpu;
+        AThermalManager *manager{}; //!< The thermal manager of the host, this is null if AThermal isn't supported
+        ReleaseManagerFunction releaseManager{};
+        GetCurrentThermalStatusFunction getCurrentThermalStatus{};
+        GetThermalHeadroomFunction getThermalHeadroom{};
+
+        std::atomic<u8> level{}; //!< The current level of the policy
+        i64 lastPollTime{}; //!< The time of the last query of the thermal state in nanoseconds
+        u32 releaseCount{}; //!< The amount of consecutive polls that warranted a lower level
+
+        /**
+         * @return The level warranted by the current thermal state of the host and the supplied frame times, this is the current level if the thermal state can't be queried
+         */
+        u8 GetTargetLevel(i64 averageFrametime, i64 frameBudget);
+
+        /**
+         * @brief Applies the restrictions of the current level to the GPU
+         */
+        void Apply();
+
+      public:
+        ThermalPolicy(GPU &gpu);
+
+        ~ThermalPolicy();
+
+        /**
+         * @brief Updates the level of the policy, this should be called after every presented frame
+         * @param averageFrametime The average time between presented frames in nanoseconds
+         * @param frameBudget The time the guest expects a frame to take in nanoseconds, 0 if the guest is unthrottled
+         */
+        void Update(i64 averageFrametime, i64 frameBudget);
+
+        u8 GetLevel() const {
+            return level.load(std::memory_order_relaxed);
+        }
+    };
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include "timestamp_tracer.h"
+
+namespace skyline::gpu {
+    constexpr u32 SkippedRange{std::numeric_limits<u32>::max()}; //!< A sentinel for ranges that were started after the set ran out of queries
+
+    thread_local TimestampTracer::QuerySet *TimestampTracer::activeSet;
+
+    TimestampTracer::QuerySet::QuerySet(TimestampTracer &tracer, vk::raii::QueryPool pool, FenceCycle *cycle, QuerySet *previous, bool trace) : tracer(tracer), pool(std::move(pool)), cycle(cycle), recordTime(perfetto::TrackEvent::GetTraceTimeNs()), previous(previous), trace(trace) {}
+
+    TimestampTracer::QuerySet::~QuerySet() {
+        if (recorded)
+            tracer.Resolve(*this);
+
+        std::scoped_lock lock(tracer.mutex);
+        tracer.freePools.push_back(std::move(pool));
+    }
+
+    void TimestampTracer::QuerySet::Write(vk::raii::CommandBuffer &commandBuffer, vk::PipelineStageFlagBits stage, const char *name) {
+        commandBuffer.writeTimestamp(stage, *pool, count);
+        names[count++] = name;
+    }
+
+    TimestampTracer::TimestampTracer(GPU &gpu, bool measure) : gpu(gpu), track(static_cast<u64>(trace::TrackIds::GpuExecution), perfetto::ProcessTrack::Current()), measure(measure) {
+        auto timestampBits{gpu.vkPhysicalDevice.getQueueFamilyProperties().at(gpu.vkQueueFamilyIndex).timestampValidBits};
+        auto timestampPeriod{gpu.vkPhysicalDevice.getProperties().limits.timestampPeriod};
+        supported = timestampBits && timestampPeriod;
+        period = timestampPeriod;
+        validMask = timestampBits >= 64 ? std::numeric_limits<u64>::max() : (1ULL << timestampBits) - 1;
+
+        auto desc{track.Serialize()};
+        desc.set_name("GPU Execution");
+        perfetto::TrackEvent::SetTrackDescriptor(track, desc);
+    }
+
+    void TimestampTracer::Resolve(QuerySet &set) {
+        std::array<u64, QueryCount> timestamps;
+        // The cycle has been signalled by the time the set is destroyed so all queries should be available without waiting
+        auto result{(*gpu.vkDevice).getQueryPoolResults(*set.pool, 0, set.count, set.count * sizeof(u64), timestamps.data(), sizeof(u64), vk::QueryResultFlagBits::e64, *gpu.vkDevice.getDispatcher())};
+        if (result != vk::Result::eSuccess)
+            return;
+
+        auto toNs{[&](u64 timestamp) { return static_cast<i64>(static_cast<double>(timestamp & validMask) * period); }};
+        i64 start{toNs(timestamps[0])}, end{toNs(timestamps[set.count - 1])};
+        gpuTime.fetch_add(std::max<i64>(end - start, 0), std::memory_order_relaxed); // The timestamp counter may wrap around during the command buffer, this is rare enough to be ignored
+
+        if (!set.trace)
+            return;
+
+        auto completionTime{static_cast<i64>(perfetto::TrackEvent::GetTraceTimeNs())};
+        i64 gpuOffset;
+        {
+            std::scoped_lock lock(mutex);
+            // The GPU must have finished the command buffer before we observed its completion and can't have started it before it was recorded, the offset is narrowed down to the tightest bounds seen so far
+            i64 upperBound{completionTime - end}, lowerBound{static_cast<i64>(set.recordTime) - start};
+            if (!offset || *offset > upperBound)
+                offset = upperBound;
+            if (*offset < lowerBound)
+                offset = std::min(lowerBound, upperBound); // A lower bound that exceeds the upper bound means the GPU clock jumped, the upper bound is always valid
+            gpuOffset = *offset;
+        }
+
+        // Timestamps are written at different pipeline stages so they aren't strictly ordered, they're clamped to be monotonic as slices on a track must nest
+        u64 lastTimestamp{};
+        for (u32 index{}; index < set.count; index++) {
+            auto timestamp{std::max(static_cast<u64>(toNs(timestamps[index]) + gpuOffset), lastTimestamp)};
+            lastTimestamp = timestamp;
+            if (set.names[index])
+                TRACE_EVENT_BEGIN("gpu", perfetto::StaticString{set.names[index]}, track, timestamp);
+            else
+                TRACE_EVENT_END("gpu", track, timestamp);
+        }
+    }
+
+    void TimestampTracer::BeginCommandBuffer(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const char *name) {
+        if (!supported) [[unlikely]]
+            return;
+
+        bool trace{TRACE_EVENT_CATEGORY_ENABLED("gpu")};
+        if (!trace && !measure) [[likely]]
+            return;
+
+        std::shared_ptr<QuerySet> set;
+        {
+            std::unique_lock lock(mutex);
+            if (!freePools.empty()) {
+                set = std::make_shared<QuerySet>(*this, std::move(freePools.back()), cycle.get(), activeSet, trace);
+                freePools.pop_back();
+            } else {
+                lock.unlock();
+                set = std::make_shared<QuerySet>(*this, vk::raii::QueryPool(gpu.vkDevice, vk::QueryPoolCreateInfo{
+                    .queryType = vk::QueryType::eTimestamp,
+                    .queryCount = QueryCount,
+                }), cycle.get(), activeSet, trace);
+            }
+        }
+
+        commandBuffer.resetQueryPool(*set->pool, 0, QueryCount);
+        set->Write(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, name);
+        set->openRanges.push_back(0);
+
+        cycle->AttachObject(set); // The cycle retains the set till it's signalled, the set is resolved on destruction
+        activeSet = set.get();
+    }
+
+    void TimestampTracer::EndCommandBuffer(vk::raii::CommandBuffer &commandBuffer) {
+        if (!activeSet) [[likely]]
+            return;
+
+        while (!activeSet->openRanges.empty())
+            EndRange(commandBuffer);
+        activeSet->recorded = true;
+        activeSet = activeSet->previous;
+    }
+
+    void TimestampTracer::AbortCommandBuffer(const std::shared_ptr<FenceCycle> &cycle) {
+        if (activeSet && activeSet->cycle == cycle.get())
+            activeSet = activeSet->previous;
+    }
+
+    void TimestampTracer::BeginRange(vk::raii::CommandBuffer &commandBuffer, const char *name) {
+        if (!activeSet) [[likely]]
+            return;
+
+        auto &set{*activeSet};
+        // A query is reserved for ending every open range including this one, the set must always be able to end the command buffer
+        if (!set.trace || set.count + set.openRanges.size() + 2 > QueryCount) {
+            set.openRanges.push_back(SkippedRange);
+            return;
+        }
+
+        set.openRanges.push_back(set.count);
+        set.Write(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, name);
+    }
+
+    void TimestampTracer::EndRange(vk::raii::CommandBuffer &commandBuffer) {
+        if (!activeSet || activeSet->openRanges.empty()) [[likely]]
+            return;
+
+        auto &set{*activeSet};
+        auto range{set.openRanges.back()};
+        set.openRanges.pop_back();
+        if (range != SkippedRange)
+            set.Write(commandBuffer, vk::PipelineStageFlagBits::eBottomOfPipe, nullptr);
+    }
+}
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/trace.h>
+#include "fence_cycle.h"
+
+namespace skyline::gpu {
+    class GPU;
+
+    /**
+     * @brief Measures the execution time of command buffers and ranges inside them on the host GPU with timestamp queries, these are emitted as slices on a Perfetto track for GPU execution
+     * @note Timestamps are only written while the "gpu" category is being traced or while measuring the total execution time for the performance overlay, they're resolved asynchronously once the fence cycle of the command buffer has been signalled
+     * @note GPU timestamps are aligned to the trace clock with bounds from the time a command buffer was recorded and the time its completion was observed, this is only as accurate as those bounds are tight
+     */
+    class TimestampTracer {
+      private:
+        static constexpr u32 QueryCount{0x40}; //!< The maximum amount of timestamps in a single command buffer, ranges past this are not traced
+
+        /**
+         * @brief The timestamp queries of a single command buffer, these are resolved on destruction which happens once the fence cycle it's attached to is signalled
+         */
+        struct QuerySet : public FenceCycleDependency {
+            TimestampTracer &tracer;
+            vk::raii::QueryPool pool;
+            FenceCycle *cycle; //!< The cycle of the command buffer, this is only used to identify the set
+            u64 recordTime; //!< The trace time at which recording of the command buffer started, the GPU cannot start executing it prior to this
+            QuerySet *previous; //!< The set which was active on this thread prior to this one
+            std::array<const char *, QueryCount> names; //!< The name of the range started by each query, this is null for queries which end a range
+            std::vector<u32> openRanges; //!< The indices of queries which started a range that hasn't been ended yet
+            u32 count{}; //!< The amount of queries that have been written
+            bool recorded{}; //!< If recording of the command buffer was completed, queries of command buffers which weren't submitted must not be resolved
+            bool trace; //!< If the "gpu" category was being traced when the command buffer was started, only the command buffer itself is timed otherwise
+
+            QuerySet(TimestampTracer &tracer, vk::raii::QueryPool pool, FenceCycle *cycle, QuerySet *previous, bool trace);
+
+            ~QuerySet();
+
+            /**
+             * @brief Writes a timestamp into the next query of the set
+             * @param name The name of the range started by the timestamp or null if it ends the last open range
+             */
+            void Write(vk::raii::CommandBuffer &commandBuffer, vk::PipelineStageFlagBits stage, const char *name);
+        };
+
+        static thread_local QuerySet *activeSet; //!< The set of the command buffer that is being recorded on this thread
+
+        GPU &gpu;
+        perfetto::Track track; //!< The Perfetto track that all GPU slices are emitted on
+        bool supported{}; //!< If the queue supports timestamp queries
+        bool measure; //!< If command buffers should be timed even when the "gpu" category isn't being traced
+        double period; //!< The amount of nanoseconds per timestamp tick
+        u64 validMask; //!< A mask of the valid bits in timestamps written on the queue
+
+        std::mutex mutex; //!< Synchronizes access to the free pools and the calibration
+        std::vector<vk::raii::QueryPool> freePools; //!< Query pools from resolved sets, these are reused to avoid recreating them for every command buffer
+        std::optional<i64> offset; //!< The offset from GPU time to trace time in nanoseconds
+        std::atomic<i64> gpuTime{}; //!< The total execution time of all resolved command buffers in nanoseconds
+
+        /**
+         * @brief Reads back the timestamps of a set and emits them as slices on the track
+         */
+        void Resolve(QuerySet &set);
+
+      public:
+        /**
+         * @param measure If the execution time of command buffers should be measured regardless of tracing, see GetGpuTime
+         */
+        TimestampTracer(GPU &gpu, bool measure);
+
+        /**
+         * @return The total execution time of all command buffers that have completed on the GPU in nanoseconds, this is only measured while tracing or if measuring was requested
+         */
+        i64 GetGpuTime() {
+            return gpuTime.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Starts tracing a command buffer recorded on this thread, this must be called prior to any other commands being recorded
+         * @note This has no effect if the "gpu" category isn't being traced and measuring wasn't requested, it must always be balanced by a call to EndCommandBuffer or AbortCommandBuffer
+         */
+        void BeginCommandBuffer(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, const char *name);
+
+        /**
+         * @brief Stops tracing the command buffer recorded on this thread, this must be called after all other commands have been recorded
+         */
+        void EndCommandBuffer(vk::raii::CommandBuffer &commandBuffer);
+
+        /**
+         * @brief Stops tracing the command buffer with the supplied cycle without resolving any of its timestamps, this is used when it won't be submitted
+         * @note This has no effect if the command buffer isn't being traced or EndCommandBuffer was already called for it
+         */
+        void AbortCommandBuffer(const std::shared_ptr<FenceCycle> &cycle);
+
+        /**
+         * @brief Starts a named range inside the command buffer recorded on this thread
+         * @note Ranges are only timed while the "gpu" category is being traced
+         * @param name A string with a static lifetime, it's used as the name of the emitted slice
+         */
+        void BeginRange(vk::raii::CommandBuffer &commandBuffer, const char *name);
+
+        /**
+         * @brief Ends the last range started inside the command buffer recorded on this thread
+         */
+        void EndRange(vk::raii::CommandBuffer &commandBuffer);
+    };
+}
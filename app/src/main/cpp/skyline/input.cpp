@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/resource.h>
+#include "input.h"
+
+namespace skyline::input {
+    Input::Input(const DeviceState &state)
+        : state(state),
+          kHid(std::make_shared<kernel::type::KSharedMemory>(state, sizeof(HidSharedMemory))),
+          hid(reinterpret_cast<HidSharedMemory *>(kHid->host.ptr)),
+          npad(state, hid),
+          touch(state, hid) {
+        // The thread is started after all other members have been constructed as it accesses them
+        updateThread = std::thread(&Input::UpdateThread, this);
+    }
+
+    Input::~Input() {
+        {
+            std::scoped_lock lock(updateMutex);
+            exitUpdate = true;
+        }
+        updateCondition.notify_all();
+        updateThread.join();
+    }
+
+    void Input::UpdateThread() {
+        pthread_setname_np(pthread_self(), "Sky-Input");
+
+        // Input is published at a higher priority than the guest's threads so that it isn't delayed by them when all cores are busy
+        constexpr int UpdatePriority{-8};
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), UpdatePriority))
+            Logger::Warn("Failed to raise the priority of the input thread: {}", strerror(errno));
+
+        try {
+            auto nextUpdate{std::chrono::steady_clock::now()};
+            std::unique_lock lock(updateMutex);
+            while (!updateCondition.wait_until(lock, nextUpdate += UpdatePeriod, [this]() { return exitUpdate; })) {
+                lock.unlock();
+                npad.PublishHostState();
+                touch.PublishHostState();
+                npad.FlushVibrations();
+                lock.lock();
+            }
+        } catch (const std::exception &e) {
+            Logger::Error("Input thread exited with an exception: {}", e.what());
+        }
+    }
+}
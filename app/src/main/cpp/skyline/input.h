@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include "common.h"
 #include "kernel/types/KSharedMemory.h"
 #include "input/shared_mem.h"
@@ -17,6 +18,15 @@ namespace skyline::input {
       private:
         const DeviceState &state;
 
+        static constexpr std::chrono::milliseconds UpdatePeriod{5}; //!< The period at which host input is published into HID shared memory, this matches the 200Hz sampling rate of NPads on HOS
+
+        std::thread updateThread; //!< A thread which publishes host input into HID shared memory at the sampling rate, this decouples the host input callbacks from any guest locks
+        std::mutex updateMutex;
+        std::condition_variable updateCondition;
+        bool exitUpdate{}; //!< If the update thread should exit
+
+        void UpdateThread();
+
       public:
         std::shared_ptr<kernel::type::KSharedMemory> kHid; //!< The kernel shared memory object for HID Shared Memory
         HidSharedMemory *hid; //!< A pointer to HID Shared Memory on the host
@@ -24,11 +34,8 @@ namespace skyline::input {
         NpadManager npad;
         TouchManager touch;
 
-        Input(const DeviceState &state)
-            : state(state),
-              kHid(std::make_shared<kernel::type::KSharedMemory>(state, sizeof(HidSharedMemory))),
-              hid(reinterpret_cast<HidSharedMemory *>(kHid->host.ptr)),
-              npad(state, hid),
-              touch(state, hid) {}
+        Input(const DeviceState &state);
+
+        ~Input();
     };
 }
@@ -79,6 +79,88 @@ namespace skyline::input {
             if (!connected)
                 device.Disconnect();
         }
+
+        hostStateDirty.store(true, std::memory_order_release); // Newly connected devices need to be populated with the current host state
+    }
+
+    void NpadManager::SubmitHostEvents(span<const HostInputEvent> events) {
+        for (const auto &event : events) {
+            if (event.index >= hostControllers.size()) [[unlikely]] {
+                Logger::Warn("Host input event is directed to an invalid controller: {}", event.index);
+                continue;
+            }
+
+            auto &host{hostControllers[event.index]};
+            switch (event.type) {
+                case HostInputEvent::Type::ButtonPressed:
+                    host.buttons.fetch_or(event.buttons.raw, std::memory_order_relaxed);
+                    break;
+
+                case HostInputEvent::Type::ButtonReleased:
+                    host.buttons.fetch_and(~event.buttons.raw, std::memory_order_relaxed);
+                    break;
+
+                case HostInputEvent::Type::Axis:
+                    if (static_cast<size_t>(event.axis) >= host.axes.size()) [[unlikely]] {
+                        Logger::Warn("Host input event has an invalid axis: {}", static_cast<u32>(event.axis));
+                        continue;
+                    }
+                    host.axes[static_cast<size_t>(event.axis)].store(event.value, std::memory_order_relaxed);
+                    break;
+
+                default:
+                    Logger::Warn("Unknown host input event type: {}", static_cast<u32>(event.type));
+                    continue;
+            }
+        }
+
+        // The dirty flag is only set once for the entire batch rather than for every event in it
+        hostStateDirty.store(true, std::memory_order_release);
+    }
+
+    void NpadManager::PublishHostState() {
+        if (!hostStateDirty.exchange(false, std::memory_order_acquire))
+            return;
+
+        std::lock_guard guard(mutex);
+        for (auto &device : npads) {
+            NpadButton buttons{};
+            std::array<i32, 4> axes{};
+            bool hasController{};
+            for (size_t index{}; index < controllers.size(); index++) {
+                if (controllers[index].device != &device)
+                    continue;
+
+                // Joy-Con pairs are made up of two host controllers, their buttons are combined and each axis is taken from the controller furthest from the center on it
+                auto &host{hostControllers[index]};
+                buttons.raw |= host.buttons.load(std::memory_order_relaxed);
+                for (size_t axis{}; axis < axes.size(); axis++) {
+                    auto value{host.axes[axis].load(std::memory_order_relaxed)};
+                    if (std::abs(value) > std::abs(axes[axis]))
+                        axes[axis] = value;
+                }
+                hasController = true;
+            }
+
+            if (hasController)
+                device.UpdateState(buttons, axes);
+        }
+    }
+
+    void NpadManager::FlushVibrations() {
+        if (!vibrationDirty.load(std::memory_order_acquire))
+            return;
+
+        // Vibration values that arrive within a period are coalesced, only the latest value of each motor is output
+        auto now{std::chrono::steady_clock::now()};
+        if (now - lastVibrationFlush < VibrationPeriod)
+            return;
+        lastVibrationFlush = now;
+        vibrationDirty.store(false, std::memory_order_relaxed);
+
+        std::lock_guard guard(mutex);
+        for (auto &device : npads)
+            device.FlushVibration();
     }
 
     void NpadManager::Activate() {
@@ -15,6 +15,35 @@ namespace skyline::input {
         NpadDevice *device{nullptr}; //!< A pointer to the NpadDevice that all events from this are redirected to
     };
 
+    /**
+     * @brief The state of a host controller, this is written by the host without any locking and published into HID shared memory by the input thread
+     */
+    struct HostControllerState {
+        std::atomic<u64> buttons{}; //!< The raw value of all held NpadButton(s)
+        std::array<std::atomic<i32>, 4> axes{}; //!< The value of each NpadAxisId
+    };
+
+    /**
+     * @brief A single host input event, these are batched into a direct buffer by the host and submitted together to avoid a JNI transition per event
+     * @note This must be kept in sync with the layout written by EmulationActivity
+     */
+    struct HostInputEvent {
+        enum class Type : u32 {
+            ButtonPressed = 0,
+            ButtonReleased = 1,
+            Axis = 2,
+        } type;
+        u32 index; //!< The index of the host controller this is directed to
+        union {
+            NpadButton buttons; //!< The mask of buttons that are pressed or released
+            struct {
+                NpadAxisId axis;
+                i32 value;
+            }; //!< The ID and new value of an axis
+        };
+    };
+    static_assert(sizeof(HostInputEvent) == 0x10);
+
     /**
      * @brief All NPad devices and their allocations to Player objects are managed by this class
      */
@@ -42,9 +71,16 @@ namespace skyline::input {
         }
 
       public:
+        static constexpr std::chrono::milliseconds VibrationPeriod{20}; //!< The minimum period between vibration outputs, Android restarts the vibration pattern on every update so changes faster than this can't be played back
+
         std::recursive_mutex mutex; //!< This mutex must be locked before any modifications to class members
         std::array<NpadDevice, constant::NpadCount> npads;
         std::array<GuestController, constant::ControllerCount> controllers;
+        std::array<HostControllerState, constant::ControllerCount> hostControllers; //!< The host state of each controller, these correspond to the entries in `controllers`
+        std::atomic<bool> hostStateDirty{}; //!< If the host state of any controller has changed since it was last published
+        std::mutex vibrationMutex; //!< Synchronizes the vibration values of all devices between the HID service and the input thread, this is separate from the main mutex so vibration never waits on a flush
+        std::atomic<bool> vibrationDirty{}; //!< If the vibration values of any device have changed since they were last flushed
+        std::chrono::steady_clock::time_point lastVibrationFlush{}; //!< The time at which vibration was last output to the host, this is only accessed by the input thread
         std::vector<NpadId> supportedIds; //!< The NPadId(s) that are supported by the application
         NpadStyleSet styles; //!< The styles that are supported by the application
         NpadJoyOrientation orientation{}; //!< The orientation all of Joy-Cons are in (This affects stick transformation for them)
@@ -74,6 +110,21 @@ namespace skyline::input {
          */
         void Update();
 
+        /**
+         * @brief Applies a batch of host input events in order, this doesn't lock the mutex and can be called from any thread
+         */
+        void SubmitHostEvents(span<const HostInputEvent> events);
+
+        /**
+         * @brief Publishes the host state of all controllers into HID shared memory if it has changed, this is called at the HID sampling rate by the input thread
+         */
+        void PublishHostState();
+
+        /**
+         * @brief Outputs the latest vibration values of all devices to the host, this is rate-limited to VibrationPeriod and is called by the input thread
+         */
+        void FlushVibrations();
+
         /**
          * @brief Activates the mapping between guest controllers -> players, a call to this is required for function
          */
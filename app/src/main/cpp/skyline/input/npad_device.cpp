@@ -146,8 +146,8 @@ namespace skyline::input {
         type = newType;
         controllerInfo = &GetControllerInfo();
 
-        GetNextEntry(*controllerInfo);
-        GetNextEntry(section.defaultController);
+        CommitEntry(*controllerInfo, GetNextEntry(*controllerInfo));
+        CommitEntry(section.defaultController, GetNextEntry(section.defaultController));
         globalTimestamp++;
 
         updateEvent->Signal();
@@ -186,16 +186,10 @@ namespace skyline::input {
         }
     }
 
-    NpadControllerState &NpadDevice::GetNextEntry(NpadControllerInfo &info) {
-        auto &lastEntry{info.state.at(info.header.currentEntry)};
-
-        info.header.timestamp = util::GetTimeTicks();
-        info.header.entryCount = std::min(static_cast<u8>(info.header.entryCount + 1), constant::HidEntryCount);
-        info.header.maxEntry = info.header.entryCount;
-        info.header.currentEntry = (info.header.currentEntry != constant::HidEntryCount - 1) ? info.header.currentEntry + 1 : 0;
-
-        auto &entry{info.state.at(info.header.currentEntry)};
+    NpadControllerState NpadDevice::GetNextEntry(NpadControllerInfo &info) {
+        const auto &lastEntry{info.state.at(info.header.currentEntry)};
 
+        NpadControllerState entry{};
         entry.globalTimestamp = globalTimestamp;
         entry.localTimestamp = lastEntry.localTimestamp + 1;
         entry.buttons = lastEntry.buttons;
@@ -208,152 +202,100 @@ namespace skyline::input {
         return entry;
     }
 
-    void NpadDevice::SetButtonState(NpadButton mask, bool pressed) {
-        if (!connectionState.connected)
-            return;
-
-        auto &entry{GetNextEntry(*controllerInfo)};
-
-        if (pressed)
-            entry.buttons.raw |= mask.raw;
-        else
-            entry.buttons.raw &= ~mask.raw;
-
-        if (manager.orientation == NpadJoyOrientation::Horizontal && (type == NpadControllerType::JoyconLeft || type == NpadControllerType::JoyconRight)) {
-            NpadButton orientedMask{};
-
-            if (mask.dpadUp)
-                orientedMask.dpadLeft = true;
-            if (mask.dpadDown)
-                orientedMask.dpadRight = true;
-            if (mask.dpadLeft)
-                orientedMask.dpadDown = true;
-            if (mask.dpadRight)
-                orientedMask.dpadUp = true;
-
-            if (mask.leftSl || mask.rightSl)
-                orientedMask.l = true;
-            if (mask.leftSr || mask.rightSr)
-                orientedMask.r = true;
-
-            orientedMask.a = mask.a;
-            orientedMask.b = mask.b;
-            orientedMask.x = mask.x;
-            orientedMask.y = mask.y;
-            orientedMask.leftStick = mask.leftStick;
-            orientedMask.rightStick = mask.rightStick;
-            orientedMask.plus = mask.plus;
-            orientedMask.minus = mask.minus;
-            orientedMask.leftSl = mask.leftSl;
-            orientedMask.leftSr = mask.leftSr;
-            orientedMask.rightSl = mask.rightSl;
-            orientedMask.rightSr = mask.rightSr;
-
-            mask = orientedMask;
-        }
+    void NpadDevice::CommitEntry(NpadControllerInfo &info, const NpadControllerState &entry) {
+        input::CommitEntry(info.header, info.state, entry);
+    }
 
-        auto &defaultEntry{GetNextEntry(section.defaultController)};
-        if (pressed)
-            defaultEntry.buttons.raw |= mask.raw;
-        else
-            defaultEntry.buttons.raw &= ~mask.raw;
+    /**
+     * @return The buttons as they're seen by the guest when a single Joy-Con is held horizontally
+     */
+    static NpadButton OrientHorizontally(NpadButton buttons) {
+        NpadButton oriented{};
+
+        if (buttons.dpadUp)
+            oriented.dpadLeft = true;
+        if (buttons.dpadDown)
+            oriented.dpadRight = true;
+        if (buttons.dpadLeft)
+            oriented.dpadDown = true;
+        if (buttons.dpadRight)
+            oriented.dpadUp = true;
+
+        if (buttons.leftSl || buttons.rightSl)
+            oriented.l = true;
+        if (buttons.leftSr || buttons.rightSr)
+            oriented.r = true;
+
+        oriented.a = buttons.a;
+        oriented.b = buttons.b;
+        oriented.x = buttons.x;
+        oriented.y = buttons.y;
+        oriented.leftStick = buttons.leftStick;
+        oriented.rightStick = buttons.rightStick;
+        oriented.plus = buttons.plus;
+        oriented.minus = buttons.minus;
+        oriented.leftSl = buttons.leftSl;
+        oriented.leftSr = buttons.leftSr;
+        oriented.rightSl = buttons.rightSl;
+        oriented.rightSr = buttons.rightSr;
+
+        return oriented;
+    }
 
-        globalTimestamp++;
+    /**
+     * @brief Sets the directional stick buttons of an entry based on the values of its sticks
+     */
+    static void SetStickButtons(NpadControllerState &entry) {
+        constexpr i32 Threshold{std::numeric_limits<i16>::max() / 2}; // A 50% deadzone for the stick buttons
+
+        entry.buttons.leftStickLeft = entry.leftX <= -Threshold;
+        entry.buttons.leftStickRight = entry.leftX >= Threshold;
+        entry.buttons.leftStickUp = entry.leftY >= Threshold;
+        entry.buttons.leftStickDown = entry.leftY <= -Threshold;
+        entry.buttons.rightStickLeft = entry.rightX <= -Threshold;
+        entry.buttons.rightStickRight = entry.rightX >= Threshold;
+        entry.buttons.rightStickUp = entry.rightY >= Threshold;
+        entry.buttons.rightStickDown = entry.rightY <= -Threshold;
     }
 
-    void NpadDevice::SetAxisValue(NpadAxisId axis, i32 value) {
+    void NpadDevice::UpdateState(NpadButton buttons, const std::array<i32, 4> &axes) {
         if (!connectionState.connected)
             return;
 
-        auto &controllerEntry{GetNextEntry(*controllerInfo)};
-        auto &defaultEntry{GetNextEntry(section.defaultController)};
-
-        constexpr i16 threshold{std::numeric_limits<i16>::max() / 2}; // A 50% deadzone for the stick buttons
-
-        if (manager.orientation == NpadJoyOrientation::Vertical || (type != NpadControllerType::JoyconLeft && type != NpadControllerType::JoyconRight)) {
-            switch (axis) {
-                case NpadAxisId::LX:
-                    controllerEntry.leftX = value;
-                    defaultEntry.leftX = value;
-
-                    controllerEntry.buttons.leftStickLeft = controllerEntry.leftX <= -threshold;
-                    defaultEntry.buttons.leftStickLeft = controllerEntry.buttons.leftStickLeft;
-
-                    controllerEntry.buttons.leftStickRight = controllerEntry.leftX >= threshold;
-                    defaultEntry.buttons.leftStickRight = controllerEntry.buttons.leftStickRight;
-                    break;
-                case NpadAxisId::LY:
-                    controllerEntry.leftY = value;
-                    defaultEntry.leftY = value;
-
-                    defaultEntry.buttons.leftStickUp = controllerEntry.buttons.leftStickUp;
-                    controllerEntry.buttons.leftStickUp = controllerEntry.leftY >= threshold;
-
-                    controllerEntry.buttons.leftStickDown = controllerEntry.leftY <= -threshold;
-                    defaultEntry.buttons.leftStickDown = controllerEntry.buttons.leftStickDown;
-                    break;
-                case NpadAxisId::RX:
-                    controllerEntry.rightX = value;
-                    defaultEntry.rightX = value;
-
-                    controllerEntry.buttons.rightStickLeft = controllerEntry.rightX <= -threshold;
-                    defaultEntry.buttons.rightStickLeft = controllerEntry.buttons.rightStickLeft;
-
-                    controllerEntry.buttons.rightStickRight = controllerEntry.rightX >= threshold;
-                    defaultEntry.buttons.rightStickRight = controllerEntry.buttons.rightStickRight;
-                    break;
-                case NpadAxisId::RY:
-                    controllerEntry.rightY = value;
-                    defaultEntry.rightY = value;
-
-                    controllerEntry.buttons.rightStickUp = controllerEntry.rightY >= threshold;
-                    defaultEntry.buttons.rightStickUp = controllerEntry.buttons.rightStickUp;
-
-                    controllerEntry.buttons.rightStickDown = controllerEntry.rightY <= -threshold;
-                    defaultEntry.buttons.rightStickDown = controllerEntry.buttons.rightStickDown;
-                    break;
-            }
+        auto controllerEntry{GetNextEntry(*controllerInfo)};
+        auto defaultEntry{GetNextEntry(section.defaultController)};
+
+        i32 leftX{axes[static_cast<size_t>(NpadAxisId::LX)]}, leftY{axes[static_cast<size_t>(NpadAxisId::LY)]};
+        i32 rightX{axes[static_cast<size_t>(NpadAxisId::RX)]}, rightY{axes[static_cast<size_t>(NpadAxisId::RY)]};
+
+        defaultEntry.leftX = leftX;
+        defaultEntry.leftY = leftY;
+        defaultEntry.rightX = rightX;
+        defaultEntry.rightY = rightY;
+
+        controllerEntry.buttons = buttons;
+        if (manager.orientation == NpadJoyOrientation::Horizontal && (type == NpadControllerType::JoyconLeft || type == NpadControllerType::JoyconRight)) {
+            // The sticks of a horizontally held Joy-Con are rotated on its own entry while the buttons are rotated on the default entry
+            defaultEntry.buttons = OrientHorizontally(buttons);
+
+            controllerEntry.leftX = -leftY;
+            controllerEntry.leftY = leftX;
+            controllerEntry.rightX = -rightY;
+            controllerEntry.rightY = rightX;
         } else {
-            switch (axis) {
-                case NpadAxisId::LX:
-                    controllerEntry.leftY = value;
-                    controllerEntry.buttons.leftStickUp = controllerEntry.leftY >= threshold;
-                    controllerEntry.buttons.leftStickDown = controllerEntry.leftY <= -threshold;
-
-                    defaultEntry.leftX = value;
-                    defaultEntry.buttons.leftStickLeft = defaultEntry.leftX <= -threshold;
-                    defaultEntry.buttons.leftStickRight = defaultEntry.leftX >= threshold;
-                    break;
-                case NpadAxisId::LY:
-                    controllerEntry.leftX = -value;
-                    controllerEntry.buttons.leftStickLeft = controllerEntry.leftX <= -threshold;
-                    controllerEntry.buttons.leftStickRight = controllerEntry.leftX >= threshold;
-
-                    defaultEntry.leftY = value;
-                    defaultEntry.buttons.leftStickUp = defaultEntry.leftY >= threshold;
-                    defaultEntry.buttons.leftStickDown = defaultEntry.leftY <= -threshold;
-                    break;
-                case NpadAxisId::RX:
-                    controllerEntry.rightY = value;
-                    controllerEntry.buttons.rightStickUp = controllerEntry.rightY >= threshold;
-                    controllerEntry.buttons.rightStickDown = controllerEntry.rightY <= -threshold;
-
-                    defaultEntry.rightX = value;
-                    defaultEntry.buttons.rightStickLeft = defaultEntry.rightX <= -threshold;
-                    defaultEntry.buttons.rightStickRight = defaultEntry.rightX >= threshold;
-                    break;
-                case NpadAxisId::RY:
-                    controllerEntry.rightX = -value;
-                    controllerEntry.buttons.rightStickLeft = controllerEntry.rightX <= -threshold;
-                    controllerEntry.buttons.rightStickRight = controllerEntry.rightX >= threshold;
-
-                    defaultEntry.rightY = value;
-                    defaultEntry.buttons.rightStickUp = defaultEntry.rightY >= threshold;
-                    defaultEntry.buttons.rightStickDown = defaultEntry.rightY <= -threshold;
-                    break;
-            }
+            defaultEntry.buttons = buttons;
+
+            controllerEntry.leftX = leftX;
+            controllerEntry.leftY = leftY;
+            controllerEntry.rightX = rightX;
+            controllerEntry.rightY = rightY;
         }
 
+        SetStickButtons(controllerEntry);
+        SetStickButtons(defaultEntry);
+
+        CommitEntry(*controllerInfo, controllerEntry);
+        CommitEntry(section.defaultController, defaultEntry);
         globalTimestamp++;
     }
 
@@ -435,27 +377,18 @@ namespace skyline::input {
     }
 
     void NpadDevice::Vibrate(const NpadVibrationValue &left, const NpadVibrationValue &right) {
+        std::scoped_lock lock(manager.vibrationMutex);
         if (vibrationLeft == left && vibrationRight && (*vibrationRight) == right)
             return;
 
         vibrationLeft = left;
         vibrationRight = right;
-
-        if (partnerIndex == NpadDevice::NullIndex) {
-            std::array<VibrationInfo, 4> vibrations{
-                VibrationInfo{left.frequencyLow, left.amplitudeLow * (AmplitudeMax / 4)},
-                VibrationInfo{left.frequencyHigh, left.amplitudeHigh * (AmplitudeMax / 4)},
-                VibrationInfo{right.frequencyLow, right.amplitudeLow * (AmplitudeMax / 4)},
-                VibrationInfo{right.frequencyHigh, right.amplitudeHigh * (AmplitudeMax / 4)},
-            };
-            VibrateDevice(manager.state.jvm, index, vibrations);
-        } else {
-            VibrateDevice(manager.state.jvm, index, left);
-            VibrateDevice(manager.state.jvm, partnerIndex, right);
-        }
+        vibrationPending = true;
+        manager.vibrationDirty.store(true, std::memory_order_release);
     }
 
     void NpadDevice::VibrateSingle(bool isRight, const NpadVibrationValue &value) {
+        std::scoped_lock lock(manager.vibrationMutex);
         if (isRight) {
             if (vibrationRight && (*vibrationRight) == value)
                 return;
@@ -466,9 +399,35 @@ namespace skyline::input {
             vibrationLeft = value;
         }
 
-        if (vibrationRight)
-            Vibrate(vibrationLeft, *vibrationRight);
-        else
-            VibrateDevice(manager.state.jvm, index, value);
+        vibrationPending = true;
+        manager.vibrationDirty.store(true, std::memory_order_release);
+    }
+
+    void NpadDevice::FlushVibration() {
+        NpadVibrationValue left;
+        std::optional<NpadVibrationValue> right;
+        {
+            std::scoped_lock lock(manager.vibrationMutex);
+            if (!vibrationPending)
+                return;
+            vibrationPending = false;
+            left = vibrationLeft;
+            right = vibrationRight;
+        }
+
+        if (!right) {
+            VibrateDevice(manager.state.jvm, index, left);
+        } else if (partnerIndex == NpadDevice::NullIndex) {
+            std::array<VibrationInfo, 4> vibrations{
+                VibrationInfo{left.frequencyLow, left.amplitudeLow * (AmplitudeMax / 4)},
+                VibrationInfo{left.frequencyHigh, left.amplitudeHigh * (AmplitudeMax / 4)},
+                VibrationInfo{right->frequencyLow, right->amplitudeLow * (AmplitudeMax / 4)},
+                VibrationInfo{right->frequencyHigh, right->amplitudeHigh * (AmplitudeMax / 4)},
+            };
+            VibrateDevice(manager.state.jvm, index, vibrations);
+        } else {
+            VibrateDevice(manager.state.jvm, index, left);
+            VibrateDevice(manager.state.jvm, partnerIndex, *right);
+        }
     }
 }
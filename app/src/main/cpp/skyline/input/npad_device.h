@@ -118,11 +118,15 @@ namespace skyline::input {
         u64 globalTimestamp{}; //!< An incrementing timestamp that's common across all sections
 
         /**
-         * @brief Updates the headers and creates a new entry in HID Shared Memory
          * @param info The controller info of the NPad that needs to be updated
-         * @return The next entry that has been created with values from the last entry
+         * @return A host-local copy of the next entry with values from the last entry, this must be published with CommitEntry once it's been updated
          */
-        NpadControllerState &GetNextEntry(NpadControllerInfo &info);
+        NpadControllerState GetNextEntry(NpadControllerInfo &info);
+
+        /**
+         * @brief Publishes an entry obtained from GetNextEntry to HID Shared Memory and updates the headers
+         */
+        void CommitEntry(NpadControllerInfo &info, const NpadControllerState &entry);
 
         /**
          * @return The NpadControllerInfo for this controller based on its type
@@ -134,8 +138,9 @@ namespace skyline::input {
         static constexpr i8 NullIndex{-1}; //!< The placeholder index value when there is no device present
         i8 index{NullIndex}; //!< The index of the device assigned to this player
         i8 partnerIndex{NullIndex}; //!< The index of a partner device, if present
-        NpadVibrationValue vibrationLeft{}; //!< Vibration for the left Joy-Con (Handheld/Pair), left LRA in a Pro-Controller or individual Joy-Cons
-        std::optional<NpadVibrationValue> vibrationRight; //!< Vibration for the right Joy-Con (Handheld/Pair) or right LRA in a Pro-Controller
+        NpadVibrationValue vibrationLeft{}; //!< Vibration for the left Joy-Con (Handheld/Pair), left LRA in a Pro-Controller or individual Joy-Cons, this is guarded by the manager's vibration mutex
+        std::optional<NpadVibrationValue> vibrationRight; //!< Vibration for the right Joy-Con (Handheld/Pair) or right LRA in a Pro-Controller, this is guarded by the manager's vibration mutex
+        bool vibrationPending{}; //!< If the vibration values have changed since they were last output to the host, this is guarded by the manager's vibration mutex
         NpadControllerType type{};
         NpadConnectionState connectionState{};
         std::shared_ptr<kernel::type::KEvent> updateEvent; //!< This event is triggered on the controller's style changing
@@ -161,27 +166,29 @@ namespace skyline::input {
         void Disconnect();
 
         /**
-         * @brief Changes the state of buttons to the specified state
-         * @param mask A bit-field mask of all the buttons to change
-         * @param pressed If the buttons were pressed or released
+         * @brief Publishes the state of the host controllers mapped to this device into HID shared memory
+         * @param buttons All held buttons, the stick direction buttons are derived from the axes rather than this
+         * @param axes The value of each NpadAxisId
+         * @note The manager's mutex must be locked prior to calling this
          */
-        void SetButtonState(NpadButton mask, bool pressed);
-
-        /**
-         * @brief Sets the value of an axis to the specified value
-         * @param axis The axis to set the value of
-         * @param value The value to set
-         */
-        void SetAxisValue(NpadAxisId axis, i32 value);
+        void UpdateState(NpadButton buttons, const std::array<i32, 4> &axes);
 
         /**
          * @brief Sets the vibration for both the Joy-Cons to the specified vibration values
+         * @note The values are only output to the host on the next call to FlushVibration, any intermediate values are dropped
          */
         void Vibrate(const NpadVibrationValue &left, const NpadVibrationValue &right);
 
         /**
          * @brief Sets the vibration for either the left or right Joy-Con to the specified vibration value
+         * @note The values are only output to the host on the next call to FlushVibration, any intermediate values are dropped
          */
         void VibrateSingle(bool isRight, const NpadVibrationValue &value);
+
+        /**
+         * @brief Outputs the latest vibration values to the host vibrators if they have changed since the last flush
+         * @note The manager's mutex must be locked prior to calling this
+         */
+        void FlushVibration();
     };
 }
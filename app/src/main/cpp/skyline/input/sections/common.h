@@ -24,5 +24,23 @@ namespace skyline {
             u64 maxEntry; //!< The maximum entry index
         };
         static_assert(sizeof(CommonHeader) == 0x20);
+
+        /**
+         * @brief Publishes an entry into the ring of entries following a CommonHeader, the entry is written in its entirety prior to the header being updated to point to it
+         * @note This is analogous to a seqlock commit: the guest locates the latest entry using the header, so it can never observe a partially written entry and each cache line of the entry is only written once
+         */
+        template<typename EntryType, size_t EntryCount>
+        void CommitEntry(CommonHeader &header, std::array<EntryType, EntryCount> &entries, const EntryType &entry) {
+            u64 index{(header.currentEntry != EntryCount - 1) ? header.currentEntry + 1 : 0};
+            entries[index] = entry;
+
+            // The entry must be visible prior to the header pointing to it
+            std::atomic_thread_fence(std::memory_order_release);
+
+            header.timestamp = util::GetTimeTicks();
+            header.entryCount = std::min(header.entryCount + 1, static_cast<u64>(EntryCount));
+            header.maxEntry = header.entryCount;
+            header.currentEntry = index;
+        }
     }
 }
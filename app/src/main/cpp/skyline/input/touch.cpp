@@ -9,19 +9,16 @@ namespace skyline::input {
     }
 
     void TouchManager::Activate() {
+        std::scoped_lock lock(mutex);
         if (!activated) {
             activated = true;
-            SetState({});
+            CommitPoints({});
         }
     }
 
-    void TouchManager::SetState(const span<TouchScreenPoint> &points) {
-        if (!activated)
-            return;
-
+    void TouchManager::CommitPoints(span<const TouchScreenPoint> points) {
         const auto &lastEntry{section.entries[section.header.currentEntry]};
-        auto entryIndex{(section.header.currentEntry != constant::HidEntryCount - 1) ? section.header.currentEntry + 1 : 0};
-        auto &entry{section.entries[entryIndex]};
+        TouchScreenState entry{};
         entry.globalTimestamp = lastEntry.globalTimestamp + 1;
         entry.localTimestamp = lastEntry.localTimestamp + 1;
         entry.touchCount = points.size();
@@ -37,9 +34,40 @@ namespace skyline::input {
             guest.angle = host.angle;
         }
 
-        section.header.timestamp = util::GetTimeTicks();
-        section.header.entryCount = std::min(static_cast<u8>(section.header.entryCount + 1), constant::HidEntryCount);
-        section.header.maxEntry = section.header.entryCount;
-        section.header.currentEntry = entryIndex;
+        CommitEntry(section.header, section.entries, entry);
+    }
+
+    void TouchManager::SetState(span<TouchScreenPoint> points) {
+        // The sequence number is odd while the state is being written, this lets the input thread detect torn reads without the writer ever waiting on it
+        u32 sequence{hostSequence.load(std::memory_order_relaxed)};
+        hostSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        hostPointCount = std::min(points.size(), MaxTouchPoints);
+        std::copy_n(points.begin(), hostPointCount, hostPoints.begin());
+
+        hostSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void TouchManager::PublishHostState() {
+        std::array<TouchScreenPoint, MaxTouchPoints> points;
+        size_t pointCount;
+        u32 sequence;
+        do {
+            sequence = hostSequence.load(std::memory_order_acquire);
+            if (sequence == publishedSequence)
+                return;
+            if (sequence & 1)
+                return; // The host state is being written, it'll be published on the next update
+
+            pointCount = hostPointCount;
+            points = hostPoints;
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (hostSequence.load(std::memory_order_relaxed) != sequence);
+
+        std::scoped_lock lock(mutex);
+        publishedSequence = sequence;
+        if (activated)
+            CommitPoints(span<const TouchScreenPoint>(points.data(), pointCount));
     }
 }
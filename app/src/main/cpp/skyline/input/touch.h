@@ -25,10 +25,24 @@ namespace skyline::input {
      */
     class TouchManager {
       private:
+        static constexpr size_t MaxTouchPoints{16}; //!< The maximum amount of points that can be touched at once in shared memory
+
         const DeviceState &state;
+        std::mutex mutex; //!< Synchronizes writes to the touch screen section between the input thread and guest activation
         bool activated{};
         TouchScreenSection &section;
 
+        std::atomic<u32> hostSequence{}; //!< The sequence number of a seqlock guarding the host state, this is odd while the host state is being written
+        std::array<TouchScreenPoint, MaxTouchPoints> hostPoints{};
+        size_t hostPointCount{};
+        u32 publishedSequence{}; //!< The sequence number of the host state that was last published
+
+        /**
+         * @brief Writes an entry with the supplied points into shared memory
+         * @note The mutex must be locked prior to calling this
+         */
+        void CommitPoints(span<const TouchScreenPoint> points);
+
       public:
         /**
          * @param hid A pointer to HID Shared Memory on the host
@@ -37,6 +51,14 @@ namespace skyline::input {
 
         void Activate();
 
-        void SetState(const span<TouchScreenPoint> &points);
+        /**
+         * @brief Sets the points that are being touched on the host, this doesn't block and must only be called from a single thread
+         */
+        void SetState(span<TouchScreenPoint> points);
+
+        /**
+         * @brief Publishes the host state into HID shared memory if it has changed, this is called at the HID sampling rate by the input thread
+         */
+        void PublishHostState();
     };
 }
@@ -72,12 +72,27 @@ namespace skyline {
         return env;
     }
 
+    jfieldID JvmManager::GetFieldId(const char *key, const char *signature) {
+        std::string name{fmt::format("{}:{}", key, signature)};
+        std::scoped_lock lock{fieldIdMutex};
+        auto it{fieldIds.find(name)};
+        if (it == fieldIds.end()) {
+            auto id{env->GetFieldID(instanceClass, key, signature)};
+            if (!id) {
+                env->ExceptionClear(); // A NoSuchFieldError is thrown on the Java side when the lookup fails
+                throw exception("Cannot find field '{}' with signature '{}' in the activity", key, signature);
+            }
+            it = fieldIds.emplace(std::move(name), id).first;
+        }
+        return it->second;
+    }
+
     jobject JvmManager::GetField(const char *key, const char *signature) {
-        return env->GetObjectField(instance, env->GetFieldID(instanceClass, key, signature));
+        return env->GetObjectField(instance, GetFieldId(key, signature));
     }
 
     bool JvmManager::CheckNull(const char *key, const char *signature) {
-        return env->IsSameObject(env->GetObjectField(instance, env->GetFieldID(instanceClass, key, signature)), nullptr);
+        return env->IsSameObject(env->GetObjectField(instance, GetFieldId(key, signature)), nullptr);
     }
 
     bool JvmManager::CheckNull(jobject &object) {
@@ -39,6 +39,11 @@ namespace skyline {
          */
         static JNIEnv *GetEnv();
 
+        /**
+         * @return The ID of a field in the activity class, IDs are looked up once and cached as they remain valid for the lifetime of the class
+         */
+        jfieldID GetFieldId(const char *key, const char *signature);
+
         /**
          * @brief Retrieves a specific field of the given type from the activity
          * @tparam objectType The type of the object in the field
@@ -49,21 +54,21 @@ namespace skyline {
         objectType GetField(const char *key) {
             JNIEnv *env{GetEnv()};
             if constexpr(std::is_same<objectType, jboolean>())
-                return env->GetBooleanField(instance, env->GetFieldID(instanceClass, key, "Z"));
+                return env->GetBooleanField(instance, GetFieldId(key, "Z"));
             else if constexpr(std::is_same<objectType, jbyte>())
-                return env->GetByteField(instance, env->GetFieldID(instanceClass, key, "B"));
+                return env->GetByteField(instance, GetFieldId(key, "B"));
             else if constexpr(std::is_same<objectType, jchar>())
-                return env->GetCharField(instance, env->GetFieldID(instanceClass, key, "C"));
+                return env->GetCharField(instance, GetFieldId(key, "C"));
             else if constexpr(std::is_same<objectType, jshort>())
-                return env->GetShortField(instance, env->GetFieldID(instanceClass, key, "S"));
+                return env->GetShortField(instance, GetFieldId(key, "S"));
             else if constexpr(std::is_same<objectType, jint>())
-                return env->GetIntField(instance, env->GetFieldID(instanceClass, key, "I"));
+                return env->GetIntField(instance, GetFieldId(key, "I"));
             else if constexpr(std::is_same<objectType, jlong>())
-                return env->GetLongField(instance, env->GetFieldID(instanceClass, key, "J"));
+                return env->GetLongField(instance, GetFieldId(key, "J"));
             else if constexpr(std::is_same<objectType, jfloat>())
-                return env->GetFloatField(instance, env->GetFieldID(instanceClass, key, "F"));
+                return env->GetFloatField(instance, GetFieldId(key, "F"));
             else if constexpr(std::is_same<objectType, jdouble>())
-                return env->GetDoubleField(instance, env->GetFieldID(instanceClass, key, "D"));
+                return env->GetDoubleField(instance, GetFieldId(key, "D"));
             else
                 throw exception("GetField: Unhandled object type");
         }
@@ -113,6 +118,9 @@ namespace skyline {
         i32 GetVersionCode();
 
       private:
+        std::mutex fieldIdMutex; //!< Synchronizes access to the field ID cache
+        std::unordered_map<std::string, jfieldID> fieldIds; //!< A map from the name and signature of a field to its ID
+
         jmethodID initializeControllersId;
         jmethodID vibrateDeviceId;
         jmethodID clearVibrationDeviceId;
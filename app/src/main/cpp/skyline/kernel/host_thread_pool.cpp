@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <kernel/types/KThread.h>
+#include "host_thread_pool.h"
+
+namespace skyline::kernel {
+    static thread_local bool poolDestroyed{}; //!< If the pool was destroyed on the current worker, the worker must return without touching the pool as it has been freed
+
+    HostThreadPool::~HostThreadPool() {
+        {
+            std::scoped_lock lock(mutex);
+            exit = true;
+        }
+
+        for (auto &worker : workers) {
+            worker.condition.notify_all();
+            if (worker.thread.get_id() == std::this_thread::get_id()) {
+                // The pool may be destroyed by the last reference to the process being dropped on one of its own workers
+                worker.thread.detach();
+                poolDestroyed = true;
+            } else {
+                worker.thread.join();
+            }
+        }
+    }
+
+    void HostThreadPool::WorkerThread(Worker *worker) {
+        pthread_setname_np(pthread_self(), "Sky-HostThread");
+        type::KThread::InitializeHostThread();
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            worker->condition.wait(lock, [&]() { return exit || worker->guestThread; });
+            if (!worker->guestThread)
+                return;
+
+            auto guestThread{std::move(worker->guestThread)};
+            lock.unlock();
+
+            signal::UnblockSignal({SIGINT}); // A prior guest thread might have blocked SIGINT while killing its process
+            guestThread->pthread = pthread_self();
+            guestThread->StartThread();
+
+            // The host thread must not retain any references to the guest thread once it's parked, the guest thread may be destroyed here if this was the last reference to it
+            DeviceState::ctx = nullptr;
+            DeviceState::thread = nullptr;
+            guestThread = nullptr;
+            if (poolDestroyed)
+                return;
+
+            lock.lock();
+            parkedWorkers.push_back(worker);
+        }
+    }
+
+    void HostThreadPool::Run(std::shared_ptr<type::KThread> guestThread) {
+        std::unique_lock lock(mutex);
+        Worker *worker;
+        if (!parkedWorkers.empty()) {
+            worker = parkedWorkers.back();
+            parkedWorkers.pop_back();
+            worker->guestThread = std::move(guestThread);
+            lock.unlock();
+            worker->condition.notify_one();
+        } else {
+            worker = &workers.emplace_back();
+            worker->guestThread = std::move(guestThread);
+            worker->thread = std::thread(&HostThreadPool::WorkerThread, this, worker);
+        }
+    }
+}
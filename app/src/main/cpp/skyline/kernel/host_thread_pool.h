@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <thread>
+#include <condition_variable>
+#include <common.h>
+
+namespace skyline::kernel {
+    namespace type {
+        class KThread;
+    }
+
+    /**
+     * @brief A pool of host threads which guest threads are run on, host threads are parked once their guest thread exits and reused by later guest threads
+     * @note Every host thread has its signal handlers set up once when it's created, this avoids the cost of creating a host thread for every guest thread which is significant for titles that create and destroy short-lived threads frequently
+     */
+    class HostThreadPool {
+      private:
+        /**
+         * @brief A single host thread alongside the guest thread it's been handed
+         */
+        struct Worker {
+            std::thread thread;
+            std::condition_variable condition; //!< Signalled when the worker has been handed a guest thread or the pool is being destroyed
+            std::shared_ptr<type::KThread> guestThread; //!< The guest thread which should be run next, this is null while the worker is parked
+        };
+
+        std::mutex mutex; //!< Synchronizes all members below
+        std::list<Worker> workers; //!< A list is used as workers must have stable addresses
+        std::vector<Worker *> parkedWorkers; //!< Workers which aren't running any guest thread and can be handed one
+        bool exit{}; //!< If the workers should exit
+
+        void WorkerThread(Worker *worker);
+
+      public:
+        ~HostThreadPool();
+
+        /**
+         * @brief Runs a guest thread on a parked host thread or a new one if there are none
+         * @note The host thread is returned to the pool once the guest thread exits
+         */
+        void Run(std::shared_ptr<type::KThread> guestThread);
+    };
+}
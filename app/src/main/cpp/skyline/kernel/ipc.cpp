@@ -5,13 +5,7 @@
 #include "types/KProcess.h"
 
 namespace skyline::kernel::ipc {
-    IpcRequest::IpcRequest(bool isDomain, const DeviceState &state) : isDomain(isDomain) {
-        auto tls{state.ctx->tpidrroEl0};
-        u8 *pointer{tls};
-
-        header = reinterpret_cast<CommandHeader *>(pointer);
-        pointer += sizeof(CommandHeader);
-
+    void IpcRequest::ParseDescriptors(u8 *&pointer) {
         if (header->handleDesc) {
             handleDesc = reinterpret_cast<HandleDescriptor *>(pointer);
             pointer += sizeof(HandleDescriptor) + (handleDesc->sendPid ? sizeof(u64) : 0);
@@ -61,6 +55,18 @@ namespace skyline::kernel::ipc {
             }
             pointer += sizeof(BufferDescriptorABW);
         }
+    }
+
+    IpcRequest::IpcRequest(bool isDomain, const DeviceState &state) : isDomain(isDomain) {
+        auto tls{state.ctx->tpidrroEl0};
+        u8 *pointer{tls};
+
+        header = reinterpret_cast<CommandHeader *>(pointer);
+        pointer += sizeof(CommandHeader);
+
+        // Most requests have neither handles nor buffers, the payload directly follows the header for them so there are no descriptors to walk
+        if (header->HasDescriptors()) [[unlikely]]
+            ParseDescriptors(pointer);
 
         auto bufCPointer{pointer + header->rawSize * sizeof(u32)};
 
@@ -133,7 +139,7 @@ namespace skyline::kernel::ipc {
         memset(tls, 0, constant::TlsIpcSize);
 
         auto header{reinterpret_cast<CommandHeader *>(pointer)};
-        header->rawSize = static_cast<u32>((sizeof(PayloadHeader) + payload.size() + (domainObjects.size() * sizeof(KHandle)) + constant::IpcPaddingSum + (isDomain ? sizeof(DomainHeaderRequest) : 0)) / sizeof(u32)); // Size is in 32-bit units because Nintendo
+        header->rawSize = static_cast<u32>((sizeof(PayloadHeader) + payloadSize + (domainObjects.size() * sizeof(KHandle)) + constant::IpcPaddingSum + (isDomain ? sizeof(DomainHeaderRequest) : 0)) / sizeof(u32)); // Size is in 32-bit units because Nintendo
         header->handleDesc = (!copyHandles.empty() || !moveHandles.empty());
         pointer += sizeof(CommandHeader);
 
@@ -170,9 +176,11 @@ namespace skyline::kernel::ipc {
         payloadHeader->value = errorCode;
         pointer += sizeof(PayloadHeader);
 
-        if (!payload.empty())
-            std::memcpy(pointer, payload.data(), payload.size());
-        pointer += payload.size();
+        if (pointer + payloadSize + (isDomain ? domainObjects.size() * sizeof(KHandle) : 0) > tls + constant::TlsIpcSize) [[unlikely]]
+            throw exception("IPC response doesn't fit in the IPC buffer: 0x{:X} bytes of payload", payloadSize);
+
+        std::memcpy(pointer, payload.data(), payloadSize);
+        pointer += payloadSize;
 
         if (isDomain) {
             for (auto &domainObject : domainObjects) {
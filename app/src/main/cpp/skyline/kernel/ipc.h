@@ -49,6 +49,13 @@ namespace skyline {
             BufferCFlag cFlag : 4;
             u32               : 17;
             bool handleDesc : 1;
+
+            /**
+             * @return If the message has any handle or buffer descriptors, a message without any only consists of the header followed by the data payload
+             */
+            bool HasDescriptors() const {
+                return handleDesc || xNo || aNo || bNo || wNo || cFlag != BufferCFlag::None;
+            }
         };
         static_assert(sizeof(CommandHeader) == 8);
 
@@ -190,6 +197,12 @@ namespace skyline {
           private:
             u8 *payloadOffset; //!< The offset of the data read from the payload
 
+            /**
+             * @brief Parses the handle descriptor and the X, A, B and W buffer descriptors which follow the header
+             * @param pointer A pointer to the descriptors, it's advanced past them
+             */
+            void ParseDescriptors(u8 *&pointer);
+
           public:
             CommandHeader *header{};
             HandleDescriptor *handleDesc{};
@@ -247,7 +260,20 @@ namespace skyline {
         class IpcResponse {
           private:
             const DeviceState &state;
-            std::vector<u8> payload; //!< The contents to be pushed to the data payload
+            std::array<u8, constant::TlsIpcSize> payload; //!< The contents to be pushed to the data payload, this is stored inline as a response can never be larger than the IPC buffer in TLS which avoids allocating for every request
+            size_t payloadSize{}; //!< The amount of bytes pushed to the payload
+
+            /**
+             * @return A pointer to a region of the payload of the supplied size which was appended to it
+             */
+            u8 *AppendPayload(size_t size) {
+                if (payloadSize + size > payload.size()) [[unlikely]]
+                    throw exception("IPC response payload exceeds the size of the IPC buffer: 0x{:X} + 0x{:X}", payloadSize, size);
+
+                auto pointer{payload.data() + payloadSize};
+                payloadSize += size;
+                return pointer;
+            }
 
           public:
             Result errorCode{}; //!< The error code to respond with, it's 0 (Success) by default
@@ -264,9 +290,7 @@ namespace skyline {
              */
             template<typename ValueType>
             void Push(const ValueType &value) {
-                auto size{payload.size()};
-                payload.resize(size + sizeof(ValueType));
-                std::memcpy(payload.data() + size, reinterpret_cast<const u8 *>(&value), sizeof(ValueType));
+                std::memcpy(AppendPayload(sizeof(ValueType)), reinterpret_cast<const u8 *>(&value), sizeof(ValueType));
             }
 
             /**
@@ -274,9 +298,7 @@ namespace skyline {
              * @param string The string to write to the payload
              */
             void Push(std::string_view string) {
-                auto size{payload.size()};
-                payload.resize(size + string.size());
-                std::memcpy(payload.data() + size, string.data(), string.size());
+                std::memcpy(AppendPayload(string.size()), string.data(), string.size());
             }
 
             /**
@@ -12,7 +12,7 @@ namespace skyline::kernel {
             munmap(reinterpret_cast<void *>(base.address), base.size);
     }
 
-    constexpr size_t RegionAlignment{1ULL << 21}; //!< The minimum alignment of a HOS memory region
+    constexpr size_t RegionAlignment{1ULL << 21}; //!< The minimum alignment of a HOS memory region, this matches the host's huge page size so regions such as the heap can be backed by transparent huge pages
     constexpr size_t CodeRegionSize{4ULL * 1024 * 1024 * 1024}; //!< The assumed maximum size of the code region (4GiB)
 
     void MemoryManager::InitializeVmm(memory::AddressSpaceType type) {
@@ -61,11 +61,14 @@ namespace skyline::kernel {
         if (!base.address)
             throw exception("Cannot find a suitable carveout for the guest address space");
 
-        auto result{mmap(reinterpret_cast<void *>(base.address), base.size, PROT_NONE, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE, -1, 0)};
+        // The address space is reserved without any swap space being accounted for it, pages are only committed once they're faulted in by the guest and are returned to the host with MADV_DONTNEED when they're freed
+        auto result{mmap(reinterpret_cast<void *>(base.address), base.size, PROT_NONE, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0)};
         if (result == MAP_FAILED)
             throw exception("Failed to mmap guest address space: {}", strerror(errno));
 
-        chunks = {
+        chunks.clear();
+        lastChunk = nullptr;
+        for (const auto &chunk : {
             ChunkDescriptor{
                 .ptr = reinterpret_cast<u8 *>(addressSpace.address),
                 .size = base.address - addressSpace.address,
@@ -80,7 +83,9 @@ namespace skyline::kernel {
                 .ptr = reinterpret_cast<u8 *>(base.address + base.size),
                 .size = addressSpace.size - (base.address + base.size),
                 .state = memory::states::Reserved,
-            }};
+            }})
+            if (chunk.size)
+                chunks.emplace(chunk.ptr, chunk);
     }
 
     void MemoryManager::InitializeRegions(u8 *codeStart, u64 size) {
@@ -135,65 +140,70 @@ namespace skyline::kernel {
             .address + heap.size, heap.size, stack.address, stack.address + stack.size, stack.size, tlsIo.address, tlsIo.address + tlsIo.size, tlsIo.size);
     }
 
+    void MemoryManager::SplitChunkLocked(u8 *ptr) {
+        auto upper{chunks.upper_bound(ptr)};
+        if (upper == chunks.begin())
+            throw exception("SplitChunk: Splitting outside the address space: 0x{:X}", ptr);
+
+        auto &lower{std::prev(upper)->second};
+        if (lower.ptr == ptr || lower.ptr + lower.size <= ptr)
+            return;
+
+        auto tail{lower};
+        tail.ptr = ptr;
+        tail.size = static_cast<size_t>((lower.ptr + lower.size) - ptr);
+        lower.size = static_cast<size_t>(ptr - lower.ptr);
+        chunks.emplace_hint(upper, ptr, tail);
+    }
+
     void MemoryManager::InsertChunk(const ChunkDescriptor &chunk) {
         std::unique_lock lock(mutex);
+        lastChunk = nullptr;
 
-        auto upper{std::upper_bound(chunks.begin(), chunks.end(), chunk.ptr, [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr; })};
-        if (upper == chunks.begin())
-            throw exception("InsertChunk: Chunk inserted outside address space: 0x{:X} - 0x{:X} and 0x{:X} - 0x{:X}", upper->ptr, upper->ptr + upper->size, chunk.ptr, chunk.ptr + chunk.size);
+        u8 *chunkEnd{chunk.ptr + chunk.size};
+        if (chunks.empty() || chunk.ptr < chunks.begin()->first)
+            throw exception("InsertChunk: Chunk inserted outside address space: 0x{:X} - 0x{:X}", chunk.ptr, chunkEnd);
 
-        upper = chunks.erase(upper, std::upper_bound(upper, chunks.end(), chunk.ptr + chunk.size, [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr + chunk.size; }));
-        if (upper != chunks.end() && upper->ptr < chunk.ptr + chunk.size) {
-            auto end{upper->ptr + upper->size};
-            upper->ptr = chunk.ptr + chunk.size;
-            upper->size = static_cast<size_t>(end - upper->ptr);
+        // Split any chunks straddling the edges of the new chunk so it exactly replaces all chunks inside its range
+        SplitChunkLocked(chunk.ptr);
+        SplitChunkLocked(chunkEnd);
+
+        auto upper{chunks.erase(chunks.lower_bound(chunk.ptr), chunks.lower_bound(chunkEnd))};
+
+        // Coalesce with the neighbouring chunks if they're contiguous and have the same attributes
+        auto inserted{chunk};
+        if (upper != chunks.end() && upper->first == chunkEnd && inserted.IsCompatible(upper->second)) {
+            inserted.size += upper->second.size;
+            upper = chunks.erase(upper);
         }
 
-        auto lower{std::prev(upper)};
-        if (lower->ptr == chunk.ptr && lower->size == chunk.size) {
-            lower->state = chunk.state;
-            lower->permission = chunk.permission;
-            lower->attributes = chunk.attributes;
-        } else if (lower->ptr + lower->size > chunk.ptr + chunk.size) {
-            auto lowerExtension{*lower};
-            lowerExtension.ptr = chunk.ptr + chunk.size;
-            lowerExtension.size = static_cast<size_t>((lower->ptr + lower->size) - lowerExtension.ptr);
-
-            lower->size = static_cast<size_t>(chunk.ptr - lower->ptr);
-            if (lower->size) {
-                upper = chunks.insert(upper, lowerExtension);
-                chunks.insert(upper, chunk);
-            } else {
-                auto lower2{std::prev(lower)};
-                if (chunk.IsCompatible(*lower2) && lower2->ptr + lower2->size >= chunk.ptr) {
-                    lower2->size = static_cast<size_t>(chunk.ptr + chunk.size - lower2->ptr);
-                    upper = chunks.erase(lower);
-                } else {
-                    *lower = chunk;
-                }
-                upper = chunks.insert(upper, lowerExtension);
-            }
-        } else if (chunk.IsCompatible(*lower) && lower->ptr + lower->size >= chunk.ptr) {
-            lower->size = static_cast<size_t>(chunk.ptr + chunk.size - lower->ptr);
-        } else {
-            if (lower->ptr + lower->size > chunk.ptr)
-                lower->size = static_cast<size_t>(chunk.ptr - lower->ptr);
-            if (upper != chunks.end() && chunk.IsCompatible(*upper) && chunk.ptr + chunk.size >= upper->ptr) {
-                upper->ptr = chunk.ptr;
-                upper->size = chunk.size + upper->size;
-            } else {
-                chunks.insert(upper, chunk);
+        if (upper != chunks.begin()) {
+            auto &lower{std::prev(upper)->second};
+            if (lower.ptr + lower.size == inserted.ptr && inserted.IsCompatible(lower)) {
+                lower.size += inserted.size;
+                return;
             }
         }
+
+        chunks.emplace_hint(upper, inserted.ptr, inserted);
     }
 
     std::optional<ChunkDescriptor> MemoryManager::Get(void *ptr) {
         std::shared_lock lock(mutex);
 
-        auto chunk{std::upper_bound(chunks.begin(), chunks.end(), reinterpret_cast<u8 *>(ptr), [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr; })};
-        if (chunk-- != chunks.begin())
-            if ((chunk->ptr + chunk->size) > ptr)
-                return std::make_optional(*chunk);
+        // Queries are frequently repeated on the same chunk (such as when iterating over a region), the last chunk that was looked up is checked prior to searching for it
+        auto address{reinterpret_cast<u8 *>(ptr)};
+        auto cached{lastChunk.load(std::memory_order_relaxed)};
+        if (cached && cached->ptr <= address && (cached->ptr + cached->size) > address)
+            return *cached;
+
+        auto chunk{chunks.upper_bound(address)};
+        if (chunk-- != chunks.begin()) {
+            if ((chunk->second.ptr + chunk->second.size) > address) {
+                lastChunk.store(&chunk->second, std::memory_order_relaxed);
+                return std::make_optional(chunk->second);
+            }
+        }
 
         return std::nullopt;
     }
@@ -201,7 +211,7 @@ namespace skyline::kernel {
     size_t MemoryManager::GetUserMemoryUsage() {
         std::shared_lock lock(mutex);
         size_t size{};
-        for (const auto &chunk : chunks)
+        for (const auto &[ptr, chunk] : chunks)
             if (chunk.state == memory::states::Heap)
                 size += chunk.size;
         return size + code.size + state.process->mainThreadStack->size;
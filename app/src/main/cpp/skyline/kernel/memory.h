@@ -215,7 +215,14 @@ namespace skyline {
         class MemoryManager {
           private:
             const DeviceState &state;
-            std::vector<ChunkDescriptor> chunks;
+            std::map<u8 *, ChunkDescriptor> chunks; //!< A map from the base address of each chunk to its descriptor, the chunks are contiguous and cover the entire address space
+            std::atomic<const ChunkDescriptor *> lastChunk{}; //!< The chunk which was last returned by Get, this is reset on any mutation of the chunks while readers may update it in shared mode
+
+            /**
+             * @brief Splits the chunk containing the supplied address into two chunks at it, this does nothing if a chunk already starts at the address
+             * @note The mutex must be locked exclusively when calling this
+             */
+            void SplitChunkLocked(u8 *ptr);
 
           public:
             memory::Region addressSpace{}; //!< The entire address space
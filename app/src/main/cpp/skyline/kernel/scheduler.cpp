@@ -2,22 +2,241 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <unistd.h>
+#include <fstream>
+#include <sys/sysinfo.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <common/signal.h>
 #include <common/trace.h>
 #include "types/KThread.h"
 #include "scheduler.h"
 
 namespace skyline::kernel {
-    Scheduler::CoreContext::CoreContext(u8 id, i8 preemptionPriority) : id(id), preemptionPriority(preemptionPriority) {}
+    type::KThread *RunQueue::Next(const type::KThread *thread) const {
+        if (thread->queueLinks.next)
+            return thread->queueLinks.next;
 
-    Scheduler::Scheduler(const DeviceState &state) : state(state) {}
+        // The thread is the last in its bucket, the next thread is at the head of the next non-empty bucket of a lower priority
+        auto lowerMask{thread->queueLinks.priority + 1U < PriorityCount ? readyMask & (std::numeric_limits<u64>::max() << (thread->queueLinks.priority + 1)) : 0};
+        return lowerMask ? buckets[static_cast<size_t>(std::countr_zero(lowerMask))].head : nullptr;
+    }
+
+    bool RunQueue::Contains(const type::KThread &thread) const {
+        return thread.queueLinks.queue == this;
+    }
+
+    void RunQueue::Insert(const std::shared_ptr<type::KThread> &thread) {
+        auto priority{static_cast<u8>(thread->priority.load())};
+        if (priority >= PriorityCount) [[unlikely]]
+            throw exception("Inserting T{} with an invalid priority: {}", thread->id, priority);
+
+        auto &links{thread->queueLinks};
+        auto &bucket{buckets[priority]};
+        links.queue = this;
+        links.priority = priority;
+        links.previous = bucket.tail;
+        links.next = nullptr;
+        links.reference = thread;
+
+        if (bucket.tail)
+            bucket.tail->queueLinks.next = thread.get();
+        else
+            bucket.head = thread.get();
+        bucket.tail = thread.get();
+
+        readyMask |= 1ULL << priority;
+        size++;
+    }
+
+    void RunQueue::Erase(type::KThread &thread) {
+        auto &links{thread.queueLinks};
+        auto &bucket{buckets[links.priority]};
+        if (links.previous)
+            links.previous->queueLinks.next = links.next;
+        else
+            bucket.head = links.next;
+        if (links.next)
+            links.next->queueLinks.previous = links.previous;
+        else
+            bucket.tail = links.previous;
+
+        if (!bucket.head)
+            readyMask &= ~(1ULL << links.priority);
+        size--;
+
+        links.queue = nullptr;
+        links.previous = links.next = nullptr;
+        links.reference.reset(); // This must be done last as it may be the last reference to the thread
+    }
+
+    void RunQueue::Requeue(type::KThread &thread) {
+        auto reference{thread.queueLinks.reference};
+        Erase(thread);
+        Insert(reference);
+    }
+
+    Scheduler::CoreContext::CoreContext(u8 id, i8 preemptionPriority)
+        : id(id),
+          preemptionPriority(preemptionPriority),
+          runQueueTrack(util::Format("C{} Run Queue", id)),
+          holdTimeTrack(util::Format("C{} Hold Time", id)),
+          preemptionTrack(util::Format("C{} Preemptions", id)),
+          yieldTrack(util::Format("C{} Yields", id)) {}
+
+    Scheduler::Scheduler(const DeviceState &state) : state(state) {
+        hostCoreAffinity = state.settings->hostCoreAffinity && CreateHostCoreSets();
+        preemptionThread = std::thread(&Scheduler::PreemptionThread, this);
+    }
+
+    Scheduler::~Scheduler() {
+        preemptionExit.store(true);
+        preemptionWord.fetch_add(1);
+        syscall(SYS_futex, &preemptionWord, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        preemptionThread.join();
+    }
+
+    void Scheduler::PreemptionThread() {
+        pthread_setname_np(pthread_self(), "Sky-Preemption");
+
+        while (!preemptionExit.load()) {
+            // Any core armed while it's being scanned wakes this thread as the wake time is the maximum value, the futex word is read prior to scanning so a wait after such an arm returns immediately
+            preemptionWakeTime.store(std::numeric_limits<i64>::max());
+            auto word{preemptionWord.load()};
+
+            auto now{util::GetTimeNs()};
+            i64 wakeTime{std::numeric_limits<i64>::max()};
+            for (auto &core : cores) {
+                std::shared_ptr<type::KThread> preempted;
+                {
+                    std::scoped_lock lock(core.mutex);
+                    auto target{core.preemptionTarget};
+                    if (!target)
+                        continue;
+
+                    if (core.preemptionDeadline > now) {
+                        wakeTime = std::min(wakeTime, core.preemptionDeadline);
+                    } else {
+                        // The timer is disarmed prior to signalling as the target can only rearm it after being scheduled again, a timer armed for the thread on the front of the queue is always for the current holder of the core
+                        core.preemptionTarget = nullptr;
+                        if (core.queue.Front() == target)
+                            preempted = target->shared_from_this();
+                    }
+                }
+
+                // The target is signalled after the core is unlocked as signalling locks its status mutex, which KThread::Start holds while inserting the thread into a core
+                if (preempted)
+                    preempted->SendSignal(PreemptionSignal);
+            }
+
+            preemptionWakeTime.store(wakeTime);
+
+            timespec relativeTimeout{};
+            if (wakeTime != std::numeric_limits<i64>::max()) {
+                auto remainingNs{std::max(wakeTime - util::GetTimeNs(), i64{})};
+                relativeTimeout = {.tv_sec = static_cast<time_t>(remainingNs / constant::NsInSecond), .tv_nsec = static_cast<long>(remainingNs % constant::NsInSecond)};
+            }
+            syscall(SYS_futex, &preemptionWord, FUTEX_WAIT_PRIVATE, word, wakeTime != std::numeric_limits<i64>::max() ? &relativeTimeout : nullptr, nullptr, 0);
+        }
+    }
+
+    void Scheduler::ArmPreemptionTimer(CoreContext &core, type::KThread &thread) {
+        core.preemptionTarget = &thread;
+        core.preemptionDeadline = util::GetTimeNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(PreemptiveTimeslice).count();
+
+        // The preemption thread only needs to be woken if it'd otherwise sleep past the deadline, this is rare as deadlines are usually armed in increasing order
+        if (core.preemptionDeadline < preemptionWakeTime.load()) {
+            preemptionWord.fetch_add(1);
+            syscall(SYS_futex, &preemptionWord, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+
+    void Scheduler::DisarmPreemptionTimer(CoreContext &core, type::KThread &thread) {
+        // The preemption thread isn't woken as it'll find the timer disarmed when it next wakes up
+        if (core.preemptionTarget == &thread)
+            core.preemptionTarget = nullptr;
+    }
+
+    bool Scheduler::CreateHostCoreSets() {
+        std::vector<std::pair<int, u64>> cpuFrequencies; //!< The index and maximum frequency in KHz of every host CPU
+        auto cpuCount{get_nprocs_conf()};
+        for (int cpu{}; cpu < cpuCount; cpu++) {
+            std::ifstream file(util::Format("/sys/devices/system/cpu/cpu{}/cpufreq/cpuinfo_max_freq", cpu));
+            u64 frequency{};
+            if (file >> frequency)
+                cpuFrequencies.emplace_back(cpu, frequency);
+        }
+
+        if (cpuFrequencies.empty())
+            return false;
+
+        auto [minimum, maximum]{std::minmax_element(cpuFrequencies.begin(), cpuFrequencies.end(), [](const auto &lhs, const auto &rhs) { return lhs.second < rhs.second; })};
+        auto littleFrequency{minimum->second}, primeFrequency{maximum->second};
+        if (littleFrequency == primeFrequency)
+            return false; // All host CPUs are identical, there's nothing to gain from pinning threads to any of them
+
+        cpu_set_t primeSet, bigSet, littleSet;
+        CPU_ZERO(&primeSet);
+        CPU_ZERO(&bigSet);
+        CPU_ZERO(&littleSet);
+        for (auto [cpu, frequency] : cpuFrequencies) {
+            if (frequency == primeFrequency)
+                CPU_SET(cpu, &primeSet);
+            if (frequency == littleFrequency)
+                CPU_SET(cpu, &littleSet);
+            else
+                CPU_SET(cpu, &bigSet);
+        }
+
+        // The main thread of most titles is on the first core and bottlenecks them, it gets the prime cluster to itself while the system core only runs background work
+        hostCoreSets = {primeSet, bigSet, bigSet, littleSet};
+        Logger::Info("Pinning guest cores to host CPUs: Prime ({} KHz): {} CPUs, Big: {} CPUs, LITTLE ({} KHz): {} CPUs", primeFrequency, CPU_COUNT(&primeSet), CPU_COUNT(&bigSet), littleFrequency, CPU_COUNT(&littleSet));
+        return true;
+    }
+
+    void Scheduler::UpdateHostAffinity() {
+        auto &thread{state.thread};
+        if (!hostCoreAffinity || thread->hostAffinityCore == thread->coreId)
+            return;
+
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &hostCoreSets.at(thread->coreId)))
+            Logger::Warn("Failed to pin T{} to the host CPUs of C{}: {}", thread->id, thread->coreId, strerror(errno));
+        thread->hostAffinityCore = thread->coreId; // We don't retry on failure as it'd most likely fail again on every schedule
+    }
+
+    void Scheduler::TraceRunQueue(CoreContext &core) {
+        TRACE_COUNTER("scheduler", perfetto::CounterTrack(core.runQueueTrack.c_str()), core.queue.Size());
+    }
+
+    void Scheduler::RecordHoldTime(CoreContext &core) {
+        auto &thread{state.thread};
+        if (thread->timesliceStart) {
+            auto heldTicks{util::GetTimeTicks() - thread->timesliceStart};
+            core.heldTicks.fetch_add(heldTicks, std::memory_order_relaxed);
+            TRACE_COUNTER("scheduler", perfetto::CounterTrack(core.holdTimeTrack.c_str(), "ns"), util::TicksToNs(heldTicks));
+        }
+    }
+
+    u64 Scheduler::GetCoreHeldTime(u8 coreId) {
+        return util::TicksToNs(cores.at(coreId).heldTicks.load(std::memory_order_relaxed));
+    }
+
+    void Scheduler::TraceScheduled() {
+        if (auto flowId{std::exchange(state.thread->scheduleFlowId, 0)})
+            TRACE_EVENT_INSTANT("scheduler", "Scheduled", [flowId](perfetto::EventContext ctx) {
+                ctx.event()->add_flow_ids(flowId);
+            });
+    }
 
     void Scheduler::SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls) {
         if (*tls) {
             TRACE_EVENT_END("guest");
             const auto &state{*reinterpret_cast<nce::ThreadContext *>(*tls)->state};
-            if (signal == PreemptionSignal)
-                state.thread->isPreempted = false;
+            auto &core{state.scheduler->cores.at(state.thread->coreId)};
+            if (signal == PreemptionSignal) {
+                TRACE_COUNTER("scheduler", perfetto::CounterTrack(core.preemptionTrack.c_str()), core.preemptionCount.fetch_add(1, std::memory_order_relaxed) + 1);
+            } else {
+                TRACE_COUNTER("scheduler", perfetto::CounterTrack(core.yieldTrack.c_str()), core.yieldCount.fetch_add(1, std::memory_order_relaxed) + 1);
+            }
             state.scheduler->Rotate(false);
             YieldPending = false;
             state.scheduler->WaitSchedule();
@@ -30,7 +249,7 @@ namespace skyline::kernel {
     Scheduler::CoreContext &Scheduler::GetOptimalCoreForThread(const std::shared_ptr<type::KThread> &thread) {
         auto *currentCore{&cores.at(thread->coreId)};
 
-        if (!currentCore->queue.empty() && thread->affinityMask.count() != 1) {
+        if (!currentCore->queue.Empty() && thread->affinityMask.count() != 1) {
             // Select core where the current thread will be scheduled the earliest based off average timeslice durations for resident threads
             // There's a preference for the current core as migration isn't free
             size_t minTimeslice{};
@@ -39,12 +258,11 @@ namespace skyline::kernel {
                 if (thread->affinityMask.test(candidateCore.id)) {
                     u64 timeslice{};
 
-                    if (!candidateCore.queue.empty()) {
+                    if (!candidateCore.queue.Empty()) {
                         std::lock_guard coreLock(candidateCore.mutex);
 
-                        auto threadIterator{candidateCore.queue.cbegin()};
-                        if (threadIterator != candidateCore.queue.cend()) {
-                            const auto &runningThread{*threadIterator};
+                        auto runningThread{candidateCore.queue.Front()};
+                        if (runningThread) {
                             timeslice += [&]() {
                                 if (runningThread->averageTimeslice)
                                     return std::min(runningThread->averageTimeslice - (util::GetTimeTicks() - runningThread->timesliceStart), 1UL);
@@ -54,11 +272,9 @@ namespace skyline::kernel {
                                     return 1UL;
                             }();
 
-                            while (++threadIterator != candidateCore.queue.cend()) {
-                                const auto &residentThread{*threadIterator};
+                            for (auto residentThread{candidateCore.queue.Next(runningThread)}; residentThread; residentThread = candidateCore.queue.Next(residentThread))
                                 if (residentThread->priority <= thread->priority)
                                     timeslice += residentThread->averageTimeslice ? residentThread->averageTimeslice : 1UL;
-                            }
                         }
                     }
 
@@ -85,18 +301,25 @@ namespace skyline::kernel {
     void Scheduler::InsertThread(const std::shared_ptr<type::KThread> &thread) {
         auto &core{cores.at(thread->coreId)};
         std::unique_lock lock(core.mutex);
-        auto nextThread{std::upper_bound(core.queue.begin(), core.queue.end(), thread->priority.load(), type::KThread::IsHigherPriority)};
-        if (nextThread == core.queue.begin()) {
-            if (nextThread != core.queue.end()) {
+
+        auto flowId{nextFlowId.fetch_add(1, std::memory_order_relaxed)};
+        thread->scheduleFlowId = flowId;
+        TRACE_EVENT("scheduler", "InsertThread", [&](perfetto::EventContext ctx) {
+            ctx.event()->add_flow_ids(flowId);
+        });
+
+        auto front{core.queue.Front()};
+        core.queue.Insert(thread);
+        TraceRunQueue(core);
+        if (core.queue.Front() == thread.get()) {
+            if (front) {
                 // If the inserted thread has a higher priority than the currently running thread (and the queue isn't empty)
                 // We can yield the thread which is currently scheduled on the core by sending it a signal
                 // It is optimized to avoid waiting for the thread to yield on receiving the signal which serializes the entire pipeline
-                auto front{core.queue.front()};
                 front->forceYield = true;
-                core.queue.splice(std::upper_bound(core.queue.begin(), core.queue.end(), front->priority.load(), type::KThread::IsHigherPriority), core.queue, core.queue.begin());
-                core.queue.push_front(thread);
+                core.queue.Requeue(*front);
 
-                if (state.thread != front) {
+                if (state.thread.get() != front) {
                     // If the calling thread isn't at the front, we need to send it an OS signal to yield
                     if (!front->pendingYield) {
                         // We only want to yield the thread if it hasn't already been sent a signal to yield in the past
@@ -109,25 +332,23 @@ namespace skyline::kernel {
                     // This avoids an OS signal which would just flip the YieldPending flag but with significantly more overhead
                     YieldPending = true;
                 }
-            } else {
-                core.queue.push_front(thread);
             }
             if (thread != state.thread)
-                thread->scheduleCondition.notify_one(); // We only want to trigger the conditional variable if the current thread isn't inserting itself
-        } else {
-            core.queue.insert(nextThread, thread);
+                thread->WakeSchedule(); // We only want to wake the thread if the current thread isn't inserting itself
         }
     }
 
     void Scheduler::MigrateToCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&currentCore, CoreContext *targetCore, std::unique_lock<std::mutex> &lock) {
         // We need to check if the thread was in its resident core's queue
         // If it was, we need to remove it from the queue
-        auto it{std::find(currentCore->queue.begin(), currentCore->queue.end(), thread)};
-        bool wasInserted{it != currentCore->queue.end()};
+        bool wasInserted{currentCore->queue.Contains(*thread)};
         if (wasInserted) {
-            it = currentCore->queue.erase(it);
-            if (it == currentCore->queue.begin() && it != currentCore->queue.end())
-                (*it)->scheduleCondition.notify_one();
+            bool wasFront{currentCore->queue.Front() == thread.get()};
+            currentCore->queue.Erase(*thread);
+            TraceRunQueue(*currentCore);
+            DisarmPreemptionTimer(*currentCore, *thread);
+            if (auto front{currentCore->queue.Front()}; wasFront && front)
+                front->WakeSchedule();
         }
         lock.unlock();
 
@@ -140,6 +361,30 @@ namespace skyline::kernel {
         lock = std::unique_lock(targetCore->mutex);
     }
 
+    template<typename Predicate>
+    bool Scheduler::WaitForWake(type::KThread &thread, std::unique_lock<std::mutex> &lock, Predicate predicate, std::optional<std::chrono::nanoseconds> timeout) {
+        auto deadline{timeout ? std::chrono::steady_clock::now() + *timeout : std::chrono::steady_clock::time_point::max()};
+        while (!predicate()) {
+            // The wake word is read while the lock is held, any wake after the lock is released changes it which causes the futex wait to return immediately rather than missing the wake
+            auto word{thread.wakeWord.load(std::memory_order_acquire)};
+
+            timespec relativeTimeout{};
+            if (timeout) {
+                auto remaining{deadline - std::chrono::steady_clock::now()};
+                if (remaining <= std::chrono::nanoseconds::zero())
+                    return predicate();
+
+                auto remainingNs{std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count()};
+                relativeTimeout = {.tv_sec = static_cast<time_t>(remainingNs / constant::NsInSecond), .tv_nsec = static_cast<long>(remainingNs % constant::NsInSecond)};
+            }
+
+            lock.unlock();
+            syscall(SYS_futex, &thread.wakeWord, FUTEX_WAIT_PRIVATE, word, timeout ? &relativeTimeout : nullptr, nullptr, 0); // Spurious wakes, EINTR from yield signals and EAGAIN are all handled by rechecking the predicate
+            lock.lock();
+        }
+        return true;
+    }
+
     void Scheduler::WaitSchedule(bool loadBalance) {
         auto &thread{state.thread};
         CoreContext *core{&cores.at(thread->coreId)};
@@ -153,13 +398,13 @@ namespace skyline::kernel {
                 if (!thread->affinityMask.test(thread->coreId)) // We need to retest in case the thread was migrated while the core was unlocked
                     MigrateToCore(thread, core, &cores.at(thread->idealCore), lock);
             }
-            return !core->queue.empty() && core->queue.front() == thread;
+            return core->queue.Front() == thread.get();
         }};
 
         TRACE_EVENT("scheduler", "WaitSchedule");
         if (loadBalance && thread->affinityMask.count() > 1) {
             std::chrono::milliseconds loadBalanceThreshold{PreemptiveTimeslice * 2}; //!< The amount of time that needs to pass unscheduled for a thread to attempt load balancing
-            while (!thread->scheduleCondition.wait_for(lock, loadBalanceThreshold, wakeFunction)) {
+            while (!WaitForWake(*thread, lock, wakeFunction, loadBalanceThreshold)) {
                 lock.unlock(); // We cannot call GetOptimalCoreForThread without relinquishing the core mutex
                 std::lock_guard migrationLock(thread->coreMigrationMutex);
                 auto newCore{&GetOptimalCoreForThread(state.thread)};
@@ -170,13 +415,15 @@ namespace skyline::kernel {
                 loadBalanceThreshold *= 2; // We double the duration required for future load balancing for this invocation to minimize pointless load balancing
             }
         } else {
-            thread->scheduleCondition.wait(lock, wakeFunction);
+            WaitForWake(*thread, lock, wakeFunction);
         }
 
         if (thread->priority == core->preemptionPriority)
-            // If the thread needs to be preempted then arm its preemption timer
-            thread->ArmPreemptionTimer(PreemptiveTimeslice);
+            // If the thread needs to be preempted then arm the preemption timer of its core
+            ArmPreemptionTimer(*core, *thread);
 
+        TraceScheduled();
+        UpdateHostAffinity();
         thread->timesliceStart = util::GetTimeTicks();
     }
 
@@ -186,16 +433,18 @@ namespace skyline::kernel {
 
         TRACE_EVENT("scheduler", "TimedWaitSchedule");
         std::unique_lock lock(core->mutex);
-        if (thread->scheduleCondition.wait_for(lock, timeout, [&]() {
+        if (WaitForWake(*thread, lock, [&]() {
             if (!thread->affinityMask.test(thread->coreId)) [[unlikely]] {
                 std::lock_guard migrationLock(thread->coreMigrationMutex);
                 MigrateToCore(thread, core, &cores.at(thread->idealCore), lock);
             }
-            return !core->queue.empty() && core->queue.front() == thread;
-        })) {
+            return core->queue.Front() == thread.get();
+        }, timeout)) {
             if (thread->priority == core->preemptionPriority)
-                thread->ArmPreemptionTimer(PreemptiveTimeslice);
+                ArmPreemptionTimer(*core, *thread);
 
+            TraceScheduled();
+            UpdateHostAffinity();
             thread->timesliceStart = util::GetTimeTicks();
 
             return true;
@@ -210,22 +459,23 @@ namespace skyline::kernel {
 
         std::unique_lock lock(core.mutex);
 
-        if (core.queue.front() == thread) {
+        if (core.queue.Front() == thread.get()) {
             // If this thread is at the front of the thread queue then we need to rotate the thread
             // In the case where this thread was forcefully yielded, we don't need to do this as it's done by the thread which yielded to this thread
-            // Splice the linked element from the beginning of the queue to where its priority is present
-            core.queue.splice(std::upper_bound(core.queue.begin(), core.queue.end(), thread->priority.load(), type::KThread::IsHigherPriority), core.queue, core.queue.begin());
+            // Move the thread behind all other threads with its priority, this also moves it to a different bucket if its priority has changed
+            RecordHoldTime(core);
+            core.queue.Requeue(*thread);
 
-            auto &front{core.queue.front()};
-            if (front != thread)
-                front->scheduleCondition.notify_one(); // If we aren't at the front of the queue, only then should we wake the thread at the front up
+            auto front{core.queue.Front()};
+            if (front != thread.get())
+                front->WakeSchedule(); // If we aren't at the front of the queue, only then should we wake the thread at the front up
         } else if (!thread->forceYield) {
             throw exception("T{} called Rotate while not being in C{}'s queue", thread->id, thread->coreId);
         }
 
         thread->averageTimeslice = (thread->averageTimeslice / 4) + (3 * (util::GetTimeTicks() - thread->timesliceStart / 4));
 
-        thread->DisarmPreemptionTimer(); // If a preemptive thread did a cooperative yield then we need to disarm the preemptive timer
+        DisarmPreemptionTimer(core, *thread); // If a preemptive thread did a cooperative yield then we need to disarm the preemptive timer
         thread->pendingYield = false;
         thread->forceYield = false;
     }
@@ -235,21 +485,25 @@ namespace skyline::kernel {
         auto &core{cores.at(thread->coreId)};
         {
             std::unique_lock lock(core.mutex);
-            auto it{std::find(core.queue.begin(), core.queue.end(), thread)};
-            if (it != core.queue.end()) {
-                it = core.queue.erase(it);
-                if (it == core.queue.begin()) {
+            if (core.queue.Contains(*thread)) {
+                bool wasFront{core.queue.Front() == thread.get()};
+                core.queue.Erase(*thread);
+                TraceRunQueue(core);
+                if (wasFront) {
+                    RecordHoldTime(core);
+
                     // We need to update the averageTimeslice accordingly, if we've been unscheduled by this
                     if (thread->timesliceStart)
                         thread->averageTimeslice = (thread->averageTimeslice / 4) + (3 * (util::GetTimeTicks() - thread->timesliceStart / 4));
 
-                    if (it != core.queue.end())
-                        (*it)->scheduleCondition.notify_one(); // We need to wake the thread at the front of the queue, if we were at the front previously
+                    if (auto front{core.queue.Front()})
+                        front->WakeSchedule(); // We need to wake the thread at the front of the queue, if we were at the front previously
                 }
             }
+
+            DisarmPreemptionTimer(core, *thread);
         }
 
-        thread->DisarmPreemptionTimer();
         thread->pendingYield = false;
         thread->forceYield = false;
         YieldPending = false;
@@ -260,37 +514,38 @@ namespace skyline::kernel {
         auto *core{&cores.at(thread->coreId)};
         std::unique_lock coreLock(core->mutex);
 
-        auto currentIt{std::find(core->queue.begin(), core->queue.end(), thread)}, nextIt{std::next(currentIt)};
-        if (currentIt == core->queue.end()) {
+        if (!core->queue.Contains(*thread))
             return;
-        } else if (currentIt == core->queue.begin()) {
-            // Alternatively, if it's currently running then we'd just want to yield if there's a higher priority thread to run instead
-            if (nextIt != core->queue.end() && (*nextIt)->priority < thread->priority) {
+
+        auto front{core->queue.Front()};
+        if (front == thread.get()) {
+            // If it's currently running then we'd just want to yield if there's a higher priority thread to run instead, it's moved into its new bucket when it rotates
+            auto next{core->queue.Next(front)};
+            if (next && next->priority < thread->priority) {
                 if (!thread->pendingYield) {
                     thread->SendSignal(YieldSignal);
                     thread->pendingYield = true;
                 }
-            } else if (!thread->isPreempted && thread->priority == core->preemptionPriority) {
-                // If the thread needs to be preempted due to its new priority then arm its preemption timer
-                thread->ArmPreemptionTimer(PreemptiveTimeslice);
-            } else if (thread->isPreempted && thread->priority != core->preemptionPriority) {
-                // If the thread no longer needs to be preempted due to its new priority then disarm its preemption timer
-                thread->DisarmPreemptionTimer();
+            } else if (core->preemptionTarget != thread.get() && thread->priority == core->preemptionPriority) {
+                // If the thread needs to be preempted due to its new priority then arm the preemption timer of its core
+                ArmPreemptionTimer(*core, *thread);
+            } else if (core->preemptionTarget == thread.get() && thread->priority != core->preemptionPriority) {
+                // If the thread no longer needs to be preempted due to its new priority then disarm the preemption timer of its core
+                DisarmPreemptionTimer(*core, *thread);
             }
-        } else if (thread->priority < (*std::prev(currentIt))->priority || (nextIt != core->queue.end() && thread->priority > (*nextIt)->priority)) {
-            // If the thread is in the queue and it's position is affected by the priority change then need to remove and re-insert the thread
-            core->queue.erase(currentIt);
-
-            auto targetIt{std::upper_bound(core->queue.begin(), core->queue.end(), thread->priority.load(), type::KThread::IsHigherPriority)};
-            if (targetIt == core->queue.begin() && targetIt != core->queue.end()) {
-                core->queue.insert(std::next(core->queue.begin()), thread);
-                auto front{core->queue.front()};
+        } else if (thread->queueLinks.priority != static_cast<u8>(thread->priority.load())) {
+            // If the thread is in the queue and it's in the bucket of its prior priority then it needs to be moved into the bucket of its new priority
+            core->queue.Requeue(*thread);
+
+            if (core->queue.Front() == thread.get()) {
+                // The thread now has a higher priority than the running thread, which is moved behind it and yielded in the same way as in InsertThread
+                front->forceYield = true;
+                core->queue.Requeue(*front);
                 if (!front->pendingYield) {
                     front->SendSignal(YieldSignal);
                     front->pendingYield = true;
                 }
-            } else {
-                core->queue.insert(targetIt, thread);
+                thread->WakeSchedule();
             }
         }
     }
@@ -298,10 +553,10 @@ namespace skyline::kernel {
     void Scheduler::UpdateCore(const std::shared_ptr<type::KThread> &thread) {
         auto *core{&cores.at(thread->coreId)};
         std::lock_guard coreLock(core->mutex);
-        if (core->queue.front() == thread)
+        if (core->queue.Front() == thread.get())
             thread->SendSignal(YieldSignal);
         else
-            thread->scheduleCondition.notify_one();
+            thread->WakeSchedule();
     }
 
     void Scheduler::ParkThread() {
@@ -311,14 +566,16 @@ namespace skyline::kernel {
 
         auto originalCoreId{thread->coreId};
         thread->coreId = constant::ParkedCoreId;
-        for (auto &core : cores)
-            if (originalCoreId != core.id && thread->affinityMask.test(core.id) && (core.queue.empty() || core.queue.front()->priority > thread->priority))
+        for (auto &core : cores) {
+            auto front{core.queue.Front()};
+            if (originalCoreId != core.id && thread->affinityMask.test(core.id) && (!front || front->priority > thread->priority))
                 thread->coreId = core.id;
+        }
 
         if (thread->coreId == constant::ParkedCoreId) {
             std::unique_lock lock(parkedMutex);
             parkedQueue.insert(std::upper_bound(parkedQueue.begin(), parkedQueue.end(), thread->priority.load(), type::KThread::IsHigherPriority), thread);
-            thread->scheduleCondition.wait(lock, [&]() { return parkedQueue.front() == thread && thread->coreId != constant::ParkedCoreId; });
+            WaitForWake(*thread, lock, [&]() { return parkedQueue.front() == thread && thread->coreId != constant::ParkedCoreId; });
         }
 
         InsertThread(thread);
@@ -330,8 +587,9 @@ namespace skyline::kernel {
             auto &thread{state.thread};
             auto &core{cores.at(thread->coreId)};
             std::unique_lock coreLock(core.mutex);
-            auto nextThread{core.queue.size() > 1 ? *std::next(core.queue.begin()) : nullptr};
-            nextThread = nextThread->priority == thread->priority ? nextThread : nullptr; // If the next thread doesn't have the same priority then it won't be scheduled next
+            auto front{core.queue.Front()};
+            auto nextThread{front ? core.queue.Next(front) : nullptr};
+            nextThread = nextThread && nextThread->priority == thread->priority ? nextThread : nullptr; // If the next thread doesn't have the same priority then it won't be scheduled next
             auto parkedThread{parkedQueue.front()};
 
             // We need to be conservative about waking up a parked thread, it should only be done if its priority is higher than the current thread
@@ -339,7 +597,7 @@ namespace skyline::kernel {
             if (parkedThread->priority < thread->priority || (parkedThread->priority == thread->priority && (!nextThread || parkedThread->timesliceStart < nextThread->timesliceStart))) {
                 parkedThread->coreId = thread->coreId;
                 parkedLock.unlock();
-                parkedThread->scheduleCondition.notify_one();
+                parkedThread->WakeSchedule();
             }
         }
     }
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <sched.h>
 #include <common.h>
 #include <condition_variable>
 
@@ -35,6 +36,77 @@ namespace skyline {
             }
         };
 
+        class RunQueue;
+
+        /**
+         * @brief The links of a thread in a RunQueue, these are embedded in KThread so that queueing a thread never allocates
+         */
+        struct RunQueueLinks {
+            RunQueue *queue{}; //!< The queue that the thread is currently in, this is null when it isn't in any queue
+            type::KThread *previous{};
+            type::KThread *next{};
+            u8 priority{}; //!< The priority of the bucket the thread is in, this can differ from the thread's priority while it's being updated
+            std::shared_ptr<type::KThread> reference; //!< A reference keeping the thread alive while it's queued
+        };
+
+        /**
+         * @brief A queue of threads that is bucketed by priority with a bitmap of all non-empty buckets, threads with the same priority are queued in FIFO order
+         * @note Inserting, removing and picking the highest priority thread are O(1) and never allocate as the links are intrusive to KThread
+         * @note This is not thread-safe, it's synchronized by the mutex of the core that it belongs to
+         */
+        class RunQueue {
+          public:
+            static constexpr size_t PriorityCount{64}; //!< The amount of priority levels on HOS, every level has a bucket of its own
+
+          private:
+            struct Bucket {
+                type::KThread *head{};
+                type::KThread *tail{};
+            };
+
+            std::array<Bucket, PriorityCount> buckets{};
+            u64 readyMask{}; //!< A bitmap of all non-empty buckets, the lowest set bit is the bucket of the highest priority thread
+            size_t size{};
+
+          public:
+            bool Empty() const {
+                return !readyMask;
+            }
+
+            size_t Size() const {
+                return size;
+            }
+
+            /**
+             * @return The highest priority thread which is the one running on the core, this is null when the queue is empty
+             */
+            type::KThread *Front() const {
+                return readyMask ? buckets[static_cast<size_t>(std::countr_zero(readyMask))].head : nullptr;
+            }
+
+            /**
+             * @return The thread which follows the supplied thread in scheduling order, this is null if it's the last thread
+             */
+            type::KThread *Next(const type::KThread *thread) const;
+
+            bool Contains(const type::KThread &thread) const;
+
+            /**
+             * @brief Inserts the thread behind all threads with the same or a higher priority than it
+             */
+            void Insert(const std::shared_ptr<type::KThread> &thread);
+
+            /**
+             * @brief Removes the thread from the queue, it must be in this queue
+             */
+            void Erase(type::KThread &thread);
+
+            /**
+             * @brief Moves the thread behind all threads with the same or a higher priority than its current priority, this is a rotation of its bucket if the priority didn't change
+             */
+            void Requeue(type::KThread &thread);
+        };
+
         /**
          * @brief The Scheduler is responsible for determining which threads should run on which virtual cores and when they should be scheduled
          * @note We tend to stray a lot from HOS in our scheduler design as we've designed it around our 1 host thread per guest thread which leads to scheduling from the perspective of threads while the HOS scheduler deals with scheduling from the perspective of cores, not doing this would lead to missing out on key optimizations and serialization of scheduling
@@ -47,7 +119,18 @@ namespace skyline {
                 u8 id;
                 i8 preemptionPriority; //!< The priority at which this core becomes preemptive as opposed to cooperative
                 std::mutex mutex; //!< Synchronizes all operations on the queue
-                std::list<std::shared_ptr<type::KThread>> queue; //!< A queue of threads which are running or to be run on this core
+                RunQueue queue; //!< A queue of threads which are running or to be run on this core, the thread at the front is the one running
+
+                type::KThread *preemptionTarget{}; //!< The thread which the preemption timer of this core is armed for, this is null when the timer is disarmed
+                i64 preemptionDeadline{}; //!< The time in nanoseconds at which the preemption target should be preempted
+
+                std::atomic<u64> preemptionCount{}; //!< The amount of preemptive yields of threads on this core, this is only used for tracing
+                std::atomic<u64> yieldCount{}; //!< The amount of non-cooperative yields of threads on this core, this is only used for tracing
+                std::atomic<u64> heldTicks{}; //!< The total amount of host ticks that threads have held this core for, this doesn't include the timeslice of the thread currently holding it
+                std::string runQueueTrack; //!< The names of the Perfetto counter tracks for this core
+                std::string holdTimeTrack;
+                std::string preemptionTrack;
+                std::string yieldTrack;
 
                 CoreContext(u8 id, i8 preemptionPriority);
             };
@@ -57,6 +140,62 @@ namespace skyline {
             std::mutex parkedMutex; //!< Synchronizes all operations on the queue of parked threads
             std::list<std::shared_ptr<type::KThread>> parkedQueue; //!< A queue of threads which are parked and waiting on core migration
 
+            std::atomic<u64> nextFlowId{1}; //!< The ID of the next Perfetto flow from a thread being inserted to it being scheduled
+
+            std::atomic<i64> preemptionWakeTime{}; //!< The time in nanoseconds that the preemption thread is sleeping till, this is the maximum value while it's scanning the cores
+            std::atomic<u32> preemptionWord{}; //!< A futex word which is incremented to wake the preemption thread when it has to recheck the cores earlier than it would otherwise
+            std::atomic<bool> preemptionExit{}; //!< If the preemption thread should exit
+            std::thread preemptionThread; //!< A thread which sends preemption signals to threads holding a core past the deadline of its preemption timer
+
+            bool hostCoreAffinity; //!< If threads are pinned to the host CPUs of their resident guest core
+            std::array<cpu_set_t, constant::CoreCount> hostCoreSets{}; //!< The host CPUs that threads resident on each guest core are pinned to
+
+            /**
+             * @brief Determines the host CPUs for each guest core based on the maximum frequency of host CPUs, the main guest core is mapped to the prime cluster, the other application cores to all clusters aside from the LITTLE one and the system core to the LITTLE cluster
+             * @return If the host has heterogeneous clusters that the guest cores could be mapped to, pinning is pointless otherwise
+             */
+            bool CreateHostCoreSets();
+
+            /**
+             * @brief Pins the calling thread to the host CPUs of its resident core if they differ from the ones it was last pinned to
+             * @note This is done by the thread itself once it's scheduled, so it covers all ways of a thread changing its resident core
+             */
+            void UpdateHostAffinity();
+
+            /**
+             * @brief Preempts threads which have held their cores past their preemption deadline, this sleeps till the earliest deadline of all cores in between
+             * @note A single thread arms a virtual timer for every core rather than every guest thread having a host timer of its own, arming and disarming these is a store under the core mutex that doesn't require any syscalls in the common case
+             */
+            void PreemptionThread();
+
+            /**
+             * @brief Arms the preemption timer of the supplied core for the thread which is holding it
+             * @note The core mutex **must** be locked by the calling thread
+             */
+            void ArmPreemptionTimer(CoreContext &core, type::KThread &thread);
+
+            /**
+             * @brief Disarms the preemption timer of the supplied core if it's armed for the supplied thread
+             * @note The core mutex **must** be locked by the calling thread
+             */
+            void DisarmPreemptionTimer(CoreContext &core, type::KThread &thread);
+
+            /**
+             * @brief Traces the length of the run queue of the supplied core, this should be called after any change to it
+             * @note The core mutex **must** be locked by the calling thread
+             */
+            void TraceRunQueue(CoreContext &core);
+
+            /**
+             * @brief Traces and accounts how long the calling thread held its core for, this should be called when it stops being the front of the queue
+             */
+            void RecordHoldTime(CoreContext &core);
+
+            /**
+             * @brief Terminates the flow from the insertion of the calling thread to it being scheduled, if there is one
+             */
+            void TraceScheduled();
+
             /**
              * @brief Migrate a thread from its resident core to its ideal core
              * @note 'KThread::coreMigrationMutex' **must** be locked by the calling thread prior to calling this
@@ -64,6 +203,15 @@ namespace skyline {
              */
             void MigrateToCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&currentCore, CoreContext *targetCore, std::unique_lock<std::mutex> &lock);
 
+            /**
+             * @brief Blocks the calling thread on its wake word till the predicate is satisfied or the timeout expires, this is a replacement for waiting on a condition variable with a predicate
+             * @param lock The lock that the predicate is checked with, it's released while blocking and may be switched to another mutex by the predicate
+             * @return If the predicate was satisfied (true) or if the timeout expired before it was (false)
+             * @note Wakers must call KThread::WakeSchedule after changing the state the predicate checks
+             */
+            template<typename Predicate>
+            bool WaitForWake(type::KThread &thread, std::unique_lock<std::mutex> &lock, Predicate predicate, std::optional<std::chrono::nanoseconds> timeout = std::nullopt);
+
           public:
             static constexpr std::chrono::milliseconds PreemptiveTimeslice{10}; //!< The duration of time a preemptive thread can run before yielding
             inline static int YieldSignal{SIGRTMIN}; //!< The signal used to cause a non-cooperative yield in running threads
@@ -72,6 +220,8 @@ namespace skyline {
 
             Scheduler(const DeviceState &state);
 
+            ~Scheduler();
+
             /**
              * @brief A signal handler designed to cause a non-cooperative yield for preemption and higher priority threads being inserted
              */
@@ -137,6 +287,11 @@ namespace skyline {
              * @note We will only wake a thread if it's determined to be a better pick than the thread which would be run on this core next
              */
             void WakeParkedThread();
+
+            /**
+             * @return The total time that threads have held the supplied core for in nanoseconds, this only includes completed timeslices
+             */
+            u64 GetCoreHeldTime(u8 coreId);
         };
 
         /**
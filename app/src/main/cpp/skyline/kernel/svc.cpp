@@ -5,6 +5,7 @@
 #include <nce.h>
 #include <kernel/types/KProcess.h>
 #include <common/trace.h>
+#include <common/precise_sleep.h>
 #include <vfs/npdm.h>
 #include "results.h"
 #include "svc.h"
@@ -291,13 +292,8 @@ namespace skyline::kernel::svc {
             Logger::Debug("Sleeping for {}ns", in);
             TRACE_EVENT("kernel", "SleepThread", "duration", in);
 
-            struct timespec spec{
-                .tv_sec = static_cast<time_t>(in / 1000000000),
-                .tv_nsec = static_cast<long>(in % 1000000000),
-            };
-
             SchedulerScopedLock schedulerLock(state);
-            nanosleep(&spec, nullptr);
+            util::PreciseSleep(std::chrono::nanoseconds(in));
         } else {
             switch (in) {
                 case yieldWithCoreMigration: {
@@ -334,9 +330,8 @@ namespace skyline::kernel::svc {
     void GetThreadPriority(const DeviceState &state) {
         KHandle handle{state.ctx->gpr.w1};
         try {
-            auto thread{state.process->GetHandle<type::KThread>(handle)};
-            i8 priority{thread->priority};
-            Logger::Debug("Retrieving thread #{}'s priority: {}", thread->id, priority);
+            auto [id, priority]{state.process->BorrowHandle<type::KThread>(handle, [](type::KThread &thread) { return std::pair<size_t, i8>{thread.id, thread.priority}; })};
+            Logger::Debug("Retrieving thread #{}'s priority: {}", id, priority);
 
             state.ctx->gpr.w1 = static_cast<u32>(priority);
             state.ctx->gpr.w0 = Result{};
@@ -379,10 +374,8 @@ namespace skyline::kernel::svc {
     void GetThreadCoreMask(const DeviceState &state) {
         KHandle handle{state.ctx->gpr.w2};
         try {
-            auto thread{state.process->GetHandle<type::KThread>(handle)};
-            auto idealCore{thread->idealCore};
-            auto affinityMask{thread->affinityMask};
-            Logger::Debug("Getting thread #{}'s Ideal Core ({}) + Affinity Mask ({})", thread->id, idealCore, affinityMask);
+            auto [id, idealCore, affinityMask]{state.process->BorrowHandle<type::KThread>(handle, [](type::KThread &thread) { return std::tuple{thread.id, thread.idealCore, thread.affinityMask}; })};
+            Logger::Debug("Getting thread #{}'s Ideal Core ({}) + Affinity Mask ({})", id, idealCore, affinityMask);
 
             state.ctx->gpr.x2 = affinityMask.to_ullong();
             state.ctx->gpr.w1 = static_cast<u32>(idealCore);
@@ -640,7 +633,7 @@ namespace skyline::kernel::svc {
         i64 timeout{static_cast<i64>(state.ctx->gpr.x3)};
         if (waitHandles.size() == 1) {
             Logger::Debug("Waiting on 0x{:X} for {}ns", waitHandles[0], timeout);
-        } else if (Logger::LogLevel::Debug <= Logger::configLevel) {
+        } else if (Logger::IsEnabled(Logger::LogLevel::Debug)) {
             std::string handleString;
             for (const auto &handle : waitHandles)
                 handleString += fmt::format("* 0x{:X}\n", handle);
@@ -649,7 +642,17 @@ namespace skyline::kernel::svc {
 
         TRACE_EVENT_FMT("kernel", waitHandles.size() == 1 ? "WaitSynchronization 0x{:X}" : "WaitSynchronizationMultiple 0x{:X}", waitHandles[0]);
 
-        std::unique_lock lock(type::KSyncObject::syncObjectMutex);
+        // The mutexes of all objects are locked in the order of their addresses so that concurrent waits on overlapping objects can't deadlock
+        std::array<type::KSyncObject *, maxSyncHandles> lockOrder;
+        std::transform(objectTable.begin(), objectTable.end(), lockOrder.begin(), [](const auto &object) { return object.get(); });
+        std::sort(lockOrder.begin(), lockOrder.begin() + objectTable.size());
+        auto lockCount{static_cast<size_t>(std::unique(lockOrder.begin(), lockOrder.begin() + objectTable.size()) - lockOrder.begin())};
+
+        std::array<std::unique_lock<std::mutex>, maxSyncHandles> objectLocks;
+        for (size_t lockIndex{}; lockIndex < lockCount; lockIndex++)
+            objectLocks[lockIndex] = std::unique_lock(lockOrder[lockIndex]->syncObjectMutex);
+
+        std::unique_lock waitLock(state.thread->syncWaitMutex);
         if (state.thread->cancelSync) {
             state.thread->cancelSync = false;
             state.ctx->gpr.w0 = result::Cancelled;
@@ -673,51 +676,46 @@ namespace skyline::kernel::svc {
             return;
         }
 
-        auto priority{state.thread->priority.load()};
-        for (const auto &object : objectTable)
-            object->syncObjectWaiters.insert(std::upper_bound(object->syncObjectWaiters.begin(), object->syncObjectWaiters.end(), priority, type::KThread::IsHigherPriority), state.thread);
+        // Every object has a node on the stack linked into its waiters, any object can wake the thread by exchanging the wake token for the index of its node
+        std::array<type::SyncWaitNode, maxSyncHandles> waitNodes;
+        for (index = 0; index < objectTable.size(); index++) {
+            waitNodes[index] = {.thread = state.thread.get(), .index = index};
+            objectTable[index]->AddWaiter(waitNodes[index]);
+        }
 
-        state.thread->isCancellable = true;
-        state.thread->wakeObject = nullptr;
+        state.thread->syncWakeToken.store(type::KThread::SyncWaiting);
         state.scheduler->RemoveThread();
 
-        lock.unlock();
+        waitLock.unlock();
+        for (size_t lockIndex{}; lockIndex < lockCount; lockIndex++)
+            objectLocks[lockIndex].unlock();
+        bool scheduled{true};
         if (timeout > 0)
-            state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout));
+            scheduled = state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout));
         else
             state.scheduler->WaitSchedule(false);
-        lock.lock();
 
-        state.thread->isCancellable = false;
-        auto wakeObject{state.thread->wakeObject};
-
-        u32 wakeIndex{};
-        index = 0;
-        for (const auto &object : objectTable) {
-            if (object.get() == wakeObject)
-                wakeIndex = index;
-
-            auto it{std::find(object->syncObjectWaiters.begin(), object->syncObjectWaiters.end(), state.thread)};
-            if (it != object->syncObjectWaiters.end())
-                object->syncObjectWaiters.erase(it);
-            else
-                throw exception("svcWaitSynchronization: An object (0x{:X}) has been removed from the syncObjectWaiters queue incorrectly", waitHandles[index]);
-
-            index++;
+        // The thread can't be woken by any object after its token has been exchanged, so the nodes can be unlinked one object at a time
+        auto wakeToken{state.thread->syncWakeToken.exchange(type::KThread::SyncNotWaiting)};
+        if (!scheduled && wakeToken != type::KThread::SyncWaiting)
+            state.scheduler->WaitSchedule(); // A waker claimed the token after the wait timed out and has inserted the thread, it must be scheduled on its core prior to returning
+        for (index = 0; index < objectTable.size(); index++) {
+            std::lock_guard objectLock(objectTable[index]->syncObjectMutex);
+            objectTable[index]->RemoveWaiter(waitNodes[index]);
         }
 
-        if (wakeObject) {
-            Logger::Debug("Signalled 0x{:X}", waitHandles[wakeIndex]);
+        if (wakeToken < objectTable.size()) {
+            Logger::Debug("Signalled 0x{:X}", waitHandles[wakeToken]);
             state.ctx->gpr.w0 = Result{};
-            state.ctx->gpr.w1 = wakeIndex;
-        } else if (state.thread->cancelSync) {
+            state.ctx->gpr.w1 = wakeToken;
+        } else if (wakeToken == type::KThread::SyncCancelled) {
+            std::lock_guard cancelLock(state.thread->syncWaitMutex);
             state.thread->cancelSync = false;
             Logger::Debug("Wait has been cancelled");
             state.ctx->gpr.w0 = result::Cancelled;
         } else {
             Logger::Debug("Wait has timed out");
             state.ctx->gpr.w0 = result::TimedOut;
-            lock.unlock();
             state.scheduler->InsertThread(state.thread);
             state.scheduler->WaitSchedule();
         }
@@ -725,13 +723,12 @@ namespace skyline::kernel::svc {
 
     void CancelSynchronization(const DeviceState &state) {
         try {
-            std::unique_lock lock(type::KSyncObject::syncObjectMutex);
             auto thread{state.process->GetHandle<type::KThread>(state.ctx->gpr.w0)};
+            std::lock_guard waitLock(thread->syncWaitMutex);
             thread->cancelSync = true;
-            if (thread->isCancellable) {
-                thread->isCancellable = false;
+            u32 expected{type::KThread::SyncWaiting};
+            if (thread->syncWakeToken.compare_exchange_strong(expected, type::KThread::SyncCancelled))
                 state.scheduler->InsertThread(thread);
-            }
             state.ctx->gpr.w0 = Result{};
         } catch (const std::out_of_range &) {
             Logger::Warn("'handle' invalid: 0x{:X}", static_cast<u32>(state.ctx->gpr.w0));
@@ -841,14 +838,13 @@ namespace skyline::kernel::svc {
     }
 
     void SendSyncRequest(const DeviceState &state) {
-        SchedulerScopedLock schedulerLock(state);
         state.os->serviceManager.SyncRequestHandler(static_cast<KHandle>(state.ctx->gpr.x0));
         state.ctx->gpr.w0 = Result{};
     }
 
     void GetThreadId(const DeviceState &state) {
         KHandle handle{state.ctx->gpr.w1};
-        size_t tid{state.process->GetHandle<type::KThread>(handle)->id};
+        size_t tid{state.process->BorrowHandle<type::KThread>(handle, [](type::KThread &thread) { return thread.id; })};
 
         Logger::Debug("Handle: 0x{:X}, TID: {}", handle, tid);
 
@@ -241,6 +241,7 @@ namespace skyline::kernel::svc {
     struct SvcDescriptor {
         void (*function)(const DeviceState &); //!< A function pointer to a HLE implementation of the SVC
         const char* name; //!< A pointer to a static string of the SVC name, the underlying data should not be mutated
+        bool fast; //!< If the SVC is hot and cheap enough to be dispatched through the fast path which skips tracing, see NCE::SvcHandler
 
         operator bool() {
             return function;
@@ -250,6 +251,7 @@ namespace skyline::kernel::svc {
     #define SVC_NONE SvcDescriptor{} //!< A macro with a placeholder value for the SVC not being implemented or not existing
     #define SVC_STRINGIFY(name) #name
     #define SVC_ENTRY(function) SvcDescriptor{function, SVC_STRINGIFY(Svc ## function)} //!< A macro which automatically stringifies the function name as the name to prevent pointless duplication
+    #define SVC_FAST_ENTRY(function) SvcDescriptor{function, SVC_STRINGIFY(Svc ## function), true} //!< A variant of SVC_ENTRY which marks the SVC for fast-path dispatch
 
     /**
      * @brief The SVC table maps all SVCs to their corresponding functions
@@ -281,18 +283,18 @@ namespace skyline::kernel::svc {
         SVC_ENTRY(ResetSignal), // 0x17
         SVC_ENTRY(WaitSynchronization), // 0x18
         SVC_ENTRY(CancelSynchronization), // 0x19
-        SVC_ENTRY(ArbitrateLock), // 0x1A
-        SVC_ENTRY(ArbitrateUnlock), // 0x1B
+        SVC_FAST_ENTRY(ArbitrateLock), // 0x1A
+        SVC_FAST_ENTRY(ArbitrateUnlock), // 0x1B
         SVC_ENTRY(WaitProcessWideKeyAtomic), // 0x1C
-        SVC_ENTRY(SignalProcessWideKey), // 0x1D
-        SVC_ENTRY(GetSystemTick), // 0x1E
+        SVC_FAST_ENTRY(SignalProcessWideKey), // 0x1D
+        SVC_FAST_ENTRY(GetSystemTick), // 0x1E
         SVC_ENTRY(ConnectToNamedPort), // 0x1F
         SVC_NONE, // 0x20
         SVC_ENTRY(SendSyncRequest), // 0x21
         SVC_NONE, // 0x22
         SVC_NONE, // 0x23
         SVC_NONE, // 0x24
-        SVC_ENTRY(GetThreadId), // 0x25
+        SVC_FAST_ENTRY(GetThreadId), // 0x25
         SVC_ENTRY(Break), // 0x26
         SVC_ENTRY(OutputDebugString), // 0x27
         SVC_NONE, // 0x28
@@ -307,7 +309,7 @@ namespace skyline::kernel::svc {
         SVC_NONE, // 0x31
         SVC_NONE, // 0x32
         SVC_NONE, // 0x33
-        SVC_ENTRY(WaitForAddress), // 0x34
+        SVC_FAST_ENTRY(WaitForAddress), // 0x34
         SVC_ENTRY(SignalToAddress), // 0x35
         SVC_NONE, // 0x36
         SVC_NONE, // 0x37
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "KHandleTable.h"
+
+namespace skyline::kernel::type {
+    KHandleTable::KHandleTable() {
+        for (size_t index{}; index < Capacity; index++)
+            entries[index].nextFree = static_cast<u16>(index + 1);
+    }
+
+    KHandle KHandleTable::Reserve() {
+        std::scoped_lock lock(allocatorMutex);
+        if (freeHead == Capacity) [[unlikely]]
+            throw exception("The handle table is full ({} handles)", Capacity);
+
+        size_t index{freeHead};
+        auto &entry{entries[index]};
+        freeHead = entry.nextFree;
+
+        u16 linearId{nextLinearId};
+        nextLinearId = (nextLinearId == LinearIdMask) ? 1 : nextLinearId + 1;
+
+        std::unique_lock shardLock(GetShardMutex(index));
+        entry.linearId = linearId;
+        return static_cast<KHandle>((linearId << IndexBits) | index);
+    }
+
+    void KHandleTable::Assign(KHandle handle, std::shared_ptr<KObject> object) {
+        std::unique_lock lock(GetShardMutex(GetIndex(handle)));
+        auto entry{FindEntry(handle)};
+        if (!entry || entry->object)
+            throw exception("Assigning an object to a handle which wasn't reserved: 0x{:X}", handle);
+        entry->object = std::move(object);
+    }
+
+    std::shared_ptr<KObject> KHandleTable::Get(KHandle handle) {
+        std::shared_lock lock(GetShardMutex(GetIndex(handle)));
+        auto entry{FindEntry(handle)};
+        if (!entry || !entry->object) [[unlikely]]
+            throw std::out_of_range(fmt::format("Handle is invalid or has been closed: 0x{:X}", handle));
+        return entry->object;
+    }
+
+    void KHandleTable::Close(KHandle handle) {
+        std::shared_ptr<KObject> object; //!< The object must only be destroyed after the locks are released as its destructor may access the table, it's declared prior to them for this
+        std::scoped_lock lock(allocatorMutex);
+        auto index{GetIndex(handle)};
+        std::unique_lock shardLock(GetShardMutex(index));
+        auto entry{FindEntry(handle)};
+        if (!entry) [[unlikely]]
+            throw std::out_of_range(fmt::format("Closing a handle which is invalid or has already been closed: 0x{:X}", handle));
+
+        object = std::move(entry->object);
+        entry->linearId = 0;
+        entry->nextFree = freeHead;
+        freeHead = static_cast<u16>(index);
+    }
+
+    void KHandleTable::Clear() {
+        std::vector<std::shared_ptr<KObject>> objects; //!< All objects in the table, these are destroyed after the locks are released for the same reason as in Close
+        std::scoped_lock lock(allocatorMutex);
+        for (size_t index{}; index < Capacity; index++) {
+            std::unique_lock shardLock(GetShardMutex(index));
+            auto &entry{entries[index]};
+            if (entry.object)
+                objects.push_back(std::move(entry.object));
+            entry.linearId = 0;
+            entry.nextFree = static_cast<u16>(index + 1);
+        }
+        freeHead = 0;
+    }
+}
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <shared_mutex>
+#include "KObject.h"
+
+namespace skyline::kernel::type {
+    /**
+     * @brief A fixed-capacity table of the kernel objects owned by a process, modelled on HOS's KHandleTable
+     * @note A handle encodes the index of its entry in the lower 15 bits and the linear ID of the entry above it, this allows entries to be reused while stale handles to them are rejected
+     * @note Entries are split across several shards with individual locks so lookups and mutations of unrelated entries don't contend on the same lock
+     * @url https://switchbrew.org/wiki/Kernel_objects#KHandleTable
+     */
+    class KHandleTable {
+      public:
+        static constexpr size_t Capacity{0x1000}; //!< The maximum amount of handles in the table, this is larger than HOS's limit as we register some internal objects in it as well
+
+      private:
+        static constexpr u8 IndexBits{15};
+        static constexpr KHandle IndexMask{(1U << IndexBits) - 1};
+        static constexpr u16 LinearIdMask{(1U << 15) - 1}; //!< The linear ID occupies 15 bits above the index, the uppermost bits of handles are reserved for pseudo-handles and mutex tags
+        static constexpr size_t ShardCount{16}; //!< The amount of locks that the entries are split across, entry N is guarded by shard N % ShardCount
+
+        struct Entry {
+            std::shared_ptr<KObject> object; //!< The object referred to by the entry, this is null if the entry is free or has only been reserved
+            u16 linearId{}; //!< The linear ID of the handle currently occupying the entry, this is 0 if the entry is free
+            u16 nextFree{}; //!< The index of the next entry in the free list, this is only valid while the entry is free
+        };
+
+        std::array<Entry, Capacity> entries;
+        std::array<std::shared_mutex, ShardCount> shardMutexes;
+        std::mutex allocatorMutex; //!< Synchronizes the free list and the linear ID counter
+        u16 freeHead{}; //!< The index of the first free entry, this is Capacity when the table is full
+        u16 nextLinearId{1}; //!< The linear ID of the next allocated handle, this is never 0 so allocated handles are never 0
+
+        static constexpr size_t GetIndex(KHandle handle) {
+            return handle & IndexMask;
+        }
+
+        std::shared_mutex &GetShardMutex(size_t index) {
+            return shardMutexes[index % ShardCount];
+        }
+
+        /**
+         * @return The entry corresponding to the handle if it's valid and occupied, otherwise nullptr
+         * @note The shard mutex of the entry must be locked, shared locking is sufficient
+         */
+        Entry *FindEntry(KHandle handle) {
+            auto index{GetIndex(handle)};
+            if (index >= Capacity) [[unlikely]]
+                return nullptr;
+
+            // Any set bits above the linear ID cause a mismatch as linear IDs never exceed 15 bits
+            auto &entry{entries[index]};
+            if (entry.linearId == 0 || entry.linearId != (handle >> IndexBits)) [[unlikely]]
+                return nullptr;
+            return &entry;
+        }
+
+      public:
+        KHandleTable();
+
+        /**
+         * @brief Reserves an entry in the table without an object assigned to it, this is used for objects which need to know their own handle at construction
+         * @return The handle of the reserved entry
+         */
+        KHandle Reserve();
+
+        /**
+         * @brief Assigns an object to an entry which was previously reserved
+         */
+        void Assign(KHandle handle, std::shared_ptr<KObject> object);
+
+        /**
+         * @brief Inserts an object into a new entry of the table
+         * @return The handle of the entry
+         */
+        KHandle Insert(std::shared_ptr<KObject> object) {
+            auto handle{Reserve()};
+            Assign(handle, std::move(object));
+            return handle;
+        }
+
+        /**
+         * @return A reference to the object referred to by the handle
+         * @throw std::out_of_range If the handle is invalid, stale or has been closed
+         */
+        std::shared_ptr<KObject> Get(KHandle handle);
+
+        /**
+         * @brief Calls the supplied function with a reference to the object referred to by the handle without acquiring a reference to it
+         * @note The function is called with the shard lock held which keeps the object alive, it shouldn't block or access any other entries of the table
+         * @throw std::out_of_range If the handle is invalid, stale or has been closed
+         */
+        template<typename Function>
+        auto Borrow(KHandle handle, Function &&function) {
+            std::shared_lock lock(GetShardMutex(GetIndex(handle)));
+            auto entry{FindEntry(handle)};
+            if (!entry || !entry->object) [[unlikely]]
+                throw std::out_of_range(fmt::format("Handle is invalid or has been closed: 0x{:X}", handle));
+            return function(*entry->object);
+        }
+
+        /**
+         * @brief Closes a handle, the entry is recycled for future handles which will have a different linear ID
+         * @throw std::out_of_range If the handle is invalid or has already been closed
+         */
+        void Close(KHandle handle);
+
+        /**
+         * @brief Calls the supplied function with all occupied entries in the table till it returns true
+         * @note The function is called with the shard lock of the entry held, it shouldn't block or access any other entries of the table
+         */
+        template<typename Function>
+        void ForEach(Function &&function) {
+            for (size_t index{}; index < Capacity; index++) {
+                std::shared_lock lock(GetShardMutex(index));
+                auto &entry{entries[index]};
+                if (entry.object && function(static_cast<KHandle>((entry.linearId << IndexBits) | index), entry.object))
+                    return;
+            }
+        }
+
+        /**
+         * @brief Closes all handles in the table
+         */
+        void Clear();
+    };
+}
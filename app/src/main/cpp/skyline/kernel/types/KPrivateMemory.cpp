@@ -1,16 +1,51 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
-#include <android/sharedmem.h>
 #include <asm/unistd.h>
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <common/memory_accounting.h>
 #include "KPrivateMemory.h"
 #include "KProcess.h"
 
 namespace skyline::kernel::type {
+    constexpr size_t HugePageSize{1ULL << 21}; //!< The size of a transparent huge page on AArch64 with a 4KiB granule
+
+    /**
+     * @brief Hints to the host kernel that any 2MiB-aligned parts of the supplied region should be backed by transparent huge pages, this reduces TLB pressure for guest code accessing large regions such as the heap
+     * @note Failures are ignored as the host kernel might not support transparent huge pages which is common on Android
+     */
+    static void AdviseHugePages(u8 *ptr, size_t size) {
+        auto start{util::AlignUp(reinterpret_cast<u64>(ptr), HugePageSize)}, end{util::AlignDown(reinterpret_cast<u64>(ptr) + size, HugePageSize)};
+        if (start < end)
+            madvise(reinterpret_cast<void *>(start), end - start, MADV_HUGEPAGE);
+    }
+
+    /**
+     * @brief Replaces the supplied region with an inaccessible anonymous mapping, this returns it to the reservation made by the MemoryManager
+     */
+    static void ReserveRegion(u8 *ptr, size_t size) {
+        if (mmap(ptr, size, PROT_NONE, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0) == MAP_FAILED)
+            throw exception("An error occurred while unmapping private memory: {}", strerror(errno));
+    }
+
+    /**
+     * @brief Accounts a change in the committed size of private memory, only the heap is accounted for as other private memory is mapped once and not resized
+     */
+    static void AccountCommit(memory::MemoryState state, size_t oldSize, size_t newSize) {
+        if (state != memory::states::Heap)
+            return;
+
+        if (newSize > oldSize)
+            perf::SharedMemoryAccounting.Add(perf::MemoryCategory::GuestHeap, newSize - oldSize);
+        else
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::GuestHeap, oldSize - newSize);
+    }
+
     KPrivateMemory::KPrivateMemory(const DeviceState &state, u8 *ptr, size_t size, memory::Permission permission, memory::MemoryState memState)
         : ptr(ptr),
-          size(size),
           permission(permission),
           memoryState(memState),
           KMemory(state, KType::KPrivateMemory) {
@@ -19,28 +54,34 @@ namespace skyline::kernel::type {
         if (!util::IsPageAligned(ptr) || !util::IsPageAligned(size))
             throw exception("KPrivateMemory mapping isn't page-aligned: 0x{:X} - 0x{:X} (0x{:X})", ptr, ptr + size, size);
 
-        if (mprotect(ptr, size, PROT_READ | PROT_WRITE | PROT_EXEC) < 0) // We only need to reprotect as the allocation has already been reserved by the MemoryManager
-            throw exception("An occurred while mapping private memory: {} with 0x{:X} @ 0x{:X}", strerror(errno), ptr, size);
+        fd = static_cast<int>(syscall(__NR_memfd_create, "KPrivateMemory", MFD_CLOEXEC));
+        if (fd < 0)
+            throw exception("An error occurred while creating private memory: {}", strerror(errno));
 
-        state.process->memory.InsertChunk(ChunkDescriptor{
-            .ptr = ptr,
-            .size = size,
-            .permission = permission,
-            .state = memState,
-        });
+        // The memfd is mapped over the reservation made by the MemoryManager, it only grows from an empty file so this is the same as resizing it to its initial size
+        Resize(size);
     }
 
     void KPrivateMemory::Resize(size_t nSize) {
-        if (mprotect(ptr, nSize, PROT_READ | PROT_WRITE | PROT_EXEC) < 0)
-            throw exception("An occurred while resizing private memory: {}", strerror(errno));
-
         if (nSize < size) {
+            // Truncating the file returns the pages being trimmed off to the host, otherwise shrinking the heap would never lower our resident memory
+            ReserveRegion(ptr + nSize, size - nSize);
+            if (ftruncate(fd, static_cast<off_t>(offset + nSize)) < 0)
+                throw exception("An error occurred while trimming private memory: {}", strerror(errno));
+
             state.process->memory.InsertChunk(ChunkDescriptor{
                 .ptr = ptr + nSize,
                 .size = size - nSize,
                 .state = memory::states::Unmapped,
             });
         } else if (size < nSize) {
+            // Only the pages being added are mapped, the existing mapping is left untouched regardless of its size
+            if (ftruncate(fd, static_cast<off_t>(offset + nSize)) < 0)
+                throw exception("An error occurred while resizing private memory: {}", strerror(errno));
+            if (mmap(ptr + size, nSize - size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_FIXED | MAP_SHARED, fd, static_cast<off_t>(offset + size)) == MAP_FAILED)
+                throw exception("An error occurred while mapping private memory: {} with 0x{:X} @ 0x{:X}", strerror(errno), ptr + size, nSize - size);
+            AdviseHugePages(ptr, nSize);
+
             state.process->memory.InsertChunk(ChunkDescriptor{
                 .ptr = ptr + size,
                 .size = nSize - size,
@@ -49,6 +90,7 @@ namespace skyline::kernel::type {
             });
         }
 
+        AccountCommit(memoryState, size, nSize);
         size = nSize;
     }
 
@@ -58,11 +100,44 @@ namespace skyline::kernel::type {
         if (!util::IsPageAligned(nPtr) || !util::IsPageAligned(nSize))
             throw exception("KPrivateMemory remapping isn't page-aligned: 0x{:X} - 0x{:X} (0x{:X})", nPtr, nPtr + nSize, nSize);
 
-        if (mprotect(ptr, size, PROT_NONE) < 0)
-            throw exception("An occurred while remapping private memory: {}", strerror(errno));
+        if (nPtr >= ptr && nPtr < ptr + size) {
+            // The pages overlapping the new mapping are already mapped at the right address, only the ones before it are released by punching them out of the file
+            auto trimmed{static_cast<size_t>(nPtr - ptr)};
+            if (trimmed) {
+                ReserveRegion(ptr, trimmed);
+                if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset), static_cast<off_t>(trimmed)) < 0)
+                    throw exception("An error occurred while remapping private memory: {}", strerror(errno));
+
+                state.process->memory.InsertChunk(ChunkDescriptor{
+                    .ptr = ptr,
+                    .size = trimmed,
+                    .state = memory::states::Unmapped,
+                });
+            }
+
+            AccountCommit(memoryState, size, size - trimmed);
+            offset += trimmed;
+            size -= trimmed;
+        } else {
+            // Nothing is retained, the file is emptied and mapped from its start at the new address
+            if (size)
+                ReserveRegion(ptr, size);
+            if (ftruncate(fd, 0) < 0)
+                throw exception("An error occurred while remapping private memory: {}", strerror(errno));
+
+            state.process->memory.InsertChunk(ChunkDescriptor{
+                .ptr = ptr,
+                .size = size,
+                .state = memory::states::Unmapped,
+            });
+
+            AccountCommit(memoryState, size, 0);
+            offset = 0;
+            size = 0;
+        }
 
-        if (mprotect(nPtr, nSize, PROT_NONE) < 0)
-            throw exception("An occurred while remapping private memory: {}", strerror(errno));
+        ptr = nPtr;
+        Resize(nSize);
     }
 
     void KPrivateMemory::UpdatePermission(u8 *pPtr, size_t pSize, memory::Permission pPermission) {
@@ -85,7 +160,10 @@ namespace skyline::kernel::type {
     }
 
     KPrivateMemory::~KPrivateMemory() {
-        mprotect(ptr, size, PROT_NONE);
+        // The error is ignored as destructors can't throw, the pages are freed alongside the memfd regardless once it's no longer mapped
+        mmap(ptr, size, PROT_NONE, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+        close(fd);
+        AccountCommit(memoryState, size, 0);
         state.process->memory.InsertChunk(ChunkDescriptor{
             .ptr = ptr,
             .size = size,
@@ -9,6 +9,7 @@ namespace skyline::kernel::type {
     /**
      * @brief KPrivateMemory is used to map memory local to the guest process
      * @note This does not reflect a kernel object in Horizon OS, it is an abstraction which makes things simpler to manage in Skyline instead
+     * @note The memory is backed by a memfd which is mapped into guest address space, resizing it only truncates the file and maps or unmaps the pages at its end so it's independent of the size of the memory
      */
     class KPrivateMemory : public KMemory {
       public:
@@ -16,6 +17,8 @@ namespace skyline::kernel::type {
         size_t size{};
         memory::Permission permission;
         memory::MemoryState memoryState;
+        int fd; //!< The memfd backing the memory, it can be mapped elsewhere to alias the memory without any copies
+        size_t offset{}; //!< The offset of 'ptr' into the memfd, this is only non-zero after the start of the memory was remapped onto a later address
 
         /**
          * @param permission The permissions for the allocated memory (As reported to the application, host memory permissions aren't reflected by this)
@@ -31,6 +34,7 @@ namespace skyline::kernel::type {
 
         /**
          * @note This does not copy over anything, only contents of any overlapping regions will be retained
+         * @note Overlapping regions are only retained when the new mapping doesn't start before the current one, other overlaps aren't supported
          */
         void Remap(u8 *ptr, size_t size);
 
@@ -80,31 +80,28 @@ namespace skyline::kernel::type {
     }
 
     std::optional<KProcess::HandleOut<KMemory>> KProcess::GetMemoryObject(u8 *ptr) {
-        std::shared_lock lock(handleMutex);
-
-        for (KHandle index{}; index < handles.size(); index++) {
-            auto &object{handles[index]};
-            if (object) {
-                switch (object->objectType) {
-                    case type::KType::KPrivateMemory:
-                    case type::KType::KSharedMemory:
-                    case type::KType::KTransferMemory: {
-                        auto mem{std::static_pointer_cast<type::KMemory>(object)};
-                        if (mem->IsInside(ptr))
-                            return std::make_optional<KProcess::HandleOut<KMemory>>({mem, constant::BaseHandleIndex + index});
+        std::optional<HandleOut<KMemory>> result;
+        handles.ForEach([&](KHandle handle, const std::shared_ptr<KObject> &object) {
+            switch (object->objectType) {
+                case type::KType::KPrivateMemory:
+                case type::KType::KSharedMemory:
+                case type::KType::KTransferMemory: {
+                    auto mem{std::static_pointer_cast<type::KMemory>(object)};
+                    if (mem->IsInside(ptr)) {
+                        result = HandleOut<KMemory>{mem, handle};
+                        return true;
                     }
-
-                    default:
-                        break;
                 }
+
+                default:
+                    return false;
             }
-        }
-        return std::nullopt;
+        });
+        return result;
     }
 
     void KProcess::ClearHandleTable() {
-        std::shared_lock lock(handleMutex);
-        handles.clear();
+        handles.Clear();
     }
 
     constexpr u32 HandleWaitersBit{1UL << 30}; //!< A bit which denotes if a mutex psuedo-handle has waiters or not
@@ -218,10 +215,11 @@ namespace skyline::kernel::type {
     Result KProcess::ConditionalVariableWait(u32 *key, u32 *mutex, KHandle tag, i64 timeout) {
         TRACE_EVENT_FMT("kernel", "ConditionalVariableWait 0x{:X} (0x{:X})", key, mutex);
 
+        auto &bucket{GetSyncWaiterBucket(key)};
         {
-            std::lock_guard lock(syncWaiterMutex);
-            auto queue{syncWaiters.equal_range(key)};
-            syncWaiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {key, state.thread});
+            std::lock_guard lock(bucket.mutex);
+            auto queue{bucket.waiters.equal_range(key)};
+            bucket.waiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {key, state.thread});
 
             __atomic_store_n(key, true, __ATOMIC_SEQ_CST); // We need to notify any userspace threads that there are waiters on this conditional variable by writing back a boolean flag denoting it
 
@@ -230,11 +228,11 @@ namespace skyline::kernel::type {
         }
 
         if (timeout > 0 && !state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout))) {
-            std::unique_lock lock(syncWaiterMutex);
-            auto queue{syncWaiters.equal_range(key)};
+            std::unique_lock lock(bucket.mutex);
+            auto queue{bucket.waiters.equal_range(key)};
             auto iterator{std::find(queue.first, queue.second, SyncWaiters::value_type{key, state.thread})};
             if (iterator != queue.second)
-                if (syncWaiters.erase(iterator) == queue.second)
+                if (bucket.waiters.erase(iterator) == queue.second)
                     __atomic_store_n(key, false, __ATOMIC_SEQ_CST);
 
             lock.unlock();
@@ -259,11 +257,12 @@ namespace skyline::kernel::type {
     void KProcess::ConditionalVariableSignal(u32 *key, i32 amount) {
         TRACE_EVENT_FMT("kernel", "ConditionalVariableSignal 0x{:X}", key);
 
-        std::lock_guard lock(syncWaiterMutex);
-        auto queue{syncWaiters.equal_range(key)};
+        auto &bucket{GetSyncWaiterBucket(key)};
+        std::lock_guard lock(bucket.mutex);
+        auto queue{bucket.waiters.equal_range(key)};
 
         auto it{queue.first};
-        for (i32 waiterCount{amount}; it != queue.second && (amount <= 0 || waiterCount); it = syncWaiters.erase(it), waiterCount--)
+        for (i32 waiterCount{amount}; it != queue.second && (amount <= 0 || waiterCount); it = bucket.waiters.erase(it), waiterCount--)
             state.scheduler->InsertThread(it->second);
 
         if (it == queue.second)
@@ -273,24 +272,25 @@ namespace skyline::kernel::type {
     Result KProcess::WaitForAddress(u32 *address, u32 value, i64 timeout, bool (*arbitrationFunction)(u32 *, u32)) {
         TRACE_EVENT_FMT("kernel", "WaitForAddress 0x{:X}", address);
 
+        auto &bucket{GetSyncWaiterBucket(address)};
         {
-            std::lock_guard lock(syncWaiterMutex);
+            std::lock_guard lock(bucket.mutex);
             if (!arbitrationFunction(address, value)) [[unlikely]]
                 return result::InvalidState;
 
-            auto queue{syncWaiters.equal_range(address)};
-            syncWaiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {address, state.thread});
+            auto queue{bucket.waiters.equal_range(address)};
+            bucket.waiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {address, state.thread});
 
             state.scheduler->RemoveThread();
         }
 
         if (timeout > 0 && !state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout))) {
             {
-                std::lock_guard lock(syncWaiterMutex);
-                auto queue{syncWaiters.equal_range(address)};
+                std::lock_guard lock(bucket.mutex);
+                auto queue{bucket.waiters.equal_range(address)};
                 auto iterator{std::find(queue.first, queue.second, SyncWaiters::value_type{address, state.thread})};
                 if (iterator != queue.second)
-                    if (syncWaiters.erase(iterator) == queue.second)
+                    if (bucket.waiters.erase(iterator) == queue.second)
                         __atomic_store_n(address, false, __ATOMIC_SEQ_CST);
             }
 
@@ -308,15 +308,16 @@ namespace skyline::kernel::type {
     Result KProcess::SignalToAddress(u32 *address, u32 value, i32 amount, bool(*mutateFunction)(u32 *address, u32 value, u32 waiterCount)) {
         TRACE_EVENT_FMT("kernel", "SignalToAddress 0x{:X}", address);
 
-        std::lock_guard lock(syncWaiterMutex);
-        auto queue{syncWaiters.equal_range(address)};
+        auto &bucket{GetSyncWaiterBucket(address)};
+        std::lock_guard lock(bucket.mutex);
+        auto queue{bucket.waiters.equal_range(address)};
 
         if (mutateFunction)
             if (!mutateFunction(address, value, (amount <= 0) ? 0 : std::min(static_cast<u32>(std::distance(queue.first, queue.second) - amount), 0U))) [[unlikely]]
                 return result::InvalidState;
 
         i32 waiterCount{amount};
-        for (auto it{queue.first}; it != queue.second && (amount <= 0 || waiterCount); it = syncWaiters.erase(it), waiterCount--)
+        for (auto it{queue.first}; it != queue.second && (amount <= 0 || waiterCount); it = bucket.waiters.erase(it), waiterCount--)
             state.scheduler->InsertThread(it->second);
 
         return {};
@@ -8,12 +8,13 @@
 #include "KTransferMemory.h"
 #include "KSession.h"
 #include "KEvent.h"
+#include "KHandleTable.h"
+#include "KSlabHeap.h"
 
 namespace skyline {
     namespace constant {
         constexpr u16 TlsSlotSize{0x200}; //!< The size of a single TLS slot
         constexpr u8 TlsSlots{PAGE_SIZE / TlsSlotSize}; //!< The amount of TLS slots in a single page
-        constexpr KHandle BaseHandleIndex{0xD000}; //!< The index of the base handle
     }
 
     namespace kernel::type {
@@ -30,9 +31,33 @@ namespace skyline {
             std::atomic_bool alreadyKilled{}; //!< If the process has already been killed prior so there's no need to redundantly kill it again
             std::vector<std::shared_ptr<KThread>> threads;
 
+          public:
+            HostThreadPool hostThreads; //!< The host threads which guest threads are run on, all guest threads must have exited prior to it being destroyed
+
+          private:
+
             using SyncWaiters = std::multimap<void *, std::shared_ptr<KThread>>;
-            std::mutex syncWaiterMutex; //!< Synchronizes all mutations to the map to prevent races
-            SyncWaiters syncWaiters; //!< All threads waiting on process-wide synchronization primitives (Atomic keys + Address Arbiter)
+
+            /**
+             * @brief A bucket of threads waiting on process-wide synchronization primitives (Atomic keys + Address Arbiter) with addresses hashing to it
+             * @note Buckets are padded to a cache line to avoid false sharing between threads contending on different buckets
+             */
+            struct alignas(64) SyncWaiterBucket {
+                std::mutex mutex; //!< Synchronizes all mutations to the waiters of the bucket
+                SyncWaiters waiters; //!< All threads waiting on addresses in this bucket sorted by address then priority
+            };
+
+            static constexpr size_t SyncWaiterBucketBits{8};
+            std::array<SyncWaiterBucket, 1 << SyncWaiterBucketBits> syncWaiterBuckets; //!< A hashed array of buckets of waiters, this is akin to futex hashing in Linux and avoids all synchronization primitives contending on a single lock
+
+            /**
+             * @return The bucket which holds all waiters on the supplied address
+             */
+            SyncWaiterBucket &GetSyncWaiterBucket(void *address) {
+                // We use Fibonacci hashing of the word index as it spreads out consecutive addresses which are common for arrays of primitives
+                constexpr u64 GoldenRatio{0x9E3779B97F4A7C15};
+                return syncWaiterBuckets[((reinterpret_cast<u64>(address) >> 2) * GoldenRatio) >> (64 - SyncWaiterBucketBits)];
+            }
 
             /**
             * @brief The status of a single TLS page (A page is 4096 bytes on ARMv8)
@@ -62,8 +87,33 @@ namespace skyline {
             vfs::NPDM npdm;
 
           private:
-            std::shared_mutex handleMutex;
-            std::vector<std::shared_ptr<KObject>> handles;
+            KHandleTable handles;
+
+            /**
+             * @return The type of kernel object corresponding to the supplied class
+             */
+            template<typename objectClass>
+            static KType GetObjectType() {
+                if constexpr(std::is_same<objectClass, KThread>())
+                    return KType::KThread;
+                else if constexpr(std::is_same<objectClass, KProcess>())
+                    return KType::KProcess;
+                else if constexpr(std::is_same<objectClass, KSharedMemory>())
+                    return KType::KSharedMemory;
+                else if constexpr(std::is_same<objectClass, KTransferMemory>())
+                    return KType::KTransferMemory;
+                else if constexpr(std::is_same<objectClass, KPrivateMemory>())
+                    return KType::KPrivateMemory;
+                else if constexpr(std::is_same<objectClass, KSession>())
+                    return KType::KSession;
+                else if constexpr(std::is_same<objectClass, KEvent>())
+                    return KType::KEvent;
+                else
+                    throw exception("KProcess::GetHandle couldn't determine object type");
+            }
+
+            static constexpr KHandle ThreadSelf{0xFFFF8000}; //!< The handle used by threads to refer to themselves
+            static constexpr KHandle ProcessSelf{0xFFFF8001}; //!< The handle used by threads in a process to refer to the process
 
           public:
             KProcess(const DeviceState &state);
@@ -111,18 +161,26 @@ namespace skyline {
              * @brief Creates a new handle to a KObject and adds it to the process handle_table
              * @tparam objectClass The class of the kernel object to create
              * @param args The arguments for the kernel object except handle, pid and state
+             * @note The object is allocated from a slab heap for its type as objects such as sessions are created and destroyed frequently by services
              */
             template<typename objectClass, typename ...objectArgs>
             HandleOut<objectClass> NewHandle(objectArgs... args) {
-                std::unique_lock lock(handleMutex);
-
                 std::shared_ptr<objectClass> item;
-                if constexpr (std::is_same<objectClass, KThread>())
-                    item = std::make_shared<objectClass>(state, constant::BaseHandleIndex + handles.size(), args...);
-                else
-                    item = std::make_shared<objectClass>(state, args...);
-                handles.push_back(std::static_pointer_cast<KObject>(item));
-                return {item, static_cast<KHandle>((constant::BaseHandleIndex + handles.size()) - 1)};
+                if constexpr (std::is_same<objectClass, KThread>()) {
+                    // Threads need to know their own handle at construction, so we reserve an entry for them prior to constructing them
+                    auto handle{handles.Reserve()};
+                    try {
+                        item = std::allocate_shared<objectClass>(KSlabAllocator<objectClass>{}, state, handle, args...);
+                    } catch (...) {
+                        handles.Close(handle);
+                        throw;
+                    }
+                    handles.Assign(handle, std::static_pointer_cast<KObject>(item));
+                    return {item, handle};
+                } else {
+                    item = std::allocate_shared<objectClass>(KSlabAllocator<objectClass>{}, state, args...);
+                    return {item, handles.Insert(std::static_pointer_cast<KObject>(item))};
+                }
             }
 
             /**
@@ -131,61 +189,53 @@ namespace skyline {
              */
             template<typename objectClass>
             KHandle InsertItem(std::shared_ptr<objectClass> &item) {
-                std::unique_lock lock(handleMutex);
-
-                handles.push_back(std::static_pointer_cast<KObject>(item));
-                return static_cast<KHandle>((constant::BaseHandleIndex + handles.size()) - 1);
+                return handles.Insert(std::static_pointer_cast<KObject>(item));
             }
 
             template<typename objectClass = KObject>
             std::shared_ptr<objectClass> GetHandle(KHandle handle) {
-                std::shared_lock lock(handleMutex);
-
-                KType objectType;
                 if constexpr(std::is_same<objectClass, KThread>()) {
-                    constexpr KHandle threadSelf{0xFFFF8000}; // The handle used by threads to refer to themselves
-                    if (handle == threadSelf)
+                    if (handle == ThreadSelf)
                         return state.thread;
-                    objectType = KType::KThread;
                 } else if constexpr(std::is_same<objectClass, KProcess>()) {
-                    constexpr KHandle processSelf{0xFFFF8001}; // The handle used by threads in a process to refer to the process
-                    if (handle == processSelf)
+                    if (handle == ProcessSelf)
                         return state.process;
-                    objectType = KType::KProcess;
-                } else if constexpr(std::is_same<objectClass, KSharedMemory>()) {
-                    objectType = KType::KSharedMemory;
-                } else if constexpr(std::is_same<objectClass, KTransferMemory>()) {
-                    objectType = KType::KTransferMemory;
-                } else if constexpr(std::is_same<objectClass, KPrivateMemory>()) {
-                    objectType = KType::KPrivateMemory;
-                } else if constexpr(std::is_same<objectClass, KSession>()) {
-                    objectType = KType::KSession;
-                } else if constexpr(std::is_same<objectClass, KEvent>()) {
-                    objectType = KType::KEvent;
-                } else {
-                    throw exception("KProcess::GetHandle couldn't determine object type");
-                }
-                try {
-                    auto &item{handles.at(handle - constant::BaseHandleIndex)};
-                    if (item != nullptr && item->objectType == objectType)
-                        return std::static_pointer_cast<objectClass>(item);
-                    else if (item == nullptr)
-                        throw exception("GetHandle was called with a deleted handle: 0x{:X}", handle);
-                    else
-                        throw exception("Tried to get kernel object (0x{:X}) with different type: {} when object is {}", handle, objectType, item->objectType);
-                } catch (const std::out_of_range &) {
-                    throw std::out_of_range(fmt::format("GetHandle was called with an invalid handle: 0x{:X}", handle));
                 }
+
+                auto objectType{GetObjectType<objectClass>()};
+                auto item{handles.Get(handle)};
+                if (item->objectType == objectType)
+                    return std::static_pointer_cast<objectClass>(item);
+                else
+                    throw exception("Tried to get kernel object (0x{:X}) with different type: {} when object is {}", handle, objectType, item->objectType);
             }
 
             template<>
             std::shared_ptr<KObject> GetHandle<KObject>(KHandle handle) {
-                std::shared_lock lock(handleMutex);
-                auto &item{handles.at(handle - constant::BaseHandleIndex)};
-                if (item != nullptr)
-                    return item;
-                else
-                    throw std::out_of_range(fmt::format("GetHandle was called with a deleted handle: 0x{:X}", handle));
+                return handles.Get(handle);
+            }
+
+            /**
+             * @brief Calls the supplied function with a reference to the object referred to by the handle, this avoids acquiring a reference to the object
+             * @note This should be preferred over GetHandle for short-lived accesses which don't need to keep the object alive, the function shouldn't block or access the handle table
+             * @throw std::out_of_range If the handle is invalid or has been closed
+             */
+            template<typename objectClass, typename Function>
+            auto BorrowHandle(KHandle handle, Function &&function) {
+                if constexpr(std::is_same<objectClass, KThread>()) {
+                    if (handle == ThreadSelf)
+                        return function(*state.thread);
+                } else if constexpr(std::is_same<objectClass, KProcess>()) {
+                    if (handle == ProcessSelf)
+                        return function(*state.process);
+                }
+
+                auto objectType{GetObjectType<objectClass>()};
+                return handles.Borrow(handle, [&](KObject &item) {
+                    if (item.objectType != objectType)
+                        throw exception("Tried to get kernel object (0x{:X}) with different type: {} when object is {}", handle, objectType, item.objectType);
+                    return function(static_cast<objectClass &>(item));
+                });
             }
 
             /**
@@ -199,7 +249,7 @@ namespace skyline {
              * @brief Closes a handle in the handle table
              */
             void CloseHandle(KHandle handle) {
-                handles.at(handle - constant::BaseHandleIndex) = nullptr;
+                handles.Close(handle);
             }
 
             /**
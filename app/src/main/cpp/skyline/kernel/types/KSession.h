@@ -17,6 +17,7 @@ namespace skyline::kernel::type {
       public:
         std::shared_ptr<service::BaseService> serviceObject;
         std::vector<std::shared_ptr<service::BaseService>> domains; //!< A vector of services that correspond to virtual handles
+        std::shared_mutex domainMutex; //!< Synchronizes access to the domain objects and handle index, lookups during requests lock it in shared mode
         KHandle handleIndex{}; //!< The currently allocated handle index
         bool isOpen{true}; //!< If the session is open or not
         bool isDomain{}; //!< If this is a domain session or not
@@ -32,6 +33,7 @@ namespace skyline::kernel::type {
          * @return The virtual handle of this service in the domain
          */
         KHandle ConvertDomain() {
+            std::unique_lock lock(domainMutex);
             isDomain = true;
             domains.push_back(serviceObject);
             return handleIndex++;
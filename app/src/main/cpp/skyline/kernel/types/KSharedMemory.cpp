@@ -4,6 +4,7 @@
 #include <android/sharedmem.h>
 #include <unistd.h>
 #include <asm/unistd.h>
+#include <common/memory_accounting.h>
 #include "KSharedMemory.h"
 #include "KProcess.h"
 
@@ -20,6 +21,7 @@ namespace skyline::kernel::type {
             throw exception("An occurred while mapping shared memory: {}", strerror(errno));
 
         host.size = size;
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::SharedMemory, size);
     }
 
     u8 *KSharedMemory::Map(u8 *ptr, u64 size, memory::Permission permission) {
@@ -56,7 +58,7 @@ namespace skyline::kernel::type {
         if (guest.ptr != ptr && guest.size != size)
             throw exception("Unmapping KSharedMemory partially is not supported: Requested Unmap: 0x{:X} - 0x{:X} (0x{:X}), Current Mapping: 0x{:X} - 0x{:X} (0x{:X})", ptr, ptr + size, size, guest.ptr, guest.ptr + guest.size, guest.size);
 
-        if (mmap(ptr, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, 0, 0) == MAP_FAILED)
+        if (mmap(ptr, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, 0, 0) == MAP_FAILED)
             throw exception("An error occurred while unmapping shared memory in guest: {}", strerror(errno));
 
         guest = {};
@@ -91,7 +93,7 @@ namespace skyline::kernel::type {
     KSharedMemory::~KSharedMemory() {
         if (state.process && guest.Valid()) {
             if (objectType != KType::KTransferMemory) {
-                mmap(guest.ptr, guest.size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0); // It doesn't particularly matter if this fails as it shouldn't really affect anything
+                mmap(guest.ptr, guest.size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, -1, 0); // It doesn't particularly matter if this fails as it shouldn't really affect anything
                 state.process->memory.InsertChunk(ChunkDescriptor{
                     .ptr = guest.ptr,
                     .size = guest.size,
@@ -120,8 +122,10 @@ namespace skyline::kernel::type {
             }
         }
 
-        if (host.Valid())
+        if (host.Valid()) {
             munmap(host.ptr, host.size);
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::SharedMemory, host.size);
+        }
 
         close(fd);
     }
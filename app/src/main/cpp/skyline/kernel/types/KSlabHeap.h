@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::kernel::type {
+    /**
+     * @brief A thread-safe free list of fixed-size blocks which are carved out of large chunks, modelled on HOS's KSlabHeap
+     * @note Chunks are never returned to the global allocator, a slab only grows to the peak amount of live objects of its size
+     */
+    template<size_t Size, size_t Alignment>
+    class KSlabHeap {
+      private:
+        static constexpr size_t BlockAlignment{std::max(Alignment, alignof(void *))};
+        static constexpr size_t BlockSize{util::AlignUp(std::max(Size, sizeof(void *)), BlockAlignment)};
+        static constexpr size_t ChunkBlockCount{64}; //!< The amount of blocks allocated at once when the slab runs out of free blocks
+
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        std::mutex mutex; //!< Synchronizes the free list
+        FreeBlock *freeList{}; //!< A singly-linked list of all free blocks
+
+        KSlabHeap() = default;
+
+      public:
+        /**
+         * @return The slab heap shared by all objects of this size and alignment
+         * @note The slab heap is intentionally leaked as objects allocated from it may outlive static destruction
+         */
+        static KSlabHeap &Get() {
+            static auto *heap{new KSlabHeap()};
+            return *heap;
+        }
+
+        void *Allocate() {
+            std::scoped_lock lock(mutex);
+            if (!freeList) [[unlikely]] {
+                auto chunk{static_cast<u8 *>(::operator new(BlockSize * ChunkBlockCount, std::align_val_t{BlockAlignment}))};
+                for (size_t index{}; index < ChunkBlockCount; index++) {
+                    auto block{reinterpret_cast<FreeBlock *>(chunk + (index * BlockSize))};
+                    block->next = freeList;
+                    freeList = block;
+                }
+            }
+
+            auto block{freeList};
+            freeList = block->next;
+            return block;
+        }
+
+        void Free(void *pointer) {
+            std::scoped_lock lock(mutex);
+            auto block{static_cast<FreeBlock *>(pointer)};
+            block->next = freeList;
+            freeList = block;
+        }
+    };
+
+    /**
+     * @brief An allocator conforming to the C++ Allocator named requirement which allocates single objects out of a KSlabHeap
+     * @note This is intended to be used with std::allocate_shared so the control block and the object are allocated from the slab together, freeing the last reference returns them to the slab
+     */
+    template<typename Type>
+    struct KSlabAllocator {
+        using value_type = Type;
+
+        KSlabAllocator() = default;
+
+        template<typename OtherType>
+        constexpr KSlabAllocator(const KSlabAllocator<OtherType> &) noexcept {}
+
+        Type *allocate(size_t count) {
+            if (count != 1) [[unlikely]]
+                return static_cast<Type *>(::operator new(count * sizeof(Type), std::align_val_t{alignof(Type)}));
+            return static_cast<Type *>(KSlabHeap<sizeof(Type), alignof(Type)>::Get().Allocate());
+        }
+
+        void deallocate(Type *pointer, size_t count) noexcept {
+            if (count != 1) [[unlikely]]
+                ::operator delete(pointer, std::align_val_t{alignof(Type)});
+            else
+                KSlabHeap<sizeof(Type), alignof(Type)>::Get().Free(pointer);
+        }
+
+        template<typename OtherType>
+        constexpr bool operator==(const KSlabAllocator<OtherType> &) const noexcept {
+            return true;
+        }
+    };
+}
@@ -8,12 +8,10 @@ namespace skyline::kernel::type {
     void KSyncObject::Signal() {
         std::lock_guard lock(syncObjectMutex);
         signalled = true;
-        for (auto &waiter : syncObjectWaiters) {
-            if (waiter->isCancellable) {
-                waiter->isCancellable = false;
-                waiter->wakeObject = this;
-                state.scheduler->InsertThread(waiter);
-            }
+        for (auto node{waitersHead}; node; node = node->next) {
+            u32 expected{KThread::SyncWaiting};
+            if (node->thread->syncWakeToken.compare_exchange_strong(expected, node->index))
+                state.scheduler->InsertThread(node->thread->shared_from_this());
         }
     }
 
@@ -25,4 +23,28 @@ namespace skyline::kernel::type {
         }
         return false;
     }
+
+    void KSyncObject::AddWaiter(SyncWaitNode &node) {
+        node.previous = waitersTail;
+        node.next = nullptr;
+        if (waitersTail)
+            waitersTail->next = &node;
+        else
+            waitersHead = &node;
+        waitersTail = &node;
+    }
+
+    void KSyncObject::RemoveWaiter(SyncWaitNode &node) {
+        if (node.previous)
+            node.previous->next = node.next;
+        else
+            waitersHead = node.next;
+
+        if (node.next)
+            node.next->previous = node.previous;
+        else
+            waitersTail = node.previous;
+
+        node.previous = node.next = nullptr;
+    }
 }
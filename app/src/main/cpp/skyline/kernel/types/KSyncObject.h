@@ -6,14 +6,26 @@
 #include "KObject.h"
 
 namespace skyline::kernel::type {
+    /**
+     * @brief A single thread waiting on a single synchronization object, these are allocated on the stack of the waiting thread for every object it's waiting on
+     * @note Nodes are linked intrusively into the waiters of the object so registering and unregistering a waiter never allocates or scans the waiters
+     */
+    struct SyncWaitNode {
+        KThread *thread;
+        u32 index; //!< The index of the object in the handles that the thread is waiting on, this is the value of the wake token of the thread when the object wakes it
+        SyncWaitNode *previous{};
+        SyncWaitNode *next{};
+    };
+
     /**
      * @brief KSyncObject is an abstract class which holds everything necessary for an object to be synchronizable
      * @note This abstraction is roughly equivalent to KSynchronizationObject on HOS
      */
     class KSyncObject : public KObject {
       public:
-        inline static std::mutex syncObjectMutex; //!< A global lock used for locking all signalling to avoid races
-        std::list<std::shared_ptr<KThread>> syncObjectWaiters; //!< A list of threads waiting on this object to be signalled
+        std::mutex syncObjectMutex; //!< Synchronizes the signalled state and waiters of this object, waits on multiple objects lock the mutexes of all of them in the order of their addresses
+        SyncWaitNode *waitersHead{}; //!< An intrusive list of threads waiting on this object to be signalled, all of them are woken when it's signalled so they aren't sorted by priority
+        SyncWaitNode *waitersTail{};
         bool signalled; //!< If the current object is signalled (An object stays signalled till the signal has been explicitly reset)
 
         /**
@@ -23,6 +35,7 @@ namespace skyline::kernel::type {
 
         /**
          * @brief Wakes up any waiters on this object and flips the 'signalled' flag
+         * @note Waiters are woken by exchanging their wake token for the index of this object, only the first object to do so wakes a thread waiting on multiple objects
          */
         void Signal();
 
@@ -32,6 +45,18 @@ namespace skyline::kernel::type {
          */
         bool ResetSignal();
 
+        /**
+         * @brief Links a waiter into the waiters of this object
+         * @note The object mutex **must** be locked by the calling thread
+         */
+        void AddWaiter(SyncWaitNode &node);
+
+        /**
+         * @brief Unlinks a waiter from the waiters of this object
+         * @note The object mutex **must** be locked by the calling thread
+         */
+        void RemoveWaiter(SyncWaitNode &node);
+
         virtual ~KSyncObject() = default;
     };
 }
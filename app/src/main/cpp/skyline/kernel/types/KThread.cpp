@@ -3,6 +3,8 @@
 
 #include <cxxabi.h>
 #include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <common/signal.h>
 #include <common/trace.h>
 #include <nce.h>
@@ -28,10 +30,11 @@ namespace skyline::kernel::type {
 
     KThread::~KThread() {
         Kill(true);
-        if (thread.joinable())
-            thread.join();
-        if (preemptionTimer)
-            timer_delete(preemptionTimer);
+    }
+
+    void KThread::InitializeHostThread() {
+        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
+        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
     }
 
     void KThread::StartThread() {
@@ -47,6 +50,9 @@ namespace skyline::kernel::type {
         state.ctx = &ctx;
         state.thread = shared_from_this();
 
+        if (state.nce->profiler)
+            state.nce->profiler->RegisterThread();
+
         if (setjmp(originalCtx)) { // Returns 1 if it's returning from guest, 0 otherwise
             state.scheduler->RemoveThread();
 
@@ -67,17 +73,6 @@ namespace skyline::kernel::type {
             return;
         }
 
-        struct sigevent event{
-            .sigev_signo = Scheduler::PreemptionSignal,
-            .sigev_notify = SIGEV_THREAD_ID,
-            .sigev_notify_thread_id = gettid(),
-        };
-        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preemptionTimer))
-            throw exception("timer_create has failed with '{}'", strerror(errno));
-
-        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
-        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
-
         {
             std::lock_guard lock(statusMutex);
             ready = true;
@@ -211,11 +206,11 @@ namespace skyline::kernel::type {
             statusCondition.notify_all();
             if (self) {
                 pthread = pthread_self();
+                InitializeHostThread();
                 lock.unlock();
                 StartThread();
             } else {
-                thread = std::thread(&KThread::StartThread, this);
-                pthread = thread.native_handle();
+                parent->hostThreads.Run(shared_from_this());
             }
         }
     }
@@ -241,30 +236,9 @@ namespace skyline::kernel::type {
             pthread_kill(pthread, signal);
     }
 
-    void KThread::ArmPreemptionTimer(std::chrono::nanoseconds timeToFire) {
-        std::unique_lock lock(statusMutex);
-        statusCondition.wait(lock, [this]() { return ready || killed; });
-        if (!killed && running) {
-            struct itimerspec spec{.it_value = {
-                .tv_nsec = std::min(static_cast<i64>(timeToFire.count()), constant::NsInSecond),
-                .tv_sec = std::max(std::chrono::duration_cast<std::chrono::seconds>(timeToFire).count() - 1, 0LL),
-            }};
-            timer_settime(preemptionTimer, 0, &spec, nullptr);
-            isPreempted = true;
-        }
-    }
-
-    void KThread::DisarmPreemptionTimer() {
-        if (!isPreempted) [[unlikely]]
-            return;
-
-        std::unique_lock lock(statusMutex);
-        statusCondition.wait(lock, [this]() { return ready || killed; });
-        if (!killed && running) {
-            struct itimerspec spec{};
-            timer_settime(preemptionTimer, 0, &spec, nullptr);
-            isPreempted = false;
-        }
+    void KThread::WakeSchedule() {
+        wakeWord.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, &wakeWord, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
     }
 
     void KThread::UpdatePriorityInheritance() {
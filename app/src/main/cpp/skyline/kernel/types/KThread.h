@@ -6,6 +6,7 @@
 #include <csetjmp>
 #include <nce/guest.h>
 #include <kernel/scheduler.h>
+#include <kernel/host_thread_pool.h>
 #include <common/signal.h>
 #include "KSyncObject.h"
 #include "KPrivateMemory.h"
@@ -19,13 +20,19 @@ namespace skyline {
         class KThread : public KSyncObject, public std::enable_shared_from_this<KThread> {
           private:
             KProcess *parent;
-            std::thread thread; //!< If this KThread is backed by a host thread then this'll hold it
             pthread_t pthread{}; //!< The pthread_t for the host thread running this guest thread
-            timer_t preemptionTimer{}; //!< A kernel timer used for preemption interrupts
+
+            friend HostThreadPool;
+
+            /**
+             * @brief Installs the signal handlers required to run guest code on the calling host thread
+             * @note This only needs to be done once for every host thread, regardless of how many guest threads it runs
+             */
+            static void InitializeHostThread();
 
             /**
              * @brief Entry function any guest threads, sets up necessary context and jumps into guest code from the calling thread
-             * @note This function also serves as the entry point for host threads created in StartThread
+             * @note The host thread must have been initialized with InitializeHostThread prior to calling this
              */
             void StartThread();
 
@@ -46,7 +53,7 @@ namespace skyline {
             u64 entryArgument; //!< An argument to provide with to the thread entry function
             void *stackTop; //!< The top of the guest's stack, this is set to the initial guest stack pointer
 
-            std::condition_variable scheduleCondition; //!< Signalled to wake the thread when it's scheduled or its resident core changes
+            std::atomic<u32> wakeWord{}; //!< A futex word which is incremented to wake the thread when it's scheduled or its resident core changes, it's only waited on by this thread
             std::atomic<i8> basePriority; //!< The priority of the thread for the scheduler without any priority-inheritance
             std::atomic<i8> priority; //!< The priority of the thread for the scheduler including priority-inheritance
 
@@ -54,11 +61,13 @@ namespace skyline {
             u8 idealCore; //!< The ideal CPU core for this thread to run on
             u8 coreId; //!< The CPU core on which this thread is running
             CoreMask affinityMask{}; //!< A mask of CPU cores this thread is allowed to run on
+            RunQueueLinks queueLinks; //!< The links of this thread in the run queue of its resident core, these are synchronized by the mutex of that core
+            u8 hostAffinityCore{constant::ParkedCoreId}; //!< The guest core which the host CPU affinity of the thread was last set for, this is only accessed by the thread itself
 
             u64 timesliceStart{}; //!< A timestamp in host CNTVCT ticks of when the thread's current timeslice started
             u64 averageTimeslice{}; //!< A weighted average of the timeslice duration for this thread
+            u64 scheduleFlowId{}; //!< The ID of the Perfetto flow from the thread being inserted into a run queue to it being scheduled, this is zero when there's no pending flow
 
-            bool isPreempted{}; //!< If the preemption timer has been armed and will fire
             bool pendingYield{}; //!< If the thread has been yielded and hasn't been acted upon it yet
             bool forceYield{}; //!< If the thread has been forcefully yielded by another thread
 
@@ -68,16 +77,19 @@ namespace skyline {
             std::shared_ptr<KThread> waitThread; //!< The thread which this thread is waiting on
             std::list<std::shared_ptr<type::KThread>> waiters; //!< A queue of threads waiting on this thread sorted by priority
 
-            bool isCancellable{false}; //!< If the thread is currently in a position where it's cancellable
+            static constexpr u32 SyncNotWaiting{std::numeric_limits<u32>::max()}; //!< The wake token of a thread that isn't waiting on any synchronization objects
+            static constexpr u32 SyncWaiting{SyncNotWaiting - 1}; //!< The wake token of a thread that's waiting and can be woken
+            static constexpr u32 SyncCancelled{SyncNotWaiting - 2}; //!< The wake token of a thread whose wait has been cancelled
+            std::mutex syncWaitMutex; //!< Synchronizes cancellation with a wait being set up, this is locked after the mutexes of any objects it's waiting on
+            std::atomic<u32> syncWakeToken{SyncNotWaiting}; //!< The index of the object that woke the thread from SvcWaitSynchronization or one of the values above, the first waker to exchange it from SyncWaiting wakes the thread
             bool cancelSync{false}; //!< Whether to cancel the SvcWaitSynchronization call this thread currently is in/the next one it joins
-            type::KSyncObject *wakeObject{}; //!< A pointer to the synchronization object responsible for waking this thread up
 
             KThread(const DeviceState &state, KHandle handle, KProcess *parent, size_t id, void *entry, u64 argument, void *stackTop, i8 priority, u8 idealCore);
 
             ~KThread();
 
             /**
-             * @param self If the calling thread should jump directly into guest code or if a new thread should be created for it
+             * @param self If the calling thread should jump directly into guest code or if it should be run on a host thread from the pool of the process
              * @note If the thread is already running then this does nothing
              * @note 'stack' will be created if it wasn't set prior to calling this
              */
@@ -94,14 +106,10 @@ namespace skyline {
             void SendSignal(int signal);
 
             /**
-             * @brief Arms the preemption kernel timer to fire in the specified amount of time
-             */
-            void ArmPreemptionTimer(std::chrono::nanoseconds timeToFire);
-
-            /**
-             * @brief Disarms the preemption kernel timer, any scheduled firings will be cancelled
+             * @brief Wakes this thread if it's waiting in the scheduler so it rechecks if it has been scheduled
+             * @note This is a futex wake of exactly this thread, the waker doesn't need to hold any lock the thread waits with as long as the state it changed is visible prior to this
              */
-            void DisarmPreemptionTimer();
+            void WakeSchedule();
 
             /**
              * @brief Recursively updates the priority for any threads this thread might be waiting on
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <common.h>
+#include <nce.h>
 
 namespace skyline::loader {
     /**
@@ -30,5 +30,9 @@ namespace skyline::loader {
 
         RelativeSegment dynsym; //!< The .dynsym segment relative to .rodata
         RelativeSegment dynstr; //!< The .dynstr segment relative to .rodata
+
+        std::array<u64, 4> buildId{}; //!< The build ID of the executable, this is zero if the executable doesn't have one
+
+        std::optional<nce::NCE::PatchData> patch; //!< The patch data of the .text segment if it was determined prior to loading, this allows it to be computed concurrently with other work
     };
 }
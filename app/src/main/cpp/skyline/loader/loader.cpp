@@ -3,6 +3,7 @@
 
 #include <dlfcn.h>
 #include <cxxabi.h>
+#include <common/settings.h>
 #include <nce.h>
 #include <os.h>
 #include <kernel/types/KProcess.h>
@@ -23,7 +24,7 @@ namespace skyline::loader {
         if (!util::IsPageAligned(executable.text.offset) || !util::IsPageAligned(executable.ro.offset) || !util::IsPageAligned(executable.data.offset))
             throw exception("LoadProcessData: Section offsets are not aligned with page size: 0x{:X}, 0x{:X}, 0x{:X}", executable.text.offset, executable.ro.offset, executable.data.offset);
 
-        auto patch{state.nce->GetPatchData(executable.text.contents)};
+        auto patch{executable.patch ? std::move(*executable.patch) : state.nce->GetPatchData(executable.text.contents, executable.buildId)};
         auto size{patch.size + textSize + roSize + dataSize};
 
         process->NewHandle<kernel::type::KPrivateMemory>(base, patch.size, memory::Permission{false, false, false}, memory::states::Reserved); // ---
@@ -38,7 +39,11 @@ namespace skyline::loader {
         process->NewHandle<kernel::type::KPrivateMemory>(base + patch.size + executable.data.offset, dataSize, memory::Permission{true, true, false}, memory::states::CodeMutable); // RW-
         Logger::Debug("Successfully mapped section .data + .bss @ 0x{:X}, Size = 0x{:X}", base + patch.size + executable.data.offset, dataSize);
 
-        state.nce->PatchCode(executable.text.contents, reinterpret_cast<u32 *>(base), patch.size, patch.offsets);
+        std::vector<nce::NCE::FunctionReplacement> replacements;
+        if (state.settings->hostLibcFunctions)
+            replacements = nce::NCE::FindFunctionReplacements(span(reinterpret_cast<const Elf64_Sym *>(executable.ro.contents.data() + executable.dynsym.offset), executable.dynsym.size / sizeof(Elf64_Sym)), span(reinterpret_cast<const char *>(executable.ro.contents.data() + executable.dynstr.offset), executable.dynstr.size), executable.text.offset, textSize);
+
+        state.nce->PatchCode(executable.text.contents, reinterpret_cast<u32 *>(base), patch.size, patch.offsets, replacements);
         std::memcpy(base + patch.size + executable.text.offset, executable.text.contents.data(), textSize);
         std::memcpy(base + patch.size + executable.ro.offset, executable.ro.contents.data(), roSize);
         std::memcpy(base + patch.size + executable.data.offset, executable.data.contents.data(), dataSize - executable.bssSize);
@@ -105,6 +110,28 @@ namespace skyline::loader {
         }
     }
 
+    std::string Loader::GetSymbolName(void *pointer) {
+        auto demangle{[](const char *name) {
+            int status{};
+            size_t length{};
+            std::unique_ptr<char, decltype(&std::free)> demangled{abi::__cxa_demangle(name, nullptr, &length, &status), std::free};
+            return std::string{(status == 0) ? demangled.get() : name};
+        }};
+
+        Dl_info info;
+        auto symbol{ResolveSymbol(pointer)};
+        if (symbol.name)
+            return demangle(symbol.name);
+        else if (!symbol.executableName.empty())
+            return fmt::format("0x{:X} (from {})", reinterpret_cast<uintptr_t>(pointer), symbol.executableName);
+        else if (dladdr(pointer, &info) && info.dli_sname)
+            return demangle(info.dli_sname);
+        else if (info.dli_fname)
+            return fmt::format("0x{:X} (from {})", reinterpret_cast<uintptr_t>(pointer), info.dli_fname);
+        else
+            return fmt::format("0x{:X}", reinterpret_cast<uintptr_t>(pointer));
+    }
+
     std::string Loader::GetStackTrace(signal::StackFrame *frame) {
         std::string trace;
         if (!frame)
@@ -110,6 +110,11 @@ namespace skyline::loader {
          */
         SymbolInfo ResolveSymbol(void *ptr);
 
+        /**
+         * @return The demangled name of the function containing the supplied address in either a guest executable or the host, this falls back to the address and the executable containing it
+         */
+        std::string GetSymbolName(void *pointer);
+
         /**
          * @param frame The initial stack frame or the calling function's stack frame by default
          * @return A string with the stack trace based on the supplied context
@@ -1,13 +1,14 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <future>
 #include <kernel/types/KProcess.h>
 #include <vfs/npdm.h>
 #include "nso.h"
 #include "nca.h"
 
 namespace skyline::loader {
-    NcaLoader::NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore) : nca(std::move(backing), std::move(keyStore)) {
+    NcaLoader::NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool verifyIntegrity) : nca(std::move(backing), std::move(keyStore), false, verifyIntegrity) {
         if (nca.exeFs == nullptr)
             throw exception("Only NCAs with an ExeFS can be loaded directly");
     }
@@ -19,25 +20,31 @@ namespace skyline::loader {
         if (!exeFs->FileExists("rtld"))
             throw exception("Cannot load an ExeFS that doesn't contain rtld");
 
-        auto nsoFile{exeFs->OpenFile("rtld")};
-
-        state.process->memory.InitializeVmm(process->npdm.meta.flags.type);
-
-        auto loadInfo{NsoLoader::LoadNso(loader, nsoFile, process, state, 0, "rtld.nso")};
-        u64 offset{loadInfo.size};
-        u8 *base{loadInfo.base};
-        void *entry{loadInfo.entry};
+        // All NSOs are read and decompressed in parallel, they're loaded into memory in order afterwards as their placement depends on the size of the prior ones
+        std::vector<std::pair<std::string, std::future<Executable>>> nsos;
+        for (const auto &nso : {"rtld", "main", "subsdk0", "subsdk1", "subsdk2", "subsdk3", "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"}) {
+            if (!exeFs->FileExists(nso))
+                continue;
 
-        Logger::Info("Loaded 'rtld.nso' at 0x{:X} (.text @ 0x{:X})", base, entry);
+            nsos.emplace_back(nso + std::string(".nso"), std::async(std::launch::async, [nsoFile{exeFs->OpenFile(nso)}, &state]() {
+                return NsoLoader::ReadNso(nsoFile, state);
+            }));
+        }
 
-        for (const auto &nso : {"main", "subsdk0", "subsdk1", "subsdk2", "subsdk3", "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"}) {
-            if (exeFs->FileExists(nso))
-                nsoFile = exeFs->OpenFile(nso);
-            else
-                continue;
+        state.process->memory.InitializeVmm(process->npdm.meta.flags.type);
 
-            loadInfo = NsoLoader::LoadNso(loader, nsoFile, process, state, offset, nso + std::string(".nso"));
-            Logger::Info("Loaded '{}.nso' at 0x{:X} (.text @ 0x{:X})", nso, base + offset, loadInfo.entry);
+        u64 offset{};
+        u8 *base{};
+        void *entry{};
+        for (auto &[name, future] : nsos) {
+            auto executable{future.get()};
+            auto loadInfo{loader->LoadExecutable(process, state, executable, offset, name)};
+            if (!base) {
+                base = loadInfo.base;
+                entry = loadInfo.entry;
+            }
+
+            Logger::Info("Loaded '{}' at 0x{:X} (.text @ 0x{:X})", name, loadInfo.base, loadInfo.entry);
             offset += loadInfo.size;
         }
 
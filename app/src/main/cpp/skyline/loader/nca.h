@@ -16,7 +16,10 @@ namespace skyline::loader {
         vfs::NCA nca; //!< The backing NCA of the loader
 
       public:
-        NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore);
+        /**
+         * @param verifyIntegrity If the hashes of the NCA's sections should be verified as they're read
+         */
+        NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool verifyIntegrity = false);
 
         /**
          * @brief Loads an ExeFS into memory and processes it accordingly for execution
@@ -1,8 +1,10 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <future>
 #include <lz4.h>
 #include <nce.h>
+#include <common/trace.h>
 #include <kernel/types/KProcess.h>
 #include "nso.h"
 
@@ -15,13 +17,20 @@ namespace skyline::loader {
     }
 
     std::vector<u8> NsoLoader::GetSegment(const std::shared_ptr<vfs::Backing> &backing, const NsoSegmentHeader &segment, u32 compressedSize) {
+        TRACE_BOOT_PHASE(NsoDecompression, "NsoLoader::GetSegment");
         std::vector<u8> outputBuffer(segment.decompressedSize);
 
         if (compressedSize) {
-            std::vector<u8> compressedBuffer(compressedSize);
-            backing->Read(compressedBuffer, segment.fileOffset);
-
-            LZ4_decompress_safe(reinterpret_cast<char *>(compressedBuffer.data()), reinterpret_cast<char *>(outputBuffer.data()), static_cast<int>(compressedSize), static_cast<int>(segment.decompressedSize));
+            // The compressed data is decompressed directly out of the backing when it's resident in memory, this avoids copying it into an intermediate buffer
+            std::vector<u8> compressedBuffer;
+            auto compressed{backing->Map(segment.fileOffset, compressedSize)};
+            if (!compressed) {
+                compressedBuffer.resize(compressedSize);
+                backing->Read(compressedBuffer, segment.fileOffset);
+                compressed = span<u8>(compressedBuffer);
+            }
+
+            LZ4_decompress_safe(reinterpret_cast<const char *>(compressed->data()), reinterpret_cast<char *>(outputBuffer.data()), static_cast<int>(compressedSize), static_cast<int>(segment.decompressedSize));
         } else {
             backing->Read(outputBuffer, segment.fileOffset);
         }
@@ -29,23 +38,29 @@ namespace skyline::loader {
         return outputBuffer;
     }
 
-    Loader::ExecutableLoadInfo NsoLoader::LoadNso(Loader *loader, const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset, const std::string &name) {
+    Executable NsoLoader::ReadNso(const std::shared_ptr<vfs::Backing> &backing, const DeviceState &state) {
         auto header{backing->Read<NsoHeader>()};
 
         if (header.magic != util::MakeMagic<u32>("NSO0"))
             throw exception("Invalid NSO magic! 0x{0:X}", header.magic);
 
         Executable executable{};
+        executable.buildId = header.buildId;
+
+        // .rodata and .data are decompressed on other threads while .text is decompressed and scanned for patches on this one
+        auto roFuture{std::async(std::launch::async, [&]() { return GetSegment(backing, header.ro, header.flags.roCompressed ? header.roCompressedSize : 0); })};
+        auto dataFuture{std::async(std::launch::async, [&]() { return GetSegment(backing, header.data, header.flags.dataCompressed ? header.dataCompressedSize : 0); })};
 
         executable.text.contents = GetSegment(backing, header.text, header.flags.textCompressed ? header.textCompressedSize : 0);
         executable.text.contents.resize(util::AlignUp(executable.text.contents.size(), PAGE_SIZE));
         executable.text.offset = header.text.memoryOffset;
+        executable.patch = state.nce->GetPatchData(executable.text.contents, executable.buildId);
 
-        executable.ro.contents = GetSegment(backing, header.ro, header.flags.roCompressed ? header.roCompressedSize : 0);
+        executable.ro.contents = roFuture.get();
         executable.ro.contents.resize(util::AlignUp(executable.ro.contents.size(), PAGE_SIZE));
         executable.ro.offset = header.ro.memoryOffset;
 
-        executable.data.contents = GetSegment(backing, header.data, header.flags.dataCompressed ? header.dataCompressedSize : 0);
+        executable.data.contents = dataFuture.get();
         executable.data.offset = header.data.memoryOffset;
 
         // Data and BSS are aligned together
@@ -56,6 +71,11 @@ namespace skyline::loader {
             executable.dynstr = {header.dynstr.offset, header.dynstr.size};
         }
 
+        return executable;
+    }
+
+    Loader::ExecutableLoadInfo NsoLoader::LoadNso(Loader *loader, const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset, const std::string &name) {
+        auto executable{ReadNso(backing, state)};
         return loader->LoadExecutable(process, state, executable, offset, name);
     }
 
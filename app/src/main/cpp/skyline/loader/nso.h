@@ -80,6 +80,13 @@ namespace skyline::loader {
       public:
         NsoLoader(std::shared_ptr<vfs::Backing> backing);
 
+        /**
+         * @brief Reads and decompresses all segments of an NSO and determines its patch data without loading it into memory
+         * @note The segments are decompressed concurrently and the patch data is determined while .rodata and .data are still being decompressed
+         * @note This doesn't depend on any process state so the NSOs of an ExeFS can be read in parallel prior to loading them
+         */
+        static Executable ReadNso(const std::shared_ptr<vfs::Backing> &backing, const DeviceState &state);
+
         /**
          * @brief Loads an NSO into memory, offset by the given amount
          * @param backing The backing that the NSO is contained within
@@ -3,6 +3,7 @@
 
 #include <kernel/types/KProcess.h>
 #include <vfs/ticket.h>
+#include <vfs/ncz_backing.h>
 #include "nca.h"
 #include "nsp.h"
 
@@ -22,16 +23,21 @@ namespace skyline::loader {
         }
     }
 
-    NspLoader::NspLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore) : nsp(std::make_shared<vfs::PartitionFileSystem>(backing)) {
+    NspLoader::NspLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore, bool verifyIntegrity) : nsp(std::make_shared<vfs::PartitionFileSystem>(backing)) {
         ExtractTickets(nsp, keyStore);
 
         auto root{nsp->OpenDirectory("", {false, true})};
         for (const auto &entry : root->Read()) {
-            if (entry.name.substr(entry.name.find_last_of('.') + 1) != "nca")
+            auto extension{entry.name.substr(entry.name.find_last_of('.') + 1)};
+            if (extension != "nca" && extension != "ncz")
                 continue;
 
             try {
-                auto nca{vfs::NCA(nsp->OpenFile(entry.name), keyStore)};
+                auto file{nsp->OpenFile(entry.name)};
+                if (extension == "ncz")
+                    file = std::make_shared<vfs::NczBacking>(std::move(file));
+
+                auto nca{vfs::NCA(std::move(file), keyStore, false, verifyIntegrity)};
 
                 if (nca.contentType == vfs::NcaContentType::Program && nca.romFs != nullptr && nca.exeFs != nullptr)
                     programNca = std::move(nca);
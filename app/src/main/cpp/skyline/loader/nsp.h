@@ -22,7 +22,10 @@ namespace skyline::loader {
         std::optional<vfs::NCA> controlNca; //!< The main control NCA within the NSP
 
       public:
-        NspLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore);
+        /**
+         * @param verifyIntegrity If the hashes of the sections of all NCAs should be verified as they're read
+         */
+        NspLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore, bool verifyIntegrity = false);
 
         std::vector<u8> GetIcon(language::ApplicationLanguage language) override;
 
@@ -4,11 +4,12 @@
 #include <common.h>
 #include <kernel/types/KProcess.h>
 #include <vfs/region_backing.h>
+#include <vfs/ncz_backing.h>
 #include "nca.h"
 #include "xci.h"
 
 namespace skyline::loader {
-    XciLoader::XciLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore) {
+    XciLoader::XciLoader(const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<crypto::KeyStore> &keyStore, bool verifyIntegrity) {
         header = backing->Read<GamecardHeader>();
 
         if (header.magic != util::MakeMagic<u32>("HEAD"))
@@ -32,11 +33,16 @@ namespace skyline::loader {
         if (secure) {
             root = secure->OpenDirectory("", {false, true});
             for (const auto &entry : root->Read()) {
-                if (entry.name.substr(entry.name.find_last_of('.') + 1) != "nca")
+                auto extension{entry.name.substr(entry.name.find_last_of('.') + 1)};
+                if (extension != "nca" && extension != "ncz")
                     continue;
 
                 try {
-                    auto nca{vfs::NCA(secure->OpenFile(entry.name), keyStore, true)};
+                    auto file{secure->OpenFile(entry.name)};
+                    if (extension == "ncz")
+                        file = std::make_shared<vfs::NczBacking>(std::move(file));
+
+                    auto nca{vfs::NCA(std::move(file), keyStore, true, verifyIntegrity)};
 
                     if (nca.contentType == vfs::NcaContentType::Program && nca.romFs != nullptr && nca.exeFs != nullptr)
                         programNca = std::move(nca);
@@ -3,8 +3,12 @@
 
 #include <cxxabi.h>
 #include <unistd.h>
+#define XXH_INLINE_ALL
+#include <xxhash.h>
 #include "common/signal.h"
+#include "common/thread_pool.h"
 #include "common/trace.h"
+#include "vfs/cache_directory.h"
 #include "os.h"
 #include "jvm.h"
 #include "kernel/types/KProcess.h"
@@ -20,14 +24,19 @@ namespace skyline::nce {
         return killAllThreads ? "ExitProcess" : "ExitThread";
     }
 
+    template<bool Fast>
     void NCE::SvcHandler(u16 svcId, ThreadContext *ctx) {
-        TRACE_EVENT_END("guest");
+        if constexpr (!Fast)
+            TRACE_EVENT_END("guest");
 
         const auto &state{*ctx->state};
-        auto svc{kernel::svc::SvcTable[svcId]};
+        const auto &svc{kernel::svc::SvcTable[svcId]};
         try {
-            if (svc) [[likely]] {
+            if constexpr (Fast) {
+                (svc.function)(state); // Fast SVCs are only dispatched to by trampolines for SVCs which are known to be implemented
+            } else if (svc) [[likely]] {
                 TRACE_EVENT("kernel", perfetto::StaticString{svc.name});
+                trace::LatencyScope latencyScope{svc.name};
                 (svc.function)(state);
             } else {
                 throw exception("Unimplemented SVC 0x{:X}", svcId);
@@ -68,7 +77,8 @@ namespace skyline::nce {
             std::longjmp(state.thread->originalCtx, true);
         }
 
-        TRACE_EVENT_BEGIN("guest", "Guest");
+        if constexpr (!Fast)
+            TRACE_EVENT_BEGIN("guest", "Guest");
     }
 
     void NCE::SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls) {
@@ -141,70 +151,179 @@ namespace skyline::nce {
         return threadCtx;
     }
 
-    NCE::NCE(const DeviceState &state) : state(state) {
+    NCE::NCE(const DeviceState &state) : state(state), profiler(state.settings->guestProfiler ? std::make_unique<GuestProfiler>(state) : nullptr) {
         signal::SetTlsRestorer(&NceTlsRestorer);
     }
 
-    constexpr u8 MainSvcTrampolineSize{17}; // Size of the main SVC trampoline function in u32 units
+    constexpr u8 MainSvcTrampolineSize{17}; // Size of the main SVC trampoline function in u32 units, the fast SVC trampoline is identical aside from the handler so it has the same size
     constexpr u32 TpidrEl0{0x5E82};         // ID of TPIDR_EL0 in MRS
     constexpr u32 TpidrroEl0{0x5E83};       // ID of TPIDRRO_EL0 in MRS
     constexpr u32 CntfrqEl0{0x5F00};        // ID of CNTFRQ_EL0 in MRS
     constexpr u32 CntpctEl0{0x5F01};        // ID of CNTPCT_EL0 in MRS
     constexpr u32 CntvctEl0{0x5F02};        // ID of CNTVCT_EL0 in MRS
     constexpr u32 TegraX1Freq{19200000};    // The clock frequency of the Tegra X1 (19.2 MHz)
+    constexpr u8 RescaledCounterSize{11};   // Size of the inline counter rescaling sequence in u32 units
+    constexpr u8 CounterScaleShift{32};     // The amount of fractional bits in the fixed-point multiplier used for rescaling the counter
+    constexpr u8 ReplacementTrampolineSize{4}; // Size of a function replacement trampoline in u32 units
+
+    /**
+     * @brief The libc routines which guest calls can be redirected to the host implementation of, these have identical semantics on both and are leaf functions which don't touch TLS
+     */
+    static const std::array<std::pair<std::string_view, void *>, 5> HostFunctions{{
+        {"memcpy", reinterpret_cast<void *>(&memcpy)},
+        {"memmove", reinterpret_cast<void *>(&memmove)},
+        {"memset", reinterpret_cast<void *>(&memset)},
+        {"memcmp", reinterpret_cast<void *>(&memcmp)},
+        {"strlen", reinterpret_cast<void *>(&strlen)},
+    }};
+
+    /**
+     * @return A fixed-point multiplier with CounterScaleShift fractional bits which scales host counter ticks to Tegra X1 ticks
+     */
+    static u64 GetCounterMultiplier(u64 frequency) {
+        return ((static_cast<u64>(TegraX1Freq) << CounterScaleShift) + (frequency / 2)) / frequency;
+    }
 
-    NCE::PatchData NCE::GetPatchData(const std::vector<u8> &text) {
-        size_t size{guest::SaveCtxSize + guest::LoadCtxSize + MainSvcTrampolineSize};
-        std::vector<size_t> offsets;
+    NCE::PatchData NCE::ScanPatchData(const std::vector<u8> &text) {
+        TRACE_EVENT("kernel", "NCE::ScanPatchData");
 
         u64 frequency;
         asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
         bool rescaleClock{frequency != TegraX1Freq};
 
-        auto start{reinterpret_cast<const u32 *>(text.data())}, end{reinterpret_cast<const u32 *>(text.data() + text.size())};
-        for (const u32 *instruction{start}; instruction < end; instruction++) {
-            auto svc{*reinterpret_cast<const instructions::Svc *>(instruction)};
-            auto mrs{*reinterpret_cast<const instructions::Mrs *>(instruction)};
-            auto msr{*reinterpret_cast<const instructions::Msr *>(instruction)};
-            auto instructionOffset{static_cast<size_t>(instruction - start)};
-
-            if (svc.Verify()) {
-                size += 7;
-                offsets.push_back(instructionOffset);
-            } else if (mrs.Verify()) {
-                if (mrs.srcReg == TpidrroEl0 || mrs.srcReg == TpidrEl0) {
-                    size += ((mrs.destReg != registers::X0) ? 6 : 3);
-                    offsets.push_back(instructionOffset);
-                } else {
-                    if (rescaleClock) {
-                        if (mrs.srcReg == CntpctEl0) {
-                            size += guest::RescaleClockSize + 3;
-                            offsets.push_back(instructionOffset);
-                        } else if (mrs.srcReg == CntfrqEl0) {
-                            size += 3;
-                            offsets.push_back(instructionOffset);
+        auto start{reinterpret_cast<const u32 *>(text.data())};
+        auto scanChunk{[&](size_t chunk, PatchData &data) {
+            auto chunkStart{start + ((chunk * ScanChunkSize) / sizeof(u32))}, chunkEnd{start + (std::min((chunk + 1) * ScanChunkSize, text.size()) / sizeof(u32))};
+            for (const u32 *instruction{chunkStart}; instruction < chunkEnd; instruction++) {
+                auto svc{*reinterpret_cast<const instructions::Svc *>(instruction)};
+                auto mrs{*reinterpret_cast<const instructions::Mrs *>(instruction)};
+                auto msr{*reinterpret_cast<const instructions::Msr *>(instruction)};
+                auto instructionOffset{static_cast<size_t>(instruction - start)};
+
+                if (svc.Verify()) {
+                    data.size += 7;
+                    data.offsets.push_back(instructionOffset);
+                } else if (mrs.Verify()) {
+                    if (mrs.srcReg == TpidrroEl0 || mrs.srcReg == TpidrEl0) {
+                        data.size += 3;
+                        data.offsets.push_back(instructionOffset);
+                    } else {
+                        if (rescaleClock) {
+                            if (mrs.srcReg == CntpctEl0 || mrs.srcReg == CntvctEl0) {
+                                data.size += RescaledCounterSize;
+                                data.offsets.push_back(instructionOffset);
+                            } else if (mrs.srcReg == CntfrqEl0) {
+                                data.size += 3;
+                                data.offsets.push_back(instructionOffset);
+                            }
+                        } else if (mrs.srcReg == CntpctEl0) {
+                            data.offsets.push_back(instructionOffset);
                         }
-                    } else if (mrs.srcReg == CntpctEl0) {
-                        offsets.push_back(instructionOffset);
                     }
+                } else if (msr.Verify() && msr.destReg == TpidrEl0) {
+                    data.size += 6;
+                    data.offsets.push_back(instructionOffset);
                 }
-            } else if (msr.Verify() && msr.destReg == TpidrEl0) {
-                size += 6;
-                offsets.push_back(instructionOffset);
             }
+        }};
+
+        // Every chunk is scanned into its own patch data which are merged in order afterwards, so the offsets remain sorted
+        size_t chunkCount{util::AlignUp(text.size(), ScanChunkSize) / ScanChunkSize};
+        std::vector<PatchData> chunks(chunkCount);
+        if (chunkCount > 1) {
+            ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+            pool.ParallelFor(chunkCount, [&](size_t chunk) {
+                scanChunk(chunk, chunks[chunk]);
+            });
+        } else if (chunkCount) {
+            scanChunk(0, chunks.front());
+        }
+
+        PatchData data{guest::SaveCtxSize + guest::LoadCtxSize + (MainSvcTrampolineSize * 2) + (ReplacementTrampolineSize * HostFunctions.size())};
+        size_t offsetCount{};
+        for (const auto &chunk : chunks)
+            offsetCount += chunk.offsets.size();
+        data.offsets.reserve(offsetCount);
+        for (const auto &chunk : chunks) {
+            data.size += chunk.size;
+            data.offsets.insert(data.offsets.end(), chunk.offsets.begin(), chunk.offsets.end());
+        }
+        data.size = util::AlignUp(data.size * sizeof(u32), PAGE_SIZE);
+        return data;
+    }
+
+    void NCE::OpenPatchCache(const std::string &path) {
+        try {
+            patchCache = std::make_shared<vfs::CacheDirectory>(path);
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to open the patch cache at '{}': {}", path, e.what());
+        }
+    }
+
+    NCE::PatchData NCE::GetPatchData(const std::vector<u8> &text, const std::array<u64, 4> &buildId) {
+        TRACE_BOOT_PHASE(NcePatching, "NCE::GetPatchData");
+        if (!patchCache || std::all_of(buildId.begin(), buildId.end(), [](u64 word) { return word == 0; }))
+            return ScanPatchData(text);
+
+        u64 frequency;
+        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        u64 textHash{XXH64(text.data(), text.size(), 0)};
+        auto entryName{vfs::CacheDirectory::GetBuildKey(buildId) + ".bin"};
+
+        if (auto entry{patchCache->Load(entryName, PatchCacheMagic, PatchCacheVersion)}) {
+            auto header{entry->size() >= sizeof(PatchCacheHeader) ? *reinterpret_cast<PatchCacheHeader *>(entry->data()) : PatchCacheHeader{}};
+            if (header.frequency == frequency && header.textSize == text.size() && header.textHash == textHash && entry->size() == sizeof(PatchCacheHeader) + (header.offsetCount * sizeof(u32))) {
+                auto offsets{reinterpret_cast<const u32 *>(entry->data() + sizeof(PatchCacheHeader))};
+                return {header.size, {offsets, offsets + header.offsetCount}};
+            }
+        }
+
+        auto data{ScanPatchData(text)};
+
+        std::vector<u8> entry(sizeof(PatchCacheHeader) + (data.offsets.size() * sizeof(u32)));
+        *reinterpret_cast<PatchCacheHeader *>(entry.data()) = PatchCacheHeader{
+            .frequency = frequency,
+            .textSize = text.size(),
+            .textHash = textHash,
+            .size = data.size,
+            .offsetCount = data.offsets.size(),
+        };
+        std::copy(data.offsets.begin(), data.offsets.end(), reinterpret_cast<u32 *>(entry.data() + sizeof(PatchCacheHeader))); // Offsets are in instructions so they always fit in 32 bits
+        patchCache->Store(entryName, PatchCacheMagic, PatchCacheVersion, entry);
+
+        return data;
+    }
+
+    std::vector<NCE::FunctionReplacement> NCE::FindFunctionReplacements(span<const Elf64_Sym> symbols, span<const char> symbolStrings, size_t textOffset, size_t textSize) {
+        std::vector<FunctionReplacement> replacements;
+        for (const auto &symbol : symbols) {
+            if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_shndx == SHN_UNDEF || !symbol.st_name || symbol.st_name >= symbolStrings.size())
+                continue;
+
+            // Only definitions in .text with at least a single instruction can be redirected
+            if (symbol.st_value < textOffset || symbol.st_value - textOffset + sizeof(u32) > textSize || symbol.st_size < sizeof(u32) || !util::IsAligned(symbol.st_value, sizeof(u32)))
+                continue;
+
+            std::string_view name{symbolStrings.data() + symbol.st_name, strnlen(symbolStrings.data() + symbol.st_name, symbolStrings.size() - symbol.st_name)};
+            auto hostFunction{std::find_if(HostFunctions.begin(), HostFunctions.end(), [&](const auto &function) { return function.first == name; })};
+            if (hostFunction == HostFunctions.end() || std::any_of(replacements.begin(), replacements.end(), [&](const auto &replacement) { return replacement.function == hostFunction->second; }))
+                continue;
+
+            replacements.push_back({(symbol.st_value - textOffset) / sizeof(u32), hostFunction->second});
+            Logger::Debug("Redirecting guest '{}' @ 0x{:X} to the host", name, symbol.st_value);
         }
-        return {util::AlignUp(size * sizeof(u32), PAGE_SIZE), offsets};
+        return replacements;
     }
 
-    void NCE::PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets) {
+    void NCE::PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets, const std::vector<FunctionReplacement> &replacements) {
+        TRACE_BOOT_PHASE(NcePatching, "NCE::PatchCode");
         u32 *start{patch};
         u32 *end{patch + (patchSize / sizeof(u32))};
 
         std::memcpy(patch, reinterpret_cast<void *>(&guest::SaveCtx), guest::SaveCtxSize * sizeof(u32));
         patch += guest::SaveCtxSize;
 
-        {
-            /* Main SVC Trampoline */
+        auto writeSvcTrampoline{[&](void (*handler)(u16, ThreadContext *)) {
             /* Store LR in 16B of pre-allocated stack */
             *patch++ = 0xF90007FE; // STR LR, [SP, #8]
 
@@ -222,7 +341,7 @@ namespace skyline::nce {
             *patch++ = 0xA9BF0BE1; // STP X1, X2, [SP, #-16]!
 
             /* Jump to SvcHandler */
-            for (const auto &mov : instructions::MoveRegister(registers::X2, reinterpret_cast<u64>(&NCE::SvcHandler)))
+            for (const auto &mov : instructions::MoveRegister(registers::X2, reinterpret_cast<u64>(handler)))
                 if (mov)
                     *patch++ = mov;
             *patch++ = 0xD63F0040; // BLR X2
@@ -235,14 +354,22 @@ namespace skyline::nce {
             /* Restore LR and Return */
             *patch++ = 0xF94007FE; // LDR LR, [SP, #8]
             *patch++ = 0xD65F03C0; // RET
-        }
+        }};
+
+        /* Main SVC Trampoline */
+        writeSvcTrampoline(&NCE::SvcHandler<false>);
 
         std::memcpy(patch, reinterpret_cast<void *>(&guest::LoadCtx), guest::LoadCtxSize * sizeof(u32));
         patch += guest::LoadCtxSize;
 
+        /* Fast SVC Trampoline */
+        u32 *fastSvcTrampoline{patch};
+        writeSvcTrampoline(&NCE::SvcHandler<true>);
+
         u64 frequency;
         asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
         bool rescaleClock{frequency != TegraX1Freq};
+        u64 counterMultiplier{GetCounterMultiplier(frequency)};
 
         for (auto offset : offsets) {
             u32 *instruction{reinterpret_cast<u32 *>(text.data()) + offset};
@@ -262,9 +389,10 @@ namespace skyline::nce {
                 *patch = instructions::BL(static_cast<i32>(startOffset())).raw;
                 patch++;
 
-                /* Jump to main SVC trampoline */
+                /* Jump to main or fast SVC trampoline */
+                bool fast{svc.value < kernel::svc::SvcTable.size() && kernel::svc::SvcTable[svc.value].fast};
                 *patch++ = instructions::Movz(registers::W0, static_cast<u16>(svc.value)).raw;
-                *patch = instructions::BL(static_cast<i32>(startOffset() + guest::SaveCtxSize)).raw;
+                *patch = instructions::BL(fast ? static_cast<i32>(fastSvcTrampoline - patch) : static_cast<i32>(startOffset() + guest::SaveCtxSize)).raw;
                 patch++;
 
                 /* Restore Context and Return */
@@ -276,45 +404,52 @@ namespace skyline::nce {
             } else if (mrs.Verify()) {
                 if (mrs.srcReg == TpidrroEl0 || mrs.srcReg == TpidrEl0) {
                     /* Emulated TLS Register Load */
+                    if (mrs.destReg == 31) {
+                        // A read into XZR has no effect, we can't use it as a base register for the load as it'd be interpreted as SP instead
+                        *instruction = 0xD503201F; // NOP
+                        continue;
+                    }
+
                     /* Rewrite MRS with B to trampoline */
                     *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
 
-                    /* Allocate Scratch Register */
-                    if (mrs.destReg != registers::X0)
-                        *patch++ = 0xF81F0FE0; // STR X0, [SP, #-16]!
-
-                    /* Retrieve emulated TLS register from ThreadContext */
-                    *patch++ = 0xD53BD040; // MRS X0, TPIDR_EL0
-                    if (mrs.srcReg == TpidrroEl0)
-                        *patch++ = 0xF9415800; // LDR X0, [X0, #0x2B0] (ThreadContext::tpidrroEl0)
-                    else
-                        *patch++ = 0xF9415C00; // LDR X0, [X0, #0x2B8] (ThreadContext::tpidrEl0)
-
-                    /* Restore Scratch Register and Return */
-                    if (mrs.destReg != registers::X0) {
-                        *patch++ = instructions::Mov(registers::X(mrs.destReg), registers::X0).raw;
-                        *patch++ = 0xF84107E0; // LDR X0, [SP], #16
-                    }
+                    /* Retrieve emulated TLS register from ThreadContext using the destination register as the base */
+                    auto destReg{registers::X(mrs.destReg)};
+                    *patch++ = instructions::Mrs(TpidrEl0, destReg).raw;
+                    instructions::Ldr ldr(mrs.srcReg == TpidrroEl0 ? 0xF9415800 : 0xF9415C00); // LDR XOUT, [XOUT, #0x2B0/#0x2B8] (ThreadContext::tpidrroEl0/ThreadContext::tpidrEl0)
+                    ldr.destReg = destReg;
+                    ldr.srcReg = destReg;
+                    *patch++ = ldr.raw;
+
+                    /* Return */
                     *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
                     patch++;
                 } else {
                     if (rescaleClock) {
-                        if (mrs.srcReg == CntpctEl0) {
-                            /* Physical Counter Load Emulation (With Rescaling) */
+                        if (mrs.srcReg == CntpctEl0 || mrs.srcReg == CntvctEl0) {
+                            /* Counter Load Emulation (With Rescaling) */
                             /* Rewrite MRS with B to trampoline */
                             *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
 
-                            /* Rescale host clock */
-                            std::memcpy(patch, reinterpret_cast<void *>(&guest::RescaleClock), guest::RescaleClockSize * sizeof(u32));
-                            patch += guest::RescaleClockSize;
-
-                            /* Load result from stack into destination register */
-                            instructions::Ldr ldr(0xF94003E0); // LDR XOUT, [SP]
-                            ldr.destReg = mrs.destReg;
-                            *patch++ = ldr.raw;
-
-                            /* Free 32B stack allocation by RescaleClock and Return */
-                            *patch++ = {0x910083FF}; // ADD SP, SP, #32
+                            /* Allocate Scratch Registers */
+                            // We need two scratch registers for the multiplier and the upper half of the product, these are the first two out of X0-X2 that aren't the destination
+                            auto destReg{registers::X(mrs.destReg)};
+                            auto multiplierReg{destReg == registers::X0 ? registers::X1 : registers::X0};
+                            auto highReg{(destReg == registers::X0 || destReg == registers::X1) ? registers::X2 : registers::X1};
+                            *patch++ = 0xA9BF03E0 | (highReg << 10) | multiplierReg; // STP XMUL, XHIGH, [SP, #-16]!
+
+                            /* Scale the host counter by a fixed-point multiplier */
+                            // The rescaled value is extracted from the 128-bit product, this avoids dividing by the host frequency on every read
+                            *patch++ = instructions::Mrs(CntvctEl0, destReg).raw;
+                            for (const auto &mov : instructions::MoveRegister(multiplierReg, counterMultiplier))
+                                if (mov)
+                                    *patch++ = mov;
+                            *patch++ = instructions::Umulh(highReg, destReg, multiplierReg).raw;
+                            *patch++ = instructions::Mul(destReg, destReg, multiplierReg).raw;
+                            *patch++ = instructions::Extr(destReg, highReg, destReg, CounterScaleShift).raw;
+
+                            /* Restore Scratch Registers and Return */
+                            *patch++ = 0xA8C103E0 | (highReg << 10) | multiplierReg; // LDP XMUL, XHIGH, [SP], #16
                             *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
                             patch++;
                         } else if (mrs.srcReg == CntfrqEl0) {
@@ -354,5 +489,19 @@ namespace skyline::nce {
                 patch++;
             }
         }
+
+        for (const auto &replacement : replacements) {
+            /* Function Replacement Trampoline */
+            // The host function runs directly on the guest stack with guest TLS and returns straight to the guest caller, this is only valid as the replaced functions don't touch either
+            // The entry is rewritten last as it may have been patched above, the trampoline for that is simply left unused
+            u32 *instruction{reinterpret_cast<u32 *>(text.data()) + replacement.offset};
+            *instruction = instructions::B(static_cast<i32>(static_cast<size_t>(end - patch) + replacement.offset), true).raw;
+
+            /* Jump to the host function, X16 is the intra-procedure-call scratch register so it can be freely clobbered at a function entry */
+            *patch++ = 0x58000050; // LDR X16, #8
+            *patch++ = 0xD61F0200; // BR X16
+            *reinterpret_cast<u64 *>(patch) = reinterpret_cast<u64>(replacement.function);
+            patch += sizeof(u64) / sizeof(u32);
+        }
     }
 }
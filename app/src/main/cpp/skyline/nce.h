@@ -5,6 +5,12 @@
 
 #include "common.h"
 #include <sys/wait.h>
+#include <linux/elf.h>
+#include "nce/profiler.h"
+
+namespace skyline::vfs {
+    class CacheDirectory;
+}
 
 namespace skyline::nce {
     /**
@@ -14,6 +20,12 @@ namespace skyline::nce {
       private:
         const DeviceState &state;
 
+        /**
+         * @brief Dispatches an SVC from guest code to its HLE implementation
+         * @tparam Fast If the SVC is dispatched through the fast path which calls the function directly without emitting any trace events, this is only used for SVCs marked as fast in the SVC table
+         * @note Exceptions are still caught on the fast path as any SVC which waits can be interrupted by a thread being killed, the handlers are zero-cost while nothing is thrown
+         */
+        template<bool Fast>
         static void SvcHandler(u16 svcId, ThreadContext *ctx);
 
       public:
@@ -34,6 +46,8 @@ namespace skyline::nce {
          */
         static void SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls);
 
+        std::unique_ptr<GuestProfiler> profiler; //!< The sampling profiler of guest threads, this is null unless it's enabled in the settings
+
         NCE(const DeviceState &state);
 
         struct PatchData {
@@ -41,12 +55,61 @@ namespace skyline::nce {
             std::vector<size_t> offsets; //!< Offsets in .text of instructions that need to be patched
         };
 
-        static PatchData GetPatchData(const std::vector<u8> &text);
+        /**
+         * @brief A guest function which has all calls to it redirected to an equivalent host function
+         */
+        struct FunctionReplacement {
+            size_t offset; //!< The offset of the entry of the guest function in .text in instructions
+            void *function; //!< The host function which is branched to from the guest function's entry
+        };
+
+      private:
+        /**
+         * @brief The header of the payload of a patch cache entry, it's followed by the offsets of all instructions that need to be patched as 32-bit integers
+         */
+        struct PatchCacheHeader {
+            u64 frequency; //!< The host counter frequency at the time of scanning as it determines which instructions are patched
+            u64 textSize; //!< The size of the .text section
+            u64 textHash; //!< The XXH64 hash of the .text section, this guards against modified code with an unchanged build ID
+            u64 size; //!< The size of the .patch section
+            u64 offsetCount; //!< The amount of offsets following the header
+        };
+
+        static constexpr u32 PatchCacheMagic{util::MakeMagic<u32>("SKNP")}; //!< "SKNP" - Skyline NCE Patch
+        static constexpr u32 PatchCacheVersion{2}; //!< The version of the patching code, this must be incremented whenever the patched instructions or their patch sizes change
+        static constexpr size_t ScanChunkSize{0x100000}; //!< The size of the .text chunks which are scanned in parallel
+
+        std::shared_ptr<vfs::CacheDirectory> patchCache; //!< The directory holding the cached patch data of executables, this is null till the cache is opened
+
+        /**
+         * @brief Scans the .text section for all instructions that need to be patched, large sections are split into chunks which are scanned in parallel
+         */
+        static PatchData ScanPatchData(const std::vector<u8> &text);
+
+      public:
+        /**
+         * @brief Opens the on-disk patch cache at the supplied directory, executables loaded prior to this are always scanned
+         */
+        void OpenPatchCache(const std::string &path);
+
+        /**
+         * @brief Retrieves the patch data of an executable from the patch cache or scans its .text section and stores the result in the cache
+         * @param buildId The build ID of the executable which is used as the key in the patch cache, the cache is bypassed if it's zero
+         */
+        PatchData GetPatchData(const std::vector<u8> &text, const std::array<u64, 4> &buildId);
+
+        /**
+         * @brief Finds all functions exported by an executable which have a host replacement, these are well-known libc routines which are usually far slower in guest code than their vectorized host counterparts
+         * @param symbols The .dynsym section of the executable, symbol values are relative to the start of the executable
+         * @param textOffset The offset of the .text section from the start of the executable
+         */
+        static std::vector<FunctionReplacement> FindFunctionReplacements(span<const Elf64_Sym> symbols, span<const char> symbolStrings, size_t textOffset, size_t textSize);
 
         /**
          * @brief Writes the .patch section and mutates the code accordingly
          * @param patch A pointer to the .patch section which should be exactly patchSize in size and located before the .text section
+         * @param replacements The guest functions which should be redirected to host functions, their entries are overwritten with a branch to a trampoline
          */
-        static void PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets);
+        static void PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets, const std::vector<FunctionReplacement> &replacements = {});
     };
 }
@@ -310,6 +310,96 @@ namespace skyline::nce {
         };
         static_assert(sizeof(Mov) == sizeof(u32));
 
+        /**
+         * @url https://developer.arm.com/docs/ddi0596/latest/base-instructions-alphabetic-order/mul-multiply-an-alias-of-madd
+         */
+        struct Mul {
+          public:
+            /**
+             * @brief Creates a MUL instruction which stores the lower 64 bits of the product of two Xn registers
+             */
+            constexpr Mul(registers::X destReg, registers::X srcReg, registers::X srcReg2) : destReg(static_cast<u8>(destReg)), srcReg(static_cast<u8>(srcReg)), addReg(0x1F), o0(0), srcReg2(static_cast<u8>(srcReg2)), op31(0x0), sig(0x9B) {}
+
+            constexpr bool Verify() {
+                return (sig == 0x9B) && (op31 == 0x0) && (o0 == 0) && (addReg == 0x1F);
+            }
+
+            union {
+                struct __attribute__((packed)) {
+                    u8 destReg : 5; //!< 5-bit destination register
+                    u8 srcReg : 5; //!< 5-bit first source register
+                    u8 addReg : 5; //!< 5-bit addend register (0x1F)
+                    u8 o0 : 1; //!< 1-bit signature (0x0)
+                    u8 srcReg2 : 5; //!< 5-bit second source register
+                    u8 op31 : 3; //!< 3-bit signature (0x0)
+                    u8 sig : 8; //!< 8-bit signature (0x9B)
+                };
+                u32 raw{};
+            };
+        };
+        static_assert(sizeof(Mul) == sizeof(u32));
+
+        /**
+         * @url https://developer.arm.com/docs/ddi0596/latest/base-instructions-alphabetic-order/umulh-unsigned-multiply-high
+         */
+        struct Umulh {
+          public:
+            /**
+             * @brief Creates a UMULH instruction which stores the upper 64 bits of the unsigned product of two Xn registers
+             */
+            constexpr Umulh(registers::X destReg, registers::X srcReg, registers::X srcReg2) : destReg(static_cast<u8>(destReg)), srcReg(static_cast<u8>(srcReg)), addReg(0x1F), o0(0), srcReg2(static_cast<u8>(srcReg2)), op31(0x6), sig(0x9B) {}
+
+            constexpr bool Verify() {
+                return (sig == 0x9B) && (op31 == 0x6) && (o0 == 0);
+            }
+
+            union {
+                struct __attribute__((packed)) {
+                    u8 destReg : 5; //!< 5-bit destination register
+                    u8 srcReg : 5; //!< 5-bit first source register
+                    u8 addReg : 5; //!< 5-bit unused register (0x1F)
+                    u8 o0 : 1; //!< 1-bit signature (0x0)
+                    u8 srcReg2 : 5; //!< 5-bit second source register
+                    u8 op31 : 3; //!< 3-bit signature (0x6)
+                    u8 sig : 8; //!< 8-bit signature (0x9B)
+                };
+                u32 raw{};
+            };
+        };
+        static_assert(sizeof(Umulh) == sizeof(u32));
+
+        /**
+         * @url https://developer.arm.com/docs/ddi0596/latest/base-instructions-alphabetic-order/extr-extract-register
+         */
+        struct Extr {
+          public:
+            /**
+             * @brief Creates an EXTR instruction which stores 64 bits extracted from the concatenation of two Xn registers
+             * @param highReg The register supplying the upper 64 bits of the concatenation
+             * @param lowReg The register supplying the lower 64 bits of the concatenation
+             * @param lsb The bit position in the concatenation to extract from
+             */
+            constexpr Extr(registers::X destReg, registers::X highReg, registers::X lowReg, u8 lsb) : destReg(static_cast<u8>(destReg)), highReg(static_cast<u8>(highReg)), lsb(lsb), lowReg(static_cast<u8>(lowReg)), o0(0), n(1), sig(0x127) {}
+
+            constexpr bool Verify() {
+                return (sig == 0x127) && (n == 1) && (o0 == 0);
+            }
+
+            union {
+                struct __attribute__((packed)) {
+                    u8 destReg : 5; //!< 5-bit destination register
+                    u8 highReg : 5; //!< 5-bit source register for the upper half
+                    u8 lsb : 6; //!< 6-bit least significant bit position
+                    u8 lowReg : 5; //!< 5-bit source register for the lower half
+                    u8 o0 : 1; //!< 1-bit signature (0x0)
+                    u8 n : 1; //!< 1-bit signature (0x1)
+                    u16 sig : 9; //!< 9-bit signature (0x127)
+                };
+                u32 raw{};
+            };
+        };
+        static_assert(sizeof(Extr) == sizeof(u32));
+
         /**
          * @url https://developer.arm.com/docs/ddi0596/e/base-instructions-alphabetic-order/ldr-immediate-load-register-immediate
          */
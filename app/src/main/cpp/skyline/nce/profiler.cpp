@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fstream>
+#include <unistd.h>
+#include <common/signal.h>
+#include <loader/loader.h>
+#include <os.h>
+#include "profiler.h"
+
+namespace skyline::nce {
+    size_t GuestProfiler::StackHash::operator()(const std::vector<void *> &stack) const {
+        size_t hash{stack.size()};
+        for (auto frame : stack)
+            hash = (hash * 31) ^ reinterpret_cast<size_t>(frame);
+        return hash;
+    }
+
+    GuestProfiler::GuestProfiler(const DeviceState &state) : state(state), samples(QueueSize) {
+        if (instance.load())
+            throw exception("Only a single instance of GuestProfiler may exist at a time");
+
+        thread = std::thread(&GuestProfiler::AggregationThread, this);
+        instance.store(this, std::memory_order_release);
+    }
+
+    GuestProfiler::~GuestProfiler() {
+        // The timers of threads aren't disarmed as they're owned by the threads, any later samples are discarded by the signal handler instead
+        instance.store(nullptr, std::memory_order_release);
+        while (activeHandlers.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        samples.Push(Sample{.stop = true});
+        thread.join();
+
+        WriteProfile();
+    }
+
+    void GuestProfiler::RegisterThread() {
+        thread_local struct ThreadTimer {
+            timer_t timer{};
+            bool created{};
+
+            ~ThreadTimer() {
+                if (created)
+                    timer_delete(timer);
+            }
+        } threadTimer;
+
+        if (threadTimer.created)
+            return;
+
+        signal::SetSignalHandler({SIGPROF}, SignalHandler);
+
+        struct sigevent event{
+            .sigev_signo = SIGPROF,
+            .sigev_notify = SIGEV_THREAD_ID,
+            .sigev_notify_thread_id = gettid(),
+        };
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &threadTimer.timer))
+            throw exception("timer_create has failed with '{}'", strerror(errno));
+        threadTimer.created = true;
+
+        auto intervalNs{std::chrono::duration_cast<std::chrono::nanoseconds>(SampleInterval).count()};
+        struct itimerspec spec{
+            .it_interval = {.tv_sec = static_cast<time_t>(intervalNs / constant::NsInSecond), .tv_nsec = static_cast<long>(intervalNs % constant::NsInSecond)},
+            .it_value = {.tv_sec = static_cast<time_t>(intervalNs / constant::NsInSecond), .tv_nsec = static_cast<long>(intervalNs % constant::NsInSecond)},
+        };
+        timer_settime(threadTimer.timer, 0, &spec, nullptr);
+    }
+
+    void GuestProfiler::SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls) {
+        activeHandlers.fetch_add(1, std::memory_order_acquire);
+        if (auto profiler{instance.load(std::memory_order_acquire)}) {
+            Sample sample{.guest = *tls != nullptr};
+            sample.frames[sample.depth++] = reinterpret_cast<void *>(ctx->uc_mcontext.pc);
+
+            // Guest code isn't guaranteed to maintain a frame pointer chain, frames are only followed while they're aligned and move up the stack by a sane amount so a corrupted chain is never followed into unmapped memory
+            auto frame{reinterpret_cast<signal::StackFrame *>(ctx->uc_mcontext.regs[29])};
+            while (frame && sample.depth < MaxDepth && util::IsAligned(frame, 16)) {
+                sample.frames[sample.depth++] = frame->lr;
+
+                auto next{frame->next};
+                if (next <= frame || reinterpret_cast<u8 *>(next) - reinterpret_cast<u8 *>(frame) > MaxFrameSize)
+                    break;
+                frame = next;
+            }
+
+            if (!profiler->samples.TryPush(std::move(sample)))
+                profiler->droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        }
+        activeHandlers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void GuestProfiler::AggregationThread() {
+        pthread_setname_np(pthread_self(), "Sky-Profiler");
+
+        while (true) {
+            auto sample{samples.Pop()};
+            if (sample.stop)
+                return;
+
+            auto &stacks{sample.guest ? guestStacks : hleStacks};
+            stacks[std::vector<void *>(sample.frames.begin(), sample.frames.begin() + sample.depth)]++;
+        }
+    }
+
+    void GuestProfiler::WriteProfile() {
+        std::unordered_map<void *, std::string> symbols;
+        auto getSymbol{[&](void *address) -> const std::string & {
+            auto it{symbols.find(address)};
+            if (it == symbols.end()) {
+                auto name{state.loader ? state.loader->GetSymbolName(address) : fmt::format("0x{:X}", reinterpret_cast<uintptr_t>(address))};
+                std::replace(name.begin(), name.end(), ';', ':'); // Semicolons separate frames in the collapsed stack format
+                it = symbols.emplace(address, std::move(name)).first;
+            }
+            return it->second;
+        }};
+
+        // Stacks are merged by their symbols as different return addresses inside the same function are the same frame in the profile
+        std::map<std::string, u64> collapsedStacks;
+        std::unordered_map<std::string, u64> selfSamples; //!< The amount of samples with every function as the innermost frame
+        u64 guestSamples{}, hleSamples{};
+        auto collapse{[&](const StackCounts &stacks, std::string_view root, u64 &total) {
+            for (const auto &[stack, count] : stacks) {
+                std::string collapsed{root};
+                for (auto frame{stack.rbegin()}; frame != stack.rend(); frame++) {
+                    collapsed += ';';
+                    collapsed += getSymbol(*frame);
+                }
+                collapsedStacks[collapsed] += count;
+                selfSamples[fmt::format("{} ({})", getSymbol(stack.front()), root)] += count;
+                total += count;
+            }
+        }};
+        collapse(guestStacks, "Guest", guestSamples);
+        collapse(hleStacks, "HLE", hleSamples);
+
+        auto totalSamples{guestSamples + hleSamples};
+        if (!totalSamples)
+            return;
+
+        auto path{fmt::format("{}guest_profile.folded", state.os->appFilesPath)};
+        std::ofstream file(path, std::ios::trunc);
+        for (const auto &[stack, count] : collapsedStacks)
+            file << stack << ' ' << count << '\n';
+
+        std::vector<std::pair<std::string_view, u64>> functions(selfSamples.begin(), selfSamples.end());
+        auto summaryCount{std::min(functions.size(), SummaryFunctions)};
+        std::partial_sort(functions.begin(), functions.begin() + static_cast<ssize_t>(summaryCount), functions.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        std::string summary;
+        for (size_t index{}; index < summaryCount; index++)
+            summary += fmt::format("\n* {:.2f}% {}", static_cast<double>(functions[index].second) * 100.0 / static_cast<double>(totalSamples), functions[index].first);
+
+        Logger::Info("Guest profile: {} samples ({:.2f}% guest, {:.2f}% HLE, {} dropped) written to {}\nHottest functions:{}", totalSamples, static_cast<double>(guestSamples) * 100.0 / static_cast<double>(totalSamples), static_cast<double>(hleSamples) * 100.0 / static_cast<double>(totalSamples), droppedSamples.load(), path, summary);
+    }
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/mpmc_queue.h>
+#include <common.h>
+
+namespace skyline::nce {
+    /**
+     * @brief A sampling profiler of guest threads which records the call stack of every sample, this shows if a title is bound by guest code or by HLE code and which functions it's spending its time in
+     * @note Every host thread running guest code has a CPU-time timer which sends SIGPROF to it, the signal handler walks the frame pointer chain of the interrupted code and pushes it into a lock-free queue that's aggregated on a separate thread
+     * @note The profile is symbolized through the loaded executables on exit, it's written in the collapsed stack format used by flame graph tools and a summary of the hottest functions is logged
+     */
+    class GuestProfiler {
+      public:
+        static constexpr std::chrono::microseconds SampleInterval{1000}; //!< The amount of CPU time a thread runs for between samples
+        static constexpr size_t MaxDepth{32}; //!< The maximum amount of frames captured in a single sample
+        static constexpr size_t MaxFrameSize{0x100000}; //!< The maximum distance between two consecutive frame records, the chain is assumed to be corrupted past it
+        static constexpr size_t QueueSize{0x1000}; //!< The amount of samples which can be pending aggregation, samples are dropped while the queue is full
+        static constexpr size_t SummaryFunctions{20}; //!< The amount of functions with the most samples which are logged
+
+      private:
+        struct Sample {
+            bool stop; //!< If this is a sentinel which stops the aggregation thread rather than an actual sample
+            bool guest; //!< If the sample was taken in guest code rather than in HLE code
+            u8 depth;
+            std::array<void *, MaxDepth> frames; //!< The PC followed by the return addresses of all captured frames, this is from the innermost frame outwards
+        };
+
+        struct StackHash {
+            size_t operator()(const std::vector<void *> &stack) const;
+        };
+
+        using StackCounts = std::unordered_map<std::vector<void *>, u64, StackHash>;
+
+        const DeviceState &state;
+        MpmcQueue<Sample> samples;
+        std::atomic<u64> droppedSamples{}; //!< The amount of samples dropped due to the queue being full
+        StackCounts guestStacks; //!< The amount of samples of every stack in guest code, this is only accessed by the aggregation thread till it has exited
+        StackCounts hleStacks; //!< The amount of samples of every stack in HLE code
+        std::thread thread;
+
+        static inline std::atomic<GuestProfiler *> instance{}; //!< The profiler that the signal handler records samples into
+        static inline std::atomic<u32> activeHandlers{}; //!< The amount of signal handlers which may be accessing the instance, it's only destroyed once there are none
+
+        static void SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls);
+
+        void AggregationThread();
+
+        /**
+         * @brief Symbolizes all aggregated stacks, writes them to a file and logs a summary of the hottest functions
+         */
+        void WriteProfile();
+
+      public:
+        GuestProfiler(const DeviceState &state);
+
+        /**
+         * @note The profile is written out on destruction
+         */
+        ~GuestProfiler();
+
+        /**
+         * @brief Starts sampling the calling host thread, this only has an effect on the first call from any thread
+         */
+        void RegisterThread();
+    };
+}
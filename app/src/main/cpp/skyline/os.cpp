@@ -3,8 +3,14 @@
 
 #include "nce.h"
 #include "nce/guest.h"
+#include "common/trace.h"
+#include "gpu.h"
 #include "kernel/types/KProcess.h"
 #include "vfs/os_backing.h"
+#include "vfs/mmap_backing.h"
+#include "vfs/cached_backing.h"
+#include "vfs/buffered_backing.h"
+#include "vfs/boot_trace.h"
 #include "loader/nro.h"
 #include "loader/nso.h"
 #include "loader/nca.h"
@@ -28,8 +34,19 @@ namespace skyline::kernel {
           systemLanguage(systemLanguage) {}
 
     void OS::Execute(int romFd, loader::RomFormat romType) {
-        auto romFile{std::make_shared<vfs::OsBacking>(romFd)};
+        trace::BootProfile::Start();
+        auto romFile{[&]() -> std::shared_ptr<vfs::Backing> {
+            // ROMs are read-only so they can be mapped in their entirety, this avoids a syscall for every read
+            try {
+                return std::make_shared<vfs::MmapBacking>(romFd);
+            } catch (const std::exception &e) {
+                Logger::Warn("Cannot map the ROM, falling back to regular reads: {}", e.what());
+                // Reads from fssrv are small and each one may go through a binder transaction for content URIs, coalescing them amortizes that cost
+                return std::make_shared<vfs::BufferedBacking>(std::make_shared<vfs::OsBacking>(romFd));
+            }
+        }()};
         auto keyStore{std::make_shared<crypto::KeyStore>(appFilesPath)};
+        vfs::BlockCache::Get().SetBudget(static_cast<size_t>(state.settings->blockCacheSize) * 1024 * 1024);
 
         state.loader = [&]() -> std::shared_ptr<loader::Loader> {
             switch (romType) {
@@ -38,19 +55,25 @@ namespace skyline::kernel {
                 case loader::RomFormat::NSO:
                     return std::make_shared<loader::NsoLoader>(std::move(romFile));
                 case loader::RomFormat::NCA:
-                    return std::make_shared<loader::NcaLoader>(std::move(romFile), std::move(keyStore));
+                    return std::make_shared<loader::NcaLoader>(std::move(romFile), std::move(keyStore), state.settings->verifyIntegrity);
                 case loader::RomFormat::NSP:
-                    return std::make_shared<loader::NspLoader>(romFile, keyStore);
+                    return std::make_shared<loader::NspLoader>(romFile, keyStore, state.settings->verifyIntegrity);
                 case loader::RomFormat::XCI:
-                    return std::make_shared<loader::XciLoader>(romFile, keyStore);
+                    return std::make_shared<loader::XciLoader>(romFile, keyStore, state.settings->verifyIntegrity);
                 default:
                     throw exception("Unsupported ROM extension.");
             }
         }();
 
+        state.gpu->decodeCache.Open(appFilesPath + "texture_cache/", static_cast<size_t>(state.settings->textureCacheSize) * 1024 * 1024);
+        state.nce->OpenPatchCache(appFilesPath + "patch_cache/");
+
         auto &process{state.process};
         process = std::make_shared<kernel::type::KProcess>(state);
         auto entry{state.loader->LoadProcessData(process, state)};
+        state.gpu->pipelineCache.Open(appFilesPath + "pipeline_cache/", process->npdm.aci0.programId);
+        state.gpu->shaderCache.Open(appFilesPath + "shader_cache/", process->npdm.aci0.programId);
+        vfs::BootTrace::Get().Start(appFilesPath + "boot_trace/", process->npdm.aci0.programId);
         process->InitializeHeapTls();
         auto thread{process->CreateThread(entry)};
         if (thread) {
@@ -58,5 +81,6 @@ namespace skyline::kernel {
             thread->Start(true);
             process->Kill(true, true, true);
         }
+        vfs::BootTrace::Get().Stop();
     }
 }
@@ -28,6 +28,10 @@ namespace skyline::service::apm {
          */
         Result GetPerformanceConfiguration(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        bool IsBlocking() override {
+            return false;
+        }
+
         SERVICE_DECL(
             SFUNC(0x0, ISession, SetPerformanceConfiguration),
             SFUNC(0x1, ISession, GetPerformanceConfiguration)
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include <kernel/types/KProcess.h>
 #include "IAudioOut.h"
 
@@ -10,15 +11,79 @@ namespace skyline::service::audio {
           channelCount(channelCount),
           releaseEvent(std::make_shared<type::KEvent>(state, false)),
           BaseService(state, manager) {
-        track = state.audio->OpenTrack(channelCount, constant::SampleRate, [this]() { releaseEvent->Signal(); });
+        track = state.audio->OpenTrack(channelCount, constant::SampleRate, [this]() {
+            pendingReleases.fetch_add(1, std::memory_order_release);
+            pendingReleases.notify_one();
+        });
+        releaseThread = std::thread(&IAudioOut::ReleaseThread, this);
+        if (sampleRate != constant::SampleRate)
+            conversionThread = std::thread(&IAudioOut::ConversionThread, this);
     }
 
     IAudioOut::~IAudioOut() {
+        if (conversionThread.joinable()) {
+            {
+                std::scoped_lock lock(conversionMutex);
+                exitConversion = true;
+            }
+            conversionCondition.notify_all();
+            conversionThread.join();
+        }
+
+        exitRelease.store(true, std::memory_order_release);
+        pendingReleases.fetch_add(1, std::memory_order_release);
+        pendingReleases.notify_one();
+        releaseThread.join();
+
         state.audio->CloseTrack(track);
     }
 
+    void IAudioOut::ReleaseThread() {
+        pthread_setname_np(pthread_self(), "Sky-AudioOutRel");
+
+        while (true) {
+            pendingReleases.wait(0, std::memory_order_acquire);
+            if (exitRelease.load(std::memory_order_acquire))
+                return;
+            pendingReleases.store(0, std::memory_order_relaxed); // Any releases after this will be picked up by the next iteration
+            releaseEvent->Signal();
+        }
+    }
+
+    void IAudioOut::ConversionThread() {
+        pthread_setname_np(pthread_self(), "Sky-AudioOut");
+
+        auto ratio{static_cast<double>(sampleRate) / constant::SampleRate};
+        std::unique_lock lock(conversionMutex);
+        while (true) {
+            conversionCondition.wait(lock, [this]() { return exitConversion || !pendingBuffers.empty(); });
+            if (exitConversion)
+                return;
+
+            // The batch is only cleared after it has been converted, so the buffers in it are still found by ContainsAudioOutBuffer while they're being converted
+            std::swap(pendingBuffers, conversionBatch);
+            lock.unlock();
+
+            TRACE_EVENT("audio", "IAudioOut::Convert", "buffers", conversionBatch.size());
+            for (const auto &buffer : conversionBatch) {
+                resampledBuffer.resize(skyline::audio::Resampler::GetMaxOutputSize(buffer.samples.size(), ratio, channelCount));
+                auto resampledSize{resampler.Resample(buffer.samples, resampledBuffer, ratio, channelCount)};
+                track->AppendBuffer(buffer.tag, span(resampledBuffer).first(resampledSize));
+            }
+
+            lock.lock();
+            conversionBatch.clear();
+            conversionCondition.notify_all();
+        }
+    }
+
+    void IAudioOut::FlushConversion() {
+        std::unique_lock lock(conversionMutex);
+        conversionCondition.wait(lock, [this]() { return pendingBuffers.empty() && conversionBatch.empty(); });
+    }
+
     Result IAudioOut::GetAudioOutState(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        response.Push(static_cast<u32>(track->playbackState));
+        response.Push(static_cast<u32>(track->playbackState.load()));
         return {};
     }
 
@@ -30,6 +95,7 @@ namespace skyline::service::audio {
 
     Result IAudioOut::StopAudioOut(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         Logger::Debug("Stop playback");
+        FlushConversion(); // Stopping waits for all appended buffers to be played, this includes the ones that weren't converted yet
         track->Stop();
         return {};
     }
@@ -47,9 +113,12 @@ namespace skyline::service::audio {
         Logger::Debug("Appending buffer at 0x{:X}, Size: 0x{:X}", data.sampleBuffer, data.sampleSize);
 
         span samples(data.sampleBuffer, data.sampleSize / sizeof(i16));
-        if (sampleRate != constant::SampleRate) {
-            auto resampledBuffer{resampler.ResampleBuffer(samples, static_cast<double>(sampleRate) / constant::SampleRate, channelCount)};
-            track->AppendBuffer(tag, resampledBuffer);
+        if (conversionThread.joinable()) {
+            {
+                std::scoped_lock lock(conversionMutex);
+                pendingBuffers.push_back(PendingBuffer{tag, samples});
+            }
+            conversionCondition.notify_all();
         } else {
             track->AppendBuffer(tag, samples);
         }
@@ -80,7 +149,14 @@ namespace skyline::service::audio {
     Result IAudioOut::ContainsAudioOutBuffer(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         auto tag{request.Pop<u64>()};
 
-        response.Push(static_cast<u32>(track->ContainsBuffer(tag)));
+        bool pending{};
+        if (conversionThread.joinable()) {
+            std::scoped_lock lock(conversionMutex);
+            auto isBuffer{[tag](const PendingBuffer &buffer) { return buffer.tag == tag; }};
+            pending = std::any_of(pendingBuffers.begin(), pendingBuffers.end(), isBuffer) || std::any_of(conversionBatch.begin(), conversionBatch.end(), isBuffer);
+        }
+
+        response.Push(static_cast<u32>(pending || track->ContainsBuffer(tag)));
         return {};
     }
 }
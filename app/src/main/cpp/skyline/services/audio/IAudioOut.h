@@ -10,17 +10,54 @@
 namespace skyline::service::audio {
     /**
      * @brief IAudioOut is a service opened when OpenAudioOut is called by IAudioOutManager
+     * @note Audio outs at a sample rate other than the output rate convert appended buffers on a dedicated thread, bursts of appended buffers are converted together in a batch without blocking the guest
      * @url https://switchbrew.org/wiki/Audio_services#IAudioOut
      */
     class IAudioOut : public BaseService {
       private:
-        skyline::audio::Resampler resampler; //!< The audio resampler object used to resample audio
+        /**
+         * @brief A buffer which was appended by the guest but wasn't converted and appended to the track yet
+         * @note The samples are read directly from guest memory, this is safe as the guest can't reuse a buffer till it's released
+         */
+        struct PendingBuffer {
+            u64 tag;
+            span<i16> samples;
+        };
+
+        skyline::audio::Resampler resampler; //!< The audio resampler object used to resample audio, this is only used by the conversion thread
+        std::vector<i16> resampledBuffer; //!< A scratch buffer for resampled audio, this retains its capacity across appended buffers
         std::shared_ptr<skyline::audio::AudioTrack> track; //!< The audio track associated with the audio out
         std::shared_ptr<type::KEvent> releaseEvent; //!< The KEvent that is signalled when a buffer has been released
 
         u32 sampleRate;
         u8 channelCount;
 
+        std::mutex conversionMutex; //!< Synchronizes the pending buffers and the conversion batch
+        std::condition_variable conversionCondition; //!< Signalled when buffers are queued for conversion and when a batch has been converted
+        std::vector<PendingBuffer> pendingBuffers; //!< The buffers which are queued for conversion
+        std::vector<PendingBuffer> conversionBatch; //!< The buffers which are being converted by the conversion thread
+        bool exitConversion{}; //!< If the conversion thread should exit
+        std::thread conversionThread; //!< The thread which converts appended buffers, this is only created if the sample rate doesn't match the output rate
+
+        std::atomic<u32> pendingReleases{}; //!< Incremented by the audio callback whenever it releases buffers, the release thread waits on this
+        std::atomic<bool> exitRelease{}; //!< If the release thread should exit
+        std::thread releaseThread; //!< The thread which signals the release event, this can't be done from the audio callback as it runs on a real-time thread and signalling locks the event
+
+        /**
+         * @brief Converts batches of pending buffers to the output sample rate and appends them to the track
+         */
+        void ConversionThread();
+
+        /**
+         * @brief Signals the release event whenever the track releases buffers
+         */
+        void ReleaseThread();
+
+        /**
+         * @brief Waits till all pending buffers have been appended to the track
+         */
+        void FlushConversion();
+
       public:
         /**
          * @param channelCount The channel count of the audio data the audio out will be fed
@@ -1,13 +1,17 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include <kernel/types/KProcess.h>
 #include "IAudioRenderer.h"
 
 namespace skyline::service::audio::IAudioRenderer {
     IAudioRenderer::IAudioRenderer(const DeviceState &state, ServiceManager &manager, AudioRendererParameters &parameters)
-        : systemEvent(std::make_shared<type::KEvent>(state, true)), parameters(parameters), BaseService(state, manager) {
-        track = state.audio->OpenTrack(constant::ChannelCount, constant::SampleRate, [&]() { systemEvent->Signal(); });
+        : systemEvent(std::make_shared<type::KEvent>(state, true)), parameters(parameters), performanceManager(parameters.performanceManagerCount), BaseService(state, manager) {
+        track = state.audio->OpenTrack(constant::ChannelCount, constant::SampleRate, [this]() {
+            pendingReleases.fetch_add(1, std::memory_order_release);
+            pendingReleases.notify_one();
+        });
         track->Start();
 
         memoryPools.resize(parameters.effectCount + parameters.voiceCount * 4);
@@ -18,9 +22,17 @@ namespace skyline::service::audio::IAudioRenderer {
         track->AppendBuffer(0);
         track->AppendBuffer(1);
         track->AppendBuffer(2);
+
+        BuildCommandList();
+        renderThread = std::thread(&IAudioRenderer::RenderThread, this);
     }
 
     IAudioRenderer::~IAudioRenderer() {
+        exitRender.store(true, std::memory_order_release);
+        pendingReleases.fetch_add(1, std::memory_order_release);
+        pendingReleases.notify_one();
+        renderThread.join();
+
         state.audio->CloseTrack(track);
     }
 
@@ -45,6 +57,8 @@ namespace skyline::service::audio::IAudioRenderer {
     }
 
     Result IAudioRenderer::RequestUpdate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock(renderMutex);
+
         auto input{request.inputBuf.at(0).data()};
 
         auto inputHeader{*reinterpret_cast<UpdateDataHeader *>(input)};
@@ -68,7 +82,7 @@ namespace skyline::service::audio::IAudioRenderer {
         for (u32 i{}; i < effectsIn.size(); i++)
             effects[i].ProcessInput(effectsIn[i]);
 
-        UpdateAudio();
+        BuildCommandList();
 
         UpdateDataHeader outputHeader{
             .revision = constant::RevMagic,
@@ -77,7 +91,7 @@ namespace skyline::service::audio::IAudioRenderer {
             .voiceSize = parameters.voiceCount * static_cast<u32>(sizeof(VoiceOut)),
             .effectSize = parameters.effectCount * static_cast<u32>(sizeof(EffectOut)),
             .sinkSize = parameters.sinkCount * 0x20,
-            .performanceManagerSize = 0x10,
+            .performanceManagerSize = sizeof(PerformanceManagerOut),
             .elapsedFrameCountInfoSize = 0x0
         };
 
@@ -114,60 +128,106 @@ namespace skyline::service::audio::IAudioRenderer {
             output += sizeof(EffectOut);
         }
 
-        return {};
-    }
+        output += outputHeader.sinkSize;
 
-    void IAudioRenderer::UpdateAudio() {
-        auto released{track->GetReleasedBuffers(2)};
+        // The performance buffer is optional, the guest only supplies it when it requested a performance manager
+        PerformanceManagerOut performanceOut{};
+        if (request.outputBuf.size() > 1)
+            performanceOut.historySize = static_cast<u32>(performanceManager.Write(request.outputBuf[1], revisionInfo.UsesPerformanceMetricDataFormatV2()));
+        *reinterpret_cast<PerformanceManagerOut *>(output) = performanceOut;
 
-        for (auto &tag : released) {
-            MixFinalBuffer();
-            track->AppendBuffer(tag, sampleBuffer);
-        }
+        return {};
     }
 
-    void IAudioRenderer::MixFinalBuffer() {
-        u32 writtenSamples{};
-
-        for (auto &voice : voices) {
-            if (!voice.Playable())
-                continue;
-
-            u32 bufferOffset{};
-            u32 pendingSamples{constant::MixBufferSize};
-
-            while (pendingSamples > 0) {
-                u32 voiceBufferOffset{};
-                u32 voiceBufferSize{};
-                auto &voiceSamples{voice.GetBufferData(pendingSamples, voiceBufferOffset, voiceBufferSize)};
+    void IAudioRenderer::BuildCommandList() {
+        commands.clear();
+        commands.emplace_back(ClearMixCommand{});
+
+        if (playbackState == skyline::audio::AudioOutState::Started) {
+            // Voices are rendered in order of priority so the least important ones are dropped first if the deadline is exceeded
+            playableVoices.clear();
+            for (auto &voice : voices) {
+                if (voice.Playable())
+                    playableVoices.push_back(&voice);
+                else if (voice.mixed)
+                    commands.emplace_back(DepopPrepareCommand{&voice});
+            }
+            std::stable_sort(playableVoices.begin(), playableVoices.end(), [](Voice *a, Voice *b) { return a->priority < b->priority; });
+
+            for (auto voice : playableVoices) {
+                commands.emplace_back(DataSourceCommand{voice});
+
+                for (u8 index{}; index < voice->biquadFilters.size(); index++) {
+                    const auto &filter{voice->biquadFilters[index]};
+                    if (filter.enable)
+                        commands.emplace_back(BiquadFilterCommand{
+                            .voice = voice,
+                            .index = index,
+                            .numerator = {static_cast<i16>(filter.b0), static_cast<i16>(filter.b1), static_cast<i16>(filter.b2)},
+                            .denominator = {static_cast<i16>(filter.a1), static_cast<i16>(filter.a2)},
+                        });
+                }
 
-                if (voiceBufferSize == 0)
-                    break;
+                commands.emplace_back(VolumeMixCommand{voice, voice->volume});
+            }
 
-                pendingSamples -= voiceBufferSize / constant::ChannelCount;
+            commands.emplace_back(DepopForMixCommand{});
+        }
 
-                for (auto index{voiceBufferOffset}; index < voiceBufferOffset + voiceBufferSize; index++) {
-                    if (writtenSamples == bufferOffset) {
-                        sampleBuffer[bufferOffset] = skyline::audio::Saturate<i16, i32>(voiceSamples[index] * voice.volume);
+        commands.emplace_back(SinkCommand{});
+    }
 
-                        writtenSamples++;
-                    } else {
-                        sampleBuffer[bufferOffset] = skyline::audio::Saturate<i16, i32>(sampleBuffer[bufferOffset] + (voiceSamples[index] * voice.volume));
+    void IAudioRenderer::RenderThread() {
+        pthread_setname_np(pthread_self(), "Sky-AudioRender");
+
+        while (true) {
+            pendingReleases.wait(0, std::memory_order_acquire);
+            if (exitRender.load(std::memory_order_acquire))
+                return;
+            pendingReleases.store(0, std::memory_order_relaxed); // Any releases after this will be picked up by the next iteration
+
+            for (auto tag : track->GetReleasedBuffers(std::numeric_limits<u32>::max())) {
+                {
+                    TRACE_EVENT("audio", "IAudioRenderer::Render");
+                    std::scoped_lock lock(renderMutex);
+
+                    CommandContext context{
+                        .mix = mixBuffer,
+                        .depop = depopSamples,
+                        .sink = &sampleBuffer,
+                        .deadline = std::chrono::steady_clock::now() + RenderDeadline,
+                        .voiceDropEnable = parameters.voiceDropEnable != 0,
+                        .metrics = {.startTime = util::GetTimeNs()},
+                    };
+
+                    try {
+                        backend->Execute(commands, context);
+                    } catch (const std::exception &e) {
+                        Logger::Warn("Failed to render audio frame: {}", e.what());
+                        sampleBuffer.fill(0);
                     }
 
-                    bufferOffset++;
+                    context.metrics.deadlineExceeded = std::chrono::steady_clock::now() > context.deadline;
+                    performanceManager.Record(context.metrics);
                 }
+
+                track->AppendBuffer(tag, sampleBuffer);
+                systemEvent->Signal();
             }
         }
     }
 
     Result IAudioRenderer::Start(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock(renderMutex);
         playbackState = skyline::audio::AudioOutState::Started;
+        BuildCommandList();
         return {};
     }
 
     Result IAudioRenderer::Stop(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock(renderMutex);
         playbackState = skyline::audio::AudioOutState::Stopped;
+        BuildCommandList();
         return {};
     }
 
@@ -8,6 +8,8 @@
 #include "memory_pool.h"
 #include "effect.h"
 #include "voice.h"
+#include "command.h"
+#include "performance.h"
 #include "revision_info.h"
 
 namespace skyline {
@@ -58,6 +60,7 @@ namespace skyline {
 
         /**
         * @brief IAudioRenderer is used to control an audio renderer output
+        * @note RequestUpdate builds a command list from the guest's parameters which is executed by a dedicated render thread whenever the track releases a buffer, this mirrors how HOS renders audio on the ADSP
         * @url https://switchbrew.org/wiki/Audio_services#IAudioRenderer
         */
         class IAudioRenderer : public BaseService {
@@ -69,19 +72,32 @@ namespace skyline {
             std::vector<MemoryPool> memoryPools;
             std::vector<Effect> effects;
             std::vector<Voice> voices;
-            std::array<i16, constant::MixBufferSize * constant::ChannelCount> sampleBuffer{}; //!< The final output data that is appended to the stream
+
+            SampleBuffer mixBuffer{}; //!< The buffer that voices are mixed into
+            SampleBuffer sampleBuffer{}; //!< The final output data that is appended to the stream
+            std::array<float, constant::ChannelCount> depopSamples{}; //!< The depop accumulator, this decays across frames
             skyline::audio::AudioOutState playbackState{skyline::audio::AudioOutState::Stopped};
 
+            static constexpr std::chrono::microseconds RenderDeadline{(constant::MixBufferSize * 1'000'000) / constant::SampleRate}; //!< The time a frame must be rendered within after the track releases a buffer, later voices are dropped if the guest enabled it
+            std::mutex renderMutex; //!< Synchronizes the command list and all renderer state between RequestUpdate and the render thread
+            CommandList commands; //!< The command list for the latest update, it's executed for every frame till the next update
+            std::vector<Voice *> playableVoices; //!< The voices which are playable when building the command list, this is only a member to retain its capacity
+            std::unique_ptr<CommandBackend> backend{std::make_unique<CpuCommandBackend>()};
+            PerformanceManager performanceManager; //!< The timings of rendered frames, this is synchronized by renderMutex
+            std::atomic<u32> pendingReleases{}; //!< Incremented by the audio callback whenever it releases buffers, the render thread waits on this
+            std::atomic<bool> exitRender{}; //!< If the render thread should exit
+            std::thread renderThread;
+
             /**
-             * @brief Obtains new sample data from voices and mixes it together into the sample buffer
-             * @return The amount of samples present in the buffer
+             * @brief Rebuilds the command list from the current renderer state
+             * @note renderMutex MUST be locked when calling this
              */
-            void MixFinalBuffer();
+            void BuildCommandList();
 
             /**
-             * @brief Appends all released buffers with new mixed sample data
+             * @brief Renders a frame for every buffer the track releases and appends it to the track
              */
-            void UpdateAudio();
+            void RenderThread();
 
           public:
             /**
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include <audio/mix.h>
+#include "command.h"
+
+namespace skyline::service::audio::IAudioRenderer {
+    constexpr float DepopDecay{0.97f}; //!< The factor that depop samples are multiplied with every sample frame, this decays them by roughly 60dB over 5ms
+
+    /**
+     * @return The voice that a command operates on or null if it doesn't operate on a single voice
+     */
+    static Voice *GetCommandVoice(const Command &command) {
+        return std::visit([](const auto &specific) -> Voice * {
+            if constexpr (requires { specific.voice; })
+                return specific.voice;
+            else
+                return nullptr;
+        }, command);
+    }
+
+    void CpuCommandBackend::ExecuteCommand(const Command &command, CommandContext &context) {
+        std::visit(VariantVisitor{
+            [&](const ClearMixCommand &) {
+                std::fill(context.mix.begin(), context.mix.end(), 0);
+            },
+            [&](const DataSourceCommand &data) {
+                auto &voice{*data.voice};
+                if (context.voiceDropEnable && std::chrono::steady_clock::now() > context.deadline) [[unlikely]] {
+                    voice.renderedSize = 0;
+                    voice.output.voiceDropsCount++;
+                    context.metrics.droppedVoices++;
+                    return;
+                }
+
+                voice.Render();
+            },
+            [&](const BiquadFilterCommand &filter) {
+                auto &voice{*filter.voice};
+                for (u8 channel{}; channel < constant::ChannelCount; channel++) {
+                    auto &[state0, state1]{voice.biquadStates[filter.index][channel]};
+                    for (size_t index{channel}; index < voice.renderedSize; index += constant::ChannelCount) {
+                        i64 input{voice.renderedSamples[index]};
+                        auto output{skyline::audio::Saturate<i16, i64>(((input * filter.numerator[0]) + state0 + (1 << 13)) >> 14)};
+
+                        state0 = state1 + (input * filter.numerator[1]) + (static_cast<i64>(output) * filter.denominator[0]);
+                        state1 = (input * filter.numerator[2]) + (static_cast<i64>(output) * filter.denominator[1]);
+                        voice.renderedSamples[index] = output;
+                    }
+                }
+            },
+            [&](const VolumeMixCommand &mix) {
+                auto &voice{*mix.voice};
+                auto size{voice.renderedSize};
+                float volumeStep{(mix.volume - voice.previousVolume) / constant::MixBufferSize};
+
+                skyline::audio::ApplyVolumeRamp<true>(context.mix.first(size), span<const i16>(voice.renderedSamples).first(size), voice.previousVolume, volumeStep);
+
+                if (size) {
+                    auto lastVolume{voice.previousVolume + (volumeStep * static_cast<float>((size / constant::ChannelCount) - 1))};
+                    for (u8 channel{}; channel < constant::ChannelCount; channel++)
+                        voice.lastSamples[channel] = skyline::audio::Saturate<i16, i32>(static_cast<float>(voice.renderedSamples[size - constant::ChannelCount + channel]) * lastVolume);
+                    voice.mixed = true;
+                }
+                voice.previousVolume = mix.volume;
+
+                if (size < context.mix.size() && voice.mixed) {
+                    // The voice ran out of data partway through the frame, its last frame decays to silence from where it stopped to avoid a pop
+                    std::array<float, constant::ChannelCount> tail{};
+                    std::copy(voice.lastSamples.begin(), voice.lastSamples.end(), tail.begin());
+                    for (size_t index{size}; index < context.mix.size(); index += constant::ChannelCount) {
+                        for (u8 channel{}; channel < constant::ChannelCount; channel++) {
+                            tail[channel] *= DepopDecay;
+                            context.mix[index + channel] = skyline::audio::Saturate<i16, i32>(static_cast<i32>(context.mix[index + channel]) + static_cast<i32>(tail[channel]));
+                        }
+                    }
+                    voice.mixed = false;
+                }
+            },
+            [&](const DepopPrepareCommand &depop) {
+                auto &voice{*depop.voice};
+                if (!voice.mixed)
+                    return;
+
+                for (u8 channel{}; channel < constant::ChannelCount; channel++)
+                    context.depop[channel] += voice.lastSamples[channel];
+                voice.mixed = false;
+            },
+            [&](const DepopForMixCommand &) {
+                if (std::all_of(context.depop.begin(), context.depop.end(), [](float sample) { return sample == 0.0f; }))
+                    return;
+
+                for (size_t index{}; index < context.mix.size(); index += constant::ChannelCount) {
+                    for (u8 channel{}; channel < constant::ChannelCount; channel++) {
+                        auto &sample{context.depop[channel]};
+                        context.mix[index + channel] = skyline::audio::Saturate<i16, i32>(static_cast<i32>(context.mix[index + channel]) + static_cast<i32>(sample));
+                        sample *= DepopDecay;
+                    }
+                }
+
+                for (auto &sample : context.depop)
+                    if (std::abs(sample) < 1.0f)
+                        sample = 0.0f;
+            },
+            [&](const SinkCommand &) {
+                if (context.sink)
+                    std::copy(context.mix.begin(), context.mix.end(), context.sink->begin());
+            },
+        }, command);
+    }
+
+    void CpuCommandBackend::ExecuteParallel(const CommandList &commands, CommandContext &context) {
+        if (!pool) {
+            pool = std::make_unique<ThreadPool>(std::clamp<size_t>(std::thread::hardware_concurrency(), 2, PartitionCount) - 1);
+            partitionMixes.resize(PartitionCount);
+        }
+
+        std::array<std::array<float, constant::ChannelCount>, PartitionCount> partitionDepops{};
+        std::array<std::exception_ptr, PartitionCount> partitionExceptions{};
+        std::array<u32, PartitionCount> partitionDrops{};
+        pool->ParallelFor(PartitionCount, [&](size_t partition) {
+            try {
+                auto &partitionMix{partitionMixes[partition]};
+                partitionMix.fill(0);
+
+                CommandContext partitionContext{
+                    .mix = partitionMix,
+                    .depop = partitionDepops[partition],
+                    .sink = nullptr,
+                    .deadline = context.deadline,
+                    .voiceDropEnable = context.voiceDropEnable,
+                };
+
+                size_t begin{(voiceRanges.size() * partition) / PartitionCount}, end{(voiceRanges.size() * (partition + 1)) / PartitionCount};
+                for (size_t range{begin}; range < end; range++)
+                    for (size_t index{voiceRanges[range].first}; index < voiceRanges[range].second; index++)
+                        ExecuteCommand(commands[index], partitionContext);
+                partitionDrops[partition] = partitionContext.metrics.droppedVoices;
+            } catch (...) {
+                partitionExceptions[partition] = std::current_exception();
+            }
+        });
+
+        for (const auto &partitionException : partitionExceptions)
+            if (partitionException)
+                std::rethrow_exception(partitionException);
+
+        for (const auto &partitionDroppedVoices : partitionDrops)
+            context.metrics.droppedVoices += partitionDroppedVoices;
+
+        for (size_t partition{}; partition < PartitionCount; partition++) {
+            skyline::audio::MixSamples(context.mix, partitionMixes[partition]);
+            for (u8 channel{}; channel < constant::ChannelCount; channel++)
+                context.depop[channel] += partitionDepops[partition][channel];
+        }
+    }
+
+    void CpuCommandBackend::Execute(const CommandList &commands, CommandContext &context) {
+        TRACE_EVENT("audio", "CpuCommandBackend::Execute", "commands", commands.size());
+
+        for (size_t index{}; index < commands.size();) {
+            auto commandStart{util::GetTimeNs()};
+            if (!GetCommandVoice(commands[index])) {
+                auto &command{commands[index++]};
+                ExecuteCommand(command, context);
+                (std::holds_alternative<SinkCommand>(command) ? context.metrics.sinkTime : context.metrics.mixTime) += util::GetTimeNs() - commandStart;
+                continue;
+            }
+
+            // Split the run of voice commands into the command ranges of each voice, these can be executed independently of each other
+            voiceRanges.clear();
+            size_t runStart{index};
+            Voice *currentVoice{};
+            for (; index < commands.size(); index++) {
+                auto voice{GetCommandVoice(commands[index])};
+                if (!voice)
+                    break;
+
+                if (voice != currentVoice) {
+                    voiceRanges.emplace_back(index, index);
+                    currentVoice = voice;
+                }
+                voiceRanges.back().second = index + 1;
+            }
+
+            if (voiceRanges.size() > ParallelVoiceThreshold)
+                ExecuteParallel(commands, context);
+            else
+                for (size_t command{runStart}; command < index; command++)
+                    ExecuteCommand(commands[command], context);
+            context.metrics.voiceTime += util::GetTimeNs() - commandStart;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <variant>
+#include <common/thread_pool.h>
+#include "voice.h"
+#include "performance.h"
+
+namespace skyline::service::audio::IAudioRenderer {
+    using SampleBuffer = std::array<i16, constant::MixBufferSize * constant::ChannelCount>;
+
+    /**
+     * @brief Clears the mix buffer prior to any voices being mixed into it
+     */
+    struct ClearMixCommand {};
+
+    /**
+     * @brief Decodes, resamples and upmixes the next frame of a voice's wave buffers into its rendered samples
+     */
+    struct DataSourceCommand {
+        Voice *voice;
+    };
+
+    /**
+     * @brief Applies a biquad filter to the rendered samples of a voice
+     * @note The coefficients are in signed 2.14 fixed point, the denominator coefficients are negated by the guest so they're added rather than subtracted
+     */
+    struct BiquadFilterCommand {
+        Voice *voice;
+        u8 index; //!< The index of the filter in the voice, this selects the filter state
+        std::array<i16, 3> numerator;
+        std::array<i16, 2> denominator;
+    };
+
+    /**
+     * @brief Mixes the rendered samples of a voice into the mix buffer with its volume ramped from the volume it was previously mixed at
+     */
+    struct VolumeMixCommand {
+        Voice *voice;
+        float volume;
+    };
+
+    /**
+     * @brief Moves the last mixed frame of a voice which stopped since the previous frame into the depop accumulator, so it decays to silence rather than cutting off
+     */
+    struct DepopPrepareCommand {
+        Voice *voice;
+    };
+
+    /**
+     * @brief Mixes the decaying depop accumulator into the mix buffer
+     */
+    struct DepopForMixCommand {};
+
+    /**
+     * @brief Outputs the mix buffer to the sink
+     */
+    struct SinkCommand {};
+
+    using Command = std::variant<ClearMixCommand, DataSourceCommand, BiquadFilterCommand, VolumeMixCommand, DepopPrepareCommand, DepopForMixCommand, SinkCommand>;
+
+    /**
+     * @brief A flat list of commands which renders a single frame, it's modelled on the command lists HOS submits to the ADSP
+     * @note All commands operating on the same voice are contiguous and the voices of separate runs of voice commands are disjoint, this allows backends to render voices in parallel
+     */
+    using CommandList = std::vector<Command>;
+
+    /**
+     * @brief The state which commands are executed against
+     */
+    struct CommandContext {
+        span<i16> mix; //!< The mix buffer, this is a whole frame of interleaved samples
+        std::array<float, constant::ChannelCount> &depop; //!< The depop accumulator, this persists across frames while it decays
+        SampleBuffer *sink; //!< The buffer that the sink outputs to, this may be null if outputting is skipped
+        std::chrono::steady_clock::time_point deadline; //!< The time by which the frame must be rendered
+        bool voiceDropEnable; //!< If voices which are rendered after the deadline has passed are dropped
+        FrameMetrics metrics{}; //!< The timings of executing the commands, these are accumulated by the backend
+    };
+
+    /**
+     * @brief An interface for executing command lists
+     */
+    class CommandBackend {
+      public:
+        virtual ~CommandBackend() = default;
+
+        /**
+         * @brief Executes all commands in the list, the result must match executing them in order aside from where saturation is applied when mixing
+         */
+        virtual void Execute(const CommandList &commands, CommandContext &context) = 0;
+    };
+
+    /**
+     * @brief A backend which executes command lists on the CPU, runs of voice commands with many voices are split across a thread pool
+     */
+    class CpuCommandBackend : public CommandBackend {
+      private:
+        static constexpr size_t ParallelVoiceThreshold{32}; //!< The amount of voices in a run above which it's executed in parallel, below this the overhead of dispatching to the workers outweighs the gains
+        static constexpr size_t PartitionCount{4}; //!< The amount of partitions that a run of voices is split into when executing it in parallel
+
+        std::unique_ptr<ThreadPool> pool; //!< The workers for executing voices in parallel, this is created when the threshold is first exceeded
+        std::vector<SampleBuffer> partitionMixes; //!< The per-partition mix buffers that voices are mixed into when executing them in parallel
+        std::vector<std::pair<size_t, size_t>> voiceRanges; //!< The command ranges of every voice in the current run, this is only a member to retain its capacity
+
+        static void ExecuteCommand(const Command &command, CommandContext &context);
+
+        /**
+         * @brief Executes the voice ranges in voiceRanges across the pool, every partition mixes into its own buffer and these are reduced into the context afterwards
+         */
+        void ExecuteParallel(const CommandList &commands, CommandContext &context);
+
+      public:
+        void Execute(const CommandList &commands, CommandContext &context) override;
+    };
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "performance.h"
+
+namespace skyline::service::audio::IAudioRenderer {
+    constexpr u32 PerformanceMagic{util::MakeMagic<u32>("PERF")};
+
+    static u32 ToMicroseconds(i64 nanoseconds) {
+        return static_cast<u32>(nanoseconds / 1000);
+    }
+
+    void PerformanceManager::Record(const FrameMetrics &metrics) {
+        TRACE_COUNTER("audio", perfetto::CounterTrack("Audio Voice Time", "ns"), metrics.voiceTime);
+        TRACE_COUNTER("audio", perfetto::CounterTrack("Audio Mix Time", "ns"), metrics.mixTime);
+        TRACE_COUNTER("audio", perfetto::CounterTrack("Audio Sink Time", "ns"), metrics.sinkTime);
+        TRACE_COUNTER("audio", perfetto::CounterTrack("Audio Dropped Voices"), metrics.droppedVoices);
+
+        if (!historyLimit)
+            return;
+
+        if (history.size() == historyLimit)
+            history.pop_front();
+        history.emplace_back(metrics, frameIndex++);
+    }
+
+    template<typename FrameHeader, typename Entry>
+    size_t PerformanceManager::WriteFrames(span<u8> output) {
+        constexpr size_t EntryCount{3};
+        constexpr size_t FrameSize{sizeof(FrameHeader) + (sizeof(Entry) * EntryCount)};
+
+        size_t offset{};
+        while (!history.empty() && offset + FrameSize <= output.size()) {
+            const auto &[metrics, index]{history.front()};
+
+            FrameHeader header{
+                .magic = PerformanceMagic,
+                .entryCount = EntryCount,
+                .nextOffset = FrameSize,
+                .totalProcessingTime = ToMicroseconds(metrics.voiceTime + metrics.mixTime + metrics.sinkTime),
+            };
+            header.frameIndex = index;
+            if constexpr (std::is_same_v<FrameHeader, PerformanceFrameHeaderV2>) {
+                header.voicesDropped = metrics.droppedVoices;
+                header.startTime = static_cast<u64>(metrics.startTime / 1000);
+                header.renderTimeExceeded = metrics.deadlineExceeded;
+            }
+            output.subspan(offset).as<FrameHeader>() = header;
+            offset += sizeof(FrameHeader);
+
+            // The phases are laid out in the order they're executed in, voices are processed between clearing the mix buffer and mixing in depop samples
+            std::array<std::pair<PerformanceEntryType, i64>, EntryCount> phases{{
+                {PerformanceEntryType::Voice, metrics.voiceTime},
+                {PerformanceEntryType::FinalMix, metrics.mixTime},
+                {PerformanceEntryType::Sink, metrics.sinkTime},
+            }};
+            i64 phaseStart{};
+            for (const auto &[type, time] : phases) {
+                Entry entry{
+                    .startTime = ToMicroseconds(phaseStart),
+                    .processedTime = ToMicroseconds(time),
+                    .entryType = type,
+                };
+                output.subspan(offset).as<Entry>() = entry;
+                offset += sizeof(Entry);
+                phaseStart += time;
+            }
+
+            history.pop_front();
+        }
+
+        return offset;
+    }
+
+    size_t PerformanceManager::Write(span<u8> output, bool useV2) {
+        if (useV2)
+            return WriteFrames<PerformanceFrameHeaderV2, PerformanceEntryV2>(output);
+        else
+            return WriteFrames<PerformanceFrameHeaderV1, PerformanceEntryV1>(output);
+    }
+}
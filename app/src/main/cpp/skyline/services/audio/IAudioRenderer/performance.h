@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::service::audio::IAudioRenderer {
+    enum class PerformanceEntryType : u8 {
+        Invalid = 0,
+        Voice = 1,
+        SubMix = 2,
+        FinalMix = 3,
+        Sink = 4,
+    };
+
+    /**
+     * @brief The header of a frame in the performance buffer which is followed by its entries
+     */
+    struct PerformanceFrameHeaderV1 {
+        u32 magic; //!< "PERF"
+        u32 entryCount;
+        u32 detailCount;
+        u32 nextOffset; //!< The offset of the next frame relative to this header
+        u32 totalProcessingTime; //!< The time it took to render the frame in microseconds
+        u32 frameIndex;
+    };
+    static_assert(sizeof(PerformanceFrameHeaderV1) == 0x18);
+
+    struct PerformanceFrameHeaderV2 {
+        u32 magic; //!< "PERF"
+        u32 entryCount;
+        u32 detailCount;
+        u32 nextOffset; //!< The offset of the next frame relative to this header
+        u32 totalProcessingTime; //!< The time it took to render the frame in microseconds
+        u32 voicesDropped;
+        u64 startTime; //!< The time at which rendering the frame started in microseconds
+        u32 frameIndex;
+        bool renderTimeExceeded;
+        u8 _pad0_[0xB];
+    };
+    static_assert(sizeof(PerformanceFrameHeaderV2) == 0x30);
+
+    struct PerformanceEntryV1 {
+        u32 nodeId;
+        u32 startTime; //!< The time at which processing the node started relative to the start of the frame in microseconds
+        u32 processedTime; //!< The time it took to process the node in microseconds
+        PerformanceEntryType entryType;
+        u8 _pad0_[0x3];
+    };
+    static_assert(sizeof(PerformanceEntryV1) == 0x10);
+
+    struct PerformanceEntryV2 {
+        u32 nodeId;
+        u32 startTime; //!< The time at which processing the node started relative to the start of the frame in microseconds
+        u32 processedTime; //!< The time it took to process the node in microseconds
+        PerformanceEntryType entryType;
+        u8 _pad0_[0xB];
+    };
+    static_assert(sizeof(PerformanceEntryV2) == 0x18);
+
+    /**
+     * @brief The performance manager status that's written into the output of RequestUpdate
+     */
+    struct PerformanceManagerOut {
+        u32 historySize; //!< The amount of bytes written into the performance buffer
+        u32 _pad0_[3];
+    };
+    static_assert(sizeof(PerformanceManagerOut) == 0x10);
+
+    /**
+     * @brief The timings of rendering a single frame
+     */
+    struct FrameMetrics {
+        i64 startTime; //!< The time at which rendering started in nanoseconds
+        i64 voiceTime; //!< The time spent processing voices in nanoseconds
+        i64 mixTime; //!< The time spent on clearing the mix buffer and mixing depop samples into it in nanoseconds
+        i64 sinkTime; //!< The time spent outputting the mix buffer in nanoseconds
+        u32 droppedVoices; //!< The amount of voices that were dropped due to exceeding the render deadline
+        bool deadlineExceeded;
+    };
+
+    /**
+     * @brief The PerformanceManager class keeps a history of frame timings to report to the guest and emits them as trace counters
+     * @note Entries are aggregated per phase rather than per node as the renderer doesn't track the nodes of voices, sub-mixes and sinks individually
+     */
+    class PerformanceManager {
+      private:
+        std::deque<std::pair<FrameMetrics, u32>> history; //!< The metrics of the frames which weren't written to the guest yet alongside their frame index
+        size_t historyLimit; //!< The maximum amount of frames retained in the history, older frames are discarded
+        u32 frameIndex{};
+
+        template<typename FrameHeader, typename Entry>
+        size_t WriteFrames(span<u8> output);
+
+      public:
+        /**
+         * @param historyLimit The amount of frames to retain, this is the performance manager count in the renderer parameters
+         */
+        PerformanceManager(size_t historyLimit) : historyLimit(historyLimit) {}
+
+        /**
+         * @brief Records the metrics of a rendered frame and emits them as trace counters
+         */
+        void Record(const FrameMetrics &metrics);
+
+        /**
+         * @brief Writes as much of the history into a guest performance buffer as fits and removes the written frames from it
+         * @param useV2 If the performance metrics data format V2 is used
+         * @return The amount of bytes written
+         */
+        size_t Write(span<u8> output, bool useV2);
+    };
+}
@@ -2,6 +2,7 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <kernel/types/KProcess.h>
+#include <audio/mix.h>
 #include "voice.h"
 
 namespace skyline::service::audio::IAudioRenderer {
@@ -22,6 +23,9 @@ namespace skyline::service::audio::IAudioRenderer {
             output.playedSamplesCount = 0;
             output.playedWaveBuffersCount = 0;
             output.voiceDropsCount = 0;
+            previousVolume = 0.0f;
+            biquadStates = {};
+            resampler.Reset();
         }
 
         acquired = input.acquired;
@@ -40,19 +44,19 @@ namespace skyline::service::audio::IAudioRenderer {
                 throw exception("Unsupported voice channel count: {}", input.channelCount);
 
             channelCount = static_cast<u8>(input.channelCount);
+            biquadStates = {};
+            resampler.Reset();
 
-            if (input.format == skyline::audio::AudioFormat::ADPCM) {
-                std::vector<std::array<i16, 2>> adpcmCoefficients(input.adpcmCoeffsSize / (sizeof(u16) * 2));
-                span(adpcmCoefficients).copy_from(span(input.adpcmCoeffs, input.adpcmCoeffsSize / sizeof(u32)));
-
-                adpcmDecoder = skyline::audio::AdpcmDecoder(std::move(adpcmCoefficients));
-            }
+            if (input.format == skyline::audio::AudioFormat::ADPCM)
+                adpcmDecoder.SetCoefficients(span(reinterpret_cast<const std::array<i16, 2> *>(input.adpcmCoeffs), input.adpcmCoeffsSize / sizeof(std::array<i16, 2>)));
 
             SetWaveBufferIndex(static_cast<u8>(input.baseWaveBufferIndex));
         }
 
         waveBuffers = input.waveBuffers;
         volume = input.volume;
+        priority = input.priority;
+        biquadFilters = input.biquadFilters;
         playbackState = input.playbackState;
     }
 
@@ -68,26 +72,25 @@ namespace skyline::service::audio::IAudioRenderer {
                 samples.resize(currentBuffer.size / sizeof(i16));
                 span(samples).copy_from(buffer);
                 break;
-            case skyline::audio::AudioFormat::ADPCM: {
-                samples = adpcmDecoder->Decode(buffer);
+            case skyline::audio::AudioFormat::ADPCM:
+                samples.resize(skyline::audio::AdpcmDecoder::GetDecodedSize(currentBuffer.size));
+                samples.resize(adpcmDecoder.Decode(buffer, samples));
                 break;
-            }
             default:
                 throw exception("Unsupported PCM format used by Voice: {}", format);
         }
 
-        if (sampleRate != constant::SampleRate)
-            samples = resampler.ResampleBuffer(samples, static_cast<double>(sampleRate) / constant::SampleRate, channelCount);
+        if (sampleRate != constant::SampleRate) {
+            auto ratio{static_cast<double>(sampleRate) / constant::SampleRate};
+            scratchSamples.resize(skyline::audio::Resampler::GetMaxOutputSize(samples.size(), ratio, channelCount));
+            scratchSamples.resize(resampler.Resample(samples, scratchSamples, ratio, channelCount));
+            std::swap(samples, scratchSamples);
+        }
 
         if (channelCount == 1 && constant::ChannelCount != channelCount) {
-            auto originalSize{samples.size()};
-            samples.resize((originalSize / channelCount) * constant::ChannelCount);
-
-            for (auto monoIndex{originalSize - 1}, targetIndex{samples.size()}; monoIndex > 0; monoIndex--) {
-                auto sample{samples[monoIndex]};
-                for (u8 i{}; i < constant::ChannelCount; i++)
-                    samples[--targetIndex] = sample;
-            }
+            scratchSamples.resize(samples.size() * constant::ChannelCount);
+            skyline::audio::UpmixMonoToStereo(scratchSamples, samples);
+            std::swap(samples, scratchSamples);
         }
     }
 
@@ -124,4 +127,24 @@ namespace skyline::service::audio::IAudioRenderer {
 
         return samples;
     }
+
+    void Voice::Render() {
+        renderedSize = 0;
+        if (!Playable())
+            return;
+
+        u32 pendingSamples{constant::MixBufferSize};
+        while (pendingSamples > 0) {
+            u32 voiceBufferOffset{};
+            u32 voiceBufferSize{};
+            auto &voiceSamples{GetBufferData(pendingSamples, voiceBufferOffset, voiceBufferSize)};
+
+            if (voiceBufferSize == 0)
+                break;
+
+            pendingSamples -= voiceBufferSize / constant::ChannelCount;
+            std::copy_n(voiceSamples.begin() + voiceBufferOffset, voiceBufferSize, renderedSamples.begin() + renderedSize);
+            renderedSize += voiceBufferSize;
+        }
+    }
 }
@@ -76,9 +76,10 @@ namespace skyline::service::audio::IAudioRenderer {
       private:
         const DeviceState &state;
         std::array<WaveBuffer, 4> waveBuffers;
-        std::vector<i16> samples; //!< A vector containing processed sample data
+        std::vector<i16> samples; //!< A vector containing processed sample data, this is reused across wave buffers so it retains its capacity
         skyline::audio::Resampler resampler; //!< The resampler object used for changing the sample rate of a wave buffer's stream
-        std::optional<skyline::audio::AdpcmDecoder> adpcmDecoder;
+        std::vector<i16> scratchSamples; //!< A scratch buffer for processing sample data out-of-place, it's swapped with samples so both retain their capacity across wave buffers
+        skyline::audio::AdpcmDecoder adpcmDecoder;
 
         bool acquired{false}; //!< If the voice is in use
         bool bufferReload{true};
@@ -103,6 +104,16 @@ namespace skyline::service::audio::IAudioRenderer {
       public:
         VoiceOut output{};
         float volume{};
+        u32 priority{}; //!< The priority of the voice, voices with a lower value are rendered first and are the last to be dropped
+        std::array<BiquadFilter, 2> biquadFilters{};
+
+        /* State owned by the commands rendering the voice */
+        std::array<i16, constant::MixBufferSize * constant::ChannelCount> renderedSamples{}; //!< The samples of the voice for the frame that's being rendered
+        u32 renderedSize{}; //!< The amount of valid samples in renderedSamples, this is lower than the size of a frame if the voice ran out of data
+        float previousVolume{}; //!< The volume the voice was last mixed at, the mixing volume is ramped from this to the current volume to avoid discontinuities
+        std::array<std::array<std::array<i64, 2>, constant::ChannelCount>, 2> biquadStates{}; //!< The state of each biquad filter for each channel
+        std::array<i16, constant::ChannelCount> lastSamples{}; //!< The last frame that was mixed after applying the volume, this is used for depopping
+        bool mixed{}; //!< If the voice was mixed in the last frame and hasn't been depopped since
 
         Voice(const DeviceState &state);
 
@@ -119,6 +130,11 @@ namespace skyline::service::audio::IAudioRenderer {
          */
         std::vector<i16> &GetBufferData(u32 maxSamples, u32 &outOffset, u32 &outSize);
 
+        /**
+         * @brief Renders the next frame of the voice's sample data into renderedSamples
+         */
+        void Render();
+
         /**
          * @return If the voice is currently playable
          */
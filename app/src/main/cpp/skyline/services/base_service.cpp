@@ -20,19 +20,19 @@ namespace skyline::service {
     }
 
     Result service::BaseService::HandleRequest(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        ServiceFunctionDescriptor function;
-        try {
-            function = GetServiceFunction(request.payload->value);
-            Logger::DebugNoPrefix("Service: {}", function.name);
-        } catch (const std::out_of_range &) {
+        auto function{GetServiceFunction(request.payload->value)};
+        if (!function) [[unlikely]] {
             Logger::Warn("Cannot find function in service '{0}': 0x{1:X} ({1})", GetName(), static_cast<u32>(request.payload->value));
             return {};
         }
-        TRACE_EVENT("service", perfetto::StaticString{function.name});
+        Logger::DebugNoPrefix("Service: {}", function->name);
+
+        TRACE_EVENT("service", perfetto::StaticString{function->name});
+        trace::LatencyScope latencyScope{function->name};
         try {
-            return function(session, request, response);
+            return (*function)(session, request, response);
         } catch (const std::exception &e) {
-            throw exception("{} (Service: {})", e.what(), function.name);
+            throw exception("{} (Service: {})", e.what(), function->name);
         }
     }
 }
@@ -17,12 +17,14 @@ Result CallBaseFunction(type::KSession &session, ipc::IpcRequest &request, ipc::
 }                                                                                                              \
 SERVICE_DECL_AUTO(functions, frozen::make_unordered_map({__VA_ARGS__}));                                          \
 protected:                                                                                                     \
-ServiceFunctionDescriptor GetServiceFunction(u32 id) override {                                                \
-    auto& function{functions.at(id)};                                                                          \
+std::optional<ServiceFunctionDescriptor> GetServiceFunction(u32 id) override {                                 \
+    auto function{functions.find(id)};                                                                         \
+    if (function == functions.end()) [[unlikely]]                                                              \
+        return std::nullopt;                                                                                   \
     return ServiceFunctionDescriptor{                                                                          \
         reinterpret_cast<DerivedService*>(this),                                                               \
-        reinterpret_cast<decltype(ServiceFunctionDescriptor::function)>(function.first),                       \
-        function.second                                                                                        \
+        reinterpret_cast<decltype(ServiceFunctionDescriptor::function)>(function->second.first),               \
+        function->second.second                                                                                \
     };                                                                                                         \
 }
 #define SRVREG(class, ...) std::make_shared<class>(state, manager, ##__VA_ARGS__)
@@ -71,8 +73,20 @@ namespace skyline::service {
          */
         virtual ~BaseService() = default;
 
-        virtual ServiceFunctionDescriptor GetServiceFunction(u32 id) {
-            throw std::out_of_range("GetServiceFunction not implemented");
+        /**
+         * @return The descriptor of the function corresponding to the supplied command ID or std::nullopt if the service doesn't implement it
+         * @note This is implemented by SERVICE_DECL as a lookup into a perfect hash table generated at compile-time, misses are returned rather than thrown as games frequently call unimplemented commands
+         */
+        virtual std::optional<ServiceFunctionDescriptor> GetServiceFunction(u32 id) {
+            return std::nullopt;
+        }
+
+        /**
+         * @return If requests to this service may block the calling thread on the host, the calling guest thread is removed from its core's queue while such requests are handled so other guest threads can run on the core in the meantime
+         * @note Services that only do short non-blocking work should override this to return false, this avoids the cost of rescheduling the thread on every request
+         */
+        virtual bool IsBlocking() {
+            return true;
         }
 
         /**
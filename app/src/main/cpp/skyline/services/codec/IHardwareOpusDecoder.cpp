@@ -11,19 +11,29 @@ namespace skyline::service::codec {
         return util::AlignUp(static_cast<u32>(frameSize * channelCount / (OpusFullbandSampleRate / sampleRate)), 0x40);
     }
 
-    IHardwareOpusDecoder::IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, u32 workBufferSize, KHandle workBufferHandle)
+    u32 CalculateWorkBufferSize(i32 sampleRate, i32 channelCount, i32 streamCount, i32 stereoStreamCount) {
+        u32 requiredSize{static_cast<u32>(opus_multistream_decoder_get_size(streamCount, stereoStreamCount))};
+        requiredSize += MaxInputBufferSize + CalculateOutBufferSize(sampleRate, channelCount, MaxFrameSizeNormal);
+        return requiredSize;
+    }
+
+    IHardwareOpusDecoder::IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, i32 streamCount, i32 stereoStreamCount, span<const u8> mappings, u32 workBufferSize, KHandle workBufferHandle)
         : BaseService(state, manager),
           sampleRate(sampleRate),
           channelCount(channelCount),
-          workBuffer(state.process->GetHandle<kernel::type::KTransferMemory>(workBufferHandle)),
-          decoderOutputBufferSize(CalculateOutBufferSize(sampleRate, channelCount, MaxFrameSizeNormal)) {
-        if (workBufferSize < decoderOutputBufferSize)
-            throw exception("Work Buffer doesn't have adequate space for Opus Decoder: 0x{:X} (Required: 0x{:X})", workBufferSize, decoderOutputBufferSize);
-
-        // We utilize the guest-supplied work buffer for allocating the OpusDecoder object into
-        decoderState = reinterpret_cast<OpusDecoder *>(workBuffer->host.ptr);
-
-        if (int result = opus_decoder_init(decoderState, sampleRate, channelCount) != OPUS_OK)
+          workBuffer(state.process->GetHandle<kernel::type::KTransferMemory>(workBufferHandle)) {
+        auto decoderSize{opus_multistream_decoder_get_size(streamCount, stereoStreamCount)};
+        if (decoderSize <= 0)
+            throw exception("Invalid Opus stream configuration: {} streams ({} stereo)", streamCount, stereoStreamCount);
+        if (workBufferSize < static_cast<u32>(decoderSize) || workBuffer->host.size() < static_cast<size_t>(decoderSize))
+            throw exception("Work Buffer doesn't have adequate space for Opus Decoder: 0x{:X} (Required: 0x{:X})", workBufferSize, decoderSize);
+        if (mappings.size() < static_cast<size_t>(channelCount))
+            throw exception("Opus channel mappings are missing: {} (Required: {})", mappings.size(), channelCount);
+
+        // We utilize the guest-supplied work buffer for allocating the OpusMSDecoder object into
+        decoderState = reinterpret_cast<OpusMSDecoder *>(workBuffer->host.ptr);
+
+        if (int result{opus_multistream_decoder_init(decoderState, sampleRate, channelCount, streamCount, stereoStreamCount, mappings.data())}; result != OPUS_OK)
             throw OpusException(result);
     }
 
@@ -44,7 +54,7 @@ namespace skyline::service::codec {
     }
 
     void IHardwareOpusDecoder::ResetContext() {
-        opus_decoder_ctl(decoderState, OPUS_RESET_STATE);
+        opus_multistream_decoder_ctl(decoderState, OPUS_RESET_STATE);
     }
 
     Result IHardwareOpusDecoder::DecodeInterleavedImpl(ipc::IpcRequest &request, ipc::IpcResponse &response, bool writeDecodeTime) {
@@ -54,22 +64,46 @@ namespace skyline::service::codec {
         if (dataIn.size() <= sizeof(OpusDataHeader))
             throw exception("Incorrect Opus data size: 0x{:X} (Should be > 0x{:X})", dataIn.size(), sizeof(OpusDataHeader));
 
-        i32 opusPacketSize{dataIn.as<OpusDataHeader>().GetPacketSize()};
-        i32 requiredInSize{opusPacketSize + static_cast<i32>(sizeof(OpusDataHeader))};
-        if (opusPacketSize > MaxInputBufferSize || dataIn.size() < requiredInSize)
-            throw exception("Opus packet size mismatch: 0x{:X} (Requested: 0x{:X})", dataIn.size() - sizeof(OpusDataHeader), opusPacketSize);
-
-        // Skip past the header in the input buffer to get the Opus packet
-        auto sampleDataIn = dataIn.subspan(sizeof(OpusDataHeader));
-
+        i32 consumedSize{}, decodedCount{};
+        size_t outputOffset{};
         auto perfTimer{timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs())};
-        i32 decodedCount{opus_decode(decoderState, sampleDataIn.data(), opusPacketSize, dataOut.data(), static_cast<int>(decoderOutputBufferSize), false)};
+        while (dataIn.size() - static_cast<size_t>(consumedSize) > sizeof(OpusDataHeader)) {
+            // Only the first packet is required to be valid, decoding stops at any data following it which isn't a packet that fits into the output
+            bool firstPacket{consumedSize == 0};
+            auto packetIn{dataIn.subspan(static_cast<size_t>(consumedSize))};
+
+            i32 opusPacketSize{packetIn.as<OpusDataHeader>().GetPacketSize()};
+            i32 requiredInSize{opusPacketSize + static_cast<i32>(sizeof(OpusDataHeader))};
+            if (opusPacketSize <= 0 || opusPacketSize > MaxInputBufferSize || packetIn.size() < static_cast<size_t>(requiredInSize)) {
+                if (firstPacket)
+                    throw exception("Opus packet size mismatch: 0x{:X} (Requested: 0x{:X})", packetIn.size() - sizeof(OpusDataHeader), opusPacketSize);
+                break;
+            }
+
+            // Skip past the header in the input buffer to get the Opus packet
+            auto sampleDataIn{packetIn.subspan(sizeof(OpusDataHeader), static_cast<size_t>(opusPacketSize))};
+
+            // The amount of samples in the packet is known upfront, so it can be decoded directly into the output buffer when it fits
+            i32 frameSize{opus_packet_get_nb_samples(sampleDataIn.data(), opusPacketSize, sampleRate)};
+            if (frameSize < 0 || outputOffset + static_cast<size_t>(frameSize * channelCount) > dataOut.size()) {
+                if (!firstPacket)
+                    break;
+                if (frameSize < 0)
+                    throw OpusException(frameSize);
+                throw exception("Opus output buffer is too small: 0x{:X} (Required: 0x{:X})", dataOut.size_bytes(), static_cast<size_t>(frameSize * channelCount) * sizeof(opus_int16));
+            }
+
+            i32 packetDecodedCount{opus_multistream_decode(decoderState, sampleDataIn.data(), opusPacketSize, dataOut.data() + outputOffset, frameSize, false)};
+            if (packetDecodedCount < 0)
+                throw OpusException(packetDecodedCount);
+
+            outputOffset += static_cast<size_t>(packetDecodedCount * channelCount);
+            consumedSize += requiredInSize; // Decoded data size is equal to opus packet size + header
+            decodedCount += packetDecodedCount;
+        }
         perfTimer = timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs()) - perfTimer;
 
-        if (decodedCount < 0)
-            throw OpusException(decodedCount);
-
-        response.Push(requiredInSize); // Decoded data size is equal to opus packet size + header
+        response.Push(consumedSize);
         response.Push(decodedCount);
         if (writeDecodeTime)
             response.Push<i64>(perfTimer.Microseconds());
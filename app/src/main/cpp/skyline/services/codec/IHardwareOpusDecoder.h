@@ -4,6 +4,7 @@
 #pragma once
 
 #include <opus.h>
+#include <opus_multistream.h>
 
 #include <common.h>
 #include <services/base_service.h>
@@ -15,6 +16,11 @@ namespace skyline::service::codec {
      */
     u32 CalculateOutBufferSize(i32 sampleRate, i32 channelCount, i32 frameSize);
 
+    /**
+     * @return The required work buffer size for a decoder with the given parameters
+     */
+    u32 CalculateWorkBufferSize(i32 sampleRate, i32 channelCount, i32 streamCount, i32 stereoStreamCount);
+
     static constexpr i32 OpusFullbandSampleRate{48000};
     static constexpr i32 MaxFrameSizeNormal{static_cast<u32>(OpusFullbandSampleRate * 0.040f)}; //!< 40ms frame size limit for normal decoders
     static constexpr i32 MaxFrameSizeEx{static_cast<u32>(OpusFullbandSampleRate * 0.120f)}; //!< 120ms frame size limit for ex decoders added in 12.0.0
@@ -22,15 +28,15 @@ namespace skyline::service::codec {
 
     /**
      * @note The Switch has a HW Opus Decoder which this service would interface with, we emulate it using libopus with CPU-decoding
+     * @note All decoders use the libopus multistream decoder, regular decoders are a single stream which is coupled if they're stereo
      * @url https://switchbrew.org/wiki/Audio_services#IHardwareOpusDecoder
      */
     class IHardwareOpusDecoder : public BaseService {
       private:
         std::shared_ptr<kernel::type::KTransferMemory> workBuffer;
-        OpusDecoder *decoderState{};
+        OpusMSDecoder *decoderState{};
         i32 sampleRate;
         i32 channelCount;
-        u32 decoderOutputBufferSize;
 
         /**
          * @brief Holds information about the Opus packet to be decoded
@@ -54,11 +60,15 @@ namespace skyline::service::codec {
 
         /**
          * @brief Decodes Opus source data via libopus
+         * @note The input may contain multiple consecutive packets, these are decoded in a single request for as long as their output fits into the output buffer
          */
         Result DecodeInterleavedImpl(ipc::IpcRequest &request, ipc::IpcResponse &response, bool writeDecodeTime = false);
 
       public:
-        IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, u32 workBufferSize, KHandle workBufferHandle);
+        /**
+         * @param mappings The mapping of each output channel to a decoded channel, this is only used for multistream decoders
+         */
+        IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, i32 streamCount, i32 stereoStreamCount, span<const u8> mappings, u32 workBufferSize, KHandle workBufferHandle);
 
         /**
          * @brief Decodes the Opus source data, returns decoded data size and decoded sample count
@@ -7,12 +7,6 @@
 #include "IHardwareOpusDecoder.h"
 
 namespace skyline::service::codec {
-    static u32 CalculateBufferSize(i32 sampleRate, i32 channelCount) {
-        u32 requiredSize{static_cast<u32>(opus_decoder_get_size(channelCount))};
-        requiredSize += MaxInputBufferSize + CalculateOutBufferSize(sampleRate, channelCount, MaxFrameSizeNormal);
-        return requiredSize;
-    }
-
     Result IHardwareOpusDecoderManager::OpenHardwareOpusDecoder(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         i32 sampleRate{request.Pop<i32>()};
         i32 channelCount{request.Pop<i32>()};
@@ -21,7 +15,9 @@ namespace skyline::service::codec {
 
         Logger::Debug("Creating Opus decoder: Sample rate: {}, Channel count: {}, Work buffer handle: 0x{:X} (Size: 0x{:X})", sampleRate, channelCount, workBuffer, workBufferSize);
 
-        manager.RegisterService(std::make_shared<IHardwareOpusDecoder>(state, manager, sampleRate, channelCount, workBufferSize, workBuffer), session, response);
+        // A regular decoder is a single stream which is coupled for stereo, the channels are mapped directly to the decoded channels
+        constexpr std::array<u8, 2> Mappings{0, 1};
+        manager.RegisterService(std::make_shared<IHardwareOpusDecoder>(state, manager, sampleRate, channelCount, 1, channelCount > 1 ? 1 : 0, Mappings, workBufferSize, workBuffer), session, response);
         return {};
     }
 
@@ -29,7 +25,28 @@ namespace skyline::service::codec {
         i32 sampleRate{request.Pop<i32>()};
         i32 channelCount{request.Pop<i32>()};
 
-        response.Push<u32>(CalculateBufferSize(sampleRate, channelCount));
+        response.Push<u32>(CalculateWorkBufferSize(sampleRate, channelCount, 1, channelCount > 1 ? 1 : 0));
+        return {};
+    }
+
+    Result IHardwareOpusDecoderManager::OpenHardwareOpusDecoderForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        u32 workBufferSize{request.Pop<u32>()};
+        KHandle workBuffer{request.copyHandles.at(0)};
+        auto &parameters{request.inputBuf.at(0).as<MultiStreamParameters>()};
+
+        Logger::Debug("Creating Opus multistream decoder: Sample rate: {}, Channel count: {}, Stream count: {} ({} stereo), Work buffer handle: 0x{:X} (Size: 0x{:X})", parameters.sampleRate, parameters.channelCount, parameters.streamCount, parameters.stereoStreamCount, workBuffer, workBufferSize);
+
+        if (parameters.channelCount <= 0 || static_cast<size_t>(parameters.channelCount) > parameters.mappings.size())
+            throw exception("Invalid Opus multistream channel count: {}", parameters.channelCount);
+
+        manager.RegisterService(std::make_shared<IHardwareOpusDecoder>(state, manager, parameters.sampleRate, parameters.channelCount, parameters.streamCount, parameters.stereoStreamCount, span(parameters.mappings).first(static_cast<size_t>(parameters.channelCount)), workBufferSize, workBuffer), session, response);
+        return {};
+    }
+
+    Result IHardwareOpusDecoderManager::GetWorkBufferSizeForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto &parameters{request.inputBuf.at(0).as<MultiStreamParameters>()};
+
+        response.Push<u32>(CalculateWorkBufferSize(parameters.sampleRate, parameters.channelCount, parameters.streamCount, parameters.stereoStreamCount));
         return {};
     }
 }
@@ -39,9 +39,23 @@ namespace skyline::service::codec {
          */
         Result GetWorkBufferSize(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        /**
+         * @brief Returns an IHardwareOpusDecoder object which decodes multiple Opus streams, this is used for surround audio
+         * @url https://switchbrew.org/wiki/Audio_services#OpenHardwareOpusDecoderForMultiStream
+         */
+        Result OpenHardwareOpusDecoderForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Returns the required size for a multistream decoder's work buffer
+         * @url https://switchbrew.org/wiki/Audio_services#GetWorkBufferSizeForMultiStream
+         */
+        Result GetWorkBufferSizeForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
         SERVICE_DECL(
             SFUNC(0x0, IHardwareOpusDecoderManager, OpenHardwareOpusDecoder),
             SFUNC(0x1, IHardwareOpusDecoderManager, GetWorkBufferSize),
+            SFUNC(0x2, IHardwareOpusDecoderManager, OpenHardwareOpusDecoderForMultiStream),
+            SFUNC(0x3, IHardwareOpusDecoderManager, GetWorkBufferSizeForMultiStream),
         )
     };
 }
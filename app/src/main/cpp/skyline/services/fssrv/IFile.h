@@ -29,7 +29,7 @@ namespace skyline::service::fssrv {
         Result Write(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
         /**
-         * @brief Flushes any written data to the IFile on the Switch, however the emulator processes any FS event immediately so this does nothing
+         * @brief Flushes any written data to the IFile, this writes back any writes buffered for save data
          */
         Result Flush(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
@@ -1,13 +1,15 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <vfs/read_ahead_backing.h>
+#include <vfs/write_back_backing.h>
 #include "results.h"
 #include "IFile.h"
 #include "IDirectory.h"
 #include "IFileSystem.h"
 
 namespace skyline::service::fssrv {
-    IFileSystem::IFileSystem(std::shared_ptr<vfs::FileSystem> backing, const DeviceState &state, ServiceManager &manager) : backing(std::move(backing)), BaseService(state, manager) {}
+    IFileSystem::IFileSystem(std::shared_ptr<vfs::FileSystem> backing, const DeviceState &state, ServiceManager &manager, bool bufferWrites) : backing(std::move(backing)), bufferWrites(bufferWrites), BaseService(state, manager) {}
 
     Result IFileSystem::CreateFile(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         std::string path(request.inputBuf.at(0).as_string(true));
@@ -41,8 +43,18 @@ namespace skyline::service::fssrv {
         auto file{backing->OpenFileUnchecked(path, mode)};
         if (file == nullptr)
             return result::UnexpectedFailure;
-        else
-            manager.RegisterService(std::make_shared<IFile>(std::move(file), state, manager), session, response);
+
+        // Read-only files are commonly streamed so sequential reads from them are prefetched
+        if (!mode.write && !mode.append) {
+            file = std::make_shared<vfs::ReadAheadBacking>(std::move(file));
+        } else if (bufferWrites) {
+            file = std::make_shared<vfs::WriteBackBacking>(std::move(file));
+
+            std::scoped_lock lock{writableFilesMutex};
+            std::erase_if(writableFiles, [](const auto &writableFile) { return writableFile.expired(); });
+            writableFiles.emplace_back(file);
+        }
+        manager.RegisterService(std::make_shared<IFile>(std::move(file), state, manager), session, response);
 
         return {};
     }
@@ -61,6 +73,17 @@ namespace skyline::service::fssrv {
     }
 
     Result IFileSystem::Commit(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::vector<std::shared_ptr<vfs::Backing>> files;
+        {
+            std::scoped_lock lock{writableFilesMutex};
+            std::erase_if(writableFiles, [](const auto &writableFile) { return writableFile.expired(); });
+            for (const auto &writableFile : writableFiles)
+                if (auto file{writableFile.lock()})
+                    files.push_back(std::move(file));
+        }
+
+        for (const auto &file : files)
+            file->Flush();
         return {};
     }
 }
@@ -14,9 +14,15 @@ namespace skyline::service::fssrv {
     class IFileSystem : public BaseService {
       private:
         std::shared_ptr<vfs::FileSystem> backing;
+        bool bufferWrites; //!< If writes to files are buffered in memory till the filesystem is committed or the file is flushed or closed
+        std::mutex writableFilesMutex; //!< Synchronizes access to writableFiles
+        std::vector<std::weak_ptr<vfs::Backing>> writableFiles; //!< All files opened as writable while writes are buffered, these are flushed on committing
 
       public:
-        IFileSystem(std::shared_ptr<vfs::FileSystem> backing, const DeviceState &state, ServiceManager &manager);
+        /**
+         * @param bufferWrites If writes should be buffered, this is used for save data which is only guaranteed to be persisted on committing
+         */
+        IFileSystem(std::shared_ptr<vfs::FileSystem> backing, const DeviceState &state, ServiceManager &manager, bool bufferWrites = false);
 
         /**
          * @brief Creates a file at the specified path in the filesystem
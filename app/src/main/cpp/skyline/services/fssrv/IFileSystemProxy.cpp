@@ -3,6 +3,7 @@
 
 #include <os.h>
 #include <vfs/os_filesystem.h>
+#include <vfs/read_ahead_backing.h>
 #include <loader/loader.h>
 #include "results.h"
 #include "IStorage.h"
@@ -57,7 +58,7 @@ namespace skyline::service::fssrv {
             }
         }()};
 
-        manager.RegisterService(std::make_shared<IFileSystem>(std::make_shared<vfs::OsFileSystem>(state.os->appFilesPath + "/switch" + saveDataPath), state, manager), session, response);
+        manager.RegisterService(std::make_shared<IFileSystem>(std::make_shared<vfs::OsFileSystem>(state.os->appFilesPath + "/switch" + saveDataPath), state, manager, true), session, response);
         return {};
     }
 
@@ -65,7 +66,7 @@ namespace skyline::service::fssrv {
         if (!state.loader->romFs)
             return result::NoRomFsAvailable;
 
-        manager.RegisterService(std::make_shared<IStorage>(state.loader->romFs, state, manager), session, response);
+        manager.RegisterService(std::make_shared<IStorage>(std::make_shared<vfs::ReadAheadBacking>(state.loader->romFs), state, manager), session, response);
         return {};
     }
 
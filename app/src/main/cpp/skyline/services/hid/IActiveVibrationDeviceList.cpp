@@ -12,8 +12,10 @@ namespace skyline::service::hid {
     Result IActiveVibrationDeviceList::ActivateVibrationDevice(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         auto handle{request.Pop<NpadDeviceHandle>()};
 
-        if (!handle.isRight)
+        if (!handle.isRight) {
+            std::scoped_lock lock(state.input->npad.vibrationMutex);
             state.input->npad.at(handle.id).vibrationRight = NpadVibrationValue{};
+        }
 
         return {};
     }
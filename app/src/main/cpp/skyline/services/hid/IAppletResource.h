@@ -20,6 +20,10 @@ namespace skyline::service::hid {
          */
         Result GetSharedMemoryHandle(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        bool IsBlocking() override {
+            return false;
+        }
+
         SERVICE_DECL(
             SFUNC(0x0, IAppletResource, GetSharedMemoryHandle)
         )
@@ -13,6 +13,10 @@
 namespace skyline::service::hosbinder {
     GraphicBufferProducer::GraphicBufferProducer(const DeviceState &state, nvdrv::core::NvMap &nvMap) : state(state), bufferEvent(std::make_shared<kernel::type::KEvent>(state, true)), nvMap(nvMap) {}
 
+    GraphicBufferProducer::~GraphicBufferProducer() {
+        state.gpu->presentation.ReleaseQueuedFrames();
+    }
+
     void GraphicBufferProducer::FreeGraphicBufferNvMap(GraphicBuffer &buffer) {
         auto surface{buffer.graphicHandle.surfaces.at(0)};
         u32 nvMapHandleId{surface.nvmapHandle ? surface.nvmapHandle : buffer.graphicHandle.nvmapId};
@@ -92,21 +96,31 @@ namespace skyline::service::hosbinder {
         constexpr i32 InvalidGraphicBufferSlot{-1}; //!< https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/include/gui/BufferQueueCore.h;l=61
         slot = InvalidGraphicBufferSlot;
 
-        std::scoped_lock lock(mutex);
-        // We don't need a loop here since the consumer is blocking and instantly frees all buffers
-        // If a valid slot is not found on the first iteration then it would be stuck in an infinite loop
-        // As a result of this, we simply warn and return InvalidOperation to the guest
+        std::unique_lock lock(mutex);
+        // Queued buffers are freed by the presentation engine asynchronously, so we wait on one of them being freed if there are no free buffers
+        // If there are no queued buffers either then we'd be stuck waiting forever, we simply warn and return InvalidOperation to the guest in that case
         auto buffer{queue.end()};
         size_t dequeuedSlotCount{};
-        for (auto it{queue.begin()}; it != std::min(queue.begin() + activeSlotCount, queue.end()); it++) {
-            // We want to select the oldest slot that's free to use as we'd want all slots to be used
-            // If we go linearly then we have a higher preference for selecting the former slots and being out of order
-            if (it->state == BufferState::Free) {
-                if (buffer == queue.end() || it->frameNumber < buffer->frameNumber)
-                    buffer = it;
-            } else if (it->state == BufferState::Dequeued) {
-                dequeuedSlotCount++;
+        while (true) {
+            size_t queuedSlotCount{};
+            dequeuedSlotCount = 0;
+            for (auto it{queue.begin()}; it != std::min(queue.begin() + activeSlotCount, queue.end()); it++) {
+                // We want to select the oldest slot that's free to use as we'd want all slots to be used
+                // If we go linearly then we have a higher preference for selecting the former slots and being out of order
+                if (it->state == BufferState::Free) {
+                    if (buffer == queue.end() || it->frameNumber < buffer->frameNumber)
+                        buffer = it;
+                } else if (it->state == BufferState::Dequeued) {
+                    dequeuedSlotCount++;
+                } else if (it->state == BufferState::Queued) {
+                    queuedSlotCount++;
+                }
             }
+
+            if (buffer != queue.end() || async || !queuedSlotCount)
+                break;
+
+            slotCondition.wait(lock);
         }
 
         if (buffer != queue.end()) {
@@ -254,6 +268,62 @@ namespace skyline::service::hosbinder {
         return AndroidStatus::Ok;
     }
 
+    std::shared_ptr<gpu::Texture> GraphicBufferProducer::CreateTexture(const GraphicBuffer &graphicBuffer) {
+        auto &handle{graphicBuffer.graphicHandle};
+        if (handle.magic != NvGraphicHandle::Magic)
+            throw exception("Unexpected NvGraphicHandle magic: {}", handle.surfaceCount);
+        else if (handle.surfaceCount < 1)
+            throw exception("At least one surface is required in a buffer: {}", handle.surfaceCount);
+        else if (handle.surfaceCount > 1)
+            throw exception("Multi-planar surfaces are not supported: {}", handle.surfaceCount);
+
+        gpu::texture::Format format;
+        switch (handle.format) {
+            case AndroidPixelFormat::RGBA8888:
+            case AndroidPixelFormat::RGBX8888:
+                format = gpu::format::R8G8B8A8Unorm;
+                break;
+
+            case AndroidPixelFormat::RGB565:
+                format = gpu::format::R5G6B5Unorm;
+                break;
+
+            default:
+                throw exception("Unknown format in buffer: '{}' ({})", ToString(handle.format), static_cast<u32>(handle.format));
+        }
+
+        auto &surface{handle.surfaces.at(0)};
+        if (surface.scanFormat != NvDisplayScanFormat::Progressive)
+            throw exception("Non-Progressive surfaces are not supported: {}", ToString(surface.scanFormat));
+
+        // Duplicate the handle so it can't be freed by the guest
+        auto nvMapHandleObj{nvMap.GetHandle(surface.nvmapHandle ? surface.nvmapHandle : handle.nvmapId)};
+        if (auto err{nvMapHandleObj->Duplicate(true)}; err != PosixResult::Success)
+            throw exception("Failed to duplicate graphic buffer NvMap handle: {}!", static_cast<i32>(err));
+
+        if (surface.size > (nvMapHandleObj->origSize - surface.offset))
+            throw exception("Surface doesn't fit into NvMap mapping of size 0x{:X} when mapped at 0x{:X} -> 0x{:X}", nvMapHandleObj->origSize, surface.offset, surface.offset + surface.size);
+
+        gpu::texture::TileConfig tileConfig{};
+        if (surface.layout == NvSurfaceLayout::Blocklinear) {
+            tileConfig = {
+                .mode = gpu::texture::TileMode::Block,
+                .blockHeight = static_cast<u8>(1U << surface.blockHeightLog2),
+                .blockDepth = 1,
+            };
+        } else if (surface.layout == NvSurfaceLayout::Pitch) {
+            tileConfig = {
+                .mode = gpu::texture::TileMode::Pitch,
+                .pitch = surface.pitch,
+            };
+        } else if (surface.layout == NvSurfaceLayout::Tiled) {
+            throw exception("Legacy 16Bx16 tiled surfaces are not supported");
+        }
+
+        gpu::GuestTexture guestTexture(span<u8>(nvMapHandleObj->GetPointer() + surface.offset, surface.size), gpu::texture::Dimensions(surface.width, surface.height), format, tileConfig, gpu::texture::TextureType::e2D);
+        return state.gpu->texture.FindOrCreate(guestTexture, true).backing; // Display buffers are the final render target of a frame, so they're scaled alongside all other render targets
+    }
+
     AndroidStatus GraphicBufferProducer::QueueBuffer(i32 slot, i64 timestamp, bool isAutoTimestamp, AndroidRect crop, NativeWindowScalingMode scalingMode, NativeWindowTransform transform, NativeWindowTransform stickyTransform, bool async, u32 swapInterval, const AndroidFence &fence, u32 &width, u32 &height, NativeWindowTransform &transformHint, u32 &pendingBufferCount) {
         switch (scalingMode) {
             case NativeWindowScalingMode::Freeze:
@@ -282,7 +352,7 @@ namespace skyline::service::hosbinder {
             buffer.wasBufferRequested = true; // Switch ignores this and doesn't return an error, certain homebrew ends up depending on this behavior
         }
 
-        auto graphicBuffer{*buffer.graphicBuffer};
+        const auto &graphicBuffer{*buffer.graphicBuffer};
         if (graphicBuffer.width < (crop.right - crop.left) || graphicBuffer.height < (crop.bottom - crop.top)) [[unlikely]] {
             Logger::Warn("Crop was out of range for surface buffer: ({}-{})x({}-{}) > {}x{}", crop.left, crop.right, crop.top, crop.bottom, graphicBuffer.width, graphicBuffer.height);
             return AndroidStatus::BadValue;
@@ -290,61 +360,8 @@ namespace skyline::service::hosbinder {
 
         if (!buffer.texture) [[unlikely]] {
             // We lazily create a texture if one isn't present at queue time, this allows us to look up the texture in the texture cache
-            // If we deterministically know that the texture is written by the CPU then we can allocate a CPU-shared host texture for fast uploads
-
-            auto &handle{graphicBuffer.graphicHandle};
-            if (handle.magic != NvGraphicHandle::Magic)
-                throw exception("Unexpected NvGraphicHandle magic: {}", handle.surfaceCount);
-            else if (handle.surfaceCount < 1)
-                throw exception("At least one surface is required in a buffer: {}", handle.surfaceCount);
-            else if (handle.surfaceCount > 1)
-                throw exception("Multi-planar surfaces are not supported: {}", handle.surfaceCount);
-
-            gpu::texture::Format format;
-            switch (handle.format) {
-                case AndroidPixelFormat::RGBA8888:
-                case AndroidPixelFormat::RGBX8888:
-                    format = gpu::format::R8G8B8A8Unorm;
-                    break;
-
-                case AndroidPixelFormat::RGB565:
-                    format = gpu::format::R5G6B5Unorm;
-                    break;
-
-                default:
-                    throw exception("Unknown format in buffer: '{}' ({})", ToString(handle.format), static_cast<u32>(handle.format));
-            }
-
-            auto &surface{graphicBuffer.graphicHandle.surfaces.at(0)};
-            if (surface.scanFormat != NvDisplayScanFormat::Progressive)
-                throw exception("Non-Progressive surfaces are not supported: {}", ToString(surface.scanFormat));
-
-            // Duplicate the handle so it can't be freed by the guest
-            auto nvMapHandleObj{nvMap.GetHandle(surface.nvmapHandle ? surface.nvmapHandle : handle.nvmapId)};
-            if (auto err{nvMapHandleObj->Duplicate(true)}; err != PosixResult::Success)
-                throw exception("Failed to duplicate graphic buffer NvMap handle: {}!", static_cast<i32>(err));
-
-            if (surface.size > (nvMapHandleObj->origSize - surface.offset))
-                throw exception("Surface doesn't fit into NvMap mapping of size 0x{:X} when mapped at 0x{:X} -> 0x{:X}", nvMapHandleObj->origSize, surface.offset, surface.offset + surface.size);
-
-            gpu::texture::TileConfig tileConfig{};
-            if (surface.layout == NvSurfaceLayout::Blocklinear) {
-                tileConfig = {
-                    .mode = gpu::texture::TileMode::Block,
-                    .blockHeight = static_cast<u8>(1U << surface.blockHeightLog2),
-                    .blockDepth = 1,
-                };
-            } else if (surface.layout == NvSurfaceLayout::Pitch) {
-                tileConfig = {
-                    .mode = gpu::texture::TileMode::Pitch,
-                    .pitch = surface.pitch,
-                };
-            } else if (surface.layout == NvSurfaceLayout::Tiled) {
-                throw exception("Legacy 16Bx16 tiled surfaces are not supported");
-            }
-
-            gpu::GuestTexture guestTexture(span<u8>(nvMapHandleObj->GetPointer() + surface.offset, surface.size), gpu::texture::Dimensions(surface.width, surface.height), format, tileConfig, gpu::texture::TextureType::e2D);
-            buffer.texture = state.gpu->texture.FindOrCreate(guestTexture).backing;
+            // The texture is retained by the slot until its buffer is replaced or freed, so later frames present it directly
+            buffer.texture = CreateTexture(graphicBuffer);
         }
 
         switch (transform) {
@@ -381,19 +398,20 @@ namespace skyline::service::hosbinder {
                 throw exception("Application attempting to perform unknown sticky transformation: {:#b}", static_cast<u32>(stickyTransform));
         }
 
-        fence.Wait(state.soc->host1x);
-
-        {
-            auto &texture{buffer.texture};
-            std::scoped_lock textureLock(*texture);
-            texture->SynchronizeHost();
-            u64 frameId;
-            state.gpu->presentation.Present(texture, isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform, frameId);
-        }
+        // The buffer stays queued till the presentation engine has presented or dropped it, the fence is waited on by it rather than blocking the guest here
+        state.gpu->presentation.Present(buffer.texture, fence, isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform, [this, slot, texture = buffer.texture]() {
+            std::scoped_lock lock(mutex);
+            auto &buffer{queue[static_cast<size_t>(slot)]};
+            if (buffer.state == BufferState::Queued && buffer.texture == texture) {
+                // The slot could have been reset while the frame was pending, we only free it if it still holds the same buffer
+                buffer.state = BufferState::Free;
+                bufferEvent->Signal();
+            }
+            slotCondition.notify_all(); // This is done regardless as a reset could have freed slots without waking any waiters
+        });
 
         buffer.frameNumber = ++frameNumber;
-        buffer.state = BufferState::Free;
-        bufferEvent->Signal();
+        buffer.state = BufferState::Queued;
 
         width = defaultWidth;
         height = defaultHeight;
@@ -586,7 +604,7 @@ namespace skyline::service::hosbinder {
         return AndroidStatus::Ok;
     }
 
-    void GraphicBufferProducer::OnTransact(TransactionCode code, Parcel &in, Parcel &out) {
+    void GraphicBufferProducer::OnTransact(TransactionCode code, ParcelReader &in, ParcelWriter &out) {
         switch (code) {
             case TransactionCode::RequestBuffer: {
                 GraphicBuffer *buffer{};
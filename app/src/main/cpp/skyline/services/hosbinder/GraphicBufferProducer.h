@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <kernel/types/KEvent.h>
 #include "parcel.h"
 #include "android_types.h"
@@ -44,7 +45,7 @@ namespace skyline::service::hosbinder {
         u64 frameNumber{}; //!< The amount of frames that have been queued using this slot
         bool wasBufferRequested{}; //!< If GraphicBufferProducer::RequestBuffer has been called with this buffer
         bool isPreallocated{}; //!< If this slot's graphic buffer has been preallocated or attached
-        std::shared_ptr<gpu::Texture> texture{};
+        std::shared_ptr<gpu::Texture> texture{}; //!< The host texture backing the graphic buffer, this is resolved on the first queue of the buffer and reset alongside the NvMap handle being freed when the buffer is replaced
         std::unique_ptr<GraphicBuffer> graphicBuffer{};
     };
 
@@ -61,6 +62,7 @@ namespace skyline::service::hosbinder {
       private:
         const DeviceState &state;
         std::mutex mutex; //!< Synchronizes access to the buffer queue
+        std::condition_variable slotCondition; //!< Signalled when a queued buffer is freed after being presented, this is waited on when dequeuing with no free buffers
         constexpr static u8 MaxSlotCount{16}; //!< The maximum amount of buffer slots that a buffer queue can hold, Android supports 64 but they go unused for applications like games so we've lowered this to 16 (https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/include/gui/BufferQueueDefs.h;l=29)
         std::array<BufferSlot, MaxSlotCount> queue;
         u8 activeSlotCount{}; //!< The amount of slots in the queue that can be dequeued
@@ -74,6 +76,11 @@ namespace skyline::service::hosbinder {
 
         void FreeGraphicBufferNvMap(GraphicBuffer &buffer);
 
+        /**
+         * @brief Resolves the host texture backing a graphic buffer, this duplicates the buffer's NvMap handle which must be freed with FreeGraphicBufferNvMap alongside the texture
+         */
+        std::shared_ptr<gpu::Texture> CreateTexture(const GraphicBuffer &graphicBuffer);
+
         /**
          * @return The amount of buffers which have been queued onto the consumer
          */
@@ -189,10 +196,15 @@ namespace skyline::service::hosbinder {
 
         GraphicBufferProducer(const DeviceState &state, nvdrv::core::NvMap &nvmap);
 
+        /**
+         * @note This waits on the presentation engine to release all frames queued by the producer as their release callbacks reference it
+         */
+        ~GraphicBufferProducer();
+
         /**
          * @brief The handler for Binder IPC transactions with IGraphicBufferProducer
          * @url https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/libs/gui/IGraphicBufferProducer.cpp;l=277-426
          */
-        void OnTransact(TransactionCode code, Parcel &in, Parcel &out);
+        void OnTransact(TransactionCode code, ParcelReader &in, ParcelWriter &out);
     };
 }
@@ -20,14 +20,14 @@ namespace skyline::service::hosbinder {
 
         auto code{request.Pop<GraphicBufferProducer::TransactionCode>()};
 
-        Parcel in(request.inputBuf.at(0), state, true);
-        Parcel out(state);
+        ParcelReader in(request.inputBuf.at(0), true);
+        ParcelWriter out(request.outputBuf.at(0));
 
         if (!layer)
             throw exception("Transacting parcel with non-existant layer");
         layer->OnTransact(code, in, out);
 
-        out.WriteParcel(request.outputBuf.at(0));
+        out.Finish();
         return {};
     }
 
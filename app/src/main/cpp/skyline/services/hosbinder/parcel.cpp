@@ -10,10 +10,8 @@ namespace skyline::service::hosbinder {
         if (buffer.size() < (sizeof(ParcelHeader) + header.dataSize + header.objectsSize))
             throw exception("The size of the parcel according to the header exceeds the specified size");
 
-        constexpr u8 tokenLength{0x50}; // The length of the token on BufferQueue parcels
-
-        data.resize(header.dataSize - (hasToken ? tokenLength : 0));
-        std::memcpy(data.data(), buffer.data() + header.dataOffset + (hasToken ? tokenLength : 0), header.dataSize - (hasToken ? tokenLength : 0));
+        data.resize(header.dataSize - (hasToken ? ParcelTokenLength : 0));
+        std::memcpy(data.data(), buffer.data() + header.dataOffset + (hasToken ? ParcelTokenLength : 0), header.dataSize - (hasToken ? ParcelTokenLength : 0));
 
         objects.resize(header.objectsSize);
         std::memcpy(objects.data(), buffer.data() + header.objectsOffset, header.objectsSize);
@@ -39,4 +37,34 @@ namespace skyline::service::hosbinder {
 
         return totalSize;
     }
+
+    ParcelReader::ParcelReader(span<u8> buffer, bool hasToken) {
+        if (buffer.size() < sizeof(ParcelHeader))
+            throw exception("The parcel buffer is smaller than the parcel header: 0x{:X}", buffer.size());
+
+        auto &header{buffer.as<ParcelHeader>()};
+        if (static_cast<u64>(header.dataOffset) + header.dataSize > buffer.size() || static_cast<u64>(header.objectsOffset) + header.objectsSize > buffer.size())
+            throw exception("The size of the parcel according to the header exceeds the specified size");
+
+        size_t tokenLength{hasToken ? ParcelTokenLength : 0U};
+        if (header.dataSize < tokenLength)
+            throw exception("The parcel data is smaller than its token: 0x{:X}", header.dataSize);
+
+        data = buffer.subspan(header.dataOffset + tokenLength, header.dataSize - tokenLength);
+    }
+
+    ParcelWriter::ParcelWriter(span<u8> buffer) : buffer(buffer) {
+        if (buffer.size() < sizeof(ParcelHeader))
+            throw exception("The parcel buffer is smaller than the parcel header: 0x{:X}", buffer.size());
+    }
+
+    u64 ParcelWriter::Finish() {
+        buffer.as<ParcelHeader>() = ParcelHeader{
+            .dataSize = static_cast<u32>(dataSize),
+            .dataOffset = sizeof(ParcelHeader),
+            .objectsSize = 0,
+            .objectsOffset = static_cast<u32>(sizeof(ParcelHeader) + dataSize),
+        };
+        return sizeof(ParcelHeader) + dataSize;
+    }
 }
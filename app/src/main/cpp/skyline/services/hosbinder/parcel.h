@@ -6,19 +6,27 @@
 #include <kernel/ipc.h>
 
 namespace skyline::service::hosbinder {
+    /**
+     * @url https://switchbrew.org/wiki/Display_services#Parcel
+     */
+    struct ParcelHeader {
+        u32 dataSize;
+        u32 dataOffset;
+        u32 objectsSize;
+        u32 objectsOffset;
+    };
+    static_assert(sizeof(ParcelHeader) == 0x10);
+
+    constexpr u8 ParcelTokenLength{0x50}; //!< The length of the token on BufferQueue parcels
+
     /**
      * @brief This allows easy access and efficient serialization of an Android Parcel object
+     * @note This owns a copy of the parcel's contents, ParcelReader and ParcelWriter should be used to directly access IPC buffers instead
      * @url https://switchbrew.org/wiki/Display_services#Parcel
      */
     class Parcel {
       private:
-        struct ParcelHeader {
-            u32 dataSize;
-            u32 dataOffset;
-            u32 objectsSize;
-            u32 objectsOffset;
-        } header{};
-        static_assert(sizeof(ParcelHeader) == 0x10);
+        ParcelHeader header{};
 
         const DeviceState &state;
 
@@ -108,4 +116,106 @@ namespace skyline::service::hosbinder {
          */
         u64 WriteParcel(span<u8> buffer);
     };
+
+    /**
+     * @brief A non-owning reader of a parcel which is directly backed by an IPC buffer, this avoids copying the parcel prior to reading it
+     * @note The buffer must outlive the reader and any references popped from it
+     */
+    class ParcelReader {
+      private:
+        span<u8> data;
+        size_t dataOffset{}; //!< The offset of the data read from the parcel
+
+      public:
+        /**
+         * @note The objects of the parcel aren't accessible as none of the transactions that use this read any
+         * @param buffer The buffer that contains the parcel
+         * @param hasToken If the parcel starts with a token, it's skipped if this flag is true
+         */
+        ParcelReader(span<u8> buffer, bool hasToken = false);
+
+        /**
+         * @return A reference to an item from the top of data
+         */
+        template<typename ValueType>
+        ValueType &Pop() {
+            if (dataOffset + sizeof(ValueType) > data.size()) [[unlikely]]
+                throw exception("Popping 0x{:X} bytes at 0x{:X} from a parcel with 0x{:X} bytes of data", sizeof(ValueType), dataOffset, data.size());
+
+            ValueType &value{*reinterpret_cast<ValueType *>(data.data() + dataOffset)};
+            dataOffset += sizeof(ValueType);
+            return value;
+        }
+
+        /**
+         * @return A pointer to an optional flattenable from the top of data, nullptr will be returned if the object doesn't exist
+         */
+        template<typename ValueType>
+        ValueType *PopOptionalFlattenable() {
+            bool hasObject{Pop<u32>() != 0};
+            if (hasObject) {
+                auto size{Pop<u64>()};
+                if (size != sizeof(ValueType))
+                    throw exception("Popping flattenable of size 0x{:X} with type size 0x{:X}", size, sizeof(ValueType));
+                return &Pop<ValueType>();
+            } else {
+                return nullptr;
+            }
+        }
+    };
+
+    /**
+     * @brief A non-owning writer of a parcel which serializes directly into an IPC buffer, this avoids flattening an intermediate copy of the parcel
+     * @note Parcels written by this have no objects as none of the transactions that use it return any
+     */
+    class ParcelWriter {
+      private:
+        span<u8> buffer;
+        size_t dataSize{}; //!< The amount of data that has been written into the parcel
+
+      public:
+        /**
+         * @param buffer The buffer to write the parcel into, it must not overlap with the buffer of any ParcelReader that's being read during the writes
+         */
+        ParcelWriter(span<u8> buffer);
+
+        template<typename ValueType>
+        void Push(const ValueType &value) {
+            auto offset{sizeof(ParcelHeader) + dataSize};
+            if (offset + sizeof(ValueType) > buffer.size()) [[unlikely]]
+                throw exception("Pushing 0x{:X} bytes at 0x{:X} into a parcel buffer of 0x{:X} bytes", sizeof(ValueType), offset, buffer.size());
+
+            std::memcpy(buffer.data() + offset, &value, sizeof(ValueType));
+            dataSize += sizeof(ValueType);
+        }
+
+        /**
+         * @brief Writes a 32-bit boolean flag denoting if an object exists alongside the object if it exists
+         */
+        template<typename ObjectType>
+        void PushOptionalFlattenable(ObjectType *pointer) {
+            Push<u32>(pointer != nullptr);
+            if (pointer) {
+                Push<u32>(sizeof(ObjectType)); // Object Size
+                Push<u32>(0); // FD Count
+                Push(*pointer);
+            }
+        }
+
+        template<typename ObjectType>
+        void PushOptionalFlattenable(std::optional<ObjectType> object) {
+            Push<u32>(object.has_value());
+            if (object) {
+                Push<u32>(sizeof(ObjectType));
+                Push<u32>(0);
+                Push(*object);
+            }
+        }
+
+        /**
+         * @brief Writes the header of the parcel, this must be called after all data has been pushed
+         * @return The total size of the Parcel
+         */
+        u64 Finish();
+    };
 }
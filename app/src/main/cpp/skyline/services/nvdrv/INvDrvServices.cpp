@@ -22,8 +22,6 @@ namespace skyline::service::nvdrv {
           ctx(SessionContext{.perms = perms}) {}
 
     Result INvDrvServices::Open(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        constexpr FileDescriptor SessionFdLimit{std::numeric_limits<u64>::digits * 2}; //!< Nvdrv uses two 64 bit variables to store a bitset
-
         auto path{request.inputBuf.at(0).as_string(true)};
         if (path.empty() || nextFdIndex == SessionFdLimit) {
             response.Push<FileDescriptor>(InvalidFileDescriptor);
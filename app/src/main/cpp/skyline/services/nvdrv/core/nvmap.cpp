@@ -3,6 +3,7 @@
 
 #include <common/address_space.inc>
 #include <soc.h>
+#include <common/settings.h>
 #include "nvmap.h"
 
 namespace skyline {
@@ -56,12 +57,52 @@ namespace skyline::service::nvdrv::core {
         return PosixResult::Success;
     }
 
-    NvMap::NvMap(const DeviceState &state) : state(state), smmuAllocator(PAGE_SIZE) {}
+    NvMap::NvMap(const DeviceState &state) : state(state), smmuAllocator(PAGE_SIZE), pinCacheBudget(static_cast<size_t>(state.settings->pinCacheSize) * 1024 * 1024) {}
+
+    NvMap::HandleSlot *NvMap::FindHandleSlot(Handle::Id id) {
+        size_t index{id / HandleIdIncrement};
+        auto directory{handleDirectory.load(std::memory_order_acquire)};
+        if (!directory || index / HandleChunkSize >= directory->size) [[unlikely]]
+            return nullptr;
+
+        auto chunk{directory->chunks[index / HandleChunkSize].load(std::memory_order_acquire)};
+        if (!chunk) [[unlikely]]
+            return nullptr;
+
+        return &(*chunk)[index % HandleChunkSize];
+    }
 
     void NvMap::AddHandle(std::shared_ptr<Handle> handleDesc) {
-        std::scoped_lock lock(handlesLock);
+        size_t index{handleDesc->id / HandleIdIncrement}, chunkIndex{index / HandleChunkSize};
+        HandleSlot *slot;
+        {
+            std::scoped_lock lock(handlesLock);
+
+            auto directory{handleDirectory.load(std::memory_order_relaxed)};
+            if (!directory || chunkIndex >= directory->size) {
+                // Lookups may still be reading the old directory so it's retired rather than freed, the sizes double so retired directories at most match the size of the current one
+                auto &newDirectory{handleDirectories.emplace_back(std::make_unique<HandleDirectory>(std::max(chunkIndex + 1, directory ? directory->size * 2 : 1)))};
+                if (directory)
+                    for (size_t i{}; i < directory->size; i++)
+                        newDirectory->chunks[i].store(directory->chunks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
 
-        handles.emplace(handleDesc->id, std::move(handleDesc));
+                directory = newDirectory.get();
+                handleDirectory.store(directory, std::memory_order_release);
+            }
+
+            auto chunk{directory->chunks[chunkIndex].load(std::memory_order_relaxed)};
+            if (!chunk) {
+                chunk = handleChunks.emplace_back(std::make_unique<HandleChunk>()).get();
+                directory->chunks[chunkIndex].store(chunk, std::memory_order_release);
+            }
+
+            slot = &(*chunk)[index % HandleChunkSize];
+        }
+
+        // IDs are unique so nothing else can be writing to the slot, it's published after the owning reference is set
+        auto handle{handleDesc.get()};
+        slot->owner = std::move(handleDesc);
+        slot->handle.store(handle, std::memory_order_release);
     }
 
     void NvMap::UnmapHandle(Handle &handleDesc) {
@@ -69,6 +110,7 @@ namespace skyline::service::nvdrv::core {
         if (handleDesc.unmapQueueEntry) {
             unmapQueue.erase(*handleDesc.unmapQueueEntry);
             handleDesc.unmapQueueEntry.reset();
+            unmapQueueSize -= handleDesc.alignedSize;
         }
 
         // Free and unmap the handle from the SMMU
@@ -77,15 +119,34 @@ namespace skyline::service::nvdrv::core {
         handleDesc.pinVirtAddress = 0;
     }
 
+    bool NvMap::EvictUnmapQueueEntry(const Handle *exclude) {
+        for (const auto &entry : unmapQueue) {
+            // A handle being locked by another thread means it's about to be pinned or freed, blocking on it here could deadlock as that thread will lock the unmap queue next
+            if (entry.get() == exclude || !entry->mutex.try_lock())
+                continue;
+
+            // The queue entry is erased by unmapping so the handle needs to be kept alive till it's unlocked
+            auto freeHandleDesc{entry};
+            std::scoped_lock freeLock(std::adopt_lock, freeHandleDesc->mutex);
+
+            // Handles in the unmap queue are guaranteed not to be pinned so don't bother checking if they are before unmapping
+            UnmapHandle(*freeHandleDesc);
+            return true;
+        }
+        return false;
+    }
+
 
     bool NvMap::TryRemoveHandle(const Handle &handleDesc) {
         // No dupes left, we can remove from handle map
         if (handleDesc.dupes == 0 && handleDesc.internalDupes == 0) {
-            std::scoped_lock lock(handlesLock);
-
-            auto it{handles.find(handleDesc.id)};
-            if (it != handles.end())
-                handles.erase(it);
+            auto slot{FindHandleSlot(handleDesc.id)};
+            if (slot && slot->handle.exchange(nullptr)) {
+                // Any lookups which loaded the handle before the exchange are waited on before dropping the owning reference, later ones will observe the slot being empty
+                while (auto users{slot->users.load()})
+                    slot->users.wait(users);
+                slot->owner.reset();
+            }
 
             return true;
         } else {
@@ -105,13 +166,17 @@ namespace skyline::service::nvdrv::core {
     }
 
     std::shared_ptr<NvMap::Handle> NvMap::GetHandle(Handle::Id handle) {
-        std::scoped_lock lock(handlesLock);
-
-        try {
-            return handles.at(handle);
-        } catch (std::out_of_range &e) {
+        auto slot{FindHandleSlot(handle)};
+        if (!slot)
             return nullptr;
-        }
+
+        // The increment must be ordered before the load for TryRemoveHandle to observe it, this is why both are sequentially consistent
+        slot->users.fetch_add(1);
+        std::shared_ptr<Handle> handleDesc{slot->handle.load() ? slot->owner : nullptr};
+        if (slot->users.fetch_sub(1) == 1)
+            slot->users.notify_all();
+
+        return handleDesc;
     }
 
     u32 NvMap::PinHandle(NvMap::Handle::Id handle) {
@@ -128,6 +193,7 @@ namespace skyline::service::nvdrv::core {
                 if (handleDesc->unmapQueueEntry) {
                     unmapQueue.erase(*handleDesc->unmapQueueEntry);
                     handleDesc->unmapQueueEntry.reset();
+                    unmapQueueSize -= handleDesc->alignedSize;
 
                     handleDesc->pins++;
                     return handleDesc->pinVirtAddress;
@@ -139,14 +205,8 @@ namespace skyline::service::nvdrv::core {
             while (!(address = smmuAllocator.Allocate(static_cast<u32>(handleDesc->alignedSize)))) {
                 // Free handles until the allocation succeeds
                 std::scoped_lock queueLock(unmapQueueLock);
-                if (auto freeHandleDesc{unmapQueue.front()}) {
-                    // Handles in the unmap queue are guaranteed not to be pinned so don't bother checking if they are before unmapping
-                    std::scoped_lock freeLock(freeHandleDesc->mutex);
-                    if (handleDesc->pinVirtAddress)
-                        UnmapHandle(*freeHandleDesc);
-                } else {
+                if (!EvictUnmapQueueEntry(handleDesc.get()))
                     throw exception("Ran out of SMMU address space!");
-                }
             }
 
             state.soc->smmu.Map(address, reinterpret_cast<u8 *>(handleDesc->address), static_cast<u32>(handleDesc->alignedSize));
@@ -171,6 +231,10 @@ namespace skyline::service::nvdrv::core {
             // Add to the unmap queue allowing this handle's memory to be freed if needed
             unmapQueue.push_back(handleDesc);
             handleDesc->unmapQueueEntry = std::prev(unmapQueue.end());
+            unmapQueueSize += handleDesc->alignedSize;
+
+            // Handles which are pinned and unpinned repeatedly stay mapped as long as the queue is within its budget
+            while (pinCacheBudget && unmapQueueSize > pinCacheBudget && EvictUnmapQueueEntry(handleDesc.get()));
         }
     }
 
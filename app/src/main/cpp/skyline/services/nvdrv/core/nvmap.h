@@ -79,15 +79,47 @@ namespace skyline::service::nvdrv::core {
         const DeviceState &state;
 
         FlatAllocator<u32, 0, 32> smmuAllocator;
-        std::list<std::shared_ptr<Handle>> unmapQueue;
-        std::mutex unmapQueueLock; //!< Protects access to `unmapQueue`
+        std::list<std::shared_ptr<Handle>> unmapQueue; //!< Handles which are unpinned but still mapped into the SMMU in order of least recently unpinned, these are reused without remapping if they're pinned again
+        size_t unmapQueueSize{}; //!< The total size of all handles in `unmapQueue` in bytes
+        size_t pinCacheBudget; //!< The maximum value of `unmapQueueSize` before the least recently unpinned handles are unmapped, 0 if handles are only unmapped when the SMMU runs out of space
+        std::mutex unmapQueueLock; //!< Protects access to `unmapQueue` and `unmapQueueSize`
 
-        std::unordered_map<Handle::Id, std::shared_ptr<Handle>> handles; //!< Main owning map of handles
-        std::mutex handlesLock; //!< Protects access to `handles`
+        /**
+         * @brief An entry in the handle table, handles are looked up without taking any locks as this is done for every map, pin and surface lookup
+         */
+        struct HandleSlot {
+            std::atomic<Handle *> handle{}; //!< The handle in this slot, this is null if it hasn't been created yet or was removed
+            std::atomic<u32> users{}; //!< The amount of lookups currently copying `owner`, it's only reset after this drops to zero
+            std::shared_ptr<Handle> owner; //!< The owning reference to the handle, this is only written to while `handle` is null
+        };
+
+        static constexpr size_t HandleChunkSize{1024}; //!< The amount of slots in a single chunk of the handle table
+
+        using HandleChunk = std::array<HandleSlot, HandleChunkSize>;
 
-        static constexpr u32 HandleIdIncrement{4}; //!< Each new handle ID is an increment of 4 from the previous
+        /**
+         * @brief The chunks of the handle table, this is replaced by a larger copy when it fills up
+         */
+        struct HandleDirectory {
+            size_t size; //!< The amount of chunks that can be stored in the directory
+            std::unique_ptr<std::atomic<HandleChunk *>[]> chunks;
+
+            HandleDirectory(size_t size) : size(size), chunks(new std::atomic<HandleChunk *>[size]{}) {}
+        };
+
+        static constexpr u32 HandleIdIncrement{4}; //!< Each new handle ID is an increment of 4 from the previous, dividing an ID by this yields its slot in the handle table
         std::atomic<u32> nextHandleId{HandleIdIncrement};
 
+        std::atomic<HandleDirectory *> handleDirectory{}; //!< The current directory of the handle table, this may be null if no handles were created yet
+        std::vector<std::unique_ptr<HandleDirectory>> handleDirectories; //!< All directories which were ever published, superseded ones are retired rather than freed as lookups may still be reading them
+        std::vector<std::unique_ptr<HandleChunk>> handleChunks; //!< The owning storage of all chunks, these stay allocated for the lifetime of the table as IDs are never reused
+        std::mutex handlesLock; //!< Serializes modifications of the handle table's structure
+
+        /**
+         * @return The slot of the handle with the supplied ID, this is null if the table hasn't grown to the ID yet
+         */
+        HandleSlot *FindHandleSlot(Handle::Id id);
+
         void AddHandle(std::shared_ptr<Handle> handle);
 
         /**
@@ -96,6 +128,14 @@ namespace skyline::service::nvdrv::core {
          */
         void UnmapHandle(Handle &handleDesc);
 
+        /**
+         * @brief Unmaps the least recently unpinned handle in the unmap queue, handles which are concurrently locked by another thread are skipped
+         * @param exclude A handle locked by the calling thread which must not be evicted
+         * @return If a handle was unmapped
+         * @note `unmapQueueLock` MUST be locked when calling this
+         */
+        bool EvictUnmapQueueEntry(const Handle *exclude);
+
         /**
          * @brief Removes a handle from the map taking its dupes into account
          * @note handleDesc.mutex MUST be locked when calling this
@@ -25,24 +25,23 @@ namespace skyline::service::nvdrv::device::nvhost {
         if  (!vm.initialised)
             return PosixResult::InvalidArgument;
 
-        try {
-            std::shared_lock gpuLock(driver.deviceMutex);
-            auto &gpuCh{dynamic_cast<GpuChannel &>(*driver.devices.at(channelFd))};
+        auto device{driver.GetDevice(channelFd)};
+        auto gpuCh{device ? dynamic_cast<GpuChannel *>(&*device) : nullptr};
+        if (!gpuCh) {
+            Logger::Warn("Attempting to bind AS to an invalid channel: {}", channelFd);
+            return PosixResult::InvalidArgument;
+        }
 
-            std::scoped_lock channelLock(gpuCh.channelMutex);
+        std::scoped_lock channelLock(gpuCh->channelMutex);
 
-            if (gpuCh.asCtx) {
-                Logger::Warn("Attempting to bind multiple ASes to a single GPU channel");
-                return PosixResult::InvalidArgument;
-            }
-            
-            gpuCh.asCtx = asCtx;
-            gpuCh.asAllocator = vm.smallPageAllocator;
-        } catch (const std::out_of_range &e) {
-            Logger::Warn("Attempting to bind AS to an invalid channel: {}", channelFd);
+        if (gpuCh->asCtx) {
+            Logger::Warn("Attempting to bind multiple ASes to a single GPU channel");
             return PosixResult::InvalidArgument;
         }
-        
+
+        gpuCh->asCtx = asCtx;
+        gpuCh->asAllocator = vm.smallPageAllocator;
+
         return PosixResult::Success;
     }
 
@@ -335,6 +334,9 @@ namespace skyline::service::nvdrv::device::nvhost {
         if (!vm.initialised)
             return PosixResult::InvalidArgument;
 
+        // All entries are validated before any of them are applied, they're then applied as a single batch so the GMMU only has to update its page table and invalidate translations once for every merged range
+        std::vector<GMMU::MapOperation> operations;
+        operations.reserve(entries.size());
         for (const auto &entry : entries) {
             u64 virtAddr{static_cast<u64>(entry.asOffsetBigPages) << vm.bigPageSizeBits};
             u64 size{static_cast<u64>(entry.bigPages) << vm.bigPageSizeBits};
@@ -352,7 +354,7 @@ namespace skyline::service::nvdrv::device::nvhost {
             }
 
             if (!entry.handle) {
-                asCtx->gmmu.Map(virtAddr, GMMU::SparsePlaceholderAddress(), size, {true});
+                operations.push_back({virtAddr, GMMU::SparsePlaceholderAddress(), size, {true}});
             } else {
                 auto h{core.nvMap.GetHandle(entry.handle)};
                 if (!h)
@@ -360,10 +362,11 @@ namespace skyline::service::nvdrv::device::nvhost {
 
                 u8 *cpuPtr{reinterpret_cast<u8 *>(h->address + (static_cast<u64>(entry.handleOffsetBigPages) << vm.bigPageSizeBits))};
 
-                asCtx->gmmu.Map(virtAddr, cpuPtr, size);
+                operations.push_back({virtAddr, cpuPtr, size});
             }
         }
 
+        asCtx->gmmu.MapBatch(operations);
         return PosixResult::Success;
     }
 
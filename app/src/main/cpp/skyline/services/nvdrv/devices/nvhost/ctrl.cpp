@@ -9,6 +9,11 @@
 namespace skyline::service::nvdrv::device::nvhost {
     Ctrl::SyncpointEvent::SyncpointEvent(const DeviceState &state) : event(std::make_shared<type::KEvent>(state, false)) {}
 
+    Ctrl::SyncpointEvent::~SyncpointEvent() {
+        if (syncpoint)
+            syncpoint->DeregisterWaiter(*this);
+    }
+
     void Ctrl::SyncpointEvent::Signal() {
         // We should only signal the KEvent if the event is actively being waited on
         if (state.exchange(State::Signalling) == State::Waiting)
@@ -18,14 +23,14 @@ namespace skyline::service::nvdrv::device::nvhost {
     }
 
     void Ctrl::SyncpointEvent::Cancel(soc::host1x::Host1x &host1x) {
-        host1x.syncpoints.at(fence.id).DeregisterWaiter(waiterHandle);
-        waiterHandle = {};
+        host1x.syncpoints.at(fence.id).DeregisterWaiter(*this);
     }
 
     void Ctrl::SyncpointEvent::RegisterWaiter(soc::host1x::Host1x &host1x, const Fence &pFence) {
         fence = pFence;
         state = State::Waiting;
-        waiterHandle = host1x.syncpoints.at(fence.id).RegisterWaiter(fence.threshold, [this] { Signal(); });
+        syncpoint = &host1x.syncpoints.at(fence.id);
+        syncpoint->RegisterWaiter(*this, fence.threshold);
     }
 
     bool Ctrl::SyncpointEvent::IsInUse() {
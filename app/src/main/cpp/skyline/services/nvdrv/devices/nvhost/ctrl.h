@@ -36,10 +36,11 @@ namespace skyline::service::nvdrv::device::nvhost {
       private:
         /**
          * @brief Syncpoint Events are used to expose fences to the userspace, they can be waited on using an IOCTL or be converted into a native HOS KEvent object that can be waited on just like any other KEvent on the guest
+         * @note The event is embedded into the syncpoint's waiters while waiting, so waiting and cancelling don't allocate
          */
-        class SyncpointEvent {
+        class SyncpointEvent : public soc::host1x::SyncpointWaiter {
           private:
-            soc::host1x::Syncpoint::WaiterHandle waiterHandle{};
+            soc::host1x::Syncpoint *syncpoint{}; //!< The syncpoint that the event was last registered on
 
             void Signal();
 
@@ -55,6 +56,12 @@ namespace skyline::service::nvdrv::device::nvhost {
 
             SyncpointEvent(const DeviceState &state);
 
+            ~SyncpointEvent();
+
+            void OnThresholdReached() override {
+                Signal();
+            }
+
             std::atomic<State> state{State::Available};
             Fence fence{}; //!< The fence that is associated with this syncpoint event
             std::shared_ptr<type::KEvent> event{}; //!< Returned by 'QueryEvent'
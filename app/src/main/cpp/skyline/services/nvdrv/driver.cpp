@@ -10,8 +10,50 @@
 #include "devices/nvhost/host1x_channel.h"
 
 namespace skyline::service::nvdrv {
+    Driver::DeviceReference::DeviceReference(DeviceSlot *pSlot) : slot(pSlot) {
+        if (!slot)
+            return;
+
+        // The increment must be ordered before the load for CloseDevice to observe it, this is why both are sequentially consistent
+        slot->users.fetch_add(1);
+        device = slot->device.load();
+        if (!device) {
+            if (slot->users.fetch_sub(1) == 1)
+                slot->users.notify_all();
+            slot = nullptr;
+        }
+    }
+
+    Driver::DeviceReference::~DeviceReference() {
+        if (slot && slot->users.fetch_sub(1) == 1)
+            slot->users.notify_all();
+    }
+
     Driver::Driver(const DeviceState &state) : state(state), core(state) {}
 
+    Driver::~Driver() {
+        for (auto &slot : devices)
+            delete slot.device.exchange(nullptr);
+    }
+
+    Driver::DeviceReference Driver::GetDevice(FileDescriptor fd) {
+        if (fd < 0 || fd >= SessionFdLimit) [[unlikely]]
+            return DeviceReference{nullptr};
+        return DeviceReference{&devices[static_cast<size_t>(fd)]};
+    }
+
+    NvResult Driver::InsertDevice(FileDescriptor fd, std::unique_ptr<device::NvDevice> device) {
+        if (fd < 0 || fd >= SessionFdLimit)
+            return NvResult::FileOperationFailed;
+
+        device::NvDevice *expected{};
+        if (devices[static_cast<size_t>(fd)].device.compare_exchange_strong(expected, device.get()))
+            device.release();
+        else
+            Logger::Warn("Trying to open a device on an fd which is already in use: {}", fd);
+        return NvResult::Success;
+    }
+
     NvResult Driver::OpenDevice(std::string_view path, FileDescriptor fd, const SessionContext &ctx) {
         Logger::Debug("Opening NvDrv device ({}): {}", fd, path);
         auto pathHash{util::Hash(path)};
@@ -23,13 +65,9 @@ namespace skyline::service::nvdrv {
                     break;           \
             }
 
-        #define DEVICE_CASE(path, object, ...)                                                                     \
-            case util::Hash(path):                                                                                 \
-                {                                                                                                  \
-                    std::unique_lock lock(deviceMutex);                                                            \
-                    devices.emplace(fd, std::make_unique<device::object>(state, *this, core, ctx, ##__VA_ARGS__)); \
-                    return NvResult::Success;                                                                      \
-                }
+        #define DEVICE_CASE(path, object, ...)                                                          \
+            case util::Hash(path):                                                                      \
+                return InsertDevice(fd, std::make_unique<device::object>(state, *this, core, ctx, ##__VA_ARGS__));
 
         DEVICE_SWITCH(
             DEVICE_CASE("/dev/nvmap", NvMap)
@@ -84,55 +122,57 @@ namespace skyline::service::nvdrv {
     }
 
     NvResult Driver::Ioctl(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer) {
-        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
-
-        try {
-            std::shared_lock lock(deviceMutex);
-            return ConvertResult(devices.at(fd)->Ioctl(cmd, buffer));
-        } catch (const std::out_of_range &) {
+        auto device{GetDevice(fd)};
+        if (!device) [[unlikely]]
             throw exception("Ioctl was called with invalid fd: {}", fd);
-        }
+
+        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device->GetName());
+        return ConvertResult(device->Ioctl(cmd, buffer));
     }
 
     NvResult Driver::Ioctl2(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer, span<u8> inlineBuffer) {
-        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
-
-        try {
-            std::shared_lock lock(deviceMutex);
-            return ConvertResult(devices.at(fd)->Ioctl2(cmd, buffer, inlineBuffer));
-        } catch (const std::out_of_range &) {
+        auto device{GetDevice(fd)};
+        if (!device) [[unlikely]]
             throw exception("Ioctl2 was called with invalid fd: {}", fd);
-        }
+
+        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device->GetName());
+        return ConvertResult(device->Ioctl2(cmd, buffer, inlineBuffer));
     }
 
     NvResult Driver::Ioctl3(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer, span<u8> inlineBuffer) {
-        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
-
-        try {
-            std::shared_lock lock(deviceMutex);
-            return ConvertResult(devices.at(fd)->Ioctl3(cmd, buffer, inlineBuffer));
-        } catch (const std::out_of_range &) {
+        auto device{GetDevice(fd)};
+        if (!device) [[unlikely]]
             throw exception("Ioctl3 was called with invalid fd: {}", fd);
-        }
+
+        Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device->GetName());
+        return ConvertResult(device->Ioctl3(cmd, buffer, inlineBuffer));
     }
 
     void Driver::CloseDevice(FileDescriptor fd) {
-        try {
-            std::unique_lock lock(deviceMutex);
-            devices.erase(fd);
-        } catch (const std::out_of_range &) {
-            Logger::Warn("Trying to close invalid fd: {}");
+        if (fd < 0 || fd >= SessionFdLimit) {
+            Logger::Warn("Trying to close invalid fd: {}", fd);
+            return;
         }
+
+        auto &slot{devices[static_cast<size_t>(fd)]};
+        auto device{slot.device.exchange(nullptr)};
+        if (!device) {
+            Logger::Warn("Trying to close invalid fd: {}", fd);
+            return;
+        }
+
+        // Any references which were created before the exchange are waited on, later ones will observe the slot being empty
+        while (auto users{slot.users.load()})
+            slot.users.wait(users);
+        delete device;
     }
 
     std::shared_ptr<kernel::type::KEvent> Driver::QueryEvent(FileDescriptor fd, u32 eventId) {
-        Logger::Debug("fd: {}, eventId: 0x{:X}, device: {}", fd, eventId, devices.at(fd)->GetName());
-
-        try {
-            std::shared_lock lock(deviceMutex);
-            return devices.at(fd)->QueryEvent(eventId);
-        } catch (const std::exception &) {
+        auto device{GetDevice(fd)};
+        if (!device) [[unlikely]]
             throw exception("QueryEvent was called with invalid fd: {}", fd);
-        }
+
+        Logger::Debug("fd: {}, eventId: 0x{:X}, device: {}", fd, eventId, device->GetName());
+        return device->QueryEvent(eventId);
     }
 }
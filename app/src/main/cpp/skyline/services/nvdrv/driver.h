@@ -10,26 +10,67 @@
 #include "devices/nvdevice.h"
 
 namespace skyline::service::nvdrv {
-    namespace device {
-        namespace nvhost {
-            class AsGpu;
-        }
-    }
-
     class Driver {
       private:
         const DeviceState &state;
 
-        std::shared_mutex deviceMutex; //!< Protects access to `devices`
-        std::unordered_map<FileDescriptor, std::unique_ptr<device::NvDevice>> devices;
+        /**
+         * @brief An entry in the device table, devices are looked up without taking any locks as this is done for every IOCTL
+         */
+        struct DeviceSlot {
+            std::atomic<device::NvDevice *> device{}; //!< The device open on this fd, this is null if there's none
+            std::atomic<u32> users{}; //!< The amount of references to the device, it's only destroyed after this drops to zero
+        };
 
-        friend device::nvhost::AsGpu; // For channel address space binding
+        std::array<DeviceSlot, SessionFdLimit> devices{}; //!< The device table indexed by fd
+
+        /**
+         * @brief Inserts a newly opened device into the device table
+         */
+        NvResult InsertDevice(FileDescriptor fd, std::unique_ptr<device::NvDevice> device);
 
       public:
+        /**
+         * @brief A reference to an open device, the device can be closed concurrently but won't be destroyed till all references to it are gone
+         */
+        class DeviceReference {
+          private:
+            DeviceSlot *slot{};
+            device::NvDevice *device{};
+
+          public:
+            DeviceReference(DeviceSlot *slot);
+
+            DeviceReference(const DeviceReference &) = delete;
+
+            DeviceReference &operator=(const DeviceReference &) = delete;
+
+            ~DeviceReference();
+
+            explicit operator bool() const {
+                return device;
+            }
+
+            device::NvDevice *operator->() const {
+                return device;
+            }
+
+            device::NvDevice &operator*() const {
+                return *device;
+            }
+        };
+
         Core core; //!< The core global state object of nvdrv that is accessed by devices
 
         Driver(const DeviceState &state);
 
+        ~Driver();
+
+        /**
+         * @return A reference to the device specified by `fd`, this is empty if there's no device open on it
+         */
+        DeviceReference GetDevice(FileDescriptor fd);
+
         /**
          * @brief Creates a new device as specified by path
          * @param path The /dev path that corresponds to the device
@@ -60,10 +60,16 @@ namespace skyline::service {
     ServiceManager::ServiceManager(const DeviceState &state) : state(state), smUserInterface(std::make_shared<sm::IUserInterface>(state, *this)), globalServiceState(std::make_shared<GlobalServiceState>(state)) {}
 
     std::shared_ptr<BaseService> ServiceManager::CreateOrGetService(ServiceName name) {
+        std::lock_guard serviceGuard(mutex);
+        return CreateOrGetServiceLocked(name);
+    }
+
+    std::shared_ptr<BaseService> ServiceManager::CreateOrGetServiceLocked(ServiceName name) {
         auto serviceIter{serviceMap.find(name)};
         if (serviceIter != serviceMap.end())
             return (*serviceIter).second;
 
+        TRACE_BOOT_PHASE(ServiceInit, "ServiceManager::CreateOrGetService");
         switch (name) {
             SERVICE_CASE(fatalsrv::IService, "fatal:u")
             SERVICE_CASE(settings::ISettingsServer, "set")
@@ -113,9 +119,10 @@ namespace skyline::service {
 
     std::shared_ptr<BaseService> ServiceManager::NewService(ServiceName name, type::KSession &session, ipc::IpcResponse &response) {
         std::lock_guard serviceGuard(mutex);
-        auto serviceObject{CreateOrGetService(name)};
+        auto serviceObject{CreateOrGetServiceLocked(name)};
         KHandle handle{};
         if (session.isDomain) {
+            std::unique_lock domainLock(session.domainMutex);
             session.domains.push_back(serviceObject);
             response.domainObjects.push_back(session.handleIndex);
             handle = session.handleIndex++;
@@ -132,6 +139,7 @@ namespace skyline::service {
         KHandle handle{};
 
         if (session.isDomain) {
+            std::unique_lock domainLock(session.domainMutex);
             session.domains.push_back(serviceObject);
             response.domainObjects.push_back(session.handleIndex);
             handle = session.handleIndex++;
@@ -148,6 +156,7 @@ namespace skyline::service {
         auto session{state.process->GetHandle<type::KSession>(handle)};
         if (session->isOpen) {
             if (session->isDomain) {
+                std::shared_lock domainLock(session->domainMutex);
                 for (const auto &domainService : session->domains)
                     std::erase_if(serviceMap, [domainService](const auto &entry) {
                         return entry.second == domainService;
@@ -176,25 +185,39 @@ namespace skyline::service {
                 case ipc::CommandType::RequestWithContext:
                     if (session->isDomain) {
                         try {
-                            auto service{session->domains.at(request.domain->objectId)};
+                            // Only the lookup of the domain object is done under the domain lock, the request itself is handled without any locks held so requests on unrelated sessions or domain objects run in parallel
+                            auto service{[&] {
+                                std::shared_lock domainLock(session->domainMutex);
+                                return session->domains.at(request.domain->objectId);
+                            }()};
                             if (service == nullptr)
                                 throw exception("Domain request used an expired handle");
                             switch (request.domain->command) {
-                                case ipc::DomainCommand::SendMessage:
+                                case ipc::DomainCommand::SendMessage: {
+                                    std::optional<SchedulerScopedLock> schedulerLock;
+                                    if (service->IsBlocking())
+                                        schedulerLock.emplace(state);
                                     response.errorCode = service->HandleRequest(*session, request, response);
                                     break;
+                                }
 
-                                case ipc::DomainCommand::CloseVHandle:
+                                case ipc::DomainCommand::CloseVHandle: {
+                                    std::scoped_lock lock(mutex, session->domainMutex);
                                     std::erase_if(serviceMap, [service](const auto &entry) {
                                         return entry.second == service;
                                     });
-                                    session->domains.at(request.domain->objectId).reset();
+                                    session->domains.at(request.domain->objectId).reset(); // The service is only destroyed once the local reference to it goes out of scope, after the locks are released
                                     break;
+                                }
                             }
                         } catch (std::out_of_range &) {
                             throw exception("Invalid object ID was used with domain request");
                         }
                     } else {
+                        // Services which may block are handled with the thread removed from its core's queue, so other guest threads can be scheduled on the core while it's blocked on the host
+                        std::optional<SchedulerScopedLock> schedulerLock;
+                        if (session->serviceObject->IsBlocking())
+                            schedulerLock.emplace(state);
                         response.errorCode = session->serviceObject->HandleRequest(*session, request, response);
                     }
                     response.WriteResponse(session->isDomain);
@@ -19,7 +19,12 @@ namespace skyline::service {
       private:
         const DeviceState &state;
         std::unordered_map<ServiceName, std::shared_ptr<BaseService>> serviceMap; //!< A mapping from a Service to the underlying object
-        std::mutex mutex; //!< Synchronizes concurrent access to services to prevent crashes
+        std::mutex mutex; //!< Synchronizes access to the service map, this isn't held while requests are handled as those are only serialized per-session
+
+        /**
+         * @note The mutex MUST be locked when calling this
+         */
+        std::shared_ptr<BaseService> CreateOrGetServiceLocked(ServiceName name);
 
       public:
         std::shared_ptr<BaseService> smUserInterface; //!< Used by applications to open connections to services
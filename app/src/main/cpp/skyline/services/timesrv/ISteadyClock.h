@@ -37,6 +37,10 @@ namespace skyline::service::timesrv {
 
         Result GetInternalOffset(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        bool IsBlocking() override {
+            return false;
+        }
+
         SERVICE_DECL(
             SFUNC(0x0, ISteadyClock, GetCurrentTimePoint),
             SFUNC(0x2, ISteadyClock, GetTestOffset),
@@ -36,6 +36,10 @@ namespace skyline::service::timesrv {
 
         Result GetOperationEventReadableHandle(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        bool IsBlocking() override {
+            return false;
+        }
+
         SERVICE_DECL(
             SFUNC(0x0, ISystemClock, GetCurrentTime),
             SFUNC(0x1, ISystemClock, SetCurrentTime),
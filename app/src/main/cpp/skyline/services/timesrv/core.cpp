@@ -29,11 +29,24 @@ namespace skyline::service::timesrv::core {
         return GetRawTimePoint() + GetTestOffset() + GetInternalOffset();
     }
 
+    void StandardSteadyClockCore::UpdateContext() {
+        rawOffset.store(rtcOffset.Nanoseconds(), std::memory_order_relaxed);
+        currentOffset.store((rtcOffset + internalOffset + testOffset).Nanoseconds(), std::memory_order_relaxed);
+
+        // The guest derives the current timepoint by adding its system tick to the context, which is exactly the precomputed offset
+        timeSharedMemory.UpdateStandardSteadyClockContext(SteadyClockTimePoint{
+            .timePoint = currentOffset.load(std::memory_order_relaxed),
+            .clockSourceId = rtcId,
+        });
+    }
+
     void StandardSteadyClockCore::Setup(UUID pRtcId, TimeSpanType pRtcOffset, TimeSpanType pInternalOffset, TimeSpanType pTestOffset, bool rtcResetDetected) {
+        std::lock_guard lock(mutex);
         rtcId = pRtcId;
         rtcOffset = pRtcOffset;
         internalOffset = pInternalOffset;
         testOffset = pTestOffset;
+        UpdateContext();
 
         if (rtcResetDetected)
             SetRtcReset();
@@ -41,6 +54,25 @@ namespace skyline::service::timesrv::core {
         MarkInitialized();
     }
 
+    void StandardSteadyClockCore::SetRtcOffset(TimeSpanType offset) {
+        std::lock_guard lock(mutex);
+        rtcOffset = offset;
+        UpdateContext();
+    }
+
+    ResultValue<SteadyClockTimePoint> StandardSteadyClockCore::GetCurrentTimePoint() {
+        SteadyClockTimePoint timePoint{
+            .timePoint = GetCurrentRawTimePoint().Seconds(),
+            .clockSourceId = rtcId,
+        };
+
+        return timePoint;
+    }
+
+    TimeSpanType StandardSteadyClockCore::GetCurrentRawTimePoint() {
+        return TimeSpanType::FromNanoseconds(util::GetTimeNs() + currentOffset.load(std::memory_order_relaxed));
+    }
+
     ResultValue<SteadyClockTimePoint> StandardSteadyClockCore::GetTimePoint() {
         SteadyClockTimePoint timePoint{
             .timePoint = GetRawTimePoint().Seconds(),
@@ -51,13 +83,30 @@ namespace skyline::service::timesrv::core {
     }
 
     TimeSpanType StandardSteadyClockCore::GetRawTimePoint() {
+        // The system tick is monotonic so the timepoint can never decrease without the offsets being changed
+        return TimeSpanType::FromNanoseconds(util::GetTimeNs() + rawOffset.load(std::memory_order_relaxed));
+    }
+
+    TimeSpanType StandardSteadyClockCore::GetTestOffset() {
         std::lock_guard lock(mutex);
+        return testOffset;
+    }
 
-        auto timePoint{TimeSpanType::FromNanoseconds(util::GetTimeNs()) + rtcOffset};
-        if (timePoint > cachedValue)
-            cachedValue = timePoint;
+    void StandardSteadyClockCore::SetTestOffset(TimeSpanType offset) {
+        std::lock_guard lock(mutex);
+        testOffset = offset;
+        UpdateContext();
+    }
 
-        return timePoint;
+    TimeSpanType StandardSteadyClockCore::GetInternalOffset() {
+        std::lock_guard lock(mutex);
+        return internalOffset;
+    }
+
+    void StandardSteadyClockCore::SetInternalOffset(TimeSpanType offset) {
+        std::lock_guard lock(mutex);
+        internalOffset = offset;
+        UpdateContext();
     }
 
     ResultValue<SteadyClockTimePoint> TickBasedSteadyClockCore::GetTimePoint() {
@@ -221,6 +270,7 @@ namespace skyline::service::timesrv::core {
         : timeSharedMemory(state),
           localSystemClockContextWriter(timeSharedMemory),
           networkSystemClockContextWriter(timeSharedMemory),
+          standardSteadyClock(timeSharedMemory),
           localSystemClock(standardSteadyClock),
           networkSystemClock(standardSteadyClock),
           userSystemClock(state, standardSteadyClock, localSystemClock, networkSystemClock, timeSharedMemory),
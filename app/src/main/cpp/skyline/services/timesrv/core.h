@@ -46,12 +46,12 @@ namespace skyline::service::timesrv::core {
         /**
          * @brief Returns the current timepoint of the clock including offsets in a SteadyClockTimePoint struct with a source UUID
          */
-        ResultValue<SteadyClockTimePoint> GetCurrentTimePoint();
+        virtual ResultValue<SteadyClockTimePoint> GetCurrentTimePoint();
 
         /**
          * @brief Returns the current raw timepoint of the clock including offsets but without any UUID, this may have higher accuracy
          */
-        TimeSpanType GetCurrentRawTimePoint();
+        virtual TimeSpanType GetCurrentRawTimePoint();
 
         /**
          * @brief Returns the base timepoint of the clock without any offsets applied in a SteadyClockTimePoint struct with a source UUID
@@ -100,39 +100,46 @@ namespace skyline::service::timesrv::core {
      */
     class StandardSteadyClockCore : public SteadyClockCore {
       private:
-        std::mutex mutex; //!< Protects accesses to cachedValue
+        TimeSharedMemory &timeSharedMemory;
+        std::mutex mutex; //!< Serialises changes to the offsets of the clock
         TimeSpanType testOffset{};
         TimeSpanType internalOffset{};
         TimeSpanType rtcOffset{}; //!< The offset between the RTC timepoint and the raw timepoints of this clock
-        TimeSpanType cachedValue{}; //!< Stores the cached time value, used to prevent time ever decreasing
+        std::atomic<i64> rawOffset{}; //!< The offset in nanoseconds between the system tick and the raw timepoint of this clock, this is the RTC offset
+        std::atomic<i64> currentOffset{}; //!< The offset in nanoseconds between the system tick and the current timepoint of this clock, this is the sum of all offsets
         UUID rtcId{}; //!< UUID of the RTC this is calibrated against
 
+        /**
+         * @brief Recomputes the tick offsets of the clock and publishes them into shared memory, this is the only point at which the steady clock context is written
+         * @note The mutex must be locked prior to calling this
+         */
+        void UpdateContext();
+
       public:
+        StandardSteadyClockCore(TimeSharedMemory &timeSharedMemory) : timeSharedMemory(timeSharedMemory) {}
+
         void Setup(UUID rtcId, TimeSpanType pRtcOffset, TimeSpanType pInternalOffset, TimeSpanType pTestOffset, bool rtcResetDetected);
 
-        void SetRtcOffset(TimeSpanType offset) {
-            rtcOffset = offset;
-        }
+        void SetRtcOffset(TimeSpanType offset);
+
+        /**
+         * @note Timepoints are derived from the system tick and the precomputed offsets without any locking, this matches the shared memory path the guest uses
+         */
+        ResultValue<SteadyClockTimePoint> GetCurrentTimePoint() override;
+
+        TimeSpanType GetCurrentRawTimePoint() override;
 
         ResultValue<SteadyClockTimePoint> GetTimePoint() override;
 
         TimeSpanType GetRawTimePoint() override;
 
-        TimeSpanType GetTestOffset() override {
-            return testOffset;
-        }
+        TimeSpanType GetTestOffset() override;
 
-        void SetTestOffset(TimeSpanType offset) override {
-            testOffset = offset;
-        }
+        void SetTestOffset(TimeSpanType offset) override;
 
-        TimeSpanType GetInternalOffset() override {
-            return internalOffset;
-        }
+        TimeSpanType GetInternalOffset() override;
 
-        void SetInternalOffset(TimeSpanType offset) override {
-            internalOffset = offset;
-        }
+        void SetInternalOffset(TimeSpanType offset) override;
     };
 
     /**
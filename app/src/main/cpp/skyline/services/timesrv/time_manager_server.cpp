@@ -27,9 +27,6 @@ namespace skyline::service::timesrv {
 
     Result TimeManagerServer::SetupStandardSteadyClock(UUID rtcId, TimeSpanType rtcOffset, TimeSpanType internalOffset, TimeSpanType testOffset, bool rtcResetDetected) {
         core.standardSteadyClock.Setup(rtcId, rtcOffset, internalOffset, testOffset, rtcResetDetected);
-
-        auto timePoint{core.standardSteadyClock.GetCurrentRawTimePoint()};
-        core.timeSharedMemory.SetupStandardSteadyClock(rtcId, timePoint);
         return {};
     }
 
@@ -66,7 +63,6 @@ namespace skyline::service::timesrv {
 
     Result TimeManagerServer::SetStandardSteadyClockRtcOffset(TimeSpanType rtcOffset) {
         core.standardSteadyClock.SetRtcOffset(rtcOffset);
-        core.timeSharedMemory.SetSteadyClockRawTimePoint(core.standardSteadyClock.GetCurrentRawTimePoint());
 
         return {};
     }
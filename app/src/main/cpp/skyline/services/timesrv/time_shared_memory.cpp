@@ -40,40 +40,15 @@ namespace skyline::service::timesrv::core {
         updateCount = newCount;
     }
 
-    /**
-     * @brief Waits for Time Shared Memory to settle then returns the latest version of the requested value
-     */
-    template<typename T>
-    static T ReadTimeSharedMemoryItem(u32 &updateCount, std::array<T, 2> &item) {
-        u32 checkUpdateCount{};
-        T out{};
-
-        do {
-            checkUpdateCount = updateCount;
-            out = item[updateCount & 1];
-            std::atomic_thread_fence(std::memory_order_consume);
-        } while (checkUpdateCount != updateCount);
-
-        return out;
-    }
-
     TimeSharedMemory::TimeSharedMemory(const DeviceState &state)
         : kTimeSharedMemory(std::make_shared<kernel::type::KSharedMemory>(state, TimeSharedMemorySize)),
           timeSharedMemory(reinterpret_cast<TimeSharedMemoryLayout *>(kTimeSharedMemory->host.ptr)) {}
 
-    void TimeSharedMemory::SetupStandardSteadyClock(UUID rtcId, TimeSpanType baseTimePoint) {
-        SteadyClockTimePoint context{
-            .timePoint = baseTimePoint.Nanoseconds() - util::GetTimeNs(),
-            .clockSourceId = rtcId
-        };
-
-        UpdateTimeSharedMemoryItem(timeSharedMemory->standardSteadyClockContextEntry.updateCount, timeSharedMemory->standardSteadyClockContextEntry.context, context);
-    }
-
-    void TimeSharedMemory::SetSteadyClockRawTimePoint(TimeSpanType timePoint) {
-        auto context{ReadTimeSharedMemoryItem(timeSharedMemory->standardSteadyClockContextEntry.updateCount, timeSharedMemory->standardSteadyClockContextEntry.context)};
-        context.timePoint = timePoint.Nanoseconds() - util::GetTimeNs();
+    void TimeSharedMemory::UpdateStandardSteadyClockContext(const SteadyClockTimePoint &context) {
+        if (steadyClockContext && *steadyClockContext == context)
+            return;
 
+        steadyClockContext = context;
         UpdateTimeSharedMemoryItem(timeSharedMemory->standardSteadyClockContextEntry.updateCount, timeSharedMemory->standardSteadyClockContextEntry.context, context);
     }
 
@@ -19,6 +19,7 @@ namespace skyline::service::timesrv::core {
       private:
         std::shared_ptr<kernel::type::KSharedMemory> kTimeSharedMemory;
         TimeSharedMemoryLayout *timeSharedMemory;
+        std::optional<SteadyClockTimePoint> steadyClockContext; //!< The last steady clock context written to shmem, this avoids reading it back or rewriting it redundantly
 
       public:
         TimeSharedMemory(const DeviceState &state);
@@ -28,11 +29,10 @@ namespace skyline::service::timesrv::core {
         }
 
         /**
-         * @brief Fills in the steady clock section of shmem, the current time is subtracted from baseTimePoint to workout the offset
+         * @brief Fills in the steady clock section of shmem if it differs from the current context
+         * @param context The offset in nanoseconds between the system tick and the current steady clock timepoint alongside the clock source
          */
-        void SetupStandardSteadyClock(UUID rtcId, TimeSpanType baseTimePoint);
-
-        void SetSteadyClockRawTimePoint(TimeSpanType timePoint);
+        void UpdateStandardSteadyClockContext(const SteadyClockTimePoint &context);
 
         void UpdateLocalSystemClockContext(const SystemClockContext &context);
 
@@ -6,12 +6,13 @@
 
 namespace skyline::soc::gm20b {
     ChannelContext::ChannelContext(const DeviceState &state, std::shared_ptr<AddressSpaceContext> asCtx, size_t numEntries) :
-        fermi2D(state),
-        keplerMemory(state),
+        fermi2D(state, *this),
+        keplerMemory(state, *this),
         maxwell3D(std::make_unique<engine::maxwell3d::Maxwell3D>(state, *this, executor)),
-        maxwellCompute(state),
-        maxwellDma(state),
+        maxwellCompute(state, *this),
+        maxwellDma(state, *this),
         gpfifo(state, *this, numEntries),
         executor(state),
-        asCtx(std::move(asCtx)){}
+        asCtx(std::move(asCtx)),
+        gmmuTlb(this->asCtx->gmmu) {}
 }
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unistd.h>
+#include <common/signal.h>
+#include <common/performance_hint.h>
+#include "channel_scheduler.h"
+#include "gpfifo.h"
+
+namespace skyline::soc::gm20b {
+    ChannelScheduler::BlockingScope::BlockingScope(ChannelScheduler &scheduler) : scheduler(scheduler) {
+        std::scoped_lock lock(scheduler.mutex);
+        scheduler.runningWorkers--;
+        scheduler.SpawnWorkers();
+    }
+
+    ChannelScheduler::BlockingScope::~BlockingScope() {
+        std::scoped_lock lock(scheduler.mutex);
+        scheduler.runningWorkers++;
+    }
+
+    ChannelScheduler::~ChannelScheduler() {
+        {
+            std::scoped_lock lock(mutex);
+            exit = true;
+            for (auto &worker : workers)
+                if (worker.channel)
+                    worker.channel->cancelled.store(true, std::memory_order_relaxed);
+        }
+        workCondition.notify_all();
+
+        for (auto &worker : workers)
+            worker.thread.join();
+    }
+
+    void ChannelScheduler::WorkerThread(Worker *worker) {
+        pthread_setname_np(pthread_self(), "GPFIFO");
+        signal::SetSignalHandler({SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+        auto tid{static_cast<i32>(gettid())};
+        perf::PerformanceHintSession::Get().AddThread(tid);
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            idleWorkers++;
+            workCondition.wait(lock, [&]() { return exit || (!queue.empty() && runningWorkers < WorkerCount); });
+            idleWorkers--;
+            if (exit) {
+                perf::PerformanceHintSession::Get().RemoveThread(tid);
+                return;
+            }
+
+            auto channel{queue.front()};
+            queue.pop_front();
+            worker->channel = channel;
+            runningWorkers++;
+
+            lock.unlock();
+            bool pending{channel->Run()};
+            lock.lock();
+
+            runningWorkers--;
+            worker->channel = nullptr;
+            if (pending && !channel->cancelled.load(std::memory_order_relaxed))
+                queue.push_back(channel); // The channel is queued behind all others so it can't starve them while entries are continuously pushed to it
+            idleCondition.notify_all();
+        }
+    }
+
+    void ChannelScheduler::SpawnWorkers() {
+        if (!queue.empty() && !idleWorkers && runningWorkers < WorkerCount) {
+            auto &worker{workers.emplace_back()};
+            worker.thread = std::thread(&ChannelScheduler::WorkerThread, this, &worker);
+        } else if (!queue.empty()) {
+            workCondition.notify_one();
+        }
+    }
+
+    void ChannelScheduler::Schedule(ChannelGpfifo *channel) {
+        std::scoped_lock lock(mutex);
+        queue.push_back(channel);
+        SpawnWorkers();
+    }
+
+    void ChannelScheduler::Cancel(ChannelGpfifo *channel) {
+        channel->cancelled.store(true, std::memory_order_relaxed);
+
+        std::unique_lock lock(mutex);
+        std::erase(queue, channel);
+        idleCondition.wait(lock, [&]() {
+            return std::none_of(workers.begin(), workers.end(), [&](const Worker &worker) { return worker.channel == channel; });
+        });
+    }
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <common.h>
+
+namespace skyline::soc::gm20b {
+    class ChannelGpfifo;
+
+    /**
+     * @brief The channel scheduler processes the GPFIFOs of all channels on a small shared pool of worker threads rather than a thread per channel
+     * @note A channel is only ever processed by a single worker at a time and is queued again after every batch of entries, this preserves the order of entries within a channel while channels can't starve each other
+     * @note Workers which block on other channels hand off their slot, another worker is created if there are queued channels and none are idle so a blocking wait can never starve the channel it depends on
+     */
+    class ChannelScheduler {
+      private:
+        static constexpr size_t WorkerCount{2}; //!< The amount of workers that process channels concurrently, most titles only use a single channel heavily at any time
+
+        /**
+         * @brief A single worker thread alongside the channel it's processing
+         */
+        struct Worker {
+            std::thread thread;
+            ChannelGpfifo *channel{}; //!< The channel which is being processed by the worker, this is null while the worker is idle
+        };
+
+        std::mutex mutex; //!< Synchronizes all members below
+        std::condition_variable workCondition; //!< Signalled when a channel has been queued or the scheduler is being destroyed
+        std::condition_variable idleCondition; //!< Signalled when a worker has finished processing a channel
+        std::list<Worker> workers; //!< A list is used as workers must have stable addresses
+        std::deque<ChannelGpfifo *> queue; //!< The channels with pending entries which aren't being processed by any worker
+        size_t idleWorkers{}; //!< The amount of workers waiting for a channel to be queued
+        size_t runningWorkers{}; //!< The amount of workers processing a channel which aren't blocked
+        bool exit{}; //!< If the workers should exit
+
+        void WorkerThread(Worker *worker);
+
+        /**
+         * @brief Creates a worker if there are queued channels that no idle worker can pick up while fewer than WorkerCount workers are running
+         * @note The mutex must be locked
+         */
+        void SpawnWorkers();
+
+      public:
+        /**
+         * @brief An RAII scope for a wait inside a channel which may only be satisfied by another channel, the worker doesn't count towards the running workers for its duration
+         */
+        class BlockingScope {
+          private:
+            ChannelScheduler &scheduler;
+
+          public:
+            BlockingScope(ChannelScheduler &scheduler);
+
+            ~BlockingScope();
+        };
+
+        ~ChannelScheduler();
+
+        /**
+         * @brief Queues a channel for processing by a worker
+         * @note This must only be called once for every transition of the channel into having pending entries, ChannelGpfifo tracks this
+         */
+        void Schedule(ChannelGpfifo *channel);
+
+        /**
+         * @brief Removes a channel from the scheduler, if it's being processed then processing is interrupted and this waits for the worker to stop
+         * @note No more entries must be pushed to the channel after this
+         */
+        void Cancel(ChannelGpfifo *channel);
+    };
+}
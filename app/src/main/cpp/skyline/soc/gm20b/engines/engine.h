@@ -25,6 +25,15 @@ namespace skyline::soc::gm20b {
             void CallMethod(u32 method, u32 argument, bool lastCall) {
                 Logger::Warn("Called method in unimplemented engine: 0x{:X} args: 0x{:X}", method, argument);
             };
+
+            /**
+             * @brief Calls an engine method with a run of arguments, this is equivalent to calling CallMethod for every argument but avoids dispatching each one individually
+             * @param increment If the method address should be incremented after every argument (IncMethod) or stay the same (NonIncMethod)
+             * @param lastCall If the final argument in the batch is also the final argument of the method
+             */
+            void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+                Logger::Warn("Called method batch in unimplemented engine: 0x{:X} count: {}", method, arguments.size());
+            };
         };
     }
 }
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <gpu/interconnect/graphics_context.h>
+#include <soc/gm20b/channel.h>
+#include "fermi_2d.h"
+
+namespace skyline::soc::gm20b::engine {
+    #define FERMI2D_OFFSET(field) U32_OFFSET(Registers, field)
+
+    Fermi2D::Fermi2D(const DeviceState &state, ChannelContext &channelCtx) : Engine(state), channelCtx(channelCtx) {}
+
+    std::optional<gpu::GuestTexture> Fermi2D::GetGuestTexture(const Registers::Surface &surface) {
+        auto format{gpu::interconnect::GraphicsContext::ConvertRenderTargetFormat(surface.format)};
+        if (!format)
+            return std::nullopt;
+
+        gpu::GuestTexture guest;
+        guest.format = format;
+        guest.dimensions = gpu::texture::Dimensions(surface.width, surface.height, 1);
+        guest.type = gpu::texture::TextureType::e2D;
+
+        u64 size;
+        if (surface.memoryLayout == Registers::MemoryLayout::Pitch) {
+            guest.tileConfig = gpu::texture::TileConfig{
+                .mode = gpu::texture::TileMode::Pitch,
+                .pitch = surface.pitch / format->bpb, // The pitch of guest textures is in texels rather than bytes
+            };
+            size = static_cast<u64>(surface.pitch) * surface.height;
+        } else {
+            guest.tileConfig = gpu::texture::TileConfig{
+                .mode = gpu::texture::TileMode::Block,
+                .blockHeight = static_cast<u8>(1U << surface.blockSize.heightLog2),
+                .blockDepth = static_cast<u8>(1U << surface.blockSize.depthLog2),
+            };
+            size = format->GetSize(guest.dimensions); // This matches the size of render targets so blits to and from them find the same texture
+        }
+
+        if (surface.layer)
+            Logger::Warn("Fermi 2D surface layers aren't supported: {}", surface.layer);
+
+        auto mappings{channelCtx.asCtx->gmmu.TranslateRange(surface.address.Pack(), size)};
+        guest.mappings.assign(mappings.begin(), mappings.end());
+        return guest;
+    }
+
+    void Fermi2D::Blit() {
+        TRACE_EVENT("gpu", "Fermi2D::Blit");
+
+        auto &pixels{registers.pixelsFromMemory};
+        if (pixels.dstWidth <= 0 || pixels.dstHeight <= 0)
+            return;
+
+        // The source region is derived from the destination region and the per-pixel steps, flipped blits have negative steps which we don't handle
+        constexpr double FixedPointScale{static_cast<double>(1ULL << 32)};
+        double duDx{static_cast<double>(pixels.duDx) / FixedPointScale}, dvDy{static_cast<double>(pixels.dvDy) / FixedPointScale};
+        if (duDx <= 0 || dvDy <= 0) [[unlikely]] {
+            Logger::Warn("Fermi 2D blits with non-positive steps aren't supported: {}x{}", duDx, dvDy);
+            return;
+        }
+
+        double srcX0{static_cast<double>(pixels.srcX0) / FixedPointScale}, srcY0{static_cast<double>(pixels.srcY0) / FixedPointScale};
+        if (pixels.sampleMode.origin == Registers::SampleOrigin::Corner) {
+            // Host blits always sample at the centers of destination pixels, so corner-origin coordinates are shifted back by half a step to sample the same locations
+            srcX0 -= duDx / 2;
+            srcY0 -= dvDy / 2;
+        }
+
+        auto srcGuest{GetGuestTexture(registers.src)}, dstGuest{GetGuestTexture(registers.dst)};
+        if (!srcGuest || !dstGuest) [[unlikely]] {
+            Logger::Warn("Fermi 2D blit with a surface that has no format");
+            return;
+        }
+
+        // Either surface may be a single layer of an array texture, the blit is done on the layer it corresponds to
+        auto sourceView{state.gpu->texture.FindOrCreate(*srcGuest)}, destinationView{state.gpu->texture.FindOrCreate(*dstGuest, true)};
+        auto source{sourceView.backing}, destination{destinationView.backing};
+        if (source == destination) [[unlikely]] {
+            Logger::Warn("Fermi 2D blits within a single surface aren't supported");
+            return;
+        }
+
+        auto sourceFeatures{state.gpu->vkPhysicalDevice.getFormatProperties(*source->format).optimalTilingFeatures};
+        auto destinationFeatures{state.gpu->vkPhysicalDevice.getFormatProperties(*destination->format).optimalTilingFeatures};
+        if (!(sourceFeatures & vk::FormatFeatureFlagBits::eBlitSrc) || !(destinationFeatures & vk::FormatFeatureFlagBits::eBlitDst) || source->format->vkAspect != destination->format->vkAspect) [[unlikely]] {
+            Logger::Warn("Fermi 2D blit between unsupported formats: {} -> {}", vk::to_string(source->format->vkFormat), vk::to_string(destination->format->vkFormat));
+            return;
+        }
+
+        // Regions are clamped in guest coordinates and then scaled to the resolution of each host texture
+        auto clampRect{[](i64 left, i64 top, i64 right, i64 bottom, const gpu::texture::Dimensions &dimensions) {
+            left = std::clamp<i64>(left, 0, dimensions.width);
+            right = std::clamp<i64>(right, left, dimensions.width);
+            top = std::clamp<i64>(top, 0, dimensions.height);
+            bottom = std::clamp<i64>(bottom, top, dimensions.height);
+            return vk::Rect2D{
+                .offset = {static_cast<i32>(left), static_cast<i32>(top)},
+                .extent = {static_cast<u32>(right - left), static_cast<u32>(bottom - top)},
+            };
+        }};
+        auto srcRect{source->ScaleRect(clampRect(std::lround(srcX0), std::lround(srcY0), std::lround(srcX0 + (pixels.dstWidth * duDx)), std::lround(srcY0 + (pixels.dstHeight * dvDy)), srcGuest->dimensions))};
+        auto dstRect{destination->ScaleRect(clampRect(pixels.dstX0, pixels.dstY0, static_cast<i64>(pixels.dstX0) + pixels.dstWidth, static_cast<i64>(pixels.dstY0) + pixels.dstHeight, dstGuest->dimensions))};
+        if (!srcRect.extent.width || !srcRect.extent.height || !dstRect.extent.width || !dstRect.extent.height)
+            return;
+
+        auto toOffsets{[](vk::Rect2D rect) {
+            return std::array<vk::Offset3D, 2>{vk::Offset3D{rect.offset.x, rect.offset.y, 0}, vk::Offset3D{rect.offset.x + static_cast<i32>(rect.extent.width), rect.offset.y + static_cast<i32>(rect.extent.height), 1}};
+        }};
+        vk::ImageBlit region{
+            .srcSubresource = {
+                .aspectMask = source->format->vkAspect,
+                .baseArrayLayer = sourceView.range.baseArrayLayer,
+                .layerCount = 1,
+            },
+            .srcOffsets = toOffsets(srcRect),
+            .dstSubresource = {
+                .aspectMask = destination->format->vkAspect,
+                .baseArrayLayer = destinationView.range.baseArrayLayer,
+                .layerCount = 1,
+            },
+            .dstOffsets = toOffsets(dstRect),
+        };
+        vk::Filter filter{pixels.sampleMode.filter == Registers::SampleFilter::Bilinear && (sourceFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest};
+
+        channelCtx.executor.AttachTexture(source.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+        channelCtx.executor.AttachTexture(destination.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        channelCtx.executor.AddOutsideRpCommand([source = std::move(source), destination = std::move(destination), region, filter](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, gpu::GPU &) {
+            destination->RecordBlitFrom(commandBuffer, source, region, filter);
+            cycle->AttachObjects(source, destination);
+            source->cycle = cycle;
+            destination->cycle = cycle;
+        });
+    }
+
+    void Fermi2D::CallMethod(u32 method, u32 argument, bool lastCall) {
+        CallMethodBatch(method, span<u32>(&argument, 1), true, lastCall);
+    }
+
+    void Fermi2D::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        Logger::Debug("Called method batch in Fermi 2D: 0x{:X} count: {} increment: {}", method, arguments.size(), increment);
+
+        if (method + (increment ? arguments.size() : 1) > RegisterCount) [[unlikely]] {
+            Logger::Debug("Ignoring untracked Fermi 2D method batch: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        constexpr u32 BlitMethod{FERMI2D_OFFSET(pixelsFromMemory.srcY0) + 1}; //!< The integer part of the source Y coordinate
+        if (!increment) {
+            if (method == BlitMethod) {
+                for (u32 argument : arguments) {
+                    registers.raw[method] = argument;
+                    Blit();
+                }
+            } else {
+                registers.raw[method] = arguments.back();
+            }
+            return;
+        }
+
+        // Registers written after the trigger in the same run apply to the next blit, so the blit must be done before they're written
+        if (method <= BlitMethod && BlitMethod < method + arguments.size()) {
+            auto blitIndex{BlitMethod - method + 1};
+            span(registers.raw).subspan(method).copy_from(arguments.first(blitIndex));
+            Blit();
+            arguments = arguments.subspan(blitIndex);
+            method = BlitMethod + 1;
+        }
+
+        span(registers.raw).subspan(method).copy_from(arguments);
+    }
+
+    #undef FERMI2D_OFFSET
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/texture/texture.h>
+#include "maxwell/types.h"
+#include "engine.h"
+
+namespace skyline::soc::gm20b {
+    struct ChannelContext;
+}
+
+namespace skyline::soc::gm20b::engine {
+    /**
+     * @brief The Fermi 2D engine handles blits between surfaces with scaling and format conversion, these are done as blits between host textures
+     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/classes/twod/cl902d.h
+     */
+    class Fermi2D : public Engine {
+      public:
+        static constexpr u32 RegisterCount{0x240}; //!< The number of Fermi 2D registers which are tracked, the registers past these aren't used for blits
+
+      private:
+        #pragma pack(push, 1)
+        union Registers {
+            std::array<u32, RegisterCount> raw;
+
+            enum class MemoryLayout : u32 {
+                BlockLinear = 0,
+                Pitch = 1,
+            };
+
+            struct Surface {
+                maxwell3d::type::RenderTarget::ColorFormat format; //!< The format of the surface, this uses the same encoding as Maxwell 3D render targets
+                MemoryLayout memoryLayout;
+                struct {
+                    u8 widthLog2 : 4; //!< The width of a block in GOBs, this is always a single GOB on the Tegra X1
+                    u8 heightLog2 : 4; //!< The height of a block in GOBs
+                    u8 depthLog2 : 4; //!< The depth of a block in GOBs
+                    u32 _pad_ : 20;
+                } blockSize;
+                u32 depth;
+                u32 layer;
+                u32 pitch; //!< The pitch of a pitch-linear surface in bytes
+                u32 width;
+                u32 height;
+                maxwell3d::type::Address address;
+            };
+            static_assert(sizeof(Surface) == (0xA * sizeof(u32)));
+
+            enum class SampleOrigin : u8 {
+                Center = 0,
+                Corner = 1,
+            };
+
+            enum class SampleFilter : u8 {
+                Point = 0,
+                Bilinear = 1,
+            };
+
+            /**
+             * @note The source coordinates and their per-pixel steps are signed 32.32 fixed point values
+             */
+            struct PixelsFromMemory {
+                u32 blockShape; // 0x220
+                u32 corralSize; // 0x221
+                u32 safeOverlap; // 0x222
+                struct {
+                    SampleOrigin origin : 1;
+                    u8 _pad0_ : 3;
+                    SampleFilter filter : 1;
+                    u32 _pad1_ : 27;
+                } sampleMode; // 0x223
+                u32 _pad_[0x8]; // 0x224
+                i32 dstX0; // 0x22C
+                i32 dstY0; // 0x22D
+                i32 dstWidth; // 0x22E
+                i32 dstHeight; // 0x22F
+                i64 duDx; // 0x230
+                i64 dvDy; // 0x232
+                i64 srcX0; // 0x234
+                i64 srcY0; // 0x236
+            };
+            static_assert(sizeof(PixelsFromMemory) == (0x18 * sizeof(u32)));
+
+            struct {
+                u32 _pad0_[0x80]; // 0x0
+                Surface dst; // 0x80
+                u32 _pad1_[0x2]; // 0x8A
+                Surface src; // 0x8C
+                u32 _pad2_[0x18A]; // 0x96
+                PixelsFromMemory pixelsFromMemory; // 0x220
+            };
+        } registers{};
+        static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
+        #pragma pack(pop)
+
+        ChannelContext &channelCtx;
+
+        /**
+         * @return A guest texture corresponding to the supplied surface, or nothing if it has no format
+         */
+        std::optional<gpu::GuestTexture> GetGuestTexture(const Registers::Surface &surface);
+
+        /**
+         * @brief Blits the source region into the destination region of the surfaces on the host GPU, this is triggered by writing the integer part of the source Y coordinate
+         */
+        void Blit();
+
+      public:
+        Fermi2D(const DeviceState &state, ChannelContext &channelCtx);
+
+        void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
+    };
+}
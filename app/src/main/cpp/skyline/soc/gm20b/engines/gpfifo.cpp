@@ -25,16 +25,42 @@ namespace skyline::soc::gm20b::engine {
         #define GPFIFO_STRUCT_CASE(field, member, content) GPFIFO_CASE_BASE(member, field.member, GPFIFO_STRUCT_OFFSET(field, member), content)
 
         switch (method) {
+            GPFIFO_STRUCT_CASE(semaphore, action, {
+                if (action.operation == Registers::SemaphoreOperation::Release) {
+                    bool fourWords{action.releaseSize == Registers::SemaphoreReleaseSize::SixteenBytes};
+                    auto address{registers.semaphore.Address()};
+                    Logger::Debug("Release semaphore: 0x{:X}, payload: 0x{:X}", address, registers.semaphore.payload);
+
+                    // The release is deferred till all work prior to it has completed on the host GPU
+                    if (auto hostAddress{channelCtx.gmmuTlb.Translate(address, fourWords ? sizeof(u64) * 2 : sizeof(u32))}) [[likely]]
+                        channelCtx.executor.ReleaseSemaphore(hostAddress, registers.semaphore.payload, fourWords);
+                    else
+                        Logger::Warn("Semaphore at 0x{:X} isn't contained in a single mapped page", address);
+                } else if (action.operation == Registers::SemaphoreOperation::Acquire || action.operation == Registers::SemaphoreOperation::AcqGeq || action.operation == Registers::SemaphoreOperation::AcqAnd) {
+                    // Acquires are issued by guests far too frequently to warn about every one, they're only logged at a debug level
+                    Logger::Debug("Unimplemented semaphore acquire: 0x{:X}, payload: 0x{:X}", registers.semaphore.Address(), registers.semaphore.payload);
+                } else {
+                    Logger::Warn("Unsupported semaphore operation: 0x{:X}", static_cast<u8>(action.operation));
+                }
+            })
+
             GPFIFO_STRUCT_CASE(syncpoint, action, {
                 if (action.operation == Registers::SyncpointOperation::Incr) {
                     Logger::Debug("Increment syncpoint: {}", +action.index);
-                    channelCtx.executor.Execute();
-                    state.soc->host1x.syncpoints.at(action.index).Increment();
+                    channelCtx.executor.Execute([&syncpoint = state.soc->host1x.syncpoints.at(action.index)] {
+                        syncpoint.Increment();
+                    });
                 } else if (action.operation == Registers::SyncpointOperation::Wait) {
                     Logger::Debug("Wait syncpoint: {}, thresh: {}", +action.index, registers.syncpoint.payload);
 
-                    // Wait forever for another channel to increment
-                    state.soc->host1x.syncpoints.at(action.index).Wait(registers.syncpoint.payload, std::chrono::steady_clock::duration::max());
+                    // Wait for another channel to increment, the worker is handed off while waiting so the channels queued behind this one can still run
+                    auto &syncpoint{state.soc->host1x.syncpoints.at(action.index)};
+                    if (syncpoint.Load() < registers.syncpoint.payload) {
+                        constexpr std::chrono::milliseconds CancellationInterval{100}; // The interval at which the wait checks if the channel is being destroyed
+                        gm20b::ChannelScheduler::BlockingScope blockingScope(state.soc->channelScheduler);
+                        while (syncpoint.Load() < registers.syncpoint.payload && !channelCtx.gpfifo.cancelled.load(std::memory_order_relaxed))
+                            syncpoint.Wait(registers.syncpoint.payload, CancellationInterval);
+                    }
                 }
             })
         }
@@ -45,4 +71,10 @@ namespace skyline::soc::gm20b::engine {
         #undef GPFIFO_STRUCT_OFFSET
         #undef GPFIFO_OFFSET
     };
+
+    void GPFIFO::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        // GPFIFO methods are infrequent and almost always have side-effects so they're still handled individually
+        for (u32 index{}; index < arguments.size(); index++)
+            CallMethod(increment ? method + index : method, arguments[index], lastCall && index == arguments.size() - 1);
+    }
 }
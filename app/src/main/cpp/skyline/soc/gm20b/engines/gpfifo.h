@@ -127,7 +127,11 @@ namespace skyline::soc::gm20b::engine {
                         u8 _pad5_ : 2;
                         SemaphoreReduction reduction : 4;
                         SemaphoreFormat format : 1;
-                    }; // 0x7
+                    } action; // 0x7
+
+                    u64 Address() const {
+                        return (static_cast<u64>(offsetUpper) << 32) | (static_cast<u64>(offsetLower) << 2);
+                    }
                 } semaphore;
 
                 u32 nonStallInterrupt; // 0x8
@@ -174,5 +178,7 @@ namespace skyline::soc::gm20b::engine {
         GPFIFO(const DeviceState &state, ChannelContext &channelCtx);
 
         void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
     };
 }
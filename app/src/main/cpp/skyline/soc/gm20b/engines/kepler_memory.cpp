@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <gpu/texture/copy.h>
+#include <gpu/texture/format.h>
+#include <soc/gm20b/channel.h>
+#include "kepler_memory.h"
+
+namespace skyline::soc::gm20b::engine {
+    #define KEPLER_MEMORY_OFFSET(field) U32_OFFSET(Registers, field)
+
+    KeplerMemory::KeplerMemory(const DeviceState &state, ChannelContext &channelCtx) : Engine(state), channelCtx(channelCtx) {}
+
+    void KeplerMemory::LaunchDma() {
+        if (transferSize) [[unlikely]] {
+            Logger::Warn("Inline2Memory transfer was relaunched after receiving 0x{:X} out of 0x{:X} bytes", inlineBuffer.size(), transferSize);
+            CompleteDma();
+        }
+
+        transferSize = static_cast<size_t>(registers.lineLengthIn) * registers.lineCount;
+        inlineBuffer.clear();
+        inlineBuffer.reserve(util::AlignUp(transferSize, sizeof(u32)));
+    }
+
+    void KeplerMemory::LoadInlineData(span<u32> data) {
+        if (!transferSize) [[unlikely]] {
+            Logger::Warn("Inline2Memory data was loaded without a transfer in progress: {} words", data.size());
+            return;
+        }
+
+        auto bytes{data.cast<u8>()};
+        inlineBuffer.insert(inlineBuffer.end(), bytes.begin(), bytes.end());
+
+        // The final word of a transfer may be padded past the end of it
+        if (inlineBuffer.size() >= transferSize) {
+            inlineBuffer.resize(transferSize);
+            CompleteDma();
+        }
+    }
+
+    void KeplerMemory::WriteContiguous(u64 address, span<u8> data) {
+        span<u8> mapping;
+        if (auto phys{channelCtx.gmmuTlb.Translate(address, data.size())}) [[likely]] {
+            mapping = span(phys, data.size());
+        } else {
+            auto mappings{channelCtx.asCtx->gmmu.TranslateRange(address, data.size())};
+            if (mappings.size() != 1) [[unlikely]] {
+                // Writes spanning several CPU mappings can't belong to a single host buffer, so they're only written to the guest
+                channelCtx.asCtx->gmmu.Write(address, data);
+                return;
+            }
+            mapping = mappings.front();
+        }
+
+        std::memcpy(mapping.data(), data.data(), data.size());
+
+        auto view{state.gpu->buffer.Lookup(mapping)};
+        if (!view)
+            return; // Buffers which haven't been created yet will upload the written data when they are
+
+        // The host write is recorded into the command stream so that prior GPU work observes the older contents as it would on the guest
+        auto stagingBuffer{state.gpu->memory.AllocateRingStagingBuffer(data.size())};
+        std::memcpy(stagingBuffer->data(), data.data(), data.size());
+
+        channelCtx.executor.AttachBuffer(view->buffer.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        channelCtx.executor.AddOutsideRpCommand([view = *view, stagingBuffer = std::move(stagingBuffer)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, gpu::GPU &) {
+            view.buffer->RecordInlineWrite(commandBuffer, cycle, stagingBuffer, view.offset);
+        });
+    }
+
+    void KeplerMemory::WriteBlockLinear(u32 lineCount) {
+        auto &surface{registers.dstSurface};
+        u32 lineBytes{registers.lineLengthIn};
+        u64 address{registers.offsetOut.Pack()};
+
+        // The surface is treated as a texture with a single byte format, the write is done on a deswizzled copy of all of it as the lines may only partially cover GOBs
+        gpu::GuestTexture guest(gpu::GuestTexture::Mappings{}, gpu::texture::Dimensions(surface.width, surface.height, 1), gpu::format::R8Uint, gpu::texture::TileConfig{
+            .mode = gpu::texture::TileMode::Block,
+            .blockHeight = static_cast<u8>(1U << surface.blockSize.heightLog2),
+            .blockDepth = static_cast<u8>(1U << surface.blockSize.depthLog2),
+        }, gpu::texture::TextureType::e2D);
+        gpu::detail::BlockLinearLayout layout{guest};
+        size_t surfaceSize{static_cast<size_t>(layout.robBytes) * layout.surfaceHeightRobs};
+        u32 pitch{layout.robWidthBytes};
+
+        if (static_cast<size_t>(surface.originX) + lineBytes > pitch || static_cast<size_t>(surface.originY + lineCount) * pitch > surfaceSize) [[unlikely]] {
+            Logger::Warn("Inline2Memory destination is out of bounds of its surface: ({}, {}) + {}x{} bytes", surface.originX, surface.originY, lineBytes, lineCount);
+            return;
+        }
+
+        auto &gmmu{channelCtx.asCtx->gmmu};
+        u64 layerAddress{address + (surfaceSize * surface.layer)};
+        surfaceBuffer.resize(surfaceSize);
+        linearBuffer.resize(surfaceSize);
+        gmmu.Read(span(surfaceBuffer), layerAddress);
+        gpu::CopyBlockLinearToLinear(guest, surfaceBuffer.data(), linearBuffer.data());
+
+        for (u32 line{}; line < lineCount; line++)
+            std::memcpy(linearBuffer.data() + (static_cast<size_t>(surface.originY + line) * pitch) + surface.originX, inlineBuffer.data() + (static_cast<size_t>(line) * lineBytes), lineBytes);
+
+        gpu::CopyLinearToBlockLinear(guest, linearBuffer.data(), surfaceBuffer.data());
+        gmmu.Write(layerAddress, span(surfaceBuffer));
+    }
+
+    void KeplerMemory::CompleteDma() {
+        TRACE_EVENT("gpu", "KeplerMemory::CompleteDma");
+
+        // Only the lines which were completely received are written when a transfer is cut short
+        u32 lineBytes{registers.lineLengthIn};
+        u32 lineCount{lineBytes ? static_cast<u32>(inlineBuffer.size() / lineBytes) : 0};
+        if (lineCount) {
+            if (registers.launchDma.dstMemoryLayout == Registers::MemoryLayout::Pitch) {
+                u64 address{registers.offsetOut.Pack()};
+                if (lineCount == 1 || registers.pitchOut == lineBytes) {
+                    WriteContiguous(address, span(inlineBuffer).first(static_cast<size_t>(lineCount) * lineBytes));
+                } else {
+                    for (u32 line{}; line < lineCount; line++)
+                        channelCtx.asCtx->gmmu.Write(address + (static_cast<u64>(line) * registers.pitchOut), inlineBuffer.data() + (static_cast<size_t>(line) * lineBytes), lineBytes);
+                }
+            } else {
+                WriteBlockLinear(lineCount);
+            }
+        }
+
+        transferSize = 0;
+        inlineBuffer.clear();
+    }
+
+    void KeplerMemory::CallMethod(u32 method, u32 argument, bool lastCall) {
+        CallMethodBatch(method, span<u32>(&argument, 1), true, lastCall);
+    }
+
+    void KeplerMemory::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        Logger::Debug("Called method batch in Kepler Memory: 0x{:X} count: {} increment: {}", method, arguments.size(), increment);
+
+        constexpr u32 LaunchDmaMethod{KEPLER_MEMORY_OFFSET(launchDma)};
+        constexpr u32 LoadInlineDataMethod{KEPLER_MEMORY_OFFSET(loadInlineData)};
+        if (!increment) {
+            if (method >= RegisterCount) [[unlikely]] {
+                Logger::Warn("Out of bounds Kepler Memory method batch called: 0x{:X} count: {}", method, arguments.size());
+                return;
+            }
+
+            // The bulk of inline data is sent as a single non-incrementing run, it's appended to the transfer as a whole
+            if (method == LoadInlineDataMethod) {
+                LoadInlineData(arguments);
+            } else if (method == LaunchDmaMethod) {
+                for (u32 argument : arguments) {
+                    registers.raw[method] = argument;
+                    LaunchDma();
+                }
+            } else {
+                registers.raw[method] = arguments.back();
+            }
+            return;
+        }
+
+        if (method + arguments.size() > RegisterCount) [[unlikely]] {
+            Logger::Warn("Out of bounds Kepler Memory method batch called: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        // Incrementing runs only write a single data word, they're split around the launch and data methods so their side effects happen in order
+        while (!arguments.empty()) {
+            if (method == LaunchDmaMethod) {
+                registers.raw[method] = arguments.front();
+                LaunchDma();
+            } else if (method == LoadInlineDataMethod) {
+                LoadInlineData(arguments.first(1));
+            } else {
+                u32 count{method < LaunchDmaMethod ? std::min(LaunchDmaMethod - method, static_cast<u32>(arguments.size())) : static_cast<u32>(arguments.size())};
+                span(registers.raw).subspan(method).copy_from(arguments.first(count));
+                arguments = arguments.subspan(count);
+                method += count;
+                continue;
+            }
+            arguments = arguments.subspan(1);
+            method++;
+        }
+    }
+
+    #undef KEPLER_MEMORY_OFFSET
+}
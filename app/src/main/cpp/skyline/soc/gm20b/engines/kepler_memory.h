@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "maxwell/types.h"
+#include "engine.h"
+
+namespace skyline::soc::gm20b {
+    struct ChannelContext;
+}
+
+namespace skyline::soc::gm20b::engine {
+    /**
+     * @brief The Kepler Memory (Inline2Memory) engine writes data embedded in the pushbuffer to pitch-linear or blocklinear memory, this is used by games to stream small uploads
+     * @note The words of a transfer are gathered and written to memory with a single copy once all of them have been received
+     */
+    class KeplerMemory : public Engine {
+      public:
+        static constexpr u32 RegisterCount{0x80}; //!< The number of Kepler Memory registers
+
+      private:
+        #pragma pack(push, 1)
+        union Registers {
+            std::array<u32, RegisterCount> raw;
+
+            enum class MemoryLayout : u8 {
+                BlockLinear = 0,
+                Pitch = 1,
+            };
+
+            struct LaunchDma {
+                MemoryLayout dstMemoryLayout : 1;
+                bool reductionEnable : 1;
+                u8 reductionFormat : 2;
+                u8 completionType : 2;
+                bool sysmembarDisable : 1;
+                u8 _pad0_ : 1;
+                u8 interruptType : 2;
+                u8 _pad1_ : 2;
+                u8 semaphoreStructSize : 1;
+                u8 reductionOp : 3;
+                u16 _pad2_;
+            };
+            static_assert(sizeof(LaunchDma) == sizeof(u32));
+
+            /**
+             * @brief The layout of a blocklinear destination surface, the width and X origin are in bytes
+             */
+            struct Surface {
+                struct {
+                    u8 widthLog2 : 4; //!< The width of a block in GOBs, this is always a single GOB on the Tegra X1
+                    u8 heightLog2 : 4; //!< The height of a block in GOBs
+                    u8 depthLog2 : 4; //!< The depth of a block in GOBs
+                    u8 _pad0_ : 4;
+                    u16 _pad1_;
+                } blockSize;
+                u32 width;
+                u32 height;
+                u32 depth;
+                u32 layer;
+                u32 originX;
+                u32 originY;
+            };
+            static_assert(sizeof(Surface) == (sizeof(u32) * 7));
+
+            struct {
+                u32 _pad0_[0x60]; // 0x0
+                u32 lineLengthIn; // 0x60
+                u32 lineCount; // 0x61
+                maxwell3d::type::Address offsetOut; // 0x62
+                u32 pitchOut; // 0x64
+                Surface dstSurface; // 0x65
+                LaunchDma launchDma; // 0x6C
+                u32 loadInlineData; // 0x6D
+                u32 _pad1_[0x12]; // 0x6E
+            };
+        } registers{};
+        static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
+        #pragma pack(pop)
+
+        ChannelContext &channelCtx;
+        std::vector<u8> inlineBuffer; //!< The data of the current transfer that has been received so far
+        size_t transferSize{}; //!< The total size of the current transfer in bytes, this is zero when there's no transfer in progress
+        std::vector<u8> surfaceBuffer; //!< A scratch buffer for the entirety of a blocklinear destination surface
+        std::vector<u8> linearBuffer; //!< A scratch buffer for a blocklinear destination surface after being deswizzled
+
+        /**
+         * @brief Starts a transfer of the size that was configured in the registers, any prior transfer that wasn't completed is written out partially
+         */
+        void LaunchDma();
+
+        /**
+         * @brief Appends a run of words to the current transfer, the transfer is completed once all of its data has been received
+         */
+        void LoadInlineData(span<u32> data);
+
+        /**
+         * @brief Writes contiguous data to guest memory and mirrors it into the host buffer backing it, if there is one
+         */
+        void WriteContiguous(u64 address, span<u8> data);
+
+        /**
+         * @brief Writes the lines of the current transfer in `inlineBuffer` into the blocklinear destination surface
+         */
+        void WriteBlockLinear(u32 lineCount);
+
+        /**
+         * @brief Writes the data in `inlineBuffer` to the destination and ends the current transfer
+         */
+        void CompleteDma();
+
+      public:
+        KeplerMemory(const DeviceState &state, ChannelContext &channelCtx);
+
+        void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
+    };
+}
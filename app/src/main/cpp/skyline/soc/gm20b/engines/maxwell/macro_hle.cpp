@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <soc/gm20b/engines/maxwell_3d.h>
+#include "macro_hle.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    constexpr u32 ConstantBufferSelectorMethod{0x8E0}; //!< Maxwell3D::Registers::constantBufferSelector
+    constexpr u32 ConstantBufferOffsetMethod{0x8E3}; //!< Maxwell3D::Registers::constantBufferSelector::offset
+    constexpr u32 ConstantBufferUpdateMethod{0x8E4}; //!< Maxwell3D::Registers::constantBufferUpdate
+
+    /*
+     * Probes use distinct values for every argument so that macros which reorder, drop or duplicate them don't match, they also differ in length for macros with variable-length arguments
+     */
+    constexpr std::pair<std::array<u32, 3>, std::array<u32, 5>> ConstantBufferUpdateProbes{
+        {0x40, 1, 0xA1A2A3A4},
+        {0x100, 3, 0xB1B2B3B4, 0xC1C2C3C4, 0xD1D2D3D4},
+    };
+    constexpr std::pair<std::array<u32, 3>, std::array<u32, 3>> ConstantBufferSelectProbes{
+        {0x10000, 0x12, 0x34560000},
+        {0x100, 0x1, 0xFFFFFF00},
+    };
+
+    bool MacroHle::ConstantBufferUpdate(Maxwell3D &maxwell3D, span<u32> arguments) {
+        if (arguments.size() < 2 || arguments[1] != arguments.size() - 2) [[unlikely]]
+            return false;
+
+        maxwell3D.CallMethod(ConstantBufferOffsetMethod, arguments[0], true);
+        if (arguments.size() > 2)
+            maxwell3D.CallMethodBatch(ConstantBufferUpdateMethod, arguments.subspan(2), false, true);
+        return true;
+    }
+
+    bool MacroHle::ConstantBufferSelect(Maxwell3D &maxwell3D, span<u32> arguments) {
+        if (arguments.size() != 3) [[unlikely]]
+            return false;
+
+        maxwell3D.CallMethodBatch(ConstantBufferSelectorMethod, arguments, true, true);
+        return true;
+    }
+
+    const std::array<MacroHle::Entry, 2> MacroHle::Entries{
+        Entry{
+            .function = &MacroHle::ConstantBufferUpdate,
+            .reference = [](span<const u32> arguments, std::vector<MacroInterpreter::MethodCall> &calls) {
+                calls.push_back({ConstantBufferOffsetMethod, arguments[0]});
+                for (u32 word : arguments.subspan(2))
+                    calls.push_back({ConstantBufferUpdateMethod, word});
+            },
+            .probes = {ConstantBufferUpdateProbes.first, ConstantBufferUpdateProbes.second},
+        },
+        Entry{
+            .function = &MacroHle::ConstantBufferSelect,
+            .reference = [](span<const u32> arguments, std::vector<MacroInterpreter::MethodCall> &calls) {
+                for (u32 index{}; index < arguments.size(); index++)
+                    calls.push_back({ConstantBufferSelectorMethod + index, arguments[index]});
+            },
+            .probes = {ConstantBufferSelectProbes.first, ConstantBufferSelectProbes.second},
+        },
+    };
+
+    size_t MacroHle::Hash(span<u32> macroCode, size_t offset) {
+        constexpr u32 ExitBit{1 << 7}; //!< MacroInterpreter::Opcode::exit
+
+        if (offset >= macroCode.size()) [[unlikely]]
+            return 0;
+
+        size_t end{offset};
+        while (end < macroCode.size() && !(macroCode[end] & ExitBit))
+            end++;
+        end = std::min(end + 2, macroCode.size()); // Include the exit instruction and its delay slot
+
+        return util::Hash(span<u32>(macroCode.subspan(offset, end - offset)).as_string());
+    }
+
+    MacroHle::Function MacroHle::Lookup(MacroInterpreter &interpreter, size_t offset) {
+        // All constant buffer update methods are equivalent, macros may write runs of words to any of them
+        auto normalise{[](MacroInterpreter::MethodCall call) -> MacroInterpreter::MethodCall {
+            if (call.method >= ConstantBufferUpdateMethod && call.method < ConstantBufferUpdateMethod + type::ConstantBufferUpdateCount)
+                call.method = ConstantBufferUpdateMethod;
+            return call;
+        }};
+
+        std::vector<MacroInterpreter::MethodCall> calls, expected;
+        for (const auto &entry : Entries) {
+            bool matches{true};
+            for (auto probe : entry.probes) {
+                calls.clear();
+                expected.clear();
+                if (!interpreter.Trace(offset, probe, calls)) {
+                    matches = false;
+                    break;
+                }
+
+                entry.reference(probe, expected);
+                if (!std::equal(calls.begin(), calls.end(), expected.begin(), expected.end(), [&](auto a, auto b) { return normalise(a) == normalise(b); })) {
+                    matches = false;
+                    break;
+                }
+            }
+
+            if (matches)
+                return entry.function;
+        }
+
+        return nullptr;
+    }
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+#include "macro_interpreter.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    class Maxwell3D; // A forward declaration of Maxwell3D as we don't want to import it here
+
+    /**
+     * @brief The MacroHle class matches well-known macros against native implementations of them, these are executed in place of the macro and receive all of its arguments at once
+     * @note Implementations should be private static members of this class as it's a friend of Maxwell3D, allowing them to call into GraphicsContext directly
+     */
+    class MacroHle {
+      public:
+        /**
+         * @return If the macro was executed natively, the macro is interpreted instead if this is false
+         * @note Implementations must check any assumptions they make about the arguments and return false prior to causing any side effects if they don't hold
+         */
+        using Function = bool (*)(Maxwell3D &maxwell3D, span<u32> arguments);
+
+      private:
+        /**
+         * @brief Appends the method calls that a macro with the same behaviour as a native implementation makes for the supplied arguments
+         */
+        using Reference = void (*)(span<const u32> arguments, std::vector<MacroInterpreter::MethodCall> &calls);
+
+        /**
+         * @brief A native implementation alongside the specification of the macros that it replaces
+         */
+        struct Entry {
+            Function function;
+            Reference reference;
+            std::array<span<const u32>, 2> probes; //!< Sets of arguments which the macro is traced with, its method calls must match those of the reference for all of them
+        };
+
+        /**
+         * @brief Writes a run of words to the selected constant buffer at the supplied offset
+         * @note Arguments: Offset, Word Count, Words[Word Count]
+         */
+        static bool ConstantBufferUpdate(Maxwell3D &maxwell3D, span<u32> arguments);
+
+        /**
+         * @brief Selects the constant buffer that later updates are written to
+         * @note Arguments: Size, Address High, Address Low
+         */
+        static bool ConstantBufferSelect(Maxwell3D &maxwell3D, span<u32> arguments);
+
+        static const std::array<Entry, 2> Entries;
+
+      public:
+        /**
+         * @return A hash of the macro at the supplied offset in macro memory, this covers all instructions up to and including the delay slot of the first exit
+         * @note This uses util::Hash as it's stable across builds, which is required for the hashes in logs to be comparable across runs and titles
+         */
+        static size_t Hash(span<u32> macroCode, size_t offset);
+
+        /**
+         * @return The native implementation of the macro at the supplied offset in macro memory or nullptr if there is none
+         * @note The macro is traced with the probe arguments of every entry, an entry only matches if the macro makes the same method calls as its reference for all of them
+         */
+        static Function Lookup(MacroInterpreter &interpreter, size_t offset);
+    };
+}
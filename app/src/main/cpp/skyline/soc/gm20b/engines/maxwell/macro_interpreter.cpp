@@ -3,9 +3,22 @@
 
 #include <common/address_space.h>
 #include <soc/gm20b/engines/maxwell_3d.h>
+#include "macro_jit.h"
 
 namespace skyline::soc::gm20b::engine::maxwell3d {
+    MacroInterpreter::MacroInterpreter(Maxwell3D &maxwell3D, bool enableJit) : maxwell3D(maxwell3D), jit(enableJit ? std::make_unique<MacroJit>(maxwell3D) : nullptr) {}
+
+    MacroInterpreter::~MacroInterpreter() = default;
+
+    void MacroInterpreter::InvalidateMacroCode() {
+        if (jit)
+            jit->InvalidateCache();
+    }
+
     void MacroInterpreter::Execute(size_t offset, const std::vector<u32> &args) {
+        if (jit && jit->Execute(offset, args))
+            return;
+
         // Reset the interpreter state
         registers = {};
         carryFlag = false;
@@ -19,6 +32,42 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         while (Step());
     }
 
+    bool MacroInterpreter::Trace(size_t offset, span<const u32> args, std::vector<MethodCall> &calls) {
+        constexpr size_t StepLimit{0x400}; //!< The amount of instructions after which a macro is assumed to never exit
+        constexpr size_t MaximumStepFetches{2}; //!< An instruction and its delay slot can each fetch an argument
+
+        if (args.empty()) [[unlikely]]
+            return false;
+
+        // Over-reads of the arguments are padded with zeroes so they can be detected after the macro has exited
+        std::vector<u32> paddedArgs(args.size() + (StepLimit * MaximumStepFetches));
+        std::copy(args.begin(), args.end(), paddedArgs.begin());
+
+        registers = {};
+        carryFlag = false;
+        methodAddress.raw = 0;
+        opcode = reinterpret_cast<Opcode *>(&maxwell3D.macroCode[offset]);
+        argument = paddedArgs.data();
+        registers[1] = *argument++;
+
+        auto codeBegin{reinterpret_cast<Opcode *>(maxwell3D.macroCode.data())}, codeEnd{codeBegin + maxwell3D.macroCode.size()};
+        bool exited{};
+        trace = &calls;
+        try {
+            for (size_t step{}; step < StepLimit && opcode >= codeBegin && opcode < codeEnd; step++) {
+                if (!Step()) {
+                    exited = true;
+                    break;
+                }
+            }
+        } catch (const std::exception &) {
+            exited = false;
+        }
+        trace = nullptr;
+
+        return exited && argument <= paddedArgs.data() + args.size();
+    }
+
     __attribute__((always_inline)) bool MacroInterpreter::Step(Opcode *delayedOpcode) {
         switch (opcode->operation) {
             case Opcode::Operation::AluRegister: {
@@ -194,7 +243,10 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
     }
 
     __attribute__((always_inline)) void MacroInterpreter::Send(u32 pArgument) {
-        maxwell3D.CallMethod(methodAddress.address, pArgument, true);
+        if (trace) [[unlikely]]
+            trace->push_back({methodAddress.address, pArgument});
+        else
+            maxwell3D.CallMethod(methodAddress.address, pArgument, true);
         methodAddress.address += methodAddress.increment;
     }
 
@@ -7,6 +7,7 @@
 
 namespace skyline::soc::gm20b::engine::maxwell3d {
     class Maxwell3D; // A forward declaration of Maxwell3D as we don't want to import it here
+    class MacroJit;
 
     /**
      * @brief The MacroInterpreter class handles interpreting macros. Macros are small programs that run on the GPU and are used for things like instanced rendering
@@ -103,7 +104,10 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             };
         };
 
+        friend MacroJit; // The JIT shares the instruction encoding and method addressing with the interpreter
+
         Maxwell3D &maxwell3D; //!< A reference to the parent engine object
+        std::unique_ptr<MacroJit> jit; //!< The JIT which macros are executed with when it's enabled, the interpreter is used as a fallback for any macros that it cannot compile
 
         Opcode *opcode{}; //!< A pointer to the instruction that is currently being executed
         std::array<u32, 8> registers{}; //!< The state of all the general-purpose registers in the macro interpreter
@@ -138,11 +142,43 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         void WriteRegister(u8 reg, u32 value);
 
       public:
-        MacroInterpreter(Maxwell3D &maxwell3D) : maxwell3D(maxwell3D) {}
+        /**
+         * @brief A method call made by a macro, this is recorded rather than sent while tracing
+         */
+        struct MethodCall {
+            u32 method;
+            u32 argument;
+
+            bool operator==(const MethodCall &) const = default;
+        };
+
+      private:
+        std::vector<MethodCall> *trace{}; //!< The vector which method calls are recorded into while tracing, nullptr while executing
+
+      public:
+        /**
+         * @param enableJit If macros should be compiled to native code rather than being interpreted
+         */
+        MacroInterpreter(Maxwell3D &maxwell3D, bool enableJit);
+
+        ~MacroInterpreter();
 
         /**
          * @brief Executes a GPU macro from macro memory with the given arguments
          */
         void Execute(size_t offset, const std::vector<u32> &args);
+
+        /**
+         * @brief Interprets a GPU macro without any side effects, the method calls it makes are recorded rather than sent to the Maxwell 3D
+         * @param calls The vector which the method calls of the macro are appended to
+         * @return If the macro exited without exceeding the step limit or consuming more than the supplied arguments
+         * @note This is used to verify native implementations of macros against their code, register reads still observe the current state of the engine
+         */
+        bool Trace(size_t offset, span<const u32> args, std::vector<MethodCall> &calls);
+
+        /**
+         * @brief Notifies the interpreter of a write to macro memory, any state derived from it will be revalidated prior to the next execution
+         */
+        void InvalidateMacroCode();
     };
 }
@@ -0,0 +1,586 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/mman.h>
+#include <common/trace.h>
+#include <soc/gm20b/engines/maxwell_3d.h>
+#include "macro_jit.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    namespace {
+        /**
+         * @brief A minimal AArch64 assembler for the subset of instructions that compiled macros require, all data processing is done on 32-bit W registers
+         * @note Branches are emitted with unresolved offsets and are patched with their target after all code has been emitted
+         */
+        class Assembler {
+          public:
+            static constexpr u8 WZR{31}; //!< The zero register, this is interpreted as SP by any instructions which take an immediate operand
+            static constexpr u8 ContextReg{19}; //!< X19 holds a pointer to MacroJit::Context
+            static constexpr u8 ArgumentReg{20}; //!< X20 holds a pointer to the next macro argument
+            static constexpr u8 CarryReg{28}; //!< W28 holds the macro carry flag as either 0 or 1
+            static constexpr u8 ResultReg{9}; //!< W9 holds the result of the current instruction prior to assignment
+            static constexpr u8 ScratchReg{10};
+            static constexpr u8 ScratchReg2{11};
+
+            enum class Condition : u8 {
+                Eq = 0,
+                Ne = 1,
+                Cs = 2,
+                Cc = 3,
+            };
+
+            enum class Shift : u8 {
+                Lsl = 0,
+                Lsr = 1,
+            };
+
+            std::vector<u32> code;
+
+            /**
+             * @return The host register that holds the supplied macro register, register 0 is always zero and maps to WZR
+             */
+            static constexpr u8 MacroReg(u8 reg) {
+                return reg == 0 ? WZR : static_cast<u8>(ArgumentReg + reg);
+            }
+
+            size_t Position() {
+                return code.size();
+            }
+
+            void Emit(u32 instruction) {
+                code.push_back(instruction);
+            }
+
+            /**
+             * @brief Emits a B instruction which must later be resolved with PatchBranch
+             * @return The position of the emitted branch
+             */
+            size_t B() {
+                Emit(0x14000000);
+                return Position() - 1;
+            }
+
+            void PatchBranch(size_t position, size_t target) {
+                auto offset{static_cast<i64>(target) - static_cast<i64>(position)};
+                code[position] = 0x14000000 | (static_cast<u32>(offset) & 0x3FFFFFF);
+            }
+
+            /**
+             * @brief Emits a CBZ or CBNZ instruction which skips over the supplied amount of instructions following it
+             */
+            void CompareBranchSkip(bool nonZero, u8 rt, u32 skip) {
+                Emit((nonZero ? 0x35000000 : 0x34000000) | ((skip + 1) << 5) | rt);
+            }
+
+            /**
+             * @brief Emits a CBZ or CBNZ instruction with an offset which must later be resolved with PatchCompareBranch
+             * @return The position of the emitted branch
+             */
+            size_t CompareBranch(bool nonZero, u8 rt) {
+                Emit((nonZero ? 0x35000000 : 0x34000000) | rt);
+                return Position() - 1;
+            }
+
+            void PatchCompareBranch(size_t position, size_t target) {
+                auto offset{static_cast<i64>(target) - static_cast<i64>(position)};
+                if (offset >= (1 << 18))
+                    throw exception("Macro too large to compile");
+                code[position] |= (static_cast<u32>(offset) & 0x7FFFF) << 5;
+            }
+
+            /**
+             * @brief Emits a B.cond instruction which skips over the supplied amount of instructions following it
+             */
+            void BranchConditionSkip(Condition condition, u32 skip) {
+                Emit(0x54000000 | ((skip + 1) << 5) | static_cast<u8>(condition));
+            }
+
+            void MovImmediate(u8 rd, u32 value) {
+                Emit(0x52800000 | ((value & 0xFFFF) << 5) | rd); // MOVZ
+                if (value >> 16)
+                    Emit(0x72A00000 | ((value >> 16) << 5) | rd); // MOVK LSL #16
+            }
+
+            void Mov(u8 rd, u8 rm) {
+                if (rd != rm)
+                    Orr(rd, WZR, rm);
+            }
+
+            void Add(u8 rd, u8 rn, u8 rm) {
+                Emit(0x0B000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Adds(u8 rd, u8 rn, u8 rm) {
+                Emit(0x2B000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Sub(u8 rd, u8 rn, u8 rm) {
+                Emit(0x4B000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Cmp(u8 rn, u8 rm) {
+                Emit(0x6B000000 | (rm << 16) | (rn << 5) | WZR); // SUBS WZR
+            }
+
+            void CmpImmediate(u8 rn, u16 imm12) {
+                Emit(0x7100001F | (imm12 << 10) | (rn << 5)); // SUBS WZR, imm
+            }
+
+            void Adcs(u8 rd, u8 rn, u8 rm) {
+                Emit(0x3A000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Sbc(u8 rd, u8 rn, u8 rm) {
+                Emit(0x5A000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void And(u8 rd, u8 rn, u8 rm, Shift shift = Shift::Lsl, u8 amount = 0) {
+                Emit(0x0A000000 | (static_cast<u8>(shift) << 22) | (rm << 16) | (amount << 10) | (rn << 5) | rd);
+            }
+
+            void Bic(u8 rd, u8 rn, u8 rm) {
+                Emit(0x0A200000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Orr(u8 rd, u8 rn, u8 rm, Shift shift = Shift::Lsl, u8 amount = 0) {
+                Emit(0x2A000000 | (static_cast<u8>(shift) << 22) | (rm << 16) | (amount << 10) | (rn << 5) | rd);
+            }
+
+            void Orn(u8 rd, u8 rn, u8 rm) {
+                Emit(0x2A200000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Eor(u8 rd, u8 rn, u8 rm) {
+                Emit(0x4A000000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Lslv(u8 rd, u8 rn, u8 rm) {
+                Emit(0x1AC02000 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Lsrv(u8 rd, u8 rn, u8 rm) {
+                Emit(0x1AC02400 | (rm << 16) | (rn << 5) | rd);
+            }
+
+            void Ubfx(u8 rd, u8 rn, u8 lsb, u8 width) {
+                Emit(0x53000000 | (lsb << 16) | ((lsb + width - 1) << 10) | (rn << 5) | rd); // UBFM
+            }
+
+            void Cset(u8 rd, Condition condition) {
+                Emit(0x1A9F07E0 | ((static_cast<u8>(condition) ^ 1) << 12) | rd); // CSINC WZR, WZR, !cond
+            }
+
+            /**
+             * @brief Emits a LDR (immediate, post-index) which loads a W register from an X register and increments it by 4
+             */
+            void LdrPostIncrement(u8 rt, u8 rn) {
+                Emit(0xB8400400 | (4 << 12) | (rn << 5) | rt);
+            }
+
+            /**
+             * @brief Emits a LDR (register) which loads a W register from [Xn, Wm, UXTW #2]
+             */
+            void LdrIndexed(u8 rt, u8 rn, u8 rm) {
+                Emit(0xB8605800 | (rm << 16) | (rn << 5) | rt);
+            }
+
+            void LdrX(u8 rt, u8 rn, size_t offset) {
+                Emit(0xF9400000 | (static_cast<u32>(offset / sizeof(u64)) << 10) | (rn << 5) | rt);
+            }
+
+            void Str(u8 rt, u8 rn, size_t offset) {
+                Emit(0xB9000000 | (static_cast<u32>(offset / sizeof(u32)) << 10) | (rn << 5) | rt);
+            }
+
+            void MovX(u8 rd, u8 rm) {
+                Emit(0xAA0003E0 | (rm << 16) | rd); // ORR XD, XZR, XM
+            }
+
+            void Blr(u8 rn) {
+                Emit(0xD63F0000 | (rn << 5));
+            }
+
+            /**
+             * @brief Saves X19-X30 in a 0x60 byte stack frame
+             */
+            void Prologue() {
+                Emit(0xA9BA7BFD); // STP X29, X30, [SP, #-0x60]!
+                Emit(0x910003FD); // MOV X29, SP
+                for (u8 reg{19}, offset{2}; reg < 29; reg += 2, offset += 2)
+                    Emit(0xA9000000 | (offset << 15) | ((reg + 1) << 10) | (31 << 5) | reg); // STP Xn, Xn+1, [SP, #offset]
+            }
+
+            void Epilogue() {
+                for (u8 reg{19}, offset{2}; reg < 29; reg += 2, offset += 2)
+                    Emit(0xA9400000 | (offset << 15) | ((reg + 1) << 10) | (31 << 5) | reg); // LDP Xn, Xn+1, [SP, #offset]
+                Emit(0xA8C67BFD); // LDP X29, X30, [SP], #0x60
+                Emit(0xD65F03C0); // RET
+            }
+        };
+    }
+
+    MacroJit::CompiledMacro::CompiledMacro(span<u32> code, size_t size, size_t hash) : mappingSize(util::AlignUp(code.size_bytes(), PAGE_SIZE)), size(size), hash(hash) {
+        auto mapping{mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+        if (mapping == MAP_FAILED)
+            throw exception("Failed to map memory for compiled macro: {}", strerror(errno));
+
+        std::memcpy(mapping, code.data(), code.size_bytes());
+        if (mprotect(mapping, mappingSize, PROT_READ | PROT_EXEC)) {
+            munmap(mapping, mappingSize);
+            throw exception("Failed to make compiled macro executable: {}", strerror(errno));
+        }
+
+        auto begin{reinterpret_cast<char *>(mapping)};
+        __builtin___clear_cache(begin, begin + code.size_bytes());
+
+        function = reinterpret_cast<MacroFunction>(mapping);
+    }
+
+    MacroJit::CompiledMacro::~CompiledMacro() {
+        munmap(reinterpret_cast<void *>(function), mappingSize);
+    }
+
+    MacroJit::MacroJit(Maxwell3D &maxwell3D) : maxwell3D(maxwell3D), context{
+        .maxwell3D = &maxwell3D,
+        .registers = maxwell3D.registers.raw.data(),
+        .send = &MacroJit::Send,
+        .exception = &pendingException,
+    } {}
+
+    u32 MacroJit::Send(Context *context, u32 argument) {
+        try {
+            MacroInterpreter::MethodAddress methodAddress{context->methodAddress};
+            context->maxwell3D->CallMethod(methodAddress.address, argument, true);
+            methodAddress.address += methodAddress.increment;
+            context->methodAddress = methodAddress.raw;
+            return static_cast<u32>(ExitStatus::Success);
+        } catch (...) {
+            *context->exception = std::current_exception();
+            return static_cast<u32>(ExitStatus::Exception);
+        }
+    }
+
+    size_t MacroJit::HashCode(size_t offset, size_t size) {
+        return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(&maxwell3D.macroCode[offset]), size * sizeof(u32)));
+    }
+
+    std::unique_ptr<MacroJit::CompiledMacro> MacroJit::Compile(size_t offset) {
+        TRACE_EVENT("gpu", "MacroJit::Compile");
+
+        span<u32> macroCode{span<u32>{maxwell3D.macroCode}.subspan(offset)};
+        auto opcodeAt{[&](size_t index) { return Opcode{macroCode[index]}; }};
+
+        // Walk all reachable instructions to determine the extent of the macro, we bail out if control flow can leave macro memory as the interpreter handles that (undefined) behaviour differently
+        size_t size{};
+        {
+            std::vector<bool> reached(macroCode.size());
+            std::vector<size_t> pending{0};
+            auto enqueue{[&](i64 index) {
+                if (index < 0 || index >= static_cast<i64>(macroCode.size()))
+                    return false;
+                if (!reached[static_cast<size_t>(index)]) {
+                    reached[static_cast<size_t>(index)] = true;
+                    pending.push_back(static_cast<size_t>(index));
+                }
+                return true;
+            }};
+            reached[0] = true;
+
+            while (!pending.empty()) {
+                auto index{pending.back()};
+                pending.pop_back();
+
+                auto opcode{opcodeAt(index)};
+                bool hasDelaySlot{static_cast<bool>(opcode.exit)};
+                if (opcode.operation == Opcode::Operation::Branch) {
+                    if (!enqueue(static_cast<i64>(index) + opcode.immediate))
+                        return nullptr;
+                    hasDelaySlot |= !opcode.noDelay;
+                }
+
+                if (opcode.exit) {
+                    // The instruction following an exit is only executed as a delay slot, it doesn't continue execution
+                    if (index + 1 >= macroCode.size())
+                        return nullptr;
+                    size = std::max(size, index + 2);
+                } else {
+                    if (!enqueue(static_cast<i64>(index) + 1))
+                        return nullptr;
+                    size = std::max(size, index + (hasDelaySlot ? 2 : 1));
+                }
+            }
+        }
+
+        Assembler as;
+        std::vector<size_t> instructionPositions(size);
+        std::vector<std::pair<size_t, size_t>> instructionBranches; //!< Pairs of a branch position and the target macro instruction
+        std::vector<size_t> exitBranches; //!< The positions of branches to the epilogue with the exit status in W0
+
+        auto exitWithStatus{[&](ExitStatus status) {
+            as.MovImmediate(0, static_cast<u32>(status));
+            exitBranches.push_back(as.B());
+        }};
+
+        auto send{[&](u8 valueReg) {
+            as.Mov(1, valueReg);
+            as.MovX(0, Assembler::ContextReg);
+            as.LdrX(16, Assembler::ContextReg, offsetof(Context, send));
+            as.Blr(16);
+            as.CompareBranchSkip(false, 0, 1);
+            exitBranches.push_back(as.B());
+        }};
+
+        auto fetch{[&](u8 reg) {
+            as.LdrPostIncrement(reg == 0 ? Assembler::ScratchReg : Assembler::MacroReg(reg), Assembler::ArgumentReg);
+        }};
+
+        auto writeRegister{[&](u8 reg, u8 valueReg) {
+            // Register 0 should always be zero so writes to it are dropped
+            if (reg != 0)
+                as.Mov(Assembler::MacroReg(reg), valueReg);
+        }};
+
+        auto setMethod{[&](u8 valueReg) {
+            as.Str(valueReg, Assembler::ContextReg, offsetof(Context, methodAddress));
+        }};
+
+        // Emits the operation and assignment of an instruction into the result register, this excludes any control flow
+        auto emitBody{[&](size_t index, bool delaySlot) {
+            auto opcode{opcodeAt(index)};
+            constexpr u8 Result{Assembler::ResultReg}, Scratch{Assembler::ScratchReg}, Scratch2{Assembler::ScratchReg2};
+            u8 srcA{Assembler::MacroReg(opcode.srcA)}, srcB{Assembler::MacroReg(opcode.srcB)};
+
+            switch (opcode.operation) {
+                case Opcode::Operation::AluRegister:
+                    switch (opcode.aluOperation) {
+                        case Opcode::AluOperation::Add:
+                            as.Adds(Result, srcA, srcB);
+                            as.Cset(Assembler::CarryReg, Assembler::Condition::Cs);
+                            break;
+                        case Opcode::AluOperation::AddWithCarry:
+                            as.CmpImmediate(Assembler::CarryReg, 1); // Sets the host carry flag to the macro carry flag
+                            as.Adcs(Result, srcA, srcB);
+                            as.Cset(Assembler::CarryReg, Assembler::Condition::Cs);
+                            break;
+                        case Opcode::AluOperation::Subtract:
+                            as.Sub(Result, srcA, srcB);
+                            as.CmpImmediate(Result, 0);
+                            as.Cset(Assembler::CarryReg, Assembler::Condition::Ne);
+                            break;
+                        case Opcode::AluOperation::SubtractWithBorrow:
+                            as.CmpImmediate(Assembler::CarryReg, 1);
+                            as.Sbc(Result, srcA, srcB);
+                            as.CmpImmediate(Result, 0);
+                            as.Cset(Assembler::CarryReg, Assembler::Condition::Ne);
+                            break;
+                        case Opcode::AluOperation::BitwiseXor:
+                            as.Eor(Result, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseOr:
+                            as.Orr(Result, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseAnd:
+                            as.And(Result, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseAndNot:
+                            as.Bic(Result, srcA, srcB);
+                            break;
+                        case Opcode::AluOperation::BitwiseNand:
+                            as.And(Result, srcA, srcB);
+                            as.Orn(Result, Assembler::WZR, Result);
+                            break;
+                        default:
+                            exitWithStatus(ExitStatus::UnknownOpcode);
+                            return;
+                    }
+                    break;
+
+                case Opcode::Operation::AddImmediate:
+                    as.MovImmediate(Scratch, static_cast<u32>(opcode.immediate));
+                    as.Add(Result, srcA, Scratch);
+                    break;
+
+                case Opcode::Operation::BitfieldReplace: {
+                    u32 mask{opcode.bitfield.GetMask()};
+                    as.MovImmediate(Scratch, mask);
+                    as.And(Result, Scratch, srcB, Assembler::Shift::Lsr, opcode.bitfield.srcBit);
+                    as.MovImmediate(Scratch, ~(mask << opcode.bitfield.destBit));
+                    as.And(Scratch2, srcA, Scratch);
+                    as.Orr(Result, Scratch2, Result, Assembler::Shift::Lsl, opcode.bitfield.destBit);
+                    break;
+                }
+
+                case Opcode::Operation::BitfieldExtractShiftLeftImmediate:
+                    as.Lsrv(Result, srcB, srcA);
+                    as.MovImmediate(Scratch, opcode.bitfield.GetMask());
+                    as.And(Result, Result, Scratch);
+                    as.Orr(Result, Assembler::WZR, Result, Assembler::Shift::Lsl, opcode.bitfield.destBit);
+                    break;
+
+                case Opcode::Operation::BitfieldExtractShiftLeftRegister:
+                    as.MovImmediate(Scratch, opcode.bitfield.GetMask());
+                    as.And(Result, Scratch, srcB, Assembler::Shift::Lsr, opcode.bitfield.srcBit);
+                    as.Lslv(Result, Result, srcA);
+                    break;
+
+                case Opcode::Operation::ReadImmediate:
+                    as.MovImmediate(Scratch, static_cast<u32>(opcode.immediate));
+                    as.Add(Result, srcA, Scratch);
+                    as.MovImmediate(Scratch, Maxwell3D::RegisterCount);
+                    as.Cmp(Result, Scratch);
+                    as.BranchConditionSkip(Assembler::Condition::Cc, 2);
+                    exitWithStatus(ExitStatus::ReadOutOfBounds);
+                    as.LdrX(Scratch, Assembler::ContextReg, offsetof(Context, registers));
+                    as.LdrIndexed(Result, Scratch, Result);
+                    break;
+
+                case Opcode::Operation::Branch:
+                    if (delaySlot)
+                        exitWithStatus(ExitStatus::BranchInDelaySlot);
+                    return; // Branches have no assignment, their control flow is handled by the caller
+
+                default:
+                    exitWithStatus(ExitStatus::UnknownOpcode);
+                    return;
+            }
+
+            switch (opcode.assignmentOperation) {
+                case Opcode::AssignmentOperation::IgnoreAndFetch:
+                    fetch(opcode.dest);
+                    break;
+                case Opcode::AssignmentOperation::Move:
+                    writeRegister(opcode.dest, Result);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethod:
+                    writeRegister(opcode.dest, Result);
+                    setMethod(Result);
+                    break;
+                case Opcode::AssignmentOperation::FetchAndSend:
+                    fetch(opcode.dest);
+                    send(Result);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSend:
+                    writeRegister(opcode.dest, Result);
+                    send(Result);
+                    break;
+                case Opcode::AssignmentOperation::FetchAndSetMethod:
+                    fetch(opcode.dest);
+                    setMethod(Result);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethodThenFetchAndSend:
+                    writeRegister(opcode.dest, Result);
+                    setMethod(Result);
+                    as.LdrPostIncrement(1, Assembler::ArgumentReg);
+                    send(1);
+                    break;
+                case Opcode::AssignmentOperation::MoveAndSetMethodThenSendHigh:
+                    writeRegister(opcode.dest, Result);
+                    setMethod(Result);
+                    as.Ubfx(1, Result, 12, 6); // MethodAddress::increment
+                    send(1);
+                    break;
+            }
+        }};
+
+        auto emitDelaySlot{[&](size_t index) {
+            if (index < size)
+                emitBody(index, true);
+            else
+                exitWithStatus(ExitStatus::CodeOutOfBounds);
+        }};
+
+        auto branchToInstruction{[&](i64 target) {
+            if (target >= 0 && target < static_cast<i64>(size))
+                instructionBranches.emplace_back(as.B(), static_cast<size_t>(target));
+            else
+                exitWithStatus(ExitStatus::CodeOutOfBounds);
+        }};
+
+        as.Prologue();
+        as.MovX(Assembler::ContextReg, 0);
+        as.MovX(Assembler::ArgumentReg, 1);
+
+        // The first argument is stored in register 1 while all other registers and the carry flag start zeroed
+        as.LdrPostIncrement(Assembler::MacroReg(1), Assembler::ArgumentReg);
+        for (u8 reg{2}; reg < 8; reg++)
+            as.Mov(Assembler::MacroReg(reg), Assembler::WZR);
+        as.Mov(Assembler::CarryReg, Assembler::WZR);
+
+        for (size_t index{}; index < size; index++) {
+            instructionPositions[index] = as.Position();
+
+            auto opcode{opcodeAt(index)};
+            if (opcode.operation == Opcode::Operation::Branch) {
+                u8 value{Assembler::MacroReg(opcode.srcA)};
+                bool branchOnZero{opcode.branchCondition == Opcode::BranchCondition::Zero};
+                i64 target{static_cast<i64>(index) + opcode.immediate};
+
+                // The branch is skipped over if its condition doesn't hold, a delayed branch executes the following instruction prior to branching
+                auto notTaken{as.CompareBranch(branchOnZero, value)};
+                if (!opcode.noDelay)
+                    emitDelaySlot(index + 1);
+                branchToInstruction(target);
+                as.PatchCompareBranch(notTaken, as.Position());
+            } else {
+                emitBody(index, false);
+            }
+
+            if (opcode.exit) {
+                // Exit has a delay slot, this is only reached by a branch with the exit bit set if it isn't taken
+                emitDelaySlot(index + 1);
+                exitWithStatus(ExitStatus::Success);
+            }
+        }
+
+        // Any unreachable instructions at the end of the range can fall through here
+        exitWithStatus(ExitStatus::CodeOutOfBounds);
+
+        auto epiloguePosition{as.Position()};
+        as.Epilogue();
+
+        for (auto [position, target] : instructionBranches)
+            as.PatchBranch(position, instructionPositions[target]);
+        for (auto position : exitBranches)
+            as.PatchBranch(position, epiloguePosition);
+
+        Logger::Debug("Compiled macro at 0x{:X}: {} instructions -> {} host instructions", offset, size, as.code.size());
+
+        return std::make_unique<CompiledMacro>(as.code, size, HashCode(offset, size));
+    }
+
+    bool MacroJit::Execute(size_t offset, const std::vector<u32> &args) {
+        if (cacheDirty) {
+            // Drop any compiled macros which have had their code changed, macros that failed to compile are retried as their code might have changed
+            std::erase_if(cache, [this](const auto &entry) {
+                return !entry.second || entry.second->hash != HashCode(entry.first, entry.second->size);
+            });
+            cacheDirty = false;
+        }
+
+        auto it{cache.find(offset)};
+        if (it == cache.end())
+            it = cache.emplace(offset, Compile(offset)).first;
+
+        auto &compiled{it->second};
+        if (!compiled)
+            return false;
+
+        context.methodAddress = 0;
+        switch (compiled->function(&context, args.data())) {
+            case ExitStatus::Success:
+                return true;
+            case ExitStatus::Exception:
+                std::rethrow_exception(std::exchange(pendingException, nullptr));
+            case ExitStatus::BranchInDelaySlot:
+                throw exception("Cannot branch while inside a delay slot");
+            case ExitStatus::UnknownOpcode:
+                throw exception("Unknown MME opcode encountered in macro at 0x{:X}", offset);
+            case ExitStatus::ReadOutOfBounds:
+                throw exception("Macro at 0x{:X} read a register out of bounds", offset);
+            case ExitStatus::CodeOutOfBounds:
+                throw exception("Macro at 0x{:X} executed outside of its compiled range", offset);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "macro_interpreter.h"
+
+namespace skyline::soc::gm20b::engine::maxwell3d {
+    /**
+     * @brief The MacroJit class compiles macros into native AArch64 code the first time they're executed, compiled macros are cached by their start offset and a hash of their code
+     * @note Any write to macro memory will cause all cached macros to be revalidated against their code hash prior to the next execution
+     */
+    class MacroJit {
+      private:
+        using Opcode = MacroInterpreter::Opcode;
+
+        /**
+         * @brief The state shared between compiled code and the host, a pointer to this is held in X19 for the duration of a macro
+         */
+        struct Context {
+            Maxwell3D *maxwell3D;
+            u32 *registers; //!< A pointer to the raw Maxwell 3D registers, used by ReadImmediate
+            u32 (*send)(Context *context, u32 argument); //!< The host function used to call a method on the Maxwell 3D, this is loaded from the context to avoid needing a literal pool
+            std::exception_ptr *exception; //!< Any exception thrown by a method call, this is stored rather than propagated as it cannot be unwound through compiled code
+            u32 methodAddress; //!< The raw MacroInterpreter::MethodAddress that is used for sending methods
+        };
+
+        /**
+         * @brief The reason for returning from compiled code
+         */
+        enum class ExitStatus : u32 {
+            Success = 0,
+            Exception = 1, //!< An exception was thrown by a method call and has been stored in Context::exception
+            BranchInDelaySlot = 2,
+            UnknownOpcode = 3,
+            ReadOutOfBounds = 4, //!< ReadImmediate tried to read a register beyond RegisterCount
+            CodeOutOfBounds = 5, //!< Control flow reached an instruction that is outside of the compiled range
+        };
+
+        using MacroFunction = ExitStatus (*)(Context *context, const u32 *arguments);
+
+        /**
+         * @brief A macro which has been compiled to executable memory
+         */
+        struct CompiledMacro {
+            MacroFunction function;
+            size_t mappingSize; //!< The size of the executable mapping backing the function in bytes
+            size_t size; //!< The amount of macro instructions (starting from the offset) that the compiled code was generated from
+            size_t hash; //!< A hash of the macro instructions that the compiled code was generated from
+
+            CompiledMacro(span<u32> code, size_t size, size_t hash);
+
+            CompiledMacro(const CompiledMacro &) = delete;
+
+            CompiledMacro &operator=(const CompiledMacro &) = delete;
+
+            ~CompiledMacro();
+        };
+
+        Maxwell3D &maxwell3D;
+        std::unordered_map<size_t, std::unique_ptr<CompiledMacro>> cache; //!< A map from the offset of a macro to its compiled form, this is nullptr for macros that couldn't be compiled
+        bool cacheDirty{}; //!< If macro memory has been written to since the cache was last validated
+        std::exception_ptr pendingException; //!< The exception thrown by the last method call from compiled code, if any
+        Context context;
+
+        /**
+         * @brief Sends a method call to the Maxwell 3D on behalf of compiled code
+         * @return ExitStatus::Success or ExitStatus::Exception if the method call threw an exception
+         */
+        static u32 Send(Context *context, u32 argument);
+
+        /**
+         * @return A hash of the supplied number of macro instructions starting at the supplied offset
+         */
+        size_t HashCode(size_t offset, size_t size);
+
+        /**
+         * @brief Compiles the macro at the supplied offset into native code
+         * @return The compiled macro or nullptr if the control flow of the macro leaves macro memory, these must be executed by the interpreter
+         */
+        std::unique_ptr<CompiledMacro> Compile(size_t offset);
+
+      public:
+        MacroJit(Maxwell3D &maxwell3D);
+
+        /**
+         * @brief Marks all compiled macros as potentially stale, this must be called after any write to macro memory
+         */
+        void InvalidateCache() {
+            cacheDirty = true;
+        }
+
+        /**
+         * @brief Executes a GPU macro from macro memory with the given arguments, compiling it if it hasn't been compiled yet
+         * @return If the macro was executed, this will be false for any macros that cannot be compiled
+         */
+        bool Execute(size_t offset, const std::vector<u32> &args);
+    };
+}
@@ -16,7 +16,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d::type {
         u32 high;
         u32 low;
 
-        u64 Pack() {
+        u64 Pack() const {
             return (static_cast<u64>(high) << 32) | low;
         }
     };
@@ -197,6 +197,8 @@ namespace skyline::soc::gm20b::engine::maxwell3d::type {
     };
     static_assert(sizeof(Scissor) == (0x4 * sizeof(u32)));
 
+    constexpr static size_t VertexAttributeCount{32}; //!< The amount of vertex attributes that can be set on Maxwell 3D
+
     union VertexAttribute {
         u32 raw;
 
@@ -309,10 +311,10 @@ namespace skyline::soc::gm20b::engine::maxwell3d::type {
             Maximum = 5,
 
             AddGL = 0x8006,
-            SubtractGL = 0x8007,
-            ReverseSubtractGL = 0x8008,
-            MinimumGL = 0x800A,
-            MaximumGL = 0x800B,
+            MinimumGL = 0x8007,
+            MaximumGL = 0x8008,
+            SubtractGL = 0x800A,
+            ReverseSubtractGL = 0x800B,
         };
 
         enum class Factor : u32 {
@@ -525,5 +527,34 @@ namespace skyline::soc::gm20b::engine::maxwell3d::type {
     };
     static_assert(sizeof(SemaphoreInfo) == sizeof(u32));
 
+    /**
+     * @brief The counters that can be reset by the guest, only the sample counter is supported
+     */
+    enum class CounterReset : u32 {
+        SampleCount = 0x01,
+        ZcullStats = 0x02,
+        TransformFeedbackPrimitivesWritten = 0x10,
+        PrimitivesGenerated = 0x11,
+    };
+
+    /**
+     * @brief The condition under which draws and clears are performed, the conditional modes depend on semaphore reports at the supplied address
+     */
+    struct RenderEnable {
+        enum class Mode : u32 {
+            Never = 0,
+            Always = 1,
+            Conditional = 2, //!< Render if the report at the address is non-zero
+            IfEqual = 3, //!< Render if the two reports at the address are equal
+            IfNotEqual = 4, //!< Render if the two reports at the address aren't equal
+        };
+
+        Address address;
+        Mode mode;
+    };
+    static_assert(sizeof(RenderEnable) == (sizeof(u32) * 3));
+
+    constexpr static size_t ConstantBufferUpdateCount{16}; //!< The amount of constant buffer update registers, a method run can increment across all of them
+
     #pragma pack(pop)
 }
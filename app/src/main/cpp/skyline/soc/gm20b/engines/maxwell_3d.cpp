@@ -2,17 +2,23 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 // Copyright © 2018-2020 fincs (https://github.com/devkitPro/deko3d)
 
-#include <boost/preprocessor/repeat.hpp>
 #include "maxwell_3d.h"
 #include <soc.h>
 
 namespace skyline::soc::gm20b::engine::maxwell3d {
-    Maxwell3D::Maxwell3D(const DeviceState &state, ChannelContext &channelCtx, gpu::interconnect::CommandExecutor &executor) : Engine(state), macroInterpreter(*this), context(*state.gpu, channelCtx, executor), channelCtx(channelCtx) {
+    #define MAXWELL3D_OFFSET(field) (sizeof(typeof(Registers::field)) - sizeof(typeof(*Registers::field))) / sizeof(u32)
+    #define MAXWELL3D_STRUCT_OFFSET(field, member) MAXWELL3D_OFFSET(field) + U32_OFFSET(typeof(*Registers::field), member)
+    #define MAXWELL3D_ARRAY_OFFSET(field, index) MAXWELL3D_OFFSET(field) + ((sizeof(typeof(Registers::field[0])) / sizeof(u32)) * index)
+    #define MAXWELL3D_ARRAY_STRUCT_OFFSET(field, index, member) MAXWELL3D_ARRAY_OFFSET(field, index) + U32_OFFSET(typeof(Registers::field[0]), member)
+    #define MAXWELL3D_ARRAY_STRUCT_STRUCT_OFFSET(field, index, member, submember) MAXWELL3D_ARRAY_STRUCT_OFFSET(field, index, member) + U32_OFFSET(typeof(Registers::field[0].member), submember)
+
+    Maxwell3D::Maxwell3D(const DeviceState &state, ChannelContext &channelCtx, gpu::interconnect::CommandExecutor &executor) : Engine(state), macroInterpreter(*this, state.settings->enableMacroJit), context(*state.gpu, channelCtx, executor), channelCtx(channelCtx) {
         ResetRegs();
     }
 
     void Maxwell3D::ResetRegs() {
         registers = {};
+        dirtyState.set(); // All host state needs to be rebuilt from the reset registers
 
         registers.rasterizerEnable = true;
 
@@ -73,6 +79,122 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         }
 
         registers.viewportTransformEnable = true;
+
+        registers.renderEnable->mode = type::RenderEnable::Mode::Always;
+    }
+
+    constexpr std::array<Maxwell3D::MethodEntry, Maxwell3D::RegisterCount> Maxwell3D::GenerateMethodTable() {
+        std::array<MethodEntry, RegisterCount> table{};
+        auto setRange{[&table](size_t offset, size_t size, u8 index) {
+            for (size_t i{}; i < size; i++)
+                table[offset + i].dirtyIndex = index;
+        }};
+
+        for (size_t index{}; index < type::RenderTargetCount; index++)
+            setRange(MAXWELL3D_ARRAY_OFFSET(renderTargets, index), sizeof(type::RenderTarget) / sizeof(u32), static_cast<u8>(DirtyState::RenderTarget + index));
+
+        setRange(MAXWELL3D_OFFSET(renderTargetControl), sizeof(type::RenderTargetControl) / sizeof(u32), DirtyState::RenderTargetControl);
+
+        for (size_t index{}; index < type::ViewportCount; index++) {
+            setRange(MAXWELL3D_ARRAY_OFFSET(viewportTransforms, index), 6, static_cast<u8>(DirtyState::Viewport + index)); // The scale and translation of all axes
+            setRange(MAXWELL3D_ARRAY_OFFSET(scissors, index), sizeof(type::Scissor) / sizeof(u32), static_cast<u8>(DirtyState::Scissor + index));
+        }
+
+        setRange(MAXWELL3D_OFFSET(clearColorValue), 4, DirtyState::ClearColor);
+
+        table[MAXWELL3D_OFFSET(rasterizerEnable)].dirtyIndex = DirtyState::Rasterizer;
+        setRange(MAXWELL3D_OFFSET(polygonMode), 2, DirtyState::Rasterizer);
+        setRange(MAXWELL3D_OFFSET(cullFaceEnable), 3, DirtyState::Rasterizer); // The cull face enable, front face and cull face
+
+        table[MAXWELL3D_OFFSET(depthTestEnable)].dirtyIndex = DirtyState::DepthStencil;
+        table[MAXWELL3D_OFFSET(depthWriteEnable)].dirtyIndex = DirtyState::DepthStencil;
+        table[MAXWELL3D_OFFSET(depthTestFunc)].dirtyIndex = DirtyState::DepthStencil;
+        table[MAXWELL3D_OFFSET(stencilEnable)].dirtyIndex = DirtyState::DepthStencil;
+        setRange(MAXWELL3D_OFFSET(stencilFront), 3, DirtyState::DepthStencil); // The fail, depth fail and pass operations
+        table[MAXWELL3D_STRUCT_OFFSET(stencilFront, compare.op)].dirtyIndex = DirtyState::DepthStencil;
+        table[MAXWELL3D_OFFSET(stencilTwoSideEnable)].dirtyIndex = DirtyState::DepthStencil;
+        setRange(MAXWELL3D_OFFSET(stencilBack), sizeof(Registers::StencilBack) / sizeof(u32), DirtyState::DepthStencil);
+
+        table[MAXWELL3D_OFFSET(multisampleControl)].dirtyIndex = DirtyState::Multisample;
+
+        setRange(MAXWELL3D_OFFSET(blendState), sizeof(Registers::BlendState) / sizeof(u32), DirtyState::Blend);
+        table[MAXWELL3D_OFFSET(independentBlendEnable)].dirtyIndex = DirtyState::Blend;
+        setRange(MAXWELL3D_OFFSET(independentBlend), (sizeof(type::Blend) / sizeof(u32)) * type::RenderTargetCount, DirtyState::Blend);
+        setRange(MAXWELL3D_OFFSET(colorMask), type::RenderTargetCount, DirtyState::Blend);
+
+        for (size_t index{}; index < type::VertexAttributeCount; index++)
+            table[MAXWELL3D_ARRAY_OFFSET(vertexAttributeState, index)].dirtyIndex = static_cast<u8>(DirtyState::VertexAttribute + index);
+
+        table[MAXWELL3D_STRUCT_OFFSET(mme, instructionRamLoad)].handler = MethodHandler::InstructionRamLoad;
+        table[MAXWELL3D_STRUCT_OFFSET(mme, startAddressRamLoad)].handler = MethodHandler::StartAddressRamLoad;
+        table[MAXWELL3D_OFFSET(syncpointAction)].handler = MethodHandler::SyncpointAction;
+        table[MAXWELL3D_OFFSET(clearBuffers)].handler = MethodHandler::ClearBuffers;
+        table[MAXWELL3D_STRUCT_OFFSET(semaphore, info)].handler = MethodHandler::SemaphoreInfo;
+        table[MAXWELL3D_OFFSET(sampleCounterEnable)].handler = MethodHandler::SampleCounterEnable;
+        table[MAXWELL3D_OFFSET(counterReset)].handler = MethodHandler::CounterReset;
+        table[MAXWELL3D_STRUCT_OFFSET(renderEnable, mode)].handler = MethodHandler::RenderEnableMode;
+        table[MAXWELL3D_ARRAY_OFFSET(firmwareCall, 4)].handler = MethodHandler::FirmwareCall4;
+        for (size_t index{}; index < type::ConstantBufferUpdateCount; index++)
+            table[MAXWELL3D_OFFSET(constantBufferUpdate) + index].handler = MethodHandler::ConstantBufferUpdate;
+
+        return table;
+    }
+
+    void Maxwell3D::FlushDirtyState() {
+        if (dirtyState.none()) [[likely]]
+            return;
+
+        for (size_t index{}; index < type::RenderTargetCount; index++)
+            if (dirtyState.test(DirtyState::RenderTarget + index))
+                context.SetRenderTarget(index, registers.renderTargets[index]);
+
+        if (dirtyState.test(DirtyState::RenderTargetControl))
+            context.UpdateRenderTargetControl(*registers.renderTargetControl);
+
+        for (size_t index{}; index < type::ViewportCount; index++) {
+            if (dirtyState.test(DirtyState::Viewport + index))
+                context.SetViewport(index, registers.viewportTransforms[index]);
+
+            if (dirtyState.test(DirtyState::Scissor + index)) {
+                auto scissor{registers.scissors[index]};
+                context.SetScissor(index, scissor.enable ? scissor : std::optional<type::Scissor>{});
+            }
+        }
+
+        if (dirtyState.test(DirtyState::ClearColor))
+            for (size_t index{}; index < registers.clearColorValue->size(); index++)
+                context.UpdateClearColorValue(index, registers.clearColorValue[index]);
+
+        if (dirtyState.test(DirtyState::Rasterizer))
+            context.SetRasterizerState(*registers.rasterizerEnable, registers.polygonMode->front, registers.polygonMode->back, *registers.cullFaceEnable, *registers.cullFace, *registers.frontFace);
+
+        if (dirtyState.test(DirtyState::DepthStencil)) {
+            auto &front{*registers.stencilFront};
+            auto &back{*registers.stencilBack};
+            context.SetDepthStencilState(*registers.depthTestEnable, *registers.depthWriteEnable, *registers.depthTestFunc, *registers.stencilEnable, *registers.stencilTwoSideEnable, front.failOp, front.zFailOp, front.zPassOp, front.compare.op, back.failOp, back.zFailOp, back.zPassOp, back.compareOp);
+        }
+
+        if (dirtyState.test(DirtyState::Multisample))
+            context.SetMultisampleState(*registers.multisampleControl);
+
+        if (dirtyState.test(DirtyState::Blend)) {
+            auto &common{*registers.blendState};
+            for (size_t index{}; index < type::RenderTargetCount; index++) {
+                bool enable{common.enable[index] != 0};
+                if (*registers.independentBlendEnable) {
+                    auto blend{registers.independentBlend[index]};
+                    context.SetAttachmentBlendState(index, enable, blend.seperateAlpha, blend.colorOp, blend.colorSrcFactor, blend.colorDestFactor, blend.alphaOp, blend.alphaSrcFactor, blend.alphaDestFactor, registers.colorMask[index]);
+                } else {
+                    context.SetAttachmentBlendState(index, enable, common.seperateAlpha, common.colorOp, common.colorSrcFactor, common.colorDestFactor, common.alphaOp, common.alphaSrcFactor, common.alphaDestFactor, registers.colorMask[index]);
+                }
+            }
+        }
+
+        for (size_t index{}; index < type::VertexAttributeCount; index++)
+            if (dirtyState.test(DirtyState::VertexAttribute + index))
+                context.SetVertexAttribute(index, registers.vertexAttributeState[index]);
+
+        dirtyState.reset();
     }
 
     void Maxwell3D::CallMethod(u32 method, u32 argument, bool lastCall) {
@@ -84,8 +206,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             if (!(method & 1)) {
                 if (macroInvocation.index != -1) {
                     // Flush the current macro as we are switching to another one
-                    macroInterpreter.Execute(macroPositions[static_cast<size_t>(macroInvocation.index)], macroInvocation.arguments);
-                    macroInvocation.arguments.clear();
+                    ExecuteMacro();
                 }
 
                 // Setup for the new macro index
@@ -96,8 +217,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
             // Flush macro after all of the data in the method call has been sent
             if (lastCall && macroInvocation.index != -1) {
-                macroInterpreter.Execute(macroPositions[static_cast<size_t>(macroInvocation.index)], macroInvocation.arguments);
-                macroInvocation.arguments.clear();
+                ExecuteMacro();
                 macroInvocation.index = -1;
             }
 
@@ -105,27 +225,6 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             return;
         }
 
-        #define MAXWELL3D_OFFSET(field) (sizeof(typeof(Registers::field)) - sizeof(typeof(*Registers::field))) / sizeof(u32)
-        #define MAXWELL3D_STRUCT_OFFSET(field, member) MAXWELL3D_OFFSET(field) + U32_OFFSET(typeof(*Registers::field), member)
-        #define MAXWELL3D_ARRAY_OFFSET(field, index) MAXWELL3D_OFFSET(field) + ((sizeof(typeof(Registers::field[0])) / sizeof(u32)) * index)
-        #define MAXWELL3D_ARRAY_STRUCT_OFFSET(field, index, member) MAXWELL3D_ARRAY_OFFSET(field, index) + U32_OFFSET(typeof(Registers::field[0]), member)
-        #define MAXWELL3D_ARRAY_STRUCT_STRUCT_OFFSET(field, index, member, submember) MAXWELL3D_ARRAY_STRUCT_OFFSET(field, index, member) + U32_OFFSET(typeof(Registers::field[0].member), submember)
-
-        #define MAXWELL3D_CASE(field, content) case MAXWELL3D_OFFSET(field): { \
-            auto field{util::BitCast<typeof(*registers.field)>(argument)};     \
-            content                                                            \
-            return;                                                            \
-        }
-        #define MAXWELL3D_CASE_BASE(fieldName, fieldAccessor, offset, content) case offset: { \
-            auto fieldName{util::BitCast<typeof(registers.fieldAccessor)>(argument)};         \
-            content                                                                           \
-            return;                                                                           \
-        }
-        #define MAXWELL3D_STRUCT_CASE(field, member, content) MAXWELL3D_CASE_BASE(member, field->member, MAXWELL3D_STRUCT_OFFSET(field, member), content)
-        #define MAXWELL3D_ARRAY_CASE(field, index, content) MAXWELL3D_CASE_BASE(field, field[index], MAXWELL3D_ARRAY_OFFSET(field, index), content)
-        #define MAXWELL3D_ARRAY_STRUCT_CASE(field, index, member, content) MAXWELL3D_CASE_BASE(member, field[index].member, MAXWELL3D_ARRAY_STRUCT_OFFSET(field, index, member), content)
-        #define MAXWELL3D_ARRAY_STRUCT_STRUCT_CASE(field, index, member, submember, content) MAXWELL3D_CASE_BASE(submember, field[index].member.submember, MAXWELL3D_ARRAY_STRUCT_STRUCT_OFFSET(field, index, member, submember), content)
-
         if (method != MAXWELL3D_STRUCT_OFFSET(mme, shadowRamControl)) {
             if (shadowRegisters.mme->shadowRamControl == type::MmeShadowRamControl::MethodTrack || shadowRegisters.mme->shadowRamControl == type::MmeShadowRamControl::MethodTrackWithFilter)
                 shadowRegisters.raw[method] = argument;
@@ -136,197 +235,296 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         bool redundant{registers.raw[method] == argument};
         registers.raw[method] = argument;
 
+        static constexpr auto MethodTable{GenerateMethodTable()};
+        auto entry{MethodTable[method]};
         if (!redundant) {
-            switch (method) {
-                MAXWELL3D_STRUCT_CASE(mme, shadowRamControl, {
-                    shadowRegisters.mme->shadowRamControl = shadowRamControl;
-                })
-
-                #define RENDER_TARGET_ARRAY(z, index, data)                               \
-                MAXWELL3D_ARRAY_STRUCT_STRUCT_CASE(renderTargets, index, address, high, { \
-                    context.SetRenderTargetAddressHigh(index, high);                      \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_STRUCT_CASE(renderTargets, index, address, low, {  \
-                    context.SetRenderTargetAddressLow(index, low);                        \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, width, {                \
-                    context.SetRenderTargetWidth(index, width);                           \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, height, {               \
-                    context.SetRenderTargetHeight(index, height);                         \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, format, {               \
-                    context.SetRenderTargetFormat(index, format);                         \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, tileMode, {             \
-                    context.SetRenderTargetTileMode(index, tileMode);                     \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, arrayMode, {            \
-                    context.SetRenderTargetArrayMode(index, arrayMode);                   \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, layerStrideLsr2, {      \
-                    context.SetRenderTargetLayerStride(index, layerStrideLsr2);           \
-                })                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(renderTargets, index, baseLayer, {            \
-                    context.SetRenderTargetBaseLayer(index, baseLayer);                   \
-                })
-
-                BOOST_PP_REPEAT(8, RENDER_TARGET_ARRAY, 0)
-                static_assert(type::RenderTargetCount == 8 && type::RenderTargetCount < BOOST_PP_LIMIT_REPEAT);
-                #undef RENDER_TARGET_ARRAY
-
-                #define VIEWPORT_TRANSFORM_CALLBACKS(z, index, data)                                      \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, scaleX, {                          \
-                    context.SetViewportX(index, scaleX, registers.viewportTransforms[index].translateX);  \
-                })                                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, translateX, {                      \
-                    context.SetViewportX(index, registers.viewportTransforms[index].scaleX, translateX);  \
-                })                                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, scaleY, {                          \
-                    context.SetViewportY(index, scaleY, registers.viewportTransforms[index].translateY);  \
-                })                                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, translateY, {                      \
-                    context.SetViewportY(index, registers.viewportTransforms[index].scaleY, translateY);  \
-                })                                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, scaleZ, {                          \
-                    context.SetViewportZ(index, scaleZ, registers.viewportTransforms[index].translateZ);  \
-                })                                                                                        \
-                MAXWELL3D_ARRAY_STRUCT_CASE(viewportTransforms, index, translateZ, {                      \
-                    context.SetViewportZ(index, registers.viewportTransforms[index].scaleZ, translateZ);  \
-                })
-
-                BOOST_PP_REPEAT(16, VIEWPORT_TRANSFORM_CALLBACKS, 0)
-                static_assert(type::ViewportCount == 16 && type::ViewportCount < BOOST_PP_LIMIT_REPEAT);
-                #undef VIEWPORT_TRANSFORM_CALLBACKS
-
-                #define COLOR_CLEAR_CALLBACKS(z, index, data)              \
-                MAXWELL3D_ARRAY_CASE(clearColorValue, index, {             \
-                    context.UpdateClearColorValue(index, clearColorValue); \
-                })
-
-                BOOST_PP_REPEAT(4, COLOR_CLEAR_CALLBACKS, 0)
-                static_assert(4 < BOOST_PP_LIMIT_REPEAT);
-                #undef COLOR_CLEAR_CALLBACKS
-
-                #define SCISSOR_CALLBACKS(z, index, data)                                                           \
-                MAXWELL3D_ARRAY_STRUCT_CASE(scissors, index, enable, {                                              \
-                    context.SetScissor(index, enable ? registers.scissors[index] : std::optional<type::Scissor>{}); \
-                })                                                                                                  \
-                MAXWELL3D_ARRAY_STRUCT_CASE(scissors, index, horizontal, {                                          \
-                    context.SetScissorHorizontal(index, horizontal);                                                \
-                })                                                                                                  \
-                MAXWELL3D_ARRAY_STRUCT_CASE(scissors, index, vertical, {                                            \
-                    context.SetScissorVertical(index, vertical);                                                    \
-                })
-
-                BOOST_PP_REPEAT(16, SCISSOR_CALLBACKS, 0)
-                static_assert(type::ViewportCount == 16 && type::ViewportCount < BOOST_PP_LIMIT_REPEAT);
-                #undef SCISSOR_CALLBACKS
-
-                MAXWELL3D_CASE(renderTargetControl, {
-                    context.UpdateRenderTargetControl(renderTargetControl);
-                })
+            if (entry.dirtyIndex != DirtyState::None)
+                dirtyState.set(entry.dirtyIndex);
+
+            if (method == MAXWELL3D_STRUCT_OFFSET(mme, shadowRamControl))
+                shadowRegisters.mme->shadowRamControl = util::BitCast<typeof(registers.mme->shadowRamControl)>(argument);
+        }
+
+        // Methods with side-effects are dispatched with a single indexed call, they're called regardless of the write being redundant as repeating them isn't a no-op
+        if (entry.handler != MethodHandler::None)
+            (this->*MethodHandlers[entry.handler])(argument);
+    }
+
+    const std::array<Maxwell3D::MethodFunction, Maxwell3D::MethodHandler::Count> Maxwell3D::MethodHandlers{
+        nullptr,
+        &Maxwell3D::HandleInstructionRamLoad,
+        &Maxwell3D::HandleStartAddressRamLoad,
+        &Maxwell3D::HandleSyncpointAction,
+        &Maxwell3D::HandleClearBuffers,
+        &Maxwell3D::HandleSemaphoreInfo,
+        &Maxwell3D::HandleSampleCounterEnable,
+        &Maxwell3D::HandleCounterReset,
+        &Maxwell3D::HandleRenderEnableMode,
+        &Maxwell3D::HandleFirmwareCall4,
+        &Maxwell3D::HandleConstantBufferUpdate,
+    };
+
+    void Maxwell3D::HandleInstructionRamLoad(u32 argument) {
+        if (registers.mme->instructionRamPointer >= macroCode.size())
+            throw exception("Macro memory is full!");
+
+        macroCode[registers.mme->instructionRamPointer++] = argument;
+        macroInterpreter.InvalidateMacroCode();
+        macroHleResolved.reset();
+
+        // Wraparound writes
+        registers.mme->instructionRamPointer %= macroCode.size();
+    }
+
+    void Maxwell3D::HandleStartAddressRamLoad(u32 argument) {
+        if (registers.mme->startAddressRamPointer >= macroPositions.size())
+            throw exception("Maximum amount of macros reached!");
+
+        macroPositions[registers.mme->startAddressRamPointer++] = argument;
+        macroHleResolved.reset();
+    }
+
+    void Maxwell3D::HandleSyncpointAction(u32 argument) {
+        auto syncpointAction{util::BitCast<typeof(*registers.syncpointAction)>(argument)};
+        Logger::Debug("Increment syncpoint: {}", static_cast<u16>(syncpointAction.id));
+        channelCtx.executor.Execute([&syncpoint = state.soc->host1x.syncpoints.at(syncpointAction.id)] {
+            syncpoint.Increment();
+        });
+    }
+
+    void Maxwell3D::HandleClearBuffers(u32 argument) {
+        FlushDirtyState();
+        context.ClearBuffers(util::BitCast<typeof(*registers.clearBuffers)>(argument));
+    }
+
+    void Maxwell3D::HandleSemaphoreInfo(u32 argument) {
+        auto info{util::BitCast<typeof(registers.semaphore->info)>(argument)};
+        switch (info.op) {
+            case type::SemaphoreInfo::Op::Release:
+                WriteSemaphoreResult(registers.semaphore->payload);
+                break;
+
+            case type::SemaphoreInfo::Op::Counter: {
+                switch (info.counterType) {
+                    case type::SemaphoreInfo::CounterType::Zero:
+                        WriteSemaphoreResult(0);
+                        break;
+
+                    case type::SemaphoreInfo::CounterType::SamplesPassed:
+                        ReportSamplesPassed();
+                        break;
+
+                    default:
+                        Logger::Warn("Unsupported semaphore counter type: 0x{:X}", static_cast<u8>(info.counterType));
+                        break;
+                }
+                break;
             }
+
+            default:
+                Logger::Warn("Unsupported semaphore operation: 0x{:X}", static_cast<u8>(info.op));
+                break;
         }
+    }
+
+    void Maxwell3D::HandleSampleCounterEnable(u32 argument) {
+        channelCtx.executor.SetSampleCounting(util::BitCast<typeof(*registers.sampleCounterEnable)>(argument));
+    }
 
-        switch (method) {
-            MAXWELL3D_STRUCT_CASE(mme, instructionRamLoad, {
-                if (registers.mme->instructionRamPointer >= macroCode.size())
-                    throw exception("Macro memory is full!");
+    void Maxwell3D::HandleCounterReset(u32 argument) {
+        auto counterReset{util::BitCast<typeof(*registers.counterReset)>(argument)};
+        if (counterReset == type::CounterReset::SampleCount)
+            channelCtx.executor.ResetSampleCounter();
+        else
+            Logger::Debug("Unsupported counter reset: 0x{:X}", static_cast<u32>(counterReset));
+    }
 
-                macroCode[registers.mme->instructionRamPointer++] = instructionRamLoad;
+    void Maxwell3D::HandleRenderEnableMode(u32) {
+        UpdateRenderCondition();
+    }
 
-                // Wraparound writes
-                registers.mme->instructionRamPointer %= macroCode.size();
-            })
+    void Maxwell3D::HandleFirmwareCall4(u32) {
+        registers.raw[0xD00] = 1;
+    }
 
-            MAXWELL3D_STRUCT_CASE(mme, startAddressRamLoad, {
-                if (registers.mme->startAddressRamPointer >= macroPositions.size())
-                    throw exception("Maximum amount of macros reached!");
+    void Maxwell3D::HandleConstantBufferUpdate(u32 argument) {
+        ConstantBufferUpdate(span<u32>(&argument, 1));
+    }
 
-                macroPositions[registers.mme->startAddressRamPointer++] = startAddressRamLoad;
-            })
+    void Maxwell3D::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        Logger::Debug("Called method batch in Maxwell 3D: 0x{:X} count: {} increment: {}", method, arguments.size(), increment);
 
-            MAXWELL3D_CASE(syncpointAction, {
-                Logger::Debug("Increment syncpoint: {}", static_cast<u16>(syncpointAction.id));
-                channelCtx.executor.Execute();
-                state.soc->host1x.syncpoints.at(syncpointAction.id).Increment();
-            })
+        if (method >= RegisterCount) [[unlikely]] {
+            // Arguments to the odd method of a macro are appended to the current invocation, this is the common case of a macro being called with a OneInc method
+            if ((method & 1) && !increment && macroInvocation.index != -1) {
+                macroInvocation.arguments.insert(macroInvocation.arguments.end(), arguments.begin(), arguments.end());
 
-            MAXWELL3D_CASE(clearBuffers, {
-                context.ClearBuffers(clearBuffers);
-            })
+                if (lastCall) {
+                    ExecuteMacro();
+                    macroInvocation.index = -1;
+                }
 
-            MAXWELL3D_STRUCT_CASE(semaphore, info, {
-                switch (info.op) {
-                    case type::SemaphoreInfo::Op::Release:
-                        WriteSemaphoreResult(registers.semaphore->payload);
+                return;
+            }
+        } else if (shadowRegisters.mme->shadowRamControl != type::MmeShadowRamControl::MethodReplay) {
+            constexpr u32 ConstantBufferUpdateStart{MAXWELL3D_OFFSET(constantBufferUpdate)}, ConstantBufferUpdateEnd{ConstantBufferUpdateStart + type::ConstantBufferUpdateCount};
+            bool handled{true};
+            if (method >= ConstantBufferUpdateStart && method < ConstantBufferUpdateEnd && (!increment || method + arguments.size() <= ConstantBufferUpdateEnd)) {
+                // Constant buffer updates are by far the most common long method runs, they're forwarded as a single contiguous write rather than a write per word
+                ConstantBufferUpdate(arguments);
+            } else if (!increment) {
+                // Macro memory uploads have no side-effects aside from the write itself, so they can be bulk copied rather than written word-by-word
+                switch (method) {
+                    case MAXWELL3D_STRUCT_OFFSET(mme, instructionRamLoad): {
+                        auto &pointer{registers.mme->instructionRamPointer};
+                        for (u32 argument : arguments) {
+                            if (pointer >= macroCode.size())
+                                throw exception("Macro memory is full!");
+
+                            macroCode[pointer++] = argument;
+
+                            // Wraparound writes
+                            pointer %= macroCode.size();
+                        }
+                        macroInterpreter.InvalidateMacroCode();
+                        macroHleResolved.reset();
                         break;
+                    }
 
-                    case type::SemaphoreInfo::Op::Counter: {
-                        switch (info.counterType) {
-                            case type::SemaphoreInfo::CounterType::Zero:
-                                WriteSemaphoreResult(0);
-                                break;
+                    case MAXWELL3D_STRUCT_OFFSET(mme, startAddressRamLoad): {
+                        auto &pointer{registers.mme->startAddressRamPointer};
+                        for (u32 argument : arguments) {
+                            if (pointer >= macroPositions.size())
+                                throw exception("Maximum amount of macros reached!");
 
-                            default:
-                                Logger::Warn("Unsupported semaphore counter type: 0x{:X}", static_cast<u8>(info.counterType));
-                                break;
+                            macroPositions[pointer++] = argument;
                         }
+                        macroHleResolved.reset();
                         break;
                     }
 
                     default:
-                        Logger::Warn("Unsupported semaphore operation: 0x{:X}", static_cast<u8>(info.op));
+                        handled = false;
                         break;
                 }
-            })
+            } else {
+                handled = false;
+            }
 
-            MAXWELL3D_ARRAY_CASE(firmwareCall, 4, {
-                registers.raw[0xD00] = 1;
-            })
+            if (handled) {
+                auto lastMethod{increment ? method + static_cast<u32>(arguments.size()) - 1 : method};
+                registers.raw[lastMethod] = arguments.back();
+                if (shadowRegisters.mme->shadowRamControl == type::MmeShadowRamControl::MethodTrack || shadowRegisters.mme->shadowRamControl == type::MmeShadowRamControl::MethodTrackWithFilter)
+                    shadowRegisters.raw[lastMethod] = arguments.back();
+                return;
+            }
+        }
 
-            default:
-                break;
+        for (u32 index{}; index < arguments.size(); index++)
+            CallMethod(increment ? method + index : method, arguments[index], lastCall && index == arguments.size() - 1);
+    }
+
+    void Maxwell3D::ExecuteMacro() {
+        auto index{static_cast<size_t>(macroInvocation.index)};
+        auto position{macroPositions[index]};
+
+        if (!macroHleResolved.test(index)) [[unlikely]] {
+            macroHleFunctions[index] = MacroHle::Lookup(macroInterpreter, position);
+            macroHleResolved.set(index);
+
+            if (!macroHleFunctions[index])
+                Logger::Debug("Macro {} at 0x{:X} has no HLE implementation: 0x{:016X}", index, position, MacroHle::Hash(macroCode, position));
         }
 
-        #undef MAXWELL3D_OFFSET
-        #undef MAXWELL3D_STRUCT_OFFSET
-        #undef MAXWELL3D_ARRAY_OFFSET
-        #undef MAXWELL3D_ARRAY_STRUCT_OFFSET
-        #undef MAXWELL3D_ARRAY_STRUCT_STRUCT_OFFSET
-
-        #undef MAXWELL3D_CASE_BASE
-        #undef MAXWELL3D_CASE
-        #undef MAXWELL3D_STRUCT_CASE
-        #undef MAXWELL3D_ARRAY_CASE
-        #undef MAXWELL3D_ARRAY_STRUCT_CASE
-        #undef MAXWELL3D_ARRAY_STRUCT_STRUCT_CASE
+        auto function{macroHleFunctions[index]};
+        if (!function || !function(*this, macroInvocation.arguments))
+            macroInterpreter.Execute(position, macroInvocation.arguments);
+
+        macroInvocation.arguments.clear();
+    }
+
+    void Maxwell3D::ConstantBufferUpdate(span<u32> data) {
+        auto &selector{*registers.constantBufferSelector};
+        if (selector.offset + data.size_bytes() > selector.size)
+            throw exception("Constant buffer update out of bounds: 0x{:X} + 0x{:X} (Size: 0x{:X})", selector.offset, data.size_bytes(), selector.size);
+
+        context.ConstantBufferUpdate(selector.address.Pack() + selector.offset, data);
+        selector.offset += data.size_bytes();
     }
 
     void Maxwell3D::WriteSemaphoreResult(u64 result) {
-        struct FourWordResult {
-            u64 value;
-            u64 timestamp;
-        };
-
-        switch (registers.semaphore->info.structureSize) {
-            case type::SemaphoreInfo::StructureSize::OneWord:
-                channelCtx.asCtx->gmmu.Write<u32>(registers.semaphore->address.Pack(), static_cast<u32>(result));
-                break;
+        bool fourWords{registers.semaphore->info.structureSize == type::SemaphoreInfo::StructureSize::FourWords};
+        if (auto address{channelCtx.gmmuTlb.Translate(registers.semaphore->address.Pack(), fourWords ? sizeof(u64) * 2 : sizeof(u32))}) [[likely]] {
+            channelCtx.executor.ReleaseSemaphore(address, result, fourWords);
+            return;
+        }
 
-            case type::SemaphoreInfo::StructureSize::FourWords: {
-                // Convert the current nanosecond time to GPU ticks
-                constexpr i64 NsToTickNumerator{384};
-                constexpr i64 NsToTickDenominator{625};
+        // Semaphores that aren't contained in a single page are written immediately through the GMMU, this may be observed by the guest prior to the work preceding it completing
+        Logger::Warn("Semaphore at 0x{:X} isn't contained in a single page, releasing it immediately", registers.semaphore->address.Pack());
+        if (fourWords) {
+            struct FourWordResult {
+                u64 value;
+                u64 timestamp;
+            };
+            channelCtx.gmmuTlb.Write<FourWordResult>(registers.semaphore->address.Pack(), FourWordResult{result, util::GetGpuTimeTicks()});
+        } else {
+            channelCtx.gmmuTlb.Write<u32>(registers.semaphore->address.Pack(), static_cast<u32>(result));
+        }
+    }
 
-                i64 nsTime{util::GetTimeNs()};
-                i64 timestamp{(nsTime / NsToTickDenominator) * NsToTickNumerator + ((nsTime % NsToTickDenominator) * NsToTickNumerator) / NsToTickDenominator};
+    void Maxwell3D::ReportSamplesPassed() {
+        bool fourWords{registers.semaphore->info.structureSize == type::SemaphoreInfo::StructureSize::FourWords};
+        auto address{channelCtx.gmmuTlb.Translate(registers.semaphore->address.Pack(), fourWords ? sizeof(u64) * 2 : sizeof(u32))};
+        if (!address) [[unlikely]] {
+            Logger::Warn("Sample count report to 0x{:X} isn't contained in a single page, reporting zero", registers.semaphore->address.Pack());
+            WriteSemaphoreResult(0);
+            return;
+        }
 
-                channelCtx.asCtx->gmmu.Write<FourWordResult>(registers.semaphore->address.Pack(),
-                                                             FourWordResult{result, static_cast<u64>(timestamp)});
+        channelCtx.executor.ReportSamplesPassed(address, fourWords);
+    }
+
+    void Maxwell3D::UpdateRenderCondition() {
+        auto &renderEnable{*registers.renderEnable};
+        gpu::interconnect::RenderCondition condition;
+        switch (renderEnable.mode) {
+            case type::RenderEnable::Mode::Never:
+                condition = gpu::interconnect::RenderCondition::Never;
+                break;
+            case type::RenderEnable::Mode::Always:
+                condition = gpu::interconnect::RenderCondition::Always;
+                break;
+            case type::RenderEnable::Mode::Conditional:
+                condition = gpu::interconnect::RenderCondition::IfNonZero;
+                break;
+            case type::RenderEnable::Mode::IfEqual:
+                condition = gpu::interconnect::RenderCondition::IfEqual;
+                break;
+            case type::RenderEnable::Mode::IfNotEqual:
+                condition = gpu::interconnect::RenderCondition::IfNotEqual;
                 break;
+            default:
+                Logger::Warn("Unknown render enable mode: 0x{:X}", static_cast<u32>(renderEnable.mode));
+                condition = gpu::interconnect::RenderCondition::Always;
+                break;
+        }
+
+        u8 *address{};
+        if (condition != gpu::interconnect::RenderCondition::Never && condition != gpu::interconnect::RenderCondition::Always) {
+            // Equality conditions compare two consecutive four word reports
+            address = channelCtx.gmmuTlb.Translate(renderEnable.address.Pack(), sizeof(u64) * (condition == gpu::interconnect::RenderCondition::IfNonZero ? 1 : 3));
+            if (!address) [[unlikely]] {
+                Logger::Warn("Render condition on reports at 0x{:X} which aren't contained in a single page, rendering unconditionally", renderEnable.address.Pack());
+                condition = gpu::interconnect::RenderCondition::Always;
             }
         }
+
+        channelCtx.executor.SetRenderCondition(condition, address);
     }
+
+    #undef MAXWELL3D_OFFSET
+    #undef MAXWELL3D_STRUCT_OFFSET
+    #undef MAXWELL3D_ARRAY_OFFSET
+    #undef MAXWELL3D_ARRAY_STRUCT_OFFSET
+    #undef MAXWELL3D_ARRAY_STRUCT_STRUCT_OFFSET
 }
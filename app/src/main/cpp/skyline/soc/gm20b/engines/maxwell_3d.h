@@ -7,6 +7,7 @@
 #include <gpu/interconnect/graphics_context.h>
 #include "engine.h"
 #include "maxwell/macro_interpreter.h"
+#include "maxwell/macro_hle.h"
 
 namespace skyline::soc::gm20b {
     struct ChannelContext;
@@ -27,14 +28,38 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
         MacroInterpreter macroInterpreter;
 
+        friend MacroHle;
+        std::array<MacroHle::Function, 0x80> macroHleFunctions{}; //!< The native implementations of each macro, nullptr for macros that have no implementation
+        std::bitset<0x80> macroHleResolved{}; //!< If the corresponding entry in 'macroHleFunctions' is up to date with macro memory, this is reset on any write to macro memory or macro positions
+
         gpu::interconnect::GraphicsContext context;
 
         /**
-         * @brief Writes back a semaphore result to the guest with an auto-generated timestamp (if required)
+         * @brief Writes back a semaphore result to the guest with an auto-generated timestamp (if required), this is deferred till all prior work has completed on the host GPU
          * @note If the semaphore is OneWord then the result will be downcasted to a 32-bit unsigned integer
          */
         void WriteSemaphoreResult(u64 result);
 
+        /**
+         * @brief Reports the amount of samples passed since the last reset of the sample counter, it's written back asynchronously once the host GPU has executed all prior draws
+         */
+        void ReportSamplesPassed();
+
+        /**
+         * @brief Translates the guest render enable into the condition under which the executor performs later draws and clears
+         */
+        void UpdateRenderCondition();
+
+        /**
+         * @brief Executes the pending macro invocation with its native implementation if one exists or with the macro interpreter otherwise, the arguments of the invocation are cleared afterwards
+         */
+        void ExecuteMacro();
+
+        /**
+         * @brief Writes a run of words to the selected constant buffer at the current offset and advances the offset past them
+         */
+        void ConstantBufferUpdate(span<u32> data);
+
       public:
         static constexpr u32 RegisterCount{0xE00}; //!< The number of Maxwell 3D registers
 
@@ -94,8 +119,11 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             Register<0x3D9, TiledCacheSize> tiledCacheSize;
 
             Register<0x3EB, u32> rtSeparateFragData;
-            Register<0x458, std::array<type::VertexAttribute, 0x20>> vertexAttributeState;
+            Register<0x458, std::array<type::VertexAttribute, type::VertexAttributeCount>> vertexAttributeState;
             Register<0x487, type::RenderTargetControl> renderTargetControl;
+            Register<0x4B3, u32> depthTestEnable;
+            Register<0x4B9, u32> independentBlendEnable;
+            Register<0x4BA, u32> depthWriteEnable;
             Register<0x4C3, type::CompareOp> depthTestFunc;
             Register<0x4C4, float> alphaTestRef;
             Register<0x4C5, type::CompareOp> alphaTestFunc;
@@ -116,6 +144,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 type::Blend::Factor colorDestFactor; // 0x4D2
                 type::Blend::Op alphaOp; // 0x4D3
                 type::Blend::Factor alphaSrcFactor; // 0x4D4
+                u32 _pad_;
                 type::Blend::Factor alphaDestFactor; // 0x4D6
 
                 u32 enableCommon; // 0x4D7
@@ -151,11 +180,14 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             Register<0x547, u32> zCullStatCountersEnable;
             Register<0x548, u32> pointSpriteEnable;
             Register<0x54A, u32> shaderExceptions;
+            Register<0x54C, type::CounterReset> counterReset;
             Register<0x54D, u32> multisampleEnable;
             Register<0x54E, u32> depthTargetEnable;
 
             Register<0x54F, type::MultisampleControl> multisampleControl;
 
+            Register<0x554, type::RenderEnable> renderEnable;
+
             struct SamplerPool {
                 type::Address address; // 0x557
                 u32 maximumIndex; // 0x559
@@ -201,10 +233,103 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
             Register<0x780, std::array<type::Blend, type::RenderTargetCount>> independentBlend;
             Register<0x8C0, u32[0x20]> firmwareCall;
+
+            struct ConstantBufferSelector {
+                u32 size; // 0x8E0
+                type::Address address; // 0x8E1
+                u32 offset; // 0x8E3 The offset into the constant buffer that the next update is written to, this is incremented by every update
+            };
+            Register<0x8E0, ConstantBufferSelector> constantBufferSelector;
+
+            Register<0x8E4, std::array<u32, type::ConstantBufferUpdateCount>> constantBufferUpdate; //!< Writes to any of these registers write the argument to the selected constant buffer, they're all equivalent and only exist to allow incrementing method runs
         };
         static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
         #pragma pack(pop)
 
+      private:
+        /**
+         * @brief Indices of groups of registers which are translated into host state together, a group is marked dirty by any non-redundant write to a register within it
+         */
+        struct DirtyState {
+            static constexpr u8 None{0}; //!< Registers which aren't translated into any host state
+            static constexpr u8 RenderTarget{1}; //!< The first of RenderTargetCount groups for each render target
+            static constexpr u8 RenderTargetControl{RenderTarget + type::RenderTargetCount};
+            static constexpr u8 Viewport{RenderTargetControl + 1}; //!< The first of ViewportCount groups for each viewport transform
+            static constexpr u8 Scissor{Viewport + type::ViewportCount}; //!< The first of ViewportCount groups for each scissor
+            static constexpr u8 ClearColor{Scissor + type::ViewportCount};
+            static constexpr u8 Rasterizer{ClearColor + 1}; //!< The polygon modes, culling and rasterizer enable
+            static constexpr u8 DepthStencil{Rasterizer + 1}; //!< The depth test and stencil operations, masks and references are dynamic host state and aren't included
+            static constexpr u8 Multisample{DepthStencil + 1};
+            static constexpr u8 Blend{Multisample + 1}; //!< The common and independent blend state alongside the color write masks of all RTs, these are grouped as the common state applies to all RTs
+            static constexpr u8 VertexAttribute{Blend + 1}; //!< The first of VertexAttributeCount groups for each vertex attribute
+            static constexpr u8 Count{VertexAttribute + type::VertexAttributeCount};
+        };
+
+        std::bitset<DirtyState::Count> dirtyState; //!< The groups of registers which have been written to since they were last flushed to the GraphicsContext
+
+        /**
+         * @brief Indices into MethodHandlers of the handlers for methods which have side-effects beyond writing their register
+         */
+        struct MethodHandler {
+            static constexpr u8 None{0}; //!< Methods which only store their argument
+            static constexpr u8 InstructionRamLoad{1};
+            static constexpr u8 StartAddressRamLoad{2};
+            static constexpr u8 SyncpointAction{3};
+            static constexpr u8 ClearBuffers{4};
+            static constexpr u8 SemaphoreInfo{5};
+            static constexpr u8 SampleCounterEnable{6};
+            static constexpr u8 CounterReset{7};
+            static constexpr u8 RenderEnableMode{8};
+            static constexpr u8 FirmwareCall4{9};
+            static constexpr u8 ConstantBufferUpdate{10}; //!< All ConstantBufferUpdateCount constant buffer update methods
+            static constexpr u8 Count{11};
+        };
+
+        /**
+         * @brief The DirtyState group and MethodHandler of a single method, this is kept small so the entire table fits in a few KiB
+         */
+        struct MethodEntry {
+            u8 dirtyIndex; //!< The DirtyState group that the register belongs to
+            u8 handler; //!< The MethodHandler which is called after the register has been written
+        };
+
+        using MethodFunction = void (Maxwell3D::*)(u32 argument);
+        static const std::array<MethodFunction, MethodHandler::Count> MethodHandlers; //!< The functions of all MethodHandler indices, MethodHandler::None has no function
+
+        /**
+         * @return A table mapping each register to the DirtyState group it belongs to and the handler of its method, this is generated at compile-time from the register layout
+         */
+        static constexpr std::array<MethodEntry, RegisterCount> GenerateMethodTable();
+
+        /**
+         * @brief The handlers of all methods with a MethodHandler, these are called with the argument after it has been written into the register
+         */
+        void HandleInstructionRamLoad(u32 argument);
+
+        void HandleStartAddressRamLoad(u32 argument);
+
+        void HandleSyncpointAction(u32 argument);
+
+        void HandleClearBuffers(u32 argument);
+
+        void HandleSemaphoreInfo(u32 argument);
+
+        void HandleSampleCounterEnable(u32 argument);
+
+        void HandleCounterReset(u32 argument);
+
+        void HandleRenderEnableMode(u32 argument);
+
+        void HandleFirmwareCall4(u32 argument);
+
+        void HandleConstantBufferUpdate(u32 argument);
+
+        /**
+         * @brief Translates the register state of all dirty groups into the GraphicsContext, this must be called prior to the GraphicsContext using any state
+         */
+        void FlushDirtyState();
+
+      public:
         Registers registers{};
         Registers shadowRegisters{}; //!< A shadow-copy of the registers, their function is controlled by the 'shadowRamControl' register
 
@@ -220,5 +345,10 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         void ResetRegs();
 
         void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        /**
+         * @brief Calls a run of methods with the supplied arguments, macro arguments, macro memory uploads and constant buffer updates are handled in bulk while other methods fall back to CallMethod
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
     };
 }
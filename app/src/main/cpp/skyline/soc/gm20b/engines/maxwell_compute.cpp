@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <soc/gm20b/channel.h>
+#include "maxwell_compute.h"
+
+namespace skyline::soc::gm20b::engine {
+    #define MAXWELL_COMPUTE_OFFSET(field) U32_OFFSET(Registers, field)
+
+    MaxwellCompute::MaxwellCompute(const DeviceState &state, ChannelContext &channelCtx) : Engine(state), channelCtx(channelCtx), inlineUpload(state, channelCtx) {}
+
+    void MaxwellCompute::Launch() {
+        TRACE_EVENT("gpu", "MaxwellCompute::Launch");
+
+        auto qmd{channelCtx.gmmuTlb.Read<Qmd>(static_cast<u64>(registers.launchDescAddress) << 8)};
+        if (!qmd.gridDimX || !qmd.gridDimY || !qmd.gridDimZ || !qmd.blockDimX || !qmd.blockDimY || !qmd.blockDimZ)
+            return; // Empty grids don't run any invocations
+
+        u64 programAddress{registers.codeAddress.Pack() + qmd.programStart};
+        Logger::Debug("Compute launch: program 0x{:X} grid: {}x{}x{} block: {}x{}x{} shared memory: 0x{:X} constant buffers: 0x{:X}", programAddress, qmd.gridDimX, qmd.gridDimY, qmd.gridDimZ, qmd.blockDimX, qmd.blockDimY, qmd.blockDimZ, qmd.sharedMemorySize, qmd.constantBufferEnableMask);
+
+        for (size_t index{}; index < ConstantBufferCount; index++) {
+            if (!(qmd.constantBufferEnableMask & (1U << index)))
+                continue;
+
+            auto &constantBuffer{qmd.constantBuffers[index]};
+            if (!channelCtx.gmmuTlb.Translate(constantBuffer.Address(), 1)) [[unlikely]]
+                Logger::Warn("Compute constant buffer {} is unmapped: 0x{:X} (Size: 0x{:X})", index, constantBuffer.Address(), constantBuffer.size);
+        }
+
+        if (!warnedLaunch) {
+            Logger::Warn("Compute grids can't be dispatched on the host as guest shaders aren't translated, launches are ignored");
+            warnedLaunch = true;
+        }
+    }
+
+    void MaxwellCompute::CallMethod(u32 method, u32 argument, bool lastCall) {
+        CallMethodBatch(method, span<u32>(&argument, 1), true, lastCall);
+    }
+
+    void MaxwellCompute::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        Logger::Debug("Called method batch in Maxwell Compute: 0x{:X} count: {} increment: {}", method, arguments.size(), increment);
+
+        if (method + (increment ? arguments.size() : 1) > RegisterCount) [[unlikely]] {
+            Logger::Warn("Out of bounds Maxwell Compute method batch called: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        constexpr u32 UploadBeginMethod{MAXWELL_COMPUTE_OFFSET(upload)};
+        constexpr u32 UploadEndMethod{UploadBeginMethod + (sizeof(Registers::upload) / sizeof(u32))};
+        constexpr u32 LaunchMethod{MAXWELL_COMPUTE_OFFSET(launch)};
+
+        // Runs are split into the parts that are forwarded to the inline upload unit, launches and flat register writes
+        while (!arguments.empty()) {
+            size_t count;
+            if (method >= UploadBeginMethod && method < UploadEndMethod) {
+                count = increment ? std::min<size_t>(UploadEndMethod - method, arguments.size()) : arguments.size();
+                inlineUpload.CallMethodBatch(method, arguments.first(count), increment, lastCall && count == arguments.size());
+            } else if (method == LaunchMethod) {
+                count = increment ? 1 : arguments.size();
+                for (u32 argument : arguments.first(count)) {
+                    registers.raw[method] = argument;
+                    Launch();
+                }
+            } else if (increment) {
+                u32 nextMethod{method < UploadBeginMethod ? UploadBeginMethod : (method < LaunchMethod ? LaunchMethod : RegisterCount)};
+                count = std::min<size_t>(nextMethod - method, arguments.size());
+                span(registers.raw).subspan(method).copy_from(arguments.first(count));
+            } else {
+                count = arguments.size();
+                registers.raw[method] = arguments.back();
+            }
+
+            arguments = arguments.subspan(count);
+            if (increment)
+                method += static_cast<u32>(count);
+        }
+    }
+
+    #undef MAXWELL_COMPUTE_OFFSET
+}
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "maxwell/types.h"
+#include "kepler_memory.h"
+#include "engine.h"
+
+namespace skyline::soc::gm20b {
+    struct ChannelContext;
+}
+
+namespace skyline::soc::gm20b::engine {
+    /**
+     * @brief The Maxwell Compute engine launches compute grids which are described by a QMD (Queue Meta Data) structure in guest memory
+     * @note The engine embeds an inline upload unit which is identical to the Inline2Memory engine, methods to it are forwarded to a KeplerMemory instance
+     */
+    class MaxwellCompute : public Engine {
+      public:
+        static constexpr u32 RegisterCount{0xCF8}; //!< The number of Maxwell Compute registers
+        static constexpr size_t ConstantBufferCount{8}; //!< The amount of constant buffers that can be bound by a QMD
+
+      private:
+        #pragma pack(push, 1)
+        union Registers {
+            std::array<u32, RegisterCount> raw;
+
+            /**
+             * @brief The address and size of a pool of texture or sampler descriptors
+             */
+            struct DescriptorPool {
+                maxwell3d::type::Address address;
+                u32 maximumIndex;
+            };
+            static_assert(sizeof(DescriptorPool) == (sizeof(u32) * 3));
+
+            struct {
+                u32 _pad0_[0x60]; // 0x0
+                u32 upload[0xE]; // 0x60, these are forwarded to the inline upload unit
+                u32 _pad1_[0x3F]; // 0x6E
+                u32 launchDescAddress; // 0xAD, the address of the QMD shifted right by 8
+                u32 _pad2_; // 0xAE
+                u32 launch; // 0xAF
+                u32 _pad3_[0x4A7]; // 0xB0
+                DescriptorPool samplerPool; // 0x557
+                u32 _pad4_[0x3]; // 0x55A
+                DescriptorPool texturePool; // 0x55D
+                u32 _pad5_[0x22]; // 0x560
+                maxwell3d::type::Address codeAddress; // 0x582
+                u32 _pad6_[0x3FE]; // 0x584
+                u32 textureConstantBufferIndex; // 0x982
+                u32 _pad7_[0x375]; // 0x983
+            };
+        } registers{};
+        static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
+
+        /**
+         * @brief The QMD which describes a single compute grid launch
+         */
+        struct Qmd {
+            struct ConstantBuffer {
+                u32 addressLow;
+                u32 addressHigh : 8;
+                u32 _pad_ : 7;
+                u32 size : 17;
+
+                u64 Address() const {
+                    return (static_cast<u64>(addressHigh) << 32) | addressLow;
+                }
+            };
+            static_assert(sizeof(ConstantBuffer) == sizeof(u64));
+
+            u32 _pad0_[0x8]; // 0x0
+            u32 programStart; // 0x8, the offset of the shader program from the code address
+            u32 _pad1_[0x2]; // 0x9
+            u32 _pad2_ : 30; // 0xB
+            u32 linkedTsc : 1; //!< If sampler descriptors are indexed with the same index as their texture descriptor
+            u32 _pad3_ : 1;
+            u32 gridDimX : 31; // 0xC
+            u32 _pad4_ : 1;
+            u16 gridDimY; // 0xD
+            u16 gridDimZ;
+            u32 _pad5_[0x3]; // 0xE
+            u32 sharedMemorySize : 18; // 0x11
+            u32 _pad6_ : 14;
+            u16 _pad7_; // 0x12
+            u16 blockDimX;
+            u16 blockDimY; // 0x13
+            u16 blockDimZ;
+            u8 constantBufferEnableMask; // 0x14
+            u8 _pad8_;
+            u16 _pad9_;
+            u32 _pad10_[0x8]; // 0x15
+            std::array<ConstantBuffer, ConstantBufferCount> constantBuffers; // 0x1D
+            u32 localPositiveMemorySize : 20; // 0x2D
+            u32 _pad11_ : 7;
+            u32 barrierCount : 5;
+            u32 localNegativeMemorySize : 20; // 0x2E
+            u32 _pad12_ : 4;
+            u32 registerCount : 5;
+            u32 _pad13_ : 3;
+            u32 callReturnStackSize : 20; // 0x2F
+            u32 _pad14_ : 12;
+            u32 _pad15_[0x10]; // 0x30
+        };
+        static_assert(sizeof(Qmd) == (sizeof(u32) * 0x40));
+        #pragma pack(pop)
+
+        ChannelContext &channelCtx;
+        KeplerMemory inlineUpload; //!< The inline upload unit of the compute engine
+        bool warnedLaunch{}; //!< If the lack of host compute dispatches has already been reported for this engine
+
+        /**
+         * @brief Launches the grid described by the QMD at the launch descriptor address
+         */
+        void Launch();
+
+      public:
+        MaxwellCompute(const DeviceState &state, ChannelContext &channelCtx);
+
+        void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
+    };
+}
@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <gpu.h>
+#include <gpu/texture/copy.h>
+#include <gpu/texture/format.h>
+#include <soc/gm20b/channel.h>
+#include "maxwell_dma.h"
+
+namespace skyline::soc::gm20b::engine {
+    #define MAXWELL_DMA_OFFSET(field) U32_OFFSET(Registers, field)
+
+    MaxwellDma::MaxwellDma(const DeviceState &state, ChannelContext &channelCtx) : Engine(state), channelCtx(channelCtx) {}
+
+    MaxwellDma::CopySide MaxwellDma::GetSourceSide() {
+        auto &remap{registers.remapComponents};
+        return CopySide{
+            .address = registers.offsetIn.Pack(),
+            .layout = registers.launchDma.srcMemoryLayout,
+            .bytesPerPixel = registers.launchDma.remapEnable ? (remap.componentSizeMinusOne + 1U) * (remap.numSrcComponentsMinusOne + 1U) : 1U,
+            .pitch = registers.pitchIn,
+            .surface = registers.srcSurface,
+        };
+    }
+
+    MaxwellDma::CopySide MaxwellDma::GetDestinationSide() {
+        auto &remap{registers.remapComponents};
+        return CopySide{
+            .address = registers.offsetOut.Pack(),
+            .layout = registers.launchDma.dstMemoryLayout,
+            .bytesPerPixel = registers.launchDma.remapEnable ? (remap.componentSizeMinusOne + 1U) * (remap.numDstComponentsMinusOne + 1U) : 1U,
+            .pitch = registers.pitchOut,
+            .surface = registers.dstSurface,
+        };
+    }
+
+    gpu::GuestTexture MaxwellDma::GetSurfaceTexture(const CopySide &side) {
+        // The surface is treated as a texture with a single byte format, this retains the layout while allowing arbitrary pixel sizes
+        return gpu::GuestTexture(gpu::GuestTexture::Mappings{}, gpu::texture::Dimensions(side.surface.width * side.bytesPerPixel, side.surface.height, 1), gpu::format::R8Uint, gpu::texture::TileConfig{
+            .mode = gpu::texture::TileMode::Block,
+            .blockHeight = static_cast<u8>(1U << side.surface.blockSize.heightLog2),
+            .blockDepth = static_cast<u8>(1U << side.surface.blockSize.depthLog2),
+        }, gpu::texture::TextureType::e2D);
+    }
+
+    u32 MaxwellDma::ReadSurface(const CopySide &side, gpu::GuestTexture &guest) {
+        gpu::detail::BlockLinearLayout layout{guest};
+        size_t surfaceSize{static_cast<size_t>(layout.robBytes) * layout.surfaceHeightRobs};
+        if (side.surface.depth > 1 && side.surface.blockSize.depthLog2)
+            Logger::Warn("Blocklinear DMA surfaces with a block depth of {} GOBs are copied as 2D layers", 1U << side.surface.blockSize.depthLog2);
+
+        surfaceBuffer.resize(surfaceSize);
+        linearBuffer.resize(surfaceSize);
+        channelCtx.asCtx->gmmu.Read(span(surfaceBuffer), side.address + (surfaceSize * side.surface.layer));
+        gpu::CopyBlockLinearToLinear(guest, surfaceBuffer.data(), linearBuffer.data(), &state.gpu->copyPool);
+        return layout.robWidthBytes;
+    }
+
+    bool MaxwellDma::RecordBufferCopy(span<u8> source, span<u8> destination) {
+        auto sourceView{state.gpu->buffer.Lookup(source)};
+        if (!sourceView)
+            return false;
+        auto destinationView{state.gpu->buffer.Lookup(destination)};
+        if (!destinationView)
+            return false;
+
+        // Copies between overlapping regions of the same buffer are invalid in Vulkan, these are left to the upload of the pages dirtied by the guest copy
+        if (sourceView->buffer == destinationView->buffer && sourceView->offset < destinationView->offset + destinationView->size && destinationView->offset < sourceView->offset + sourceView->size)
+            return false;
+
+        channelCtx.executor.AttachBuffer(sourceView->buffer.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+        channelCtx.executor.AttachBuffer(destinationView->buffer.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        channelCtx.executor.AddOutsideRpCommand([source = *sourceView, destination = *destinationView](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, gpu::GPU &) {
+            destination.buffer->RecordCopy(commandBuffer, cycle, source, destination.offset);
+        });
+        return true;
+    }
+
+    bool MaxwellDma::RecordTextureCopy(const CopySide &source, const CopySide &destination, u32 lineBytes, u32 lineCount) {
+        if (source.layout != MemoryLayout::BlockLinear || destination.layout != MemoryLayout::BlockLinear)
+            return false;
+
+        auto lookupTexture{[&](const CopySide &side) -> std::shared_ptr<gpu::Texture> {
+            if (side.surface.origin.x || side.surface.origin.y || side.surface.layer)
+                return nullptr;
+
+            auto phys{channelCtx.gmmuTlb.Translate(side.address, 1)};
+            if (!phys)
+                return nullptr;
+
+            auto texture{state.gpu->texture.Lookup(phys)};
+            if (!texture)
+                return nullptr;
+
+            // The copy must cover the entirety of the texture with the same layout for it to be equivalent to an image copy
+            auto &guest{*texture->guest};
+            if (guest.tileConfig.mode != gpu::texture::TileMode::Block || guest.tileConfig.blockHeight != (1U << side.surface.blockSize.heightLog2) || guest.dimensions.depth != 1 || guest.layerCount != 1)
+                return nullptr;
+            if (guest.format->GetSize(guest.dimensions.width, 1) != lineBytes || guest.dimensions.height / guest.format->blockHeight != lineCount)
+                return nullptr;
+
+            return texture;
+        }};
+
+        auto sourceTexture{lookupTexture(source)};
+        if (!sourceTexture)
+            return false;
+        auto destinationTexture{lookupTexture(destination)};
+        if (!destinationTexture || destinationTexture == sourceTexture)
+            return false;
+
+        if (sourceTexture->format != destinationTexture->format || sourceTexture->dimensions != destinationTexture->dimensions || sourceTexture->mipLevels != destinationTexture->mipLevels)
+            return false;
+
+        channelCtx.executor.AttachTexture(sourceTexture.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+        channelCtx.executor.AttachTexture(destinationTexture.get(), vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+        channelCtx.executor.AddOutsideRpCommand([source = std::move(sourceTexture), destination = std::move(destinationTexture)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, gpu::GPU &) {
+            destination->RecordCopyFrom(commandBuffer, source, vk::ImageSubresourceRange{
+                .aspectMask = destination->format->vkAspect,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            });
+            cycle->AttachObjects(source, destination);
+            source->cycle = cycle;
+            destination->cycle = cycle;
+        });
+        return true;
+    }
+
+    void MaxwellDma::ReadLines(const CopySide &side, u32 lineBytes, u32 lineCount) {
+        copyBuffer.resize(static_cast<size_t>(lineBytes) * lineCount);
+        auto &gmmu{channelCtx.asCtx->gmmu};
+
+        if (side.layout == MemoryLayout::Pitch) {
+            if (lineCount == 1 || side.pitch == lineBytes) {
+                gmmu.Read(span(copyBuffer), side.address);
+            } else {
+                for (u32 line{}; line < lineCount; line++)
+                    gmmu.Read(copyBuffer.data() + (static_cast<size_t>(line) * lineBytes), side.address + (static_cast<u64>(line) * side.pitch), lineBytes);
+            }
+            return;
+        }
+
+        auto guest{GetSurfaceTexture(side)};
+        u32 pitch{ReadSurface(side, guest)};
+        size_t offsetX{static_cast<size_t>(side.surface.origin.x) * side.bytesPerPixel};
+        if (offsetX + lineBytes > pitch || static_cast<size_t>(side.surface.origin.y + lineCount) * pitch > linearBuffer.size()) [[unlikely]] {
+            Logger::Warn("DMA source is out of bounds of its surface: ({}, {}) + {}x{} bytes", offsetX, side.surface.origin.y, lineBytes, lineCount);
+            std::fill(copyBuffer.begin(), copyBuffer.end(), 0);
+            return;
+        }
+
+        for (u32 line{}; line < lineCount; line++)
+            std::memcpy(copyBuffer.data() + (static_cast<size_t>(line) * lineBytes), linearBuffer.data() + (static_cast<size_t>(side.surface.origin.y + line) * pitch) + offsetX, lineBytes);
+    }
+
+    void MaxwellDma::WriteLines(const CopySide &side, u32 lineBytes, u32 lineCount) {
+        auto &gmmu{channelCtx.asCtx->gmmu};
+
+        if (side.layout == MemoryLayout::Pitch) {
+            if (lineCount == 1 || side.pitch == lineBytes) {
+                gmmu.Write(side.address, span(copyBuffer));
+            } else {
+                for (u32 line{}; line < lineCount; line++)
+                    gmmu.Write(side.address + (static_cast<u64>(line) * side.pitch), copyBuffer.data() + (static_cast<size_t>(line) * lineBytes), lineBytes);
+            }
+            return;
+        }
+
+        // The copy is done on a deswizzled copy of the entire surface as the lines may only partially cover GOBs
+        auto guest{GetSurfaceTexture(side)};
+        u32 pitch{ReadSurface(side, guest)};
+        size_t offsetX{static_cast<size_t>(side.surface.origin.x) * side.bytesPerPixel};
+        if (offsetX + lineBytes > pitch || static_cast<size_t>(side.surface.origin.y + lineCount) * pitch > linearBuffer.size()) [[unlikely]] {
+            Logger::Warn("DMA destination is out of bounds of its surface: ({}, {}) + {}x{} bytes", offsetX, side.surface.origin.y, lineBytes, lineCount);
+            return;
+        }
+
+        for (u32 line{}; line < lineCount; line++)
+            std::memcpy(linearBuffer.data() + (static_cast<size_t>(side.surface.origin.y + line) * pitch) + offsetX, copyBuffer.data() + (static_cast<size_t>(line) * lineBytes), lineBytes);
+
+        gpu::CopyLinearToBlockLinear(guest, linearBuffer.data(), surfaceBuffer.data(), &state.gpu->copyPool);
+        gmmu.Write(side.address + (surfaceBuffer.size() * side.surface.layer), span(surfaceBuffer));
+    }
+
+    void MaxwellDma::RemapLines(u32 srcBytesPerPixel, u32 dstBytesPerPixel, size_t pixelCount) {
+        auto &remap{registers.remapComponents};
+        u32 componentSize{remap.componentSizeMinusOne + 1U}, srcComponents{remap.numSrcComponentsMinusOne + 1U}, dstComponents{remap.numDstComponentsMinusOne + 1U};
+
+        remapBuffer.resize(pixelCount * dstBytesPerPixel);
+        for (size_t pixel{}; pixel < pixelCount; pixel++) {
+            auto input{copyBuffer.data() + (pixel * srcBytesPerPixel)};
+            auto output{remapBuffer.data() + (pixel * dstBytesPerPixel)};
+            for (u32 component{}; component < dstComponents; component++, output += componentSize) {
+                auto swizzle{remap.GetSwizzle(component)};
+                switch (swizzle) {
+                    case Registers::RemapSwizzle::SrcX:
+                    case Registers::RemapSwizzle::SrcY:
+                    case Registers::RemapSwizzle::SrcZ:
+                    case Registers::RemapSwizzle::SrcW: {
+                        auto srcComponent{static_cast<u32>(swizzle)};
+                        if (srcComponent < srcComponents)
+                            std::memcpy(output, input + (srcComponent * componentSize), componentSize);
+                        else
+                            std::memset(output, 0, componentSize);
+                        break;
+                    }
+
+                    case Registers::RemapSwizzle::ConstA:
+                    case Registers::RemapSwizzle::ConstB:
+                        std::memcpy(output, &registers.remapConsts[static_cast<u32>(swizzle) - static_cast<u32>(Registers::RemapSwizzle::ConstA)], componentSize);
+                        break;
+
+                    default:
+                        // Components which aren't written would require reading back the destination, these are rare enough that they're zeroed instead
+                        std::memset(output, 0, componentSize);
+                        break;
+                }
+            }
+        }
+
+        std::swap(copyBuffer, remapBuffer);
+    }
+
+    void MaxwellDma::LaunchDma() {
+        TRACE_EVENT("gpu", "MaxwellDma::LaunchDma");
+
+        auto launch{registers.launchDma};
+        auto source{GetSourceSide()}, destination{GetDestinationSide()};
+        u32 lineCount{launch.multiLineEnable ? registers.lineCount : 1U};
+        u32 srcLineBytes{registers.lineLengthIn * source.bytesPerPixel}, dstLineBytes{registers.lineLengthIn * destination.bytesPerPixel};
+
+        bool identityRemap{true}, readsSource{!launch.remapEnable};
+        if (launch.remapEnable) {
+            auto &remap{registers.remapComponents};
+            identityRemap = remap.numSrcComponentsMinusOne == remap.numDstComponentsMinusOne;
+            for (u32 component{}; component <= remap.numDstComponentsMinusOne; component++) {
+                auto swizzle{remap.GetSwizzle(component)};
+                identityRemap &= static_cast<u32>(swizzle) == component;
+                readsSource |= swizzle <= Registers::RemapSwizzle::SrcW;
+            }
+        }
+
+        if (launch.dataTransferType && srcLineBytes && lineCount) {
+            if (identityRemap && source.layout == MemoryLayout::Pitch && destination.layout == MemoryLayout::Pitch && (lineCount == 1 || (source.pitch == srcLineBytes && destination.pitch == srcLineBytes))) {
+                // Contiguous copies are the common case of buffer copies, they can be done on the host GPU when both sides are backed by host buffers
+                size_t size{static_cast<size_t>(srcLineBytes) * lineCount};
+                auto &gmmu{channelCtx.asCtx->gmmu};
+                auto sourceMappings{gmmu.TranslateRange(source.address, size)}, destinationMappings{gmmu.TranslateRange(destination.address, size)};
+                if (sourceMappings.size() == 1 && destinationMappings.size() == 1) {
+                    // The guest is always written as host buffers aren't synchronized back to it, the recorded copy only orders the write relative to other host work
+                    std::memmove(destinationMappings.front().data(), sourceMappings.front().data(), size);
+                    RecordBufferCopy(sourceMappings.front(), destinationMappings.front());
+                    ReleaseSemaphore();
+                    return;
+                }
+            }
+
+            if (!identityRemap || !RecordTextureCopy(source, destination, srcLineBytes, lineCount)) {
+                // Textures written by prior submissions only trap CPU accesses to their guest memory once they've been recorded
+                channelCtx.executor.WaitRecorded();
+
+                if (readsSource)
+                    ReadLines(source, srcLineBytes, lineCount);
+                else
+                    copyBuffer.resize(static_cast<size_t>(srcLineBytes) * lineCount); // Copies which only write constants don't need the contents of the source
+
+                if (!identityRemap)
+                    RemapLines(source.bytesPerPixel, destination.bytesPerPixel, static_cast<size_t>(registers.lineLengthIn) * lineCount);
+
+                WriteLines(destination, dstLineBytes, lineCount);
+            }
+        }
+
+        ReleaseSemaphore();
+    }
+
+    void MaxwellDma::ReleaseSemaphore() {
+        switch (registers.launchDma.semaphoreType) {
+            case Registers::SemaphoreType::None:
+                break;
+
+            case Registers::SemaphoreType::ReleaseOneWord:
+            case Registers::SemaphoreType::ReleaseFourWord: {
+                bool fourWords{registers.launchDma.semaphoreType == Registers::SemaphoreType::ReleaseFourWord};
+                if (auto address{channelCtx.gmmuTlb.Translate(registers.semaphore.address.Pack(), fourWords ? sizeof(u64) * 2 : sizeof(u32))}) [[likely]] {
+                    // The release is deferred till any copies performed on the host GPU prior to it have completed
+                    channelCtx.executor.ReleaseSemaphore(address, registers.semaphore.payload, fourWords);
+                    break;
+                }
+
+                Logger::Warn("DMA semaphore at 0x{:X} isn't contained in a single page, releasing it immediately", registers.semaphore.address.Pack());
+                if (fourWords) {
+                    struct FourWordResult {
+                        u32 payload;
+                        u32 _pad_;
+                        u64 timestamp;
+                    };
+                    channelCtx.gmmuTlb.Write<FourWordResult>(registers.semaphore.address.Pack(), FourWordResult{registers.semaphore.payload, 0, util::GetGpuTimeTicks()});
+                } else {
+                    channelCtx.gmmuTlb.Write<u32>(registers.semaphore.address.Pack(), registers.semaphore.payload);
+                }
+                break;
+            }
+
+            default:
+                Logger::Warn("Unsupported DMA semaphore type: 0x{:X}", static_cast<u8>(registers.launchDma.semaphoreType));
+                break;
+        }
+    }
+
+    void MaxwellDma::CallMethod(u32 method, u32 argument, bool lastCall) {
+        CallMethodBatch(method, span<u32>(&argument, 1), true, lastCall);
+    }
+
+    void MaxwellDma::CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall) {
+        Logger::Debug("Called method batch in Maxwell DMA: 0x{:X} count: {} increment: {}", method, arguments.size(), increment);
+
+        if (method + (increment ? arguments.size() : 1) > RegisterCount) [[unlikely]] {
+            Logger::Warn("Out of bounds Maxwell DMA method batch called: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        constexpr u32 LaunchDmaMethod{MAXWELL_DMA_OFFSET(launchDma)};
+        if (!increment) {
+            if (method == LaunchDmaMethod) {
+                for (u32 argument : arguments) {
+                    registers.raw[method] = argument;
+                    LaunchDma();
+                }
+            } else {
+                registers.raw[method] = arguments.back();
+            }
+            return;
+        }
+
+        // Registers written after LaunchDma in the same run apply to the next copy, so the copy must be launched before they're written
+        if (method <= LaunchDmaMethod && LaunchDmaMethod < method + arguments.size()) {
+            auto launchIndex{LaunchDmaMethod - method + 1};
+            span(registers.raw).subspan(method).copy_from(arguments.first(launchIndex));
+            LaunchDma();
+            arguments = arguments.subspan(launchIndex);
+            method = LaunchDmaMethod + 1;
+        }
+
+        span(registers.raw).subspan(method).copy_from(arguments);
+    }
+
+    #undef MAXWELL_DMA_OFFSET
+}
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/texture/texture.h>
+#include "engine.h"
+
+namespace skyline::soc::gm20b {
+    struct ChannelContext;
+}
+
+namespace skyline::soc::gm20b::engine {
+    /**
+     * @brief The Maxwell DMA engine handles copies between pitch-linear and blocklinear memory, they're done on the host GPU when both sides are backed by host resources and on the CPU otherwise
+     * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/classes/dma-copy/clb0b5.h
+     */
+    class MaxwellDma : public Engine {
+      public:
+        static constexpr u32 RegisterCount{0x200}; //!< The number of Maxwell DMA registers
+
+      private:
+        #pragma pack(push, 1)
+        union Registers {
+            std::array<u32, RegisterCount> raw;
+
+            struct Address {
+                u32 high;
+                u32 low;
+
+                u64 Pack() const {
+                    return (static_cast<u64>(high) << 32) | low;
+                }
+            };
+            static_assert(sizeof(Address) == sizeof(u64));
+
+            enum class SemaphoreType : u8 {
+                None = 0,
+                ReleaseOneWord = 1,
+                ReleaseFourWord = 2,
+            };
+
+            enum class MemoryLayout : u8 {
+                BlockLinear = 0,
+                Pitch = 1,
+            };
+
+            /**
+             * @brief The source of a single destination component during a remapped copy
+             */
+            enum class RemapSwizzle : u8 {
+                SrcX = 0,
+                SrcY = 1,
+                SrcZ = 2,
+                SrcW = 3,
+                ConstA = 4,
+                ConstB = 5,
+                NoWrite = 6,
+            };
+
+            struct LaunchDma {
+                u8 dataTransferType : 2;
+                bool flushEnable : 1;
+                SemaphoreType semaphoreType : 2;
+                u8 interruptType : 2;
+                MemoryLayout srcMemoryLayout : 1;
+                MemoryLayout dstMemoryLayout : 1;
+                bool multiLineEnable : 1; //!< If the copy is 2D with `lineCount` lines rather than a single line
+                bool remapEnable : 1; //!< If the copy is done in units of remapped components rather than bytes
+                u32 _pad_ : 21;
+            };
+            static_assert(sizeof(LaunchDma) == sizeof(u32));
+
+            struct RemapComponents {
+                RemapSwizzle dstX : 3;
+                u8 _pad0_ : 1;
+                RemapSwizzle dstY : 3;
+                u8 _pad1_ : 1;
+                RemapSwizzle dstZ : 3;
+                u8 _pad2_ : 1;
+                RemapSwizzle dstW : 3;
+                u8 _pad3_ : 1;
+                u8 componentSizeMinusOne : 2;
+                u8 _pad4_ : 2;
+                u8 numSrcComponentsMinusOne : 2;
+                u8 _pad5_ : 2;
+                u8 numDstComponentsMinusOne : 2;
+                u8 _pad6_ : 6;
+
+                RemapSwizzle GetSwizzle(size_t component) const {
+                    std::array<RemapSwizzle, 4> swizzles{dstX, dstY, dstZ, dstW};
+                    return swizzles[component];
+                }
+            };
+            static_assert(sizeof(RemapComponents) == sizeof(u32));
+
+            /**
+             * @brief The layout of a blocklinear surface, the dimensions are in units of remapped pixels when remapping is enabled and bytes otherwise
+             */
+            struct Surface {
+                struct {
+                    u8 widthLog2 : 4; //!< The width of a block in GOBs, this is always a single GOB on the Tegra X1
+                    u8 heightLog2 : 4; //!< The height of a block in GOBs
+                    u8 depthLog2 : 4; //!< The depth of a block in GOBs
+                    u8 gobHeight : 4;
+                    u16 _pad_;
+                } blockSize;
+                u32 width;
+                u32 height;
+                u32 depth;
+                u32 layer;
+                struct {
+                    u16 x;
+                    u16 y;
+                } origin;
+            };
+            static_assert(sizeof(Surface) == (sizeof(u32) * 6));
+
+            struct {
+                u32 _pad0_[0x90]; // 0x0
+
+                struct {
+                    Address address; // 0x90
+                    u32 payload; // 0x92
+                } semaphore;
+
+                u32 _pad1_[0x2D]; // 0x93
+
+                LaunchDma launchDma; // 0xC0
+
+                u32 _pad2_[0x3F]; // 0xC1
+
+                Address offsetIn; // 0x100
+                Address offsetOut; // 0x102
+                u32 pitchIn; // 0x104
+                u32 pitchOut; // 0x105
+                u32 lineLengthIn; // 0x106
+                u32 lineCount; // 0x107
+
+                u32 _pad3_[0xB8]; // 0x108
+
+                std::array<u32, 2> remapConsts; // 0x1C0
+                RemapComponents remapComponents; // 0x1C2
+                Surface dstSurface; // 0x1C3
+                u32 _pad4_; // 0x1C9
+                Surface srcSurface; // 0x1CA
+            };
+        } registers{};
+        static_assert(sizeof(Registers) == (RegisterCount * sizeof(u32)));
+        #pragma pack(pop)
+
+        ChannelContext &channelCtx;
+        std::vector<u8> copyBuffer; //!< A packed linear copy of the lines being transferred by a CPU copy
+        std::vector<u8> surfaceBuffer; //!< A scratch buffer for the entirety of an accessed blocklinear surface
+        std::vector<u8> linearBuffer; //!< A scratch buffer for a blocklinear surface after being deswizzled
+        std::vector<u8> remapBuffer; //!< A scratch buffer for the packed lines after their components have been remapped
+
+        /**
+         * @brief The layout of one side of a copy in bytes
+         */
+        struct CopySide {
+            u64 address;
+            MemoryLayout layout;
+            u32 bytesPerPixel; //!< The size of a remapped pixel, this is 1 when remapping is disabled
+            u32 pitch; //!< The pitch of pitch-linear memory in bytes
+            Surface surface; //!< The surface of blocklinear memory
+        };
+
+        CopySide GetSourceSide();
+
+        CopySide GetDestinationSide();
+
+        /**
+         * @return A guest texture describing the blocklinear surface of one side of a copy in bytes, this allows the texture swizzling functions to be used on it
+         */
+        static gpu::GuestTexture GetSurfaceTexture(const CopySide &side);
+
+        /**
+         * @brief Reads the layer of the blocklinear surface of one side of a copy into `surfaceBuffer` and deswizzles it into `linearBuffer`
+         * @return The pitch of the lines in `linearBuffer`
+         */
+        u32 ReadSurface(const CopySide &side, gpu::GuestTexture &guest);
+
+        /**
+         * @brief Records a copy between two host buffers if both sides of a 1D copy are backed by them
+         * @return If the copy was recorded, the guest copy still has to be done by the caller
+         * @note The guest memory is expected to already contain the result of the copy when the recorded copy is executed
+         */
+        bool RecordBufferCopy(span<u8> source, span<u8> destination);
+
+        /**
+         * @brief Records a copy between two host textures if both sides of the copy cover the entirety of one
+         * @return If the copy was recorded, the guest copy must not be done by the caller as the destination is synchronized from the host
+         */
+        bool RecordTextureCopy(const CopySide &source, const CopySide &destination, u32 lineBytes, u32 lineCount);
+
+        /**
+         * @brief Reads the lines of one side of a copy into `copyBuffer`, they're tightly packed afterwards
+         */
+        void ReadLines(const CopySide &side, u32 lineBytes, u32 lineCount);
+
+        /**
+         * @brief Writes the tightly packed lines in `copyBuffer` to one side of a copy
+         */
+        void WriteLines(const CopySide &side, u32 lineBytes, u32 lineCount);
+
+        /**
+         * @brief Applies the remapping of components to the packed lines in `copyBuffer`
+         */
+        void RemapLines(u32 srcBytesPerPixel, u32 dstBytesPerPixel, size_t pixelCount);
+
+        /**
+         * @brief Performs the copy that was configured in the registers alongside any semaphore release
+         */
+        void LaunchDma();
+
+        void ReleaseSemaphore();
+
+      public:
+        MaxwellDma(const DeviceState &state, ChannelContext &channelCtx);
+
+        void CallMethod(u32 method, u32 argument, bool lastCall);
+
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment, bool lastCall);
+    };
+}
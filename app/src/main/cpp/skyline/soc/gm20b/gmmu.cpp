@@ -6,5 +6,5 @@
 
 namespace skyline {
     template class FlatAddressSpaceMap<u64, 0, u8 *, nullptr, true, soc::gm20b::GmmuAddressSpaceBits>;
-    template class FlatMemoryManager<u64, 0, soc::gm20b::GmmuAddressSpaceBits>;
+    template class FlatMemoryManager<u64, 0, soc::gm20b::GmmuAddressSpaceBits, soc::gm20b::GmmuPageTableBits>;
 }
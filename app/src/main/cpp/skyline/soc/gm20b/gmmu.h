@@ -7,15 +7,117 @@
 
 namespace skyline::soc::gm20b {
     static constexpr u8 GmmuAddressSpaceBits{40}; //!< The size of the GMMU AS in bits
+    static constexpr u8 GmmuPageTableBits{12}; //!< The size of the pages in the GMMU page table in bits, this matches the small page size of the GMMU which is the granularity that mappings can be made at
 
     /**
      * @brief The GMMU (Graphics Memory Management Unit) class handles mapping between a Maxwell GPU virtual address space and an application's address space and is meant to roughly emulate the GMMU on the X1
      * @note This is not accurate to the X1 as it would have an SMMU between the GMMU and physical memory but we don't need to emulate this abstraction
-     * @note The GMMU is implemented entirely as a template specialization over FlatMemoryManager
+     * @note The GMMU is implemented entirely as a template specialization over FlatMemoryManager, with a page table for translating the small accesses done by pushbuffer and semaphore handling
      */
-    using GMMU = FlatMemoryManager<u64, 0, GmmuAddressSpaceBits>;
+    using GMMU = FlatMemoryManager<u64, 0, GmmuAddressSpaceBits, GmmuPageTableBits>;
 
     struct AddressSpaceContext {
         GMMU gmmu;
     };
+
+    /**
+     * @brief A small direct-mapped cache of GMMU page translations, this avoids locking the GMMU for the repeated small accesses to the same pages which pushbuffer processing and engines do
+     * @note The cache is flushed entirely whenever the generation of the GMMU changes, this happens on any change to its mappings
+     * @note This isn't thread-safe and is only meant to be used by the thread processing the GPFIFO of a single channel
+     */
+    class GmmuTlb {
+      private:
+        static constexpr size_t EntryCount{64};
+
+        struct Entry {
+            u64 page{std::numeric_limits<u64>::max()}; //!< The page number of the entry, this is an unreachable page number for invalid entries
+            u8 *phys{}; //!< A host pointer to the start of the page
+        };
+
+        GMMU &gmmu;
+        std::array<Entry, EntryCount> entries{};
+        u32 generation{}; //!< The generation of the GMMU that the entries were filled at
+
+        /**
+         * @brief Flushes all entries if the mappings of the GMMU have changed since they were filled
+         */
+        void Revalidate() {
+            u32 currentGeneration{gmmu.generation.load(std::memory_order_acquire)};
+            if (currentGeneration != generation) [[unlikely]] {
+                entries.fill({});
+                generation = currentGeneration;
+            }
+        }
+
+        /**
+         * @return A host pointer to the start of the supplied page if it's regularly mapped, otherwise nullptr
+         */
+        u8 *TranslatePage(u64 page) {
+            auto &entry{entries[page % EntryCount]};
+            if (entry.page != page) [[unlikely]] {
+                auto phys{gmmu.TranslatePage(page << GmmuPageTableBits)};
+                if (!phys)
+                    return nullptr;
+                entry = {page, phys};
+            }
+            return entry.phys;
+        }
+
+      public:
+        GmmuTlb(GMMU &gmmu) : gmmu(gmmu) {}
+
+        /**
+         * @return A host pointer to the supplied range if it's contained within a single regularly mapped page, otherwise nullptr
+         */
+        u8 *Translate(u64 virt, u64 size) {
+            if ((virt & (GMMU::PageSize - 1)) + size > GMMU::PageSize) [[unlikely]]
+                return nullptr;
+
+            Revalidate();
+            auto phys{TranslatePage(virt >> GmmuPageTableBits)};
+            return phys ? phys + (virt & (GMMU::PageSize - 1)) : nullptr;
+        }
+
+        /**
+         * @return A host pointer to the supplied range if all pages it covers are regularly mapped and consecutive in host memory, otherwise nullptr
+         * @note Ranges covering more pages than the TLB has entries return nullptr as they would evict each other, the cost of translating them through the GMMU is amortized over their size
+         */
+        u8 *TranslateContiguous(u64 virt, u64 size) {
+            if (size == 0) [[unlikely]]
+                return nullptr;
+
+            u64 firstPage{virt >> GmmuPageTableBits}, lastPage{(virt + size - 1) >> GmmuPageTableBits};
+            if (lastPage - firstPage >= EntryCount) [[unlikely]]
+                return nullptr;
+
+            Revalidate();
+            auto phys{TranslatePage(firstPage)};
+            if (!phys)
+                return nullptr;
+
+            for (u64 page{firstPage + 1}; page <= lastPage; page++)
+                if (TranslatePage(page) != phys + ((page - firstPage) << GmmuPageTableBits))
+                    return nullptr;
+
+            return phys + (virt & (GMMU::PageSize - 1));
+        }
+
+        template<typename T>
+        T Read(u64 virt) {
+            if (auto phys{Translate(virt, sizeof(T))}) [[likely]] {
+                T obj;
+                std::memcpy(&obj, phys, sizeof(T));
+                return obj;
+            }
+            return gmmu.Read<T>(virt);
+        }
+
+        template<typename T>
+        void Write(u64 virt, T source) {
+            if (auto phys{Translate(virt, sizeof(T))}) [[likely]]
+                std::memcpy(phys, &source, sizeof(T));
+            else
+                gmmu.Write<T>(virt, source);
+        }
+    };
 }
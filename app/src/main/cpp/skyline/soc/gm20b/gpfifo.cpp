@@ -2,9 +2,11 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <common/signal.h>
+#include <common/performance_counters.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
 #include <soc.h>
+#include <gpu.h>
 #include <os.h>
 #include "engines/maxwell_3d.h"
 
@@ -59,21 +61,32 @@ namespace skyline::soc::gm20b {
     };
     static_assert(sizeof(PushBufferMethodHeader) == sizeof(u32));
 
+    static std::atomic<u32> CaptureIndex{}; //!< The index of the next channel to be captured, every channel is captured into a separate file
+
     ChannelGpfifo::ChannelGpfifo(const DeviceState &state, ChannelContext &channelCtx, size_t numEntries) :
         state(state),
         gpfifoEngine(state, channelCtx),
         channelCtx(channelCtx),
         gpEntries(numEntries),
-        thread(std::thread(&ChannelGpfifo::Run, this)) {}
+        statistics(state.settings->methodStatistics ? std::make_unique<MethodStatistics>() : nullptr),
+        capture(state.settings->gpfifoCapture ? std::make_unique<GpfifoCapture>(util::Format("{}gpfifo_capture_{}.skgc", state.os->appFilesPath, CaptureIndex++)) : nullptr) {}
 
-    void ChannelGpfifo::Send(u32 method, u32 argument, u32 subChannel, bool lastCall) {
+    namespace {
         constexpr u32 ThreeDSubChannel{0};
         constexpr u32 ComputeSubChannel{1};
         constexpr u32 Inline2MemorySubChannel{2};
         constexpr u32 TwoDSubChannel{3};
         constexpr u32 CopySubChannel{4}; // HW forces a memory flush on a switch from this subchannel to others
+    }
 
+    MethodStatistics::Engine ChannelGpfifo::GetStatisticsEngine(u32 method, u32 subChannel) {
+        // Subchannels are bound to engines in the same order as the statistics engines
+        return method < engine::GPFIFO::RegisterCount || subChannel > CopySubChannel ? MethodStatistics::Engine::Gpfifo : static_cast<MethodStatistics::Engine>(subChannel);
+    }
+
+    void ChannelGpfifo::Send(u32 method, u32 argument, u32 subChannel, bool lastCall) {
         Logger::Debug("Called GPU method - method: 0x{:X} argument: 0x{:X} subchannel: 0x{:X} last: {}", method, argument, subChannel, lastCall);
+        MethodStatistics::Scope statisticsScope{statistics.get(), GetStatisticsEngine(method, subChannel), method, 1};
 
         if (method < engine::GPFIFO::RegisterCount) {
             gpfifoEngine.CallMethod(method, argument, lastCall);
@@ -100,8 +113,48 @@ namespace skyline::soc::gm20b {
         }
     }
 
+    void ChannelGpfifo::SendBatch(u32 method, span<u32> arguments, u32 subChannel, bool increment, bool lastCall) {
+        Logger::Debug("Called GPU method batch - method: 0x{:X} count: {} subchannel: 0x{:X} increment: {} last: {}", method, arguments.size(), subChannel, increment, lastCall);
+
+        if (method < engine::GPFIFO::RegisterCount) {
+            if (increment && method + arguments.size() > engine::GPFIFO::RegisterCount) [[unlikely]] {
+                // An incrementing run which crosses from the GPFIFO registers into the engine registers needs to be split up per-argument
+                for (u32 index{}; index < arguments.size(); index++)
+                    Send(method + index, arguments[index], subChannel, lastCall && index == arguments.size() - 1);
+                return;
+            }
+
+            MethodStatistics::Scope statisticsScope{statistics.get(), MethodStatistics::Engine::Gpfifo, method, static_cast<u32>(arguments.size())};
+            gpfifoEngine.CallMethodBatch(method, arguments, increment, lastCall);
+        } else {
+            MethodStatistics::Scope statisticsScope{statistics.get(), GetStatisticsEngine(method, subChannel), method, static_cast<u32>(arguments.size())};
+            switch (subChannel) {
+                case ThreeDSubChannel:
+                    channelCtx.maxwell3D->CallMethodBatch(method, arguments, increment, lastCall);
+                    break;
+                case ComputeSubChannel:
+                    channelCtx.maxwellCompute.CallMethodBatch(method, arguments, increment, lastCall);
+                    break;
+                case Inline2MemorySubChannel:
+                    channelCtx.keplerMemory.CallMethodBatch(method, arguments, increment, lastCall);
+                    break;
+                case TwoDSubChannel:
+                    channelCtx.fermi2D.CallMethodBatch(method, arguments, increment, lastCall);
+                    break;
+                case CopySubChannel:
+                    channelCtx.maxwellDma.CallMethodBatch(method, arguments, increment, lastCall);
+                    break;
+                default:
+                    throw exception("Tried to call into a software subchannel: {}!", subChannel);
+            }
+        }
+    }
+
     void ChannelGpfifo::Process(GpEntry gpEntry) {
         if (!gpEntry.size) {
+            if (capture) [[unlikely]]
+                capture->WriteEntry(gpEntry, {});
+
             // This is a GPFIFO control entry, all control entries have a zero length and contain no pushbuffers
             switch (gpEntry.opcode) {
                 case GpEntry::Opcode::Nop:
@@ -112,32 +165,49 @@ namespace skyline::soc::gm20b {
             }
         }
 
-        pushBufferData.resize(gpEntry.size);
-        channelCtx.asCtx->gmmu.Read<u32>(pushBufferData, gpEntry.Address());
+        auto pushBuffer{[&]() -> span<u32> {
+            // Pushbuffers (especially nvmap-backed ones) are almost always contiguous in host memory, in which case we can read straight from the mapping after resolving its pages through the TLB without locking the GMMU or allocating
+            if (auto phys{channelCtx.gmmuTlb.TranslateContiguous(gpEntry.Address(), gpEntry.size * sizeof(u32))}; phys && util::IsWordAligned(phys))
+                return span(reinterpret_cast<u32 *>(phys), gpEntry.size);
+
+            // Larger pushbuffers or ones with pages that are partially mapped may still be covered by a single mapping
+            auto mappings{channelCtx.asCtx->gmmu.TranslateRange(gpEntry.Address(), gpEntry.size * sizeof(u32))};
+            if (mappings.size() == 1 && mappings.front().data() && util::IsWordAligned(mappings.front().data()))
+                return mappings.front().cast<u32>();
+
+            // The GpEntry straddles multiple mappings, we need to copy it into a contiguous buffer
+            pushBufferData.resize(gpEntry.size);
+            channelCtx.asCtx->gmmu.Read<u32>(pushBufferData, gpEntry.Address());
+            return pushBufferData;
+        }()};
+
+        if (capture) [[unlikely]]
+            capture->WriteEntry(gpEntry, pushBuffer);
 
         // There will be at least one entry here
-        auto entry{pushBufferData.begin()};
+        auto entry{pushBuffer.begin()};
 
         // Executes the current split method, returning once execution is finished or the current GpEntry has reached its end
         auto resumeSplitMethod{[&](){
-            switch (resumeState.state) {
-                case MethodResumeState::State::Inc:
-                    while (entry != pushBufferData.end() && resumeState.remaining)
-                        Send(resumeState.address++, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
+            if (resumeState.state == MethodResumeState::State::OneInc && entry != pushBuffer.end()) {
+                Send(resumeState.address++, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
 
-                    break;
-                case MethodResumeState::State::OneInc:
-                    Send(resumeState.address++, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
+                // After the first increment OneInc methods work the same as a NonInc method, this is needed so they can resume correctly if they are broken up by multiple GpEntries
+                resumeState.state = MethodResumeState::State::NonInc;
+            }
 
-                    // After the first increment OneInc methods work the same as a NonInc method, this is needed so they can resume correctly if they are broken up by multiple GpEntries
-                    resumeState.state = MethodResumeState::State::NonInc;
-                    [[fallthrough]];
-                case MethodResumeState::State::NonInc:
-                    while (entry != pushBufferData.end() && resumeState.remaining)
-                        Send(resumeState.address, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
+            auto count{std::min<u32>(resumeState.remaining, static_cast<u32>(std::distance(entry, pushBuffer.end())))};
+            if (!count)
+                return;
 
-                    break;
-            }
+            resumeState.remaining -= count;
+
+            bool increment{resumeState.state == MethodResumeState::State::Inc};
+            SendBatch(resumeState.address, span(&*entry, count), resumeState.subChannel, increment, resumeState.remaining == 0);
+
+            if (increment)
+                resumeState.address += count;
+            entry += count;
         }};
 
         // We've a method from a previous GpEntry that needs resuming
@@ -145,7 +215,7 @@ namespace skyline::soc::gm20b {
             resumeSplitMethod();
 
         // Process more methods if the entries are still not all used up after handling resuming
-        for (; entry != pushBufferData.end(); entry++) {
+        for (; entry != pushBuffer.end(); entry++) {
             // An entry containing all zeroes is a NOP, skip over it
             if (*entry == 0)
                 continue;
@@ -153,7 +223,7 @@ namespace skyline::soc::gm20b {
             PushBufferMethodHeader methodHeader{.raw = *entry};
 
             // Needed in order to check for methods split across multiple GpEntries
-            auto remainingEntries{std::distance(entry, pushBufferData.end()) - 1};
+            auto remainingEntries{std::distance(entry, pushBuffer.end()) - 1};
 
             // Handles storing state and initial execution for methods that are split across multiple GpEntries
             auto startSplitMethod{[&](auto methodState) {
@@ -173,8 +243,10 @@ namespace skyline::soc::gm20b {
             switch (methodHeader.secOp) {
                 case PushBufferMethodHeader::SecOp::IncMethod:
                     if (remainingEntries >= methodHeader.methodCount) {
-                        for (u32 i{}; i < methodHeader.methodCount; i++)
-                            Send(methodHeader.methodAddress + i, *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
+                        if (methodHeader.methodCount) {
+                            SendBatch(methodHeader.methodAddress, span(&*std::next(entry), methodHeader.methodCount), methodHeader.methodSubChannel, true, true);
+                            entry += methodHeader.methodCount;
+                        }
 
                         break;
                     } else {
@@ -183,8 +255,10 @@ namespace skyline::soc::gm20b {
                     }
                 case PushBufferMethodHeader::SecOp::NonIncMethod:
                     if (remainingEntries >= methodHeader.methodCount) {
-                        for (u32 i{}; i < methodHeader.methodCount; i++)
-                            Send(methodHeader.methodAddress, *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
+                        if (methodHeader.methodCount) {
+                            SendBatch(methodHeader.methodAddress, span(&*std::next(entry), methodHeader.methodCount), methodHeader.methodSubChannel, false, true);
+                            entry += methodHeader.methodCount;
+                        }
 
                         break;
                     } else {
@@ -193,8 +267,14 @@ namespace skyline::soc::gm20b {
                     }
                 case PushBufferMethodHeader::SecOp::OneInc:
                     if (remainingEntries >= methodHeader.methodCount) {
-                        for (u32 i{}; i < methodHeader.methodCount; i++)
-                            Send(methodHeader.methodAddress + (i ? 1 : 0), *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
+                        if (methodHeader.methodCount) {
+                            // The first argument is sent to the method address while all subsequent arguments are sent to the next method
+                            Send(methodHeader.methodAddress, *++entry, methodHeader.methodSubChannel, methodHeader.methodCount == 1);
+                            if (methodHeader.methodCount > 1) {
+                                SendBatch(methodHeader.methodAddress + 1, span(&*std::next(entry), methodHeader.methodCount - 1U), methodHeader.methodSubChannel, false, true);
+                                entry += methodHeader.methodCount - 1;
+                            }
+                        }
 
                         break;
                     } else {
@@ -214,40 +294,61 @@ namespace skyline::soc::gm20b {
         }
     }
 
-    void ChannelGpfifo::Run() {
-        pthread_setname_np(pthread_self(), "GPFIFO");
+    bool ChannelGpfifo::Run() {
         try {
-            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+            gpEntries.ProcessAvailable([this](const GpEntry &gpEntry) {
+                if (cancelled.load(std::memory_order_relaxed)) [[unlikely]]
+                    return;
 
-            gpEntries.Process([this](GpEntry gpEntry) {
                 Logger::Debug("Processing pushbuffer: 0x{:X}, Size: 0x{:X}", gpEntry.Address(), +gpEntry.size);
+                if (statistics) [[unlikely]]
+                    statistics->UpdateFrame(state.gpu->presentation.queuedFrames.load(std::memory_order_relaxed));
+                if (capture) [[unlikely]]
+                    capture->UpdateFrame(state.gpu->presentation.queuedFrames.load(std::memory_order_relaxed));
                 Process(gpEntry);
+                perf::SharedCounters.gpfifoDepth.fetch_sub(1, std::memory_order_relaxed);
             });
+
+            // Semaphore releases are batched with the commands after them till the channel runs out of entries, the guest may wait on them from this point onwards
+            channelCtx.executor.FlushReleases();
         } catch (const signal::SignalException &e) {
-            if (e.signal != SIGINT) {
-                Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
-                signal::BlockSignal({SIGINT});
-                state.process->Kill(false);
-            }
+            Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+            signal::BlockSignal({SIGINT});
+            state.process->Kill(false);
+            return false;
         } catch (const std::exception &e) {
             Logger::Error(e.what());
             signal::BlockSignal({SIGINT});
             state.process->Kill(false);
+            return false;
         }
+
+        // The fence orders clearing the flag before checking for entries, a producer pushing concurrently either sees the flag cleared and queues the channel itself or its entries are seen here
+        scheduled.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !gpEntries.Empty() && !scheduled.exchange(true, std::memory_order_relaxed);
+    }
+
+    void ChannelGpfifo::Schedule() {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in Run(), see the comment there
+        if (!scheduled.exchange(true, std::memory_order_relaxed))
+            state.soc->channelScheduler.Schedule(this);
     }
 
     void ChannelGpfifo::Push(span<GpEntry> entries) {
-        gpEntries.Append(entries);
+        perf::SharedCounters.gpfifoDepth.fetch_add(static_cast<u32>(entries.size()), std::memory_order_relaxed);
+        gpEntries.Append(entries, [this] {
+            Schedule(); // The channel must be queued before waiting for space as it'd never be drained otherwise
+        });
     }
 
     void ChannelGpfifo::Push(GpEntry entry) {
+        perf::SharedCounters.gpfifoDepth.fetch_add(1, std::memory_order_relaxed);
         gpEntries.Push(entry);
+        Schedule();
     }
 
     ChannelGpfifo::~ChannelGpfifo() {
-        if (thread.joinable()) {
-            pthread_kill(thread.native_handle(), SIGINT);
-            thread.join();
-        }
+        state.soc->channelScheduler.Cancel(this);
     }
 }
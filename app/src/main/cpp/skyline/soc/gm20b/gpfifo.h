@@ -3,8 +3,10 @@
 
 #pragma once
 
-#include <common/circular_queue.h>
+#include <common/spsc_queue.h>
 #include "engines/gpfifo.h"
+#include "method_statistics.h"
+#include "gpfifo_capture.h"
 
 namespace skyline::soc::gm20b {
     struct ChannelContext;
@@ -82,7 +84,7 @@ namespace skyline::soc::gm20b {
 
     /**
      * @brief The ChannelGpfifo class handles creating pushbuffers from GP entries and then processing them for a single channel
-     * @note A single ChannelGpfifo thread exists per channel, allowing them to run asynchronously
+     * @note Channels are processed asynchronously by the workers of the ChannelScheduler, a channel is queued on it whenever entries are pushed to it while it isn't queued already
      * @note This class doesn't perfectly map to any particular hardware component on the X1, it does a mix of the GPU Host PBDMA and handling the GPFIFO entries
      * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/manuals/volta/gv100/dev_pbdma.ref.txt#L62
      */
@@ -91,9 +93,11 @@ namespace skyline::soc::gm20b {
         const DeviceState &state;
         ChannelContext &channelCtx;
         engine::GPFIFO gpfifoEngine; //!< The engine for processing GPFIFO method calls
-        CircularQueue<GpEntry> gpEntries;
-        std::thread thread; //!< The thread that manages processing of pushbuffers
-        std::vector<u32> pushBufferData; //!< Persistent vector storing pushbuffer data to avoid constant reallocations
+        SpscQueue<GpEntry> gpEntries; //!< The GP entries submitted by the channel, pushes are serialized by the channel mutex of the GPU channel device so it only has a single producer
+        std::unique_ptr<MethodStatistics> statistics; //!< Statistics for all methods called on the channel, this is only allocated when they're enabled in the settings
+        std::unique_ptr<GpfifoCapture> capture; //!< A capture of the command stream of the channel, this is only allocated when capturing is enabled in the settings
+        std::atomic<bool> scheduled{}; //!< If the channel is queued on the ChannelScheduler or being processed by it, this is cleared by the worker before it checks for entries pushed during processing
+        std::vector<u32> pushBufferData; //!< Persistent vector storing pushbuffer data which straddles multiple mappings to avoid constant reallocations
 
         /**
          * @brief Holds the required state in order to resume a method started from one call to `Process` in another
@@ -115,11 +119,23 @@ namespace skyline::soc::gm20b {
         } resumeState{};
 
 
+        /**
+         * @return The engine that statistics for a method sent to the supplied subchannel are attributed to
+         */
+        static MethodStatistics::Engine GetStatisticsEngine(u32 method, u32 subChannel);
+
         /**
          * @brief Sends a method call to the GPU hardware
          */
         void Send(u32 method, u32 argument, u32 subchannel, bool lastCall);
 
+        /**
+         * @brief Sends a run of method calls to the GPU hardware in a single call to the target engine
+         * @param increment If the method address should be incremented after every argument
+         * @param lastCall If the final argument in the batch is also the final argument of the method
+         */
+        void SendBatch(u32 method, span<u32> arguments, u32 subchannel, bool increment, bool lastCall);
+
 
         /**
          * @brief Processes the pushbuffer contained within the given GpEntry, calling methods as needed
@@ -127,11 +143,19 @@ namespace skyline::soc::gm20b {
         void Process(GpEntry gpEntry);
 
         /**
-         * @brief Executes all pending entries in the FIFO and polls for more
+         * @brief Queues the channel on the ChannelScheduler if it isn't queued already, this must be called after entries have been pushed
          */
-        void Run();
+        void Schedule();
 
       public:
+        std::atomic<bool> cancelled{}; //!< If the channel is being destroyed, any pending waits inside the channel are abandoned and remaining entries are skipped
+
+        /**
+         * @brief Executes all entries in the FIFO that were pending at the time of the call, this is called by workers of the ChannelScheduler
+         * @return If more entries were pushed while processing, the channel must be queued again in that case
+         */
+        bool Run();
+
         /**
          * @param numEntries The number of gpEntries to allocate space for in the FIFO
          */
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "gpfifo.h"
+#include "gpfifo_capture.h"
+
+namespace skyline::soc::gm20b {
+    GpfifoCapture::GpfifoCapture(const std::string &path) : file(path, std::ios::trunc | std::ios::binary) {
+        if (!file)
+            throw exception("Failed to open GPFIFO capture file: {}", path);
+
+        FileHeader header{};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        Logger::Info("Capturing GPFIFO to {}", path);
+    }
+
+    void GpfifoCapture::WriteRecord(RecordType type, span<const u8> payload, span<const u8> trailer) {
+        RecordHeader header{
+            .type = type,
+            .size = static_cast<u32>(payload.size() + trailer.size()),
+        };
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!trailer.empty())
+            file.write(reinterpret_cast<const char *>(trailer.data()), static_cast<std::streamsize>(trailer.size()));
+    }
+
+    void GpfifoCapture::WriteEntry(GpEntry gpEntry, span<const u32> pushBuffer) {
+        WriteRecord(RecordType::GpEntry, span<const GpEntry>{&gpEntry, 1}.cast<const u8>(), pushBuffer.cast<const u8>());
+    }
+
+    void GpfifoCapture::UpdateFrame(u64 frameId) {
+        if (frameId == lastFrameId)
+            return;
+        lastFrameId = frameId;
+
+        WriteRecord(RecordType::Frame, span<const u64>{&frameId, 1}.cast<const u8>());
+        file.flush(); // Captures are flushed every frame so they remain usable if emulation is terminated abruptly
+    }
+}
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <fstream>
+#include <common.h>
+
+namespace skyline::soc::gm20b {
+    struct GpEntry;
+
+    /**
+     * @brief Records the GP entries of a channel alongside the contents of their pushbuffers into a file, this captures the entire command stream of the channel including macro uploads and inline data
+     * @note Captures can be decoded offline with tools/decode_gpfifo_capture.py, this is used to inspect and diff the command streams that the GPU emulation is fed with
+     * @note This class is **NOT** thread-safe, it must only be used by the GPFIFO thread of the channel
+     */
+    class GpfifoCapture {
+      public:
+        static constexpr u32 Magic{util::MakeMagic<u32>("SKGC")};
+        static constexpr u32 Version{1};
+
+        enum class RecordType : u32 {
+            GpEntry, //!< A GP entry followed by the words of its pushbuffer, control entries have no words
+            Frame, //!< A marker that the guest queued a frame for presentation, this is followed by the ID of the frame
+        };
+
+        struct FileHeader {
+            u32 magic{Magic};
+            u32 version{Version};
+        };
+        static_assert(sizeof(FileHeader) == 0x8);
+
+        struct RecordHeader {
+            RecordType type;
+            u32 size; //!< The size of the payload following the header in bytes
+        };
+        static_assert(sizeof(RecordHeader) == 0x8);
+
+      private:
+        std::ofstream file;
+        u64 lastFrameId{}; //!< The ID of the last frame queued for presentation as of the last call to UpdateFrame
+
+        void WriteRecord(RecordType type, span<const u8> payload, span<const u8> trailer = {});
+
+      public:
+        /**
+         * @param path The path of the capture file, any existing file is overwritten
+         */
+        GpfifoCapture(const std::string &path);
+
+        /**
+         * @brief Records a GP entry and the pushbuffer it references
+         */
+        void WriteEntry(GpEntry gpEntry, span<const u32> pushBuffer);
+
+        /**
+         * @brief Records a frame marker if the guest has queued a frame for presentation since the last call
+         */
+        void UpdateFrame(u64 frameId);
+    };
+}
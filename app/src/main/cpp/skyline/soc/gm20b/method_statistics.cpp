@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "method_statistics.h"
+
+namespace skyline::soc::gm20b {
+    constexpr std::array<const char *, MethodStatistics::EngineCount> EngineNames{"Maxwell 3D", "Maxwell Compute", "Kepler Memory", "Fermi 2D", "Maxwell DMA", "GPFIFO"};
+    constexpr size_t ReportedMethodCount{0x10}; //!< The amount of the most expensive methods of every engine that are included in the report
+
+    MethodStatistics::~MethodStatistics() {
+        Report();
+    }
+
+    void MethodStatistics::Add(Engine engine, u32 method, u32 arguments, i64 time) {
+        for (auto counter : {&methods[static_cast<size_t>(engine)][method % MethodCount], &frame[static_cast<size_t>(engine)]}) {
+            counter->calls++;
+            counter->arguments += arguments;
+            counter->time += time;
+        }
+    }
+
+    void MethodStatistics::UpdateFrame(u64 frameId) {
+        if (frameId == lastFrameId)
+            return;
+        lastFrameId = frameId;
+        frameCount++;
+
+        TRACE_EVENT_INSTANT("gpu", "GPU Method Statistics",
+                            "3D Calls", frame[static_cast<size_t>(Engine::Maxwell3D)].calls,
+                            "3D Arguments", frame[static_cast<size_t>(Engine::Maxwell3D)].arguments,
+                            "3D Time (us)", frame[static_cast<size_t>(Engine::Maxwell3D)].time / constant::NsInMicrosecond,
+                            "Compute Calls", frame[static_cast<size_t>(Engine::MaxwellCompute)].calls,
+                            "Compute Time (us)", frame[static_cast<size_t>(Engine::MaxwellCompute)].time / constant::NsInMicrosecond,
+                            "I2M Calls", frame[static_cast<size_t>(Engine::KeplerMemory)].calls,
+                            "I2M Time (us)", frame[static_cast<size_t>(Engine::KeplerMemory)].time / constant::NsInMicrosecond,
+                            "2D Calls", frame[static_cast<size_t>(Engine::Fermi2D)].calls,
+                            "2D Time (us)", frame[static_cast<size_t>(Engine::Fermi2D)].time / constant::NsInMicrosecond,
+                            "DMA Calls", frame[static_cast<size_t>(Engine::MaxwellDma)].calls,
+                            "DMA Time (us)", frame[static_cast<size_t>(Engine::MaxwellDma)].time / constant::NsInMicrosecond,
+                            "GPFIFO Calls", frame[static_cast<size_t>(Engine::Gpfifo)].calls,
+                            "GPFIFO Time (us)", frame[static_cast<size_t>(Engine::Gpfifo)].time / constant::NsInMicrosecond);
+
+        frame = {};
+    }
+
+    void MethodStatistics::Report() {
+        std::string report{util::Format("GPU method statistics over {} frames:", frameCount)};
+        for (size_t engine{}; engine < EngineCount; engine++) {
+            auto &engineMethods{methods[engine]};
+
+            Counter total{};
+            std::vector<u32> calledMethods;
+            for (u32 method{}; method < MethodCount; method++) {
+                auto &counter{engineMethods[method]};
+                if (!counter.calls)
+                    continue;
+                total.calls += counter.calls;
+                total.arguments += counter.arguments;
+                total.time += counter.time;
+                calledMethods.push_back(method);
+            }
+
+            if (!total.calls)
+                continue;
+
+            report += util::Format("\n* {}: {} calls with {} arguments in {}ms", EngineNames[engine], total.calls, total.arguments, total.time / constant::NsInMillisecond);
+
+            auto reportedCount{std::min(calledMethods.size(), ReportedMethodCount)};
+            std::partial_sort(calledMethods.begin(), calledMethods.begin() + static_cast<ssize_t>(reportedCount), calledMethods.end(), [&](u32 a, u32 b) {
+                return engineMethods[a].time > engineMethods[b].time;
+            });
+            for (size_t index{}; index < reportedCount; index++) {
+                auto method{calledMethods[index]};
+                auto &counter{engineMethods[method]};
+                report += util::Format("\n  * 0x{:03X}: {} calls with {} arguments in {}us ({}ns per call)", method, counter.calls, counter.arguments, counter.time / constant::NsInMicrosecond, counter.time / static_cast<i64>(counter.calls));
+            }
+        }
+        Logger::InfoNoPrefix("{}", report);
+    }
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::soc::gm20b {
+    /**
+     * @brief Collects the amount of calls to every method of every engine on a channel and the time spent in them, this is used to find methods that would benefit from HLE or batching
+     * @note Statistics for every guest frame are emitted as a Perfetto event and the totals are logged as a report on destruction
+     * @note This class is **NOT** thread-safe, it must only be used by the GPFIFO thread of the channel
+     */
+    class MethodStatistics {
+      public:
+        /**
+         * @brief The engines which methods are tracked for, all engines other than GPFIFO correspond to the subchannel they're bound to
+         */
+        enum class Engine : u8 {
+            Maxwell3D,
+            MaxwellCompute,
+            KeplerMemory,
+            Fermi2D,
+            MaxwellDma,
+            Gpfifo,
+        };
+        static constexpr size_t EngineCount{static_cast<size_t>(Engine::Gpfifo) + 1};
+
+      private:
+        static constexpr size_t MethodCount{0x1000}; //!< The amount of addressable methods in an engine, this is limited by the 12-bit method address of pushbuffer headers
+
+        struct Counter {
+            u64 calls; //!< The amount of calls into the engine, a batch of arguments is a single call
+            u64 arguments;
+            i64 time; //!< The time spent in the engine in nanoseconds
+        };
+
+        std::array<std::array<Counter, MethodCount>, EngineCount> methods{}; //!< The totals for every method over the lifetime of the channel
+        std::array<Counter, EngineCount> frame{}; //!< The totals for every engine over the current frame
+        u64 frameCount{}; //!< The amount of frames that have been completed
+        u64 lastFrameId{}; //!< The ID of the last frame queued for presentation as of the last call to UpdateFrame
+
+      public:
+        /**
+         * @brief A scoped timer which adds its lifetime and its arguments to the statistics of a method
+         */
+        class Scope {
+          private:
+            MethodStatistics *statistics;
+            Engine engine;
+            u32 method;
+            u32 arguments;
+            i64 start;
+
+          public:
+            /**
+             * @param statistics The statistics to add to, this has no effect if this is null
+             */
+            Scope(MethodStatistics *statistics, Engine engine, u32 method, u32 arguments) : statistics(statistics), engine(engine), method(method), arguments(arguments), start(statistics ? util::GetTimeNs() : 0) {}
+
+            ~Scope() {
+                if (statistics) [[unlikely]]
+                    statistics->Add(engine, method, arguments, util::GetTimeNs() - start);
+            }
+        };
+
+        ~MethodStatistics();
+
+        void Add(Engine engine, u32 method, u32 arguments, i64 time);
+
+        /**
+         * @brief Emits the statistics of the current frame and starts a new one if the guest has queued a frame for presentation since the last call
+         */
+        void UpdateFrame(u64 frameId);
+
+        /**
+         * @brief Logs the total statistics for every engine alongside its most expensive methods
+         */
+        void Report();
+    };
+}
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "h264.h"
+
+namespace skyline::soc::host1x::h264 {
+    /**
+     * @brief Writes the RBSP of a single NAL unit bit by bit, emulation prevention bytes are inserted when it's appended to the output
+     */
+    class NalWriter {
+      private:
+        std::vector<u8> &output;
+        std::vector<u8> rbsp;
+        u8 currentByte{};
+        u8 bitCount{}; //!< The amount of bits written into `currentByte`
+
+      public:
+        NalWriter(std::vector<u8> &output, u8 nalRefIdc, u8 nalUnitType) : output(output) {
+            output.insert(output.end(), {0, 0, 0, 1});
+            output.push_back(static_cast<u8>((nalRefIdc << 5) | nalUnitType));
+        }
+
+        void WriteBit(bool value) {
+            currentByte = static_cast<u8>((currentByte << 1) | value);
+            if (++bitCount == 8) {
+                rbsp.push_back(currentByte);
+                currentByte = 0;
+                bitCount = 0;
+            }
+        }
+
+        void WriteBits(u32 value, u8 count) {
+            while (count--)
+                WriteBit((value >> count) & 1);
+        }
+
+        /**
+         * @brief Writes an unsigned Exp-Golomb code
+         */
+        void WriteUe(u32 value) {
+            u64 codeNum{static_cast<u64>(value) + 1};
+            u8 length{static_cast<u8>(std::bit_width(codeNum))};
+            WriteBits(0, static_cast<u8>(length - 1));
+            while (length--)
+                WriteBit((codeNum >> length) & 1);
+        }
+
+        /**
+         * @brief Writes a signed Exp-Golomb code
+         */
+        void WriteSe(i32 value) {
+            WriteUe(value > 0 ? static_cast<u32>(2 * value - 1) : static_cast<u32>(-2 * static_cast<i64>(value)));
+        }
+
+        /**
+         * @brief Writes a scaling list as deltas in zig-zag scan order
+         * @param list The scaling list in raster order
+         */
+        void WriteScalingList(span<const u8> list, span<const u8> zigZagScan) {
+            u8 lastScale{8};
+            for (u8 index : zigZagScan) {
+                u8 scale{list[index]};
+                WriteSe(static_cast<i8>(static_cast<u8>(scale - lastScale))); // Deltas are modulo 256 and within [-128, 127]
+                lastScale = scale;
+            }
+        }
+
+        /**
+         * @brief Writes the RBSP trailing bits and appends the NAL unit to the output with emulation prevention applied
+         */
+        void Finish() {
+            WriteBit(true);
+            while (bitCount)
+                WriteBit(false);
+
+            u8 zeroCount{};
+            for (u8 byte : rbsp) {
+                if (zeroCount == 2 && byte <= 3) {
+                    output.push_back(3);
+                    zeroCount = 0;
+                }
+                output.push_back(byte);
+                zeroCount = byte ? 0 : static_cast<u8>(zeroCount + 1);
+            }
+        }
+    };
+
+    constexpr std::array<u8, 16> ZigZagScan4x4{0, 1, 4, 8, 5, 2, 3, 6, 9, 12, 13, 10, 7, 11, 14, 15};
+
+    constexpr std::array<u8, 64> ZigZagScan8x8{
+        0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+    };
+
+    void ComposeFrame(const DecoderContext &context, span<const u8> bitstream, std::vector<u8> &output) {
+        const auto &params{context.parameterSet};
+        output.clear();
+
+        {
+            NalWriter sps(output, 3, 7);
+            sps.WriteBits(100, 8); // profile_idc: High, this is a superset of all profiles the guest could be using
+            sps.WriteBits(0, 8); // constraint_set_flags
+            sps.WriteBits(51, 8); // level_idc: Level 5.1, this is the maximum level so the decoder doesn't reject the stream
+            sps.WriteUe(0); // seq_parameter_set_id
+            sps.WriteUe(static_cast<u32>(params.chromaFormatIdc));
+            if (params.chromaFormatIdc == 3)
+                sps.WriteBit(false); // separate_colour_plane_flag
+            sps.WriteUe(0); // bit_depth_luma_minus8
+            sps.WriteUe(0); // bit_depth_chroma_minus8
+            sps.WriteBit(false); // qpprime_y_zero_transform_bypass_flag
+            sps.WriteBit(false); // seq_scaling_matrix_present_flag, the scaling lists are supplied in the PPS instead
+            sps.WriteUe(static_cast<u32>(params.log2MaxFrameNumMinus4));
+            sps.WriteUe(static_cast<u32>(params.picOrderCntType));
+            if (params.picOrderCntType == 0) {
+                sps.WriteUe(static_cast<u32>(params.log2MaxPicOrderCntLsbMinus4));
+            } else if (params.picOrderCntType == 1) {
+                sps.WriteBit(params.deltaPicOrderAlwaysZeroFlag != 0);
+                sps.WriteSe(0); // offset_for_non_ref_pic
+                sps.WriteSe(0); // offset_for_top_to_bottom_field
+                sps.WriteUe(0); // num_ref_frames_in_pic_order_cnt_cycle
+            }
+            sps.WriteUe(16); // max_num_ref_frames, the guest doesn't supply this so the maximum is used
+            sps.WriteBit(false); // gaps_in_frame_num_value_allowed_flag
+            sps.WriteUe(params.picWidthInMbs - 1);
+            sps.WriteUe((params.frameHeightInMapUnits / (params.frameMbsOnlyFlag ? 1U : 2U)) - 1);
+            sps.WriteBit(params.frameMbsOnlyFlag != 0);
+            if (!params.frameMbsOnlyFlag)
+                sps.WriteBit(params.mbaffFrameFlag);
+            sps.WriteBit(params.direct8x8InferenceFlag);
+            sps.WriteBit(false); // frame_cropping_flag
+            sps.WriteBit(false); // vui_parameters_present_flag
+            sps.Finish();
+        }
+
+        {
+            NalWriter pps(output, 3, 8);
+            pps.WriteUe(0); // pic_parameter_set_id
+            pps.WriteUe(0); // seq_parameter_set_id
+            pps.WriteBit(params.entropyCodingModeFlag != 0);
+            pps.WriteBit(params.picOrderPresentFlag != 0);
+            pps.WriteUe(0); // num_slice_groups_minus1
+            pps.WriteUe(static_cast<u32>(params.numRefIdxL0DefaultActiveMinus1));
+            pps.WriteUe(static_cast<u32>(params.numRefIdxL1DefaultActiveMinus1));
+            pps.WriteBit(params.weightedPredFlag);
+            pps.WriteBits(static_cast<u32>(params.weightedBipredIdc), 2);
+            pps.WriteSe(static_cast<i32>(params.picInitQpMinus26));
+            pps.WriteSe(0); // pic_init_qs_minus26
+            pps.WriteSe(static_cast<i32>(params.chromaQpIndexOffset));
+            pps.WriteBit(params.deblockingFilterControlPresentFlag != 0);
+            pps.WriteBit(params.constrainedIntraPredFlag);
+            pps.WriteBit(params.redundantPicCntPresentFlag != 0);
+            pps.WriteBit(params.transform8x8ModeFlag != 0);
+            pps.WriteBit(true); // pic_scaling_matrix_present_flag
+            for (size_t list{}; list < 6; list++) {
+                pps.WriteBit(true); // pic_scaling_list_present_flag
+                pps.WriteScalingList(span(context.weightScale4x4).subspan(list * 16, 16), ZigZagScan4x4);
+            }
+            if (params.transform8x8ModeFlag) {
+                for (size_t list{}; list < 2; list++) {
+                    pps.WriteBit(true); // pic_scaling_list_present_flag
+                    pps.WriteScalingList(span(context.weightScale8x8).subspan(list * 64, 64), ZigZagScan8x8);
+                }
+            }
+            pps.WriteSe(static_cast<i32>(params.secondChromaQpIndexOffset));
+            pps.Finish();
+        }
+
+        output.insert(output.end(), bitstream.begin(), bitstream.end());
+    }
+}
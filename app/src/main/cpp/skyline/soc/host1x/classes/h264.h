@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::soc::host1x::h264 {
+    /**
+     * @brief The subset of the H.264 SPS and PPS which NVDEC receives for every frame, the guest driver parses these out of the stream so only slice data is present in the bitstream
+     */
+    struct ParameterSet {
+        i32 log2MaxPicOrderCntLsbMinus4;
+        i32 deltaPicOrderAlwaysZeroFlag;
+        i32 frameMbsOnlyFlag;
+        u32 picWidthInMbs;
+        u32 frameHeightInMapUnits;
+        struct {
+            u32 tileFormat : 2; //!< 0 if the output surfaces are pitch linear, otherwise they're block linear
+            u32 gobHeight : 3; //!< The log2 of the height of a block linear block in GOBs
+            u32 _pad_ : 27;
+        };
+        u32 entropyCodingModeFlag;
+        i32 picOrderPresentFlag;
+        i32 numRefIdxL0DefaultActiveMinus1;
+        i32 numRefIdxL1DefaultActiveMinus1;
+        i32 deblockingFilterControlPresentFlag;
+        i32 redundantPicCntPresentFlag;
+        u32 transform8x8ModeFlag;
+        u32 pitchLuma; //!< The pitch of the luma output surfaces in bytes
+        u32 pitchChroma; //!< The pitch of the chroma output surfaces in bytes
+        u32 lumaTopOffset;
+        u32 lumaBottomOffset;
+        u32 lumaFrameOffset;
+        u32 chromaTopOffset;
+        u32 chromaBottomOffset;
+        u32 chromaFrameOffset;
+        u32 histBufferSize;
+        struct {
+            u64 mbaffFrameFlag : 1;
+            u64 direct8x8InferenceFlag : 1;
+            u64 weightedPredFlag : 1;
+            u64 constrainedIntraPredFlag : 1;
+            u64 refPic : 1;
+            u64 fieldPic : 1;
+            u64 bottomField : 1;
+            u64 secondField : 1;
+            u64 log2MaxFrameNumMinus4 : 4;
+            u64 chromaFormatIdc : 2;
+            u64 picOrderCntType : 2;
+            i64 picInitQpMinus26 : 6;
+            i64 chromaQpIndexOffset : 5;
+            i64 secondChromaQpIndexOffset : 5;
+            u64 weightedBipredIdc : 2;
+            u64 currentPictureIndex : 7; //!< The index of the output surface that the frame is decoded into
+            u64 currentColocationIndex : 5;
+            u64 frameNumber : 16;
+            u64 frameSurfaces : 1;
+            u64 outputMemoryLayout : 1;
+        };
+    };
+    static_assert(sizeof(ParameterSet) == 0x60);
+
+    /**
+     * @brief The picture info structure which is passed to NVDEC for decoding an H.264 frame
+     */
+    struct DecoderContext {
+        u32 _pad0_[18];
+        u32 streamLength; //!< The size of the frame's bitstream in bytes
+        u32 _pad1_[3];
+        ParameterSet parameterSet;
+        u32 _pad2_[66];
+        std::array<u8, 6 * 16> weightScale4x4; //!< The 4x4 scaling lists in raster order
+        std::array<u8, 2 * 64> weightScale8x8; //!< The 8x8 scaling lists in raster order
+    };
+    static_assert(offsetof(DecoderContext, streamLength) == 0x48);
+    static_assert(offsetof(DecoderContext, parameterSet) == 0x58);
+    static_assert(offsetof(DecoderContext, weightScale4x4) == 0x1C0);
+    static_assert(offsetof(DecoderContext, weightScale8x8) == 0x220);
+
+    /**
+     * @brief Reconstructs a complete Annex B H.264 access unit from an NVDEC submission by prepending an SPS and PPS generated from its parameters, this allows it to be decoded by a regular decoder
+     * @param output The vector to write the access unit into, it's cleared beforehand
+     */
+    void ComposeFrame(const DecoderContext &context, span<const u8> bitstream, std::vector<u8> &output);
+}
@@ -39,4 +39,9 @@ namespace skyline::soc::host1x {
                 break;
         }
     }
+
+    void Host1xClass::CallMethodBatch(u32 method, span<u32> arguments, bool increment) {
+        for (u32 index{}; index < arguments.size(); index++)
+            CallMethod(increment ? method + index : method, arguments[index]);
+    }
 }
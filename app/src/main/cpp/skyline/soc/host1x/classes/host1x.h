@@ -19,5 +19,11 @@ namespace skyline::soc::host1x {
         Host1xClass(SyncpointSet &syncpoints);
 
         void CallMethod(u32 method, u32 argument);
+
+        /**
+         * @brief Calls a run of methods with the supplied arguments, these are all control methods so they're called individually
+         * @param increment If the method address should be incremented after every argument or stay the same
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment);
     };
 }
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "media_decoder.h"
+
+namespace skyline::soc::host1x {
+    MediaDecoder::MediaDecoder(std::string mime) : mime(std::move(mime)) {}
+
+    MediaDecoder::~MediaDecoder() {
+        Destroy();
+    }
+
+    void MediaDecoder::OnImageAvailable(void *context, AImageReader *reader) {
+        auto decoder{static_cast<MediaDecoder *>(context)};
+        {
+            std::scoped_lock lock(decoder->imageMutex);
+            decoder->pendingImages++;
+        }
+        decoder->imageCondition.notify_all();
+    }
+
+    void MediaDecoder::Destroy() {
+        if (codec) {
+            AMediaCodec_stop(codec);
+            AMediaCodec_delete(codec);
+            codec = nullptr;
+        }
+
+        if (imageReader) {
+            AImageReader_delete(imageReader);
+            imageReader = nullptr;
+        }
+
+        std::scoped_lock lock(imageMutex);
+        pendingImages = 0;
+        width = height = 0;
+    }
+
+    bool MediaDecoder::Configure(u32 pWidth, u32 pHeight) {
+        Destroy();
+        Logger::Info("Configuring {} decoder for {}x{}", mime, pWidth, pHeight);
+
+        if (AImageReader_new(static_cast<i32>(pWidth), static_cast<i32>(pHeight), AIMAGE_FORMAT_YUV_420_888, MaxImages, &imageReader) != AMEDIA_OK) {
+            Logger::Warn("Failed to create an image reader for the {} decoder", mime);
+            imageReader = nullptr;
+            return false;
+        }
+
+        AImageReader_ImageListener listener{
+            .context = this,
+            .onImageAvailable = &MediaDecoder::OnImageAvailable,
+        };
+        AImageReader_setImageListener(imageReader, &listener);
+
+        ANativeWindow *window{};
+        AImageReader_getWindow(imageReader, &window);
+
+        codec = AMediaCodec_createDecoderByType(mime.c_str());
+        if (!codec) {
+            Logger::Warn("No hardware decoder is available for {}", mime);
+            Destroy();
+            return false;
+        }
+
+        auto format{AMediaFormat_new()};
+        AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mime.c_str());
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, static_cast<i32>(pWidth));
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, static_cast<i32>(pHeight));
+        AMediaFormat_setInt32(format, "low-latency", 1); // NVDEC submissions are expected to complete in order, codecs which support it shouldn't hold back frames
+        auto status{AMediaCodec_configure(codec, format, window, nullptr, 0)};
+        AMediaFormat_delete(format);
+
+        if (status != AMEDIA_OK || AMediaCodec_start(codec) != AMEDIA_OK) {
+            Logger::Warn("Failed to start the {} decoder: {}", mime, static_cast<i32>(status));
+            Destroy();
+            return false;
+        }
+
+        width = pWidth;
+        height = pHeight;
+        return true;
+    }
+
+    void MediaDecoder::DrainOutput(i64 timeoutUs, const std::function<void(const DecodedFrame &)> &callback) {
+        AMediaCodecBufferInfo info{};
+        while (true) {
+            auto index{AMediaCodec_dequeueOutputBuffer(codec, &info, timeoutUs)};
+            if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED || index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED)
+                continue;
+            else if (index < 0)
+                return;
+
+            timeoutUs = 0; // Only the first frame is waited on, any further frames must already be decoded
+            AMediaCodec_releaseOutputBuffer(codec, static_cast<size_t>(index), true);
+
+            {
+                std::unique_lock lock(imageMutex);
+                if (!imageCondition.wait_for(lock, ImageTimeout, [this] { return pendingImages != 0; })) {
+                    Logger::Warn("Timed out waiting for a decoded {} frame", mime);
+                    continue;
+                }
+                pendingImages--;
+            }
+
+            AImage *image{};
+            if (AImageReader_acquireNextImage(imageReader, &image) != AMEDIA_OK)
+                continue;
+
+            i64 timestampNs{};
+            AImage_getTimestamp(image, &timestampNs);
+
+            DecodedFrame frame{
+                .timestamp = static_cast<u64>(timestampNs / 1000), // The presentation time of a frame is supplied in microseconds but the image timestamp is in nanoseconds
+                .width = width,
+                .height = height,
+            };
+            for (i32 plane{}; plane < 3; plane++) {
+                i32 length{}, rowStride{}, pixelStride{};
+                AImage_getPlaneData(image, plane, &frame.planes[plane], &length);
+                AImage_getPlaneRowStride(image, plane, &rowStride);
+                AImage_getPlanePixelStride(image, plane, &pixelStride);
+                frame.rowStrides[plane] = static_cast<u32>(rowStride);
+                frame.pixelStrides[plane] = static_cast<u32>(pixelStride);
+            }
+
+            callback(frame);
+            AImage_delete(image);
+        }
+    }
+
+    void MediaDecoder::Decode(span<const u8> bitstream, u64 timestamp, u32 pWidth, u32 pHeight, const std::function<void(const DecodedFrame &)> &callback) {
+        TRACE_EVENT("host1x", "MediaDecoder::Decode", "size", bitstream.size());
+
+        if ((pWidth != width || pHeight != height) && !Configure(pWidth, pHeight))
+            return;
+
+        auto index{AMediaCodec_dequeueInputBuffer(codec, InputTimeoutUs)};
+        if (index < 0) {
+            Logger::Warn("Dropping {} frame as no input buffer became available", mime);
+            DrainOutput(0, callback);
+            return;
+        }
+
+        size_t capacity{};
+        auto buffer{AMediaCodec_getInputBuffer(codec, static_cast<size_t>(index), &capacity)};
+        size_t size{bitstream.size()};
+        if (size > capacity) {
+            Logger::Warn("Truncating {} frame of 0x{:X} bytes to the input buffer size of 0x{:X} bytes", mime, size, capacity);
+            size = capacity;
+        }
+
+        std::memcpy(buffer, bitstream.data(), size);
+        AMediaCodec_queueInputBuffer(codec, static_cast<size_t>(index), 0, size, timestamp, 0);
+
+        DrainOutput(OutputTimeoutUs, callback);
+    }
+}
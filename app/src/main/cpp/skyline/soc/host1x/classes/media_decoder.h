@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <media/NdkMediaCodec.h>
+#include <media/NdkImageReader.h>
+#include <common.h>
+
+namespace skyline::soc::host1x {
+    /**
+     * @brief A decoded frame in 8-bit YUV 4:2:0, the planes are only valid for the duration of the callback it's passed to
+     */
+    struct DecodedFrame {
+        u64 timestamp; //!< The timestamp that the frame's bitstream was submitted with
+        u32 width;
+        u32 height;
+        std::array<u8 *, 3> planes; //!< The Y, U and V planes
+        std::array<u32, 3> rowStrides; //!< The distance between consecutive rows of every plane in bytes
+        std::array<u32, 3> pixelStrides; //!< The distance between consecutive samples of every plane in bytes, the chroma planes of semi-planar frames have a stride of 2
+    };
+
+    /**
+     * @brief A hardware video decoder backed by Android's MediaCodec, frames are rendered into an AImageReader so their layout is independent of vendor-specific buffer formats
+     * @note Decoding is synchronous from the perspective of the caller, a frame is waited on for a short duration after its bitstream is queued so NVDEC submissions can complete in order
+     */
+    class MediaDecoder {
+      private:
+        static constexpr i32 MaxImages{4}; //!< The amount of images that the image reader can hold at once, frames are copied out and released immediately so this only needs to cover the codec's output queue
+        static constexpr i64 InputTimeoutUs{100000}; //!< The maximum duration to wait for an input buffer to become available
+        static constexpr i64 OutputTimeoutUs{50000}; //!< The maximum duration to wait for the frame of a submission to be decoded, decoders with reordering may take several submissions before outputting a frame
+        static constexpr std::chrono::milliseconds ImageTimeout{50}; //!< The maximum duration to wait for a rendered output buffer to arrive at the image reader
+
+        std::string mime;
+        u32 width{}, height{}; //!< The dimensions that the codec is currently configured for, these are zero if it isn't configured
+        AMediaCodec *codec{};
+        AImageReader *imageReader{};
+
+        std::mutex imageMutex;
+        std::condition_variable imageCondition; //!< Signalled by the image reader's listener when a new image is available
+        u32 pendingImages{}; //!< The amount of images available in the image reader which haven't been acquired yet
+
+        static void OnImageAvailable(void *context, AImageReader *reader);
+
+        /**
+         * @brief Destroys the codec and image reader if they exist
+         */
+        void Destroy();
+
+        /**
+         * @brief Creates and starts a codec for the supplied dimensions, this replaces any existing codec
+         * @return If the codec was successfully created
+         */
+        bool Configure(u32 pWidth, u32 pHeight);
+
+        /**
+         * @brief Passes all frames which the codec has finished decoding to the callback
+         * @param timeoutUs The duration to wait for the first frame
+         */
+        void DrainOutput(i64 timeoutUs, const std::function<void(const DecodedFrame &)> &callback);
+
+      public:
+        /**
+         * @param mime The MIME type of the codec, such as "video/avc"
+         */
+        MediaDecoder(std::string mime);
+
+        ~MediaDecoder();
+
+        /**
+         * @brief Decodes a single frame of bitstream data and passes any frames that finished decoding to the callback
+         * @param timestamp A unique and increasing value for this frame, it's used to identify the frame once decoded
+         * @note The codec is recreated whenever the dimensions of the stream change
+         * @note Errors are logged rather than thrown so that a broken stream only results in missing frames
+         */
+        void Decode(span<const u8> bitstream, u64 timestamp, u32 pWidth, u32 pHeight, const std::function<void(const DecodedFrame &)> &callback);
+    };
+}
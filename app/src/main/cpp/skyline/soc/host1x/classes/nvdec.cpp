@@ -1,13 +1,174 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
+#include <soc.h>
 #include "nvdec.h"
+#include "h264.h"
 
 namespace skyline::soc::host1x {
-    NvDecClass::NvDecClass(std::function<void()> opDoneCallback)
-        : opDoneCallback(std::move(opDoneCallback)) {}
+    /**
+     * @brief The codecs that can be selected with the SetCodecId method
+     */
+    enum class NvDecCodec : u32 {
+        None = 0x0,
+        H264 = 0x3,
+        Vp8 = 0x5,
+        H265 = 0x7,
+        Vp9 = 0x9,
+    };
+
+    constexpr static u32 SetCodecIdMethodId{0x80};
+    constexpr static u32 ExecuteMethodId{0xC0};
+    constexpr static u32 PictureInfoOffsetMethodId{0x101};
+    constexpr static u32 FrameBitstreamOffsetMethodId{0x102};
+    constexpr static u32 SurfaceLumaOffsetMethodId{0x10C}; //!< The first of the luma output surface addresses
+    constexpr static u32 SurfaceChromaOffsetMethodId{0x11D}; //!< The first of the chroma output surface addresses
+    constexpr static u32 SurfaceCount{17}; //!< The amount of output surfaces that can be bound
+
+    NvDecClass::NvDecClass(const DeviceState &state, std::function<void()> opDoneCallback)
+        : state(state),
+          opDoneCallback(std::move(opDoneCallback)) {}
+
+    u32 NvDecClass::GetAddress(u32 method) {
+        return static_cast<u32>(static_cast<u64>(registers[method]) << 8);
+    }
+
+    void NvDecClass::WritePlane(const OutputSurfaces &surfaces, u32 address, u32 pitch, u32 widthBytes, u32 rows) {
+        if (!address) [[unlikely]]
+            return;
+
+        if (!surfaces.blockLinear) {
+            guestSurface.resize(static_cast<size_t>(pitch) * rows);
+            for (u32 y{}; y < rows; y++)
+                std::memcpy(guestSurface.data() + (static_cast<size_t>(y) * pitch), linearSurface.data() + (static_cast<size_t>(y) * widthBytes), std::min(widthBytes, pitch));
+        } else {
+            // Block linear surfaces are made up of 64x8 byte GOBs which are stacked vertically into blocks, each GOB consists of 16x2 byte sectors
+            constexpr u32 GobWidth{64}, GobHeight{8}, GobSize{GobWidth * GobHeight};
+            u32 blockHeight{1U << surfaces.gobHeight}, widthGobs{util::AlignUp(pitch, GobWidth) / GobWidth};
+            guestSurface.resize(static_cast<size_t>(widthGobs) * GobSize * (util::AlignUp(rows, GobHeight * blockHeight) / GobHeight));
+            widthBytes = std::min(widthBytes, widthGobs * GobWidth);
+
+            for (u32 y{}; y < rows; y++) {
+                size_t rowOffset{(static_cast<size_t>(y / (GobHeight * blockHeight)) * widthGobs * blockHeight * GobSize) + (((y / GobHeight) % blockHeight) * GobSize) + (((y % GobHeight) / 2) * 64) + ((y % 2) * 16)};
+                for (u32 x{}; x < widthBytes; x += 16) {
+                    size_t offset{rowOffset + ((x / GobWidth) * blockHeight * GobSize) + (((x % GobWidth) / 32) * 256) + (((x % 32) / 16) * 32)};
+                    std::memcpy(guestSurface.data() + offset, linearSurface.data() + (static_cast<size_t>(y) * widthBytes) + x, std::min(16U, widthBytes - x));
+                }
+            }
+        }
+
+        state.soc->smmu.Write(address, span(guestSurface));
+    }
+
+    void NvDecClass::WriteFrame(const DecodedFrame &frame) {
+        TRACE_EVENT("host1x", "NvDecClass::WriteFrame");
+
+        auto it{pendingFrames.find(frame.timestamp)};
+        if (it == pendingFrames.end()) {
+            Logger::Warn("Decoded frame with an unknown timestamp: {}", frame.timestamp);
+            return;
+        }
+
+        // Any frames submitted before this one which weren't output have been dropped by the decoder
+        auto surfaces{it->second};
+        pendingFrames.erase(pendingFrames.begin(), std::next(it));
+
+        linearSurface.resize(static_cast<size_t>(frame.width) * frame.height);
+        for (u32 y{}; y < frame.height; y++)
+            std::memcpy(linearSurface.data() + (static_cast<size_t>(y) * frame.width), frame.planes[0] + (static_cast<size_t>(y) * frame.rowStrides[0]), frame.width);
+        WritePlane(surfaces, surfaces.lumaAddress, surfaces.lumaPitch, frame.width, frame.height);
+
+        // NVDEC outputs chroma as interleaved UV samples, frames which are already semi-planar in that order can be copied directly
+        u32 chromaWidth{frame.width / 2}, chromaHeight{frame.height / 2};
+        bool semiPlanar{frame.pixelStrides[1] == 2 && frame.planes[2] == frame.planes[1] + 1};
+        linearSurface.resize(static_cast<size_t>(frame.width) * chromaHeight);
+        for (u32 y{}; y < chromaHeight; y++) {
+            auto output{linearSurface.data() + (static_cast<size_t>(y) * frame.width)};
+            auto u{frame.planes[1] + (static_cast<size_t>(y) * frame.rowStrides[1])}, v{frame.planes[2] + (static_cast<size_t>(y) * frame.rowStrides[2])};
+            if (semiPlanar) {
+                std::memcpy(output, u, chromaWidth * 2);
+            } else {
+                for (u32 x{}; x < chromaWidth; x++) {
+                    output[x * 2] = u[x * frame.pixelStrides[1]];
+                    output[(x * 2) + 1] = v[x * frame.pixelStrides[2]];
+                }
+            }
+        }
+        WritePlane(surfaces, surfaces.chromaAddress, surfaces.chromaPitch, chromaWidth * 2, chromaHeight);
+    }
+
+    void NvDecClass::DecodeH264() {
+        auto &smmu{state.soc->smmu};
+        auto context{smmu.Read<h264::DecoderContext>(GetAddress(PictureInfoOffsetMethodId))};
+        const auto &params{context.parameterSet};
+
+        bitstream.resize(context.streamLength);
+        smmu.Read(span(bitstream), GetAddress(FrameBitstreamOffsetMethodId));
+        h264::ComposeFrame(context, bitstream, frameBuffer);
+
+        u32 surfaceIndex{static_cast<u32>(params.currentPictureIndex)};
+        if (surfaceIndex >= SurfaceCount) [[unlikely]] {
+            Logger::Warn("H.264 frame has an invalid output surface: {}", surfaceIndex);
+            return;
+        }
+
+        // Frames which the decoder failed to output are otherwise only discarded once a later frame is output
+        constexpr size_t MaxPendingFrames{32};
+        if (pendingFrames.size() >= MaxPendingFrames)
+            pendingFrames.erase(pendingFrames.begin());
+
+        u64 timestamp{nextTimestamp++};
+        pendingFrames.emplace(timestamp, OutputSurfaces{
+            .lumaAddress = GetAddress(SurfaceLumaOffsetMethodId + surfaceIndex),
+            .chromaAddress = GetAddress(SurfaceChromaOffsetMethodId + surfaceIndex),
+            .lumaPitch = params.pitchLuma,
+            .chromaPitch = params.pitchChroma,
+            .blockLinear = params.tileFormat != 0,
+            .gobHeight = static_cast<u8>(params.gobHeight),
+        });
+
+        constexpr u32 MacroblockSize{16};
+        u32 width{params.picWidthInMbs * MacroblockSize}, height{params.frameHeightInMapUnits * (params.frameMbsOnlyFlag ? 1U : 2U) * MacroblockSize};
+
+        if (!h264Decoder)
+            h264Decoder = std::make_unique<MediaDecoder>("video/avc");
+        h264Decoder->Decode(frameBuffer, timestamp, width, height, [this](const DecodedFrame &frame) {
+            WriteFrame(frame);
+        });
+    }
+
+    void NvDecClass::Execute() {
+        TRACE_EVENT("host1x", "NvDecClass::Execute");
+
+        auto codec{static_cast<NvDecCodec>(registers[SetCodecIdMethodId])};
+        switch (codec) {
+            case NvDecCodec::H264:
+                DecodeH264();
+                break;
+            default:
+                Logger::Warn("Unimplemented NVDEC codec: 0x{:X}", static_cast<u32>(codec));
+                break;
+        }
+    }
 
     void NvDecClass::CallMethod(u32 method, u32 argument) {
-        Logger::Warn("Unknown NVDEC class method called: 0x{:X} argument: 0x{:X}", method, argument);
+        CallMethodBatch(method, span(&argument, 1), true);
+    }
+
+    void NvDecClass::CallMethodBatch(u32 method, span<u32> arguments, bool increment) {
+        if (method + (increment ? arguments.size() : 1) > RegisterCount) [[unlikely]] {
+            Logger::Warn("Out of bounds NVDEC class method batch called: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        if (increment)
+            span(registers).subspan(method).copy_from(arguments);
+        else
+            registers[method] = arguments.back();
+
+        // Execute is only ever written by itself after the frame's registers have been set up
+        if (increment ? (method <= ExecuteMethodId && ExecuteMethodId < method + arguments.size()) : method == ExecuteMethodId)
+            Execute();
     }
 }
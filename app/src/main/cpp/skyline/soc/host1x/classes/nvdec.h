@@ -4,18 +4,74 @@
 #pragma once
 
 #include <common.h>
+#include "media_decoder.h"
 
 namespace skyline::soc::host1x {
     /**
      * @brief The NVDEC Host1x class implements hardware accelerated video decoding for the VP9/VP8/H264/VC1 codecs
+     * @note Frames are decoded by the host's hardware decoders through MediaCodec and written into the guest's output surfaces, only H.264 is currently supported
      */
     class NvDecClass {
       private:
+        const DeviceState &state;
         std::function<void()> opDoneCallback;
 
+        static constexpr size_t RegisterCount{0x1000}; //!< The size of the method space of the class in words
+        std::array<u32, RegisterCount> registers{}; //!< The values written to every method of the class
+
+        /**
+         * @brief The output surfaces that a submitted frame will be written into once it's decoded
+         */
+        struct OutputSurfaces {
+            u32 lumaAddress;
+            u32 chromaAddress;
+            u32 lumaPitch;
+            u32 chromaPitch;
+            bool blockLinear; //!< If the surfaces are block linear rather than pitch linear
+            u8 gobHeight; //!< The log2 of the height of a block in GOBs for block linear surfaces
+        };
+
+        u64 nextTimestamp{}; //!< The timestamp of the next submitted frame, this is used to associate decoded frames with their submission
+        std::map<u64, OutputSurfaces> pendingFrames; //!< The output surfaces of submitted frames which haven't been decoded yet, keyed by their timestamp
+
+        std::unique_ptr<MediaDecoder> h264Decoder; //!< The decoder for H.264 streams, this is created on the first H.264 submission
+        std::vector<u8> bitstream; //!< A buffer for the bitstream of a submission, this is only a member to retain its capacity
+        std::vector<u8> frameBuffer; //!< A buffer for the reconstructed bitstream that's passed to the decoder, this is only a member to retain its capacity
+        std::vector<u8> linearSurface; //!< A buffer for building a plane in linear layout before it's written to the guest
+        std::vector<u8> guestSurface; //!< A buffer for a plane in the guest's layout before it's written to the guest
+
+        /**
+         * @return The SMMU address stored in the supplied register, addresses are written shifted right by 8 bits
+         */
+        u32 GetAddress(u32 method);
+
+        /**
+         * @brief Writes a plane from `linearSurface` into a guest surface
+         * @param widthBytes The width of the plane in bytes, rows in `linearSurface` are tightly packed
+         */
+        void WritePlane(const OutputSurfaces &surfaces, u32 address, u32 pitch, u32 widthBytes, u32 rows);
+
+        /**
+         * @brief Writes a decoded frame into the output surfaces of its submission
+         */
+        void WriteFrame(const DecodedFrame &frame);
+
+        /**
+         * @brief Decodes the frame described by the current register state
+         */
+        void Execute();
+
+        void DecodeH264();
+
       public:
-        NvDecClass(std::function<void()> opDoneCallback);
+        NvDecClass(const DeviceState &state, std::function<void()> opDoneCallback);
 
         void CallMethod(u32 method, u32 argument);
+
+        /**
+         * @brief Calls a run of methods with the supplied arguments, register setup sequences are written in bulk rather than dispatched one method at a time
+         * @param increment If the method address should be incremented after every argument or stay the same
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment);
     };
 }
@@ -1,13 +1,289 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <gpu.h>
+#include <common/trace.h>
+#include <soc.h>
 #include "vic.h"
 
 namespace skyline::soc::host1x {
-    VicClass::VicClass(std::function<void()> opDoneCallback)
-        : opDoneCallback(std::move(opDoneCallback)) {}
+    constexpr static u32 ExecuteMethodId{0xC0};
+    constexpr static u32 SurfaceOffsetMethodId{0x100}; //!< The first of the luma, chroma U and chroma V addresses of the surfaces of every slot
+    constexpr static u32 SlotSurfaceCount{8}; //!< The amount of surfaces of every slot, only the current surface is used as the others are reference fields for deinterlacing
+    constexpr static u32 PlaneCount{3};
+    constexpr static u32 ConfigStructOffsetMethodId{0x1C2};
+    constexpr static u32 OutputSurfaceLumaOffsetMethodId{0x1C8};
+    constexpr static u32 OutputSurfaceChromaOffsetMethodId{0x1C9};
+
+    namespace {
+        using ColorMatrix = std::array<std::array<float, 4>, 3>;
+
+        constexpr float Kr{0.299f}, Kb{0.114f}, Kg{1.0f - Kr - Kb}; //!< The BT.601 luma coefficients
+        constexpr float LumaOffset{16.0f / 255.0f}, LumaRange{219.0f / 255.0f}, ChromaOffset{128.0f / 255.0f}, ChromaRange{224.0f / 255.0f}; //!< The limited range quantization of 8-bit YUV
+
+        /**
+         * @return A matrix converting limited range YUV into RGB, normalized luma and chroma are Y' = (Y - LumaOffset) / LumaRange and Pb/Pr = (U/V - ChromaOffset) / ChromaRange
+         */
+        constexpr ColorMatrix GetYuvToRgbMatrix() {
+            float y{1.0f / LumaRange}, pb{2.0f * (1.0f - Kb) / ChromaRange}, pr{2.0f * (1.0f - Kr) / ChromaRange};
+            float gPb{-Kb * pb / Kg}, gPr{-Kr * pr / Kg}; // G = (Y' - Kr * R - Kb * B) / Kg
+            return ColorMatrix{{
+                {y, 0.0f, pr, -(y * LumaOffset) - (pr * ChromaOffset)},
+                {y, gPb, gPr, -(y * LumaOffset) - ((gPb + gPr) * ChromaOffset)},
+                {y, pb, 0.0f, -(y * LumaOffset) - (pb * ChromaOffset)},
+            }};
+        }
+
+        /**
+         * @return A matrix converting RGB into limited range YUV, this is the inverse of GetYuvToRgbMatrix
+         */
+        constexpr ColorMatrix GetRgbToYuvMatrix() {
+            float u{ChromaRange / (2.0f * (1.0f - Kb))}, v{ChromaRange / (2.0f * (1.0f - Kr))};
+            return ColorMatrix{{
+                {LumaRange * Kr, LumaRange * Kg, LumaRange * Kb, LumaOffset},
+                {-u * Kr, -u * Kg, u * (1.0f - Kb), ChromaOffset},
+                {v * (1.0f - Kr), -v * Kg, -v * Kb, ChromaOffset},
+            }};
+        }
+
+        constexpr ColorMatrix GetColorMatrix(bool yuvInput, bool yuvOutput) {
+            if (yuvInput && !yuvOutput)
+                return GetYuvToRgbMatrix();
+            else if (!yuvInput && yuvOutput)
+                return GetRgbToYuvMatrix();
+            return ColorMatrix{{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}}};
+        }
+
+        /**
+         * @return The format of the only plane of an RGB surface, or nothing for YUV and unsupported formats
+         */
+        std::optional<gpu::texture::Format> GetRgbFormat(vic::PixelFormat format) {
+            switch (format) {
+                case vic::PixelFormat::A8B8G8R8:
+                    return gpu::format::R8G8B8A8Unorm;
+                case vic::PixelFormat::A8R8G8B8:
+                    return gpu::format::B8G8R8A8Unorm;
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        bool IsSupported(vic::PixelFormat format) {
+            return format == vic::PixelFormat::Y8U8V8N420 || GetRgbFormat(format);
+        }
+    }
+
+    VicClass::VicClass(const DeviceState &state, std::function<void()> opDoneCallback)
+        : state(state),
+          opDoneCallback(std::move(opDoneCallback)) {}
+
+    u32 VicClass::GetAddress(u32 method) {
+        return static_cast<u32>(static_cast<u64>(registers[method]) << 8);
+    }
+
+    std::optional<gpu::TextureView> VicClass::GetPlane(const vic::SurfaceConfig &config, u32 address, gpu::texture::Format format, gpu::texture::Dimensions dimensions, u32 pitch, bool output) {
+        if (!address) [[unlikely]]
+            return std::nullopt;
+
+        gpu::GuestTexture guest;
+        guest.format = format;
+        guest.dimensions = dimensions;
+        guest.type = gpu::texture::TextureType::e2D;
+        if (config.blockKind == 0)
+            guest.tileConfig = gpu::texture::TileConfig{
+                .mode = gpu::texture::TileMode::Pitch,
+                .pitch = std::max(pitch, dimensions.width) * format->bpb,
+            };
+        else
+            guest.tileConfig = gpu::texture::TileConfig{
+                .mode = gpu::texture::TileMode::Block,
+                .blockHeight = static_cast<u8>(1U << config.blockHeightLog2),
+                .blockDepth = 1,
+            };
+
+        auto mappings{state.soc->smmu.TranslateRange(address, static_cast<u32>(guest.GetLayerStride()))};
+        if (mappings.size() != 1) [[unlikely]] {
+            Logger::Warn("VIC surface at 0x{:X} spans {} mappings", address, mappings.size());
+            return std::nullopt;
+        }
+        guest.mappings.assign(mappings.begin(), mappings.end());
+
+        auto view{state.gpu->texture.FindOrCreate(guest, output)};
+        if (!gpu::CompositionPass::IsSupported(*view.backing)) [[unlikely]] {
+            Logger::Warn("VIC surface at 0x{:X} with format {} can't be composited", address, vk::to_string(view.format->vkFormat));
+            return std::nullopt;
+        }
+        return view;
+    }
+
+    void VicClass::Execute() {
+        TRACE_EVENT("host1x", "VicClass::Execute");
+
+        auto config{state.soc->smmu.Read<vic::ConfigStruct>(GetAddress(ConfigStructOffsetMethodId))};
+        const auto &outputSurface{config.outputSurfaceConfig};
+        auto outputFormat{static_cast<vic::PixelFormat>(outputSurface.pixelFormat)};
+        if (!IsSupported(outputFormat)) [[unlikely]] {
+            Logger::Warn("Unimplemented VIC output format: 0x{:X}", static_cast<u32>(outputFormat));
+            return;
+        }
+
+        // Planes of YUV surfaces are composited separately, the luma plane is composited with only the first row of the matrix while the chroma plane uses the others
+        bool yuvOutput{outputFormat == vic::PixelFormat::Y8U8V8N420};
+        u32 outputWidth{static_cast<u32>(outputSurface.surfaceWidthMinus1) + 1}, outputHeight{static_cast<u32>(outputSurface.surfaceHeightMinus1) + 1};
+        std::vector<gpu::TextureView> outputs;
+        if (yuvOutput) {
+            auto luma{GetPlane(outputSurface, GetAddress(OutputSurfaceLumaOffsetMethodId), gpu::format::R8Unorm, {outputWidth, outputHeight}, static_cast<u32>(outputSurface.lumaWidthMinus1) + 1, true)};
+            auto chroma{GetPlane(outputSurface, GetAddress(OutputSurfaceChromaOffsetMethodId), gpu::format::R8G8Unorm, {(outputWidth + 1) / 2, (outputHeight + 1) / 2}, static_cast<u32>(outputSurface.chromaWidthMinus1) + 1, true)};
+            if (!luma || !chroma)
+                return;
+            outputs = {std::move(*luma), std::move(*chroma)};
+        } else {
+            auto surface{GetPlane(outputSurface, GetAddress(OutputSurfaceLumaOffsetMethodId), *GetRgbFormat(outputFormat), {outputWidth, outputHeight}, static_cast<u32>(outputSurface.lumaWidthMinus1) + 1, true)};
+            if (!surface)
+                return;
+            outputs = {std::move(*surface)};
+        }
+
+        std::vector<gpu::CompositionPass::Layer> layers;
+        for (u32 slot{}; slot < vic::SlotCount; slot++) {
+            const auto &slotStruct{config.slots[slot]};
+            if (!slotStruct.config.slotEnable)
+                continue;
+
+            const auto &surface{slotStruct.surfaceConfig};
+            auto format{static_cast<vic::PixelFormat>(surface.pixelFormat)};
+            if (!IsSupported(format)) [[unlikely]] {
+                Logger::Warn("Unimplemented VIC slot format: 0x{:X}", static_cast<u32>(format));
+                continue;
+            }
+
+            u32 width{static_cast<u32>(surface.surfaceWidthMinus1) + 1}, height{static_cast<u32>(surface.surfaceHeightMinus1) + 1};
+            u32 surfaceMethod{SurfaceOffsetMethodId + (slot * SlotSurfaceCount * PlaneCount)};
+            bool yuvInput{format == vic::PixelFormat::Y8U8V8N420};
+            std::optional<gpu::TextureView> luma, chroma;
+            if (yuvInput) {
+                luma = GetPlane(surface, GetAddress(surfaceMethod), gpu::format::R8Unorm, {width, height}, static_cast<u32>(surface.lumaWidthMinus1) + 1, false);
+                chroma = GetPlane(surface, GetAddress(surfaceMethod + 1), gpu::format::R8G8Unorm, {(width + 1) / 2, (height + 1) / 2}, static_cast<u32>(surface.chromaWidthMinus1) + 1, false);
+                if (!chroma)
+                    continue;
+            } else {
+                luma = GetPlane(surface, GetAddress(surfaceMethod), *GetRgbFormat(format), {width, height}, static_cast<u32>(surface.lumaWidthMinus1) + 1, false);
+            }
+            if (!luma)
+                continue;
+
+            // Rectangles which are empty after being clamped to their surface are treated as covering the entirety of it
+            const auto &slotConfig{slotStruct.config};
+            auto getRect{[](float left, float top, float right, float bottom, u32 width, u32 height) {
+                left = std::clamp(left, 0.0f, static_cast<float>(width));
+                right = std::clamp(right, 0.0f, static_cast<float>(width));
+                top = std::clamp(top, 0.0f, static_cast<float>(height));
+                bottom = std::clamp(bottom, 0.0f, static_cast<float>(height));
+                if (right <= left || bottom <= top)
+                    return std::array<float, 4>{0.0f, 0.0f, 1.0f, 1.0f};
+                return std::array<float, 4>{left / static_cast<float>(width), top / static_cast<float>(height), right / static_cast<float>(width), bottom / static_cast<float>(height)};
+            }};
+            constexpr float FixedPointScale{1 << 16};
+            auto source{getRect(static_cast<float>(slotConfig.sourceRectLeft) / FixedPointScale, static_cast<float>(slotConfig.sourceRectTop) / FixedPointScale, (static_cast<float>(slotConfig.sourceRectRight) / FixedPointScale) + 1.0f, (static_cast<float>(slotConfig.sourceRectBottom) / FixedPointScale) + 1.0f, width, height)};
+            auto destination{getRect(static_cast<float>(slotConfig.destinationRectLeft), static_cast<float>(slotConfig.destinationRectTop), static_cast<float>(slotConfig.destinationRectRight) + 1.0f, static_cast<float>(slotConfig.destinationRectBottom) + 1.0f, outputWidth, outputHeight)};
+
+            layers.push_back(gpu::CompositionPass::Layer{
+                .luma = std::move(*luma),
+                .chroma = std::move(chroma),
+                .source = source,
+                .destination = destination,
+                .matrix = GetColorMatrix(yuvInput, yuvOutput),
+                .alpha = slotConfig.constantAlpha ? static_cast<float>(slotConfig.planarAlpha) / 1023.0f : 1.0f,
+            });
+        }
+
+        const auto &outputConfig{config.outputConfig};
+        constexpr float BackgroundScale{1023.0f};
+        std::array<float, 4> background{static_cast<float>(outputConfig.backgroundRed) / BackgroundScale, static_cast<float>(outputConfig.backgroundGreen) / BackgroundScale, static_cast<float>(outputConfig.backgroundBlue) / BackgroundScale, static_cast<float>(outputConfig.backgroundAlpha) / BackgroundScale};
+        if (yuvOutput) {
+            auto matrix{GetRgbToYuvMatrix()};
+            std::array<float, 4> yuv{};
+            for (size_t row{}; row < matrix.size(); row++)
+                yuv[row] = (matrix[row][0] * background[0]) + (matrix[row][1] * background[1]) + (matrix[row][2] * background[2]) + matrix[row][3];
+            yuv[3] = background[3];
+            background = yuv;
+        }
+
+        // Every texture is only locked and synchronized once regardless of how many planes or slots refer to it
+        std::vector<std::shared_ptr<gpu::Texture>> textures;
+        auto addTexture{[&](const gpu::TextureView &view) {
+            if (std::find(textures.begin(), textures.end(), view.backing) == textures.end())
+                textures.push_back(view.backing);
+        }};
+        for (auto &output : outputs)
+            addTexture(output);
+        for (auto &layer : layers) {
+            if (std::find_if(outputs.begin(), outputs.end(), [&](const gpu::TextureView &output) { return output.backing == layer.luma.backing || (layer.chroma && output.backing == layer.chroma->backing); }) != outputs.end()) [[unlikely]] {
+                Logger::Warn("VIC compositions from a slot into itself aren't supported");
+                return;
+            }
+            addTexture(layer.luma);
+            if (layer.chroma)
+                addTexture(*layer.chroma);
+        }
+
+        std::vector<std::unique_lock<gpu::Texture>> locks;
+        locks.reserve(textures.size());
+        for (auto &texture : textures)
+            locks.emplace_back(*texture);
+
+        auto &gpu{*state.gpu};
+        if (!compositionPass)
+            compositionPass.emplace(gpu);
+
+        auto cycle{gpu.scheduler.SubmitWithCycle([&](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<gpu::FenceCycle> &pCycle) {
+            for (auto &texture : textures) {
+                texture->RecordDeferredLayout(commandBuffer);
+                texture->SynchronizeHostWithBuffer(commandBuffer, pCycle);
+            }
+
+            for (size_t plane{}; plane < outputs.size(); plane++) {
+                if (yuvOutput) {
+                    for (auto &layer : layers) {
+                        auto matrix{GetColorMatrix(layer.chroma.has_value(), true)};
+                        layer.matrix = plane == 0 ? ColorMatrix{matrix[0]} : ColorMatrix{matrix[1], matrix[2]};
+                    }
+                }
+
+                auto clearColor{background};
+                if (yuvOutput)
+                    clearColor = plane == 0 ? std::array<float, 4>{background[0], 0.0f, 0.0f, background[3]} : std::array<float, 4>{background[1], background[2], 0.0f, background[3]};
+                compositionPass->Record(commandBuffer, pCycle, outputs[plane], clearColor, layers);
+            }
+
+            // The output is only copied back when the guest accesses it, presenting it through the display uses the host texture directly
+            for (auto &output : outputs)
+                output.backing->SynchronizeGuestWithBuffer(commandBuffer, pCycle);
+        })};
+
+        for (auto &texture : textures) {
+            cycle->AttachObject(texture);
+            texture->cycle = cycle;
+        }
+    }
 
     void VicClass::CallMethod(u32 method, u32 argument) {
-        Logger::Warn("Unknown VIC class method called: 0x{:X} argument: 0x{:X}", method, argument);
+        CallMethodBatch(method, span(&argument, 1), true);
+    }
+
+    void VicClass::CallMethodBatch(u32 method, span<u32> arguments, bool increment) {
+        if (method + (increment ? arguments.size() : 1) > RegisterCount) [[unlikely]] {
+            Logger::Warn("Out of bounds VIC class method batch called: 0x{:X} count: {}", method, arguments.size());
+            return;
+        }
+
+        if (increment)
+            span(registers).subspan(method).copy_from(arguments);
+        else
+            registers[method] = arguments.back();
+
+        // Execute is only ever written by itself after the composition's registers have been set up
+        if (increment ? (method <= ExecuteMethodId && ExecuteMethodId < method + arguments.size()) : method == ExecuteMethodId)
+            Execute();
     }
 }
@@ -4,18 +4,149 @@
 #pragma once
 
 #include <common.h>
+#include <gpu/composition_pass.h>
 
 namespace skyline::soc::host1x {
+    namespace vic {
+        constexpr size_t SlotCount{8}; //!< The amount of input slots that are composited into the output surface
+
+        /**
+         * @brief The pixel formats of VIC surfaces which are supported, the names are in the order of components within a word
+         */
+        enum class PixelFormat : u8 {
+            A8B8G8R8 = 0x1F, //!< R8G8B8A8 in memory
+            A8R8G8B8 = 0x20, //!< B8G8R8A8 in memory
+            Y8U8V8N420 = 0x44, //!< Semi-planar YUV 4:2:0 with a luma plane followed by a plane of interleaved U and V samples, this is the layout that NVDEC outputs
+        };
+
+        /**
+         * @brief The format, layout and dimensions of a surface, this is the same for the output surface and the surfaces of all slots
+         */
+        struct SurfaceConfig {
+            u64 pixelFormat : 7; //!< The PixelFormat of the surface
+            u64 chromaLocationHorizontal : 2;
+            u64 chromaLocationVertical : 2;
+            u64 blockKind : 4; //!< 0 if the surface is pitch linear, otherwise it's block linear
+            u64 blockHeightLog2 : 4; //!< The log2 of the height of a block in GOBs for block linear surfaces
+            u64 _pad0_ : 13;
+            u64 surfaceWidthMinus1 : 14;
+            u64 surfaceHeightMinus1 : 14;
+            u64 _pad1_ : 4;
+            u64 lumaWidthMinus1 : 14; //!< The width of the allocation of the luma plane in pixels, this is the pitch of pitch linear surfaces
+            u64 lumaHeightMinus1 : 14;
+            u64 _pad2_ : 4;
+            u64 chromaWidthMinus1 : 14; //!< The width of the allocation of the chroma plane in samples
+            u64 chromaHeightMinus1 : 14;
+            u64 _pad3_ : 4;
+        };
+        static_assert(sizeof(SurfaceConfig) == 0x10);
+
+        struct OutputConfig {
+            u64 alphaFillMode : 3;
+            u64 alphaFillSlot : 3;
+            u64 backgroundAlpha : 10; //!< The components of the background colour in 0.10 fixed point, regions that no slot is drawn to are filled with it
+            u64 backgroundRed : 10;
+            u64 backgroundGreen : 10;
+            u64 backgroundBlue : 10;
+            u64 _pad0_ : 18;
+            u64 _pad1_; //!< The target rectangle, the entire output surface is always composited into
+        };
+        static_assert(sizeof(OutputConfig) == 0x10);
+
+        struct SlotConfig {
+            u64 slotEnable : 1;
+            u64 _pad0_ : 63;
+            u64 _pad1_;
+            u64 _pad2_ : 32;
+            u64 planarAlpha : 10; //!< The alpha of the entire slot in 0.10 fixed point, this is only applied when constantAlpha is set
+            u64 constantAlpha : 1;
+            u64 _pad3_ : 21;
+            u64 _pad4_;
+            u64 sourceRectLeft : 30; //!< The region of the surface that's sampled in 16.16 fixed point, the right and bottom edges are inclusive
+            u64 _pad5_ : 2;
+            u64 sourceRectRight : 30;
+            u64 _pad6_ : 2;
+            u64 sourceRectTop : 30;
+            u64 _pad7_ : 2;
+            u64 sourceRectBottom : 30;
+            u64 _pad8_ : 2;
+            u64 destinationRectLeft : 14; //!< The region of the output surface that's drawn into in pixels, the right and bottom edges are inclusive
+            u64 _pad9_ : 2;
+            u64 destinationRectRight : 14;
+            u64 _pad10_ : 2;
+            u64 destinationRectTop : 14;
+            u64 _pad11_ : 2;
+            u64 destinationRectBottom : 14;
+            u64 _pad12_ : 2;
+            u64 _pad13_;
+        };
+        static_assert(sizeof(SlotConfig) == 0x40);
+
+        struct SlotStruct {
+            SlotConfig config;
+            SurfaceConfig surfaceConfig;
+            std::array<u64, 2> lumaKey;
+            std::array<u64, 4> colorMatrix; //!< The colour matrix of the slot, this isn't decoded as YUV samples are always converted with the limited range BT.601 matrix
+            std::array<u64, 4> gamutMatrix;
+            std::array<u64, 2> blending;
+        };
+        static_assert(sizeof(SlotStruct) == 0xB0);
+
+        /**
+         * @brief The configuration of a single composition which is read from the address in the SetConfigStructOffset method
+         */
+        struct ConfigStruct {
+            std::array<u64, 2> pipeConfig;
+            OutputConfig outputConfig;
+            SurfaceConfig outputSurfaceConfig;
+            std::array<u64, 4> outputColorMatrix;
+            std::array<u64, 8> clearRects;
+            std::array<SlotStruct, SlotCount> slots;
+        };
+        static_assert(offsetof(ConfigStruct, outputSurfaceConfig) == 0x20);
+        static_assert(offsetof(ConfigStruct, slots) == 0xA0);
+    }
+
     /**
      * @brief The VIC Host1x class implements hardware accelerated image operations
+     * @note Compositions are done on the host GPU with the surfaces as host textures, the output is only read back if the guest accesses it with the CPU rather than presenting it
      */
     class VicClass {
       private:
+        const DeviceState &state;
         std::function<void()> opDoneCallback;
 
+        static constexpr size_t RegisterCount{0x1000}; //!< The size of the method space of the class in words
+        std::array<u32, RegisterCount> registers{}; //!< The values written to every method of the class
+
+        std::optional<gpu::CompositionPass> compositionPass; //!< The pass that compositions are recorded with, this is created on the first composition as the GPU doesn't exist yet when the class is constructed
+
+        /**
+         * @return The SMMU address stored in the supplied register, addresses are written shifted right by 8 bits
+         */
+        u32 GetAddress(u32 method);
+
+        /**
+         * @return A view of the host texture for a single plane of a surface, or nothing if the plane can't be composited
+         * @param pitch The pitch of the plane in texels, this is only used for pitch linear surfaces
+         * @param output If the plane is composited into, it's looked up as a render target in that case
+         */
+        std::optional<gpu::TextureView> GetPlane(const vic::SurfaceConfig &config, u32 address, gpu::texture::Format format, gpu::texture::Dimensions dimensions, u32 pitch, bool output);
+
+        /**
+         * @brief Composites all enabled slots into the output surface as described by the current config struct
+         */
+        void Execute();
+
       public:
-        VicClass(std::function<void()> opDoneCallback);
+        VicClass(const DeviceState &state, std::function<void()> opDoneCallback);
 
         void CallMethod(u32 method, u32 argument);
+
+        /**
+         * @brief Calls a run of methods with the supplied arguments, register setup sequences are written in bulk rather than dispatched one method at a time
+         * @param increment If the method address should be incremented after every argument or stay the same
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment);
     };
 }
@@ -44,7 +44,7 @@ namespace skyline::soc::host1x {
     };
     static_assert(sizeof(ChannelCommandFifoMethodHeader) == sizeof(u32));
 
-    ChannelCommandFifo::ChannelCommandFifo(const DeviceState &state, SyncpointSet &syncpoints) : state(state), gatherQueue(GatherQueueSize), host1XClass(syncpoints), nvDecClass(syncpoints), vicClass(syncpoints) {}
+    ChannelCommandFifo::ChannelCommandFifo(const DeviceState &state, SyncpointSet &syncpoints) : state(state), gatherQueue(GatherQueueSize), host1XClass(syncpoints), nvDecClass(state, syncpoints), vicClass(state, syncpoints) {}
 
     void ChannelCommandFifo::Send(ClassId targetClass, u32 method, u32 argument) {
         Logger::Verbose("Calling method in class: 0x{:X}, method: 0x{:X}, argument: 0x{:X}", targetClass, method, argument);
@@ -65,6 +65,25 @@ namespace skyline::soc::host1x {
         }
     }
 
+    void ChannelCommandFifo::SendBatch(ClassId targetClass, u32 method, span<u32> arguments, bool increment) {
+        Logger::Verbose("Calling method batch in class: 0x{:X}, method: 0x{:X}, count: {}, increment: {}", targetClass, method, arguments.size(), increment);
+
+        switch (targetClass) {
+            case ClassId::Host1x:
+                host1XClass.CallMethodBatch(method, arguments, increment);
+                break;
+            case ClassId::NvDec:
+                nvDecClass.CallMethodBatch(method, arguments, increment);
+                break;
+            case ClassId::VIC:
+                vicClass.CallMethodBatch(method, arguments, increment);
+                break;
+            default:
+                Logger::Error("Sending method batch to unimplemented class: 0x{:X}", targetClass);
+                break;
+        }
+    }
+
     void ChannelCommandFifo::Process(span<u32> gather) {
         ClassId targetClass{ClassId::Host1x};
 
@@ -73,6 +92,9 @@ namespace skyline::soc::host1x {
 
             switch (methodHeader.opcode) {
                 case Host1xOpcode::SetClass:
+                    // Batched device class methods shouldn't be reordered past the methods of the new class
+                    nvDecClass.Flush();
+                    vicClass.Flush();
                     targetClass = methodHeader.classId;
 
                     for (u32 i{}; i < std::numeric_limits<u8>::max(); i++)
@@ -81,13 +103,14 @@ namespace skyline::soc::host1x {
 
                     break;
                 case Host1xOpcode::Incr:
-                    for (u32 i{}; i < methodHeader.methodCount; i++)
-                        Send(targetClass, methodHeader.methodAddress + i, *++entry);
-
-                    break;
                 case Host1xOpcode::NonIncr:
-                    for (u32 i{}; i < methodHeader.methodCount; i++)
-                        Send(targetClass, methodHeader.methodAddress, *++entry);
+                    if (methodHeader.methodCount) {
+                        if (static_cast<size_t>(std::distance(entry, gather.end())) <= methodHeader.methodCount) [[unlikely]]
+                            throw exception("Host1x method run exceeds the bounds of the gather: 0x{:X}", methodHeader.methodCount);
+
+                        SendBatch(targetClass, methodHeader.methodAddress, span(&*std::next(entry), methodHeader.methodCount), methodHeader.opcode == Host1xOpcode::Incr);
+                        entry += methodHeader.methodCount;
+                    }
 
                     break;
                 case Host1xOpcode::Mask:
@@ -103,6 +126,9 @@ namespace skyline::soc::host1x {
                     throw exception("Unimplemented Host1x command FIFO opcode: 0x{:X}", static_cast<u8>(methodHeader.opcode));
             }
         }
+
+        nvDecClass.Flush();
+        vicClass.Flush();
     }
 
     void ChannelCommandFifo::Start() {
@@ -135,6 +161,7 @@ namespace skyline::soc::host1x {
     }
 
     void ChannelCommandFifo::Push(span<u32> gather) {
+        std::scoped_lock lock(pushMutex);
         gatherQueue.Push(gather);
     }
 
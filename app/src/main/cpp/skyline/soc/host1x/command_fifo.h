@@ -4,7 +4,7 @@
 #pragma once
 
 #include <common.h>
-#include <common/circular_queue.h>
+#include <common/spsc_queue.h>
 #include "syncpoint.h"
 #include "classes/class.h"
 #include "classes/host1x.h"
@@ -22,7 +22,8 @@ namespace skyline::soc::host1x {
         const DeviceState &state;
 
         static constexpr size_t GatherQueueSize{0x1000}; //!< Maximum size of the gather queue, this value is arbritary
-        CircularQueue<span<u32>> gatherQueue;
+        SpscQueue<span<u32>> gatherQueue;
+        std::mutex pushMutex; //!< Serializes pushing gathers as multiple host1x channel devices may submit to the same channel, this makes the queue single-producer
         std::thread thread; //!< The thread that manages processing of pushbuffers within gathers
         std::mutex threadStartMutex; //!< Protects the thread from being started multiple times
 
@@ -35,6 +36,12 @@ namespace skyline::soc::host1x {
          */
         void Send(ClassId targetClass, u32 method, u32 argument);
 
+        /**
+         * @brief Sends a run of method calls to the target class in a single call
+         * @param increment If the method address should be incremented after every argument
+         */
+        void SendBatch(ClassId targetClass, u32 method, span<u32> arguments, bool increment);
+
         /**
          * @brief Processes the pushbuffer contained within the given gather, calling methods as needed
          */
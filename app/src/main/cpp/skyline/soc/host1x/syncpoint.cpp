@@ -5,6 +5,43 @@
 #include "syncpoint.h"
 
 namespace skyline::soc::host1x {
+    void Syncpoint::UpdateLowestThreshold() {
+        lowestThreshold.store(std::min(waiters.empty() ? std::numeric_limits<u32>::max() : waiters.front().threshold, intrusiveLowestThreshold));
+    }
+
+    void Syncpoint::UnlinkWaiter(SyncpointWaiter &waiter) {
+        if (waiter.previous)
+            waiter.previous->next = waiter.next;
+        else
+            intrusiveWaiters = waiter.next;
+        if (waiter.next)
+            waiter.next->previous = waiter.previous;
+
+        waiter.previous = waiter.next = nullptr;
+        waiter.registered = false;
+    }
+
+    bool Syncpoint::InsertWaiter(Waiter &&waiter) {
+        auto threshold{waiter.threshold}, id{waiter.id};
+        waiters.push_back(std::move(waiter));
+        std::push_heap(waiters.begin(), waiters.end());
+        UpdateLowestThreshold();
+
+        // An increment which happened before the threshold was published may have missed the waiter, both sides use sequentially consistent operations so at least one of them observes the other
+        if (value.load() < threshold)
+            return false;
+
+        // If the waiter isn't found then a concurrent increment took it and will handle it
+        auto it{std::find_if(waiters.begin(), waiters.end(), [id](const Waiter &entry) { return entry.id == id; })};
+        if (it == waiters.end())
+            return false;
+
+        waiters.erase(it);
+        std::make_heap(waiters.begin(), waiters.end());
+        UpdateLowestThreshold();
+        return true;
+    }
+
     Syncpoint::WaiterHandle Syncpoint::RegisterWaiter(u32 threshold, const std::function<void()> &callback) {
         if (value.load(std::memory_order_acquire) >= threshold) {
             // (Fast path) We don't need to wait on the mutex and can just get away with atomics
@@ -12,48 +49,135 @@ namespace skyline::soc::host1x {
             return {};
         }
 
-        std::scoped_lock lock(mutex);
-        if (value.load(std::memory_order_acquire) >= threshold) {
-            callback();
-            return {};
+        {
+            std::scoped_lock lock(mutex);
+            auto handle{nextWaiterId++};
+            if (!InsertWaiter(Waiter{threshold, handle, callback}))
+                return handle;
         }
 
-        auto it{waiters.begin()};
-        while (it != waiters.end() && threshold >= it->threshold)
-            it++;
-        return waiters.emplace(it, threshold, callback);
+        callback();
+        return {};
     }
 
     void Syncpoint::DeregisterWaiter(WaiterHandle waiter) {
-        std::scoped_lock lock(mutex);
-        // We want to ensure the iterator still exists prior to erasing it
-        // Otherwise, if an invalid iterator was passed in then it could lead to UB
-        // It is important to avoid UB in that case since the deregister isn't called from a locked context
-        for (auto it{waiters.begin()}; it != waiters.end(); it++)
-            if (it == waiter)
+        if (!waiter)
+            return;
+
+        {
+            std::scoped_lock lock(mutex);
+            auto it{std::find_if(waiters.begin(), waiters.end(), [waiter](const Waiter &entry) { return entry.id == waiter; })};
+            if (it != waiters.end()) {
                 waiters.erase(it);
+                std::make_heap(waiters.begin(), waiters.end());
+                UpdateLowestThreshold();
+                return;
+            }
+        }
+
+        // The waiter was already taken by an increment, its callback must have returned before the caller can safely destroy anything it refers to
+        u32 running;
+        while ((running = runningCallbacks.load(std::memory_order_acquire)))
+            runningCallbacks.wait(running, std::memory_order_acquire);
+    }
+
+    void Syncpoint::RegisterWaiter(SyncpointWaiter &waiter, u32 threshold) {
+        if (value.load(std::memory_order_acquire) >= threshold) {
+            waiter.OnThresholdReached();
+            return;
+        }
+
+        {
+            std::scoped_lock lock(mutex);
+            waiter.threshold = threshold;
+            waiter.previous = nullptr;
+            waiter.next = intrusiveWaiters;
+            if (intrusiveWaiters)
+                intrusiveWaiters->previous = &waiter;
+            intrusiveWaiters = &waiter;
+            waiter.registered = true;
+
+            intrusiveLowestThreshold = std::min(intrusiveLowestThreshold, threshold);
+            UpdateLowestThreshold();
+
+            // See InsertWaiter, if the waiter isn't registered anymore then a concurrent increment took it and will notify it
+            if (value.load() < threshold || !waiter.registered)
+                return;
+            UnlinkWaiter(waiter);
+        }
+
+        waiter.OnThresholdReached();
+    }
+
+    void Syncpoint::DeregisterWaiter(SyncpointWaiter &waiter) {
+        {
+            std::scoped_lock lock(mutex);
+            if (waiter.registered) {
+                UnlinkWaiter(waiter);
+                return;
+            }
+        }
+
+        u32 running;
+        while ((running = runningCallbacks.load(std::memory_order_acquire)))
+            runningCallbacks.wait(running, std::memory_order_acquire);
     }
 
     u32 Syncpoint::Increment() {
-        auto readValue{value.fetch_add(1, std::memory_order_acq_rel) + 1}; // We don't want to constantly do redundant atomic loads
+        auto readValue{value.fetch_add(1) + 1}; // We don't want to constantly do redundant atomic loads
+        if (readValue < lowestThreshold.load()) [[likely]]
+            return readValue; // (Fast path) No waiter is due, this is the case for the vast majority of increments
 
-        std::scoped_lock lock(mutex);
+        std::vector<std::function<void()>> callbacks;
+        SyncpointWaiter *dueWaiters{};
         bool signalCondition{};
-        auto it{waiters.begin()};
-        while (it != waiters.end() && readValue >= it->threshold) {
-            auto &waiter{*it};
-            if (waiter.callback)
-                waiter.callback();
-            else
-                signalCondition = true;
-            it++;
-        }
+        {
+            std::scoped_lock lock(mutex);
+            while (!waiters.empty() && readValue >= waiters.front().threshold) {
+                std::pop_heap(waiters.begin(), waiters.end());
+                auto &waiter{waiters.back()};
+                if (waiter.callback)
+                    callbacks.emplace_back(std::move(waiter.callback));
+                else
+                    signalCondition = true;
+                waiters.pop_back();
+            }
 
-        waiters.erase(waiters.begin(), it);
+            // Due embedded waiters are moved into a chain which is notified after unlocking, the lower bound of the remaining thresholds is exact again after this
+            intrusiveLowestThreshold = std::numeric_limits<u32>::max();
+            for (auto waiter{intrusiveWaiters}; waiter;) {
+                auto next{waiter->next};
+                if (readValue >= waiter->threshold) {
+                    UnlinkWaiter(*waiter);
+                    waiter->nextDue = dueWaiters;
+                    dueWaiters = waiter;
+                } else {
+                    intrusiveLowestThreshold = std::min(intrusiveLowestThreshold, waiter->threshold);
+                }
+                waiter = next;
+            }
+            UpdateLowestThreshold();
+
+            if (!callbacks.empty() || dueWaiters)
+                runningCallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
 
         if (signalCondition)
             incrementCondition.notify_all();
 
+        if (!callbacks.empty() || dueWaiters) {
+            for (const auto &callback : callbacks)
+                callback();
+            for (auto waiter{dueWaiters}; waiter;) {
+                auto next{waiter->nextDue}; // The waiter may be reused as soon as it's notified
+                waiter->OnThresholdReached();
+                waiter = next;
+            }
+
+            runningCallbacks.fetch_sub(1, std::memory_order_release);
+            runningCallbacks.notify_all();
+        }
+
         return readValue;
     }
 
@@ -63,10 +187,8 @@ namespace skyline::soc::host1x {
             return {};
 
         std::unique_lock lock(mutex);
-        auto it{waiters.begin()};
-        while (it != waiters.end() && threshold >= it->threshold)
-            it++;
-        waiters.emplace(it, threshold, nullptr);
+        if (InsertWaiter(Waiter{threshold, nextWaiterId++, nullptr}))
+            return true;
 
         if (timeout == std::chrono::steady_clock::duration::max()) {
             incrementCondition.wait(lock, [&] { return value.load(std::memory_order_relaxed) >= threshold; });
@@ -76,4 +198,3 @@ namespace skyline::soc::host1x {
         }
     }
 }
-
@@ -9,23 +9,79 @@
 namespace skyline::soc::host1x {
     constexpr size_t SyncpointCount{192}; //!< The number of host1x syncpoints on T210
 
+    class Syncpoint;
+
+    /**
+     * @brief A waiter which is embedded into the object that waits on a syncpoint, registering and deregistering it neither allocates nor searches through other waiters
+     */
+    class SyncpointWaiter {
+      private:
+        friend Syncpoint;
+
+        SyncpointWaiter *previous{}; //!< The previous waiter in the intrusive list of the syncpoint
+        SyncpointWaiter *next{}; //!< The next waiter in the intrusive list of the syncpoint
+        SyncpointWaiter *nextDue{}; //!< The next waiter in the chain of waiters which an increment is calling
+        u32 threshold{};
+        bool registered{}; //!< If the waiter is linked into the list of a syncpoint
+
+      public:
+        virtual ~SyncpointWaiter() = default;
+
+        /**
+         * @brief Called when the syncpoint reaches the threshold of the waiter, this is called without any locks held from the thread that incremented the syncpoint
+         */
+        virtual void OnThresholdReached() = 0;
+    };
+
     /**
      * @brief The Syncpoint class represents a single syncpoint in the GPU which is used for GPU -> CPU synchronisation
+     * @note Waiters are kept in a min-heap ordered by threshold with the lowest threshold cached in an atomic, an increment which doesn't reach it is only a pair of atomic operations
      */
     class Syncpoint {
       private:
         std::atomic<u32> value{}; //!< An atomically-incrementing counter at the core of a syncpoint
+        std::atomic<u32> lowestThreshold{std::numeric_limits<u32>::max()}; //!< The lowest threshold of any waiter, this is the maximum value if there are no waiters
 
         std::mutex mutex; //!< Synchronizes insertions and deletions of waiters alongside locking the increment condition
         std::condition_variable incrementCondition; //!< Signalled on thresholds for waiters which are tied to Wait(...)
+        std::atomic<u32> runningCallbacks{}; //!< The amount of increments which are running due callbacks outside of the lock
 
         struct Waiter {
             u32 threshold; //!< The syncpoint value to wait on to be reached
+            u64 id; //!< A unique identifier for the waiter, this is used as the handle of waiters with a callback
             std::function<void()> callback; //!< The callback to do after the wait has ended, refers to cvar signal when nullptr
 
-            Waiter(u32 threshold, std::function<void()> callback) : threshold(threshold), callback(std::move(callback)) {}
+            /**
+             * @brief Orders waiters such that the standard heap algorithms form a min-heap by threshold
+             */
+            bool operator<(const Waiter &other) const {
+                return threshold > other.threshold;
+            }
         };
-        std::list<Waiter> waiters; //!< A linked list of all waiters, it's sorted in ascending order by threshold
+        std::vector<Waiter> waiters; //!< A min-heap of all waiters by threshold
+        u64 nextWaiterId{1};
+
+        SyncpointWaiter *intrusiveWaiters{}; //!< The head of an unsorted intrusive list of embedded waiters
+        u32 intrusiveLowestThreshold{std::numeric_limits<u32>::max()}; //!< A lower bound of the thresholds of all embedded waiters, this is only recalculated by increments as deregistration doesn't affect its correctness
+
+        /**
+         * @brief Updates the cached lowest threshold after the waiters were modified
+         * @note The mutex MUST be locked when calling this
+         */
+        void UpdateLowestThreshold();
+
+        /**
+         * @brief Unlinks an embedded waiter from the intrusive list
+         * @note The mutex MUST be locked when calling this
+         */
+        void UnlinkWaiter(SyncpointWaiter &waiter);
+
+        /**
+         * @brief Inserts a waiter into the heap
+         * @return If the syncpoint had already reached the threshold after the waiter was published and it was removed again, the caller must handle the waiter in this case
+         * @note The mutex MUST be locked when calling this
+         */
+        bool InsertWaiter(Waiter &&waiter);
 
       public:
         /**
@@ -35,20 +91,34 @@ namespace skyline::soc::host1x {
             return value.load(std::memory_order_acquire);
         }
 
-        using WaiterHandle = decltype(waiters)::iterator; //!< Aliasing an iterator to a Waiter as an opaque handle
+        using WaiterHandle = u64; //!< An opaque handle to a waiter, 0 is an invalid handle
 
         /**
          * @brief Registers a new waiter with a callback that will be called when the syncpoint reaches the target threshold
          * @note The callback will be called immediately if the syncpoint has already reached the given threshold
-         * @return A handle that can be used to deregister the waiter, its boolean operator will evaluate to false if the threshold has already been reached
+         * @note Callbacks are called without any locks held, they may be called from any thread that increments the syncpoint
+         * @return A handle that can be used to deregister the waiter, this will be invalid if the threshold has already been reached
          */
         WaiterHandle RegisterWaiter(u32 threshold, const std::function<void()> &callback);
 
         /**
          * @note If the supplied handle is invalid then the function will do nothing
+         * @note If the waiter's callback is already being called then this waits for it to return
          */
         void DeregisterWaiter(WaiterHandle waiter);
 
+        /**
+         * @brief Registers an embedded waiter which is notified when the syncpoint reaches the target threshold
+         * @note The waiter will be notified immediately if the syncpoint has already reached the given threshold
+         * @note The waiter must not be registered on any syncpoint already and it must be deregistered prior to being destroyed
+         */
+        void RegisterWaiter(SyncpointWaiter &waiter, u32 threshold);
+
+        /**
+         * @note This does nothing if the waiter isn't registered, if it's being notified then this waits for it to return
+         */
+        void DeregisterWaiter(SyncpointWaiter &waiter);
+
         /**
          * @return The new value of the syncpoint after the increment
          */
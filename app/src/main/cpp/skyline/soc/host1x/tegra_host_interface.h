@@ -18,8 +18,14 @@ namespace skyline::soc::host1x {
         SyncpointSet &syncpoints;
         ClassType deviceClass; //!< The device class behind the THI, such as NVDEC or VIC
 
+        static constexpr u32 Method0MethodId{0x10}; //!< Sets the method to be called on the device class upon a call to Method1, see TRM '15.5.6 NV_PVIC_THI_METHOD0'
+        static constexpr u32 Method1MethodId{0x11}; //!< Calls the method set by Method1 with the supplied argument, see TRM '15.5.7 NV_PVIC_THI_METHOD1"
+
         u32 storedMethod{}; //!< Method that will be used for deviceClass.CallMethod, set using Method0
 
+        u32 pendingMethod{}; //!< The first method of the run of device class method calls in `pendingArguments`
+        std::vector<u32> pendingArguments; //!< The arguments of consecutive device class methods which were called through Method0/Method1 pairs but haven't been sent to the device class yet
+
         std::queue<u32> incrQueue; //!< Queue of syncpoint IDs to be incremented when a device operation is finished, the same syncpoint may be held multiple times within the queue
         std::mutex incrMutex;
 
@@ -36,17 +42,27 @@ namespace skyline::soc::host1x {
         }
 
       public:
-        TegraHostInterface(SyncpointSet &syncpoints)
-            : deviceClass([&] { SubmitPendingIncrs(); }),
+        TegraHostInterface(const DeviceState &state, SyncpointSet &syncpoints)
+            : deviceClass(state, [&] { SubmitPendingIncrs(); }),
               syncpoints(syncpoints) {}
 
-        void CallMethod(u32 method, u32 argument)  {
-            constexpr u32 Method0MethodId{0x10}; //!< Sets the method to be called on the device class upon a call to Method1, see TRM '15.5.6 NV_PVIC_THI_METHOD0'
-            constexpr u32 Method1MethodId{0x11}; //!< Calls the method set by Method1 with the supplied argument, see TRM '15.5.7 NV_PVIC_THI_METHOD1"
+        /**
+         * @brief Sends any pending device class method calls to the device class in a single batch
+         * @note This must be called at the end of every gather so method calls don't linger till the next one
+         */
+        void Flush() {
+            if (pendingArguments.empty())
+                return;
+
+            deviceClass.CallMethodBatch(pendingMethod, pendingArguments, true);
+            pendingArguments.clear();
+        }
 
+        void CallMethod(u32 method, u32 argument)  {
             switch (method) {
                 case IncrementSyncpointMethodId: {
                     IncrementSyncpointMethod incrSyncpoint{.raw = argument};
+                    Flush(); // Any prior operations must be submitted before the syncpoint guarding them is incremented
 
                     switch (incrSyncpoint.condition) {
                         case IncrementSyncpointMethod::Condition::Immediate:
@@ -68,12 +84,33 @@ namespace skyline::soc::host1x {
                     storedMethod = argument;
                     break;
                 case Method1MethodId:
-                    deviceClass.CallMethod(storedMethod, argument);
+                    // Register setup sequences consist of Method0/Method1 pairs for consecutive methods, these are coalesced into a single batch
+                    if (!pendingArguments.empty() && storedMethod != pendingMethod + pendingArguments.size())
+                        Flush();
+                    if (pendingArguments.empty())
+                        pendingMethod = storedMethod;
+                    pendingArguments.push_back(argument);
                     break;
                 default:
                     Logger::Error("Unknown THI method called: 0x{:X}, argument: 0x{:X}", method, argument);
                     break;
             }
         }
+
+        /**
+         * @brief Calls a run of THI methods with the supplied arguments
+         * @param increment If the method address should be incremented after every argument or stay the same
+         */
+        void CallMethodBatch(u32 method, span<u32> arguments, bool increment) {
+            if (!increment && method == Method1MethodId) {
+                // Repeated writes to Method1 all call the same stored method so they can be forwarded to the device class as-is
+                Flush();
+                deviceClass.CallMethodBatch(storedMethod, arguments, false);
+                return;
+            }
+
+            for (u32 index{}; index < arguments.size(); index++)
+                CallMethod(increment ? method + index : method, arguments[index]);
+        }
     };
 }
@@ -3,6 +3,7 @@
 
 #include <android/asset_manager.h>
 #include "android_asset_backing.h"
+#include "buffered_backing.h"
 #include "android_asset_filesystem.h"
 
 namespace skyline::vfs {
@@ -13,7 +14,8 @@ namespace skyline::vfs {
         if (file == nullptr)
             return nullptr;
 
-        return file ? std::make_shared<AndroidAssetBacking>(file, mode) : nullptr;
+        // Every read of an asset requires a seek and a read, coalescing them avoids paying for both on each small read
+        return std::make_shared<BufferedBacking>(std::make_shared<AndroidAssetBacking>(file, mode));
     }
 
     std::optional<Directory::EntryType> AndroidAssetFileSystem::GetEntryTypeImpl(const std::string &path) {
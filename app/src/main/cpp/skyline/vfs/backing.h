@@ -22,6 +22,12 @@ namespace skyline::vfs {
             throw exception("This backing does not support being resized");
         }
 
+        virtual std::optional<span<u8>> MapImpl(size_t offset, size_t mapSize) {
+            return std::nullopt;
+        }
+
+        virtual void FlushImpl() {}
+
       public:
         union Mode {
             struct {
@@ -100,6 +106,21 @@ namespace skyline::vfs {
             return object;
         }
 
+        /**
+         * @brief Provides direct access to the data of the backing without copying it, this is only supported by backings which hold their data in memory and don't have to process it on reads
+         * @return A span of the data which is valid for the lifetime of the backing or std::nullopt if the backing doesn't support mapping, Read should be used in that case
+         * @note The span must never be written to as the underlying memory may be read-only
+         */
+        std::optional<span<u8>> Map(size_t offset, size_t mapSize) {
+            if (!mode.read)
+                throw exception("Attempting to map a backing that is not readable");
+
+            if (offset > size || (size - offset) < mapSize)
+                throw exception("Trying to map past the end of a backing: 0x{:X}/0x{:X} (Offset: 0x{:X})", mapSize, size, offset);
+
+            return MapImpl(offset, mapSize);
+        }
+
         /**
          * @brief Writes from a buffer to a particular offset in the backing
          * @param input The data to write to the backing
@@ -139,5 +160,12 @@ namespace skyline::vfs {
         void Resize(size_t pSize) {
             ResizeImpl(pSize);
         }
+
+        /**
+         * @brief Writes back any data which has been buffered by the backing and waits for it to reach the underlying storage
+         */
+        void Flush() {
+            FlushImpl();
+        }
     };
 }
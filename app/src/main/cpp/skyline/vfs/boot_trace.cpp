@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "cache_directory.h"
+#include "cached_backing.h"
+#include "boot_trace.h"
+
+namespace skyline::vfs {
+    void BootTrace::Run(std::shared_ptr<CacheDirectory> directory, std::string name) {
+        pthread_setname_np(pthread_self(), "Sky-BootTrace");
+        auto deadline{std::chrono::steady_clock::now() + RecordDuration};
+
+        if (auto payload{directory->Load(name, TraceMagic, TraceVersion)}; payload && payload->size() % sizeof(Entry) == 0)
+            Prefetch(span(reinterpret_cast<const Entry *>(payload->data()), payload->size() / sizeof(Entry)));
+
+        {
+            std::unique_lock lock(threadMutex);
+            if (stopCondition.wait_until(lock, deadline, [this]() { return stop; }))
+                return;
+        }
+
+        std::vector<Entry> entries;
+        {
+            std::scoped_lock lock(recordMutex);
+            recording.store(false, std::memory_order_relaxed);
+            entries = std::move(recordedEntries);
+            recordedEntries.clear();
+            recordedSet.clear();
+        }
+
+        Logger::Info("Recorded {} blocks read during boot", entries.size());
+        directory->Store(name, TraceMagic, TraceVersion, span(entries).cast<const u8>());
+    }
+
+    void BootTrace::Prefetch(span<const Entry> entries) {
+        auto &cache{BlockCache::Get()};
+        // Only half of the cache is filled so the prefetched blocks don't evict everything the guest has read in the meantime
+        size_t budget{cache.GetBudget() / 2}, prefetched{}, blockCount{};
+        for (const auto &entry : entries) {
+            {
+                std::scoped_lock lock(threadMutex);
+                if (stop)
+                    break;
+            }
+
+            Source source;
+            {
+                std::scoped_lock lock(sourceMutex);
+                auto it{sources.find(entry.traceKey)};
+                if (it == sources.end())
+                    continue;
+                source = it->second;
+            }
+
+            size_t blockStart{entry.blockIndex * BlockCache::BlockSize};
+            if (blockStart >= source.backing->size)
+                continue;
+
+            std::vector<u8> block(std::min(BlockCache::BlockSize, source.backing->size - blockStart));
+            try {
+                if (source.backing->ReadUnchecked(block, blockStart) != block.size())
+                    continue;
+            } catch (const std::exception &e) {
+                Logger::Warn("Failed to prefetch block {} of a traced backing: {}", entry.blockIndex, e.what());
+                break;
+            }
+
+            // If the CachedBacking was destroyed in the meantime the block is orphaned, it can never be served as backing IDs aren't reused and is evicted like any other block
+            prefetched += block.size();
+            blockCount++;
+            cache.Insert(source.backingId, entry.blockIndex, std::move(block));
+            if (prefetched >= budget)
+                break;
+        }
+
+        Logger::Info("Prefetched {} out of {} blocks read during the previous boot", blockCount, entries.size());
+    }
+
+    void BootTrace::RecordAccess(u64 traceKey, u64 blockIndex) {
+        std::scoped_lock lock(recordMutex);
+        if (!recording.load(std::memory_order_relaxed) || recordedEntries.size() >= MaxRecordedBlocks)
+            return;
+
+        Entry entry{traceKey, blockIndex};
+        if (recordedSet.insert(entry).second)
+            recordedEntries.push_back(entry);
+    }
+
+    void BootTrace::Start(const std::string &path, u64 titleId) {
+        Stop();
+        if (!BlockCache::Get().IsEnabled())
+            return;
+
+        std::shared_ptr<CacheDirectory> directory;
+        try {
+            directory = std::make_shared<CacheDirectory>(path);
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to open the boot trace directory at '{}': {}", path, e.what());
+            return;
+        }
+
+        {
+            std::scoped_lock lock(threadMutex);
+            stop = false;
+        }
+        recording.store(true, std::memory_order_relaxed);
+        thread = std::thread(&BootTrace::Run, this, std::move(directory), util::Format("{}_boot_trace.bin", CacheDirectory::GetTitleKey(titleId)));
+    }
+
+    void BootTrace::Stop() {
+        {
+            std::scoped_lock lock(threadMutex);
+            stop = true;
+        }
+        stopCondition.notify_all();
+        if (thread.joinable())
+            thread.join();
+
+        std::scoped_lock lock(recordMutex);
+        recording.store(false, std::memory_order_relaxed);
+        recordedEntries.clear();
+        recordedSet.clear();
+    }
+
+    void BootTrace::RegisterBacking(u64 traceKey, u64 backingId, std::shared_ptr<Backing> backing) {
+        std::scoped_lock lock(sourceMutex);
+        sources.insert_or_assign(traceKey, Source{backingId, std::move(backing)});
+    }
+
+    void BootTrace::UnregisterBacking(u64 traceKey, u64 backingId) {
+        std::scoped_lock lock(sourceMutex);
+        // Another backing with identical contents may have replaced this one in the meantime, it's left registered in that case
+        if (auto it{sources.find(traceKey)}; it != sources.end() && it->second.backingId == backingId)
+            sources.erase(it);
+    }
+}
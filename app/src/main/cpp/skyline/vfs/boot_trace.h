@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <thread>
+#include <condition_variable>
+#include <unordered_set>
+#include "backing.h"
+
+namespace skyline::vfs {
+    class CacheDirectory;
+
+    /**
+     * @brief Records which blocks of traced CachedBackings are read during the start of a boot and prefetches the same blocks into the BlockCache on subsequent boots of the title
+     * @note Backings are identified by a trace key which is derived from their contents by the creator of the backing, this stays stable across boots unlike their BlockCache IDs
+     * @note Prefetching reads the backing underneath a CachedBacking and inserts the result into the BlockCache directly, this avoids prefetched reads being recorded as accesses of the guest
+     */
+    class BootTrace {
+      private:
+        static constexpr u32 TraceMagic{util::MakeMagic<u32>("SKBT")}; //!< "SKBT" - Skyline Boot Trace
+        static constexpr u32 TraceVersion{1};
+        static constexpr std::chrono::seconds RecordDuration{30}; //!< The duration from the start of the trace during which accesses are recorded
+        static constexpr size_t MaxRecordedBlocks{0x4000}; //!< The maximum amount of blocks in a single trace, any further accesses are dropped
+
+        struct Entry {
+            u64 traceKey;
+            u64 blockIndex;
+
+            bool operator==(const Entry &) const = default;
+        };
+
+        struct EntryHash {
+            size_t operator()(const Entry &entry) const {
+                return std::hash<u64>{}(entry.traceKey ^ (entry.blockIndex * 0x9E3779B97F4A7C15));
+            }
+        };
+
+        /**
+         * @brief A traced backing which blocks can be prefetched from
+         */
+        struct Source {
+            u64 backingId; //!< The ID of the CachedBacking in the BlockCache
+            std::shared_ptr<Backing> backing; //!< The backing underneath the CachedBacking
+        };
+
+        std::mutex sourceMutex; //!< Synchronizes access to the sources
+        std::unordered_map<u64, Source> sources; //!< A map from the trace key of all live traced backings to their source
+
+        std::atomic<bool> recording{}; //!< If accesses are currently being recorded, this is checked prior to locking the record mutex
+        std::mutex recordMutex; //!< Synchronizes access to the recorded entries
+        std::vector<Entry> recordedEntries; //!< All recorded accesses in the order of their first occurrence
+        std::unordered_set<Entry, EntryHash> recordedSet; //!< The set of all recorded accesses to deduplicate them
+
+        std::mutex threadMutex; //!< Synchronizes the state of the trace thread
+        std::condition_variable stopCondition;
+        bool stop{}; //!< If the trace thread should exit as soon as possible
+        std::thread thread;
+
+        BootTrace() = default;
+
+        /**
+         * @brief Prefetches the blocks of a previous trace and stores a new trace once the record duration has elapsed
+         */
+        void Run(std::shared_ptr<CacheDirectory> directory, std::string name);
+
+        /**
+         * @brief Reads the supplied blocks into the BlockCache in order till the prefetch budget is exhausted or the thread is stopped
+         */
+        void Prefetch(span<const Entry> entries);
+
+        /**
+         * @brief Appends an access to the recorded entries if it hasn't been recorded before
+         */
+        void RecordAccess(u64 traceKey, u64 blockIndex);
+
+      public:
+        /**
+         * @note The trace is intentionally leaked as backings may be destroyed during static destruction
+         */
+        static BootTrace &Get() {
+            static auto *trace{new BootTrace()};
+            return *trace;
+        }
+
+        /**
+         * @brief Starts recording accesses and prefetching the blocks recorded during the previous boot of the title on a background thread
+         * @param path The directory holding the traces of all titles
+         * @note Any trace which is still in progress is stopped beforehand, this is a no-op while the BlockCache is disabled as prefetched blocks would be discarded
+         */
+        void Start(const std::string &path, u64 titleId);
+
+        /**
+         * @brief Stops recording and prefetching, the recorded accesses are discarded if the record duration hasn't elapsed yet as the trace wouldn't cover the entire boot
+         */
+        void Stop();
+
+        /**
+         * @brief Registers a CachedBacking so blocks from a trace can be prefetched into it
+         * @param traceKey A key derived from the contents of the backing, this must be non-zero
+         * @param backing The backing underneath the CachedBacking
+         */
+        void RegisterBacking(u64 traceKey, u64 backingId, std::shared_ptr<Backing> backing);
+
+        /**
+         * @brief Unregisters a CachedBacking, this must be called before it's destroyed
+         */
+        void UnregisterBacking(u64 traceKey, u64 backingId);
+
+        /**
+         * @brief Records an access of a block of a traced backing if recording is active
+         */
+        void Record(u64 traceKey, u64 blockIndex) {
+            if (recording.load(std::memory_order_relaxed)) [[unlikely]]
+                RecordAccess(traceKey, blockIndex);
+        }
+    };
+}
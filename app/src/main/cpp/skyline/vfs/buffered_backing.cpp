@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "buffered_backing.h"
+
+namespace skyline::vfs {
+    BufferedBacking::BufferedBacking(std::shared_ptr<Backing> pBacking, size_t windowSize) : Backing(pBacking->mode, pBacking->size), backing(std::move(pBacking)), windowSize(windowSize) {
+        if (mode.write || mode.append)
+            throw exception("Cannot open a BufferedBacking as writable");
+        if (!windowSize || (windowSize & (windowSize - 1)))
+            throw exception("The window size of a BufferedBacking must be a power of two: 0x{:X}", windowSize);
+    }
+
+    size_t BufferedBacking::ReadImpl(span<u8> output, size_t offset) {
+        std::scoped_lock lock(mutex);
+        size_t read{};
+        while (read < output.size() && offset < size) {
+            auto remaining{output.subspan(read)};
+            if (offset < windowOffset || offset >= windowOffset + window.size()) {
+                if (remaining.size() >= windowSize)
+                    return read + backing->ReadUnchecked(remaining, offset);
+
+                windowOffset = offset & ~(windowSize - 1);
+                window.resize(std::min(windowSize, size - windowOffset));
+                window.resize(backing->ReadUnchecked(window, windowOffset));
+                if (offset >= windowOffset + window.size()) [[unlikely]]
+                    break; // The underlying backing returned less data than its size, there's nothing more to read
+            }
+
+            size_t chunkSize{std::min(remaining.size(), windowOffset + window.size() - offset)};
+            std::memcpy(remaining.data(), window.data() + (offset - windowOffset), chunkSize);
+            read += chunkSize;
+            offset += chunkSize;
+        }
+        return read;
+    }
+}
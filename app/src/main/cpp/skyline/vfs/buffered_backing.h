@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A read-only backing which coalesces small reads into large aligned reads of an underlying backing, this is intended for backings with a high fixed cost per read such as files exposed through the storage access framework
+     * @note Reads that are at least as large as the window are passed through directly as there's nothing to gain from buffering them
+     * @note Reads are serialized by a mutex, this makes it safe to share backings which aren't thread-safe themselves
+     */
+    class BufferedBacking : public Backing {
+      private:
+        std::shared_ptr<Backing> backing;
+        std::mutex mutex; //!< Synchronizes access to the window and the underlying backing
+        std::vector<u8> window; //!< The buffered data starting at windowOffset, this may be smaller than the window size at the end of the backing
+        size_t windowOffset{}; //!< The aligned offset of the buffered data in the backing
+        size_t windowSize; //!< The size and alignment of the reads performed on the underlying backing
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+      public:
+        /**
+         * @param windowSize The size of the reads performed on the underlying backing, this must be a power of two
+         */
+        BufferedBacking(std::shared_ptr<Backing> backing, size_t windowSize = 0x100000);
+    };
+}
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#include "os_filesystem.h"
+#include "cache_directory.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A file descriptor which is closed when it goes out of scope
+     */
+    struct ScopedFd {
+        int fd;
+
+        ~ScopedFd() {
+            if (fd >= 0)
+                close(fd);
+        }
+    };
+
+    /**
+     * @brief Calls the supplied function with the name and status of every regular file in a directory
+     * @note A failure to open the directory is logged and treated as the directory being empty
+     */
+    template<typename Function>
+    static void ForEachFile(const std::string &path, Function function) {
+        auto directory{opendir(path.c_str())};
+        if (!directory) {
+            Logger::Warn("Failed to open the cache directory '{}': {}", path, strerror(errno));
+            return;
+        }
+
+        while (auto entry{readdir(directory)}) {
+            struct stat status;
+            if (entry->d_type == DT_DIR || fstatat(dirfd(directory), entry->d_name, &status, 0) || !S_ISREG(status.st_mode))
+                continue;
+            function(std::string_view(entry->d_name), status);
+        }
+        closedir(directory);
+    }
+
+    static bool ReadFully(int fd, void *buffer, size_t size, off_t offset) {
+        auto pointer{static_cast<u8 *>(buffer)};
+        while (size) {
+            auto ret{pread(fd, pointer, size, offset)};
+            if (ret <= 0)
+                return false;
+            pointer += ret;
+            offset += ret;
+            size -= static_cast<size_t>(ret);
+        }
+        return true;
+    }
+
+    static bool WriteFully(int fd, const void *buffer, size_t size) {
+        auto pointer{static_cast<const u8 *>(buffer)};
+        while (size) {
+            auto ret{write(fd, pointer, size)};
+            if (ret <= 0)
+                return false;
+            pointer += ret;
+            size -= static_cast<size_t>(ret);
+        }
+        return true;
+    }
+
+    CacheDirectory::CacheDirectory(std::string pPath, size_t budget) : path(pPath.ends_with('/') ? std::move(pPath) : std::move(pPath) + '/'), budget(budget) {
+        OsFileSystem{path}; // This creates the directory if it doesn't exist yet
+
+        // Temporary files can only be left behind by writes that were interrupted, they're never going to be completed
+        size_t size{};
+        ForEachFile(path, [&](std::string_view name, const struct stat &status) {
+            if (name.ends_with(TemporarySuffix))
+                unlink((path + std::string(name)).c_str());
+            else
+                size += static_cast<size_t>(status.st_size);
+        });
+        usage = size;
+
+        if (budget && size > budget)
+            Trim();
+    }
+
+    std::string CacheDirectory::GetTitleKey(u64 titleId) {
+        return util::Format("{:016X}", titleId);
+    }
+
+    std::string CacheDirectory::GetBuildKey(const std::array<u64, 4> &buildId) {
+        return util::Format("{:016X}{:016X}{:016X}{:016X}", util::SwapEndianness(buildId[0]), util::SwapEndianness(buildId[1]), util::SwapEndianness(buildId[2]), util::SwapEndianness(buildId[3]));
+    }
+
+    void CacheDirectory::Trim() {
+        std::scoped_lock lock(trimMutex);
+
+        struct Entry {
+            std::string name;
+            size_t size;
+            timespec lastUse;
+        };
+        std::vector<Entry> entries;
+        size_t size{};
+        ForEachFile(path, [&](std::string_view name, const struct stat &status) {
+            if (name.ends_with(TemporarySuffix))
+                return;
+            entries.push_back(Entry{std::string(name), static_cast<size_t>(status.st_size), status.st_mtim});
+            size += static_cast<size_t>(status.st_size);
+        });
+
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return std::tie(a.lastUse.tv_sec, a.lastUse.tv_nsec) < std::tie(b.lastUse.tv_sec, b.lastUse.tv_nsec);
+        });
+
+        // The directory is trimmed to 3/4 of its budget so it isn't trimmed again by the next few stores
+        size_t target{budget - (budget / 4)};
+        size_t evicted{};
+        for (auto it{entries.begin()}; it != entries.end() && size > target; it++) {
+            if (unlink((path + it->name).c_str()) == 0) {
+                size -= it->size;
+                evicted++;
+            }
+        }
+
+        usage = size;
+        if (evicted)
+            Logger::Debug("Evicted {} entries from the cache directory '{}'", evicted, path);
+    }
+
+    std::optional<std::vector<u8>> CacheDirectory::Load(const std::string &name, u32 magic, u32 version) {
+        auto entryPath{path + name};
+        ScopedFd file{open(entryPath.c_str(), O_RDWR | O_CLOEXEC)};
+        if (file.fd < 0) {
+            if (errno != ENOENT)
+                Logger::Warn("Failed to open cache entry '{}': {}", entryPath, strerror(errno));
+            return std::nullopt;
+        }
+
+        struct stat status;
+        EntryHeader header{};
+        if (fstat(file.fd, &status) || static_cast<size_t>(status.st_size) < sizeof(EntryHeader) || !ReadFully(file.fd, &header, sizeof(EntryHeader), 0) || header.magic != magic || header.version != version || header.size != static_cast<size_t>(status.st_size) - sizeof(EntryHeader)) {
+            // Entries from older versions of a format or other subsystems can never be used, they're deleted so they don't take up space in the budget
+            Logger::Debug("Deleting invalid or outdated cache entry '{}'", entryPath);
+            unlink(entryPath.c_str());
+            return std::nullopt;
+        }
+
+        std::vector<u8> payload(header.size);
+        if (!ReadFully(file.fd, payload.data(), payload.size(), sizeof(EntryHeader)) || XXH64(payload.data(), payload.size(), 0) != header.hash) {
+            Logger::Warn("Deleting corrupted cache entry '{}'", entryPath);
+            unlink(entryPath.c_str());
+            return std::nullopt;
+        }
+
+        futimens(file.fd, nullptr); // The modification time is used as the last use time for LRU eviction
+        return payload;
+    }
+
+    void CacheDirectory::Store(const std::string &name, u32 magic, u32 version, span<const u8> payload) {
+        auto entryPath{path + name};
+        auto temporaryPath{util::Format("{}.{}{}", entryPath, nextTemporaryId.fetch_add(1, std::memory_order_relaxed), TemporarySuffix)};
+
+        bool written;
+        {
+            ScopedFd file{open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR)};
+            if (file.fd < 0) {
+                Logger::Warn("Failed to create cache entry '{}': {}", entryPath, strerror(errno));
+                return;
+            }
+
+            EntryHeader header{
+                .magic = magic,
+                .version = version,
+                .size = payload.size(),
+                .hash = XXH64(payload.data(), payload.size(), 0),
+            };
+            written = WriteFully(file.fd, &header, sizeof(EntryHeader)) && WriteFully(file.fd, payload.data(), payload.size());
+        }
+
+        if (!written || rename(temporaryPath.c_str(), entryPath.c_str())) {
+            Logger::Warn("Failed to write cache entry '{}': {}", entryPath, strerror(errno));
+            unlink(temporaryPath.c_str());
+            return;
+        }
+
+        // Replaced entries are counted twice, this only makes trimming slightly more eager as the usage is recalculated during it
+        auto newUsage{usage.fetch_add(sizeof(EntryHeader) + payload.size(), std::memory_order_relaxed) + sizeof(EntryHeader) + payload.size()};
+        if (budget && newUsage > budget)
+            Trim();
+    }
+}
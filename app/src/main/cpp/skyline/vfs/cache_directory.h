@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::vfs {
+    /**
+     * @brief A directory of persistent cache entries, this handles the file management shared by all subsystems which store derived data on disk
+     * @note Every entry is prefixed with a header holding the magic and version of the format the subsystem wrote it with alongside a hash of the payload, entries that don't match any of these are deleted on lookup
+     * @note Entries are written to a temporary file which is renamed over the entry, a concurrent or interrupted write therefore never leaves behind a partially written entry
+     * @note If the directory exceeds its size budget the least recently used entries are evicted, an entry is marked as used by updating its modification time whenever it's loaded
+     */
+    class CacheDirectory {
+      private:
+        /**
+         * @brief The header of every entry, it's followed by the payload from the subsystem
+         */
+        struct EntryHeader {
+            u32 magic; //!< The magic of the subsystem which wrote the entry
+            u32 version; //!< The version of the subsystem's format, this must be incremented by the subsystem whenever the payload changes in an incompatible way
+            u64 size; //!< The size of the payload
+            u64 hash; //!< An XXH64 hash of the payload
+        };
+
+        static constexpr std::string_view TemporarySuffix{".tmp"}; //!< The suffix of files that are still being written
+
+        std::string path; //!< The path to the directory, this always has a trailing slash
+        size_t budget; //!< The maximum size of all entries in bytes, 0 if the size is unlimited
+        std::atomic<size_t> usage{}; //!< An estimate of the size of all entries, this is only used to decide when the directory needs to be trimmed
+        std::atomic<u32> nextTemporaryId{}; //!< A counter used to create unique names for temporary files
+        std::mutex trimMutex; //!< Serializes trimming the directory
+
+        /**
+         * @brief Evicts the least recently used entries till the directory is well below its budget
+         */
+        void Trim();
+
+      public:
+        /**
+         * @param budget The maximum size of all entries in bytes, 0 disables eviction
+         * @throw exception If the directory doesn't exist and couldn't be created
+         */
+        CacheDirectory(std::string path, size_t budget = 0);
+
+        /**
+         * @return An entry name which is unique to the supplied title, subsystems append their own suffix to this
+         */
+        static std::string GetTitleKey(u64 titleId);
+
+        /**
+         * @return An entry name which is unique to an executable with the supplied build ID, subsystems append their own suffix to this
+         */
+        static std::string GetBuildKey(const std::array<u64, 4> &buildId);
+
+        /**
+         * @brief Loads the payload of an entry and marks it as recently used
+         * @return The payload of the entry if it exists and was written with the supplied magic and version
+         * @note Any errors are logged and treated as a miss as the cache is only an optimization
+         */
+        std::optional<std::vector<u8>> Load(const std::string &name, u32 magic, u32 version);
+
+        /**
+         * @brief Atomically creates or replaces an entry and evicts other entries if the directory exceeds its budget
+         * @note Any errors are logged and otherwise ignored as the cache is only an optimization
+         */
+        void Store(const std::string &name, u32 magic, u32 version, span<const u8> payload);
+    };
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/memory_accounting.h>
+#include "boot_trace.h"
+#include "cached_backing.h"
+
+namespace skyline::vfs {
+    void BlockCache::TrimShardLocked(Shard &shard, size_t budget) {
+        while (shard.usage > budget && !shard.blocks.empty()) {
+            auto &block{shard.blocks.back()};
+            shard.usage -= block.data.size();
+            perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::BlockCache, block.data.size());
+            shard.blockMap.erase(block.key);
+            shard.blocks.pop_back();
+        }
+    }
+
+    void BlockCache::SetBudget(size_t budget) {
+        size_t perShard{budget / ShardCount};
+        shardBudget.store(perShard, std::memory_order_relaxed);
+        for (auto &shard : shards) {
+            std::scoped_lock lock(shard.mutex);
+            TrimShardLocked(shard, perShard);
+        }
+    }
+
+    bool BlockCache::Read(u64 backingId, u64 blockIndex, span<u8> output, size_t blockOffset) {
+        BlockKey key{backingId, blockIndex};
+        auto &shard{GetShard(key)};
+        std::scoped_lock lock(shard.mutex);
+        auto it{shard.blockMap.find(key)};
+        if (it == shard.blockMap.end())
+            return false;
+
+        auto &data{it->second->data};
+        if (blockOffset + output.size() > data.size()) [[unlikely]]
+            return false;
+
+        std::memcpy(output.data(), data.data() + blockOffset, output.size());
+        shard.blocks.splice(shard.blocks.begin(), shard.blocks, it->second);
+        return true;
+    }
+
+    void BlockCache::Insert(u64 backingId, u64 blockIndex, std::vector<u8> data) {
+        size_t budget{shardBudget.load(std::memory_order_relaxed)};
+        if (data.size() > budget)
+            return;
+
+        BlockKey key{backingId, blockIndex};
+        auto &shard{GetShard(key)};
+        std::scoped_lock lock(shard.mutex);
+        auto it{shard.blockMap.find(key)};
+        if (it != shard.blockMap.end()) {
+            // Another thread may have inserted the same block while we were reading it, the contents are identical so we only need to update its recency
+            shard.blocks.splice(shard.blocks.begin(), shard.blocks, it->second);
+            return;
+        }
+
+        shard.usage += data.size();
+        perf::SharedMemoryAccounting.Add(perf::MemoryCategory::BlockCache, data.size());
+        shard.blocks.push_front(Block{key, std::move(data)});
+        shard.blockMap.emplace(key, shard.blocks.begin());
+        TrimShardLocked(shard, budget);
+    }
+
+    void BlockCache::Invalidate(u64 backingId) {
+        for (auto &shard : shards) {
+            std::scoped_lock lock(shard.mutex);
+            for (auto it{shard.blocks.begin()}; it != shard.blocks.end();) {
+                if (it->key.backingId == backingId) {
+                    shard.usage -= it->data.size();
+                    perf::SharedMemoryAccounting.Sub(perf::MemoryCategory::BlockCache, it->data.size());
+                    shard.blockMap.erase(it->key);
+                    it = shard.blocks.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+    }
+
+    CachedBacking::CachedBacking(std::shared_ptr<Backing> pBacking, u64 traceKey) : Backing(pBacking->mode, pBacking->size), backing(std::move(pBacking)), id(BlockCache::Get().AllocateBackingId()), traceKey(traceKey) {
+        if (mode.write || mode.append)
+            throw exception("Cannot open a CachedBacking as writable");
+
+        if (traceKey)
+            BootTrace::Get().RegisterBacking(traceKey, id, backing);
+    }
+
+    CachedBacking::~CachedBacking() {
+        if (traceKey)
+            BootTrace::Get().UnregisterBacking(traceKey, id);
+        BlockCache::Get().Invalidate(id);
+    }
+
+    size_t CachedBacking::ReadImpl(span<u8> output, size_t offset) {
+        auto &cache{BlockCache::Get()};
+        if (!cache.IsEnabled())
+            return backing->ReadUnchecked(output, offset);
+
+        size_t read{};
+        while (read < output.size() && offset < size) {
+            u64 blockIndex{offset / BlockCache::BlockSize};
+            size_t blockStart{blockIndex * BlockCache::BlockSize}, blockOffset{offset - blockStart};
+            size_t blockSize{std::min(BlockCache::BlockSize, size - blockStart)};
+            auto chunk{output.subspan(read, std::min(output.size() - read, blockSize - blockOffset))};
+            if (traceKey)
+                BootTrace::Get().Record(traceKey, blockIndex);
+
+            if (!cache.Read(id, blockIndex, chunk, blockOffset)) {
+                std::vector<u8> block(blockSize);
+                if (chunk.size() == blockSize) {
+                    // The read covers the entire block so it can be read directly into the output and copied into the cache afterwards
+                    if (backing->ReadUnchecked(chunk, blockStart) != blockSize) [[unlikely]]
+                        return read;
+                    std::memcpy(block.data(), chunk.data(), blockSize);
+                } else {
+                    size_t blockRead{backing->ReadUnchecked(block, blockStart)};
+                    if (blockRead < blockOffset + chunk.size()) [[unlikely]] {
+                        size_t available{blockRead > blockOffset ? blockRead - blockOffset : 0};
+                        std::memcpy(chunk.data(), block.data() + blockOffset, available);
+                        return read + available;
+                    }
+                    std::memcpy(chunk.data(), block.data() + blockOffset, chunk.size());
+                }
+                cache.Insert(id, blockIndex, std::move(block));
+            }
+
+            read += chunk.size();
+            offset += chunk.size();
+        }
+
+        return read;
+    }
+}
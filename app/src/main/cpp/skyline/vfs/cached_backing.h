@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A process-wide LRU cache of fixed-size blocks read from backings, blocks are split across several shards with individual locks and individual LRU lists to avoid contention between concurrent readers
+     * @note Blocks are identified by the ID of the CachedBacking they belong to and their index within it, IDs are never reused so blocks of destroyed backings can't be served to new ones
+     */
+    class BlockCache {
+      public:
+        static constexpr size_t BlockSize{0x10000}; //!< The size of a single cached block, the final block of a backing may be smaller than this
+
+      private:
+        static constexpr size_t ShardCount{8};
+
+        struct BlockKey {
+            u64 backingId;
+            u64 blockIndex;
+
+            bool operator==(const BlockKey &) const = default;
+        };
+
+        struct BlockKeyHash {
+            size_t operator()(const BlockKey &key) const {
+                return std::hash<u64>{}(key.backingId ^ (key.blockIndex * 0x9E3779B97F4A7C15));
+            }
+        };
+
+        struct Block {
+            BlockKey key;
+            std::vector<u8> data;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<Block> blocks; //!< All cached blocks in the shard from the most to the least recently used
+            std::unordered_map<BlockKey, std::list<Block>::iterator, BlockKeyHash> blockMap;
+            size_t usage{}; //!< The total size of the data of all blocks in the shard
+        };
+
+        std::array<Shard, ShardCount> shards;
+        std::atomic<size_t> shardBudget{}; //!< The maximum amount of bytes a single shard may hold, this is 0 if the cache is disabled
+        std::atomic<u64> nextBackingId{1};
+
+        BlockCache() = default;
+
+        Shard &GetShard(const BlockKey &key) {
+            return shards[BlockKeyHash{}(key) % ShardCount];
+        }
+
+        /**
+         * @brief Evicts the least recently used blocks of a shard till it fits within the supplied budget
+         * @note The shard mutex must be locked
+         */
+        static void TrimShardLocked(Shard &shard, size_t budget);
+
+      public:
+        /**
+         * @note The cache is intentionally leaked as backings may be destroyed during static destruction
+         */
+        static BlockCache &Get() {
+            static auto *cache{new BlockCache()};
+            return *cache;
+        }
+
+        /**
+         * @brief Sets the total amount of memory the cache may use, blocks exceeding the new budget are evicted immediately
+         * @param budget The budget in bytes, 0 disables caching entirely
+         */
+        void SetBudget(size_t budget);
+
+        bool IsEnabled() {
+            return shardBudget.load(std::memory_order_relaxed) != 0;
+        }
+
+        /**
+         * @return The total amount of memory the cache may use in bytes
+         */
+        size_t GetBudget() {
+            return shardBudget.load(std::memory_order_relaxed) * ShardCount;
+        }
+
+        /**
+         * @return A unique ID for a new backing, this is never 0
+         */
+        u64 AllocateBackingId() {
+            return nextBackingId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Copies data out of a cached block and marks it as the most recently used block
+         * @param blockOffset The offset of the data within the block
+         * @return If the block was present in the cache and held all of the requested data
+         */
+        bool Read(u64 backingId, u64 blockIndex, span<u8> output, size_t blockOffset);
+
+        /**
+         * @brief Inserts a block into the cache, this replaces any existing contents of the block
+         */
+        void Insert(u64 backingId, u64 blockIndex, std::vector<u8> data);
+
+        /**
+         * @brief Evicts all blocks belonging to the supplied backing
+         */
+        void Invalidate(u64 backingId);
+    };
+
+    /**
+     * @brief A read-only backing which caches blocks of an underlying backing in the BlockCache, it's intended to sit above an expensive layer such as decryption so repeated reads of the same data skip it
+     */
+    class CachedBacking : public Backing {
+      private:
+        std::shared_ptr<Backing> backing;
+        u64 id; //!< The ID of this backing in the BlockCache
+        u64 traceKey; //!< The key of this backing in the BootTrace, 0 if accesses to it aren't traced
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+      public:
+        /**
+         * @param traceKey A key derived from the contents of the backing which stays stable across boots, accesses are recorded in the BootTrace and prefetched on later boots if this is non-zero
+         */
+        CachedBacking(std::shared_ptr<Backing> backing, u64 traceKey = 0);
+
+        ~CachedBacking();
+    };
+}
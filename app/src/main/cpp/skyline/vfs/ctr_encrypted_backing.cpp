@@ -1,21 +1,58 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/thread_pool.h>
 #include "ctr_encrypted_backing.h"
 
 namespace skyline::vfs {
     constexpr size_t SectorSize{0x10};
+    constexpr size_t DecryptChunkSize{0x40000}; //!< The size of the chunks which large reads are split into for decryption on the workers, this must be a multiple of the sector size
+    constexpr size_t ParallelDecryptThreshold{DecryptChunkSize * 4}; //!< The minimum size of a read for it to be decrypted in parallel, smaller reads are decrypted faster than the workers can be woken
 
     CtrEncryptedBacking::CtrEncryptedBacking(crypto::KeyStore::Key128 ctr, crypto::KeyStore::Key128 key, std::shared_ptr<Backing> backing, size_t baseOffset) : Backing({true, false, false}, backing->size), ctr(ctr), cipher(key, MBEDTLS_CIPHER_AES_128_CTR), backing(std::move(backing)), baseOffset(baseOffset) {
         if (mode.write || mode.append)
             throw exception("Cannot open a CtrEncryptedBacking as writable");
     }
 
-    void CtrEncryptedBacking::UpdateCtr(u64 offset) {
+    crypto::KeyStore::Key128 CtrEncryptedBacking::GetCtr(u64 offset) const {
+        auto counter{ctr};
         offset >>= 4;
         size_t le{util::SwapEndianness(offset)};
-        std::memcpy(ctr.data() + 8, &le, 8);
-        cipher.SetIV(ctr);
+        std::memcpy(counter.data() + 8, &le, 8);
+        return counter;
+    }
+
+    void CtrEncryptedBacking::Decrypt(span<u8> data, size_t offset) {
+        if (data.size() < ParallelDecryptThreshold) {
+            cipher.CtrDecrypt(data.data(), data.data(), data.size(), GetCtr(baseOffset + offset));
+            return;
+        }
+
+        static ThreadPool pool{std::max(std::thread::hardware_concurrency() / 2, 2U) - 1}; // The pool is shared by all backings as reads which are large enough to use it are infrequent
+
+        // Decryption only reads the cipher context so chunks can be decrypted concurrently, a failure is rethrown on the calling thread as workers must not throw
+        std::exception_ptr exception;
+        std::mutex exceptionMutex;
+        std::function<void(size_t)> decryptChunk{[&](size_t chunk) {
+            auto chunkOffset{chunk * DecryptChunkSize};
+            auto chunkData{data.subspan(chunkOffset, std::min(DecryptChunkSize, data.size() - chunkOffset))};
+            try {
+                cipher.CtrDecrypt(chunkData.data(), chunkData.data(), chunkData.size(), GetCtr(baseOffset + offset + chunkOffset));
+            } catch (...) {
+                std::scoped_lock lock{exceptionMutex};
+                exception = std::current_exception();
+            }
+        }};
+
+        size_t chunkCount{util::AlignUp(data.size(), DecryptChunkSize) / DecryptChunkSize};
+        if (!pool.TryParallelFor(chunkCount, decryptChunk)) {
+            // Another large read is already using the workers, decrypting on this thread is faster than waiting for it to complete
+            for (size_t chunk{}; chunk < chunkCount; chunk++)
+                decryptChunk(chunk);
+        }
+
+        if (exception)
+            std::rethrow_exception(exception);
     }
 
     size_t CtrEncryptedBacking::ReadImpl(span<u8> output, size_t offset) {
@@ -28,24 +65,16 @@ namespace skyline::vfs {
             size_t read{backing->ReadUnchecked(output, offset)};
             if (read != size)
                 return 0;
-            {
-                std::lock_guard guard(mutex);
-                UpdateCtr(baseOffset + offset);
-                cipher.Decrypt(output);
-            }
+            Decrypt(output, offset);
             return size;
         }
 
         size_t sectorStart{offset - sectorOffset};
-        std::vector<u8> blockBuf(SectorSize);
+        std::array<u8, SectorSize> blockBuf;
         size_t read{backing->ReadUnchecked(blockBuf, sectorStart)};
         if (read != SectorSize)
             return 0;
-        {
-            std::lock_guard guard(mutex);
-            UpdateCtr(baseOffset + sectorStart);
-            cipher.Decrypt(blockBuf);
-        }
+        cipher.CtrDecrypt(blockBuf.data(), blockBuf.data(), SectorSize, GetCtr(baseOffset + sectorStart));
         if (size + sectorOffset < SectorSize) {
             std::memcpy(output.data(), blockBuf.data() + sectorOffset, size);
             return size;
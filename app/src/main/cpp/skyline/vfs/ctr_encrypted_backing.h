@@ -10,19 +10,25 @@
 namespace skyline::vfs {
     /**
      * @brief A backing for decrypting AES-CTR data
+     * @note Decryption is stateless as the counter is derived from the offset for every read, concurrent reads are decrypted in parallel
+     * @note Large reads are additionally split into chunks which are decrypted on a shared pool of workers, this shortens loading screens where the guest reads large assets at once
      */
     class CtrEncryptedBacking : public Backing {
       private:
         crypto::KeyStore::Key128 ctr;
         crypto::AesCipher cipher;
         std::shared_ptr<Backing> backing;
-        std::mutex mutex; //!< Synchronize all AES-CTR cipher state modifications
         size_t baseOffset; //!< The offset of the backing into the file is used to calculate the IV
 
         /**
-         * @brief Calculates IV based on the offset
+         * @return The counter for the block at the supplied offset
          */
-        void UpdateCtr(u64 offset);
+        crypto::KeyStore::Key128 GetCtr(u64 offset) const;
+
+        /**
+         * @brief Decrypts sector-aligned data in place, large amounts of data are split into chunks which are decrypted in parallel
+         */
+        void Decrypt(span<u8> data, size_t offset);
 
       protected:
         size_t ReadImpl(span<u8> output, size_t offset) override;
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "integrity_verifying_backing.h"
+
+namespace skyline::vfs {
+    IntegrityVerifyingBacking::IntegrityVerifyingBacking(std::shared_ptr<Backing> pBacking, std::shared_ptr<Backing> hashBacking, size_t blockSize, bool padBlocks)
+        : Backing({true, false, false}, pBacking->size),
+          backing(std::move(pBacking)),
+          hashBacking(std::move(hashBacking)),
+          blockSize(blockSize),
+          padBlocks(padBlocks),
+          verifiedBlocks(util::AlignUp(util::AlignUp(size, blockSize) / blockSize, 64) / 64) {
+        if (!blockSize)
+            throw exception("An IntegrityVerifyingBacking cannot have a block size of 0");
+
+        if (this->hashBacking->size < (util::AlignUp(size, blockSize) / blockSize) * crypto::Sha256::DigestSize)
+            throw exception("The hash backing is too small for 0x{:X} bytes of data with a block size of 0x{:X}: 0x{:X}", size, blockSize, this->hashBacking->size);
+    }
+
+    IntegrityVerifyingBacking::IntegrityVerifyingBacking(std::shared_ptr<Backing> pBacking, std::vector<crypto::Sha256::Digest> pHashes, size_t blockSize, bool padBlocks)
+        : Backing({true, false, false}, pBacking->size),
+          backing(std::move(pBacking)),
+          hashes(std::move(pHashes)),
+          blockSize(blockSize),
+          padBlocks(padBlocks),
+          verifiedBlocks(util::AlignUp(util::AlignUp(size, blockSize) / blockSize, 64) / 64) {
+        if (!blockSize)
+            throw exception("An IntegrityVerifyingBacking cannot have a block size of 0");
+
+        if (hashes.size() < util::AlignUp(size, blockSize) / blockSize)
+            throw exception("Only {} hashes were supplied for 0x{:X} bytes of data with a block size of 0x{:X}", hashes.size(), size, blockSize);
+    }
+
+    void IntegrityVerifyingBacking::VerifyBlock(size_t index) {
+        auto &word{verifiedBlocks[index / 64]};
+        u64 bit{1ULL << (index % 64)};
+        if (word.load(std::memory_order_acquire) & bit)
+            return;
+
+        // Concurrent readers may verify the same block simultaneously, this is harmless as the result is identical
+        auto blockOffset{index * blockSize};
+        auto dataSize{std::min(blockSize, size - blockOffset)};
+        std::vector<u8> block(padBlocks ? blockSize : dataSize);
+        if (backing->ReadUnchecked(span(block).first(dataSize), blockOffset) != dataSize)
+            throw exception("Failed to read block {} for integrity verification", index);
+
+        crypto::Sha256::Digest expected;
+        if (hashBacking)
+            hashBacking->Read(span(expected), index * crypto::Sha256::DigestSize);
+        else
+            expected = hashes[index];
+
+        if (crypto::Sha256::Hash(block) != expected)
+            throw exception("Integrity verification failed for block {} at 0x{:X}, the data is corrupted", index, blockOffset);
+
+        word.fetch_or(bit, std::memory_order_release);
+    }
+
+    size_t IntegrityVerifyingBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (offset >= size || output.empty())
+            return 0;
+
+        auto end{std::min(offset + output.size(), size)};
+        for (size_t index{offset / blockSize}; index * blockSize < end; index++)
+            VerifyBlock(index);
+
+        // Blocks are read again after verification, this is cheap as the underlying backing generally has them cached by now
+        return backing->ReadUnchecked(output.first(end - offset), offset);
+    }
+
+    std::optional<span<u8>> IntegrityVerifyingBacking::MapImpl(size_t offset, size_t mapSize) {
+        auto end{offset + mapSize};
+        for (size_t index{offset / blockSize}; index * blockSize < end; index++)
+            VerifyBlock(index);
+
+        return backing->Map(offset, mapSize);
+    }
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <crypto/sha256.h>
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A backing which verifies the SHA-256 hash of every block of another backing the first time it's read, this is used for the hierarchical hash schemes of NCA sections
+     * @note Blocks are only verified once, this is tracked with a bitmap so subsequent reads of them don't have any overhead aside from checking it
+     * @note The hashes can be supplied by another backing which is usually an IntegrityVerifyingBacking itself, this verifies the hash tree lazily from the root down to the read data
+     */
+    class IntegrityVerifyingBacking : public Backing {
+      private:
+        std::shared_ptr<Backing> backing;
+        std::shared_ptr<Backing> hashBacking; //!< The backing containing the digests of all blocks, this is null if they're supplied directly
+        std::vector<crypto::Sha256::Digest> hashes; //!< The digests of all blocks if they were supplied directly
+        size_t blockSize;
+        bool padBlocks; //!< If a partial final block is padded with zeroes to the block size prior to hashing it
+        std::vector<std::atomic<u64>> verifiedBlocks; //!< A bitmap of all blocks which have been verified
+
+        /**
+         * @brief Verifies the block at the supplied index if it hasn't been verified yet
+         * @note An exception is thrown if the block doesn't match its hash
+         */
+        void VerifyBlock(size_t index);
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+        std::optional<span<u8>> MapImpl(size_t offset, size_t mapSize) override;
+
+      public:
+        /**
+         * @param hashBacking The backing containing the digest of every block of the backing in order
+         */
+        IntegrityVerifyingBacking(std::shared_ptr<Backing> backing, std::shared_ptr<Backing> hashBacking, size_t blockSize, bool padBlocks);
+
+        /**
+         * @param hashes The digest of every block of the backing in order
+         */
+        IntegrityVerifyingBacking(std::shared_ptr<Backing> backing, std::vector<crypto::Sha256::Digest> hashes, size_t blockSize, bool padBlocks);
+    };
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mmap_backing.h"
+
+namespace skyline::vfs {
+    MmapBacking::MmapBacking(int fd, bool closable) : Backing({true, false, false}), fd(fd), closable(closable) {
+        struct stat fileInfo;
+        if (fstat(fd, &fileInfo))
+            throw exception("Failed to stat fd: {}", strerror(errno));
+        if (!S_ISREG(fileInfo.st_mode))
+            throw exception("Cannot map an fd which isn't a regular file");
+
+        size = static_cast<size_t>(fileInfo.st_size);
+        if (size) {
+            auto pointer{mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+            if (pointer == MAP_FAILED)
+                throw exception("Failed to map fd: {}", strerror(errno));
+            mapping = span<u8>(static_cast<u8 *>(pointer), size);
+        }
+    }
+
+    MmapBacking::~MmapBacking() {
+        if (!mapping.empty())
+            munmap(mapping.data(), mapping.size());
+        if (closable)
+            close(fd);
+    }
+
+    size_t MmapBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (offset >= size)
+            return 0;
+
+        size_t readSize{std::min(output.size(), size - offset)};
+        std::memcpy(output.data(), mapping.data() + offset, readSize);
+        return readSize;
+    }
+}
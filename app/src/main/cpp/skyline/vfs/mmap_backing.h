@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A read-only backing for a physical linux file which maps the entire file into memory, reads are a copy out of the mapping rather than a syscall and the kernel page cache handles read-ahead
+     * @note An I/O error while faulting in the mapping results in a SIGBUS rather than an exception, this is intended for local read-only images where this shouldn't happen
+     */
+    class MmapBacking : public Backing {
+      private:
+        int fd; //!< An FD to the backing
+        bool closable; //!< Whether the FD can be closed when the backing is destroyed
+        span<u8> mapping; //!< The mapping of the entire file, this is mapped as read-only so it must never be written to
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+        std::optional<span<u8>> MapImpl(size_t offset, size_t mapSize) override {
+            return mapping.subspan(offset, mapSize);
+        }
+
+      public:
+        /**
+         * @param fd The file descriptor of the backing
+         * @throw exception If the file couldn't be mapped, OsBacking should be used instead in this case
+         */
+        MmapBacking(int fd, bool closable = false);
+
+        ~MmapBacking();
+    };
+}
@@ -1,10 +1,14 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <xxhash.h>
 #include <crypto/aes_cipher.h>
 #include <loader/loader.h>
+#include <common/trace.h>
 
 #include "ctr_encrypted_backing.h"
+#include "cached_backing.h"
+#include "integrity_verifying_backing.h"
 #include "region_backing.h"
 #include "partition_filesystem.h"
 #include "nca.h"
@@ -14,10 +18,11 @@
 namespace skyline::vfs {
     using namespace loader;
 
-    NCA::NCA(std::shared_ptr<vfs::Backing> pBacking, std::shared_ptr<crypto::KeyStore> pKeyStore, bool pUseKeyArea) : backing(std::move(pBacking)), keyStore(std::move(pKeyStore)), useKeyArea(pUseKeyArea) {
+    NCA::NCA(std::shared_ptr<vfs::Backing> pBacking, std::shared_ptr<crypto::KeyStore> pKeyStore, bool pUseKeyArea, bool pVerifyIntegrity) : backing(std::move(pBacking)), keyStore(std::move(pKeyStore)), useKeyArea(pUseKeyArea), verifyIntegrity(pVerifyIntegrity) {
         header = backing->Read<NcaHeader>();
 
         if (header.magic != util::MakeMagic<u32>("NCA3")) {
+            TRACE_BOOT_PHASE(NcaHeaderDecryption, "NCA Header Decryption");
             if (!keyStore->headerKey)
                 throw loader_exception(LoaderResult::MissingHeaderKey);
 
@@ -46,10 +51,22 @@ namespace skyline::vfs {
     }
 
     void NCA::ReadPfs0(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry) {
-        size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize + sectionHeader.sha256HashInfo.pfs0Offset};
-        size_t size{constant::MediaUnitSize * static_cast<size_t>(entry.endOffset - entry.startOffset)};
+        const auto &hashInfo{sectionHeader.sha256HashInfo};
+        size_t sectionOffset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize};
+        size_t offset{sectionOffset + hashInfo.pfs0Offset};
+
+        std::shared_ptr<Backing> pfsBacking;
+        if (verifyIntegrity) {
+            // The hash table is verified as a single block against the hash in the section header, the PFS0 is then verified against the hash table
+            size_t hashTableOffset{sectionOffset + hashInfo.hashTableOffset};
+            auto hashTable{std::make_shared<IntegrityVerifyingBacking>(CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, hashTableOffset, hashInfo.hashTableSize), hashTableOffset), std::vector<crypto::Sha256::Digest>{hashInfo.hashTableHash}, hashInfo.hashTableSize, false)};
+            pfsBacking = std::make_shared<IntegrityVerifyingBacking>(CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, hashInfo.pfs0Size), offset), std::move(hashTable), hashInfo.blockSize, false);
+        } else {
+            size_t size{constant::MediaUnitSize * static_cast<size_t>(entry.endOffset - entry.startOffset)};
+            pfsBacking = CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset);
+        }
 
-        auto pfs{std::make_shared<PartitionFileSystem>(CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset))};
+        auto pfs{std::make_shared<PartitionFileSystem>(std::move(pfsBacking))};
 
         if (contentType == NcaContentType::Program) {
             // An ExeFS must always contain an NPDM and a main NSO, whereas the logo section will always contain a logo and a startup movie
@@ -63,10 +80,27 @@ namespace skyline::vfs {
     }
 
     void NCA::ReadRomFs(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry) {
-        size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize + sectionHeader.integrityHashInfo.levels.back().offset};
-        size_t size{sectionHeader.integrityHashInfo.levels.back().size};
+        const auto &hashInfo{sectionHeader.integrityHashInfo};
+        size_t sectionOffset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize};
+        auto openLevel{[&](const HierarchicalIntegrityLevel &level) {
+            size_t offset{sectionOffset + level.offset};
+            return CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, level.size), offset);
+        }};
+
+        if (!verifyIntegrity) {
+            romFs = openLevel(hashInfo.levels.back());
+            return;
+        }
+
+        // Every level contains the hashes of the blocks of the following one with the master hash covering the first level, the final level is the RomFS itself
+        // Block sizes are stored as powers of two and partial blocks are hashed with zero padding
+        if (hashInfo.numLevels != hashInfo.levels.size() + 1 || hashInfo.masterHashSize != crypto::Sha256::DigestSize)
+            throw exception("Unsupported IVFC layout with {} levels and a master hash of 0x{:X} bytes", hashInfo.numLevels, hashInfo.masterHashSize);
 
-        romFs = CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset);
+        std::shared_ptr<Backing> level{std::make_shared<IntegrityVerifyingBacking>(openLevel(hashInfo.levels.front()), std::vector<crypto::Sha256::Digest>{hashInfo.masterHash}, 1ULL << hashInfo.levels.front().blockSize, true)};
+        for (auto it{std::next(hashInfo.levels.begin())}; it != hashInfo.levels.end(); it++)
+            level = std::make_shared<IntegrityVerifyingBacking>(openLevel(*it), std::move(level), 1ULL << it->blockSize, true);
+        romFs = std::move(level);
     }
 
     std::shared_ptr<Backing> NCA::CreateBacking(const NcaSectionHeader &sectionHeader, std::shared_ptr<Backing> rawBacking, size_t offset) {
@@ -86,7 +120,9 @@ namespace skyline::vfs {
                 std::memcpy(ctr.data(), &secureValueLE, 4);
                 std::memcpy(ctr.data() + 4, &generationLE, 4);
 
-                return std::make_shared<CtrEncryptedBacking>(ctr, key, std::move(rawBacking), offset);
+                // Decrypted blocks are cached as decryption is the most expensive part of reading from an NCA, the section header holds the hashes of its contents so it uniquely identifies the section across boots
+                u64 traceKey{XXH64(&sectionHeader, sizeof(NcaSectionHeader), offset)};
+                return std::make_shared<CachedBacking>(std::make_shared<CtrEncryptedBacking>(ctr, key, std::move(rawBacking), offset), traceKey);
             }
             default:
                 return nullptr;
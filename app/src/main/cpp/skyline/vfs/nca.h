@@ -174,6 +174,7 @@ namespace skyline {
             bool encrypted{false};
             bool rightsIdEmpty;
             bool useKeyArea;
+            bool verifyIntegrity; //!< If the hashes of all sections should be verified as they're read
 
             void ReadPfs0(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry);
 
@@ -194,7 +195,10 @@ namespace skyline {
             std::shared_ptr<Backing> romFs; //!< The backing for this NCA's RomFS section
             NcaContentType contentType; //!< The content type of the NCA
 
-            NCA(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool useKeyArea = false);
+            /**
+             * @param verifyIntegrity If the hierarchical hashes of every section should be verified, this is done lazily for every block on its first read
+             */
+            NCA(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool useKeyArea = false, bool verifyIntegrity = false);
         };
     }
 }
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <zstd.h>
+#include "ncz_backing.h"
+
+namespace skyline::vfs {
+    constexpr size_t SectorSize{0x10}; //!< The size of an AES block, sections are re-encrypted in units of these
+    constexpr size_t StreamInputSize{0x20000}; //!< The size of the reads of compressed data for solid NCZs
+
+    NczBacking::NczBacking(std::shared_ptr<Backing> pBacking) : Backing({true, false, false}), backing(std::move(pBacking)) {
+        constexpr u64 SectionMagic{util::MakeMagic<u64>("NCZSECTN")};
+        constexpr u64 BlockMagic{util::MakeMagic<u64>("NCZBLOCK")};
+        constexpr u64 CryptoTypeNone{1}, CryptoTypeCtr{3}, CryptoTypeBktr{4};
+
+        if (backing->Read<u64>(HeaderSize) != SectionMagic)
+            throw exception("Invalid NCZ section magic");
+
+        auto sectionCount{backing->Read<u64>(HeaderSize + sizeof(u64))};
+        std::vector<SectionEntry> entries(sectionCount);
+        backing->Read(span(entries), HeaderSize + (sizeof(u64) * 2));
+        dataOffset = HeaderSize + (sizeof(u64) * 2) + (sectionCount * sizeof(SectionEntry));
+
+        sections.reserve(sectionCount);
+        for (auto &entry : entries) {
+            std::unique_ptr<crypto::AesCipher> cipher;
+            if (entry.cryptoType == CryptoTypeCtr || entry.cryptoType == CryptoTypeBktr)
+                cipher = std::make_unique<crypto::AesCipher>(entry.key, MBEDTLS_CIPHER_AES_128_CTR);
+            else if (entry.cryptoType != CryptoTypeNone)
+                throw exception("Unsupported NCZ section crypto type: {}", entry.cryptoType);
+
+            sections.push_back(Section{entry.offset, entry.size, std::move(cipher), entry.counter});
+            size = std::max(size, entry.offset + entry.size);
+        }
+
+        if (dataOffset + sizeof(BlockHeader) <= backing->size && backing->Read<u64>(dataOffset) == BlockMagic) {
+            auto header{backing->Read<BlockHeader>(dataOffset)};
+            if (header.blockSizeExponent < 14 || header.blockSizeExponent > 32)
+                throw exception("Invalid NCZ block size exponent: {}", header.blockSizeExponent);
+            blockSize = 1ULL << header.blockSizeExponent;
+
+            std::vector<u32> compressedSizes(header.blockCount);
+            backing->Read(span(compressedSizes), dataOffset + sizeof(BlockHeader));
+            dataOffset += sizeof(BlockHeader) + (header.blockCount * sizeof(u32));
+
+            blockOffsets.reserve(header.blockCount + 1);
+            blockOffsets.push_back(dataOffset);
+            for (u32 compressedSize : compressedSizes)
+                blockOffsets.push_back(blockOffsets.back() + compressedSize);
+
+            if (blockOffsets.back() > backing->size || header.decompressedSize > header.blockCount * blockSize)
+                throw exception("Invalid NCZ block table: 0x{:X} blocks of 0x{:X} bytes for 0x{:X} bytes", header.blockCount, blockSize, header.decompressedSize);
+
+            size = HeaderSize + header.decompressedSize;
+            blockBuffer.resize(blockSize);
+        } else {
+            streamCompressedOffset = dataOffset;
+            size = std::max(size, HeaderSize);
+        }
+
+        context = ZSTD_createDCtx();
+        if (!context)
+            throw exception("Failed to create a zstd decompression context");
+    }
+
+    NczBacking::~NczBacking() {
+        ZSTD_freeDCtx(context);
+    }
+
+    void NczBacking::LoadBlock(size_t index) {
+        if (index + 1 >= blockOffsets.size())
+            throw exception("NCZ block out of bounds: {} (Count: {})", index, blockOffsets.size() - 1);
+
+        size_t decompressedSize{std::min(blockSize, size - HeaderSize - (index * blockSize))};
+        size_t compressedSize{blockOffsets[index + 1] - blockOffsets[index]};
+
+        if (compressedSize >= decompressedSize) {
+            backing->Read(span(blockBuffer.data(), decompressedSize), blockOffsets[index]);
+        } else {
+            std::vector<u8> compressed(compressedSize);
+            backing->Read(span(compressed), blockOffsets[index]);
+
+            auto result{ZSTD_decompressDCtx(context, blockBuffer.data(), decompressedSize, compressed.data(), compressed.size())};
+            if (ZSTD_isError(result) || result != decompressedSize)
+                throw exception("Failed to decompress NCZ block {}: {}", index, ZSTD_isError(result) ? ZSTD_getErrorName(result) : "Size mismatch");
+        }
+
+        cachedBlock = index;
+    }
+
+    void NczBacking::DecompressStream(span<u8> output, size_t offset) {
+        if (offset < streamOffset) {
+            ZSTD_DCtx_reset(context, ZSTD_reset_session_only);
+            streamInput.clear();
+            streamInputPosition = 0;
+            streamCompressedOffset = dataOffset;
+            streamOffset = 0;
+        }
+
+        std::array<u8, 0x1000> discard; // Data prior to the offset is decompressed into this and dropped
+        while (!output.empty()) {
+            ZSTD_outBuffer outBuffer{};
+            if (streamOffset < offset)
+                outBuffer = {discard.data(), std::min(discard.size(), offset - streamOffset), 0};
+            else
+                outBuffer = {output.data(), output.size(), 0};
+
+            if (streamInputPosition == streamInput.size()) {
+                size_t inputSize{std::min(StreamInputSize, backing->size - streamCompressedOffset)};
+                if (inputSize == 0)
+                    throw exception("NCZ stream ended prematurely at 0x{:X}", streamOffset);
+
+                streamInput.resize(inputSize);
+                backing->Read(span(streamInput), streamCompressedOffset);
+                streamCompressedOffset += inputSize;
+                streamInputPosition = 0;
+            }
+
+            ZSTD_inBuffer inBuffer{streamInput.data(), streamInput.size(), streamInputPosition};
+            auto result{ZSTD_decompressStream(context, &outBuffer, &inBuffer)};
+            if (ZSTD_isError(result))
+                throw exception("Failed to decompress NCZ stream at 0x{:X}: {}", streamOffset, ZSTD_getErrorName(result));
+            streamInputPosition = inBuffer.pos;
+
+            streamOffset += outBuffer.pos;
+            if (outBuffer.dst == output.data())
+                output = output.subspan(outBuffer.pos);
+        }
+    }
+
+    void NczBacking::Decompress(span<u8> output, size_t offset) {
+        if (!blockSize) {
+            DecompressStream(output, offset);
+            return;
+        }
+
+        while (!output.empty()) {
+            size_t index{offset / blockSize}, blockOffset{offset % blockSize};
+            if (index != cachedBlock)
+                LoadBlock(index);
+
+            size_t copySize{std::min(output.size(), blockSize - blockOffset)};
+            std::memcpy(output.data(), blockBuffer.data() + blockOffset, copySize);
+            output = output.subspan(copySize);
+            offset += copySize;
+        }
+    }
+
+    size_t NczBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (offset >= size)
+            return 0;
+        output = output.subspan(0, std::min(output.size(), size - offset));
+
+        size_t headerRead{};
+        if (offset < HeaderSize) {
+            headerRead = std::min(output.size(), HeaderSize - offset);
+            if (backing->ReadUnchecked(output.subspan(0, headerRead), offset) != headerRead)
+                return 0;
+            if (headerRead == output.size())
+                return headerRead;
+        }
+
+        // The body is decompressed into a sector-aligned buffer as the keystream for re-encryption is generated in units of sectors
+        size_t bodyOffset{offset + headerRead}, bodyEnd{offset + output.size()};
+        size_t alignedOffset{util::AlignDown(bodyOffset, SectorSize)}, alignedEnd{std::min(util::AlignUp(bodyEnd, SectorSize), size)};
+        std::vector<u8> body(alignedEnd - alignedOffset);
+
+        std::scoped_lock lock{mutex};
+        Decompress(body, alignedOffset - HeaderSize);
+
+        for (const auto &section : sections) {
+            if (!section.cipher)
+                continue;
+
+            size_t start{std::max(alignedOffset, util::AlignDown(section.offset, SectorSize))}, end{std::min(alignedEnd, section.offset + section.size)};
+            if (start >= end)
+                continue;
+
+            auto counter{section.counter};
+            size_t sector{util::SwapEndianness(static_cast<u64>(start / SectorSize))};
+            std::memcpy(counter.data() + 8, &sector, sizeof(sector));
+            section.cipher->CtrDecrypt(body.data() + (start - alignedOffset), body.data() + (start - alignedOffset), end - start, counter);
+        }
+
+        std::memcpy(output.data() + headerRead, body.data() + (bodyOffset - alignedOffset), bodyEnd - bodyOffset);
+        return output.size();
+    }
+}
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <crypto/aes_cipher.h>
+#include <crypto/key_store.h>
+#include "backing.h"
+
+struct ZSTD_DCtx_s;
+
+namespace skyline::vfs {
+    /**
+     * @brief A backing which exposes an NCZ-compressed NCA as the original encrypted NCA
+     * @url https://github.com/nicoboss/nsz#ncz
+     * @note NCZs store the NCA header uncompressed followed by a table of sections and a zstd stream of the decrypted NCA body, the sections are re-encrypted on reads so the NCA can be parsed like any other
+     * @note Block-compressed NCZs are randomly accessible by block while solid NCZs are a single stream which has to be decompressed again from the start on any backwards seek
+     * @note Reads are serialized by a mutex as the decompression context and the cached block are shared
+     */
+    class NczBacking : public Backing {
+      private:
+        static constexpr size_t HeaderSize{0x4000}; //!< The size of the uncompressed NCA header at the start of an NCZ
+
+        /**
+         * @brief An entry in the section table, the data of sections with AES-CTR encryption is stored decrypted
+         */
+        struct SectionEntry {
+            u64 offset; //!< The offset of the section in the NCA
+            u64 size;
+            u64 cryptoType;
+            u64 _pad_;
+            crypto::KeyStore::Key128 key;
+            crypto::KeyStore::Key128 counter; //!< The counter of the section, the lower 8 bytes are replaced with the block index on encryption
+        };
+        static_assert(sizeof(SectionEntry) == 0x40);
+
+        /**
+         * @brief The header of block-compressed NCZs, it's followed by the compressed size of every block
+         */
+        struct BlockHeader {
+            u64 magic; //!< "NCZBLOCK"
+            u8 version;
+            u8 type;
+            u8 _pad_;
+            u8 blockSizeExponent;
+            u32 blockCount;
+            u64 decompressedSize; //!< The size of the NCA after the header
+        };
+        static_assert(sizeof(BlockHeader) == 0x18);
+
+        struct Section {
+            size_t offset;
+            size_t size;
+            std::unique_ptr<crypto::AesCipher> cipher; //!< The cipher the section is re-encrypted with, nullptr for unencrypted sections
+            crypto::KeyStore::Key128 counter;
+        };
+
+        std::shared_ptr<Backing> backing;
+        std::vector<Section> sections;
+        std::mutex mutex; //!< Synchronizes access to the decompression state
+        ZSTD_DCtx_s *context{};
+        size_t dataOffset{}; //!< The offset of the compressed data in the NCZ
+
+        size_t blockSize{}; //!< The decompressed size of a block, this is zero for solid NCZs
+        std::vector<size_t> blockOffsets; //!< The offset of every block in the NCZ alongside the end of the last block
+        std::vector<u8> blockBuffer; //!< The decompressed data of the block at 'cachedBlock'
+        size_t cachedBlock{std::numeric_limits<size_t>::max()};
+
+        std::vector<u8> streamInput; //!< The compressed data of a solid NCZ which is yet to be consumed by the stream
+        size_t streamInputPosition{}; //!< The position of the stream in 'streamInput'
+        size_t streamCompressedOffset{}; //!< The offset in the NCZ of the data after 'streamInput'
+        size_t streamOffset{}; //!< The offset in the NCA body of the next byte decompressed from the stream
+
+        /**
+         * @brief Decompresses the block with the supplied index into 'blockBuffer', blocks which don't compress are stored uncompressed
+         */
+        void LoadBlock(size_t index);
+
+        /**
+         * @brief Decompresses data from the NCA body into the supplied buffer
+         * @param offset The offset in the NCA body, this excludes the header
+         */
+        void Decompress(span<u8> output, size_t offset);
+
+        /**
+         * @brief Decompresses data from a solid NCZ, the stream is restarted if the offset precedes the current position in it
+         */
+        void DecompressStream(span<u8> output, size_t offset);
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+      public:
+        NczBacking(std::shared_ptr<Backing> backing);
+
+        ~NczBacking();
+    };
+}
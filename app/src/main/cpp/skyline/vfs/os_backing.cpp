@@ -22,6 +22,13 @@ namespace skyline::vfs {
 
     size_t OsBacking::ReadImpl(span<u8> output, size_t offset) {
         auto ret{pread64(fd, output.data(), output.size(), static_cast<off64_t>(offset))};
+        if (ret < 0 && errno == EFAULT) {
+            // The kernel fails with EFAULT rather than raising SIGSEGV when writing into pages that are protected by the write tracker, the data is read into a bounce buffer and copied from userspace instead so the fault can be handled
+            std::vector<u8> buffer(output.size());
+            ret = pread64(fd, buffer.data(), buffer.size(), static_cast<off64_t>(offset));
+            if (ret > 0)
+                std::memcpy(output.data(), buffer.data(), static_cast<size_t>(ret));
+        }
         if (ret < 0)
             throw exception("Failed to read from fd: {}", strerror(errno));
 
@@ -30,6 +37,11 @@ namespace skyline::vfs {
 
     size_t OsBacking::WriteImpl(span<u8> input, size_t offset) {
         auto ret{pwrite64(fd, input.data(), input.size(), static_cast<off64_t>(offset))};
+        if (ret < 0 && errno == EFAULT) {
+            // Reads of pages that have all accesses trapped fail in the same way as above, the data is copied into a bounce buffer from userspace first
+            std::vector<u8> buffer(input.begin(), input.end());
+            ret = pwrite64(fd, buffer.data(), buffer.size(), static_cast<off64_t>(offset));
+        }
         if (ret < 0)
             throw exception("Failed to write to fd: {}", strerror(errno));
 
@@ -43,4 +55,9 @@ namespace skyline::vfs {
 
         size = pSize;
     }
+
+    void OsBacking::FlushImpl() {
+        if (mode.write && fsync(fd) < 0)
+            throw exception("Failed to sync file: {}", strerror(errno));
+    }
 }
@@ -9,6 +9,50 @@
 #include "os_filesystem.h"
 
 namespace skyline::vfs {
+    /**
+     * @brief A process-wide cache of the types of entries in OS filesystems keyed by their full path, this includes entries that don't exist as titles commonly probe for many optional files
+     * @note The cache is write-through, it's cleared whenever an entry is created through an OsFileSystem; changes made outside of the emulator while a title is running aren't observed
+     */
+    class EntryTypeCache {
+      private:
+        static constexpr size_t MaxEntries{0x1000}; //!< The maximum amount of cached entries, the cache is cleared entirely when this is exceeded
+
+        std::mutex mutex;
+        std::unordered_map<std::string, std::optional<Directory::EntryType>> entries;
+
+      public:
+        /**
+         * @note The cache is intentionally leaked as filesystems may be destroyed during static destruction
+         */
+        static EntryTypeCache &Get() {
+            static auto *cache{new EntryTypeCache()};
+            return *cache;
+        }
+
+        /**
+         * @return The cached type of the entry if it's present in the cache, the inner optional is empty if the entry doesn't exist
+         */
+        std::optional<std::optional<Directory::EntryType>> Lookup(const std::string &path) {
+            std::scoped_lock lock(mutex);
+            auto it{entries.find(path)};
+            if (it == entries.end())
+                return std::nullopt;
+            return it->second;
+        }
+
+        void Insert(const std::string &path, std::optional<Directory::EntryType> type) {
+            std::scoped_lock lock(mutex);
+            if (entries.size() >= MaxEntries)
+                entries.clear();
+            entries.insert_or_assign(path, type);
+        }
+
+        void Clear() {
+            std::scoped_lock lock(mutex);
+            entries.clear();
+        }
+    };
+
     OsFileSystem::OsFileSystem(const std::string &basePath) : FileSystem(), basePath(basePath.ends_with('/') ? basePath : basePath + '/') {
         if (!DirectoryExists(basePath))
             if (!CreateDirectory(basePath, true))
@@ -17,6 +61,7 @@ namespace skyline::vfs {
 
     bool OsFileSystem::CreateFileImpl(const std::string &path, size_t size) {
         auto fullPath{basePath + path};
+        EntryTypeCache::Get().Clear();
 
         // Create a directory that will hold the file
         CreateDirectory(fullPath.substr(0, fullPath.find_last_of('/')), true);
@@ -39,6 +84,9 @@ namespace skyline::vfs {
     }
 
     bool OsFileSystem::CreateDirectoryImpl(const std::string &path, bool parents) {
+        // Creating a directory may create any amount of parent directories, it's rare enough that dropping every cached entry is simpler than tracking them
+        EntryTypeCache::Get().Clear();
+
         if (!parents) {
             int ret{mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH)};
             return ret == 0 || errno == EEXIST;
@@ -68,17 +116,20 @@ namespace skyline::vfs {
 
     std::optional<Directory::EntryType> OsFileSystem::GetEntryTypeImpl(const std::string &path) {
         auto fullPath{basePath + path};
+        while (fullPath.size() > 1 && fullPath.ends_with('/'))
+            fullPath.pop_back();
 
-        auto directory{opendir(fullPath.c_str())};
-        if (directory) {
-            closedir(directory);
-            return Directory::EntryType::Directory;
-        }
+        auto &cache{EntryTypeCache::Get()};
+        if (auto cached{cache.Lookup(fullPath)})
+            return *cached;
 
-        if (access(fullPath.c_str(), F_OK) != -1)
-            return Directory::EntryType::File;
+        std::optional<Directory::EntryType> type;
+        struct stat entryInfo;
+        if (stat(fullPath.c_str(), &entryInfo) == 0)
+            type = S_ISDIR(entryInfo.st_mode) ? Directory::EntryType::Directory : Directory::EntryType::File;
 
-        return std::nullopt;
+        cache.Insert(fullPath, type);
+        return type;
     }
 
     std::shared_ptr<Directory> OsFileSystem::OpenDirectoryImpl(const std::string &path, Directory::ListMode listMode) {
@@ -99,18 +150,27 @@ namespace skyline::vfs {
             throw exception("Failed to open directory: {}, error: {}", path, strerror(errno));
 
         while ((entry = readdir(directory))) {
-            struct stat entryInfo;
-            if (stat((path + std::string(entry->d_name)).c_str(), &entryInfo))
-                throw exception("Failed to stat directory entry: {}, error: {}", entry->d_name, strerror(errno));
+            // The type from the directory entry is used when it's available as only files need to be stat-ed for their size
+            bool isDirectory{entry->d_type == DT_DIR}, isFile{entry->d_type == DT_REG};
+            struct stat entryInfo{};
+            if (entry->d_type == DT_UNKNOWN || (isFile && listMode.file)) {
+                if (stat((path + std::string(entry->d_name)).c_str(), &entryInfo)) {
+                    int error{errno};
+                    closedir(directory);
+                    throw exception("Failed to stat directory entry: {}, error: {}", entry->d_name, strerror(error));
+                }
+                isDirectory = S_ISDIR(entryInfo.st_mode);
+                isFile = S_ISREG(entryInfo.st_mode);
+            }
 
             std::string name(entry->d_name);
-            if (S_ISDIR(entryInfo.st_mode) && listMode.directory && (name != ".") && (name != "..")) {
+            if (isDirectory && listMode.directory && (name != ".") && (name != "..")) {
                 outputEntries.push_back(Directory::Entry{
                     .type = Directory::EntryType::Directory,
                     .name = std::string(entry->d_name),
                     .size = 0,
                 });
-            } else if (S_ISREG(entryInfo.st_mode) && listMode.file) {
+            } else if (isFile && listMode.file) {
                 outputEntries.push_back(Directory::Entry{
                     .type = Directory::EntryType::File,
                     .name = std::string(entry->d_name),
@@ -118,6 +178,7 @@ namespace skyline::vfs {
                 });
             }
         }
+        closedir(directory);
 
         return outputEntries;
     }
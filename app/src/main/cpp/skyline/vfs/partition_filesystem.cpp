@@ -1,11 +1,13 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include "region_backing.h"
 #include "partition_filesystem.h"
 
 namespace skyline::vfs {
     PartitionFileSystem::PartitionFileSystem(const std::shared_ptr<Backing> &backing) : FileSystem(), backing(backing) {
+        TRACE_BOOT_PHASE(PartitionParsing, "PartitionFileSystem::PartitionFileSystem");
         header = backing->Read<FsHeader>();
 
         if (header.magic == util::MakeMagic<u32>("PFS0"))
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <thread>
+#include <condition_variable>
+#include <queue>
+#include "cached_backing.h"
+#include "read_ahead_backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A single background thread which reads prefetch requests from all ReadAheadBackings in FIFO order
+     */
+    class ReadAheadWorker {
+      private:
+        static constexpr size_t MaxPendingRequests{32}; //!< The maximum amount of queued requests, any further requests are dropped as the worker is too far behind for them to be useful
+
+        struct Request {
+            std::shared_ptr<Backing> backing;
+            size_t offset;
+            size_t size;
+        };
+
+        std::mutex mutex;
+        std::condition_variable requestCondition;
+        std::queue<Request> requests;
+        std::thread thread;
+
+        ReadAheadWorker() : thread(&ReadAheadWorker::Run, this) {}
+
+        [[noreturn]] void Run() {
+            pthread_setname_np(pthread_self(), "Sky-ReadAhead");
+
+            std::vector<u8> scratch(BlockCache::BlockSize);
+            while (true) {
+                Request request;
+                {
+                    std::unique_lock lock(mutex);
+                    requestCondition.wait(lock, [&]() { return !requests.empty(); });
+                    request = std::move(requests.front());
+                    requests.pop();
+                }
+
+                try {
+                    for (size_t offset{request.offset}, end{request.offset + request.size}; offset < end; offset += scratch.size())
+                        if (request.backing->ReadUnchecked(span<u8>(scratch).first(std::min(scratch.size(), end - offset)), offset) == 0)
+                            break;
+                } catch (const std::exception &e) {
+                    Logger::Warn("Failed to prefetch 0x{:X} bytes at 0x{:X}: {}", request.size, request.offset, e.what());
+                }
+            }
+        }
+
+      public:
+        /**
+         * @note The worker is intentionally leaked as its thread runs for the lifetime of the process
+         */
+        static ReadAheadWorker &Get() {
+            static auto *worker{new ReadAheadWorker()};
+            return *worker;
+        }
+
+        void Queue(std::shared_ptr<Backing> backing, size_t offset, size_t size) {
+            {
+                std::scoped_lock lock(mutex);
+                if (requests.size() >= MaxPendingRequests)
+                    return;
+                requests.push(Request{std::move(backing), offset, size});
+            }
+            requestCondition.notify_one();
+        }
+    };
+
+    ReadAheadBacking::ReadAheadBacking(std::shared_ptr<Backing> pBacking, size_t prefetchBlocks) : Backing(pBacking->mode, pBacking->size), backing(std::move(pBacking)), prefetchSize(prefetchBlocks * BlockCache::BlockSize) {
+        if (mode.write || mode.append)
+            throw exception("Cannot open a ReadAheadBacking as writable");
+    }
+
+    void ReadAheadBacking::TrackRead(size_t offset, size_t readSize) {
+        size_t end{offset + readSize};
+        size_t prefetchOffset{}, prefetchLength{};
+        {
+            std::scoped_lock lock(mutex);
+            auto stream{std::find_if(streams.begin(), streams.end(), [&](const Stream &stream) { return stream.lastUse && stream.nextOffset == offset; })};
+            if (stream != streams.end()) {
+                stream->sequentialReads++;
+            } else {
+                stream = std::min_element(streams.begin(), streams.end(), [](const Stream &a, const Stream &b) { return a.lastUse < b.lastUse; });
+                *stream = Stream{};
+            }
+
+            stream->nextOffset = end;
+            stream->lastUse = ++useCounter;
+            stream->prefetchEnd = std::max(stream->prefetchEnd, end);
+
+            // The window is only refilled once half of it has been consumed so prefetch requests are reasonably large
+            size_t target{std::min(end + prefetchSize, size)};
+            if (stream->sequentialReads >= SequentialThreshold && stream->prefetchEnd + (prefetchSize / 2) <= target) {
+                prefetchOffset = stream->prefetchEnd;
+                prefetchLength = target - prefetchOffset;
+                stream->prefetchEnd = target;
+            }
+        }
+
+        if (prefetchLength)
+            ReadAheadWorker::Get().Queue(backing, prefetchOffset, prefetchLength);
+    }
+
+    size_t ReadAheadBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (BlockCache::Get().IsEnabled() && offset < size)
+            TrackRead(offset, std::min(output.size(), size - offset));
+
+        return backing->ReadUnchecked(output, offset);
+    }
+}
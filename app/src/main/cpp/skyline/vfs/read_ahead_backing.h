@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A read-only backing which detects sequential reads and prefetches the data following them on a background thread, this is intended for streamed assets so they're already in the BlockCache by the time the guest reads them
+     * @note The prefetched data itself is discarded, only the side effect of reading it through any CachedBacking in the parent's stack is used; prefetching is skipped entirely while the BlockCache is disabled
+     * @note Several independent streams are tracked as guests commonly read multiple files from the same storage in an interleaved manner
+     */
+    class ReadAheadBacking : public Backing {
+      private:
+        static constexpr size_t StreamCount{4}; //!< The amount of sequential streams that are tracked simultaneously
+        static constexpr u32 SequentialThreshold{2}; //!< The amount of consecutive sequential reads in a stream prior to prefetching for it
+
+        struct Stream {
+            size_t nextOffset{}; //!< The offset directly after the last read in the stream
+            size_t prefetchEnd{}; //!< The end of the range that has been queued for prefetching
+            u32 sequentialReads{}; //!< The amount of consecutive reads that continued the stream
+            u64 lastUse{}; //!< The value of the use counter at the last read in the stream, streams are replaced in LRU order
+        };
+
+        std::shared_ptr<Backing> backing;
+        size_t prefetchSize; //!< The amount of data that is prefetched ahead of a sequential stream
+        std::mutex mutex; //!< Synchronizes the stream state
+        std::array<Stream, StreamCount> streams{};
+        u64 useCounter{};
+
+        /**
+         * @brief Updates the stream state with a read and queues a prefetch if it continues a sequential stream
+         */
+        void TrackRead(size_t offset, size_t readSize);
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+        std::optional<span<u8>> MapImpl(size_t offset, size_t mapSize) override {
+            return backing->Map(offset, mapSize);
+        }
+
+      public:
+        /**
+         * @param prefetchBlocks The amount of BlockCache blocks to prefetch ahead of a sequential stream
+         */
+        ReadAheadBacking(std::shared_ptr<Backing> backing, size_t prefetchBlocks = 8);
+    };
+}
@@ -19,6 +19,10 @@ namespace skyline::vfs {
             return backing->ReadUnchecked(output, baseOffset + offset);
         }
 
+        std::optional<span<u8>> MapImpl(size_t offset, size_t mapSize) override {
+            return backing->Map(baseOffset + offset, mapSize);
+        }
+
       public:
         /**
          * @param file The backing to create the RegionBacking from
@@ -1,117 +1,181 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include "region_backing.h"
 #include "rom_filesystem.h"
 
 namespace skyline::vfs {
-    RomFileSystem::RomFileSystem(std::shared_ptr<Backing> pBacking) : FileSystem(), backing(std::move(pBacking)) {
-        header = backing->Read<RomFsHeader>();
-        TraverseDirectory(0, "");
+    RomFileSystem::Metadata::Metadata(Backing &backing, const RomFsHeader &header) {
+        // The tables are practically always contiguous so they're accessed as a single range
+        tablesOffset = std::min({header.dirHashTableOffset, header.dirMetaTableOffset, header.fileHashTableOffset, header.fileMetaTableOffset});
+        size_t tablesEnd{std::max({header.dirHashTableOffset + header.dirHashTableSize, header.dirMetaTableOffset + header.dirMetaTableSize, header.fileHashTableOffset + header.fileHashTableSize, header.fileMetaTableOffset + header.fileMetaTableSize})};
+
+        if (auto mapping{backing.Map(tablesOffset, tablesEnd - tablesOffset)}) {
+            tables = *mapping;
+        } else {
+            buffer.resize(tablesEnd - tablesOffset);
+            backing.Read(buffer, tablesOffset);
+            tables = buffer;
+        }
+
+        dirHashTable = GetTable(header.dirHashTableOffset, header.dirHashTableSize).cast<u32, std::dynamic_extent, true>();
+        dirMetaTable = GetTable(header.dirMetaTableOffset, header.dirMetaTableSize);
+        fileHashTable = GetTable(header.fileHashTableOffset, header.fileHashTableSize).cast<u32, std::dynamic_extent, true>();
+        fileMetaTable = GetTable(header.fileMetaTableOffset, header.fileMetaTableSize);
     }
 
-    void RomFileSystem::TraverseFiles(u32 offset, const std::string &path) {
-        RomFsFileEntry entry;
-        do {
-            entry = backing->Read<RomFsFileEntry>(header.fileMetaTableOffset + offset);
+    span<u8> RomFileSystem::Metadata::GetTable(u64 offset, u64 size) const {
+        return tables.subspan(offset - tablesOffset, size);
+    }
+
+    /**
+     * @return The entry at the supplied offset in a metadata table alongside the name directly following it
+     */
+    template<typename EntryType>
+    static std::pair<EntryType, std::string_view> GetEntry(span<u8> table, u32 offset) {
+        if (offset > table.size() || table.size() - offset < sizeof(EntryType))
+            throw exception("RomFS entry is outside of its metadata table: 0x{:X}/0x{:X}", offset, table.size());
+
+        EntryType entry;
+        std::memcpy(&entry, table.data() + offset, sizeof(EntryType));
+
+        size_t nameOffset{offset + sizeof(EntryType)};
+        if (table.size() - nameOffset < entry.nameSize)
+            throw exception("RomFS entry name is outside of its metadata table: 0x{:X}/0x{:X}", nameOffset + entry.nameSize, table.size());
 
-            if (entry.nameSize) {
-                std::vector<char> name(entry.nameSize);
-                backing->Read(span(name), header.fileMetaTableOffset + offset + sizeof(RomFsFileEntry));
+        return {entry, std::string_view(reinterpret_cast<const char *>(table.data() + nameOffset), entry.nameSize)};
+    }
 
-                std::string fullPath{path + (path.empty() ? "" : "/") + std::string(name.data(), entry.nameSize)};
-                fileMap.emplace(fullPath, entry);
-            }
+    std::pair<RomFileSystem::RomFsDirectoryEntry, std::string_view> RomFileSystem::Metadata::GetDirectory(u32 offset) const {
+        return GetEntry<RomFsDirectoryEntry>(dirMetaTable, offset);
+    }
 
-            offset = entry.siblingOffset;
-        } while (offset != constant::RomFsEmptyEntry);
+    std::pair<RomFileSystem::RomFsFileEntry, std::string_view> RomFileSystem::Metadata::GetFile(u32 offset) const {
+        return GetEntry<RomFsFileEntry>(fileMetaTable, offset);
     }
 
-    void RomFileSystem::TraverseDirectory(u32 offset, const std::string &path) {
-        auto entry{backing->Read<RomFsDirectoryEntry>(header.dirMetaTableOffset + offset)};
+    /**
+     * @return The hash of an entry's name which determines its bucket in the hash table, this matches the hash used by HOS when building the image
+     */
+    static u32 CalculatePathHash(u32 parentOffset, std::string_view name) {
+        u32 hash{parentOffset ^ 123456789};
+        for (auto character : name) {
+            hash = (hash >> 5) | (hash << 27);
+            hash ^= static_cast<u8>(character);
+        }
+        return hash;
+    }
 
-        std::string childPath(path);
-        if (entry.nameSize) {
-            std::vector<char> name(entry.nameSize);
-            backing->Read(span(name), header.dirMetaTableOffset + offset + sizeof(RomFsDirectoryEntry));
-            childPath = path + (path.empty() ? "" : "/") + std::string(name.data(), entry.nameSize);
+    template<typename GetEntryFunction>
+    std::optional<u32> RomFileSystem::Metadata::FindChild(span<u32> hashTable, u32 parentOffset, std::string_view name, GetEntryFunction getEntry) {
+        if (hashTable.empty())
+            return std::nullopt;
+
+        u32 offset{hashTable[CalculatePathHash(parentOffset, name) % hashTable.size()]};
+        while (offset != constant::RomFsEmptyEntry) {
+            auto [entry, entryName]{getEntry(offset)};
+            if (entry.parentOffset == parentOffset && entryName == name)
+                return offset;
+            offset = entry.hashSiblingOffset;
         }
+        return std::nullopt;
+    }
 
-        directoryMap.emplace(childPath, entry);
+    std::optional<std::pair<u32, std::string_view>> RomFileSystem::Metadata::FindParent(std::string_view path) const {
+        u32 directoryOffset{RootDirectoryOffset};
+        size_t separator;
+        while ((separator = path.find('/')) != std::string_view::npos) {
+            auto component{path.substr(0, separator)};
+            path.remove_prefix(separator + 1);
+            if (component.empty())
+                continue; // Redundant separators are ignored
+
+            auto childOffset{FindChild(dirHashTable, directoryOffset, component, [this](u32 entryOffset) { return GetDirectory(entryOffset); })};
+            if (!childOffset)
+                return std::nullopt;
+            directoryOffset = *childOffset;
+        }
+        return std::make_pair(directoryOffset, path);
+    }
 
-        if (entry.fileOffset != constant::RomFsEmptyEntry)
-            TraverseFiles(entry.fileOffset, childPath);
+    std::optional<RomFileSystem::RomFsDirectoryEntry> RomFileSystem::Metadata::FindDirectory(std::string_view path) const {
+        auto parent{FindParent(path)};
+        if (!parent)
+            return std::nullopt;
 
-        if (entry.childOffset != constant::RomFsEmptyEntry)
-            TraverseDirectory(entry.childOffset, childPath);
+        auto [parentOffset, name]{*parent};
+        if (name.empty())
+            return GetDirectory(parentOffset).first;
 
-        if (entry.siblingOffset != constant::RomFsEmptyEntry)
-            TraverseDirectory(entry.siblingOffset, path);
+        auto offset{FindChild(dirHashTable, parentOffset, name, [this](u32 entryOffset) { return GetDirectory(entryOffset); })};
+        if (!offset)
+            return std::nullopt;
+        return GetDirectory(*offset).first;
+    }
+
+    std::optional<RomFileSystem::RomFsFileEntry> RomFileSystem::Metadata::FindFile(std::string_view path) const {
+        auto parent{FindParent(path)};
+        if (!parent || parent->second.empty())
+            return std::nullopt;
+
+        auto offset{FindChild(fileHashTable, parent->first, parent->second, [this](u32 entryOffset) { return GetFile(entryOffset); })};
+        if (!offset)
+            return std::nullopt;
+        return GetFile(*offset).first;
+    }
+
+    RomFileSystem::RomFileSystem(std::shared_ptr<Backing> pBacking) : FileSystem(), backing(std::move(pBacking)) {
+        TRACE_BOOT_PHASE(RomFsIndex, "RomFileSystem::RomFileSystem");
+        header = backing->Read<RomFsHeader>();
+        metadata = std::make_shared<Metadata>(*backing, header);
     }
 
     std::shared_ptr<Backing> RomFileSystem::OpenFileImpl(const std::string &path, Backing::Mode mode) {
-        try {
-            const auto &entry{fileMap.at(path)};
-            return std::make_shared<RegionBacking>(backing, header.dataOffset + entry.offset, entry.size, mode);
-        } catch (std::out_of_range &e) {
+        auto entry{metadata->FindFile(path)};
+        if (!entry)
             return nullptr;
-        }
+        return std::make_shared<RegionBacking>(backing, header.dataOffset + entry->offset, entry->size, mode);
     }
 
     std::optional<Directory::EntryType> RomFileSystem::GetEntryTypeImpl(const std::string &path) {
-        if (fileMap.count(path))
+        if (metadata->FindFile(path))
             return Directory::EntryType::File;
-        else if (directoryMap.count(path))
+        else if (metadata->FindDirectory(path))
             return Directory::EntryType::Directory;
 
         return std::nullopt;
     }
 
     std::shared_ptr<Directory> RomFileSystem::OpenDirectoryImpl(const std::string &path, Directory::ListMode listMode) {
-        try {
-            auto &entry{directoryMap.at(path)};
-            return std::make_shared<RomFileSystemDirectory>(backing, header, entry, listMode);
-        } catch (std::out_of_range &e) {
+        auto entry{metadata->FindDirectory(path)};
+        if (!entry)
             return nullptr;
-        }
+        return std::make_shared<RomFileSystemDirectory>(backing, metadata, *entry, listMode);
     }
 
-    RomFileSystemDirectory::RomFileSystemDirectory(std::shared_ptr<Backing> backing, const RomFileSystem::RomFsHeader &header, const RomFileSystem::RomFsDirectoryEntry &ownEntry, ListMode listMode) : Directory(listMode), backing(std::move(backing)), header(header), ownEntry(ownEntry) {}
+    RomFileSystemDirectory::RomFileSystemDirectory(std::shared_ptr<Backing> backing, std::shared_ptr<RomFileSystem::Metadata> metadata, const RomFileSystem::RomFsDirectoryEntry &ownEntry, ListMode listMode) : Directory(listMode), ownEntry(ownEntry), backing(std::move(backing)), metadata(std::move(metadata)) {}
 
     std::vector<RomFileSystemDirectory::Entry> RomFileSystemDirectory::Read() {
         std::vector<Entry> contents;
 
-        if (listMode.file) {
-            RomFileSystem::RomFsFileEntry romFsFileEntry;
+        if (listMode.file && ownEntry.fileOffset != constant::RomFsEmptyEntry) {
             u32 offset{ownEntry.fileOffset};
-
             do {
-                romFsFileEntry = backing->Read<RomFileSystem::RomFsFileEntry>(header.fileMetaTableOffset + offset);
-
-                if (romFsFileEntry.nameSize) {
-                    std::vector<char> name(romFsFileEntry.nameSize);
-                    backing->Read(span(name), header.fileMetaTableOffset + offset + sizeof(RomFileSystem::RomFsFileEntry));
-
-                    contents.emplace_back(Entry{std::string(name.data(), romFsFileEntry.nameSize), EntryType::File, romFsFileEntry.size});
-                }
+                auto [romFsFileEntry, name]{metadata->GetFile(offset)};
+                if (!name.empty())
+                    contents.emplace_back(Entry{std::string(name), EntryType::File, romFsFileEntry.size});
 
                 offset = romFsFileEntry.siblingOffset;
             } while (offset != constant::RomFsEmptyEntry);
         }
 
-        if (listMode.directory) {
-            RomFileSystem::RomFsDirectoryEntry romFsDirectoryEntry;
+        if (listMode.directory && ownEntry.childOffset != constant::RomFsEmptyEntry) {
             u32 offset{ownEntry.childOffset};
-
             do {
-                romFsDirectoryEntry = backing->Read<RomFileSystem::RomFsDirectoryEntry>(header.dirMetaTableOffset + offset);
-
-                if (romFsDirectoryEntry.nameSize) {
-                    std::vector<char> name(romFsDirectoryEntry.nameSize);
-                    backing->Read(span(name), header.dirMetaTableOffset + offset + sizeof(RomFileSystem::RomFsDirectoryEntry));
-
-                    contents.emplace_back(Entry{std::string(name.data(), romFsDirectoryEntry.nameSize), EntryType::Directory});
-                }
+                auto [romFsDirectoryEntry, name]{metadata->GetDirectory(offset)};
+                if (!name.empty())
+                    contents.emplace_back(Entry{std::string(name), EntryType::Directory});
 
                 offset = romFsDirectoryEntry.siblingOffset;
             } while (offset != constant::RomFsEmptyEntry);
@@ -18,20 +18,6 @@ namespace skyline {
           private:
             std::shared_ptr<Backing> backing;
 
-            /**
-             * @brief Traverses the sibling files of the given file and adds them to the file map
-             * @param offset The offset of the file entry to traverses the siblings of
-             * @param path The path to the parent directory of the supplied file entry
-             */
-            void TraverseFiles(u32 offset, const std::string &path);
-
-            /**
-             * @brief Traverses the directories within the given directory, adds them to the directory map and calls TraverseFiles on them
-             * @param offset The offset of the directory entry to traverses the directories in
-             * @param path The path to the supplied directory entry
-             */
-            void TraverseDirectory(u32 offset, const std::string &path);
-
           protected:
             std::shared_ptr<Backing> OpenFileImpl(const std::string &path, Backing::Mode mode) override;
 
@@ -59,7 +45,7 @@ namespace skyline {
                 u32 siblingOffset; //!< The offset from the directory metadata base of a sibling directory
                 u32 childOffset; //!< The offset from the directory metadata base of a child directory
                 u32 fileOffset; //!< The offset from the file metadata base of a child file
-                u32 hash; //!< The hash of the directory
+                u32 hashSiblingOffset; //!< The offset from the directory metadata base of the next directory in the same hash table bucket
                 u32 nameSize; //!< The size of the directory's name in bytes
             };
 
@@ -68,12 +54,70 @@ namespace skyline {
                 u32 siblingOffset; //!< The offset from the file metadata base of a sibling file
                 u64 offset; //!< The offset from the file data base of the file contents
                 u64 size; //!< The size of the file in bytes
-                u32 hash; //!< The hash of the file
+                u32 hashSiblingOffset; //!< The offset from the file metadata base of the next file in the same hash table bucket
                 u32 nameSize; //!< The size of the file's name in bytes
             };
 
-            std::unordered_map<std::string, RomFsFileEntry> fileMap; //!< A map that maps file names to their corresponding entry
-            std::unordered_map<std::string, RomFsDirectoryEntry> directoryMap; //!< A map that maps directory names to their corresponding entry
+            /**
+             * @brief The metadata tables of a RomFS, these are mapped directly from the backing when possible and are otherwise read into memory in a single read
+             * @note Paths are looked up through the hash tables in the image rather than a prebuilt index of all paths, this avoids walking the entire tree when the filesystem is opened
+             */
+            class Metadata {
+              private:
+                std::vector<u8> buffer; //!< The contents of the tables if the backing couldn't be mapped
+                span<u8> tables; //!< All metadata tables, this starts at the lowest table offset in the header
+                size_t tablesOffset; //!< The offset of the tables in the backing
+
+                span<u8> GetTable(u64 offset, u64 size) const;
+
+                /**
+                 * @return The offset of the child entry of a directory with the supplied name in its metadata table, if it exists
+                 * @param hashTable The hash table of the type of entry that is being looked up
+                 * @param getEntry A function returning the entry at an offset in the metadata table alongside its name
+                 */
+                template<typename GetEntryFunction>
+                static std::optional<u32> FindChild(span<u32> hashTable, u32 parentOffset, std::string_view name, GetEntryFunction getEntry);
+
+                /**
+                 * @return The offset of the directory containing the final component of the path alongside the final component itself, if all parent directories exist
+                 */
+                std::optional<std::pair<u32, std::string_view>> FindParent(std::string_view path) const;
+
+              public:
+                static constexpr u32 RootDirectoryOffset{0}; //!< The offset of the root directory in the directory metadata table
+
+                span<u32> dirHashTable; //!< A table of the offset of the first directory in every bucket
+                span<u8> dirMetaTable;
+                span<u32> fileHashTable; //!< A table of the offset of the first file in every bucket
+                span<u8> fileMetaTable;
+
+                /**
+                 * @note The backing must outlive the metadata as the tables may be mapped from it
+                 */
+                Metadata(Backing &backing, const RomFsHeader &header);
+
+                /**
+                 * @return The directory entry at the supplied offset in the directory metadata table alongside its name
+                 */
+                std::pair<RomFsDirectoryEntry, std::string_view> GetDirectory(u32 offset) const;
+
+                /**
+                 * @return The file entry at the supplied offset in the file metadata table alongside its name
+                 */
+                std::pair<RomFsFileEntry, std::string_view> GetFile(u32 offset) const;
+
+                /**
+                 * @return The directory entry at the supplied path, if it exists
+                 */
+                std::optional<RomFsDirectoryEntry> FindDirectory(std::string_view path) const;
+
+                /**
+                 * @return The file entry at the supplied path, if it exists
+                 */
+                std::optional<RomFsFileEntry> FindFile(std::string_view path) const;
+            };
+
+            std::shared_ptr<Metadata> metadata;
 
             RomFileSystem(std::shared_ptr<Backing> backing);
         };
@@ -84,11 +128,11 @@ namespace skyline {
         class RomFileSystemDirectory : public Directory {
           private:
             RomFileSystem::RomFsDirectoryEntry ownEntry; //!< This directory's entry in the RomFS header
-            RomFileSystem::RomFsHeader header; //!< A header of this files parent RomFS image
-            std::shared_ptr<Backing> backing;
+            std::shared_ptr<Backing> backing; //!< The backing of the parent RomFS image, this keeps any mapped metadata alive
+            std::shared_ptr<RomFileSystem::Metadata> metadata; //!< The metadata of the parent RomFS image
 
           public:
-            RomFileSystemDirectory(std::shared_ptr<Backing> backing, const RomFileSystem::RomFsHeader &header, const RomFileSystem::RomFsDirectoryEntry &ownEntry, ListMode listMode);
+            RomFileSystemDirectory(std::shared_ptr<Backing> backing, std::shared_ptr<RomFileSystem::Metadata> metadata, const RomFileSystem::RomFsDirectoryEntry &ownEntry, ListMode listMode);
 
             std::vector<Entry> Read();
         };
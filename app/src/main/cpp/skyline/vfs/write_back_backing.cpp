@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "write_back_backing.h"
+
+namespace skyline::vfs {
+    WriteBackBacking::WriteBackBacking(std::shared_ptr<Backing> pBacking) : Backing(pBacking->mode, pBacking->size), backing(std::move(pBacking)) {}
+
+    WriteBackBacking::~WriteBackBacking() {
+        try {
+            std::scoped_lock lock{mutex};
+            WriteBack();
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write back buffered data on closing a file: {}", e.what());
+        }
+    }
+
+    void WriteBackBacking::WriteBack() {
+        for (auto &[offset, data] : ranges)
+            if (backing->Write(data, offset) != data.size())
+                throw exception("Failed to write back 0x{:X} bytes at 0x{:X}", data.size(), offset);
+
+        ranges.clear();
+        bufferedSize = 0;
+    }
+
+    size_t WriteBackBacking::ReadImpl(span<u8> output, size_t offset) {
+        std::scoped_lock lock{mutex};
+
+        // Buffered data may extend the backing, only the part of the read which is in the underlying backing is read from it
+        size_t readSize{std::min(output.size(), size - std::min(offset, size))};
+        size_t backingSize{std::min(readSize, backing->size - std::min(offset, backing->size))};
+        size_t read{backingSize ? backing->ReadUnchecked(output.first(backingSize), offset) : 0};
+        if (read < readSize)
+            std::memset(output.data() + read, 0, readSize - read); // Any gap between the end of the underlying backing and buffered data past it reads as zero
+
+        auto end{offset + readSize};
+        auto it{ranges.upper_bound(offset)};
+        if (it != ranges.begin())
+            it = std::prev(it);
+        for (; it != ranges.end() && it->first < end; it++) {
+            auto rangeEnd{it->first + it->second.size()};
+            if (rangeEnd <= offset)
+                continue;
+
+            auto copyStart{std::max(it->first, offset)}, copyEnd{std::min(rangeEnd, end)};
+            std::memcpy(output.data() + (copyStart - offset), it->second.data() + (copyStart - it->first), copyEnd - copyStart);
+        }
+
+        return readSize;
+    }
+
+    size_t WriteBackBacking::WriteImpl(span<u8> input, size_t offset) {
+        std::scoped_lock lock{mutex};
+        auto end{offset + input.size()};
+
+        // Find the first range which overlaps or touches the written range, all following ranges up to the end of the write are merged into it
+        auto first{ranges.upper_bound(offset)};
+        if (first != ranges.begin() && std::prev(first)->first + std::prev(first)->second.size() >= offset)
+            first = std::prev(first);
+
+        auto last{first};
+        while (last != ranges.end() && last->first <= end)
+            last++;
+
+        if (first == last) {
+            ranges.emplace(offset, std::vector<u8>(input.begin(), input.end()));
+            bufferedSize += input.size();
+        } else {
+            // The data of the first range is reused when it starts prior to the write, sequential writes only have to append to it this way
+            auto lastEnd{std::max(end, std::prev(last)->first + std::prev(last)->second.size())};
+            auto start{std::min(offset, first->first)};
+            std::vector<u8> merged;
+            if (first->first == start) {
+                merged = std::move(first->second);
+                bufferedSize -= merged.size();
+                first++;
+            }
+            merged.resize(lastEnd - start);
+
+            for (auto it{first}; it != last; it++) {
+                std::memcpy(merged.data() + (it->first - start), it->second.data(), it->second.size());
+                bufferedSize -= it->second.size();
+            }
+            std::memcpy(merged.data() + (offset - start), input.data(), input.size());
+
+            ranges.erase(ranges.lower_bound(start), last);
+            bufferedSize += merged.size();
+            ranges.emplace(start, std::move(merged));
+        }
+
+        if (end > size)
+            size = end;
+
+        if (bufferedSize > MaxBufferedSize)
+            WriteBack();
+
+        return input.size();
+    }
+
+    void WriteBackBacking::ResizeImpl(size_t pSize) {
+        std::scoped_lock lock{mutex};
+
+        // Buffered data past the new end is discarded as it'd be truncated by the resize regardless
+        for (auto it{ranges.lower_bound(pSize)}; it != ranges.end(); it = ranges.erase(it))
+            bufferedSize -= it->second.size();
+        if (!ranges.empty()) {
+            auto &[offset, data]{*ranges.rbegin()};
+            if (offset + data.size() > pSize) {
+                bufferedSize -= offset + data.size() - pSize;
+                data.resize(pSize - offset);
+            }
+        }
+
+        backing->Resize(pSize);
+        size = pSize;
+    }
+
+    void WriteBackBacking::FlushImpl() {
+        std::scoped_lock lock{mutex};
+        WriteBack();
+        backing->Flush();
+    }
+}
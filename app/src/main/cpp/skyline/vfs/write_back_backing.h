@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A backing which buffers all writes to another backing in memory till it's flushed, this is intended for save data which guests commonly write in a large amount of small writes
+     * @note Buffered writes are merged into contiguous ranges which are written back in offset order on flushing, followed by a single flush of the underlying backing
+     * @note Writes are also written back when the backing is destroyed or once the amount of buffered data exceeds MaxBufferedSize
+     */
+    class WriteBackBacking : public Backing {
+      private:
+        static constexpr size_t MaxBufferedSize{0x400000}; //!< The maximum amount of buffered data, any write past this flushes all buffered data
+
+        std::shared_ptr<Backing> backing;
+        std::mutex mutex; //!< Synchronizes all buffered ranges
+        std::map<size_t, std::vector<u8>> ranges; //!< A map from the offset of every contiguous buffered range to its data, ranges never overlap or touch each other
+        size_t bufferedSize{}; //!< The total size of all buffered ranges
+
+        /**
+         * @brief Writes all buffered ranges back into the underlying backing
+         * @note The mutex must be locked when calling this
+         */
+        void WriteBack();
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+        size_t WriteImpl(span<u8> input, size_t offset) override;
+
+        void ResizeImpl(size_t pSize) override;
+
+        void FlushImpl() override;
+
+      public:
+        WriteBackBacking(std::shared_ptr<Backing> backing);
+
+        ~WriteBackBacking();
+    };
+}
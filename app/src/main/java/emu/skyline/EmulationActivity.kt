@@ -21,8 +21,11 @@ import dagger.hilt.android.AndroidEntryPoint
 import emu.skyline.databinding.EmuActivityBinding
 import emu.skyline.input.*
 import emu.skyline.loader.getRomFormat
+import emu.skyline.utils.PerformanceCounters
 import emu.skyline.utils.Settings
 import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import javax.inject.Inject
 import kotlin.math.abs
 
@@ -36,6 +39,11 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
          * The Kotlin thread on which emulation code executes
          */
         private var emulationThread : Thread? = null
+
+        /**
+         * The size of a single skyline::input::HostInputEvent in bytes
+         */
+        private const val InputEventSize = 0x10
     }
 
     private val binding by lazy { EmuActivityBinding.inflate(layoutInflater) }
@@ -71,8 +79,10 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
      * @param preferenceFd The file descriptor of the Preference XML
      * @param appFilesPath The full path to the app files directory
      * @param assetManager The asset manager used for accessing app assets
+     * @param automationFrames The amount of frames after which an automated benchmark run is finished, 0 runs emulation normally
+     * @param automationInput The path to an input replay file for an automated benchmark run, this may be empty
      */
-    private external fun executeApplication(romUri : String, romType : Int, romFd : Int, preferenceFd : Int, language : Int, appFilesPath : String, assetManager : AssetManager)
+    private external fun executeApplication(romUri : String, romType : Int, romFd : Int, preferenceFd : Int, language : Int, appFilesPath : String, assetManager : AssetManager, automationFrames : Int, automationInput : String)
 
     /**
      * @param join If the function should only return after all the threads join or immediately
@@ -93,14 +103,21 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
      */
     private external fun changeAudioStatus(play : Boolean)
 
-    var fps : Int = 0
-    var averageFrametime : Float = 0.0f
-    var averageFrametimeDeviation : Float = 0.0f
+    /**
+     * @return A direct buffer backed by the native performance counters, it remains valid for the lifetime of the process
+     */
+    private external fun getPerformanceCounters() : ByteBuffer
 
     /**
-     * Writes the current performance statistics into [fps], [averageFrametime] and [averageFrametimeDeviation] fields
+     * @param count The maximum amount of calls to return
+     * @return A line for each of the HLE calls (SVCs and service commands) with the highest tail latency, these include their amount of calls alongside their average, 99th percentile and maximum latency
      */
-    private external fun updatePerformanceStatistics()
+    external fun getHleLatencies(count : Int) : String
+
+    /**
+     * @return The amount of memory in bytes accounted to the guest heap, shared memory, texture images, staging buffers, the pipeline cache, the shader cache, audio buffers and the VFS block cache in that order
+     */
+    external fun getMemoryUsage() : LongArray
 
     /**
      * This initializes a guest controller in libskyline
@@ -120,22 +137,54 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
     private external fun updateControllers()
 
     /**
-     * This sets the state of the buttons specified in the mask on a specific controller
+     * This submits a batch of input events to libskyline, this is done once per host event to avoid a JNI transition for every button and axis in it
+     *
+     * @param events A direct buffer of skyline::input::HostInputEvent in C++
+     * @param count The amount of events in the buffer
+     */
+    private external fun submitInputEvents(events : ByteBuffer, count : Int)
+
+    /**
+     * A buffer of input events that are pending submission, this is only accessed from the UI thread
+     */
+    private val inputEvents = ByteBuffer.allocateDirect(InputEventSize * 64).order(ByteOrder.nativeOrder())
+
+    /**
+     * This queues a change in the state of the buttons specified in the mask on a specific controller
      *
      * @param index The index of the controller this is directed to
      * @param mask The mask of the button that are being set
      * @param pressed If the buttons are being pressed or released
      */
-    private external fun setButtonState(index : Int, mask : Long, pressed : Boolean)
+    private fun setButtonState(index : Int, mask : Long, pressed : Boolean) {
+        if (inputEvents.remaining() < InputEventSize)
+            flushInputEvents()
+        inputEvents.putInt(if (pressed) 0 else 1).putInt(index).putLong(mask)
+    }
 
     /**
-     * This sets the value of a specific axis on a specific controller
+     * This queues a change in the value of a specific axis on a specific controller
      *
      * @param index The index of the controller this is directed to
      * @param axis The ID of the axis that is being modified
      * @param value The value to set the axis to
      */
-    private external fun setAxisValue(index : Int, axis : Int, value : Int)
+    private fun setAxisValue(index : Int, axis : Int, value : Int) {
+        if (inputEvents.remaining() < InputEventSize)
+            flushInputEvents()
+        inputEvents.putInt(2).putInt(index).putInt(axis).putInt(value)
+    }
+
+    /**
+     * This submits all queued input events to libskyline
+     */
+    private fun flushInputEvents() {
+        val count = inputEvents.position() / InputEventSize
+        if (count != 0) {
+            submitInputEvents(inputEvents, count)
+            inputEvents.clear()
+        }
+    }
 
     /**
      * This sets the values of the points on the guest touch-screen
@@ -208,10 +257,13 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         val rom = intent.data!!
         val romType = getRomFormat(rom, contentResolver).ordinal
         val romFd = contentResolver.openFileDescriptor(rom, "r")!!
+        // Automated benchmark runs are requested through extras, e.g. `adb shell am start -n emu.skyline/.EmulationActivity -d <ROM URI> --ei automationFrames 600`
+        val automationFrames = intent.getIntExtra("automationFrames", 0)
+        val automationInput = intent.getStringExtra("automationInput") ?: ""
         val preferenceFd = ParcelFileDescriptor.open(File("${applicationInfo.dataDir}/shared_prefs/${applicationInfo.packageName}_preferences.xml"), ParcelFileDescriptor.MODE_READ_WRITE)
 
         emulationThread = Thread {
-            executeApplication(rom.toString(), romType, romFd.detachFd(), preferenceFd.detachFd(), settings.systemLanguage, applicationContext.filesDir.canonicalPath + "/", assets)
+            executeApplication(rom.toString(), romType, romFd.detachFd(), preferenceFd.detachFd(), settings.systemLanguage, applicationContext.filesDir.canonicalPath + "/", assets, automationFrames, automationInput)
             returnFromEmulation()
         }
 
@@ -244,11 +296,14 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         )
 
         if (settings.perfStats) {
+            val counters = PerformanceCounters(getPerformanceCounters())
             binding.perfStats.apply {
                 postDelayed(object : Runnable {
                     override fun run() {
-                        updatePerformanceStatistics()
-                        text = "$fps FPS\n${"%.1f".format(averageFrametime)}±${"%.2f".format(averageFrametimeDeviation)}ms"
+                        counters.run {
+                            val cores = (0 until PerformanceCounters.CoreCount).joinToString("/") { "%.0f".format(coreUtilization(it)) }
+                            text = "$fps FPS\n${"%.1f".format(averageFrametime)}±${"%.2f".format(averageFrametimeDeviation)}ms\nCPU $cores%\nGPU ${"%.1f".format(gpuTime)}ms\n${textureMemory / (1024 * 1024)} MiB Textures"
+                        }
                         postDelayed(this, 250)
                     }
                 }, 250)
@@ -360,13 +415,16 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
 
         return when (val guestEvent = inputManager.eventMap[KeyHostEvent(event.device.descriptor, event.keyCode)]) {
             is ButtonGuestEvent -> {
-                if (guestEvent.button != ButtonId.Menu)
+                if (guestEvent.button != ButtonId.Menu) {
                     setButtonState(guestEvent.id, guestEvent.button.value(), action.state)
+                    flushInputEvents()
+                }
                 true
             }
 
             is AxisGuestEvent -> {
                 setAxisValue(guestEvent.id, guestEvent.axis.ordinal, (if (action == ButtonState.Pressed) if (guestEvent.polarity) Short.MAX_VALUE else Short.MIN_VALUE else 0).toInt())
+                flushInputEvents()
                 true
             }
 
@@ -427,6 +485,7 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
                     axesHistory[axisItem.index] = value
                 }
 
+                flushInputEvents()
                 return true
             } else {
                 oldHat = hat
@@ -460,11 +519,15 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         return true
     }
 
-    private fun onButtonStateChanged(buttonId : ButtonId, state : ButtonState) = setButtonState(0, buttonId.value(), state.state)
+    private fun onButtonStateChanged(buttonId : ButtonId, state : ButtonState) {
+        setButtonState(0, buttonId.value(), state.state)
+        flushInputEvents()
+    }
 
     private fun onStickStateChanged(stickId : StickId, position : PointF) {
         setAxisValue(0, stickId.xAxis.ordinal, (position.x * Short.MAX_VALUE).toInt())
         setAxisValue(0, stickId.yAxis.ordinal, (-position.y * Short.MAX_VALUE).toInt()) // Y is inverted, since drawing starts from top left
+        flushInputEvents()
     }
 
     @SuppressLint("WrongConstant")
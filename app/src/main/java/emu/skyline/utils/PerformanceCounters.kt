@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: MPL-2.0
+ * Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+ */
+
+package emu.skyline.utils
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * A reader for the performance counters which are written by native code into a direct buffer, reading these doesn't require any JNI calls
+ * @note The offsets must be kept in sync with skyline::perf::Counters in performance_counters.h
+ */
+class PerformanceCounters(buffer : ByteBuffer) {
+    companion object {
+        const val CoreCount = 4
+
+        private const val PresentCountOffset = 0x0
+        private const val FpsOffset = 0x4
+        private const val AverageFrametimeOffset = 0x8
+        private const val AverageFrametimeDeviationOffset = 0xC
+        private const val CoreUtilizationOffset = 0x10
+        private const val GpuTimeOffset = 0x20
+        private const val GpfifoDepthOffset = 0x24
+        private const val AudioUnderrunsOffset = 0x28
+        private const val TextureMemoryOffset = 0x30
+    }
+
+    private val buffer = buffer.order(ByteOrder.nativeOrder())
+
+    /**
+     * The amount of frames presented, this changes after all other per-frame counters have been updated
+     */
+    val presentCount get() = buffer.getInt(PresentCountOffset)
+
+    val fps get() = buffer.getInt(FpsOffset)
+
+    val averageFrametime get() = buffer.getFloat(AverageFrametimeOffset)
+
+    val averageFrametimeDeviation get() = buffer.getFloat(AverageFrametimeDeviationOffset)
+
+    /**
+     * @return The percentage of time guest threads held the supplied guest core for since the last frame
+     */
+    fun coreUtilization(core : Int) = buffer.getFloat(CoreUtilizationOffset + core * Float.SIZE_BYTES)
+
+    /**
+     * The GPU execution time of the last frame in milliseconds, this is always zero if the GPU doesn't support timestamp queries
+     */
+    val gpuTime get() = buffer.getFloat(GpuTimeOffset)
+
+    val gpfifoDepth get() = buffer.getInt(GpfifoDepthOffset)
+
+    val audioUnderruns get() = buffer.getInt(AudioUnderrunsOffset)
+
+    /**
+     * The amount of device memory used by textures in bytes
+     */
+    val textureMemory get() = buffer.getLong(TextureMemoryOffset)
+}
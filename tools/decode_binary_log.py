@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MPL-2.0
+# Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+"""
+Decodes a binary log (emulation.skblog) written by Skyline into the textual log format (emulation.sklog)
+The string table is read from the file with the same path and a ".strings" suffix, it must be pulled from the device alongside the log
+This must be kept in sync with the binary format in app/src/main/cpp/skyline/common/logger.cpp
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LOG_MAGIC = b"SKYBLOG\0"
+LOG_VERSION = 1
+LOG_HEADER = struct.Struct("<8sIIQQq")  # magic, version, headerSize, ringSize, writeOffset, startTime
+RECORD_MAGIC = 0x52594B53  # "SKYR"
+RECORD_HEADER = struct.Struct("<IIqIIB")  # magic, size, timestamp, threadId, formatId, level
+STRING_ENTRY = struct.Struct("<BII")  # type, id, length
+
+STRING_FORMAT, STRING_THREAD = range(2)
+ARGUMENT_SIGNED, ARGUMENT_UNSIGNED, ARGUMENT_FLOAT, ARGUMENT_BOOL, ARGUMENT_CHAR, ARGUMENT_STRING = range(6)
+LEVEL_CHARACTERS = "EWIDV"
+
+
+def read_string_table(path):
+    """
+    :return: A mapping from format IDs to their function and format string alongside a mapping from thread IDs to their names
+    """
+    formats, threads = {}, {}
+    with open(path, "rb") as file:
+        data = file.read()
+
+    offset = 0
+    while offset + STRING_ENTRY.size <= len(data):
+        entry_type, entry_id, length = STRING_ENTRY.unpack_from(data, offset)
+        offset += STRING_ENTRY.size
+        string = data[offset:offset + length].decode("utf-8", "replace")
+        offset += length
+
+        if entry_type == STRING_FORMAT:
+            function, _, format_string = string.partition("\0")
+            formats[entry_id] = (function, format_string)
+        elif entry_type == STRING_THREAD:
+            threads[entry_id] = string  # Threads may be renamed, we only retain the latest name as records aren't ordered relative to the table
+
+    return formats, threads
+
+
+def read_arguments(payload):
+    """
+    :return: A list of the arguments serialized in a record's payload, truncated payloads yield all complete arguments
+    """
+    arguments = []
+    offset = 0
+    while offset < len(payload):
+        argument_type = payload[offset]
+        offset += 1
+        try:
+            if argument_type == ARGUMENT_SIGNED:
+                value, = struct.unpack_from("<q", payload, offset)
+                offset += 8
+            elif argument_type == ARGUMENT_UNSIGNED:
+                value, = struct.unpack_from("<Q", payload, offset)
+                offset += 8
+            elif argument_type == ARGUMENT_FLOAT:
+                value, = struct.unpack_from("<d", payload, offset)
+                offset += 8
+            elif argument_type == ARGUMENT_BOOL:
+                value = "true" if payload[offset] else "false"  # fmt formats booleans in lowercase
+                offset += 1
+            elif argument_type == ARGUMENT_CHAR:
+                value = chr(payload[offset])
+                offset += 1
+            elif argument_type == ARGUMENT_STRING:
+                length, = struct.unpack_from("<I", payload, offset)
+                offset += 4
+                value = payload[offset:offset + length].decode("utf-8", "replace")
+                offset += length
+            else:
+                break
+        except (struct.error, IndexError):
+            break
+        arguments.append(value)
+    return arguments
+
+
+REPLACEMENT_FIELD = re.compile(r"{{|}}|{[^{}]*}")
+
+
+def format_message(format_string, arguments):
+    """
+    :return: The format string formatted with the arguments, fmt specifications that Python doesn't support are dropped with the affected arguments formatted as-is
+    """
+    try:
+        return format_string.format(*arguments)
+    except (ValueError, IndexError, KeyError, TypeError):
+        pass
+
+    remaining = iter(arguments)
+
+    def replace(match):
+        field = match.group(0)
+        if field in ("{{", "}}"):
+            return field[0]
+        try:
+            argument = next(remaining)
+        except StopIteration:
+            return field
+        try:
+            return ("{" + field[1:-1] + "}").format(argument)
+        except (ValueError, IndexError, KeyError, TypeError):
+            return str(argument)
+
+    return REPLACEMENT_FIELD.sub(replace, format_string)
+
+
+def decode(log_path, strings_path, output):
+    with open(log_path, "rb") as file:
+        data = file.read()
+
+    magic, version, header_size, ring_size, write_offset, start_time = LOG_HEADER.unpack_from(data, 0)
+    if magic != LOG_MAGIC:
+        raise ValueError(f"'{log_path}' is not a binary log")
+    if version != LOG_VERSION:
+        raise ValueError(f"Unsupported binary log version: {version}")
+
+    ring = data[header_size:header_size + ring_size]
+    if write_offset > ring_size:
+        # The ring has wrapped around, records are unrolled starting from the oldest one so they're contiguous
+        split = write_offset % ring_size
+        ring = ring[split:] + ring[:split]
+        offset = ring.find(struct.pack("<I", RECORD_MAGIC))  # The oldest record may have been partially overwritten
+        if offset < 0:
+            return
+    else:
+        ring = ring[:write_offset]
+        offset = 0
+
+    formats, threads = read_string_table(strings_path)
+
+    while offset + RECORD_HEADER.size <= len(ring):
+        magic, size, timestamp, thread_id, format_id, level = RECORD_HEADER.unpack_from(ring, offset)
+        if magic != RECORD_MAGIC or size < RECORD_HEADER.size:
+            # This should only happen at the point where the ring was overwritten, we try to resynchronize on the next record
+            next_offset = ring.find(struct.pack("<I", RECORD_MAGIC), offset + 1)
+            if next_offset < 0:
+                break
+            offset = next_offset
+            continue
+
+        payload = ring[offset + RECORD_HEADER.size:offset + size]
+        offset += size
+
+        if format_id:
+            function, format_string = formats.get(format_id, ("Unknown", f"<Unknown format {format_id}>"))
+            message = f"{function}: {format_message(format_string, read_arguments(payload))}"
+        else:
+            message = payload.decode("utf-8", "replace")
+
+        level_character = LEVEL_CHARACTERS[level] if level < len(LEVEL_CHARACTERS) else "?"
+        thread_name = threads.get(thread_id, str(thread_id))
+        output.write(f"\036{level_character}\035{timestamp}\035{thread_name}\035{message}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes a binary Skyline log into the textual log format")
+    parser.add_argument("log", help="The path to the binary log (emulation.skblog)")
+    parser.add_argument("-s", "--strings", help="The path to the string table, this defaults to the log path with a '.strings' suffix")
+    parser.add_argument("-o", "--output", help="The path to write the decoded log to, this defaults to stdout")
+    args = parser.parse_args()
+
+    output = open(args.output, "w", encoding="utf-8") if args.output else sys.stdout
+    try:
+        decode(args.log, args.strings or args.log + ".strings", output)
+    finally:
+        if output is not sys.stdout:
+            output.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MPL-2.0
+# Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+"""
+Decodes a GPFIFO capture (gpfifo_capture_<channel>.skgc) written by Skyline into the stream of method calls that the channel executed
+The output is deterministic for a given capture so it can be diffed between captures to find changes in what the guest submits
+This must be kept in sync with the capture format in app/src/main/cpp/skyline/soc/gm20b/gpfifo_capture.h
+"""
+
+import argparse
+import collections
+import struct
+import sys
+
+CAPTURE_MAGIC = 0x43474B53  # "SKGC"
+CAPTURE_VERSION = 1
+FILE_HEADER = struct.Struct("<II")  # magic, version
+RECORD_HEADER = struct.Struct("<II")  # type, size
+GP_ENTRY = struct.Struct("<II")  # entry0, entry1
+
+RECORD_GP_ENTRY, RECORD_FRAME = range(2)
+SEC_OP_GRP0_USE_TERT, SEC_OP_INC, SEC_OP_GRP2_USE_TERT, SEC_OP_NON_INC, SEC_OP_IMMEDIATE, SEC_OP_ONE_INC, SEC_OP_END = 0, 1, 2, 3, 4, 5, 7
+TERT_OP_GRP0_INC, TERT_OP_GRP2_NON_INC = 0, 0  # The legacy method formats, all other Grp0 TertOps only manipulate the subdevice mask
+SUBCHANNEL_NAMES = ["3D", "Compute", "I2M", "2D", "DMA", "SW5", "SW6", "SW7"]
+GPFIFO_REGISTER_COUNT = 0x40  # Methods below this are handled by the GPFIFO engine regardless of the subchannel
+
+
+class MethodDecoder:
+    """
+    Decodes pushbuffers into method calls, the state of a method that's split across pushbuffers is carried over between them
+    """
+
+    def __init__(self):
+        self.remaining = 0
+        self.address = 0
+        self.subchannel = 0
+        self.increment = False
+        self.one_increment = False
+
+    def _argument(self, argument):
+        yield self.subchannel, self.address, argument
+        if self.increment or self.one_increment:
+            self.address += 1
+            self.one_increment = False
+        self.remaining -= 1
+
+    def decode(self, words):
+        """
+        :return: A generator of (subchannel, method, argument) for every method call in the pushbuffer
+        """
+        index = 0
+        while index < len(words):
+            word = words[index]
+            index += 1
+
+            if self.remaining:
+                yield from self._argument(word)
+                continue
+
+            if word == 0:
+                continue  # An entry containing all zeroes is a NOP
+
+            address, subchannel, count, sec_op = word & 0xFFF, (word >> 13) & 0x7, (word >> 16) & 0x1FFF, word >> 29
+            if sec_op in (SEC_OP_INC, SEC_OP_NON_INC, SEC_OP_ONE_INC):
+                self.remaining, self.address, self.subchannel = count, address, subchannel
+                self.increment, self.one_increment = sec_op == SEC_OP_INC, sec_op == SEC_OP_ONE_INC
+            elif sec_op in (SEC_OP_GRP0_USE_TERT, SEC_OP_GRP2_USE_TERT):
+                tert_op = (word >> 16) & 0x3
+                if (sec_op == SEC_OP_GRP0_USE_TERT and tert_op == TERT_OP_GRP0_INC) or (sec_op == SEC_OP_GRP2_USE_TERT and tert_op == TERT_OP_GRP2_NON_INC):
+                    # The legacy formats have a byte address and an 11-bit count rather than the TertOp
+                    self.remaining, self.address, self.subchannel = (word >> 18) & 0x7FF, (word >> 2) & 0x7FF, subchannel
+                    self.increment, self.one_increment = sec_op == SEC_OP_GRP0_USE_TERT, False
+                elif sec_op == SEC_OP_GRP2_USE_TERT:
+                    raise ValueError(f"Unsupported pushbuffer method Grp2 TertOp: {tert_op}")
+                # Setting, storing or using the subdevice mask has no effect on the methods executed by a single GPU
+            elif sec_op == SEC_OP_IMMEDIATE:
+                yield subchannel, address, count
+            elif sec_op == SEC_OP_END:
+                return
+            else:
+                raise ValueError(f"Unsupported pushbuffer method SecOp: {sec_op}")
+
+
+def read_records(path):
+    """
+    :return: A generator of (type, payload) for every record in the capture
+    """
+    with open(path, "rb") as file:
+        data = file.read()
+
+    magic, version = FILE_HEADER.unpack_from(data, 0)
+    if magic != CAPTURE_MAGIC or version != CAPTURE_VERSION:
+        raise ValueError(f"Not a supported GPFIFO capture: magic 0x{magic:X}, version {version}")
+
+    offset = FILE_HEADER.size
+    while offset + RECORD_HEADER.size <= len(data):
+        record_type, size = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        if offset + size > len(data):
+            break  # The capture was truncated while writing the last record
+        yield record_type, data[offset:offset + size]
+        offset += size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("capture", help="The path to the capture file")
+    parser.add_argument("-s", "--summary", action="store_true", help="Print the amount of calls to every method per frame rather than every call")
+    arguments = parser.parse_args()
+
+    decoder = MethodDecoder()
+    frame_calls = collections.Counter()
+    output = sys.stdout
+
+    def print_summary(frame_id):
+        output.write(f"Frame {frame_id}: {sum(frame_calls.values())} calls\n")
+        for (engine, method), calls in sorted(frame_calls.items(), key=lambda item: (-item[1], item[0])):
+            output.write(f"  {engine:>7} 0x{method:03X}: {calls}\n")
+        frame_calls.clear()
+
+    for record_type, payload in read_records(arguments.capture):
+        if record_type == RECORD_GP_ENTRY:
+            entry0, entry1 = GP_ENTRY.unpack_from(payload, 0)
+            words = struct.unpack_from(f"<{(len(payload) - GP_ENTRY.size) // 4}I", payload, GP_ENTRY.size)
+            if not arguments.summary:
+                address = ((entry1 & 0xFF) << 32) | (entry0 & ~0x3)
+                output.write(f"GpEntry 0x{address:010X} ({len(words)} words)\n" if words else f"GpEntry control opcode {entry1 & 0xFF}\n")
+
+            for subchannel, method, argument in decoder.decode(words):
+                engine = "GPFIFO" if method < GPFIFO_REGISTER_COUNT else SUBCHANNEL_NAMES[subchannel]
+                if arguments.summary:
+                    frame_calls[(engine, method)] += 1
+                else:
+                    output.write(f"  {engine:>7} 0x{method:03X} = 0x{argument:08X}\n")
+        elif record_type == RECORD_FRAME:
+            frame_id, = struct.unpack_from("<Q", payload, 0)
+            if arguments.summary:
+                print_summary(frame_id)
+            else:
+                output.write(f"Frame {frame_id}\n")
+
+    if arguments.summary and frame_calls:
+        print_summary("(incomplete)")
+
+
+if __name__ == "__main__":
+    main()